@@ -66,6 +66,9 @@ struct decoder_owner_callbacks
             /* Display rate
              * cf. decoder_GetDisplayRate */
             float       (*get_display_rate)( decoder_t * );
+            /* Output lateness
+             * cf. decoder_GetLateness */
+            vlc_tick_t  (*get_lateness)( decoder_t * );
         } video;
         struct
         {
@@ -583,6 +586,28 @@ static inline float decoder_GetDisplayRate( decoder_t *dec )
     return dec->cbs->video.get_display_rate( dec );
 }
 
+/**
+ * This function returns how late the last picture queued by the decoder was
+ * when it reached the output, 0 if it was on time or if it is unknown.
+ *
+ * Decoders can use it, together with decoder_GetDisplayDate(), to skip
+ * frames before decoding them when they cannot keep up with the clock,
+ * instead of having the video output drop them after decoding.
+ *
+ * Pictures are only measured once the decoder called it, so the first call
+ * returns 0.
+ */
+VLC_USED
+static inline vlc_tick_t decoder_GetLateness( decoder_t *dec )
+{
+    vlc_assert( dec->fmt_in->i_cat == VIDEO_ES && dec->cbs != NULL );
+
+    if( !dec->cbs->video.get_lateness )
+        return 0;
+
+    return dec->cbs->video.get_lateness( dec );
+}
+
 /** @} */
 
 /**
@@ -31,6 +31,22 @@ extern "C" {
 /** Executor type (opaque) */
 typedef struct vlc_executor vlc_executor_t;
 
+/**
+ * Priority of a runnable.
+ *
+ * Queued runnables of a higher priority are started first. Runnables of the
+ * same priority are started in submission order, unless they are submitted
+ * from different threads.
+ */
+enum vlc_executor_priority {
+    /** Work nobody waits for (e.g. a library scan) */
+    VLC_EXECUTOR_PRIORITY_BACKGROUND,
+    /** Default priority, used by vlc_executor_Submit() */
+    VLC_EXECUTOR_PRIORITY_NORMAL,
+    /** Work the user waits for (e.g. a thumbnail on screen) */
+    VLC_EXECUTOR_PRIORITY_INTERACTIVE,
+};
+
 /**
  * A Runnable encapsulates a task to be run from an executor thread.
  */
@@ -60,6 +76,8 @@ struct vlc_runnable {
 
     /* Private data used by the vlc_executor_t (do not touch) */
     struct vlc_list node;
+    void *queue;
+    unsigned priority;
 };
 
 /**
@@ -133,6 +151,10 @@ vlc_executor_Delete(vlc_executor_t *executor);
  * is still in the pending queue (i.e. not canceled or started). This is due to
  * the intrusive linked list of runnables.
  *
+ * Each executor thread has its own queue. A runnable submitted from a runnable
+ * is queued on the same thread, idle threads steal runnables from the other
+ * queues.
+ *
  * It is strongly discouraged to submit a runnable that is currently running on
  * the executor (unless you are prepared for the run() callback to be run
  * several times in parallel).
@@ -145,6 +167,21 @@ vlc_executor_Delete(vlc_executor_t *executor);
 VLC_API void
 vlc_executor_Submit(vlc_executor_t *executor, struct vlc_runnable *runnable);
 
+/**
+ * Submit a runnable for execution with a given priority.
+ *
+ * This is the same as vlc_executor_Submit(), except that the runnable is
+ * started before the queued runnables of lower priorities.
+ *
+ * \param executor the executor
+ * \param runnable the task to run
+ * \param priority the priority of the task
+ */
+VLC_API void
+vlc_executor_SubmitPriority(vlc_executor_t *executor,
+                            struct vlc_runnable *runnable,
+                            enum vlc_executor_priority priority);
+
 /**
  * Cancel a runnable previously submitted.
  *
@@ -187,6 +187,24 @@ VLC_API vlc_frame_t *vlc_frame_New(const struct vlc_frame_callbacks *cbs,
  */
 VLC_API vlc_frame_t *vlc_frame_Alloc(size_t size) VLC_USED VLC_MALLOC;
 
+/**
+ * Frame allocation cache statistics.
+ *
+ * Small frames allocated with vlc_frame_Alloc() are recycled through
+ * per-thread caches of power-of-two size classes.
+ */
+struct vlc_frame_cache_stats
+{
+    uint64_t hits; /**< allocations served from the cache */
+    uint64_t misses; /**< cacheable allocations served by the heap */
+    size_t bytes_cached; /**< memory held by released frames */
+};
+
+/**
+ * Gets the frame allocation cache statistics, summed over all threads.
+ */
+VLC_API void vlc_frame_cache_GetStats(struct vlc_frame_cache_stats *);
+
 VLC_API vlc_frame_t *vlc_frame_TryRealloc(vlc_frame_t *, ssize_t pre, size_t body) VLC_USED;
 
 /**
@@ -55,6 +55,7 @@
 
 #include "../demux/mpeg/timestamps.h"
 #include "../demux/timestamps_filter.h"
+#include "disc_cache.h"
 
 #include <libbluray/bluray.h>
 #include <libbluray/bluray-version.h>
@@ -141,6 +142,9 @@ static const char * bluray_event_debug_strings[] =
 #define BD_REGION_TEXT      N_("Region code")
 #define BD_REGION_LONGTEXT  N_("Blu-Ray player region code. "\
                                 "Some discs can be played only with a correct region code.")
+#define BD_DIRECT_TS_TEXT      N_("Parse transport stream in place")
+#define BD_DIRECT_TS_LONGTEXT  N_("Drive the TS demuxer from the disc read loop " \
+                                   "instead of handing the data to its own thread.")
 
 #define BD_BDJ_SETTINGS_TEXT        N_("BD-J")
 #define BD_BDJ_JAVA_HOME_TEXT       N_("JAVA_HOME")
@@ -190,6 +194,7 @@ vlc_module_begin ()
     add_bool("bluray-menu", true, BD_MENU_TEXT, BD_MENU_LONGTEXT)
     add_string("bluray-region", ppsz_region_code[REGION_DEFAULT], BD_REGION_TEXT, BD_REGION_LONGTEXT)
         change_string_list(ppsz_region_code, ppsz_region_code_text)
+    add_bool("bluray-direct-ts", true, BD_DIRECT_TS_TEXT, BD_DIRECT_TS_LONGTEXT)
 
 #if defined(BLURAY_SET_JAVA_HOME) || defined(BLURAY_ENABLE_PERSISTENT_STORAGE)
     set_section(BD_BDJ_SETTINGS_TEXT, NULL)
@@ -302,11 +307,19 @@ typedef struct
     es_out_t            *p_out;
     bool                b_spu_enable;       /* enabled / disabled */
     vlc_demux_chained_t *p_parser;
+    struct
+    {
+        bool            b_enabled;
+        demux_t         *p_ts;      /* owns the stream reading the queue */
+        block_t         *p_queue;
+        block_t         **pp_queue_last;
+    } direct;                       /* TS demuxer driven from blurayDemux() */
     bool                b_flushed;
     bool                b_pl_playing;       /* true when playing playlist */
 
     /* stream input */
     vlc_mutex_t         read_block_lock;
+    vlc_disc_cache_t    *p_cache;
 
     /* Used to store bluray disc path */
     char                *psz_bd_path;
@@ -472,6 +485,9 @@ static void  blurayArgbOverlayProc(void *ptr, const BD_ARGB_OVERLAY * const over
 static void  blurayCloseOverlay(demux_t *p_demux, int plane);
 
 static void  onMouseEvent(const vlc_mouse_t *mouse, void *user_data);
+static int   parserNew(demux_t *p_demux);
+static void  parserDelete(demux_sys_t *p_sys);
+static void  parserSend(demux_sys_t *p_sys, block_t *p_block);
 static void  blurayRestartParser(demux_t *p_demux, bool, bool);
 static void  notifyDiscontinuityToParser( demux_sys_t *p_sys );
 
@@ -653,7 +669,11 @@ static int probeStream(demux_t *p_demux)
 }
 
 #ifdef BLURAY_DEMUX
-static int blurayReadBlock(void *object, void *buf, int lba, int num_blocks)
+/* Stream input read-ahead: 4 MiB of ECC blocks, 1 MiB ahead of libbluray */
+#define BD_CACHE_BLOCKS   64
+#define BD_CACHE_PREFETCH 16
+
+static int blurayReadStream(void *object, void *buf, uint64_t lba, unsigned num_blocks)
 {
     demux_t *p_demux = (demux_t*)object;
     demux_sys_t *p_sys = p_demux->p_sys;
@@ -669,18 +689,51 @@ static int blurayReadBlock(void *object, void *buf, int lba, int num_blocks)
 
         got = vlc_stream_Read( p_demux->s, buf, req);
         if (got < 0) {
-            msg_Err(p_demux, "read from lba %d failed", lba);
+            msg_Err(p_demux, "read from lba %"PRIu64" failed", lba);
         } else {
             result = got / 2048;
         }
     } else {
-       msg_Err(p_demux, "seek to lba %d failed", lba);
+       msg_Err(p_demux, "seek to lba %"PRIu64" failed", lba);
     }
 
     vlc_mutex_unlock(&p_sys->read_block_lock);
 
     return result;
 }
+
+static int blurayReadBlock(void *object, void *buf, int lba, int num_blocks)
+{
+    demux_t *p_demux = (demux_t*)object;
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if (lba < 0 || num_blocks <= 0)
+        return -1;
+    if (p_sys->p_cache)
+        return vlc_disc_cache_Read(p_sys->p_cache, buf, lba, num_blocks);
+    return blurayReadStream(object, buf, lba, num_blocks);
+}
+
+static void blurayCacheNew(demux_t *p_demux)
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const struct vlc_disc_cache_cfg cfg = {
+        .sector_size = 2048,
+        .block_sectors = DISC_CACHE_BD_BLOCK_SECTORS,
+        .blocks = BD_CACHE_BLOCKS,
+        .prefetch = BD_CACHE_PREFETCH,
+        .read = blurayReadStream,
+        .opaque = p_demux,
+    };
+
+    p_sys->p_cache = vlc_disc_cache_New(p_demux, &cfg);
+    if (!p_sys->p_cache) {
+        msg_Warn(p_demux, "cannot create read-ahead cache");
+        return;
+    }
+    /* Keep the file system and the disc navigation files read at open */
+    vlc_disc_cache_SetPinning(p_sys->p_cache, true);
+}
 #endif
 
 /*****************************************************************************
@@ -837,6 +890,8 @@ static int blurayOpen(vlc_object_t *object)
     if (p_demux->s) {
         i_init_pos = vlc_stream_Tell(p_demux->s);
 
+        blurayCacheNew(p_demux);
+
         p_sys->bluray = bd_init();
         if (!bd_open_stream(p_sys->bluray, p_demux, blurayReadBlock)) {
             bd_close(p_sys->bluray);
@@ -1003,8 +1058,8 @@ static int blurayOpen(vlc_object_t *object)
     if (unlikely(p_sys->p_out == NULL))
         goto error;
 
-    p_sys->p_parser = vlc_demux_chained_New(VLC_OBJECT(p_demux), "ts", p_sys->p_out);
-    if (!p_sys->p_parser) {
+    p_sys->direct.b_enabled = var_InheritBool(p_demux, "bluray-direct-ts");
+    if (parserNew(p_demux) != VLC_SUCCESS) {
         msg_Err(p_demux, "Failed to create TS demuxer");
         goto error;
     }
@@ -1012,6 +1067,9 @@ static int blurayOpen(vlc_object_t *object)
     p_demux->pf_control = blurayControl;
     p_demux->pf_demux   = blurayDemux;
 
+    if (p_sys->p_cache)
+        vlc_disc_cache_SetPinning(p_sys->p_cache, false);
+
     return VLC_SUCCESS;
 
 error:
@@ -1051,13 +1109,16 @@ static void blurayClose(vlc_object_t *object)
         bd_close(p_sys->bluray);
     }
 
+    /* No more readers, stop the read-ahead before the stream is used again */
+    if (p_sys->p_cache)
+        vlc_disc_cache_Delete(p_sys->p_cache);
+
     vlc_mutex_lock(&p_sys->bdj.lock);
     for(int i = 0; i < MAX_OVERLAY; i++)
         blurayCloseOverlay(p_demux, i);
     vlc_mutex_unlock(&p_sys->bdj.lock);
 
-    if (p_sys->p_parser)
-        vlc_demux_chained_Delete(p_sys->p_parser);
+    parserDelete(p_sys);
 
     if (p_sys->p_out != NULL)
         es_out_Delete(p_sys->p_out);
@@ -2219,6 +2280,135 @@ static void blurayInitTitles(demux_t *p_demux, uint32_t menu_titles)
         p_sys->pp_title[p_sys->i_main_title]->i_flags |= INPUT_TITLE_MAIN;
 }
 
+/*****************************************************************************
+ * TS parser: either a chained demuxer running on its own thread, or the
+ * TS demuxer run in place, on the data just read, from blurayDemux()
+ *****************************************************************************/
+static block_t *directStreamBlock(stream_t *s, bool *restrict eof)
+{
+    demux_sys_t *p_sys = s->p_sys;
+    block_t *p_block = p_sys->direct.p_queue;
+
+    /* Running dry only ends this demux run, more is read from the disc */
+    *eof = p_block == NULL;
+    if (p_block == NULL)
+        return NULL;
+
+    p_sys->direct.p_queue = p_block->p_next;
+    if (p_sys->direct.p_queue == NULL)
+        p_sys->direct.pp_queue_last = &p_sys->direct.p_queue;
+    p_block->p_next = NULL;
+    return p_block;
+}
+
+static int directStreamControl(stream_t *s, int i_query, va_list args)
+{
+    VLC_UNUSED(s);
+
+    switch (i_query)
+    {
+        case STREAM_CAN_SEEK:
+        case STREAM_CAN_FASTSEEK:
+        case STREAM_CAN_PAUSE:
+        case STREAM_CAN_CONTROL_PACE:
+            *va_arg(args, bool *) = false;
+            break;
+
+        case STREAM_GET_PTS_DELAY:
+            *va_arg(args, vlc_tick_t *) = DEFAULT_PTS_DELAY;
+            break;
+
+        default:
+            return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static void directStreamDestroy(stream_t *s)
+{
+    /* The queue belongs to demux_sys_t */
+    VLC_UNUSED(s);
+}
+
+static void directQueueRelease(demux_sys_t *p_sys)
+{
+    block_ChainRelease(p_sys->direct.p_queue);
+    p_sys->direct.p_queue = NULL;
+    p_sys->direct.pp_queue_last = &p_sys->direct.p_queue;
+}
+
+static int parserNew(demux_t *p_demux)
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if (!p_sys->direct.b_enabled)
+    {
+        p_sys->p_parser = vlc_demux_chained_New(VLC_OBJECT(p_demux), "ts", p_sys->p_out);
+        return p_sys->p_parser ? VLC_SUCCESS : VLC_EGENERIC;
+    }
+
+    p_sys->direct.p_queue = NULL;
+    p_sys->direct.pp_queue_last = &p_sys->direct.p_queue;
+    p_sys->direct.p_ts = NULL;
+
+    stream_t *s = vlc_stream_CommonNew(VLC_OBJECT(p_demux), directStreamDestroy);
+    if (!s)
+        return VLC_EGENERIC;
+    s->p_sys = p_sys;
+    s->pf_block = directStreamBlock;
+    s->pf_control = directStreamControl;
+
+    /* Forced to BluRay aligned units: there is nothing to probe yet */
+    p_sys->direct.p_ts = demux_New(VLC_OBJECT(s), "m2ts", "vlc://nop", s, p_sys->p_out);
+    if (!p_sys->direct.p_ts)
+    {
+        vlc_stream_Delete(s);
+        return VLC_EGENERIC;
+    }
+    demux_Control(p_sys->direct.p_ts, DEMUX_SET_GROUP_ALL);
+    return VLC_SUCCESS;
+}
+
+static void parserDelete(demux_sys_t *p_sys)
+{
+    if (!p_sys->direct.b_enabled)
+    {
+        if (p_sys->p_parser)
+            vlc_demux_chained_Delete(p_sys->p_parser);
+        p_sys->p_parser = NULL;
+        return;
+    }
+
+    /* The demuxer owns the stream */
+    if (p_sys->direct.p_ts)
+        demux_Delete(p_sys->direct.p_ts);
+    p_sys->direct.p_ts = NULL;
+    directQueueRelease(p_sys);
+}
+
+static void parserSend(demux_sys_t *p_sys, block_t *p_block)
+{
+    if (!p_sys->direct.b_enabled)
+    {
+        if (p_sys->p_parser)
+            vlc_demux_chained_Send(p_sys->p_parser, p_block);
+        else
+            block_Release(p_block);
+        return;
+    }
+
+    if (!p_sys->direct.p_ts)
+    {
+        block_Release(p_block);
+        return;
+    }
+
+    block_ChainLastAppend(&p_sys->direct.pp_queue_last, p_block);
+
+    /* Parse everything queued, on this thread, before reading more */
+    while (demux_Demux(p_sys->direct.p_ts) == VLC_DEMUXER_SUCCESS);
+}
+
 static void blurayRestartParser(demux_t *p_demux, bool b_flush, bool b_random_access)
 {
     /*
@@ -2231,14 +2421,12 @@ static void blurayRestartParser(demux_t *p_demux, bool b_flush, bool b_random_ac
     if(b_flush)
         es_out_Control(p_sys->p_out, BLURAY_ES_OUT_CONTROL_DISABLE_OUTPUT);
 
-    if (p_sys->p_parser)
-        vlc_demux_chained_Delete(p_sys->p_parser);
+    parserDelete(p_sys);
 
     if(b_flush)
         es_out_Control(p_sys->p_tf_out, ES_OUT_TF_FILTER_RESET);
 
-    p_sys->p_parser = vlc_demux_chained_New(VLC_OBJECT(p_demux), "ts", p_sys->p_out);
-    if (!p_sys->p_parser)
+    if (parserNew(p_demux) != VLC_SUCCESS)
         msg_Err(p_demux, "Failed to create TS demuxer");
 
     es_out_Control(p_sys->p_out, BLURAY_ES_OUT_CONTROL_ENABLE_OUTPUT);
@@ -2633,7 +2821,7 @@ static void writeTsPacketWDiscontinuity( uint8_t *p_buf, uint16_t i_pid,
         memcpy( &p_buf[192 - i_payload], p_payload, i_payload );
 }
 
-static void notifyStreamsDiscontinuity( vlc_demux_chained_t *p_parser,
+static void notifyStreamsDiscontinuity( demux_sys_t *p_sys,
                                         const BLURAY_STREAM_INFO *p_sinfo, size_t i_sinfo )
 {
     for( size_t i=0; i< i_sinfo; i++ )
@@ -2646,11 +2834,11 @@ static void notifyStreamsDiscontinuity( vlc_demux_chained_t *p_parser,
 
         writeTsPacketWDiscontinuity( p_block->p_buffer, i_pid, NULL, 0 );
 
-        vlc_demux_chained_Send(p_parser, p_block);
+        parserSend(p_sys, p_block);
     }
 }
 
-#define DONOTIFY(memb) notifyStreamsDiscontinuity( p_sys->p_parser, p_clip->memb##_streams, \
+#define DONOTIFY(memb) notifyStreamsDiscontinuity( p_sys, p_clip->memb##_streams, \
                                                    p_clip->memb##_stream_count )
 
 static void notifyDiscontinuityToParser( demux_sys_t *p_sys )
@@ -2722,7 +2910,7 @@ static void streamFlush( demux_sys_t *p_sys )
 
     writeTsPacketWDiscontinuity( p_block->p_buffer, 0x1011, seq_end_pes, sizeof(seq_end_pes) );
 
-    vlc_demux_chained_Send(p_sys->p_parser, p_block);
+    parserSend(p_sys, p_block);
     p_sys->b_flushed = true;
 }
 
@@ -3084,7 +3272,7 @@ static int blurayDemux(demux_t *p_demux)
 
     p_block->i_buffer = nread;
 
-    vlc_demux_chained_Send(p_sys->p_parser, p_block);
+    parserSend(p_sys, p_block);
 
     p_sys->b_flushed = false;
 
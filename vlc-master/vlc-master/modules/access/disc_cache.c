@@ -0,0 +1,446 @@
+/*****************************************************************************
+ * disc_cache.c: optical disc read-ahead sector cache
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_threads.h>
+
+#include "disc_cache.h"
+
+#include <assert.h>
+
+enum
+{
+    BLOCK_FREE,
+    BLOCK_QUEUED,
+    BLOCK_READING,
+    BLOCK_VALID,
+};
+
+struct disc_block
+{
+    uint64_t  index;        /* first sector / block_sectors */
+    uint8_t  *data;
+    unsigned  sectors;      /* valid sectors, fewer at the end of the disc */
+    int       state;
+    bool      urgent;       /* a reader waits for it */
+    bool      pinned;
+    bool      failed;
+    unsigned  waiters;
+    uint64_t  last_use;
+};
+
+struct vlc_disc_cache
+{
+    vlc_object_t *obj;
+    struct vlc_disc_cache_cfg cfg;
+
+    vlc_mutex_t lock;
+    vlc_cond_t  wait;       /* signals the thread */
+    vlc_cond_t  done;       /* signals the readers */
+    vlc_thread_t thread;
+    bool closing;
+    bool pinning;
+
+    struct disc_block *blocks;
+    uint8_t *data;
+    unsigned pinned;
+    uint64_t clock;
+
+    /* Elevator */
+    uint64_t head;          /* block following the last drive read */
+    bool     ascending;
+
+    struct vlc_disc_cache_stats stats;
+};
+
+static struct disc_block *Find(vlc_disc_cache_t *c, uint64_t index)
+{
+    for (unsigned i = 0; i < c->cfg.blocks; i++)
+    {
+        struct disc_block *b = &c->blocks[i];
+        if (b->state != BLOCK_FREE && b->index == index)
+            return b;
+    }
+    return NULL;
+}
+
+/* Returns a free block, evicting the least recently used one if needed.
+ * Read-ahead never cancels other read-ahead, readers may. */
+static struct disc_block *Acquire(vlc_disc_cache_t *c, uint64_t index,
+                                  bool b_demand)
+{
+    struct disc_block *victim = NULL;
+
+    for (unsigned i = 0; i < c->cfg.blocks; i++)
+    {
+        struct disc_block *b = &c->blocks[i];
+
+        if (b->state == BLOCK_FREE)
+        {
+            victim = b;
+            break;
+        }
+        if (b->pinned || b->waiters > 0)
+            continue;
+        if (b->state != BLOCK_VALID &&
+            !(b_demand && b->state == BLOCK_QUEUED && !b->urgent))
+            continue;
+        if (victim == NULL || b->last_use < victim->last_use)
+            victim = b;
+    }
+
+    if (victim == NULL)
+        return NULL;
+
+    victim->index = index;
+    victim->sectors = 0;
+    victim->state = BLOCK_QUEUED;
+    victim->urgent = b_demand;
+    victim->pinned = false;
+    victim->failed = false;
+    victim->last_use = ++c->clock;
+    vlc_cond_signal(&c->wait);
+    return victim;
+}
+
+static void PinBlock(vlc_disc_cache_t *c, struct disc_block *b)
+{
+    if (b->pinned)
+        return;
+    if (c->pinned >= c->cfg.blocks / 2)
+    {
+        msg_Dbg(c->obj, "pinning budget exhausted, block %"PRIu64" not pinned",
+                b->index);
+        return;
+    }
+    b->pinned = true;
+    c->pinned++;
+}
+
+static void UnpinBlock(vlc_disc_cache_t *c, struct disc_block *b)
+{
+    if (!b->pinned)
+        return;
+    b->pinned = false;
+    c->pinned--;
+}
+
+/* Nearest queued block from the head, in the current sweep direction,
+ * reversing the direction at the end of the sweep */
+static struct disc_block *Elevator(vlc_disc_cache_t *c, bool b_urgent)
+{
+    for (int pass = 0; pass < 2; pass++)
+    {
+        struct disc_block *best = NULL;
+
+        for (unsigned i = 0; i < c->cfg.blocks; i++)
+        {
+            struct disc_block *b = &c->blocks[i];
+            if (b->state != BLOCK_QUEUED || b->urgent != b_urgent)
+                continue;
+
+            if (c->ascending)
+            {
+                if (b->index >= c->head &&
+                    (best == NULL || b->index < best->index))
+                    best = b;
+            }
+            else
+            {
+                if (b->index < c->head &&
+                    (best == NULL || b->index > best->index))
+                    best = b;
+            }
+        }
+
+        if (best != NULL)
+            return best;
+        c->ascending = !c->ascending;
+    }
+    return NULL;
+}
+
+static void *Thread(void *data)
+{
+    vlc_disc_cache_t *c = data;
+    const unsigned bs = c->cfg.block_sectors;
+
+    vlc_thread_set_name("vlc-disc-cache");
+
+    vlc_mutex_lock(&c->lock);
+    for (;;)
+    {
+        struct disc_block *b = NULL;
+
+        while (!c->closing)
+        {
+            /* Readers first, then read-ahead */
+            b = Elevator(c, true);
+            if (b == NULL)
+                b = Elevator(c, false);
+            if (b != NULL)
+                break;
+            vlc_cond_wait(&c->wait, &c->lock);
+        }
+        if (c->closing)
+            break;
+
+        const uint64_t index = b->index;
+        b->state = BLOCK_READING;
+        vlc_mutex_unlock(&c->lock);
+
+        int ret = c->cfg.read(c->cfg.opaque, b->data, index * bs, bs);
+
+        vlc_mutex_lock(&c->lock);
+        c->stats.drive_reads++;
+        if (index != c->head)
+            c->stats.drive_seeks++;
+        c->head = index + 1;
+
+        if (ret <= 0 && b->waiters == 0)
+        {
+            /* Failed read-ahead, or nothing past the end of the disc */
+            UnpinBlock(c, b);
+            b->state = BLOCK_FREE;
+        }
+        else
+        {
+            b->failed = ret < 0;
+            if (b->failed)
+            {
+                msg_Err(c->obj, "cannot read sectors %"PRIu64" to %"PRIu64,
+                        index * bs, index * bs + bs - 1);
+                UnpinBlock(c, b);
+            }
+            b->sectors = ret > 0 ? (unsigned)ret : 0;
+            b->state = BLOCK_VALID;
+        }
+        /* Wakes up the readers of the block, and those waiting for a free
+         * one */
+        vlc_cond_broadcast(&c->done);
+    }
+    vlc_mutex_unlock(&c->lock);
+    return NULL;
+}
+
+/* Queues the blocks following the last read, up to the read-ahead depth */
+static void ReadAhead(vlc_disc_cache_t *c, uint64_t index)
+{
+    for (unsigned i = 0; i < c->cfg.prefetch; i++)
+    {
+        if (Find(c, index + i) != NULL)
+            continue;
+        if (Acquire(c, index + i, false) == NULL)
+            break;
+    }
+}
+
+int vlc_disc_cache_Read(vlc_disc_cache_t *c, void *buf, uint64_t lba,
+                        unsigned count)
+{
+    const unsigned bs = c->cfg.block_sectors;
+    uint8_t *p_buf = buf;
+    unsigned i_done = 0;
+    int ret = 0;
+
+    vlc_mutex_lock(&c->lock);
+    while (i_done < count)
+    {
+        const uint64_t index = (lba + i_done) / bs;
+        const unsigned offset = (lba + i_done) % bs;
+        struct disc_block *b;
+
+        for (;;)
+        {
+            b = Find(c, index);
+            if (b != NULL)
+                break;
+            b = Acquire(c, index, true);
+            if (b != NULL)
+                break;
+            /* Every block is pinned or waited for */
+            vlc_cond_wait(&c->done, &c->lock);
+        }
+
+        if (b->state == BLOCK_VALID && b->failed && b->waiters == 0)
+        {
+            /* Retry a previously failed read */
+            b->state = BLOCK_QUEUED;
+            b->failed = false;
+            vlc_cond_signal(&c->wait);
+        }
+
+        if (b->state == BLOCK_VALID)
+            c->stats.hits++;
+        else
+        {
+            c->stats.misses++;
+            b->urgent = true;
+            b->waiters++;
+            while (b->state != BLOCK_VALID)
+                vlc_cond_wait(&c->done, &c->lock);
+            b->waiters--;
+        }
+
+        if (b->failed)
+        {
+            ret = -1;
+            break;
+        }
+        if (c->pinning)
+            PinBlock(c, b);
+        b->last_use = ++c->clock;
+
+        if (b->sectors <= offset)
+            break; /* end of disc */
+        unsigned n = __MIN(count - i_done, b->sectors - offset);
+        memcpy(p_buf, &b->data[offset * c->cfg.sector_size],
+               n * c->cfg.sector_size);
+        p_buf += n * c->cfg.sector_size;
+        i_done += n;
+
+        if (b->sectors < bs)
+            break; /* end of disc */
+    }
+
+    if (ret == 0 && i_done > 0)
+        ReadAhead(c, (lba + i_done - 1) / bs + 1);
+    vlc_mutex_unlock(&c->lock);
+
+    if (ret < 0 && i_done == 0)
+        return -1;
+    return i_done;
+}
+
+static void Queue(vlc_disc_cache_t *c, uint64_t lba, unsigned count,
+                  bool b_pin)
+{
+    const unsigned bs = c->cfg.block_sectors;
+
+    if (count == 0)
+        return;
+
+    vlc_mutex_lock(&c->lock);
+    for (uint64_t index = lba / bs; index <= (lba + count - 1) / bs; index++)
+    {
+        struct disc_block *b = Find(c, index);
+        if (b == NULL)
+            b = Acquire(c, index, false);
+        if (b == NULL)
+            break;
+        if (b_pin)
+            PinBlock(c, b);
+    }
+    vlc_mutex_unlock(&c->lock);
+}
+
+void vlc_disc_cache_Prefetch(vlc_disc_cache_t *c, uint64_t lba, unsigned count)
+{
+    Queue(c, lba, count, false);
+}
+
+void vlc_disc_cache_Pin(vlc_disc_cache_t *c, uint64_t lba, unsigned count)
+{
+    Queue(c, lba, count, true);
+}
+
+void vlc_disc_cache_SetPinning(vlc_disc_cache_t *c, bool b_pinning)
+{
+    vlc_mutex_lock(&c->lock);
+    c->pinning = b_pinning;
+    vlc_mutex_unlock(&c->lock);
+}
+
+void vlc_disc_cache_GetStats(vlc_disc_cache_t *c,
+                             struct vlc_disc_cache_stats *stats)
+{
+    vlc_mutex_lock(&c->lock);
+    *stats = c->stats;
+    vlc_mutex_unlock(&c->lock);
+}
+
+#undef vlc_disc_cache_New
+vlc_disc_cache_t *vlc_disc_cache_New(vlc_object_t *obj,
+                                     const struct vlc_disc_cache_cfg *cfg)
+{
+    assert(cfg->read != NULL);
+    assert(cfg->sector_size > 0 && cfg->block_sectors > 0);
+    assert(cfg->prefetch < cfg->blocks);
+
+    vlc_disc_cache_t *c = malloc(sizeof(*c));
+    if (unlikely(c == NULL))
+        return NULL;
+
+    const size_t i_block_size = cfg->sector_size * cfg->block_sectors;
+    c->obj = obj;
+    c->cfg = *cfg;
+    c->blocks = calloc(cfg->blocks, sizeof(*c->blocks));
+    c->data = vlc_alloc(cfg->blocks, i_block_size);
+    if (unlikely(c->blocks == NULL || c->data == NULL))
+        goto error;
+
+    for (unsigned i = 0; i < cfg->blocks; i++)
+    {
+        c->blocks[i].data = &c->data[i * i_block_size];
+        c->blocks[i].state = BLOCK_FREE;
+    }
+
+    vlc_mutex_init(&c->lock);
+    vlc_cond_init(&c->wait);
+    vlc_cond_init(&c->done);
+    c->closing = false;
+    c->pinning = false;
+    c->pinned = 0;
+    c->clock = 0;
+    c->head = 0;
+    c->ascending = true;
+    memset(&c->stats, 0, sizeof(c->stats));
+
+    if (vlc_clone(&c->thread, Thread, c))
+        goto error;
+    return c;
+
+error:
+    free(c->data);
+    free(c->blocks);
+    free(c);
+    return NULL;
+}
+
+void vlc_disc_cache_Delete(vlc_disc_cache_t *c)
+{
+    vlc_mutex_lock(&c->lock);
+    c->closing = true;
+    vlc_cond_signal(&c->wait);
+    vlc_mutex_unlock(&c->lock);
+    vlc_join(c->thread, NULL);
+
+    msg_Dbg(c->obj, "disc cache: %"PRIu64" hits, %"PRIu64" misses, "
+            "%"PRIu64" drive reads, %"PRIu64" seeks", c->stats.hits,
+            c->stats.misses, c->stats.drive_reads, c->stats.drive_seeks);
+
+    free(c->data);
+    free(c->blocks);
+    free(c);
+}
@@ -0,0 +1,80 @@
+/*****************************************************************************
+ * disc_cache.h: optical disc read-ahead sector cache
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_DISC_CACHE_H
+#define VLC_DISC_CACHE_H
+
+/* Sectors are cached by aligned blocks of the drive ECC unit size (16
+ * sectors on DVD, 32 on Blu-ray). A single thread does all the drive
+ * reads: blocks a reader waits for come first, then the blocks read ahead
+ * of the last read. Each group is served in elevator order from the
+ * current head position, so scattered requests are read in one sweep.
+ *
+ * Pinned blocks (file system, IFO, playlists, chapter starts) are never
+ * evicted. Up to half of the cache can be pinned. */
+
+#define DISC_CACHE_DVD_BLOCK_SECTORS    16
+#define DISC_CACHE_BD_BLOCK_SECTORS     32
+
+struct vlc_disc_cache_cfg
+{
+    size_t   sector_size;
+    unsigned block_sectors; /* sectors per cache block */
+    unsigned blocks;        /* capacity, in blocks */
+    unsigned prefetch;      /* blocks read ahead of each read */
+
+    /* Reads count sectors from lba, returns the number of sectors read,
+     * fewer at the end of the disc, or -1 on error. Only ever called from
+     * the cache thread. */
+    int  (*read)(void *opaque, void *buf, uint64_t lba, unsigned count);
+    void *opaque;
+};
+
+struct vlc_disc_cache_stats
+{
+    uint64_t hits;          /* blocks found valid */
+    uint64_t misses;        /* blocks a reader had to wait for */
+    uint64_t drive_reads;
+    uint64_t drive_seeks;   /* non-contiguous drive reads */
+};
+
+typedef struct vlc_disc_cache vlc_disc_cache_t;
+
+vlc_disc_cache_t *vlc_disc_cache_New(vlc_object_t *, const struct vlc_disc_cache_cfg *);
+#define vlc_disc_cache_New(o, c) vlc_disc_cache_New(VLC_OBJECT(o), c)
+
+/* Cancels pending read-ahead and waits for the drive read in progress */
+void vlc_disc_cache_Delete(vlc_disc_cache_t *);
+
+/* Returns the number of sectors read, fewer at the end of the disc,
+ * or -1 on error */
+int  vlc_disc_cache_Read(vlc_disc_cache_t *, void *buf, uint64_t lba, unsigned count);
+
+/* Queues the blocks covering the sectors without waiting */
+void vlc_disc_cache_Prefetch(vlc_disc_cache_t *, uint64_t lba, unsigned count);
+
+/* Queues and pins the blocks covering the sectors */
+void vlc_disc_cache_Pin(vlc_disc_cache_t *, uint64_t lba, unsigned count);
+
+/* While enabled, blocks read on demand are pinned (disc open, menus) */
+void vlc_disc_cache_SetPinning(vlc_disc_cache_t *, bool);
+
+void vlc_disc_cache_GetStats(vlc_disc_cache_t *, struct vlc_disc_cache_stats *);
+
+#endif
@@ -65,6 +65,7 @@
 #include <limits.h>
 
 #include "disc_helper.h"
+#include "disc_cache.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -118,6 +119,10 @@ vlc_module_end ()
 /* how many blocks DVDRead will read in each loop */
 #define DVD_BLOCK_READ_ONCE 4
 
+/* Read-ahead cache: 4 MiB of ECC blocks, 512 KiB ahead of the demuxer */
+#define DVD_CACHE_BLOCKS   128
+#define DVD_CACHE_PREFETCH 16
+
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
@@ -127,6 +132,8 @@ typedef struct
     /* DVDRead state */
     dvd_reader_t *p_dvdread;
     dvd_file_t   *p_title;
+    vlc_disc_cache_t *p_cache;  /* reads p_title */
+    ssize_t      i_title_file_blocks;
 
     ifo_handle_t *p_vmg_file;
     ifo_handle_t *p_vts_file;
@@ -208,6 +215,10 @@ static int  DvdAudioReadSeek( demux_t *, uint32_t );
 static void DvdReadHandleDSI( demux_t *, uint8_t * );
 static void DvdReadFindCell ( demux_t * );
 
+static void DvdReadCacheNew ( demux_t * );
+static void DvdReadCloseTitle( demux_sys_t * );
+static int  DvdReadTitleBlocks( demux_sys_t *, int, int, uint8_t * );
+
 #if DVDREAD_VERSION >= DVDREAD_VERSION_CODE(6, 1, 0)
 static void DvdReadLog( void *foo, dvd_logger_level_t i, const char *p, va_list z )
 {
@@ -339,6 +350,7 @@ static int OpenCommon( vlc_object_t *p_this , dvd_type_t type )
     p_sys->p_dvdread = p_dvdread;
     p_sys->p_vmg_file = p_vmg_file;
     p_sys->p_title = NULL;
+    p_sys->p_cache = NULL;
     p_sys->p_vts_file = NULL;
 
     p_sys->updates = 0;
@@ -402,7 +414,7 @@ static void Close( vlc_object_t *p_this )
     TAB_CLEAN( p_sys->i_titles, p_sys->titles );
 
     /* Close libdvdread */
-    if( p_sys->p_title ) DVDCloseFile( p_sys->p_title );
+    DvdReadCloseTitle( p_sys );
     if( p_sys->p_vts_file ) ifoClose( p_sys->p_vts_file );
     if( p_sys->p_vmg_file ) ifoClose( p_sys->p_vmg_file );
     DVDClose( p_sys->p_dvdread );
@@ -634,8 +646,8 @@ static int Demux( demux_t *p_demux )
     if( !p_sys->i_pack_len && type == DVD_V )
     {
         /* Read NAV packet */
-        if( DVDReadBlocks( p_sys->p_title, p_sys->i_next_vobu,
-                           1, p_buffer ) != 1 )
+        if( DvdReadTitleBlocks( p_sys, p_sys->i_next_vobu,
+                                1, p_buffer ) != 1 )
         {
             msg_Err( p_demux, "read failed for block %d", p_sys->i_next_vobu );
             vlc_dialog_display_error( p_demux, _("Playback failure"),
@@ -692,8 +704,8 @@ static int Demux( demux_t *p_demux )
     p_sys->i_pack_len -= i_blocks_once;
 
     /* Reads from DVD */
-    i_read = DVDReadBlocks( p_sys->p_title, p_sys->i_cur_block,
-                            i_blocks_once, p_buffer );
+    i_read = DvdReadTitleBlocks( p_sys, p_sys->i_cur_block,
+                                 i_blocks_once, p_buffer );
     if( i_read != i_blocks_once )
     {
         msg_Err( p_demux, "read failed for %d/%d blocks at 0x%02x",
@@ -879,6 +891,104 @@ static void ESNew( demux_t *p_demux, int i_id, int i_lang )
     tk->b_configured = true;
 }
 
+/*****************************************************************************
+ * DvdReadCacheNew: start the read-ahead on the opened title
+ *****************************************************************************
+ * The cache thread is the only one reading p_title until DvdReadCloseTitle.
+ * Chapter starts are pinned so that chapter jumps do not wait for a seek.
+ *****************************************************************************/
+static int DvdReadDevice( void *opaque, void *p_buffer, uint64_t i_block,
+                          unsigned i_count )
+{
+    demux_sys_t *p_sys = opaque;
+
+    /* Read-ahead stops at the end of the title file */
+    if( p_sys->i_title_file_blocks >= 0 )
+    {
+        if( i_block >= (uint64_t)p_sys->i_title_file_blocks )
+            return 0;
+        if( i_count > p_sys->i_title_file_blocks - i_block )
+            i_count = p_sys->i_title_file_blocks - i_block;
+    }
+    else if( i_block > INT_MAX )
+        return 0;
+
+    return DVDReadBlocks( p_sys->p_title, i_block, i_count, p_buffer );
+}
+
+static void DvdReadCacheNew( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const struct vlc_disc_cache_cfg cfg = {
+        .sector_size = DVD_VIDEO_LB_LEN,
+        .block_sectors = DISC_CACHE_DVD_BLOCK_SECTORS,
+        .blocks = DVD_CACHE_BLOCKS,
+        .prefetch = DVD_CACHE_PREFETCH,
+        .read = DvdReadDevice,
+        .opaque = p_sys,
+    };
+
+    p_sys->i_title_file_blocks = DVDFileSize( p_sys->p_title );
+    p_sys->p_cache = vlc_disc_cache_New( p_demux, &cfg );
+    if( p_sys->p_cache == NULL )
+    {
+        msg_Warn( p_demux, "cannot create read-ahead cache" );
+        return;
+    }
+
+    const ifo_handle_t *p_vts = p_sys->p_vts_file;
+    const int i_pins = __MIN( p_sys->i_chapters, DVD_CACHE_BLOCKS / 2 );
+    for( int i = 0; i < i_pins; i++ )
+    {
+        uint32_t i_block;
+
+#ifdef DVDREAD_HAS_DVDAUDIO
+        if( p_sys->type == DVD_A )
+            i_block = p_sys->p_title_table->atsi_track_pointer_rows[i].start_sector;
+        else
+#endif
+        {
+            const ptt_info_t *p_ptt =
+                &p_vts->vts_ptt_srpt->title[p_sys->i_ttn - 1].ptt[i];
+            if( p_ptt->pgcn == 0 ||
+                p_ptt->pgcn > p_vts->vts_pgcit->nr_of_pgci_srp )
+                continue;
+            const pgc_t *p_pgc = p_vts->vts_pgcit->pgci_srp[p_ptt->pgcn - 1].pgc;
+            if( p_pgc == NULL || p_pgc->program_map == NULL ||
+                p_pgc->cell_playback == NULL ||
+                p_ptt->pgn == 0 || p_ptt->pgn > p_pgc->nr_of_programs )
+                continue;
+            const int i_cell = p_pgc->program_map[p_ptt->pgn - 1] - 1;
+            if( i_cell < 0 || i_cell >= p_pgc->nr_of_cells )
+                continue;
+            i_block = p_pgc->cell_playback[i_cell].first_sector;
+        }
+        vlc_disc_cache_Pin( p_sys->p_cache, i_block, 1 );
+    }
+}
+
+static void DvdReadCloseTitle( demux_sys_t *p_sys )
+{
+    if( p_sys->p_cache != NULL )
+    {
+        vlc_disc_cache_Delete( p_sys->p_cache );
+        p_sys->p_cache = NULL;
+    }
+    if( p_sys->p_title != NULL )
+    {
+        DVDCloseFile( p_sys->p_title );
+        p_sys->p_title = NULL;
+    }
+}
+
+static int DvdReadTitleBlocks( demux_sys_t *p_sys, int i_block, int i_count,
+                               uint8_t *p_buffer )
+{
+    if( p_sys->p_cache == NULL )
+        return DVDReadBlocks( p_sys->p_title, i_block, i_count, p_buffer );
+    return vlc_disc_cache_Read( p_sys->p_cache, p_buffer, i_block, i_count );
+}
+
 /*****************************************************************************
  * DvdReadSetArea: initialize input data for title x, chapter y.
  * It should be called for each user navigation request.
@@ -898,11 +1008,7 @@ static int DvdReadSetArea( demux_t *p_demux, int i_title, int i_chapter,
     {
         int i_start_cell, i_end_cell;
 
-        if( p_sys->p_title != NULL )
-        {
-            DVDCloseFile( p_sys->p_title );
-            p_sys->p_title = NULL;
-        }
+        DvdReadCloseTitle( p_sys );
         p_sys->i_title = i_title;
         const ifo_handle_t *p_vmg = p_sys->p_vmg_file;
 
@@ -1006,6 +1112,7 @@ static int DvdReadSetArea( demux_t *p_demux, int i_title, int i_chapter,
                      p_vmg->tt_srpt->title[i_title].title_set_nr );
             return VLC_EGENERIC;
         }
+        DvdReadCacheNew( p_demux );
 
         //IfoPrintTitle( p_demux );
 
@@ -1226,11 +1333,7 @@ static int DvdAudioReadSetArea( demux_t *p_demux, int i_title, int i_track,
     if( i_title >= 0 && i_title < p_sys->i_titles &&
         i_title != p_sys->i_title )
     {
-        if( p_sys->p_title != NULL )
-        {
-            DVDCloseFile( p_sys->p_title );
-            p_sys->p_title = NULL;
-        }
+        DvdReadCloseTitle( p_sys );
         p_sys->i_title = i_title;
 
         /* reusing p_vmg variable for p_amg */
@@ -1294,6 +1397,7 @@ static int DvdAudioReadSetArea( demux_t *p_demux, int i_title, int i_track,
                      p_vmg->info_table_second_sector->tracks_info[i_title].group_property );
             return VLC_EGENERIC;
         }
+        DvdReadCacheNew( p_demux );
 
         /* for now we are using the "second table, which includes no VOB tracks, assuming that if a user wants to open the video side he will select the standard DVD option"*/
 
@@ -0,0 +1,195 @@
+/*****************************************************************************
+ * uring.c: file input with io_uring
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <vlc_common.h>
+#include <vlc_access.h>
+#include <vlc_fs.h>
+#include <vlc_plugin.h>
+
+#include "uring_reader.h"
+
+static int  Open (vlc_object_t *);
+static void Close(vlc_object_t *);
+
+#define BLOCK_SIZE_TEXT N_("Read size (KiB)")
+#define BLOCK_SIZE_LONGTEXT N_("Size of each read submitted to the kernel.")
+
+#define DEPTH_TEXT N_("Queue depth")
+#define DEPTH_LONGTEXT N_("Number of reads in flight ahead of the demuxer.")
+
+#define DIRECT_TEXT N_("Bypass the page cache")
+#define DIRECT_LONGTEXT N_("Open the file with O_DIRECT, so that large " \
+    "files do not evict the page cache.")
+
+vlc_module_begin()
+    set_shortname(N_("io_uring"))
+    set_description(N_("File input (io_uring)"))
+    set_subcategory(SUBCAT_INPUT_ACCESS)
+    add_integer_with_range("uring-block-size", 1024, 64, 16384,
+                           BLOCK_SIZE_TEXT, BLOCK_SIZE_LONGTEXT)
+    add_integer_with_range("uring-depth", 8, 2, 64,
+                           DEPTH_TEXT, DEPTH_LONGTEXT)
+    add_bool("uring-direct", false, DIRECT_TEXT, DIRECT_LONGTEXT)
+    /* Opt-in: --access=file_uring or uring:// */
+    set_capability("access", 0)
+    add_shortcut("uring")
+    set_callbacks(Open, Close)
+vlc_module_end()
+
+typedef struct
+{
+    int fd;
+    vlc_uring_reader_t *reader;
+} access_sys_t;
+
+static block_t *Block(stream_t *access, bool *restrict eof)
+{
+    access_sys_t *sys = access->p_sys;
+
+    block_t *block = vlc_uring_reader_Read(sys->reader, eof);
+    if (block == NULL && errno != 0)
+        msg_Err(access, "read error: %s", vlc_strerror_c(errno));
+    return block;
+}
+
+static int Seek(stream_t *access, uint64_t offset)
+{
+    access_sys_t *sys = access->p_sys;
+
+    vlc_uring_reader_Seek(sys->reader, offset);
+    return VLC_SUCCESS;
+}
+
+static int Control(stream_t *access, int query, va_list args)
+{
+    access_sys_t *sys = access->p_sys;
+
+    switch (query)
+    {
+        case STREAM_CAN_SEEK:
+        case STREAM_CAN_FASTSEEK:
+        case STREAM_CAN_PAUSE:
+        case STREAM_CAN_CONTROL_PACE:
+            *va_arg(args, bool *) = true;
+            break;
+
+        case STREAM_GET_SIZE:
+            *va_arg(args, uint64_t *) = vlc_uring_reader_GetSize(sys->reader);
+            break;
+
+        case STREAM_GET_PTS_DELAY:
+            *va_arg(args, vlc_tick_t *) =
+                VLC_TICK_FROM_MS(var_InheritInteger(access, "file-caching"));
+            break;
+
+        case STREAM_SET_PAUSE_STATE:
+            /* Nothing to do */
+            break;
+
+        default:
+            return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static int Open(vlc_object_t *obj)
+{
+    stream_t *access = (stream_t *)obj;
+
+    if (access->psz_filepath == NULL)
+        return VLC_EGENERIC;
+
+    bool direct = var_InheritBool(access, "uring-direct");
+    int fd = vlc_open(access->psz_filepath,
+                      O_RDONLY | (direct ? O_DIRECT : 0));
+    if (fd == -1 && direct)
+    {   /* Not supported by every file system */
+        msg_Warn(access, "cannot bypass the page cache (%s)",
+                 vlc_strerror_c(errno));
+        direct = false;
+        fd = vlc_open(access->psz_filepath, O_RDONLY);
+    }
+    if (fd == -1)
+    {
+        msg_Err(access, "cannot open file %s (%s)", access->psz_filepath,
+                vlc_strerror_c(errno));
+        return VLC_EGENERIC;
+    }
+
+    /* Directories, pipes and devices are left to the file module */
+    struct stat st;
+    if (fstat(fd, &st) || !(S_ISREG(st.st_mode) || S_ISBLK(st.st_mode)))
+        goto error;
+
+    struct vlc_uring_reader_cfg cfg = {
+        .fd = fd,
+        .block_size = (var_InheritInteger(access, "uring-block-size") << 10)
+                      & ~(size_t)(URING_READER_ALIGN - 1),
+        .depth = var_InheritInteger(access, "uring-depth"),
+    };
+
+    access_sys_t *sys = vlc_obj_malloc(obj, sizeof (*sys));
+    if (unlikely(sys == NULL))
+        goto error;
+
+    sys->fd = fd;
+    sys->reader = vlc_uring_reader_New(&cfg);
+    if (sys->reader == NULL)
+    {
+        msg_Dbg(access, "io_uring not available");
+        goto error;
+    }
+
+#ifdef HAVE_POSIX_FADVISE
+    if (!direct)
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    access->pf_read = NULL;
+    access->pf_block = Block;
+    access->pf_seek = Seek;
+    access->pf_control = Control;
+    access->p_sys = sys;
+
+    msg_Dbg(access, "%u reads of %zu KiB in flight%s", cfg.depth,
+            cfg.block_size >> 10, direct ? ", bypassing the page cache" : "");
+    return VLC_SUCCESS;
+
+error:
+    vlc_close(fd);
+    return VLC_EGENERIC;
+}
+
+static void Close(vlc_object_t *obj)
+{
+    stream_t *access = (stream_t *)obj;
+    access_sys_t *sys = access->p_sys;
+
+    vlc_uring_reader_Delete(sys->reader);
+    vlc_close(sys->fd);
+}
@@ -0,0 +1,471 @@
+/*****************************************************************************
+ * uring_reader.c: io_uring sequential file reader
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <liburing.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+
+#include "uring_reader.h"
+
+enum uring_slot_state
+{
+    SLOT_FREE,
+    SLOT_BUSY,  /* read in flight */
+    SLOT_READY, /* read completed, queued */
+    SLOT_HELD,  /* returned as a block */
+};
+
+struct uring_slot
+{
+    block_t block;
+    vlc_uring_reader_t *reader;
+    uint8_t *buffer;
+    uint64_t offset;
+    int result;
+    unsigned index;
+    enum uring_slot_state state;
+    bool stale; /* read from before a seek, dropped on completion */
+};
+
+struct vlc_uring_reader
+{
+    struct io_uring ring;
+    int fd;
+    uint64_t size;
+    size_t block_size;
+    unsigned depth;
+    bool fixed; /* buffers registered */
+
+    uint8_t *buffers;
+    struct uring_slot *slots;
+    unsigned slot_count;
+    unsigned *queue; /* slots of the reads, by offset */
+    unsigned queue_head;
+    unsigned queue_count;
+    unsigned inflight;
+    unsigned unsubmitted; /* prepared, not taken by the kernel yet */
+
+    uint64_t offset;      /* next byte returned */
+    uint64_t read_offset; /* next aligned offset read */
+
+    vlc_mutex_t lock; /* held slots and refs */
+    unsigned refs;
+};
+
+static void Destroy(vlc_uring_reader_t *r)
+{
+    free(r->queue);
+    free(r->slots);
+    aligned_free(r->buffers);
+    free(r);
+}
+
+static void SlotRelease(block_t *block)
+{
+    struct uring_slot *slot = container_of(block, struct uring_slot, block);
+    vlc_uring_reader_t *r = slot->reader;
+
+    vlc_mutex_lock(&r->lock);
+    assert(slot->state == SLOT_HELD);
+    slot->state = SLOT_FREE;
+    bool last = --r->refs == 0;
+    vlc_mutex_unlock(&r->lock);
+
+    if (last)
+        Destroy(r);
+}
+
+static const struct vlc_block_callbacks slot_cbs =
+{
+    SlotRelease,
+};
+
+static struct uring_slot *GetFreeSlot(vlc_uring_reader_t *r)
+{
+    struct uring_slot *slot = NULL;
+
+    vlc_mutex_lock(&r->lock);
+    for (unsigned i = 0; i < r->slot_count; i++)
+        if (r->slots[i].state == SLOT_FREE)
+        {
+            slot = &r->slots[i];
+            slot->state = SLOT_BUSY;
+            break;
+        }
+    vlc_mutex_unlock(&r->lock);
+    return slot;
+}
+
+static void PutFreeSlot(vlc_uring_reader_t *r, struct uring_slot *slot)
+{
+    vlc_mutex_lock(&r->lock);
+    slot->state = SLOT_FREE;
+    vlc_mutex_unlock(&r->lock);
+}
+
+static int Submit(vlc_uring_reader_t *r)
+{
+    while (r->queue_count < r->depth && r->read_offset < r->size)
+    {
+        /* The slot first: a reserved entry is submitted, prepared or not */
+        struct uring_slot *slot = GetFreeSlot(r);
+        if (slot == NULL)
+            break;
+
+        struct io_uring_sqe *sqe = io_uring_get_sqe(&r->ring);
+        if (sqe == NULL)
+        {
+            PutFreeSlot(r, slot);
+            break;
+        }
+
+        if (r->fixed)
+            io_uring_prep_read_fixed(sqe, r->fd, slot->buffer, r->block_size,
+                                     r->read_offset, slot->index);
+        else
+            io_uring_prep_read(sqe, r->fd, slot->buffer, r->block_size,
+                               r->read_offset);
+        io_uring_sqe_set_data(sqe, slot);
+
+        slot->offset = r->read_offset;
+        slot->stale = false;
+        r->queue[(r->queue_head + r->queue_count++) % r->depth] = slot->index;
+        r->read_offset += r->block_size;
+        r->inflight++;
+        r->unsubmitted++;
+    }
+
+    if (r->unsubmitted == 0)
+        return 0;
+
+    /* The entries left over by a failure go with the next submission */
+    int ret;
+    do
+        ret = io_uring_submit(&r->ring);
+    while (ret == -EINTR);
+    if (ret < 0)
+        return ret;
+    if (ret == 0)
+        return -EAGAIN;
+
+    r->unsubmitted -= __MIN((unsigned)ret, r->unsubmitted);
+    return 0;
+}
+
+static void Complete(vlc_uring_reader_t *r, struct io_uring_cqe *cqe)
+{
+    struct uring_slot *slot = io_uring_cqe_get_data(cqe);
+
+    assert(slot->state == SLOT_BUSY);
+    slot->result = cqe->res;
+    slot->state = slot->stale ? SLOT_FREE : SLOT_READY;
+    r->inflight--;
+    io_uring_cqe_seen(&r->ring, cqe);
+}
+
+static int WaitCompletion(vlc_uring_reader_t *r)
+{
+    struct io_uring_cqe *cqe;
+    int ret;
+
+    do
+        ret = io_uring_wait_cqe(&r->ring, &cqe);
+    while (ret == -EINTR);
+    if (ret < 0)
+        return ret;
+
+    Complete(r, cqe);
+    return 0;
+}
+
+/* Frees the buffers of the stale reads as soon as possible */
+static void Reap(vlc_uring_reader_t *r)
+{
+    struct io_uring_cqe *cqe;
+
+    while (r->inflight > 0 && io_uring_peek_cqe(&r->ring, &cqe) == 0)
+        Complete(r, cqe);
+}
+
+static void DropHead(vlc_uring_reader_t *r)
+{
+    struct uring_slot *slot = &r->slots[r->queue[r->queue_head]];
+
+    if (slot->state == SLOT_BUSY)
+        slot->stale = true;
+    else
+        slot->state = SLOT_FREE;
+    r->queue_head = (r->queue_head + 1) % r->depth;
+    r->queue_count--;
+}
+
+static void Restart(vlc_uring_reader_t *r, uint64_t offset)
+{
+    while (r->queue_count > 0)
+        DropHead(r);
+    r->offset = offset;
+    r->read_offset = offset & ~(uint64_t)(URING_READER_ALIGN - 1);
+}
+
+/* All the buffers are held by the caller: read into a new block */
+static block_t *ReadSync(vlc_uring_reader_t *r, bool *eof)
+{
+    uint64_t aligned = r->offset & ~(uint64_t)(URING_READER_ALIGN - 1);
+    size_t skip = r->offset - aligned;
+
+    block_t *block = block_Alloc(r->block_size + URING_READER_ALIGN);
+    if (unlikely(block == NULL))
+        return NULL;
+
+    uint8_t *buf = (uint8_t *)(((uintptr_t)block->p_buffer
+                                + URING_READER_ALIGN - 1)
+                               & ~(uintptr_t)(URING_READER_ALIGN - 1));
+    ssize_t val = pread(r->fd, buf, r->block_size, aligned);
+    if (val < 0)
+    {
+        block_Release(block);
+        *eof = true;
+        return NULL;
+    }
+    if ((size_t)val <= skip)
+    {   /* The file is shorter than it was */
+        block_Release(block);
+        r->size = r->offset;
+        *eof = true;
+        return NULL;
+    }
+
+    block->p_buffer = buf + skip;
+    block->i_buffer = val - skip;
+    r->offset += block->i_buffer;
+    r->read_offset = r->offset & ~(uint64_t)(URING_READER_ALIGN - 1);
+    return block;
+}
+
+block_t *vlc_uring_reader_Read(vlc_uring_reader_t *r, bool *eof)
+{
+    *eof = false;
+    errno = 0;
+
+    if (r->offset >= r->size)
+    {
+        *eof = true;
+        return NULL;
+    }
+
+    Reap(r);
+    int ret = Submit(r);
+    if (ret < 0)
+    {   /* The reads in flight would never complete */
+        errno = -ret;
+        *eof = true;
+        return NULL;
+    }
+
+    if (r->queue_count == 0)
+        return ReadSync(r, eof);
+
+    struct uring_slot *slot = &r->slots[r->queue[r->queue_head]];
+    while (slot->state == SLOT_BUSY)
+    {
+        ret = WaitCompletion(r);
+        if (ret < 0)
+        {
+            errno = -ret;
+            *eof = true;
+            return NULL;
+        }
+    }
+
+    assert(slot->state == SLOT_READY);
+    assert(slot->offset <= r->offset);
+    r->queue_head = (r->queue_head + 1) % r->depth;
+    r->queue_count--;
+
+    if (slot->result < 0)
+    {
+        errno = -slot->result;
+        slot->state = SLOT_FREE;
+        Restart(r, r->offset);
+        *eof = true;
+        return NULL;
+    }
+
+    size_t skip = r->offset - slot->offset;
+    size_t length = slot->result;
+
+    if (length <= skip)
+    {   /* The file is shorter than it was */
+        slot->state = SLOT_FREE;
+        Restart(r, r->offset);
+        r->size = r->offset;
+        *eof = true;
+        return NULL;
+    }
+
+    block_t *block = block_Init(&slot->block, &slot_cbs, slot->buffer,
+                                r->block_size);
+    block->p_buffer += skip;
+    block->i_buffer = length - skip;
+
+    vlc_mutex_lock(&r->lock);
+    slot->state = SLOT_HELD;
+    r->refs++;
+    vlc_mutex_unlock(&r->lock);
+
+    r->offset += block->i_buffer;
+    if (length < r->block_size && r->offset < r->size)
+        /* Short read: the next reads in flight do not follow */
+        Restart(r, r->offset);
+
+    /* A failure is reported by the next read */
+    Submit(r);
+    return block;
+}
+
+void vlc_uring_reader_Seek(vlc_uring_reader_t *r, uint64_t offset)
+{
+    /* Keep the reads in flight from the offset on */
+    while (r->queue_count > 0)
+    {
+        const struct uring_slot *slot = &r->slots[r->queue[r->queue_head]];
+
+        if (offset < slot->offset)
+            break;
+        if (offset - slot->offset < r->block_size)
+        {
+            r->offset = offset;
+            return;
+        }
+        DropHead(r);
+    }
+    Restart(r, offset);
+}
+
+uint64_t vlc_uring_reader_GetSize(vlc_uring_reader_t *r)
+{
+    return r->size;
+}
+
+vlc_uring_reader_t *vlc_uring_reader_New(const struct vlc_uring_reader_cfg *cfg)
+{
+    assert(cfg->block_size > 0);
+    assert(cfg->block_size % URING_READER_ALIGN == 0);
+    assert(cfg->depth > 0);
+
+    struct stat st;
+    if (fstat(cfg->fd, &st))
+        return NULL;
+
+    uint64_t size;
+    if (S_ISREG(st.st_mode))
+        size = st.st_size;
+    else
+    {   /* Block device */
+        off_t end = lseek(cfg->fd, 0, SEEK_END);
+        if (end == (off_t)-1)
+            return NULL;
+        size = end;
+    }
+
+    vlc_uring_reader_t *r = malloc(sizeof (*r));
+    if (unlikely(r == NULL))
+        return NULL;
+
+    r->fd = cfg->fd;
+    r->size = size;
+    r->block_size = cfg->block_size;
+    r->depth = cfg->depth;
+    /* Spare buffers for the blocks held by the caller */
+    r->slot_count = 2 * cfg->depth;
+    r->queue_head = 0;
+    r->queue_count = 0;
+    r->inflight = 0;
+    r->unsubmitted = 0;
+    r->offset = 0;
+    r->read_offset = 0;
+    r->refs = 1;
+    vlc_mutex_init(&r->lock);
+
+    r->buffers = aligned_alloc(URING_READER_ALIGN,
+                               r->slot_count * r->block_size);
+    r->slots = calloc(r->slot_count, sizeof (*r->slots));
+    r->queue = vlc_alloc(r->depth, sizeof (*r->queue));
+    if (unlikely(r->buffers == NULL || r->slots == NULL || r->queue == NULL))
+        goto error;
+
+    struct iovec *iov = vlc_alloc(r->slot_count, sizeof (*iov));
+    if (unlikely(iov == NULL))
+        goto error;
+
+    for (unsigned i = 0; i < r->slot_count; i++)
+    {
+        struct uring_slot *slot = &r->slots[i];
+
+        slot->reader = r;
+        slot->buffer = r->buffers + i * r->block_size;
+        slot->index = i;
+        slot->state = SLOT_FREE;
+        iov[i].iov_base = slot->buffer;
+        iov[i].iov_len = r->block_size;
+    }
+
+    if (io_uring_queue_init(r->depth, &r->ring, 0) < 0)
+    {
+        free(iov);
+        goto error;
+    }
+
+    /* Registration pins the pages, it may exceed RLIMIT_MEMLOCK */
+    r->fixed = io_uring_register_buffers(&r->ring, iov, r->slot_count) == 0;
+    free(iov);
+    return r;
+
+error:
+    Destroy(r);
+    return NULL;
+}
+
+void vlc_uring_reader_Delete(vlc_uring_reader_t *r)
+{
+    while (r->queue_count > 0)
+        DropHead(r);
+    while (r->inflight > r->unsubmitted)
+        if (WaitCompletion(r) < 0)
+            break;
+    io_uring_queue_exit(&r->ring);
+
+    vlc_mutex_lock(&r->lock);
+    bool last = --r->refs == 0;
+    vlc_mutex_unlock(&r->lock);
+
+    if (last)
+        Destroy(r);
+}
@@ -0,0 +1,59 @@
+/*****************************************************************************
+ * uring_reader.h: io_uring sequential file reader
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_URING_READER_H
+#define VLC_URING_READER_H
+
+#include <vlc_block.h>
+
+/* The file is read ahead by a queue of large reads in flight, into
+ * buffers registered once with the kernel. Each completed read is returned
+ * as a block pointing into its buffer, without copy: the buffer is queued
+ * again when the block is released. If the caller holds all the buffers,
+ * the reader falls back to a synchronous read into a new block.
+ *
+ * Reads are aligned on URING_READER_ALIGN, in offset, size and memory, so
+ * that the file can be opened with O_DIRECT. */
+
+#define URING_READER_ALIGN 4096
+
+struct vlc_uring_reader_cfg
+{
+    int      fd;         /* not closed by the reader */
+    size_t   block_size; /* bytes per read, a multiple of the alignment */
+    unsigned depth;      /* reads in flight */
+};
+
+typedef struct vlc_uring_reader vlc_uring_reader_t;
+
+/* Returns NULL if io_uring is not available */
+vlc_uring_reader_t *vlc_uring_reader_New(const struct vlc_uring_reader_cfg *);
+
+/* Waits for the reads in flight. The returned blocks remain valid. */
+void vlc_uring_reader_Delete(vlc_uring_reader_t *);
+
+/* Returns the data at the current offset, NULL at the end of the file
+ * (*eof set) or on error */
+block_t *vlc_uring_reader_Read(vlc_uring_reader_t *, bool *eof);
+
+void vlc_uring_reader_Seek(vlc_uring_reader_t *, uint64_t offset);
+
+uint64_t vlc_uring_reader_GetSize(vlc_uring_reader_t *);
+
+#endif
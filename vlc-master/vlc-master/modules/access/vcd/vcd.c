@@ -35,6 +35,7 @@
 #include <vlc_charset.h>
 
 #include "cdrom.h"
+#include "../disc_cache.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -63,9 +64,15 @@ vlc_module_end ()
 #define VCD_BLOCKS_ONCE 20
 #define VCD_DATA_ONCE   (VCD_BLOCKS_ONCE * VCD_DATA_SIZE)
 
+/* Read-ahead cache: CD drives have no ECC unit, use DVD sized blocks */
+#define VCD_CACHE_BLOCK_SECTORS DISC_CACHE_DVD_BLOCK_SECTORS
+#define VCD_CACHE_BLOCKS        64
+#define VCD_CACHE_PREFETCH      8
+
 typedef struct
 {
     vcddev_t    *vcddev;                            /* vcd device descriptor */
+    vlc_disc_cache_t *p_cache;
     uint64_t    offset;
 
     /* Title infos */
@@ -85,6 +92,7 @@ static block_t *Block( stream_t *, bool * restrict);
 static int      Seek( stream_t *, uint64_t );
 static int      Control( stream_t *, int, va_list );
 static int      EntryPoints( stream_t * );
+static void     CacheNew( stream_t * );
 
 /*****************************************************************************
  * VCDOpen: open vcd
@@ -181,6 +189,8 @@ static int Open( vlc_object_t *p_this )
         msg_Warn( p_access, "could not read entry points, will not use them" );
     }
 
+    CacheNew( p_access );
+
     /* Starting title/chapter and sector */
     if( i_title > USABLE_TITLES(p_sys->p_toc->i_tracks) )
         i_title = 0;
@@ -219,6 +229,9 @@ static void Close( vlc_object_t *p_this )
     stream_t     *p_access = (stream_t *)p_this;
     access_sys_t *p_sys = p_access->p_sys;
 
+    if( p_sys->p_cache )
+        vlc_disc_cache_Delete( p_sys->p_cache );
+
     for( size_t i = 0; i < ARRAY_SIZE(p_sys->titles); i++ )
         free( p_sys->titles[i].seekpoints );
 
@@ -330,6 +343,81 @@ static int Control( stream_t *p_access, int i_query, va_list args )
     return VLC_SUCCESS;
 }
 
+/*****************************************************************************
+ * ReadSectors: reads through the cache when there is one
+ *****************************************************************************/
+static int ReadDevice( void *opaque, void *p_buffer, uint64_t i_sector,
+                       unsigned i_blocks )
+{
+    stream_t     *p_access = opaque;
+    access_sys_t *p_sys = p_access->p_sys;
+    const vcddev_toc_t *p_toc = p_sys->p_toc;
+    const uint64_t i_leadout = p_toc->p_sectors[p_toc->i_tracks].i_lba;
+
+    /* Read-ahead stops at the lead-out */
+    if( i_sector >= i_leadout )
+        return 0;
+    if( i_blocks > i_leadout - i_sector )
+        i_blocks = i_leadout - i_sector;
+
+    if( ioctl_ReadSectors( VLC_OBJECT(p_access), p_sys->vcddev,
+            i_sector, p_buffer, i_blocks, VCD_TYPE ) < 0 )
+        return -1;
+    return i_blocks;
+}
+
+static int ReadSectors( stream_t *p_access, int i_sector, uint8_t *p_buffer,
+                        int i_blocks )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    if( p_sys->p_cache == NULL )
+        return ioctl_ReadSectors( VLC_OBJECT(p_access), p_sys->vcddev,
+                                  i_sector, p_buffer, i_blocks, VCD_TYPE );
+
+    if( vlc_disc_cache_Read( p_sys->p_cache, p_buffer, i_sector,
+                             i_blocks ) != i_blocks )
+        return -1;
+    return 0;
+}
+
+/*****************************************************************************
+ * CacheNew: starts the read-ahead, keeping the entry points at hand
+ *****************************************************************************/
+static void CacheNew( stream_t *p_access )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    const vcddev_toc_t *p_toc = p_sys->p_toc;
+    const struct vlc_disc_cache_cfg cfg = {
+        .sector_size = VCD_DATA_SIZE,
+        .block_sectors = VCD_CACHE_BLOCK_SECTORS,
+        .blocks = VCD_CACHE_BLOCKS,
+        .prefetch = VCD_CACHE_PREFETCH,
+        .read = ReadDevice,
+        .opaque = p_access,
+    };
+
+    p_sys->p_cache = vlc_disc_cache_New( p_access, &cfg );
+    if( p_sys->p_cache == NULL )
+    {
+        msg_Warn( p_access, "cannot create read-ahead cache" );
+        return;
+    }
+
+    /* Chapter jumps land on entry points */
+    unsigned i_pinned = 0;
+    for( int i = 0; i < USABLE_TITLES(p_toc->i_tracks); i++ )
+    {
+        for( size_t j = 0; j < p_sys->titles[i].count; j++ )
+        {
+            if( i_pinned++ >= VCD_CACHE_BLOCKS / 2 )
+                return;
+            vlc_disc_cache_Pin( p_sys->p_cache, p_toc->p_sectors[1 + i].i_lba +
+                                p_sys->titles[i].seekpoints[j] / VCD_DATA_SIZE, 1 );
+        }
+    }
+}
+
 /*****************************************************************************
  * Block:
  *****************************************************************************/
@@ -369,8 +457,8 @@ static block_t *Block( stream_t *p_access, bool *restrict eof )
         return NULL;
     }
 
-    if( ioctl_ReadSectors( VLC_OBJECT(p_access), p_sys->vcddev,
-            p_sys->i_sector, p_block->p_buffer, i_blocks, VCD_TYPE ) < 0 )
+    if( ReadSectors( p_access, p_sys->i_sector, p_block->p_buffer,
+                     i_blocks ) < 0 )
     {
         msg_Err( p_access, "cannot read sector %i", p_sys->i_sector );
         block_Release( p_block );
@@ -16,8 +16,30 @@ typedef struct decoder_sys_t {
     bool video_initialized;
     bool audio_initialized;
     bool debug_enabled;
+    vp9_8k_downscale_t downscale_mode;
+    vlc_mutex_t display_lock;
+    uint32_t display_width;
+    uint32_t display_height;
 } decoder_sys_t;
 
+#define SKIP_NONREF_TEXT N_("Lateness before skipping non-reference frames (ms)")
+#define SKIP_NONREF_LONGTEXT N_("When video is this late behind the clock, " \
+    "non-reference VP9 frames are skipped before being decoded.")
+#define SKIP_KEYONLY_TEXT N_("Lateness before decoding keyframes only (ms)")
+#define SKIP_KEYONLY_LONGTEXT N_("When video is this late behind the clock, " \
+    "only VP9 keyframes are decoded until it catches up again.")
+#define DOWNSCALE_TEXT N_("Downscale on decode")
+#define DOWNSCALE_LONGTEXT N_("Output 8K video at a reduced resolution, " \
+    "either fixed or picked automatically from the display size, instead " \
+    "of having the video output scale full 8K pictures.")
+#define THREADS_TEXT N_("Output stage threads")
+#define THREADS_LONGTEXT N_("Number of threads used to downscale " \
+    "decoded pictures (0 for one per CPU).")
+
+static const char *const downscale_values[] = { "off", "auto", "half", "quarter" };
+static const char *const downscale_texts[] = {
+    N_("Disable"), N_("Automatic"), N_("Half resolution"), N_("Quarter resolution") };
+
 // Module descriptor
 vlc_module_begin()
     set_shortname("8KDVD Codec")
@@ -27,6 +49,11 @@ vlc_module_begin()
     set_subcategory(SUBCAT_INPUT_CODEC)
     set_callbacks(Open, Close)
     add_shortcut("8kdvd", "vp9_8k", "opus_8k")
+    add_integer("8kdvd-skip-nonref-late", 20, SKIP_NONREF_TEXT, SKIP_NONREF_LONGTEXT)
+    add_integer("8kdvd-skip-keyonly-late", 500, SKIP_KEYONLY_TEXT, SKIP_KEYONLY_LONGTEXT)
+    add_string("8kdvd-downscale", "off", DOWNSCALE_TEXT, DOWNSCALE_LONGTEXT)
+        change_string_list(downscale_values, downscale_texts)
+    add_integer_with_range("8kdvd-threads", 0, 0, 64, THREADS_TEXT, THREADS_LONGTEXT)
 vlc_module_end()
 
 // Forward declarations
@@ -35,6 +62,32 @@ static void Close(vlc_object_t *);
 static int Decode(decoder_t *, block_t *);
 static int Flush(decoder_t *);
 
+// Display size published by the 8KDVD vout on VOUT_DISPLAY_CHANGE_DISPLAY_SIZE
+static int DisplaySizeCallback(vlc_object_t *obj, const char *name,
+                               vlc_value_t oldval, vlc_value_t newval, void *data) {
+    VLC_UNUSED(obj); VLC_UNUSED(name); VLC_UNUSED(oldval);
+    decoder_sys_t *sys = data;
+    
+    vlc_mutex_lock(&sys->display_lock);
+    sys->display_width = newval.coords.x > 0 ? newval.coords.x : 0;
+    sys->display_height = newval.coords.y > 0 ? newval.coords.y : 0;
+    vlc_mutex_unlock(&sys->display_lock);
+    return VLC_SUCCESS;
+}
+
+static void UpdateDisplaySize(decoder_sys_t *sys) {
+    if (sys->downscale_mode != VP9_8K_DOWNSCALE_AUTO)
+        return;
+    
+    vlc_mutex_lock(&sys->display_lock);
+    uint32_t width = sys->display_width;
+    uint32_t height = sys->display_height;
+    vlc_mutex_unlock(&sys->display_lock);
+    
+    if (width > 0 && height > 0)
+        vp9_8k_decoder_set_display_size(sys->vp9_decoder, width, height);
+}
+
 // Module functions
 static int Open(vlc_object_t *obj) {
     decoder_t *decoder = (decoder_t *)obj;
@@ -45,6 +98,7 @@ static int Open(vlc_object_t *obj) {
     }
     
     msg_Info(decoder, "8KDVD codec module opening");
+    vlc_mutex_init(&sys->display_lock);
     
     // Check if this is a VP9 or Opus stream
     if (decoder->fmt_in.i_codec == VLC_CODEC_VP9) {
@@ -83,9 +137,56 @@ static int Open(vlc_object_t *obj) {
         vp9_8k_decoder_enable_8k_mode(sys->vp9_decoder, true);
         vp9_8k_decoder_optimize_for_8k(sys->vp9_decoder);
         
+        // Deadline-based frame skipping thresholds
+        vp9_8k_decoder_set_skip_thresholds(sys->vp9_decoder,
+            VLC_TICK_FROM_MS(var_InheritInteger(decoder, "8kdvd-skip-nonref-late")),
+            VLC_TICK_FROM_MS(var_InheritInteger(decoder, "8kdvd-skip-keyonly-late")));
+        
+        // Downscale-on-decode, selected from the display size in auto mode
+        char *downscale = var_InheritString(decoder, "8kdvd-downscale");
+        vp9_8k_downscale_t downscale_mode = VP9_8K_DOWNSCALE_OFF;
+        if (downscale) {
+            if (strcmp(downscale, "auto") == 0)
+                downscale_mode = VP9_8K_DOWNSCALE_AUTO;
+            else if (strcmp(downscale, "half") == 0)
+                downscale_mode = VP9_8K_DOWNSCALE_HALF;
+            else if (strcmp(downscale, "quarter") == 0)
+                downscale_mode = VP9_8K_DOWNSCALE_QUARTER;
+            free(downscale);
+        }
+        sys->downscale_mode = downscale_mode;
+        
+        // Full size pictures are copied on the decoder thread
+        if (downscale_mode != VP9_8K_DOWNSCALE_OFF) {
+            int64_t threads = var_InheritInteger(decoder, "8kdvd-threads");
+            vp9_8k_decoder_set_threads(sys->vp9_decoder,
+                                       VLC_CLIP(threads, 0, 64));
+        }
+        if (downscale_mode == VP9_8K_DOWNSCALE_AUTO) {
+            // Shared with the vout, which may already have set it
+            libvlc_int_t *libvlc = vlc_object_instance(decoder);
+            int32_t width = 0, height = 0;
+            
+            var_Create(libvlc, "8kdvd-display-size", VLC_VAR_COORDS);
+            var_AddCallback(libvlc, "8kdvd-display-size", DisplaySizeCallback, sys);
+            var_GetCoords(libvlc, "8kdvd-display-size", &width, &height);
+            
+            vlc_mutex_lock(&sys->display_lock);
+            sys->display_width = width > 0 ? width : 0;
+            sys->display_height = height > 0 ? height : 0;
+            vlc_mutex_unlock(&sys->display_lock);
+        }
+        UpdateDisplaySize(sys);
+        vp9_8k_decoder_set_downscale(sys->vp9_decoder, downscale_mode);
+        
+        uint32_t output_width, output_height;
+        vp9_8k_decoder_get_output_size(sys->vp9_decoder, &output_width, &output_height);
+        
         // Set up video output format
-        decoder->fmt_out.video.i_width = 7680;
-        decoder->fmt_out.video.i_height = 4320;
+        decoder->fmt_out.video.i_width = output_width;
+        decoder->fmt_out.video.i_height = output_height;
+        decoder->fmt_out.video.i_visible_width = output_width;
+        decoder->fmt_out.video.i_visible_height = output_height;
         decoder->fmt_out.video.i_bits_per_pixel = 10;
         decoder->fmt_out.video.i_frame_rate = 60;
         decoder->fmt_out.video.i_frame_rate_base = 1;
@@ -172,6 +273,11 @@ static void Close(vlc_object_t *obj) {
     msg_Info(decoder, "8KDVD codec module closing");
     
     if (sys->vp9_decoder) {
+        if (sys->downscale_mode == VP9_8K_DOWNSCALE_AUTO) {
+            libvlc_int_t *libvlc = vlc_object_instance(decoder);
+            var_DelCallback(libvlc, "8kdvd-display-size", DisplaySizeCallback, sys);
+            var_Destroy(libvlc, "8kdvd-display-size");
+        }
         vp9_8k_decoder_destroy(sys->vp9_decoder);
     }
     
@@ -200,6 +306,46 @@ static int Decode(decoder_t *decoder, block_t *block) {
     }
     
     if (sys->vp9_decoder && sys->video_initialized) {
+        // Skip frames before decoding them when we can't keep up with the
+        // clock, rather than having the vout drop them once decoded
+        if (decoder->b_frame_drop_allowed) {
+            vlc_tick_t lateness = decoder_GetLateness(decoder);
+            if (block->i_pts != VLC_TICK_INVALID) {
+                vlc_tick_t now = vlc_tick_now();
+                vlc_tick_t display_date = decoder_GetDisplayDate(decoder, now, block->i_pts);
+                if (display_date != VLC_TICK_INVALID && now - display_date > lateness)
+                    lateness = now - display_date;
+            }
+            
+            if (vp9_8k_decoder_check_skip(sys->vp9_decoder, block, lateness) != VP9_8K_SKIP_REASON_NONE) {
+                block_Release(block);
+                return 0;
+            }
+        }
+        
+        // Follow display size changes, only switching at keyframes so that
+        // the vout never sees a resolution change mid-GOP
+        vp9_8k_frame_info_t info;
+        if (sys->downscale_mode == VP9_8K_DOWNSCALE_AUTO &&
+            vp9_8k_decoder_parse_frame_info(block->p_buffer, block->i_buffer, &info) == 0 &&
+            info.keyframe) {
+            uint32_t output_width, output_height;
+            
+            UpdateDisplaySize(sys);
+            vp9_8k_decoder_get_output_size(sys->vp9_decoder, &output_width, &output_height);
+            if (output_width != decoder->fmt_out.video.i_width ||
+                output_height != decoder->fmt_out.video.i_height) {
+                decoder->fmt_out.video.i_width = output_width;
+                decoder->fmt_out.video.i_height = output_height;
+                decoder->fmt_out.video.i_visible_width = output_width;
+                decoder->fmt_out.video.i_visible_height = output_height;
+                if (decoder_UpdateVideoOutput(decoder, NULL) != VLC_SUCCESS) {
+                    block_Release(block);
+                    return 0;
+                }
+            }
+        }
+        
         // Decode VP9 8K video
         picture_t *picture = NULL;
         
@@ -221,8 +367,11 @@ static int Decode(decoder_t *decoder, block_t *block) {
             
             if (sys->debug_enabled) {
                 vp9_8k_stats_t stats = vp9_8k_decoder_get_stats(sys->vp9_decoder);
-                msg_Dbg(decoder, "VP9 8K frame decoded: %llu frames, %.2f FPS", 
-                       stats.frames_decoded, stats.average_fps);
+                msg_Dbg(decoder, "VP9 8K frame decoded: %llu frames, %.2f FPS, %"PRIu64" skipped "
+                       "(%"PRIu64" non-ref, %"PRIu64" show-existing, %"PRIu64" keyframe-only, %"PRIu64" preroll)",
+                       stats.frames_decoded, stats.average_fps, stats.dropped_frames,
+                       stats.skipped_nonref, stats.skipped_show_existing,
+                       stats.skipped_keyonly, stats.skipped_preroll);
             }
         }
         
@@ -6,10 +6,15 @@
 #include <vlc_es.h>
 #include <vlc_es_out.h>
 #include <vlc_input_item.h>
+#include <vlc_bits.h>
+#include <vlc_executor.h>
+#include <assert.h>
 #include <string.h>
 #include <stdlib.h>
 #include <time.h>
 
+typedef struct vp9_8k_slice_t vp9_8k_slice_t;
+
 // VP9 8K Decoder Implementation
 struct vp9_8k_decoder_t {
     vlc_object_t *obj;
@@ -29,8 +34,35 @@ struct vp9_8k_decoder_t {
     uint32_t current_bit_depth;
     uint64_t start_time;
     uint64_t last_frame_time;
+    vp9_8k_skip_mode_t skip_mode;
+    vlc_tick_t skip_nonref_late;
+    vlc_tick_t skip_keyonly_late;
+    vp9_8k_downscale_t downscale_mode;
+    uint32_t downscale_factor;        // 1, 2 or 4
+    uint32_t display_width;
+    uint32_t display_height;
+    vlc_executor_t *executor;         // Output stage slice threads
+    vp9_8k_slice_t *slices;
+    unsigned slice_count;
+};
+
+// One horizontal band of the output stage, run on an executor thread
+struct vp9_8k_slice_t {
+    struct vlc_runnable runnable;
+    vp9_8k_decoder_t *decoder;
+    picture_t *picture;
+    uint32_t factor;
+    unsigned first_row;               // First output luma row (even)
+    unsigned last_row;                // Past the last output luma row (even)
+    vlc_latch_t *done;
 };
 
+static void vp9_8k_update_downscale(vp9_8k_decoder_t *decoder);
+
+// Default lateness thresholds for the deadline skip policy
+#define VP9_8K_SKIP_NONREF_LATE  VLC_TICK_FROM_MS(20)
+#define VP9_8K_SKIP_KEYONLY_LATE VLC_TICK_FROM_MS(500)
+
 // VP9 8K Decoder Functions
 vp9_8k_decoder_t* vp9_8k_decoder_create(vlc_object_t *obj) {
     vp9_8k_decoder_t *decoder = calloc(1, sizeof(vp9_8k_decoder_t));
@@ -50,6 +82,16 @@ vp9_8k_decoder_t* vp9_8k_decoder_create(vlc_object_t *obj) {
     decoder->current_bit_depth = 0;
     decoder->start_time = 0;
     decoder->last_frame_time = 0;
+    decoder->skip_mode = VP9_8K_SKIP_NONE;
+    decoder->skip_nonref_late = VP9_8K_SKIP_NONREF_LATE;
+    decoder->skip_keyonly_late = VP9_8K_SKIP_KEYONLY_LATE;
+    decoder->downscale_mode = VP9_8K_DOWNSCALE_OFF;
+    decoder->downscale_factor = 1;
+    decoder->display_width = 0;
+    decoder->display_height = 0;
+    decoder->executor = NULL;
+    decoder->slices = NULL;
+    decoder->slice_count = 0;
     
     // Initialize stats
     memset(&decoder->stats, 0, sizeof(vp9_8k_stats_t));
@@ -84,6 +126,11 @@ void vp9_8k_decoder_destroy(vp9_8k_decoder_t *decoder) {
         free(decoder->decoder_context);
     }
     
+    if (decoder->executor) {
+        vlc_executor_Delete(decoder->executor);
+    }
+    free(decoder->slices);
+    
     free(decoder);
     msg_Info(decoder->obj, "VP9 8K decoder destroyed");
 }
@@ -131,6 +178,7 @@ int vp9_8k_decoder_configure(vp9_8k_decoder_t *decoder, const vp9_8k_config_t *c
     decoder->current_width = config->width;
     decoder->current_height = config->height;
     decoder->current_bit_depth = config->bit_depth;
+    vp9_8k_update_downscale(decoder);
     
     // Initialize decoder context
     if (decoder->decoder_context) {
@@ -169,6 +217,229 @@ int vp9_8k_decoder_set_hdr_mode(vp9_8k_decoder_t *decoder, bool hdr_enabled, boo
     return 0;
 }
 
+// Box filter `factor`x`factor` blocks of 10-bit samples, one output row at a
+// time, writing straight into the output picture plane
+static void vp9_8k_downscale_rows(const uint16_t *src, size_t src_pitch,
+                                  uint8_t *dst, size_t dst_pitch,
+                                  unsigned width, unsigned first, unsigned last,
+                                  uint32_t factor) {
+    if (factor == 1) {
+        for (unsigned y = first; y < last; y++)
+            memcpy(dst + y * dst_pitch, src + y * src_pitch, width * sizeof(uint16_t));
+        return;
+    }
+    
+    if (factor == 2) {
+        for (unsigned y = first; y < last; y++) {
+            const uint16_t *row0 = src + 2 * y * src_pitch;
+            const uint16_t *row1 = row0 + src_pitch;
+            uint16_t *out = (uint16_t *)(dst + y * dst_pitch);
+            
+            for (unsigned x = 0; x < width; x++) {
+                unsigned sum = row0[2 * x] + row0[2 * x + 1]
+                             + row1[2 * x] + row1[2 * x + 1];
+                out[x] = (sum + 2) >> 2;
+            }
+        }
+        return;
+    }
+    
+    assert(factor == 4);
+    for (unsigned y = first; y < last; y++) {
+        const uint16_t *in = src + 4 * y * src_pitch;
+        uint16_t *out = (uint16_t *)(dst + y * dst_pitch);
+        
+        for (unsigned x = 0; x < width; x++) {
+            unsigned sum = 0;
+            for (unsigned j = 0; j < 4; j++) {
+                const uint16_t *row = in + j * src_pitch + 4 * x;
+                sum += row[0] + row[1] + row[2] + row[3];
+            }
+            out[x] = (sum + 8) >> 4;
+        }
+    }
+}
+
+static void vp9_8k_run_slice(void *userdata) {
+    vp9_8k_slice_t *slice = userdata;
+    vp9_8k_decoder_t *decoder = slice->decoder;
+    picture_t *picture = slice->picture;
+    
+    // The reconstructed frame is planar 10-bit 4:2:0 in frame_buffer
+    const uint16_t *src = (const uint16_t *)decoder->frame_buffer;
+    uint32_t width = decoder->current_width;
+    uint32_t height = decoder->current_height;
+    
+    for (int i = 0; i < picture->i_planes && i < 3; i++) {
+        unsigned shift = i > 0 ? 1 : 0;
+        plane_t *plane = &picture->p[i];
+        
+        vp9_8k_downscale_rows(src, width >> shift, plane->p_pixels, plane->i_pitch,
+                              (width >> shift) / slice->factor,
+                              slice->first_row >> shift, slice->last_row >> shift,
+                              slice->factor);
+        src += (size_t)(width >> shift) * (height >> shift);
+    }
+    
+    if (slice->done)
+        vlc_latch_count_down(slice->done, 1);
+}
+
+// Output stage: fused copy/downscale of the reconstructed frame into the
+// output picture, split in bands across the slice threads
+static void vp9_8k_output_picture(vp9_8k_decoder_t *decoder, picture_t *picture) {
+    uint32_t factor = decoder->downscale_factor;
+    unsigned rows = decoder->current_height / factor;
+    
+    if (!decoder->frame_buffer ||
+        decoder->frame_buffer_size < (size_t)decoder->current_width * decoder->current_height * 3)
+        return;
+    
+    if (decoder->slice_count <= 1 || !decoder->executor) {
+        vp9_8k_slice_t slice = {
+            .decoder = decoder,
+            .picture = picture,
+            .factor = factor,
+            .first_row = 0,
+            .last_row = rows,
+            .done = NULL,
+        };
+        vp9_8k_run_slice(&slice);
+        return;
+    }
+    
+    // Keep bands on even rows so that chroma rows are not shared
+    unsigned count = decoder->slice_count;
+    unsigned band = ((rows + count - 1) / count + 1) & ~1u;
+    vlc_latch_t done;
+    unsigned submitted = 0;
+    
+    for (unsigned i = 0; i < count && i * band < rows; i++) {
+        vp9_8k_slice_t *slice = &decoder->slices[i];
+        
+        slice->decoder = decoder;
+        slice->picture = picture;
+        slice->factor = factor;
+        slice->first_row = i * band;
+        slice->last_row = __MIN(rows, (i + 1) * band);
+        slice->done = &done;
+        slice->runnable.run = vp9_8k_run_slice;
+        slice->runnable.userdata = slice;
+        submitted++;
+    }
+    
+    // Run the first band on the decoder thread, the others on the executor
+    vlc_latch_init(&done, submitted);
+    for (unsigned i = 1; i < submitted; i++)
+        vlc_executor_Submit(decoder->executor, &decoder->slices[i].runnable);
+    vp9_8k_run_slice(&decoder->slices[0]);
+    vlc_latch_wait(&done);
+}
+
+int vp9_8k_decoder_set_threads(vp9_8k_decoder_t *decoder, unsigned threads) {
+    if (!decoder) return -1;
+    
+    if (threads == 0) {
+        threads = vlc_GetCPUCount();
+    }
+    
+    if (decoder->executor) {
+        vlc_executor_Delete(decoder->executor);
+        decoder->executor = NULL;
+    }
+    free(decoder->slices);
+    decoder->slices = NULL;
+    decoder->slice_count = 0;
+    
+    if (threads > 1) {
+        decoder->slices = calloc(threads, sizeof(*decoder->slices));
+        if (!decoder->slices) {
+            msg_Err(decoder->obj, "Failed to allocate VP9 8K output slices");
+            return -1;
+        }
+        
+        // The decoder thread runs one band itself
+        decoder->executor = vlc_executor_New(threads - 1);
+        if (!decoder->executor) {
+            msg_Err(decoder->obj, "Failed to create VP9 8K slice threads");
+            free(decoder->slices);
+            decoder->slices = NULL;
+            return -1;
+        }
+        decoder->slice_count = threads;
+    }
+    
+    msg_Info(decoder->obj, "VP9 8K output stage using %u slice thread(s)", threads);
+    return 0;
+}
+
+// Pick the smallest output that still covers the display
+static void vp9_8k_update_downscale(vp9_8k_decoder_t *decoder) {
+    uint32_t factor = 1;
+    
+    switch (decoder->downscale_mode) {
+        case VP9_8K_DOWNSCALE_OFF:
+            factor = 1;
+            break;
+        case VP9_8K_DOWNSCALE_HALF:
+            factor = 2;
+            break;
+        case VP9_8K_DOWNSCALE_QUARTER:
+            factor = 4;
+            break;
+        case VP9_8K_DOWNSCALE_AUTO:
+            if (decoder->display_width == 0 || decoder->display_height == 0)
+                break;
+            factor = 4;
+            while (factor > 1 &&
+                   (decoder->current_width / factor < decoder->display_width ||
+                    decoder->current_height / factor < decoder->display_height))
+                factor /= 2;
+            break;
+    }
+    
+    // Chroma of 4:2:0 must stay whole after the downscale
+    while (factor > 1 &&
+           ((decoder->current_width % (2 * factor)) || (decoder->current_height % (2 * factor))))
+        factor /= 2;
+    
+    if (factor != decoder->downscale_factor) {
+        msg_Info(decoder->obj, "VP9 8K output downscale 1/%u: %ux%u", factor,
+                 decoder->current_width / factor, decoder->current_height / factor);
+        decoder->downscale_factor = factor;
+    }
+}
+
+int vp9_8k_decoder_set_downscale(vp9_8k_decoder_t *decoder, vp9_8k_downscale_t mode) {
+    if (!decoder) return -1;
+    
+    decoder->downscale_mode = mode;
+    vp9_8k_update_downscale(decoder);
+    return 0;
+}
+
+int vp9_8k_decoder_set_display_size(vp9_8k_decoder_t *decoder, uint32_t width, uint32_t height) {
+    if (!decoder) return -1;
+    
+    if (width == decoder->display_width && height == decoder->display_height)
+        return 0;
+    
+    decoder->display_width = width;
+    decoder->display_height = height;
+    vp9_8k_update_downscale(decoder);
+    return 0;
+}
+
+void vp9_8k_decoder_get_output_size(vp9_8k_decoder_t *decoder, uint32_t *width, uint32_t *height) {
+    if (!decoder) {
+        *width = *height = 0;
+        return;
+    }
+    
+    *width = decoder->current_width / decoder->downscale_factor;
+    *height = decoder->current_height / decoder->downscale_factor;
+}
+
 int vp9_8k_decoder_decode_frame(vp9_8k_decoder_t *decoder, block_t *input_block, picture_t **output_picture) {
     if (!decoder || !input_block || !output_picture) return -1;
     
@@ -184,15 +455,18 @@ int vp9_8k_decoder_decode_frame(vp9_8k_decoder_t *decoder, block_t *input_block,
         msg_Dbg(decoder->obj, "Decoding VP9 8K frame: %zu bytes", input_block->i_buffer);
     }
     
-    // Create output picture
+    // Create output picture, possibly downscaled for the display
+    uint32_t output_width, output_height;
+    vp9_8k_decoder_get_output_size(decoder, &output_width, &output_height);
+    
     picture_t *picture = picture_NewFromFormat(&(video_format_t){
         .i_chroma = VLC_CODEC_I420_10L,
-        .i_width = decoder->current_width,
-        .i_height = decoder->current_height,
+        .i_width = output_width,
+        .i_height = output_height,
         .i_x_offset = 0,
         .i_y_offset = 0,
-        .i_visible_width = decoder->current_width,
-        .i_visible_height = decoder->current_height,
+        .i_visible_width = output_width,
+        .i_visible_height = output_height,
         .i_sar_num = 1,
         .i_sar_den = 1,
         .i_frame_rate = decoder->config.frame_rate,
@@ -230,6 +504,9 @@ int vp9_8k_decoder_decode_frame(vp9_8k_decoder_t *decoder, block_t *input_block,
         }
     }
     
+    // Output stage: copy or downscale the reconstructed frame into the picture
+    vp9_8k_output_picture(decoder, picture);
+    
     // Set HDR metadata if enabled
     if (decoder->hdr_enabled) {
         picture->p_sys = malloc(sizeof(vlc_meta_t));
@@ -275,9 +552,241 @@ int vp9_8k_decoder_flush(vp9_8k_decoder_t *decoder) {
     // Reset decoder state
     decoder->stats.dropped_frames = 0;
     
+    // References are gone after a flush, wait for the clock to tell us again
+    decoder->skip_mode = VP9_8K_SKIP_NONE;
+    
+    return 0;
+}
+
+// Parse the uncompressed header of a single VP9 frame, up to
+// refresh_frame_flags, which tells whether later frames depend on it
+static int vp9_8k_parse_frame_header(const uint8_t *data, size_t size,
+                                     bool *keyframe, bool *show_existing,
+                                     bool *reference) {
+    bs_t bs;
+    bs_init(&bs, data, size);
+    
+    if (bs_read(&bs, 2) != 0x2) // frame_marker
+        return -1;
+    
+    uint32_t profile = bs_read1(&bs);
+    profile |= bs_read1(&bs) << 1;
+    if (profile == 3)
+        bs_skip(&bs, 1); // reserved_zero
+    
+    *keyframe = false;
+    *show_existing = bs_read1(&bs);
+    if (*show_existing) {
+        // Nothing gets decoded nor refreshed, the frame is only re-shown
+        *reference = false;
+        return bs_error(&bs) ? -1 : 0;
+    }
+    
+    bool non_key = bs_read1(&bs);
+    bool show_frame = bs_read1(&bs);
+    bool error_resilient = bs_read1(&bs);
+    
+    if (!non_key) {
+        // Keyframes refresh every reference slot
+        *keyframe = true;
+        *reference = true;
+        return bs_error(&bs) ? -1 : 0;
+    }
+    
+    bool intra_only = show_frame ? false : bs_read1(&bs);
+    if (!error_resilient)
+        bs_skip(&bs, 2); // reset_frame_context
+    
+    if (intra_only) {
+        if (bs_read(&bs, 24) != 0x498342) // frame_sync_code
+            return -1;
+        if (profile > 0) {
+            // color_config()
+            if (profile >= 2)
+                bs_skip(&bs, 1); // ten_or_twelve_bit
+            uint32_t color_space = bs_read(&bs, 3);
+            if (color_space != 7 /* CS_RGB */) {
+                bs_skip(&bs, 1); // color_range
+                if (profile == 1 || profile == 3)
+                    bs_skip(&bs, 3); // subsampling_x/y, reserved_zero
+            } else if (profile == 1 || profile == 3) {
+                bs_skip(&bs, 1); // reserved_zero
+            }
+        }
+    }
+    
+    *reference = bs_read(&bs, 8) != 0; // refresh_frame_flags
+    return bs_error(&bs) ? -1 : 0;
+}
+
+int vp9_8k_decoder_parse_frame_info(const uint8_t *data, size_t size, vp9_8k_frame_info_t *info) {
+    if (!data || !size || !info) return -1;
+    
+    memset(info, 0, sizeof(*info));
+    
+    // Superframes pack several frames (typically a hidden ARF and a shown
+    // frame) with an index in the trailing bytes
+    size_t frame_sizes[8];
+    uint32_t frame_count = 1;
+    frame_sizes[0] = size;
+    
+    uint8_t marker = data[size - 1];
+    if ((marker & 0xe0) == 0xc0) {
+        uint32_t count = (marker & 0x7) + 1;
+        uint32_t mag = ((marker >> 3) & 0x3) + 1;
+        size_t index_size = 2 + mag * count;
+        
+        if (size >= index_size && data[size - index_size] == marker) {
+            const uint8_t *index = &data[size - index_size + 1];
+            size_t total = 0;
+            
+            for (uint32_t i = 0; i < count; i++) {
+                size_t frame_size = 0;
+                for (uint32_t j = 0; j < mag; j++)
+                    frame_size |= (size_t)*index++ << (j * 8);
+                frame_sizes[i] = frame_size;
+                total += frame_size;
+            }
+            
+            if (total > size - index_size) return -1;
+            frame_count = count;
+        }
+    }
+    
+    info->frame_count = frame_count;
+    
+    size_t offset = 0;
+    for (uint32_t i = 0; i < frame_count; i++) {
+        bool keyframe, show_existing, reference;
+        
+        if (frame_sizes[i] == 0) continue;
+        if (vp9_8k_parse_frame_header(&data[offset], frame_sizes[i],
+                                      &keyframe, &show_existing, &reference) != 0)
+            return -1;
+        
+        if (i == 0) {
+            info->keyframe = keyframe;
+            info->show_existing_frame = show_existing;
+        } else {
+            info->show_existing_frame &= show_existing;
+        }
+        info->reference |= reference;
+        offset += frame_sizes[i];
+    }
+    
+    return 0;
+}
+
+vp9_8k_skip_reason_t vp9_8k_decoder_check_skip(vp9_8k_decoder_t *decoder, block_t *input_block, vlc_tick_t lateness) {
+    if (!decoder || !input_block) return VP9_8K_SKIP_REASON_NONE;
+    
+    vp9_8k_frame_info_t info;
+    if (vp9_8k_decoder_parse_frame_info(input_block->p_buffer, input_block->i_buffer, &info) != 0) {
+        // Never skip what we can't understand, let the decoder report it
+        return VP9_8K_SKIP_REASON_NONE;
+    }
+    
+    vp9_8k_skip_mode_t mode = decoder->skip_mode;
+    
+    // Escalate as soon as we are late enough, only relax with some margin so
+    // that the policy doesn't oscillate around a threshold. Leaving the
+    // keyframe-only mode needs a keyframe since the references are missing.
+    if (lateness >= decoder->skip_keyonly_late) {
+        mode = VP9_8K_SKIP_KEYONLY;
+    } else if (mode == VP9_8K_SKIP_KEYONLY) {
+        if (info.keyframe && lateness < decoder->skip_keyonly_late / 2)
+            mode = VP9_8K_SKIP_NONREF;
+    } else if (lateness >= decoder->skip_nonref_late) {
+        mode = VP9_8K_SKIP_NONREF;
+    } else if (mode == VP9_8K_SKIP_NONREF && lateness < decoder->skip_nonref_late / 2) {
+        mode = VP9_8K_SKIP_NONE;
+    }
+    
+    if (mode != decoder->skip_mode) {
+        if (mode > decoder->skip_mode)
+            decoder->stats.skip_escalations++;
+        else
+            decoder->stats.skip_recoveries++;
+        
+        msg_Dbg(decoder->obj, "VP9 8K skip mode %d -> %d (%"PRId64" ms late)",
+                decoder->skip_mode, mode, MS_FROM_VLC_TICK(lateness));
+        decoder->skip_mode = mode;
+    }
+    
+    vp9_8k_skip_reason_t reason = VP9_8K_SKIP_REASON_NONE;
+    
+    if (info.keyframe) {
+        reason = VP9_8K_SKIP_REASON_NONE;
+    } else if (input_block->i_flags & BLOCK_FLAG_PREROLL) {
+        // Prerolled frames are never displayed, only references matter
+        if (!info.reference)
+            reason = VP9_8K_SKIP_REASON_PREROLL;
+    } else if (mode == VP9_8K_SKIP_KEYONLY) {
+        reason = VP9_8K_SKIP_REASON_KEYONLY;
+    } else if (mode == VP9_8K_SKIP_NONREF && !info.reference) {
+        reason = info.show_existing_frame ? VP9_8K_SKIP_REASON_SHOW_EXISTING
+                                          : VP9_8K_SKIP_REASON_NONREF;
+    }
+    
+    switch (reason) {
+        case VP9_8K_SKIP_REASON_NONREF:
+            decoder->stats.skipped_nonref++;
+            break;
+        case VP9_8K_SKIP_REASON_SHOW_EXISTING:
+            decoder->stats.skipped_show_existing++;
+            break;
+        case VP9_8K_SKIP_REASON_KEYONLY:
+            decoder->stats.skipped_keyonly++;
+            break;
+        case VP9_8K_SKIP_REASON_PREROLL:
+            decoder->stats.skipped_preroll++;
+            break;
+        case VP9_8K_SKIP_REASON_NONE:
+            return reason;
+    }
+    
+    decoder->stats.dropped_frames++;
+    
+    if (decoder->debug_enabled) {
+        msg_Dbg(decoder->obj, "Skipping VP9 8K frame before decode: %s",
+                vp9_8k_decoder_skip_reason_name(reason));
+    }
+    
+    return reason;
+}
+
+int vp9_8k_decoder_set_skip_thresholds(vp9_8k_decoder_t *decoder, vlc_tick_t nonref_threshold, vlc_tick_t keyonly_threshold) {
+    if (!decoder) return -1;
+    
+    if (nonref_threshold <= 0 || keyonly_threshold < nonref_threshold) {
+        msg_Err(decoder->obj, "Invalid VP9 8K skip thresholds: %"PRId64"/%"PRId64" ms",
+                MS_FROM_VLC_TICK(nonref_threshold), MS_FROM_VLC_TICK(keyonly_threshold));
+        return -1;
+    }
+    
+    decoder->skip_nonref_late = nonref_threshold;
+    decoder->skip_keyonly_late = keyonly_threshold;
+    
+    msg_Info(decoder->obj, "VP9 8K skip thresholds: non-reference %"PRId64" ms, keyframe-only %"PRId64" ms",
+             MS_FROM_VLC_TICK(nonref_threshold), MS_FROM_VLC_TICK(keyonly_threshold));
     return 0;
 }
 
+vp9_8k_skip_mode_t vp9_8k_decoder_get_skip_mode(vp9_8k_decoder_t *decoder) {
+    return decoder ? decoder->skip_mode : VP9_8K_SKIP_NONE;
+}
+
+const char *vp9_8k_decoder_skip_reason_name(vp9_8k_skip_reason_t reason) {
+    switch (reason) {
+        case VP9_8K_SKIP_REASON_NONREF: return "late non-reference frame";
+        case VP9_8K_SKIP_REASON_SHOW_EXISTING: return "late show_existing_frame";
+        case VP9_8K_SKIP_REASON_KEYONLY: return "waiting for keyframe";
+        case VP9_8K_SKIP_REASON_PREROLL: return "non-reference frame in preroll";
+        case VP9_8K_SKIP_REASON_NONE: break;
+    }
+    return "none";
+}
+
 int vp9_8k_decoder_reset(vp9_8k_decoder_t *decoder) {
     if (!decoder) return -1;
     
@@ -322,6 +831,7 @@ int vp9_8k_decoder_set_8k_resolution(vp9_8k_decoder_t *decoder, uint32_t width,
     decoder->config.height = height;
     decoder->current_width = width;
     decoder->current_height = height;
+    vp9_8k_update_downscale(decoder);
     
     msg_Info(decoder->obj, "8K resolution set: %ux%u", width, height);
     return 0;
@@ -632,6 +1142,12 @@ void vp9_8k_decoder_log_stats(vp9_8k_decoder_t *decoder) {
     msg_Info(decoder->obj, "  Bytes Processed: %llu", decoder->stats.bytes_processed);
     msg_Info(decoder->obj, "  Total Decode Time: %llu us", decoder->stats.decode_time_us);
     msg_Info(decoder->obj, "  Dropped Frames: %llu", decoder->stats.dropped_frames);
+    msg_Info(decoder->obj, "    Late Non-Reference: %"PRIu64, decoder->stats.skipped_nonref);
+    msg_Info(decoder->obj, "    Late Show-Existing: %"PRIu64, decoder->stats.skipped_show_existing);
+    msg_Info(decoder->obj, "    Keyframe-Only: %"PRIu64, decoder->stats.skipped_keyonly);
+    msg_Info(decoder->obj, "    Preroll: %"PRIu64, decoder->stats.skipped_preroll);
+    msg_Info(decoder->obj, "  Skip Escalations/Recoveries: %"PRIu64"/%"PRIu64,
+             decoder->stats.skip_escalations, decoder->stats.skip_recoveries);
     msg_Info(decoder->obj, "  Average FPS: %.2f", decoder->stats.average_fps);
     msg_Info(decoder->obj, "  Average Decode Time: %.2f us", decoder->stats.average_decode_time);
     msg_Info(decoder->obj, "  Memory Usage: %u MB", decoder->stats.memory_usage_mb);
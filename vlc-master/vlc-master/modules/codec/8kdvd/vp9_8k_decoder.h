@@ -39,8 +39,46 @@ typedef struct vp9_8k_stats_t {
     float average_decode_time;        // Average decode time per frame
     uint32_t current_frame_rate;      // Current frame rate
     uint32_t memory_usage_mb;         // Memory usage in MB
+    uint64_t skipped_nonref;          // Non-reference frames skipped while late
+    uint64_t skipped_show_existing;   // show_existing_frame frames skipped while late
+    uint64_t skipped_keyonly;         // Inter frames skipped in keyframe-only mode
+    uint64_t skipped_preroll;         // Non-reference frames skipped during preroll
+    uint64_t skip_escalations;        // Times the skip policy got more aggressive
+    uint64_t skip_recoveries;         // Times the skip policy relaxed
 } vp9_8k_stats_t;
 
+// VP9 frame header summary, parsed before decoding
+typedef struct vp9_8k_frame_info_t {
+    uint32_t frame_count;             // Frames in the block (>1 for superframes)
+    bool keyframe;                    // First frame is a keyframe
+    bool show_existing_frame;         // Only re-shows an already decoded frame
+    bool reference;                   // At least one frame refreshes a reference slot
+} vp9_8k_frame_info_t;
+
+// Deadline skip policy, escalated with lateness
+typedef enum vp9_8k_skip_mode_t {
+    VP9_8K_SKIP_NONE = 0,             // Decode everything
+    VP9_8K_SKIP_NONREF,               // Skip non-reference frames
+    VP9_8K_SKIP_KEYONLY               // Skip everything until the next keyframe
+} vp9_8k_skip_mode_t;
+
+// Why a frame was skipped before decode
+typedef enum vp9_8k_skip_reason_t {
+    VP9_8K_SKIP_REASON_NONE = 0,      // Frame must be decoded
+    VP9_8K_SKIP_REASON_NONREF,        // Late non-reference frame
+    VP9_8K_SKIP_REASON_SHOW_EXISTING, // Late show_existing_frame
+    VP9_8K_SKIP_REASON_KEYONLY,       // Waiting for a keyframe
+    VP9_8K_SKIP_REASON_PREROLL        // Non-reference frame that won't be displayed
+} vp9_8k_skip_reason_t;
+
+// Downscale-on-decode mode
+typedef enum vp9_8k_downscale_t {
+    VP9_8K_DOWNSCALE_OFF = 0,         // Always output full resolution
+    VP9_8K_DOWNSCALE_AUTO,            // Pick the factor from the display size
+    VP9_8K_DOWNSCALE_HALF,            // Always output half resolution
+    VP9_8K_DOWNSCALE_QUARTER          // Always output quarter resolution
+} vp9_8k_downscale_t;
+
 // VP9 8K Decoder Functions
 vp9_8k_decoder_t* vp9_8k_decoder_create(vlc_object_t *obj);
 void vp9_8k_decoder_destroy(vp9_8k_decoder_t *decoder);
@@ -55,6 +93,19 @@ int vp9_8k_decoder_decode_frame(vp9_8k_decoder_t *decoder, block_t *input_block,
 int vp9_8k_decoder_flush(vp9_8k_decoder_t *decoder);
 int vp9_8k_decoder_reset(vp9_8k_decoder_t *decoder);
 
+// Deadline-based Frame Skipping
+int vp9_8k_decoder_parse_frame_info(const uint8_t *data, size_t size, vp9_8k_frame_info_t *info);
+vp9_8k_skip_reason_t vp9_8k_decoder_check_skip(vp9_8k_decoder_t *decoder, block_t *input_block, vlc_tick_t lateness);
+int vp9_8k_decoder_set_skip_thresholds(vp9_8k_decoder_t *decoder, vlc_tick_t nonref_threshold, vlc_tick_t keyonly_threshold);
+vp9_8k_skip_mode_t vp9_8k_decoder_get_skip_mode(vp9_8k_decoder_t *decoder);
+const char *vp9_8k_decoder_skip_reason_name(vp9_8k_skip_reason_t reason);
+
+// Downscale-on-decode
+int vp9_8k_decoder_set_threads(vp9_8k_decoder_t *decoder, unsigned threads);
+int vp9_8k_decoder_set_downscale(vp9_8k_decoder_t *decoder, vp9_8k_downscale_t mode);
+int vp9_8k_decoder_set_display_size(vp9_8k_decoder_t *decoder, uint32_t width, uint32_t height);
+void vp9_8k_decoder_get_output_size(vp9_8k_decoder_t *decoder, uint32_t *width, uint32_t *height);
+
 // 8K Specific Functions
 int vp9_8k_decoder_enable_8k_mode(vp9_8k_decoder_t *decoder, bool enable);
 int vp9_8k_decoder_set_8k_resolution(vp9_8k_decoder_t *decoder, uint32_t width, uint32_t height);
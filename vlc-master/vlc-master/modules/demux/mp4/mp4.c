@@ -169,6 +169,8 @@ typedef struct
 #define DEMUX_INCREMENT VLC_TICK_FROM_MS(250) /* How far the pcr will go, each round */
 #define DEMUX_TRACK_MAX_PRELOAD VLC_TICK_FROM_SEC(15) /* maximum preloading, to deal with interleaving */
 
+#define INDEX_PREFETCH_SIZE (256 * 1024) /* file tail holding the mfra index */
+
 #define INVALID_PRELOAD  UINT_MAX
 #define UNKNOWN_DELTA    UINT32_MAX
 #define INVALID_PTS      VLC_TICK_MIN
@@ -1413,6 +1415,15 @@ static int Open( vlc_object_t * p_this )
     {
         p_demux->pf_demux = DemuxFrag;
         msg_Dbg( p_demux, "Set Fragmented demux mode" );
+
+        /* Without sidx, the first seek reads the mfra index at the end */
+        uint64_t i_size;
+        if( p_sys->b_seekable && !MP4_BoxGet( p_sys->p_root, "sidx" ) &&
+            vlc_stream_GetSize( p_demux->s, &i_size ) == VLC_SUCCESS )
+        {
+            uint64_t i_tail = __MIN( i_size, INDEX_PREFETCH_SIZE );
+            vlc_stream_SetPrefetchHint( p_demux->s, i_size - i_tail, i_tail );
+        }
     }
 
     if( !p_sys->b_seekable && p_demux->pf_demux == Demux )
@@ -40,6 +40,7 @@
 #include "ts_streams_private.h"
 #include "ts_packet.h"
 #include "ts_pes.h"
+#include "ts_packets.h"
 #include "ts_psi.h"
 #include "ts_si.h"
 #include "ts_psip.h"
@@ -167,7 +168,7 @@ vlc_module_begin ()
 
     set_capability( "demux", 10 )
     set_callbacks( Open, Close )
-    add_shortcut( "ts" )
+    add_shortcut( "ts", "m2ts" )
 vlc_module_end ()
 
 /*****************************************************************************
@@ -190,6 +191,8 @@ static bool GatherPESData( demux_t *p_demux, ts_pid_t *, block_t *, size_t );
 static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_prg, vlc_tick_t i_pcr );
 
 static block_t* ReadTSPacket( demux_t *p_demux );
+static uint64_t StreamTell( demux_sys_t * );
+static int StreamSeek( demux_sys_t *, uint64_t );
 static int SeekToTime( demux_t *p_demux, const ts_pmt_t *, vlc_tick_t time );
 static void ReadyQueuesPostSeek( demux_t *p_demux );
 static void PCRHandle( demux_t *p_demux, ts_pid_t *, ts_90khz_t );
@@ -363,10 +366,19 @@ static int Open( vlc_object_t *p_this )
     ts_pid_t    *patpid;
     vdr_info_t   vdr = {0};
 
-    /* Search first sync byte */
-    i_packet_size = DetectPVRHeadersAndHeaderSize( p_demux, &i_packet_header_size, &vdr );
-    if( i_packet_size < 0 )
-        return VLC_EGENERIC;
+    if( demux_IsForced( p_demux, "m2ts" ) )
+    {
+        /* BluRay aligned units, nothing may be there to peek at yet */
+        i_packet_size = TS_PACKET_SIZE_192;
+        i_packet_header_size = 4;
+    }
+    else
+    {
+        /* Search first sync byte */
+        i_packet_size = DetectPVRHeadersAndHeaderSize( p_demux, &i_packet_header_size, &vdr );
+        if( i_packet_size < 0 )
+            return VLC_EGENERIC;
+    }
 
     p_demux->p_sys = p_sys = malloc( sizeof( demux_sys_t ) );
     if( !p_sys )
@@ -395,6 +407,11 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_packet_size = i_packet_size;
     p_sys->i_packet_header_size = i_packet_header_size;
     p_sys->i_ts_read = 50;
+    if( ts_packets_Init( &p_sys->packets, i_packet_size, i_packet_header_size ) )
+    {
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
     p_sys->csa = NULL;
     p_sys->b_start_record = false;
     p_sys->record_dir_path = NULL;
@@ -410,12 +427,14 @@ static int Open( vlc_object_t *p_this )
     patpid = GetPID(p_sys, 0);
     if ( !PIDSetup( p_demux, TYPE_PAT, patpid, NULL ) )
     {
+        ts_packets_Clean( &p_sys->packets );
         free( p_sys );
         return VLC_ENOMEM;
     }
     if( !ts_psi_PAT_Attach( patpid, p_demux ) )
     {
         PIDRelease( p_demux, patpid );
+        ts_packets_Clean( &p_sys->packets );
         free( p_sys );
         return VLC_EGENERIC;
     }
@@ -589,6 +608,7 @@ static void Close( vlc_object_t *p_this )
     /* Clear up attachments */
     vlc_dictionary_clear( &p_sys->attachments, FreeDictAttachment, NULL );
 
+    ts_packets_Clean( &p_sys->packets );
     free( p_sys->record_dir_path );
     free( p_sys );
 }
@@ -651,13 +671,6 @@ static int Demux( demux_t *p_demux )
             p_sys->b_start_record = false;
         }
 
-        /* Early reject truncated packets from hw devices */
-        if( unlikely(p_pkt->i_buffer < TS_PACKET_SIZE_188) )
-        {
-            block_Release( p_pkt );
-            continue;
-        }
-
         /* Reject any fully uncorrected packet. Even PID can be incorrect */
         if( p_pkt->p_buffer[1]&0x80 )
         {
@@ -957,7 +970,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         if( vlc_stream_GetSize( p_sys->stream, &u64 ) == VLC_SUCCESS )
         {
-            uint64_t offset = vlc_stream_Tell( p_sys->stream );
+            uint64_t offset = StreamTell( p_sys );
             *pf = (double)offset / (double)u64;
             return VLC_SUCCESS;
         }
@@ -1003,7 +1016,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
         }
 
         if( vlc_stream_GetSize( p_sys->stream, &u64 ) == VLC_SUCCESS &&
-            vlc_stream_Seek( p_sys->stream, (uint64_t)(u64 * f) ) == VLC_SUCCESS )
+            StreamSeek( p_sys, (uint64_t)(u64 * f) ) == VLC_SUCCESS )
         {
             ReadyQueuesPostSeek( p_demux );
             return VLC_SUCCESS;
@@ -1153,9 +1166,12 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
     }
 
     case DEMUX_SET_TITLE:
+        /* The access moves, drop what was read ahead */
+        ts_packets_Flush( &p_sys->packets );
         return vlc_stream_vaControl( p_sys->stream, STREAM_SET_TITLE, args );
 
     case DEMUX_SET_SEEKPOINT:
+        ts_packets_Flush( &p_sys->packets );
         return vlc_stream_vaControl( p_sys->stream, STREAM_SET_SEEKPOINT,
                                      args );
 
@@ -1786,87 +1802,38 @@ static void PESDataChainHandle( vlc_object_t *p_obj, void *priv, block_t *p_data
     ParsePESDataChain( (demux_t *)p_obj, (ts_pid_t *) priv, p_data, i_flags, i_appendpcr );
 }
 
-static bool CheckAndResync( demux_t *p_demux )
+static uint64_t StreamTell( demux_sys_t *p_sys )
 {
-    demux_sys_t *p_sys = p_demux->p_sys;
-
-    const uint8_t *p_peek;
-    if( vlc_stream_Peek( p_sys->stream, &p_peek, 1 ) != 1 )
-        return true;
-
-    /* Check sync byte and re-sync if needed */
-    if( p_peek[0] == 0x47 )
-        return true;
-
-    msg_Warn( p_demux, "lost synchro at %" PRIu64, vlc_stream_Tell( p_sys->stream ) );
-
-    for( ;; )
-    {
-        ssize_t i_peek = 0;
-        unsigned i_skip = 0;
-
-        i_peek = vlc_stream_Peek( p_sys->stream, &p_peek,
-                                  p_sys->i_packet_size * 10 );
-        if( i_peek < 0 || (size_t)i_peek < p_sys->i_packet_size + 1 )
-        {
-            msg_Dbg( p_demux, "eof ?" );
-            return false;
-        }
-
-        while( i_skip < i_peek - p_sys->i_packet_size )
-        {
-            if( p_peek[i_skip + p_sys->i_packet_header_size] == 0x47 &&
-                p_peek[i_skip + p_sys->i_packet_header_size + p_sys->i_packet_size] == 0x47 )
-                break;
-            i_skip++;
-        }
-        msg_Dbg( p_demux, "skipping %d bytes of garbage at %"PRIu64,
-                 i_skip, vlc_stream_Tell( p_sys->stream ) );
-        if (vlc_stream_Read( p_sys->stream, NULL, i_skip ) != i_skip)
-            return false;
-
-        if( i_skip < i_peek - p_sys->i_packet_size )
-            break;
-    }
-    msg_Dbg( p_demux, "resynced at %" PRIu64, vlc_stream_Tell( p_sys->stream ) );
+    /* Position of the next packet, not of the stream read ahead */
+    return vlc_stream_Tell( p_sys->stream ) - ts_packets_Buffered( &p_sys->packets );
+}
 
-    return true;
+static int StreamSeek( demux_sys_t *p_sys, uint64_t i_pos )
+{
+    ts_packets_Flush( &p_sys->packets );
+    return vlc_stream_Seek( p_sys->stream, i_pos );
 }
 
 static block_t* ReadTSPacket( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
 
-    if( !CheckAndResync( p_demux) )
-        return NULL;
-
-    block_t     *p_pkt;
-
-    /* Get a new TS packet */
-    if( !( p_pkt = vlc_stream_Block( p_sys->stream, p_sys->i_packet_size ) ) )
+    /* Get a new TS packet, only valid until the next one is read */
+    block_t *p_pkt = ts_packets_Read( &p_sys->packets, VLC_OBJECT(p_demux),
+                                      p_sys->stream );
+    if( !p_pkt )
     {
+        /* Running out of data is not an error, streams without size may
+         * get more later */
         uint64_t size;
-        if( vlc_stream_GetSize( p_sys->stream, &size ) == VLC_SUCCESS &&
-            size == vlc_stream_Tell( p_sys->stream ) )
+        if( !vlc_stream_Eof( p_sys->stream ) )
+            msg_Dbg( p_demux, "Can't read TS packet at %"PRIu64, StreamTell( p_sys ) );
+        else if( vlc_stream_GetSize( p_sys->stream, &size ) == VLC_SUCCESS &&
+                 size == vlc_stream_Tell( p_sys->stream ) )
             msg_Dbg( p_demux, "EOF at %"PRIu64, size );
-        else
-            msg_Dbg( p_demux, "Can't read TS packet at %"PRIu64, vlc_stream_Tell(p_sys->stream) );
-        return NULL;
-    }
-
-    if( p_pkt->i_buffer < TS_HEADER_SIZE + p_sys->i_packet_header_size )
-    {
-        block_Release( p_pkt );
         return NULL;
     }
 
-    /* Skip header (BluRay streams).
-     * re-sync logic would do this (by adjusting packet start), but this would result in losing first and last ts packets.
-     * First packet is usually PAT, and losing it means losing whole first GOP. This is fatal with still-image based menus.
-     */
-    p_pkt->p_buffer += p_sys->i_packet_header_size;
-    p_pkt->i_buffer -= p_sys->i_packet_header_size;
-
     return p_pkt;
 }
 
@@ -1972,7 +1939,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, vlc_tick_t i_see
 
     /* Deal with common but worst binary search case */
     if( p_pmt->pcr.i_first == i_seektime && p_sys->b_canseek )
-        return vlc_stream_Seek( p_sys->stream, 0 );
+        return StreamSeek( p_sys, 0 );
 
     uint64_t i_stream_size;
     if( vlc_stream_GetSize( p_sys->stream, &i_stream_size ) != VLC_SUCCESS )
@@ -1981,7 +1948,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, vlc_tick_t i_see
     if( !p_sys->b_canfastseek || i_stream_size < p_sys->i_packet_size )
         return VLC_EGENERIC;
 
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = StreamTell( p_sys );
 
     /* Find the time position by using binary search algorithm. */
     uint64_t i_head_pos = 0;
@@ -1997,7 +1964,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, vlc_tick_t i_see
         uint64_t i_div = i_splitpos % p_sys->i_packet_size;
         i_splitpos -= i_div;
 
-        if ( vlc_stream_Seek( p_sys->stream, i_splitpos ) != VLC_SUCCESS )
+        if ( StreamSeek( p_sys, i_splitpos ) != VLC_SUCCESS )
             break;
 
         uint64_t i_pos = i_splitpos;
@@ -2011,7 +1978,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, vlc_tick_t i_see
                 break;
             }
             else
-                i_pos = vlc_stream_Tell( p_sys->stream );
+                i_pos = StreamTell( p_sys );
 
             int i_pid = PIDGet( p_pkt );
             ts_pid_t *p_pid = GetPID(p_sys, i_pid);
@@ -2059,7 +2026,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, vlc_tick_t i_see
     if( !b_found )
     {
         msg_Dbg( p_demux, "Seek():cannot find a time position." );
-        if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) != VLC_SUCCESS )
+        if( StreamSeek( p_sys, i_initial_pos ) != VLC_SUCCESS )
             msg_Err( p_demux, "Can't seek back to %" PRIu64, i_initial_pos );
         return VLC_EGENERIC;
     }
@@ -2137,7 +2104,7 @@ static int ProbeChunk( demux_t *p_demux, int i_program, bool b_end, bool *pb_fou
                         if( b_end )
                         {
                             p_pmt->i_last_dts = FROM_SCALE(i_pcr);
-                            p_pmt->i_last_dts_byte = vlc_stream_Tell( p_sys->stream );
+                            p_pmt->i_last_dts_byte = StreamTell( p_sys );
                         }
                         /* Start, only keep first */
                         else if( b_pcrresult && p_pmt->pcr.i_first == VLC_TICK_INVALID )
@@ -2165,7 +2132,7 @@ static int ProbeChunk( demux_t *p_demux, int i_program, bool b_end, bool *pb_fou
 int ProbeStart( demux_t *p_demux, int i_program )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = StreamTell( p_sys );
     uint64_t i_stream_size;
     if( vlc_stream_GetSize( p_sys->stream, &i_stream_size ) != VLC_SUCCESS )
       return VLC_EGENERIC;
@@ -2183,7 +2150,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
         if( i_pos > i_stream_size - p_sys->i_packet_size )
           break;
 
-        if( vlc_stream_Seek( p_sys->stream, i_pos ) )
+        if( StreamSeek( p_sys, i_pos ) )
             return VLC_EGENERIC;
 
         int i_count =  ProbeChunk( p_demux, i_program, false, &b_found );
@@ -2195,7 +2162,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
     } while( i_pos < i_stream_size && !b_found &&
              i_probe_count < PROBE_MAX );
 
-    if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) )
+    if( StreamSeek( p_sys, i_initial_pos ) )
         return VLC_EGENERIC;
 
     return (b_found) ? VLC_SUCCESS : VLC_EGENERIC;
@@ -2204,7 +2171,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
 int ProbeEnd( demux_t *p_demux, int i_program )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = StreamTell( p_sys );
     uint64_t i_stream_size;
     if( vlc_stream_GetSize( p_sys->stream, &i_stream_size ) != VLC_SUCCESS )
       return VLC_EGENERIC;
@@ -2226,7 +2193,7 @@ int ProbeEnd( demux_t *p_demux, int i_program )
         if( i_pos % p_sys->i_packet_size != i_sync_align_offset )
             i_pos = i_pos - (i_pos % p_sys->i_packet_size) + i_sync_align_offset;
 
-        if( vlc_stream_Seek( p_sys->stream, i_pos ) )
+        if( StreamSeek( p_sys, i_pos ) )
             return VLC_EGENERIC;
 
         int i_count = ProbeChunk( p_demux, i_program, true, &b_found );
@@ -2238,7 +2205,7 @@ int ProbeEnd( demux_t *p_demux, int i_program )
     } while( i_pos > 0 && !b_found &&
              i_probe_count < PROBE_MAX );
 
-    if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) )
+    if( StreamSeek( p_sys, i_initial_pos ) )
         return VLC_EGENERIC;
 
     return (b_found) ? VLC_SUCCESS : VLC_EGENERIC;
@@ -2294,7 +2261,7 @@ static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_pmt, vlc_tick_t i_pcr )
         es_out_Control( p_demux->out, ES_OUT_SET_GROUP_PCR, p_pmt->i_number, i_pcr );
         /* growing files/named fifo handling */
         if( p_sys->b_access_control == false &&
-            vlc_stream_Tell( p_sys->stream ) > p_pmt->i_last_dts_byte )
+            StreamTell( p_sys ) > p_pmt->i_last_dts_byte )
         {
             if( p_pmt->i_last_dts_byte == 0 ) /* first run */
             {
@@ -2304,7 +2271,7 @@ static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_pmt, vlc_tick_t i_pcr )
             else
             {
                 p_pmt->i_last_dts = i_pcr;
-                p_pmt->i_last_dts_byte = vlc_stream_Tell( p_sys->stream );
+                p_pmt->i_last_dts_byte = StreamTell( p_sys );
             }
         }
     }
@@ -2668,8 +2635,18 @@ static bool GatherPESData( demux_t *p_demux, ts_pid_t *p_pid, block_t *p_pkt, si
                                  .pf_parse = PESDataChainHandle };
     const bool b_unit_start = p_pkt->p_buffer[1]&0x40;
 
-    p_pkt->p_buffer += i_skip; /* point to PES */
-    p_pkt->i_buffer -= i_skip;
+    /* Packets are views on the input buffer, gathered payloads
+     * need their own storage */
+    block_t *p_payload = block_Alloc( p_pkt->i_buffer - i_skip );
+    if( unlikely(!p_payload) )
+    {
+        block_Release( p_pkt );
+        return false;
+    }
+    memcpy( p_payload->p_buffer, &p_pkt->p_buffer[i_skip], p_payload->i_buffer );
+    p_payload->i_flags = p_pkt->i_flags;
+    block_Release( p_pkt );
+    p_pkt = p_payload;
 
     const ts_es_t *p_es = p_pid->u.p_stream->p_es;
     ts_90khz_t i_append_pcr = ( p_es && p_es->p_program && p_es->p_program->pcr.i_current != VLC_TICK_INVALID )
@@ -21,6 +21,9 @@
 #define VLC_TS_H
 
 #include <vlc_arrays.h>
+#include <vlc_block.h>
+
+#include "ts_packets.h"
 
 #ifdef HAVE_ARIBB24
     typedef struct arib_instance_t arib_instance_t;
@@ -66,6 +69,9 @@ struct demux_sys_t
     /* how many TS packet we read at once */
     unsigned    i_ts_read;
 
+    /* Batched packets input, buffered ahead of p_sys->stream position */
+    ts_packets_t packets;
+
     bool        b_cc_check;
     bool        b_ignore_time_for_positions;
 
@@ -0,0 +1,143 @@
+/*****************************************************************************
+ * ts_packets.c: Transport Stream packets batched input
+ *****************************************************************************
+ * Copyright (C) 2004-2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_stream.h>
+
+#include "ts_packets.h"
+
+static void ViewRelease( block_t *p_block )
+{
+    /* Storage belongs to the reader */
+    VLC_UNUSED(p_block);
+}
+
+static const struct vlc_block_callbacks view_cbs =
+{
+    ViewRelease,
+};
+
+int ts_packets_Init( ts_packets_t *p, unsigned i_packet_size, unsigned i_header_size )
+{
+    p->i_packet_size = i_packet_size;
+    p->i_header_size = i_header_size;
+    p->i_size = (size_t) i_packet_size * TS_PACKETS_ALIGNED_UNIT * TS_PACKETS_BATCH_UNITS;
+    p->p_buffer = malloc( p->i_size );
+    ts_packets_Flush( p );
+    return p->p_buffer ? VLC_SUCCESS : VLC_ENOMEM;
+}
+
+void ts_packets_Clean( ts_packets_t *p )
+{
+    free( p->p_buffer );
+}
+
+/* Moves the leftovers to the front and reads until i_min bytes are buffered.
+ * Partial reads return what the access has, so that live streams do not wait
+ * for a whole batch. */
+static bool Fill( ts_packets_t *p, stream_t *s, size_t i_min )
+{
+    const size_t i_avail = ts_packets_Buffered( p );
+    if( p->i_offset > 0 )
+    {
+        memmove( p->p_buffer, &p->p_buffer[p->i_offset], i_avail );
+        p->i_offset = 0;
+        p->i_length = i_avail;
+    }
+
+    while( p->i_length < i_min )
+    {
+        ssize_t i_read = vlc_stream_ReadPartial( s, &p->p_buffer[p->i_length],
+                                                 p->i_size - p->i_length );
+        if( i_read <= 0 )
+            return false;
+        p->i_length += i_read;
+    }
+    return true;
+}
+
+static uint64_t Tell( const ts_packets_t *p, stream_t *s )
+{
+    return vlc_stream_Tell( s ) - ts_packets_Buffered( p );
+}
+
+static bool Resync( ts_packets_t *p, vlc_object_t *p_obj, stream_t *s )
+{
+    /* Distance between two sync bytes, checked for a valid position */
+    const size_t i_span = p->i_header_size + p->i_packet_size;
+
+    msg_Warn( p_obj, "lost synchro at %" PRIu64, Tell( p, s ) );
+
+    for( ;; )
+    {
+        if( ts_packets_Buffered( p ) <= i_span && !Fill( p, s, i_span + 1 ) )
+        {
+            msg_Dbg( p_obj, "eof ?" );
+            return false;
+        }
+
+        const uint8_t *p_peek = &p->p_buffer[p->i_offset];
+        const size_t i_peek = ts_packets_Buffered( p );
+        size_t i_skip = 0;
+
+        while( i_skip + i_span < i_peek )
+        {
+            if( p_peek[i_skip + p->i_header_size] == 0x47 &&
+                p_peek[i_skip + i_span] == 0x47 )
+                break;
+            i_skip++;
+        }
+        msg_Dbg( p_obj, "skipping %zu bytes of garbage at %" PRIu64,
+                 i_skip, Tell( p, s ) );
+        p->i_offset += i_skip;
+
+        if( i_skip + i_span < i_peek )
+            break;
+    }
+    msg_Dbg( p_obj, "resynced at %" PRIu64, Tell( p, s ) );
+
+    return true;
+}
+
+block_t * ts_packets_Read( ts_packets_t *p, vlc_object_t *p_obj, stream_t *s )
+{
+    if( ts_packets_Buffered( p ) < p->i_packet_size &&
+        !Fill( p, s, p->i_packet_size ) )
+        return NULL; /* truncated last packet is dropped */
+
+    /* Check sync byte and re-sync if needed */
+    if( p->p_buffer[p->i_offset + p->i_header_size] != 0x47 &&
+        !Resync( p, p_obj, s ) )
+        return NULL;
+
+    /* Skip header (BluRay streams).
+     * re-sync logic would do this (by adjusting packet start), but this would result in losing first and last ts packets.
+     * First packet is usually PAT, and losing it means losing whole first GOP. This is fatal with still-image based menus.
+     */
+    uint8_t *p_pkt = &p->p_buffer[p->i_offset + p->i_header_size];
+    p->i_offset += p->i_packet_size;
+
+    return block_Init( &p->view, &view_cbs, p_pkt,
+                       p->i_packet_size - p->i_header_size );
+}
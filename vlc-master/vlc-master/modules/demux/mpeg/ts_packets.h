@@ -0,0 +1,62 @@
+/*****************************************************************************
+ * ts_packets.h: Transport Stream packets batched input
+ *****************************************************************************
+ * Copyright (C) 2004-2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_TS_PACKETS_H
+#define VLC_TS_PACKETS_H
+
+/* Packets are read by aligned units of 32 packets (6144 bytes BluRay
+ * clusters for 192 bytes packets) */
+#define TS_PACKETS_ALIGNED_UNIT  32
+#define TS_PACKETS_BATCH_UNITS    4
+
+/* Reads the stream by large chunks and walks the packets in place.
+ * Packets are returned as views on the chunk: their block_t is owned by
+ * the reader and is only valid until the next read. Anything kept longer
+ * (PES payload gathering) has to be copied out. */
+typedef struct
+{
+    uint8_t *p_buffer;
+    size_t   i_size;        /* buffer capacity */
+    size_t   i_offset;      /* next packet start */
+    size_t   i_length;      /* valid bytes */
+    unsigned i_packet_size; /* 188, 192 or 204 */
+    unsigned i_header_size; /* bytes before sync byte (BluRay) */
+    block_t  view;
+} ts_packets_t;
+
+int  ts_packets_Init( ts_packets_t *, unsigned i_packet_size, unsigned i_header_size );
+void ts_packets_Clean( ts_packets_t * );
+
+/* Drops buffered data, to be called on any seek of the underlying stream */
+static inline void ts_packets_Flush( ts_packets_t *p )
+{
+    p->i_offset = p->i_length = 0;
+}
+
+/* Bytes read from the stream but not returned yet */
+static inline size_t ts_packets_Buffered( const ts_packets_t *p )
+{
+    return p->i_length - p->i_offset;
+}
+
+/* Returns the next packet, header skipped, resyncing on the sync byte
+ * if needed, or NULL on end of stream */
+block_t * ts_packets_Read( ts_packets_t *, vlc_object_t *, stream_t * );
+
+#endif
@@ -123,6 +123,7 @@ typedef struct
     vlc_tick_t i_stop;
 
     char    *psz_text;
+    uint64_t i_offset; /* text position in the stream, if indexed */
 } subtitle_t;
 
 typedef struct
@@ -163,6 +164,7 @@ typedef struct
     bool        b_slave;
     bool        b_first_time;
     bool        b_sorted;
+    bool        b_indexed; /* cue text is read on demand */
 
     double      f_rate;
     vlc_tick_t  i_next_demux_date;
@@ -240,6 +242,8 @@ static int Control( demux_t *, int, va_list );
 
 static void Fix( demux_t * );
 static char * get_language_from_filename( const char * );
+static int  IndexSubRip( stream_t *, subtitle_t * );
+static char *LoadSubRipText( stream_t *, uint64_t );
 
 /*****************************************************************************
  * Decoder format output function
@@ -320,6 +324,7 @@ static int Open ( vlc_object_t *p_this )
     p_sys->b_slave = false;
     p_sys->b_first_time = true;
     p_sys->b_sorted = false;
+    p_sys->b_indexed = false;
     p_sys->i_next_demux_date = 0;
     p_sys->f_rate = 1.0;
 
@@ -646,9 +651,20 @@ static int Open ( vlc_object_t *p_this )
         return VLC_EGENERIC;
     }
 
+    /* SubRip cues are indexed in one pass, and their text is read when
+     * they are sent. Other formats are loaded as a whole. */
+    if( p_sys->props.i_type == SUB_TYPE_SUBRIP )
+    {
+        bool b_can_seek;
+        if( vlc_stream_Control( p_demux->s, STREAM_CAN_SEEK,
+                                &b_can_seek ) == VLC_SUCCESS && b_can_seek )
+            p_sys->b_indexed = true;
+    }
+
     /* Load the whole file */
     text_t txtlines;
-    TextLoad( &txtlines, p_demux->s );
+    if( !p_sys->b_indexed )
+        TextLoad( &txtlines, p_demux->s );
 
     /* Parse it */
     for( size_t i_max = 0; i_max < SIZE_MAX - 500 * sizeof(subtitle_t); )
@@ -659,24 +675,32 @@ static int Open ( vlc_object_t *p_this )
             subtitle_t *p_realloc = realloc( p_sys->subtitles.p_array, sizeof(subtitle_t) * i_max );
             if( p_realloc == NULL )
             {
-                TextUnload( &txtlines );
+                if( !p_sys->b_indexed )
+                    TextUnload( &txtlines );
                 Close( p_this );
                 return VLC_ENOMEM;
             }
             p_sys->subtitles.p_array = p_realloc;
         }
 
-        if( pf_read( VLC_OBJECT(p_demux), &p_sys->props, &txtlines,
-                     &p_sys->subtitles.p_array[p_sys->subtitles.i_count],
-                     p_sys->subtitles.i_count ) )
+        subtitle_t *p_subtitle = &p_sys->subtitles.p_array[p_sys->subtitles.i_count];
+        if( p_sys->b_indexed )
+        {
+            if( IndexSubRip( p_demux->s, p_subtitle ) )
+                break;
+        }
+        else if( pf_read( VLC_OBJECT(p_demux), &p_sys->props, &txtlines,
+                          p_subtitle, p_sys->subtitles.i_count ) )
             break;
 
         p_sys->subtitles.i_count++;
     }
     /* Unload */
-    TextUnload( &txtlines );
+    if( !p_sys->b_indexed )
+        TextUnload( &txtlines );
 
-    msg_Dbg(p_demux, "loaded %zu subtitles", p_sys->subtitles.i_count );
+    msg_Dbg(p_demux, "%s %zu subtitles", p_sys->b_indexed ? "indexed" : "loaded",
+            p_sys->subtitles.i_count );
 
     /* *** add subtitle ES *** */
     if( p_sys->props.i_type == SUB_TYPE_SSA1 ||
@@ -753,17 +777,37 @@ static void Close( vlc_object_t *p_this )
     free( p_sys );
 }
 
+/* Returns the last subtitle starting at or before the date, or the first one
+ * if none does. The array must be sorted. */
+static size_t subtitle_FindIndex( const subtitle_t *p_array, size_t i_count,
+                                  vlc_tick_t i_date, double f_rate )
+{
+    size_t i_low = 0, i_high = i_count;
+
+    /* Count the subtitles starting at or before the date */
+    while( i_low < i_high )
+    {
+        size_t i_mid = i_low + (i_high - i_low) / 2;
+        if( p_array[i_mid].i_start * f_rate > i_date )
+            i_high = i_mid;
+        else
+            i_low = i_mid + 1;
+    }
+    return i_low > 0 ? i_low - 1 : 0;
+}
+
 static void
 ResetCurrentIndex( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    for( size_t i = 0; i < p_sys->subtitles.i_count; i++ )
-    {
-        if( p_sys->subtitles.p_array[i].i_start * p_sys->f_rate >
-            p_sys->i_next_demux_date && i > 0 )
-            break;
-        p_sys->subtitles.i_current = i;
-    }
+
+    if( p_sys->subtitles.i_count == 0 )
+        return;
+
+    Fix( p_demux );
+    p_sys->subtitles.i_current =
+        subtitle_FindIndex( p_sys->subtitles.p_array, p_sys->subtitles.i_count,
+                            p_sys->i_next_demux_date, p_sys->f_rate );
 }
 
 /*****************************************************************************
@@ -869,7 +913,7 @@ static int Demux( demux_t *p_demux )
            ( p_sys->subtitles.p_array[p_sys->subtitles.i_current].i_start *
              p_sys->f_rate ) <= i_barrier )
     {
-        const subtitle_t *p_subtitle = &p_sys->subtitles.p_array[p_sys->subtitles.i_current];
+        subtitle_t *p_subtitle = &p_sys->subtitles.p_array[p_sys->subtitles.i_current];
 
         if ( !p_sys->b_slave && p_sys->b_first_time )
         {
@@ -879,7 +923,17 @@ static int Demux( demux_t *p_demux )
 
         if( p_subtitle->i_start >= 0 )
         {
+            if( p_sys->b_indexed )
+                p_subtitle->psz_text = LoadSubRipText( p_demux->s,
+                                                       p_subtitle->i_offset );
+
             block_t *p_block = p_sys->pf_convert( p_subtitle );
+
+            if( p_sys->b_indexed )
+            {   /* Read again if the cue is sent again after a seek */
+                free( p_subtitle->psz_text );
+                p_subtitle->psz_text = NULL;
+            }
             if( p_block )
             {
                 p_block->i_dts =
@@ -1052,6 +1106,21 @@ static int ParseMicroDvd( vlc_object_t *p_obj, subs_properties_t *p_props,
     return VLC_SUCCESS;
 }
 
+/* Appends a line and a line feed to the cue text */
+static char *SubtitleAppendLine( char *psz_text, size_t *pi_old,
+                                 const char *s, size_t i_len )
+{
+    psz_text = realloc_or_free( psz_text, *pi_old + i_len + 1 + 1 );
+    if( !psz_text )
+        return NULL;
+
+    memcpy( &psz_text[*pi_old], s, i_len );
+    psz_text[*pi_old + i_len + 0] = '\n';
+    psz_text[*pi_old + i_len + 1] = '\0';
+    *pi_old += i_len + 1;
+    return psz_text;
+}
+
 /* ParseSubRipSubViewer
  *  Format SubRip
  *      n
@@ -1106,15 +1175,10 @@ static int ParseSubRipSubViewer( vlc_object_t *p_obj, subs_properties_t *p_props
             return VLC_SUCCESS;
         }
 
-        psz_text = realloc_or_free( psz_text, i_old + i_len + 1 + 1 );
+        psz_text = SubtitleAppendLine( psz_text, &i_old, s, i_len );
         if( !psz_text )
             return VLC_ENOMEM;
 
-        memcpy( &psz_text[i_old], s, i_len );
-        psz_text[i_old + i_len + 0] = '\n';
-        psz_text[i_old + i_len + 1] = '\0';
-        i_old += i_len + 1;
-
         /* replace [br] by \n */
         if( b_replace_br )
         {
@@ -1200,6 +1264,61 @@ static int  ParseSubRip( vlc_object_t *p_obj, subs_properties_t *p_props,
                                  false );
 }
 
+/* IndexSubRip
+ *  Same as ParseSubRip, but only keeps the position of the text in the
+ *  stream. The text is read by LoadSubRipText when the cue is sent.
+ */
+static int IndexSubRip( stream_t *s, subtitle_t *p_subtitle )
+{
+    for( ;; )
+    {
+        char *psz = vlc_stream_ReadLine( s );
+
+        if( !psz )
+            return VLC_EGENERIC;
+
+        int i_ret = subtitle_ParseSubRipTiming( p_subtitle, psz );
+        free( psz );
+        if( i_ret == VLC_SUCCESS && p_subtitle->i_start < p_subtitle->i_stop )
+            break;
+    }
+
+    p_subtitle->psz_text = NULL;
+    p_subtitle->i_offset = vlc_stream_Tell( s );
+
+    /* Skip the text until an empty line */
+    for( ;; )
+    {
+        char *psz = vlc_stream_ReadLine( s );
+        bool b_end = psz == NULL || *psz == '\0';
+
+        free( psz );
+        if( b_end )
+            return VLC_SUCCESS;
+    }
+}
+
+static char *LoadSubRipText( stream_t *s, uint64_t i_offset )
+{
+    if( vlc_stream_Seek( s, i_offset ) )
+        return NULL;
+
+    /* Read text until an empty line */
+    char *psz_text = NULL;
+    size_t i_old = 0;
+    for( ;; )
+    {
+        char *psz = vlc_stream_ReadLine( s );
+        size_t i_len = psz ? strlen( psz ) : 0;
+
+        if( i_len > 0 )
+            psz_text = SubtitleAppendLine( psz_text, &i_old, psz, i_len );
+        free( psz );
+        if( i_len == 0 || !psz_text )
+            return psz_text;
+    }
+}
+
 /* subtitle_ParseSubViewerTiming
  * Parses SubViewer timing.
  */
@@ -2675,11 +2794,55 @@ static void test_subtitle_ParseSubRipTiming(void)
     }
 }
 
+static void test_subtitle_FindIndex(void)
+{
+    fprintf(stderr, "\n# %s:\n", __func__);
+
+    static const subtitle_t subs[] =
+    {
+        { .i_start = VLC_TICK_FROM_SEC(1) },
+        { .i_start = VLC_TICK_FROM_SEC(2) },
+        { .i_start = VLC_TICK_FROM_SEC(2) },
+        { .i_start = VLC_TICK_FROM_SEC(5) },
+    };
+
+    struct test_find
+    {
+        vlc_tick_t date;
+        double rate;
+        size_t index;
+    };
+
+    static const struct test_find finds[] =
+    {
+        { 0,                        1.0, 0 },
+        { VLC_TICK_FROM_SEC(1),     1.0, 0 },
+        { VLC_TICK_FROM_MS(1500),   1.0, 0 },
+        { VLC_TICK_FROM_SEC(2),     1.0, 2 },
+        { VLC_TICK_FROM_SEC(4),     1.0, 2 },
+        { VLC_TICK_FROM_SEC(60),    1.0, 3 },
+        { VLC_TICK_FROM_SEC(4),     2.0, 2 },
+        { VLC_TICK_FROM_SEC(4),     0.5, 3 },
+    };
+
+    for (size_t i=0; i<ARRAY_SIZE(finds); ++i)
+    {
+        size_t index = subtitle_FindIndex(subs, ARRAY_SIZE(subs),
+                                          finds[i].date, finds[i].rate);
+        fprintf(stderr, "Checking %" PRId64 " at rate %f -> %zu\n",
+                finds[i].date, finds[i].rate, index);
+        assert(index == finds[i].index);
+    }
+
+    assert(subtitle_FindIndex(subs, 0, VLC_TICK_FROM_SEC(1), 1.0) == 0);
+}
+
 int main(int argc, char **argv)
 {
     (void)argc; (void)argv;
     test_subtitle_ParseSubRipTimingValue();
     test_subtitle_ParseSubRipTiming();
+    test_subtitle_FindIndex();
 
     return 0;
 }
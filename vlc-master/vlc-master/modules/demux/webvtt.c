@@ -308,12 +308,17 @@ static int index_Compare( const void *a_, const void *b_ )
 
 static size_t getIndexByTime( demux_sys_t *p_sys, vlc_tick_t i_time )
 {
-    for( size_t i=0; i<p_sys->index.i_count; i++ )
+    /* First entry at or after the time, the index is sorted */
+    size_t i_low = 0, i_high = p_sys->index.i_count;
+    while( i_low < i_high )
     {
-        if( p_sys->index.p_array[i].time >= i_time )
-            return i;
+        size_t i_mid = i_low + (i_high - i_low) / 2;
+        if( p_sys->index.p_array[i_mid].time >= i_time )
+            i_high = i_mid;
+        else
+            i_low = i_mid + 1;
     }
-    return 0;
+    return i_low < p_sys->index.i_count ? i_low : 0;
 }
 
 static void BuildIndex( demux_t *p_demux )
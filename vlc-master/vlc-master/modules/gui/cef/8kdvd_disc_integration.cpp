@@ -1,9 +1,12 @@
 #include "8kdvd_disc_integration.h"
 #include "html5_menu_system.h"
 #include "menu_navigation.h"
+#include "chapter_thumbnailer.h"
+#include "xml_parser.h"
 #include <vlc_messages.h>
 #include <vlc_input.h>
 #include <vlc_playlist.h>
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <sstream>
@@ -13,6 +16,7 @@ struct kdvd_disc_integration_t {
     vlc_object_t *obj;
     html5_menu_system_t *menu_system;
     menu_navigation_t *navigation;
+    chapter_thumbnailer_t *thumbnailer;
     kdvd_disc_info_t disc_info;
     std::vector<kdvd_title_info_t> titles;
     bool vlc_integration_enabled;
@@ -29,6 +33,7 @@ kdvd_disc_integration_t* kdvd_disc_integration_create(vlc_object_t *obj) {
     integration->obj = obj;
     integration->menu_system = html5_menu_system_create(obj);
     integration->navigation = menu_navigation_create(obj);
+    integration->thumbnailer = chapter_thumbnailer_create(obj, nullptr);
     integration->vlc_integration_enabled = true;
     integration->debug_output_enabled = false;
     integration->disc_loaded = false;
@@ -67,6 +72,10 @@ void kdvd_disc_integration_destroy(kdvd_disc_integration_t *integration) {
         menu_navigation_destroy(integration->navigation);
     }
     
+    if (integration->thumbnailer) {
+        chapter_thumbnailer_destroy(integration->thumbnailer);
+    }
+    
     integration->titles.clear();
     delete integration;
     msg_Info(integration->obj, "8KDVD disc integration destroyed");
@@ -127,6 +136,11 @@ int kdvd_disc_integration_load_disc(kdvd_disc_integration_t *integration, const
     integration->disc_loaded = true;
     integration->disc_info.disc_path = disc_path;
     
+    // Mouse input follows the menu being navigated, and the chapter menu
+    // loads its generated thumbnails from the thumbnailer cache
+    html5_menu_system_set_menu_navigation(integration->menu_system, integration->navigation);
+    html5_menu_system_set_chapter_thumbnailer(integration->menu_system, integration->thumbnailer);
+    
     msg_Info(integration->obj, "8KDVD disc loaded successfully: %s", disc_path);
     return 0;
 }
@@ -140,6 +154,8 @@ int kdvd_disc_integration_unload_disc(kdvd_disc_integration_t *integration) {
     }
     
     if (integration->menu_system) {
+        html5_menu_system_set_menu_navigation(integration->menu_system, nullptr);
+        html5_menu_system_set_chapter_thumbnailer(integration->menu_system, nullptr);
         html5_menu_system_hide_menu(integration->menu_system);
     }
     
@@ -241,6 +257,20 @@ int kdvd_disc_integration_resume_playback(kdvd_disc_integration_t *integration)
     return 0;
 }
 
+// Navigate the items of the menu as it is laid out on screen
+static void kdvd_disc_integration_set_navigation_menu(kdvd_disc_integration_t *integration, const char *menu_id) {
+    if (!integration->navigation) return;
+    
+    const menu_t *menu = html5_menu_system_get_menu(integration->menu_system, menu_id);
+    if (menu) {
+        menu_navigation_set_menu_size(integration->navigation, menu->width, menu->height);
+        menu_navigation_set_menu_items(integration->navigation, menu_id,
+                                       menu->items.data(), (int)menu->items.size());
+    } else {
+        menu_navigation_set_menu(integration->navigation, menu_id, 0);
+    }
+}
+
 int kdvd_disc_integration_load_main_menu(kdvd_disc_integration_t *integration) {
     if (!integration) return -1;
     
@@ -252,9 +282,7 @@ int kdvd_disc_integration_load_main_menu(kdvd_disc_integration_t *integration) {
         html5_menu_system_show_menu(integration->menu_system, "8kdvd_main");
         
         // Set up navigation
-        if (integration->navigation) {
-            menu_navigation_set_menu(integration->navigation, "8kdvd_main", 3); // 3 main menu items
-        }
+        kdvd_disc_integration_set_navigation_menu(integration, "8kdvd_main");
         
         msg_Info(integration->obj, "8KDVD main menu loaded");
     }
@@ -273,9 +301,7 @@ int kdvd_disc_integration_load_settings_menu(kdvd_disc_integration_t *integratio
         html5_menu_system_show_menu(integration->menu_system, "8kdvd_settings");
         
         // Set up navigation
-        if (integration->navigation) {
-            menu_navigation_set_menu(integration->navigation, "8kdvd_settings", 3); // 3 settings items
-        }
+        kdvd_disc_integration_set_navigation_menu(integration, "8kdvd_settings");
         
         msg_Info(integration->obj, "8KDVD settings menu loaded");
     }
@@ -294,9 +320,7 @@ int kdvd_disc_integration_load_about_menu(kdvd_disc_integration_t *integration)
         html5_menu_system_show_menu(integration->menu_system, "8kdvd_about");
         
         // Set up navigation
-        if (integration->navigation) {
-            menu_navigation_set_menu(integration->navigation, "8kdvd_about", 2); // 2 about items
-        }
+        kdvd_disc_integration_set_navigation_menu(integration, "8kdvd_about");
         
         msg_Info(integration->obj, "8KDVD about menu loaded");
     }
@@ -304,6 +328,10 @@ int kdvd_disc_integration_load_about_menu(kdvd_disc_integration_t *integration)
     return 0;
 }
 
+chapter_thumbnailer_t* kdvd_disc_integration_get_chapter_thumbnailer(kdvd_disc_integration_t *integration) {
+    return integration ? integration->thumbnailer : nullptr;
+}
+
 void kdvd_disc_integration_set_vlc_integration(kdvd_disc_integration_t *integration, bool enable) {
     if (integration) {
         integration->vlc_integration_enabled = enable;
@@ -342,6 +370,59 @@ int kdvd_disc_integration_validate_disc(kdvd_disc_integration_t *integration, co
     return 0;
 }
 
+static void kdvd_disc_integration_hash(uint64_t *hash, const void *data, size_t size) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < size; i++) {
+        *hash ^= bytes[i];
+        *hash *= UINT64_C(0x100000001b3);
+    }
+}
+
+std::string kdvd_disc_integration_compute_disc_id(const char *disc_path) {
+    // Stable across mounts and sessions, so per-disc caches (chapter
+    // thumbnails) survive a reinsert: FNV-1a over what each disc authors,
+    // not over the menu templates shared by discs. That is the index and
+    // certificate contents, then the name and size of every file.
+    static const char *const id_files[] = {
+        "8KDVD_TS/index.xml",
+        "8KDVD_TS/certificate.pem",
+    };
+    uint64_t hash = UINT64_C(0xcbf29ce484222325);
+    
+    for (const char *file : id_files) {
+        std::ifstream stream(std::string(disc_path) + "/" + file, std::ios::binary);
+        char buffer[4096];
+        while (stream.read(buffer, sizeof(buffer)) || stream.gcount() > 0) {
+            kdvd_disc_integration_hash(&hash, buffer, stream.gcount());
+        }
+    }
+    
+    // Content payloads are too large to read, their sizes tell them apart.
+    // Sorted, as the directory order depends on the file system.
+    std::vector<std::pair<std::string, uint64_t>> files;
+    std::error_code ec;
+    const std::filesystem::path root(disc_path);
+    for (std::filesystem::recursive_directory_iterator it(root, ec), end;
+         !ec && it != end; it.increment(ec)) {
+        std::error_code size_ec;
+        if (!it->is_regular_file(size_ec)) continue;
+        uint64_t size = it->file_size(size_ec);
+        if (size_ec) continue;
+        files.emplace_back(it->path().lexically_relative(root).generic_string(), size);
+    }
+    std::sort(files.begin(), files.end());
+    for (const auto &file : files) {
+        kdvd_disc_integration_hash(&hash, file.first.c_str(), file.first.size() + 1);
+        uint8_t size[8];
+        SetQWBE(size, file.second);
+        kdvd_disc_integration_hash(&hash, size, sizeof(size));
+    }
+    
+    char id[32];
+    snprintf(id, sizeof(id), "8KDVD_%016" PRIx64, hash);
+    return id;
+}
+
 int kdvd_disc_integration_extract_metadata(kdvd_disc_integration_t *integration, const char *disc_path) {
     if (!integration || !disc_path) return -1;
     
@@ -349,7 +430,7 @@ int kdvd_disc_integration_extract_metadata(kdvd_disc_integration_t *integration,
     
     // Extract basic disc information
     integration->disc_info.disc_path = disc_path;
-    integration->disc_info.disc_id = "8KDVD_" + std::to_string(time(nullptr));
+    integration->disc_info.disc_id = kdvd_disc_integration_compute_disc_id(disc_path);
     integration->disc_info.title = "8KDVD Disc";
     integration->disc_info.version = "1.0";
     integration->disc_info.region = "ALL";
@@ -364,6 +445,37 @@ int kdvd_disc_integration_extract_metadata(kdvd_disc_integration_t *integration,
     main_title.playable = true;
     integration->titles.push_back(main_title);
     
+    // Chapter thumbnails are cached per disc, generated from the title payloads
+    if (integration->thumbnailer &&
+        chapter_thumbnailer_set_disc(integration->thumbnailer,
+                                     integration->disc_info.disc_id.c_str()) == 0) {
+        std::string mrl = std::string("8kdvd-disc://") + disc_path;
+        for (const auto &title : integration->titles) {
+            chapter_thumbnailer_set_title_mrl(integration->thumbnailer, title.title_id, mrl.c_str());
+        }
+        
+        // Start on the chapters without an authored thumbnail, in the
+        // background, so the chapter menu finds most of them cached
+        xml_parser_t *parser = xml_parser_create(integration->obj);
+        if (parser) {
+            std::string index_xml = std::string(disc_path) + "/8KDVD_TS/index.xml";
+            if (std::filesystem::exists(index_xml) &&
+                xml_parser_parse_chapters(parser, index_xml.c_str()) == 0) {
+                std::vector<chapter_info_t> chapters;
+                for (const auto &chapter : xml_parser_get_chapters(parser)) {
+                    if (chapter.thumbnail.empty()) {
+                        chapters.push_back(chapter);
+                    }
+                }
+                int queued = chapter_thumbnailer_generate(integration->thumbnailer, chapters);
+                if (queued > 0) {
+                    msg_Dbg(integration->obj, "8KDVD: %d chapter thumbnails queued", queued);
+                }
+            }
+            xml_parser_destroy(parser);
+        }
+    }
+    
     msg_Info(integration->obj, "8KDVD metadata extracted successfully");
     return 0;
 }
@@ -65,6 +65,9 @@ int kdvd_disc_integration_load_main_menu(kdvd_disc_integration_t *integration);
 int kdvd_disc_integration_load_settings_menu(kdvd_disc_integration_t *integration);
 int kdvd_disc_integration_load_about_menu(kdvd_disc_integration_t *integration);
 
+// Chapter thumbnails (shared with the CEF resource handler)
+struct chapter_thumbnailer_t* kdvd_disc_integration_get_chapter_thumbnailer(kdvd_disc_integration_t *integration);
+
 // VLC Integration
 void kdvd_disc_integration_set_vlc_integration(kdvd_disc_integration_t *integration, bool enable);
 void kdvd_disc_integration_set_debug_output(kdvd_disc_integration_t *integration, bool enable);
@@ -72,6 +75,7 @@ void kdvd_disc_integration_set_debug_output(kdvd_disc_integration_t *integration
 // 8KDVD Specific Functions
 int kdvd_disc_integration_validate_disc(kdvd_disc_integration_t *integration, const char *disc_path);
 int kdvd_disc_integration_extract_metadata(kdvd_disc_integration_t *integration, const char *disc_path);
+std::string kdvd_disc_integration_compute_disc_id(const char *disc_path);
 int kdvd_disc_integration_setup_playback(kdvd_disc_integration_t *integration, int title_id);
 
 #endif // VLC_8KDVD_DISC_INTEGRATION_H
@@ -3,7 +3,9 @@
 #include <vlc_messages.h>
 
 VLCCefClient::VLCCefClient(vlc_object_t *obj) 
-    : vlc_obj_(obj), render_width_(1920), render_height_(1080) {
+    : vlc_obj_(obj), mouse_handler_(new VLCCefMouseHandler(obj)),
+      request_handler_(new VLCCefRequestHandler(obj)),
+      render_width_(1920), render_height_(1080) {
 }
 
 void VLCCefClient::OnTitleChange(CefRefPtr<CefBrowser> browser,
@@ -127,8 +129,13 @@ void VLCCefClient::OnPaint(CefRefPtr<CefBrowser> browser,
 void VLCCefClient::SetRenderSize(int width, int height) {
     render_width_ = width;
     render_height_ = height;
+    mouse_handler_->SetViewSize(width, height);
     
     if (browser_) {
         browser_->GetHost()->WasResized();
     }
 }
+
+void VLCCefClient::SetChapterThumbnailer(chapter_thumbnailer_t *thumbnailer) {
+    request_handler_->SetChapterThumbnailer(thumbnailer);
+}
@@ -7,6 +7,8 @@
 #include "include/cef_load_handler.h"
 #include "include/cef_render_handler.h"
 #include <vlc_common.h>
+#include "cef_mouse_handler.h"
+#include "cef_request_handler.h"
 
 class VLCCefClient : public CefClient,
                      public CefDisplayHandler,
@@ -21,6 +23,8 @@ public:
     CefRefPtr<CefLifeSpanHandler> GetLifeSpanHandler() override { return this; }
     CefRefPtr<CefLoadHandler> GetLoadHandler() override { return this; }
     CefRefPtr<CefRenderHandler> GetRenderHandler() override { return this; }
+    CefRefPtr<CefRequestHandler> GetRequestHandler() override { return request_handler_; }
+    CefRefPtr<VLCCefMouseHandler> GetMouseHandler() { return mouse_handler_; }
     
     // CefDisplayHandler methods
     void OnTitleChange(CefRefPtr<CefBrowser> browser,
@@ -71,12 +75,15 @@ public:
     // Browser management
     CefRefPtr<CefBrowser> GetBrowser() const { return browser_; }
     void SetRenderSize(int width, int height);
+    void SetChapterThumbnailer(chapter_thumbnailer_t *thumbnailer);
     
     IMPLEMENT_REFCOUNTING(VLCCefClient);
     
 private:
     vlc_object_t *vlc_obj_;
     CefRefPtr<CefBrowser> browser_;
+    CefRefPtr<VLCCefMouseHandler> mouse_handler_;
+    CefRefPtr<VLCCefRequestHandler> request_handler_;
     int render_width_;
     int render_height_;
     
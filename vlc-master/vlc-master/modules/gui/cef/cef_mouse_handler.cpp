@@ -4,7 +4,8 @@
 
 VLCCefMouseHandler::VLCCefMouseHandler(vlc_object_t *obj) 
     : vlc_obj_(obj), vlc_integration_enabled_(true), mouse_events_enabled_(true),
-      disc_loaded_(false), mouse_x_(0), mouse_y_(0), mouse_over_menu_(false) {
+      disc_loaded_(false), mouse_x_(0), mouse_y_(0), mouse_over_menu_(false),
+      navigation_(nullptr), hovered_item_(-1), view_width_(1920), view_height_(1080) {
     
     msg_Info(vlc_obj_, "CEF mouse handler created");
 }
@@ -86,7 +87,12 @@ bool VLCCefMouseHandler::Handle8KDVDMouseEvent(const CefMouseEvent& event, Mouse
     // Handle 8KDVD menu interactions
     if (IsMouseOverMenu(event)) {
         if (type == MBT_LEFT && !mouseUp) {
-            msg_Info(vlc_obj_, "8KDVD: Menu item clicked at (%d, %d)", event.x, event.y);
+            int item = navigation_ ? menu_navigation_mouse_click(navigation_, event.x, event.y) : -1;
+            if (item >= 0) {
+                msg_Info(vlc_obj_, "8KDVD: Menu item %d clicked at (%d, %d)", item, event.x, event.y);
+            } else {
+                msg_Info(vlc_obj_, "8KDVD: Menu item clicked at (%d, %d)", event.x, event.y);
+            }
             return true;
         }
     }
@@ -105,6 +111,11 @@ void VLCCefMouseHandler::Handle8KDVDMouseMove(const CefMouseEvent& event) {
         msg_Dbg(vlc_obj_, "8KDVD: Mouse %s menu at (%d, %d)", 
                mouse_over_menu_ ? "entered" : "left", event.x, event.y);
     }
+    
+    // Hovering an item highlights it, as remote navigation would
+    if (navigation_) {
+        hovered_item_ = menu_navigation_mouse_move(navigation_, event.x, event.y);
+    }
 }
 
 void VLCCefMouseHandler::Handle8KDVDMouseWheel(int deltaX, int deltaY) {
@@ -146,6 +157,24 @@ bool VLCCefMouseHandler::IsMouseOver8KDVDMenu() {
     return mouse_over_menu_;
 }
 
+void VLCCefMouseHandler::SetMenuNavigation(menu_navigation_t *navigation) {
+    // A disc menu is on screen as long as its navigation is attached
+    navigation_ = navigation;
+    disc_loaded_ = navigation != nullptr;
+    hovered_item_ = -1;
+    if (navigation_) {
+        menu_navigation_set_view_size(navigation_, view_width_, view_height_);
+    }
+}
+
+void VLCCefMouseHandler::SetViewSize(int width, int height) {
+    view_width_ = width;
+    view_height_ = height;
+    if (navigation_) {
+        menu_navigation_set_view_size(navigation_, width, height);
+    }
+}
+
 bool VLCCefMouseHandler::HandleVLCMouseEvent(const CefMouseEvent& event, MouseButtonType type, bool mouseUp) {
     // Handle VLC-specific mouse events
     if (type == MBT_LEFT && !mouseUp) {
@@ -157,9 +186,12 @@ bool VLCCefMouseHandler::HandleVLCMouseEvent(const CefMouseEvent& event, MouseBu
 }
 
 bool VLCCefMouseHandler::IsMouseOverMenu(const CefMouseEvent& event) {
-    // Check if mouse is over 8KDVD menu area
-    // This would integrate with the actual menu layout
-    return (event.x >= 0 && event.x < 1920 && event.y >= 0 && event.y < 1080);
+    // Check if mouse is over an 8KDVD menu item, through the spatial index
+    // of the current menu layout when there is one
+    if (navigation_) {
+        return menu_navigation_hit_test(navigation_, event.x, event.y) >= 0;
+    }
+    return (event.x >= 0 && event.x < view_width_ && event.y >= 0 && event.y < view_height_);
 }
 
 void VLCCefMouseHandler::UpdateMouseState(const CefMouseEvent& event) {
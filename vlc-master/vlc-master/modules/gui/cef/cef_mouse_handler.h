@@ -6,6 +6,7 @@
 #include "include/cef_mouse_event.h"
 #include <vlc_common.h>
 #include <string>
+#include "menu_navigation.h"
 
 // CEF Mouse Handler for VLC Integration
 class VLCCefMouseHandler : public CefMouseHandler {
@@ -43,6 +44,10 @@ public:
     void GetMousePosition(int& x, int& y);
     bool IsMouseOver8KDVDMenu();
     
+    // Menu layout used for hit testing, and size of the view it is shown in
+    void SetMenuNavigation(menu_navigation_t *navigation);
+    void SetViewSize(int width, int height);
+    
 private:
     vlc_object_t *vlc_obj_;
     bool vlc_integration_enabled_;
@@ -54,6 +59,10 @@ private:
     int mouse_x_;
     int mouse_y_;
     bool mouse_over_menu_;
+    menu_navigation_t *navigation_;
+    int hovered_item_;
+    int view_width_;
+    int view_height_;
     
     // Helper methods
     bool HandleVLCMouseEvent(const CefMouseEvent& event, MouseButtonType type, bool mouseUp);
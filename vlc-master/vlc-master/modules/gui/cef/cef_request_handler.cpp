@@ -1,4 +1,5 @@
 #include "cef_request_handler.h"
+#include "cef_resource_handler.h"
 #include "include/wrapper/cef_helpers.h"
 #include <vlc_messages.h>
 #include <fstream>
@@ -6,7 +7,8 @@
 #include <algorithm>
 
 VLCCefRequestHandler::VLCCefRequestHandler(vlc_object_t *obj) 
-    : vlc_obj_(obj), vlc_integration_enabled_(true), disc_loaded_(false) {
+    : vlc_obj_(obj), vlc_integration_enabled_(true), chapter_thumbnailer_(nullptr),
+      disc_loaded_(false) {
     
     msg_Info(vlc_obj_, "CEF request handler created");
 }
@@ -61,6 +63,14 @@ CefRefPtr<CefResourceHandler> VLCCefRequestHandler::GetResourceHandler(CefRefPtr
     std::string url = request->GetURL().ToString();
     msg_Dbg(vlc_obj_, "CEF resource handler: %s", url.c_str());
     
+    // Generated chapter thumbnails are served from the thumbnailer cache
+    chapter_thumbnailer_t *thumbnailer = chapter_thumbnailer_.load();
+    if (thumbnailer && url.find(CHAPTER_THUMBNAIL_URL_PREFIX) == 0) {
+        CefRefPtr<VLCCefResourceHandler> handler = new VLCCefResourceHandler(vlc_obj_);
+        handler->SetChapterThumbnailer(thumbnailer);
+        return handler;
+    }
+    
     // Handle 8KDVD resources
     if (Is8KDVDResource(url)) {
         return nullptr; // Use default handler for now
@@ -125,6 +135,10 @@ void VLCCefRequestHandler::SetResourceBasePath(const std::string& base_path) {
     msg_Info(vlc_obj_, "Resource base path set: %s", base_path.c_str());
 }
 
+void VLCCefRequestHandler::SetChapterThumbnailer(chapter_thumbnailer_t *thumbnailer) {
+    chapter_thumbnailer_.store(thumbnailer);
+}
+
 bool VLCCefRequestHandler::HandleLocalFileRequest(const std::string& url, CefRefPtr<CefResponse> response) {
     // Handle local file requests
     if (url.find("file://") == 0) {
@@ -7,6 +7,8 @@
 #include "include/cef_request.h"
 #include "include/cef_response.h"
 #include <vlc_common.h>
+#include "chapter_thumbnailer.h"
+#include <atomic>
 #include <string>
 
 // CEF Request Handler for VLC Integration
@@ -45,11 +47,13 @@ public:
     // VLC integration
     void SetVLCIntegration(bool enable);
     void SetResourceBasePath(const std::string& base_path);
+    void SetChapterThumbnailer(chapter_thumbnailer_t *thumbnailer);
     
 private:
     vlc_object_t *vlc_obj_;
     bool vlc_integration_enabled_;
     std::string resource_base_path_;
+    std::atomic<chapter_thumbnailer_t*> chapter_thumbnailer_;
     
     // 8KDVD state
     std::string current_disc_path_;
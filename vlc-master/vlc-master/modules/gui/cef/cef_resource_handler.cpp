@@ -6,7 +6,7 @@
 
 VLCCefResourceHandler::VLCCefResourceHandler(vlc_object_t *obj) 
     : vlc_obj_(obj), vlc_integration_enabled_(true), resource_cache_enabled_(true),
-      disc_loaded_(false), file_size_(0), bytes_read_(0) {
+      chapter_thumbnailer_(nullptr), disc_loaded_(false), file_size_(0), bytes_read_(0) {
     
     msg_Info(vlc_obj_, "CEF resource handler created");
 }
@@ -25,6 +25,18 @@ bool VLCCefResourceHandler::ProcessRequest(CefRefPtr<CefRequest> request,
     
     msg_Dbg(vlc_obj_, "CEF resource request: %s", url.c_str());
     
+    // Handle generated chapter thumbnails
+    if (url.find(CHAPTER_THUMBNAIL_URL_PREFIX) == 0) {
+        std::string thumbnail_path = GetChapterThumbnailPath(url);
+        if (!thumbnail_path.empty() && OpenResourceFile(thumbnail_path)) {
+            callback->Continue();
+            return true;
+        }
+        // Not generated yet: cancel the request, the menu falls back to
+        // its placeholder
+        return false;
+    }
+    
     // Handle 8KDVD resources
     if (Is8KDVDResource(url)) {
         std::string resource_path = Get8KDVDResourcePath(url);
@@ -43,8 +55,7 @@ bool VLCCefResourceHandler::ProcessRequest(CefRefPtr<CefRequest> request,
         }
     }
     
-    // Resource not found
-    callback->Continue();
+    // Resource not found: cancel the request
     return false;
 }
 
@@ -139,6 +150,10 @@ void VLCCefResourceHandler::SetResourceBasePath(const std::string& base_path) {
     msg_Info(vlc_obj_, "Resource base path set: %s", base_path.c_str());
 }
 
+void VLCCefResourceHandler::SetChapterThumbnailer(chapter_thumbnailer_t *thumbnailer) {
+    chapter_thumbnailer_ = thumbnailer;
+}
+
 void VLCCefResourceHandler::SetResourceCacheEnabled(bool enable) {
     resource_cache_enabled_ = enable;
     msg_Info(vlc_obj_, "Resource cache %s", enable ? "enabled" : "disabled");
@@ -177,6 +192,13 @@ bool VLCCefResourceHandler::Handle8KDVDMediaResource(const std::string& url, Cef
     return false;
 }
 
+std::string VLCCefResourceHandler::GetChapterThumbnailPath(const std::string& url) {
+    int title_id, chapter_id;
+    if (!chapter_thumbnailer_ || !chapter_thumbnailer_parse_url(url, &title_id, &chapter_id))
+        return "";
+    return chapter_thumbnailer_get_path(chapter_thumbnailer_, title_id, chapter_id);
+}
+
 std::string VLCCefResourceHandler::GetMimeType(const std::string& filename) {
     // Get MIME type based on file extension
     size_t dot_pos = filename.find_last_of('.');
@@ -190,6 +212,7 @@ std::string VLCCefResourceHandler::GetMimeType(const std::string& filename) {
         if (extension == "json") return "application/json";
         if (extension == "png") return "image/png";
         if (extension == "jpg" || extension == "jpeg") return "image/jpeg";
+        if (extension == "webp") return "image/webp";
         if (extension == "gif") return "image/gif";
         if (extension == "svg") return "image/svg+xml";
         if (extension == "ico") return "image/x-icon";
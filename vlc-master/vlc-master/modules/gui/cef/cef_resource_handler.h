@@ -6,6 +6,7 @@
 #include "include/cef_response.h"
 #include "include/cef_callback.h"
 #include <vlc_common.h>
+#include "chapter_thumbnailer.h"
 #include <string>
 #include <fstream>
 
@@ -38,6 +39,7 @@ public:
     // VLC integration
     void SetVLCIntegration(bool enable);
     void SetResourceBasePath(const std::string& base_path);
+    void SetChapterThumbnailer(chapter_thumbnailer_t *thumbnailer);
     
     // Resource management
     void SetResourceCacheEnabled(bool enable);
@@ -48,6 +50,7 @@ private:
     bool vlc_integration_enabled_;
     std::string resource_base_path_;
     bool resource_cache_enabled_;
+    chapter_thumbnailer_t *chapter_thumbnailer_;
     
     // 8KDVD state
     bool disc_loaded_;
@@ -64,6 +67,7 @@ private:
     bool HandleLocalFileResource(const std::string& url, CefRefPtr<CefResponse> response);
     bool Handle8KDVDMenuResource(const std::string& url, CefRefPtr<CefResponse> response);
     bool Handle8KDVDMediaResource(const std::string& url, CefRefPtr<CefResponse> response);
+    std::string GetChapterThumbnailPath(const std::string& url);
     std::string GetMimeType(const std::string& filename);
     bool OpenResourceFile(const std::string& file_path);
     void CloseResourceFile();
@@ -105,6 +105,20 @@ int cef_wrapper_load_8kdvd_menu(cef_wrapper_t *wrapper, const char *disc_path) {
     return cef_wrapper_load_menu(wrapper, menu_path);
 }
 
+void cef_wrapper_set_menu_navigation(cef_wrapper_t *wrapper, struct menu_navigation_t *navigation) {
+    if (!wrapper || !wrapper->client) return;
+    
+    // Mouse hit testing follows the layout of the menu being navigated
+    wrapper->client->GetMouseHandler()->SetMenuNavigation(navigation);
+}
+
+void cef_wrapper_set_chapter_thumbnailer(cef_wrapper_t *wrapper, struct chapter_thumbnailer_t *thumbnailer) {
+    if (!wrapper || !wrapper->client) return;
+    
+    // Serves the CHAPTER_THUMBNAIL_URL_PREFIX URLs of the chapter menu
+    wrapper->client->SetChapterThumbnailer(thumbnailer);
+}
+
 // Browser navigation functions
 int cef_wrapper_navigate_back(cef_wrapper_t *wrapper) {
     if (!wrapper || !wrapper->browser) return -1;
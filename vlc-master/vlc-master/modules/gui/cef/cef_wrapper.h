@@ -11,6 +11,8 @@ extern "C" {
 
 // CEF Wrapper Module for VLC 8KDVD HTML5 Menu Integration
 typedef struct cef_wrapper_t cef_wrapper_t;
+struct menu_navigation_t;
+struct chapter_thumbnailer_t;
 
 // CEF Initialization and Management
 cef_wrapper_t* cef_wrapper_create(vlc_object_t *obj);
@@ -30,6 +32,8 @@ int cef_wrapper_reload(cef_wrapper_t *wrapper);
 // 8KDVD Integration Functions
 int cef_wrapper_handle_menu_selection(cef_wrapper_t *wrapper, int selection_id);
 void cef_wrapper_set_size(cef_wrapper_t *wrapper, int width, int height);
+void cef_wrapper_set_menu_navigation(cef_wrapper_t *wrapper, struct menu_navigation_t *navigation);
+void cef_wrapper_set_chapter_thumbnailer(cef_wrapper_t *wrapper, struct chapter_thumbnailer_t *thumbnailer);
 
 #ifdef __cplusplus
 }
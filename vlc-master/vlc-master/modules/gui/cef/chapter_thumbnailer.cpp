@@ -0,0 +1,345 @@
+#include "chapter_thumbnailer.h"
+#include <vlc_messages.h>
+#include <vlc_threads.h>
+#include <vlc_configuration.h>
+#include <vlc_input_item.h>
+#include <vlc_preparser.h>
+#include <filesystem>
+#include <sstream>
+#include <map>
+
+// Per-chapter generation timeout
+#define CHAPTER_THUMBNAIL_TIMEOUT VLC_TICK_FROM_SEC(15)
+
+enum chapter_thumbnail_state {
+    CHAPTER_THUMBNAIL_PENDING,
+    CHAPTER_THUMBNAIL_FAILED,
+};
+
+// Chapter Thumbnailer Implementation
+struct chapter_thumbnailer_t {
+    vlc_object_t *obj;
+    vlc_preparser_t *preparser;
+    vlc_mutex_t lock;
+
+    std::string cache_root;
+    std::string disc_dir;           // cache_root/disc_id, empty if no disc
+    std::map<int, std::string> title_mrls;
+    std::map<int64_t, int> states;  // chapter key -> chapter_thumbnail_state
+    unsigned generation;            // bumped on disc change
+
+    enum vlc_thumbnailer_format format;
+    std::string extension;
+    int width;
+    int height;
+};
+
+// One in-flight preparser request
+struct chapter_thumbnail_job {
+    chapter_thumbnailer_t *thumbnailer;
+    unsigned generation;
+    int64_t key;
+    std::string part_path;
+    std::string final_path;
+};
+
+static int64_t chapter_thumbnailer_key(int title_id, int chapter_id) {
+    return ((int64_t)title_id << 32) | (uint32_t)chapter_id;
+}
+
+static std::string chapter_thumbnailer_sanitize_id(const char *disc_id) {
+    // The disc ID becomes a directory name: keep it to a portable charset
+    std::string id;
+    for (const char *p = disc_id; *p; p++) {
+        char c = *p;
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+            (c >= '0' && c <= '9') || c == '-' || c == '_')
+            id += c;
+        else
+            id += '_';
+    }
+    return id;
+}
+
+// Caller must hold the lock
+static std::string chapter_thumbnailer_file_path(chapter_thumbnailer_t *thumbnailer,
+                                                 int title_id, int chapter_id) {
+    std::ostringstream path;
+    path << thumbnailer->disc_dir << "/t" << title_id << "_c" << chapter_id
+         << "_" << thumbnailer->width << "x" << thumbnailer->height
+         << "." << thumbnailer->extension;
+    return path.str();
+}
+
+static void chapter_thumbnailer_on_ended(input_item_t *item, int status,
+                                         const bool *result_array, size_t result_count,
+                                         void *data) {
+    VLC_UNUSED(item);
+    chapter_thumbnail_job *job = static_cast<chapter_thumbnail_job *>(data);
+    chapter_thumbnailer_t *thumbnailer = job->thumbnailer;
+
+    bool success = status == VLC_SUCCESS && result_count > 0 && result_array[0];
+    std::error_code ec;
+    if (success) {
+        // Publish atomically so the resource handler never serves a partial file
+        std::filesystem::rename(job->part_path, job->final_path, ec);
+        success = !ec;
+    }
+    if (!success)
+        std::filesystem::remove(job->part_path, ec);
+
+    vlc_mutex_lock(&thumbnailer->lock);
+    if (job->generation == thumbnailer->generation) {
+        if (success)
+            thumbnailer->states.erase(job->key);
+        else
+            thumbnailer->states[job->key] = CHAPTER_THUMBNAIL_FAILED;
+    }
+    vlc_mutex_unlock(&thumbnailer->lock);
+
+    if (success)
+        msg_Dbg(thumbnailer->obj, "Chapter thumbnail generated: %s", job->final_path.c_str());
+    else if (status != -EINTR)
+        msg_Warn(thumbnailer->obj, "Chapter thumbnail generation failed (%d): %s",
+                 status, job->final_path.c_str());
+
+    delete job;
+}
+
+static const struct vlc_thumbnailer_to_files_cbs chapter_thumbnailer_cbs = {
+    chapter_thumbnailer_on_ended,
+};
+
+chapter_thumbnailer_t* chapter_thumbnailer_create(vlc_object_t *obj, const char *cache_dir) {
+    chapter_thumbnailer_t *thumbnailer = new chapter_thumbnailer_t();
+    if (!thumbnailer) return nullptr;
+
+    thumbnailer->obj = obj;
+    thumbnailer->generation = 0;
+    thumbnailer->width = CHAPTER_THUMBNAIL_DEFAULT_WIDTH;
+    thumbnailer->height = 0;
+    vlc_mutex_init(&thumbnailer->lock);
+
+    if (cache_dir) {
+        thumbnailer->cache_root = cache_dir;
+    } else {
+        char *user_cache = config_GetUserDir(VLC_CACHE_DIR);
+        if (!user_cache) {
+            delete thumbnailer;
+            return nullptr;
+        }
+        thumbnailer->cache_root = std::string(user_cache) + "/8kdvd/thumbnails";
+        free(user_cache);
+    }
+
+    // Prefer WebP (smallest strip), fall back to PNG, then to whatever
+    // image encoder is available
+    const char *ext = nullptr;
+    if (vlc_preparser_CheckThumbnailerFormat(VLC_THUMBNAILER_FORMAT_WEBP) == 0) {
+        thumbnailer->format = VLC_THUMBNAILER_FORMAT_WEBP;
+        ext = "webp";
+    } else if (vlc_preparser_CheckThumbnailerFormat(VLC_THUMBNAILER_FORMAT_PNG) == 0) {
+        thumbnailer->format = VLC_THUMBNAILER_FORMAT_PNG;
+        ext = "png";
+    } else if (vlc_preparser_GetBestThumbnailerFormat(&thumbnailer->format, &ext) != 0) {
+        msg_Err(obj, "No image encoder available for chapter thumbnails");
+        delete thumbnailer;
+        return nullptr;
+    }
+    thumbnailer->extension = ext;
+
+    const struct vlc_preparser_cfg cfg = {
+        VLC_PREPARSER_TYPE_THUMBNAIL_TO_FILES, // types
+        0,                                     // max_parser_threads
+        1,                                     // max_thumbnailer_threads
+        CHAPTER_THUMBNAIL_TIMEOUT,             // timeout
+    };
+    thumbnailer->preparser = vlc_preparser_New(obj, &cfg);
+    if (!thumbnailer->preparser) {
+        msg_Err(obj, "Failed to create chapter thumbnailer");
+        delete thumbnailer;
+        return nullptr;
+    }
+
+    msg_Info(obj, "Chapter thumbnailer created (%s, cache: %s)",
+             ext, thumbnailer->cache_root.c_str());
+    return thumbnailer;
+}
+
+void chapter_thumbnailer_destroy(chapter_thumbnailer_t *thumbnailer) {
+    if (!thumbnailer) return;
+
+    // Cancels pending requests and waits for the running one: every job is
+    // released through chapter_thumbnailer_on_ended before this returns
+    vlc_preparser_Delete(thumbnailer->preparser);
+
+    vlc_object_t *obj = thumbnailer->obj;
+    delete thumbnailer;
+    msg_Info(obj, "Chapter thumbnailer destroyed");
+}
+
+int chapter_thumbnailer_set_disc(chapter_thumbnailer_t *thumbnailer, const char *disc_id) {
+    if (!thumbnailer || !disc_id || !*disc_id) return -1;
+
+    std::string disc_dir = thumbnailer->cache_root + "/" + chapter_thumbnailer_sanitize_id(disc_id);
+
+    std::error_code ec;
+    std::filesystem::create_directories(disc_dir, ec);
+    if (ec) {
+        msg_Err(thumbnailer->obj, "Failed to create thumbnail cache: %s", disc_dir.c_str());
+        return -1;
+    }
+
+    chapter_thumbnailer_cancel(thumbnailer);
+
+    vlc_mutex_lock(&thumbnailer->lock);
+    thumbnailer->disc_dir = disc_dir;
+    thumbnailer->title_mrls.clear();
+    thumbnailer->states.clear();
+    thumbnailer->generation++;
+    vlc_mutex_unlock(&thumbnailer->lock);
+
+    msg_Dbg(thumbnailer->obj, "Chapter thumbnail cache: %s", disc_dir.c_str());
+    return 0;
+}
+
+int chapter_thumbnailer_set_title_mrl(chapter_thumbnailer_t *thumbnailer, int title_id, const char *mrl) {
+    if (!thumbnailer || !mrl) return -1;
+
+    vlc_mutex_lock(&thumbnailer->lock);
+    thumbnailer->title_mrls[title_id] = mrl;
+    vlc_mutex_unlock(&thumbnailer->lock);
+    return 0;
+}
+
+void chapter_thumbnailer_set_size(chapter_thumbnailer_t *thumbnailer, int width, int height) {
+    if (!thumbnailer || width < 0 || height < 0 || (width == 0 && height == 0)) return;
+
+    // The size is part of the cache file name, previous files stay valid for
+    // their own size
+    vlc_mutex_lock(&thumbnailer->lock);
+    thumbnailer->width = width;
+    thumbnailer->height = height;
+    thumbnailer->states.clear();
+    vlc_mutex_unlock(&thumbnailer->lock);
+}
+
+int chapter_thumbnailer_generate(chapter_thumbnailer_t *thumbnailer,
+                                 const std::vector<chapter_info_t> &chapters) {
+    if (!thumbnailer) return -1;
+
+    int queued = 0;
+
+    vlc_mutex_lock(&thumbnailer->lock);
+    if (thumbnailer->disc_dir.empty()) {
+        vlc_mutex_unlock(&thumbnailer->lock);
+        return -1;
+    }
+
+    for (const chapter_info_t &chapter : chapters) {
+        int64_t key = chapter_thumbnailer_key(chapter.title_id, chapter.id);
+        if (thumbnailer->states.count(key))
+            continue; // pending, or failed for this disc
+
+        auto mrl = thumbnailer->title_mrls.find(chapter.title_id);
+        if (mrl == thumbnailer->title_mrls.end())
+            continue;
+
+        std::string final_path = chapter_thumbnailer_file_path(thumbnailer, chapter.title_id, chapter.id);
+        std::error_code ec;
+        if (std::filesystem::exists(final_path, ec))
+            continue; // cached by a previous visit
+
+        input_item_t *item = input_item_New(mrl->second.c_str(), chapter.name.c_str());
+        if (!item)
+            break;
+
+        chapter_thumbnail_job *job = new chapter_thumbnail_job();
+        job->thumbnailer = thumbnailer;
+        job->generation = thumbnailer->generation;
+        job->key = key;
+        job->final_path = final_path;
+        job->part_path = final_path + ".part";
+
+        // Fast seek lands on the keyframe at or before the chapter start,
+        // which avoids decoding a full GOP of 8K frames per thumbnail
+        struct vlc_thumbnailer_arg arg = {};
+        arg.seek.type = vlc_thumbnailer_arg::seek::VLC_THUMBNAILER_SEEK_TIME;
+        arg.seek.time = vlc_tick_from_sec(chapter.start_time);
+        arg.seek.speed = vlc_thumbnailer_arg::seek::VLC_THUMBNAILER_SEEK_FAST;
+        arg.hw_dec = true;
+
+        struct vlc_thumbnailer_output output = {};
+        output.format = thumbnailer->format;
+        output.width = thumbnailer->width;
+        output.height = thumbnailer->height;
+        output.crop = thumbnailer->width > 0 && thumbnailer->height > 0;
+        output.file_path = job->part_path.c_str();
+        output.creat_mode = 0644;
+
+        vlc_preparser_req_id id =
+            vlc_preparser_GenerateThumbnailToFiles(thumbnailer->preparser, item, &arg,
+                                                   &output, 1, &chapter_thumbnailer_cbs, job);
+        input_item_Release(item);
+
+        if (id == VLC_PREPARSER_REQ_ID_INVALID) {
+            delete job;
+            thumbnailer->states[key] = CHAPTER_THUMBNAIL_FAILED;
+            continue;
+        }
+
+        thumbnailer->states[key] = CHAPTER_THUMBNAIL_PENDING;
+        queued++;
+    }
+    vlc_mutex_unlock(&thumbnailer->lock);
+
+    if (queued > 0)
+        msg_Dbg(thumbnailer->obj, "Queued %d chapter thumbnails", queued);
+    return queued;
+}
+
+void chapter_thumbnailer_cancel(chapter_thumbnailer_t *thumbnailer) {
+    if (!thumbnailer) return;
+
+    // Must not hold the lock: cancelled jobs end synchronously
+    vlc_preparser_Cancel(thumbnailer->preparser, VLC_PREPARSER_REQ_ID_INVALID);
+}
+
+std::string chapter_thumbnailer_get_path(chapter_thumbnailer_t *thumbnailer, int title_id, int chapter_id) {
+    if (!thumbnailer) return "";
+
+    vlc_mutex_lock(&thumbnailer->lock);
+    std::string path;
+    if (!thumbnailer->disc_dir.empty())
+        path = chapter_thumbnailer_file_path(thumbnailer, title_id, chapter_id);
+    vlc_mutex_unlock(&thumbnailer->lock);
+
+    std::error_code ec;
+    if (path.empty() || !std::filesystem::exists(path, ec))
+        return "";
+    return path;
+}
+
+bool chapter_thumbnailer_is_ready(chapter_thumbnailer_t *thumbnailer, int title_id, int chapter_id) {
+    return !chapter_thumbnailer_get_path(thumbnailer, title_id, chapter_id).empty();
+}
+
+std::string chapter_thumbnailer_get_url(int title_id, int chapter_id) {
+    return std::string(CHAPTER_THUMBNAIL_URL_PREFIX) + std::to_string(title_id) +
+           "/" + std::to_string(chapter_id);
+}
+
+bool chapter_thumbnailer_parse_url(const std::string &url, int *title_id, int *chapter_id) {
+    const size_t prefix_len = sizeof(CHAPTER_THUMBNAIL_URL_PREFIX) - 1;
+    if (url.compare(0, prefix_len, CHAPTER_THUMBNAIL_URL_PREFIX) != 0)
+        return false;
+
+    int title, chapter;
+    char trailing;
+    if (sscanf(url.c_str() + prefix_len, "%d/%d%c", &title, &chapter, &trailing) != 2)
+        return false;
+
+    *title_id = title;
+    *chapter_id = chapter;
+    return true;
+}
@@ -0,0 +1,50 @@
+#ifndef VLC_8KDVD_CHAPTER_THUMBNAILER_H
+#define VLC_8KDVD_CHAPTER_THUMBNAILER_H
+
+#include <vlc_common.h>
+#include "xml_parser.h"
+#include <string>
+#include <vector>
+
+// Background chapter thumbnail generator for the 8KDVD chapter menu
+//
+// Thumbnails are generated by the preparser thumbnailer (fast seek to the
+// keyframe at or before the chapter start, reduced-size export) and cached
+// on disk under <cache_dir>/<disc_id>/, so a disc's chapter strip only has to
+// be decoded once.
+typedef struct chapter_thumbnailer_t chapter_thumbnailer_t;
+
+// URL prefix served by the CEF resource handler
+#define CHAPTER_THUMBNAIL_URL_PREFIX "8kdvd://thumbnail/"
+
+// Default thumbnail width in pixels (height follows the source aspect ratio)
+#define CHAPTER_THUMBNAIL_DEFAULT_WIDTH 384
+
+// Creation and destruction
+// cache_dir may be NULL to use the VLC user cache directory
+chapter_thumbnailer_t* chapter_thumbnailer_create(vlc_object_t *obj, const char *cache_dir);
+void chapter_thumbnailer_destroy(chapter_thumbnailer_t *thumbnailer);
+
+// Disc setup
+// Switching disc cancels every pending request of the previous disc
+int chapter_thumbnailer_set_disc(chapter_thumbnailer_t *thumbnailer, const char *disc_id);
+int chapter_thumbnailer_set_title_mrl(chapter_thumbnailer_t *thumbnailer, int title_id, const char *mrl);
+void chapter_thumbnailer_set_size(chapter_thumbnailer_t *thumbnailer, int width, int height);
+
+// Generation
+// Queues every chapter that is neither cached nor pending; returns the number
+// of queued requests, or -1 on error
+int chapter_thumbnailer_generate(chapter_thumbnailer_t *thumbnailer,
+                                 const std::vector<chapter_info_t> &chapters);
+void chapter_thumbnailer_cancel(chapter_thumbnailer_t *thumbnailer);
+
+// Lookup
+// Returns the cached file path, or an empty string if not generated yet
+std::string chapter_thumbnailer_get_path(chapter_thumbnailer_t *thumbnailer, int title_id, int chapter_id);
+bool chapter_thumbnailer_is_ready(chapter_thumbnailer_t *thumbnailer, int title_id, int chapter_id);
+
+// URL helpers
+std::string chapter_thumbnailer_get_url(int title_id, int chapter_id);
+bool chapter_thumbnailer_parse_url(const std::string &url, int *title_id, int *chapter_id);
+
+#endif // VLC_8KDVD_CHAPTER_THUMBNAILER_H
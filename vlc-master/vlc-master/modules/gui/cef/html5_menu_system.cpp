@@ -84,6 +84,13 @@ int html5_menu_system_create_menu(html5_menu_system_t *system, const menu_t *men
     return 0;
 }
 
+const menu_t* html5_menu_system_get_menu(html5_menu_system_t *system, const char *menu_id) {
+    if (!system || !menu_id) return nullptr;
+    
+    auto it = system->menus.find(menu_id);
+    return it != system->menus.end() ? &it->second : nullptr;
+}
+
 int html5_menu_system_show_menu(html5_menu_system_t *system, const char *menu_id) {
     if (!system || !menu_id) return -1;
     
@@ -119,6 +126,30 @@ int html5_menu_system_hide_menu(html5_menu_system_t *system) {
 }
 
 // 8KDVD Specific Functions
+
+// Stack the visible items in a column centred on the menu
+static void html5_menu_system_layout_items(menu_t *menu) {
+    const int item_width = menu->width / 4;
+    const int item_height = menu->height / 12;
+    const int spacing = item_height / 2;
+    
+    int count = 0;
+    for (const auto &item : menu->items) {
+        if (item.visible) count++;
+    }
+    
+    int y = (menu->height - (count * item_height + (count - 1) * spacing)) / 2;
+    for (auto &item : menu->items) {
+        item.x = (menu->width - item_width) / 2;
+        item.width = item_width;
+        item.height = item_height;
+        item.y = y;
+        if (item.visible) {
+            y += item_height + spacing;
+        }
+    }
+}
+
 int html5_menu_system_load_8kdvd_menu(html5_menu_system_t *system, const char *disc_path) {
     if (!system || !disc_path) return -1;
     
@@ -175,6 +206,8 @@ int html5_menu_system_create_8kdvd_main_menu(html5_menu_system_t *system, const
     about_item.visible = true;
     main_menu.items.push_back(about_item);
     
+    html5_menu_system_layout_items(&main_menu);
+    
     return html5_menu_system_create_menu(system, &main_menu);
 }
 
@@ -218,6 +251,8 @@ int html5_menu_system_create_8kdvd_settings_menu(html5_menu_system_t *system) {
     back_item.visible = true;
     settings_menu.items.push_back(back_item);
     
+    html5_menu_system_layout_items(&settings_menu);
+    
     return html5_menu_system_create_menu(system, &settings_menu);
 }
 
@@ -252,6 +287,8 @@ int html5_menu_system_create_8kdvd_about_menu(html5_menu_system_t *system) {
     back_item.visible = true;
     about_menu.items.push_back(back_item);
     
+    html5_menu_system_layout_items(&about_menu);
+    
     return html5_menu_system_create_menu(system, &about_menu);
 }
 
@@ -366,3 +403,15 @@ void html5_menu_system_set_8kdvd_mode(html5_menu_system_t *system, bool enable)
         msg_Info(system->obj, "8KDVD mode %s", enable ? "enabled" : "disabled");
     }
 }
+
+void html5_menu_system_set_menu_navigation(html5_menu_system_t *system, struct menu_navigation_t *navigation) {
+    if (system) {
+        cef_wrapper_set_menu_navigation(system->cef_wrapper, navigation);
+    }
+}
+
+void html5_menu_system_set_chapter_thumbnailer(html5_menu_system_t *system, struct chapter_thumbnailer_t *thumbnailer) {
+    if (system) {
+        cef_wrapper_set_chapter_thumbnailer(system->cef_wrapper, thumbnailer);
+    }
+}
@@ -17,6 +17,11 @@ typedef struct menu_item_t {
     std::string icon;
     std::string action;
     std::map<std::string, std::string> properties;
+    // Position in menu coordinates
+    int x;
+    int y;
+    int width;
+    int height;
     bool enabled;
     bool visible;
 } menu_item_t;
@@ -44,6 +49,7 @@ int html5_menu_system_load_menu(html5_menu_system_t *system, const char *menu_pa
 int html5_menu_system_create_menu(html5_menu_system_t *system, const menu_t *menu);
 int html5_menu_system_show_menu(html5_menu_system_t *system, const char *menu_id);
 int html5_menu_system_hide_menu(html5_menu_system_t *system);
+const menu_t* html5_menu_system_get_menu(html5_menu_system_t *system, const char *menu_id);
 
 // 8KDVD Specific Functions
 int html5_menu_system_load_8kdvd_menu(html5_menu_system_t *system, const char *disc_path);
@@ -67,5 +73,7 @@ int html5_menu_system_get_selected_item(html5_menu_system_t *system);
 // VLC Integration
 void html5_menu_system_set_vlc_integration(html5_menu_system_t *system, bool enable);
 void html5_menu_system_set_8kdvd_mode(html5_menu_system_t *system, bool enable);
+void html5_menu_system_set_menu_navigation(html5_menu_system_t *system, struct menu_navigation_t *navigation);
+void html5_menu_system_set_chapter_thumbnailer(html5_menu_system_t *system, struct chapter_thumbnailer_t *thumbnailer);
 
 #endif // VLC_HTML5_MENU_SYSTEM_H
@@ -1,8 +1,208 @@
 #include "menu_navigation.h"
 #include "html5_menu_system.h"
 #include <vlc_messages.h>
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
 #include <cstring>
 
+// Uniform grid over the menu item rectangles, built once per menu load.
+// Each cell lists the items overlapping it, stored contiguously so that
+// hit testing is a single cell lookup and directional navigation only
+// visits the cells around the current item.
+class MenuSpatialIndex {
+public:
+    MenuSpatialIndex() : origin_x_(0), origin_y_(0), cell_w_(1), cell_h_(1), cols_(0), rows_(0) {}
+    
+    void Build(const nav_item_rect_t *rects, int count);
+    void Clear();
+    bool Empty() const { return rects_.empty(); }
+    int HitTest(int x, int y) const;
+    int FindNeighbour(int from, nav_direction_t direction) const;
+    
+private:
+    std::vector<nav_item_rect_t> rects_;
+    std::vector<int> cell_offsets_;   // cols_ * rows_ + 1 offsets into cell_items_
+    std::vector<int> cell_items_;
+    int origin_x_, origin_y_;
+    int cell_w_, cell_h_;
+    int cols_, rows_;
+    
+    int CellColumn(int x) const { return std::min(std::max((x - origin_x_) / cell_w_, 0), cols_ - 1); }
+    int CellRow(int y) const { return std::min(std::max((y - origin_y_) / cell_h_, 0), rows_ - 1); }
+    bool Score(const nav_item_rect_t &from, const nav_item_rect_t &to,
+               nav_direction_t direction, long long *score) const;
+};
+
+// Keep the grid around one cell per item, whatever the menu looks like
+#define MENU_INDEX_MAX_CELLS_PER_AXIS 256
+
+void MenuSpatialIndex::Clear() {
+    rects_.clear();
+    cell_offsets_.clear();
+    cell_items_.clear();
+    cols_ = rows_ = 0;
+}
+
+void MenuSpatialIndex::Build(const nav_item_rect_t *rects, int count) {
+    Clear();
+    if (!rects || count <= 0) return;
+    
+    rects_.assign(rects, rects + count);
+    
+    int min_x = INT_MAX, min_y = INT_MAX, max_x = INT_MIN, max_y = INT_MIN;
+    long long total_w = 0, total_h = 0;
+    for (const nav_item_rect_t &r : rects_) {
+        min_x = std::min(min_x, r.x);
+        min_y = std::min(min_y, r.y);
+        max_x = std::max(max_x, r.x + std::max(r.width, 1));
+        max_y = std::max(max_y, r.y + std::max(r.height, 1));
+        total_w += std::max(r.width, 1);
+        total_h += std::max(r.height, 1);
+    }
+    
+    // Cells about the size of an average item
+    origin_x_ = min_x;
+    origin_y_ = min_y;
+    cell_w_ = std::max<int>(1, total_w / count);
+    cell_h_ = std::max<int>(1, total_h / count);
+    cols_ = std::min((max_x - min_x + cell_w_ - 1) / cell_w_, MENU_INDEX_MAX_CELLS_PER_AXIS);
+    rows_ = std::min((max_y - min_y + cell_h_ - 1) / cell_h_, MENU_INDEX_MAX_CELLS_PER_AXIS);
+    cols_ = std::max(cols_, 1);
+    rows_ = std::max(rows_, 1);
+    cell_w_ = std::max(cell_w_, (max_x - min_x + cols_ - 1) / cols_);
+    cell_h_ = std::max(cell_h_, (max_y - min_y + rows_ - 1) / rows_);
+    
+    // Two passes: count the items per cell, then fill them in place
+    cell_offsets_.assign(cols_ * rows_ + 1, 0);
+    for (const nav_item_rect_t &r : rects_) {
+        for (int row = CellRow(r.y); row <= CellRow(r.y + std::max(r.height, 1) - 1); row++)
+            for (int col = CellColumn(r.x); col <= CellColumn(r.x + std::max(r.width, 1) - 1); col++)
+                cell_offsets_[row * cols_ + col + 1]++;
+    }
+    for (size_t i = 1; i < cell_offsets_.size(); i++)
+        cell_offsets_[i] += cell_offsets_[i - 1];
+    
+    cell_items_.resize(cell_offsets_.back());
+    std::vector<int> fill(cell_offsets_.begin(), cell_offsets_.end() - 1);
+    for (int i = 0; i < count; i++) {
+        const nav_item_rect_t &r = rects_[i];
+        for (int row = CellRow(r.y); row <= CellRow(r.y + std::max(r.height, 1) - 1); row++)
+            for (int col = CellColumn(r.x); col <= CellColumn(r.x + std::max(r.width, 1) - 1); col++)
+                cell_items_[fill[row * cols_ + col]++] = i;
+    }
+}
+
+int MenuSpatialIndex::HitTest(int x, int y) const {
+    if (rects_.empty()) return -1;
+    if (x < origin_x_ || y < origin_y_ ||
+        x >= origin_x_ + cols_ * cell_w_ || y >= origin_y_ + rows_ * cell_h_)
+        return -1;
+    
+    int cell = CellRow(y) * cols_ + CellColumn(x);
+    int hit = -1;
+    
+    // Later items are drawn on top of earlier ones
+    for (int i = cell_offsets_[cell]; i < cell_offsets_[cell + 1]; i++) {
+        const nav_item_rect_t &r = rects_[cell_items_[i]];
+        if (r.enabled && x >= r.x && x < r.x + r.width && y >= r.y && y < r.y + r.height)
+            hit = std::max(hit, cell_items_[i]);
+    }
+    
+    return hit;
+}
+
+// Score a candidate for a move in the given direction: the distance along
+// the direction plus twice the offset across it, measured from the centre
+// of the current item to the closest point of the candidate
+bool MenuSpatialIndex::Score(const nav_item_rect_t &from, const nav_item_rect_t &to,
+                             nav_direction_t direction, long long *score) const {
+    int cx = from.x + from.width / 2;
+    int cy = from.y + from.height / 2;
+    int tx = to.x + to.width / 2;
+    int ty = to.y + to.height / 2;
+    int px = std::min(std::max(cx, to.x), to.x + to.width);
+    int py = std::min(std::max(cy, to.y), to.y + to.height);
+    long long major, minor;
+    
+    switch (direction) {
+        case NAV_UP:
+            if (ty >= cy) return false;
+            major = cy - py; minor = std::abs(px - cx);
+            break;
+        case NAV_DOWN:
+            if (ty <= cy) return false;
+            major = py - cy; minor = std::abs(px - cx);
+            break;
+        case NAV_LEFT:
+            if (tx >= cx) return false;
+            major = cx - px; minor = std::abs(py - cy);
+            break;
+        case NAV_RIGHT:
+            if (tx <= cx) return false;
+            major = px - cx; minor = std::abs(py - cy);
+            break;
+        default:
+            return false;
+    }
+    
+    *score = major + 2 * minor;
+    return true;
+}
+
+int MenuSpatialIndex::FindNeighbour(int from, nav_direction_t direction) const {
+    if (from < 0 || from >= (int)rects_.size()) return -1;
+    
+    const nav_item_rect_t &current = rects_[from];
+    int start_col = CellColumn(current.x + current.width / 2);
+    int start_row = CellRow(current.y + current.height / 2);
+    int max_ring = std::max(cols_, rows_);
+    long long cell_min = std::min(cell_w_, cell_h_);
+    long long best_score = LLONG_MAX;
+    int best = -1;
+    
+    // Walk rings of cells around the current item, only on the side we are
+    // moving to. Anything first met beyond ring r is at least r cells away,
+    // so we can stop as soon as that can't beat the best candidate.
+    for (int ring = 0; ring <= max_ring; ring++) {
+        if (best >= 0 && best_score < (ring - 1) * cell_min) break;
+        
+        for (int row = start_row - ring; row <= start_row + ring; row++) {
+            if (row < 0 || row >= rows_) continue;
+            if (direction == NAV_UP && row > start_row) continue;
+            if (direction == NAV_DOWN && row < start_row) continue;
+            
+            for (int col = start_col - ring; col <= start_col + ring; col++) {
+                if (col < 0 || col >= cols_) continue;
+                if (direction == NAV_LEFT && col > start_col) continue;
+                if (direction == NAV_RIGHT && col < start_col) continue;
+                if (std::max(std::abs(row - start_row), std::abs(col - start_col)) != ring) continue;
+                
+                int cell = row * cols_ + col;
+                for (int i = cell_offsets_[cell]; i < cell_offsets_[cell + 1]; i++) {
+                    int item = cell_items_[i];
+                    long long score;
+                    
+                    if (item == from || !rects_[item].enabled) continue;
+                    if (!Score(current, rects_[item], direction, &score)) continue;
+                    if (score < best_score || (score == best_score && item < best)) {
+                        best_score = score;
+                        best = item;
+                    }
+                }
+            }
+        }
+    }
+    
+    return best;
+}
+
+// Helpers, defined below
+void menu_navigation_update_navigation_state(menu_navigation_t *nav);
+int menu_navigation_handle_main_menu_selection(menu_navigation_t *nav);
+int menu_navigation_handle_settings_menu_selection(menu_navigation_t *nav);
+int menu_navigation_handle_about_menu_selection(menu_navigation_t *nav);
+
 // Menu Navigation System Implementation
 struct menu_navigation_t {
     vlc_object_t *obj;
@@ -12,6 +212,10 @@ struct menu_navigation_t {
     bool vlc_integration_enabled;
     bool debug_output_enabled;
     bool kdvd_mode_enabled;
+    MenuSpatialIndex spatial_index;
+    // Layout and view sizes, to map mouse positions to the layout
+    int menu_width, menu_height;
+    int view_width, view_height;
 };
 
 menu_navigation_t* menu_navigation_create(vlc_object_t *obj) {
@@ -24,6 +228,8 @@ menu_navigation_t* menu_navigation_create(vlc_object_t *obj) {
     nav->vlc_integration_enabled = true;
     nav->debug_output_enabled = false;
     nav->kdvd_mode_enabled = false;
+    nav->menu_width = nav->menu_height = 0;
+    nav->view_width = nav->view_height = 0;
     
     // Initialize navigation state
     nav->state.current_item = 0;
@@ -42,14 +248,28 @@ menu_navigation_t* menu_navigation_create(vlc_object_t *obj) {
 void menu_navigation_destroy(menu_navigation_t *nav) {
     if (!nav) return;
     
-    nav->current_menu_id.clear();
-    delete nav;
     msg_Info(nav->obj, "Menu navigation system destroyed");
+    delete nav;
 }
 
 int menu_navigation_navigate(menu_navigation_t *nav, nav_direction_t direction) {
     if (!nav) return -1;
     
+    // Menus with a known layout move to the nearest item on screen
+    if (!nav->spatial_index.Empty() &&
+        (direction == NAV_UP || direction == NAV_DOWN ||
+         direction == NAV_LEFT || direction == NAV_RIGHT)) {
+        int next = nav->spatial_index.FindNeighbour(nav->state.current_item, direction);
+        if (next >= 0) {
+            nav->state.current_item = next;
+            msg_Dbg(nav->obj, "Navigation: %s (item %d)",
+                    direction == NAV_UP ? "Up" : direction == NAV_DOWN ? "Down" :
+                    direction == NAV_LEFT ? "Left" : "Right", next);
+        }
+        menu_navigation_update_navigation_state(nav);
+        return 0;
+    }
+    
     switch (direction) {
         case NAV_UP:
             if (nav->state.can_navigate_up) {
@@ -158,6 +378,7 @@ int menu_navigation_set_menu(menu_navigation_t *nav, const char *menu_id, int to
     nav->current_menu_id = menu_id;
     nav->state.total_items = total_items;
     nav->state.current_item = 0;
+    nav->spatial_index.Clear();
     
     menu_navigation_update_navigation_state(nav);
     
@@ -165,11 +386,104 @@ int menu_navigation_set_menu(menu_navigation_t *nav, const char *menu_id, int to
     return 0;
 }
 
+int menu_navigation_set_menu_layout(menu_navigation_t *nav, const char *menu_id, const nav_item_rect_t *rects, int total_items) {
+    if (!nav || !menu_id || (total_items > 0 && !rects)) return -1;
+    
+    nav->current_menu_id = menu_id;
+    nav->state.total_items = total_items;
+    nav->state.current_item = 0;
+    nav->spatial_index.Build(rects, total_items);
+    
+    // Start on the first item that can be selected
+    for (int i = 0; i < total_items; i++) {
+        if (rects[i].enabled) {
+            nav->state.current_item = i;
+            break;
+        }
+    }
+    
+    menu_navigation_update_navigation_state(nav);
+    
+    msg_Info(nav->obj, "Menu navigation set: %s (%d items, spatial layout)", menu_id, total_items);
+    return 0;
+}
+
+int menu_navigation_set_menu_items(menu_navigation_t *nav, const char *menu_id, const struct menu_item_t *items, int total_items) {
+    if (!nav || !menu_id || (total_items > 0 && !items)) return -1;
+    
+    std::vector<nav_item_rect_t> rects(total_items);
+    for (int i = 0; i < total_items; i++) {
+        rects[i].x = items[i].x;
+        rects[i].y = items[i].y;
+        rects[i].width = items[i].width;
+        rects[i].height = items[i].height;
+        rects[i].enabled = items[i].enabled && items[i].visible;
+    }
+    
+    return menu_navigation_set_menu_layout(nav, menu_id, rects.data(), total_items);
+}
+
+int menu_navigation_set_menu_size(menu_navigation_t *nav, int width, int height) {
+    if (!nav || width < 0 || height < 0) return -1;
+    
+    nav->menu_width = width;
+    nav->menu_height = height;
+    return 0;
+}
+
+int menu_navigation_set_view_size(menu_navigation_t *nav, int width, int height) {
+    if (!nav || width < 0 || height < 0) return -1;
+    
+    nav->view_width = width;
+    nav->view_height = height;
+    return 0;
+}
+
+int menu_navigation_hit_test(menu_navigation_t *nav, int x, int y) {
+    if (!nav) return -1;
+    
+    // The menu is stretched over the whole view
+    if (nav->menu_width > 0 && nav->view_width > 0)
+        x = (int)((long long)x * nav->menu_width / nav->view_width);
+    if (nav->menu_height > 0 && nav->view_height > 0)
+        y = (int)((long long)y * nav->menu_height / nav->view_height);
+    
+    return nav->spatial_index.HitTest(x, y);
+}
+
+int menu_navigation_mouse_move(menu_navigation_t *nav, int x, int y) {
+    // Hovering an item highlights it, as remote navigation would
+    int item = menu_navigation_hit_test(nav, x, y);
+    if (item >= 0)
+        menu_navigation_set_current_item(nav, item);
+    return item;
+}
+
+int menu_navigation_mouse_click(menu_navigation_t *nav, int x, int y) {
+    int item = menu_navigation_mouse_move(nav, x, y);
+    if (item >= 0)
+        menu_navigation_select(nav);
+    return item;
+}
+
+int menu_navigation_set_current_item(menu_navigation_t *nav, int item) {
+    if (!nav || item < 0 || item >= nav->state.total_items) return -1;
+    
+    if (item != nav->state.current_item) {
+        nav->state.current_item = item;
+        menu_navigation_update_navigation_state(nav);
+    }
+    return 0;
+}
+
 int menu_navigation_update_items(menu_navigation_t *nav, int total_items) {
     if (!nav) return -1;
     
     nav->state.total_items = total_items;
     
+    // The layout no longer matches the items
+    nav->spatial_index.Clear();
+    
     // Ensure current item is within bounds
     if (nav->state.current_item >= total_items) {
         nav->state.current_item = total_items - 1;
@@ -233,8 +547,9 @@ void menu_navigation_update_navigation_state(menu_navigation_t *nav) {
     // Update navigation capabilities based on current state
     nav->state.can_navigate_up = (nav->state.total_items > 1);
     nav->state.can_navigate_down = (nav->state.total_items > 1);
-    nav->state.can_navigate_left = false; // Not used in current menu system
-    nav->state.can_navigate_right = false; // Not used in current menu system
+    // Left/right only make sense when we know where the items are
+    nav->state.can_navigate_left = !nav->spatial_index.Empty() && (nav->state.total_items > 1);
+    nav->state.can_navigate_right = !nav->spatial_index.Empty() && (nav->state.total_items > 1);
     nav->state.can_select = (nav->state.total_items > 0);
     nav->state.can_go_back = true; // Always allow going back
     
@@ -31,6 +31,17 @@ typedef struct nav_state_t {
     bool can_go_back;
 } nav_state_t;
 
+// On-screen rectangle of a menu item, in menu coordinates
+typedef struct nav_item_rect_t {
+    int x;
+    int y;
+    int width;
+    int height;
+    bool enabled;
+} nav_item_rect_t;
+
+struct menu_item_t;
+
 // Menu Navigation Functions
 menu_navigation_t* menu_navigation_create(vlc_object_t *obj);
 void menu_navigation_destroy(menu_navigation_t *nav);
@@ -49,6 +60,19 @@ int menu_navigation_get_total_items(menu_navigation_t *nav);
 int menu_navigation_set_menu(menu_navigation_t *nav, const char *menu_id, int total_items);
 int menu_navigation_update_items(menu_navigation_t *nav, int total_items);
 
+// Spatial Layout (indexed once per menu load)
+int menu_navigation_set_menu_layout(menu_navigation_t *nav, const char *menu_id, const nav_item_rect_t *rects, int total_items);
+int menu_navigation_set_menu_items(menu_navigation_t *nav, const char *menu_id, const struct menu_item_t *items, int total_items);
+int menu_navigation_set_current_item(menu_navigation_t *nav, int item);
+
+// Mouse Input: the layout is in menu coordinates, scaled to the view that
+// shows it, while mouse positions are in view coordinates
+int menu_navigation_set_menu_size(menu_navigation_t *nav, int width, int height);
+int menu_navigation_set_view_size(menu_navigation_t *nav, int width, int height);
+int menu_navigation_hit_test(menu_navigation_t *nav, int x, int y);
+int menu_navigation_mouse_move(menu_navigation_t *nav, int x, int y);
+int menu_navigation_mouse_click(menu_navigation_t *nav, int x, int y);
+
 // 8KDVD Specific Navigation
 int menu_navigation_handle_8kdvd_input(menu_navigation_t *nav, const char *input);
 int menu_navigation_set_8kdvd_mode(menu_navigation_t *nav, bool enable);
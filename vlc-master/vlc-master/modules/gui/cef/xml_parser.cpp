@@ -1,4 +1,5 @@
 #include "xml_parser.h"
+#include "chapter_thumbnailer.h"
 #include <vlc_messages.h>
 #include <fstream>
 #include <sstream>
@@ -254,7 +255,12 @@ std::string xml_parser_generate_chapter_data(xml_parser_t *parser) {
         json << "\"name\":\"" << parser->chapters[i].name << "\",";
         json << "\"start_time\":" << parser->chapters[i].start_time << ",";
         json << "\"end_time\":" << parser->chapters[i].end_time << ",";
-        json << "\"thumbnail\":\"" << parser->chapters[i].thumbnail << "\"";
+        // Chapters without an authored thumbnail use the generated one
+        if (parser->chapters[i].thumbnail.empty())
+            json << "\"thumbnail\":\"" << chapter_thumbnailer_get_url(parser->chapters[i].title_id,
+                                                                      parser->chapters[i].id) << "\"";
+        else
+            json << "\"thumbnail\":\"" << parser->chapters[i].thumbnail << "\"";
         json << "}";
     }
     
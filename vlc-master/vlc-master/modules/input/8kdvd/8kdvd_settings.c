@@ -2,9 +2,100 @@
 #include <vlc_messages.h>
 #include <vlc_fs.h>
 #include <vlc_meta.h>
+#include <vlc_threads.h>
+#include <vlc_atomic.h>
+#include <vlc_list.h>
 #include <string.h>
 #include <stdlib.h>
 #include <time.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+# include <unistd.h>
+# include <sys/mman.h>
+#else
+# include <io.h>
+#endif
+
+// Binary snapshot file format (host byte order, rejected if swapped)
+#define KDVD_SETTINGS_FILE_MAGIC   0x5344384Bu // "K8DS"
+#define KDVD_SETTINGS_FILE_VERSION 1
+
+typedef struct kdvd_settings_file_header_t {
+    uint32_t magic;                 // KDVD_SETTINGS_FILE_MAGIC
+    uint16_t version;               // KDVD_SETTINGS_FILE_VERSION
+    uint16_t record_size;           // sizeof(kdvd_settings_file_record_t)
+    uint32_t record_count;          // Number of records
+    uint32_t strings_size;          // String pool size, NUL-terminated
+    uint64_t modified_date;         // Save time (seconds since epoch)
+} kdvd_settings_file_header_t;
+
+typedef struct kdvd_settings_file_record_t {
+    uint32_t name_offset;           // Key offset in the string pool
+    uint16_t type;                  // kdvd_setting_type_t
+    uint16_t reserved;
+    union {
+        int32_t integer_value;
+        float float_value;
+        uint32_t uint_value;        // Boolean, enum and color
+        uint32_t string_offset;     // String, path and password
+    };
+} kdvd_settings_file_record_t;
+
+// Compiled setting value, strings point into the string arena, the loaded
+// file or a copy owned by the setting
+typedef union kdvd_settings_scalar_t {
+    bool boolean_value;
+    int32_t integer_value;
+    float float_value;
+    uint32_t uint_value;
+    const char *string_value;
+} kdvd_settings_scalar_t;
+
+typedef struct kdvd_settings_entry_t {
+    const char *name;               // Interned key
+    kdvd_setting_type_t type;       // Setting type
+    kdvd_settings_scalar_t value;   // Current value
+} kdvd_settings_entry_t;
+
+// Immutable compiled table, replaced as a whole on every modification.
+// Lookups go through a hash-and-displace perfect hash: one hash picks a
+// bucket, the bucket displacement picks a collision-free slot.
+typedef struct kdvd_settings_snapshot_t {
+    size_t size;                    // Allocation size (for duplication)
+    uint64_t version;               // Bumped on every publication
+    uint32_t count;                 // Entry count
+    uint32_t bucket_count;          // Displacement table size
+    uint32_t slot_mask;             // Slot table size - 1 (power of two)
+    kdvd_settings_entry_t entries[]; // Followed by slots and displacements
+} kdvd_settings_snapshot_t;
+
+// Grace period tracking, same scheme as src/misc/rcu.c but per object, as
+// the core RCU is not exported to modules
+struct kdvd_settings_generation {
+    atomic_uintptr_t readers;
+    atomic_uint writer;
+};
+
+typedef struct kdvd_settings_chunk_t {
+    struct kdvd_settings_chunk_t *next;
+    size_t used;
+    size_t size;
+    char data[];
+} kdvd_settings_chunk_t;
+
+typedef struct kdvd_settings_mapping_t {
+    void *addr;
+    size_t size;
+} kdvd_settings_mapping_t;
+
+struct kdvd_settings_listener_id {
+    const kdvd_settings_callbacks_t *cbs;
+    void *data;
+    struct vlc_list node;
+};
 
 // 8KDVD Settings Implementation
 struct kdvd_settings_t {
@@ -14,7 +105,8 @@ struct kdvd_settings_t {
     bool debug_enabled;
     char last_error[256];
     char config_path[512];
-    kdvd_setting_t *settings;
+    kdvd_setting_t *settings;       // Schema, writer side only
+    kdvd_settings_scalar_t *defaults; // Compiled default values
     uint32_t setting_count;
     kdvd_settings_profile_t *profiles;
     uint32_t profile_count;
@@ -22,135 +114,955 @@ struct kdvd_settings_t {
     void *settings_context;
     uint64_t start_time;
     uint32_t memory_usage_mb;
+
+    // Read side: lock-free
+    kdvd_settings_snapshot_t *_Atomic snapshot;
+    struct kdvd_settings_generation *_Atomic generation;
+    struct kdvd_settings_generation generations[2];
+
+    // Write side: serialized by writer_lock
+    vlc_mutex_t writer_lock;
+    kdvd_settings_chunk_t *strings; // Interned keys and default values
+    char **owned_strings;           // Written string values, NULL if unused
+    kdvd_settings_mapping_t *mapping; // Last loaded snapshot file
+    struct vlc_list listeners;
 };
 
+static uint32_t kdvd_settings_hash(const char *name, uint32_t seed) {
+    // FNV-1a with a seeded basis and a final avalanche, so that successive
+    // displacements yield independent slots
+    uint32_t hash = 2166136261u ^ (seed * 0x9e3779b9u);
+    for (; *name; name++) {
+        hash ^= (uint8_t)*name;
+        hash *= 16777619u;
+    }
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    return hash;
+}
+
+static int32_t *kdvd_settings_snapshot_slots(const kdvd_settings_snapshot_t *snapshot) {
+    return (int32_t *)&snapshot->entries[snapshot->count];
+}
+
+static uint16_t *kdvd_settings_snapshot_displacements(const kdvd_settings_snapshot_t *snapshot) {
+    return (uint16_t *)(kdvd_settings_snapshot_slots(snapshot) + snapshot->slot_mask + 1);
+}
+
+static kdvd_settings_snapshot_t *kdvd_settings_snapshot_alloc(uint32_t count, uint32_t bucket_count,
+                                                              uint32_t slot_count) {
+    size_t size = sizeof(kdvd_settings_snapshot_t)
+                + count * sizeof(kdvd_settings_entry_t)
+                + slot_count * sizeof(int32_t)
+                + bucket_count * sizeof(uint16_t);
+    kdvd_settings_snapshot_t *snapshot = malloc(size);
+    if (!snapshot) return NULL;
+
+    snapshot->size = size;
+    snapshot->version = 0;
+    snapshot->count = count;
+    snapshot->bucket_count = bucket_count;
+    snapshot->slot_mask = slot_count - 1;
+    return snapshot;
+}
+
+static kdvd_settings_snapshot_t *kdvd_settings_snapshot_dup(const kdvd_settings_snapshot_t *snapshot) {
+    kdvd_settings_snapshot_t *copy = malloc(snapshot->size);
+    if (!copy) return NULL;
+
+    memcpy(copy, snapshot, snapshot->size);
+    copy->version++;
+    return copy;
+}
+
+static kdvd_setting_key_t kdvd_settings_snapshot_find(const kdvd_settings_snapshot_t *snapshot,
+                                                      const char *name) {
+    if (snapshot->count == 0) return KDVD_SETTING_KEY_INVALID;
+
+    uint32_t bucket = kdvd_settings_hash(name, 0) % snapshot->bucket_count;
+    uint32_t displacement = kdvd_settings_snapshot_displacements(snapshot)[bucket];
+    uint32_t slot = kdvd_settings_hash(name, displacement + 1) & snapshot->slot_mask;
+    int32_t index = kdvd_settings_snapshot_slots(snapshot)[slot];
+
+    // A perfect hash maps every registered key to its own slot, unknown keys
+    // land anywhere: one compare settles it
+    if (index < 0 || strcmp(snapshot->entries[index].name, name) != 0)
+        return KDVD_SETTING_KEY_INVALID;
+    return index;
+}
+
+// Builds the perfect hash over the given entries; the slot table grows until
+// every bucket finds a displacement
+static kdvd_settings_snapshot_t *kdvd_settings_snapshot_compile(const kdvd_settings_entry_t *entries,
+                                                                uint32_t count) {
+    uint32_t bucket_count = count / 4 + 1;
+    uint32_t slot_count = 1;
+    while (slot_count < 2 * count)
+        slot_count <<= 1;
+
+    uint32_t *bucket_of = malloc((count + 1) * sizeof(uint32_t));
+    uint32_t *bucket_start = calloc(bucket_count + 1, sizeof(uint32_t));
+    uint32_t *members = malloc((count + 1) * sizeof(uint32_t));
+    uint32_t *order = malloc(bucket_count * sizeof(uint32_t));
+    kdvd_settings_snapshot_t *snapshot = NULL;
+    if (!bucket_of || !bucket_start || !members || !order)
+        goto out;
+
+    // Group entries by bucket (counting sort)
+    for (uint32_t i = 0; i < count; i++) {
+        bucket_of[i] = kdvd_settings_hash(entries[i].name, 0) % bucket_count;
+        bucket_start[bucket_of[i] + 1]++;
+    }
+    for (uint32_t b = 0; b < bucket_count; b++)
+        bucket_start[b + 1] += bucket_start[b];
+    uint32_t *fill = calloc(bucket_count, sizeof(uint32_t));
+    if (!fill) goto out;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t b = bucket_of[i];
+        members[bucket_start[b] + fill[b]++] = i;
+    }
+    free(fill);
+
+    // Place the largest buckets first, while the slot table is emptiest
+    for (uint32_t b = 0; b < bucket_count; b++)
+        order[b] = b;
+    for (uint32_t i = 1; i < bucket_count; i++) {
+        uint32_t b = order[i], size = bucket_start[b + 1] - bucket_start[b], j = i;
+        while (j > 0 && bucket_start[order[j - 1] + 1] - bucket_start[order[j - 1]] < size) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = b;
+    }
+
+    for (;;) {
+        snapshot = kdvd_settings_snapshot_alloc(count, bucket_count, slot_count);
+        if (!snapshot) goto out;
+
+        if (count > 0)
+            memcpy(snapshot->entries, entries, count * sizeof(*entries));
+        int32_t *slots = kdvd_settings_snapshot_slots(snapshot);
+        uint16_t *displacements = kdvd_settings_snapshot_displacements(snapshot);
+        for (uint32_t s = 0; s < slot_count; s++)
+            slots[s] = -1;
+        memset(displacements, 0, bucket_count * sizeof(uint16_t));
+
+        bool placed_all = true;
+        for (uint32_t o = 0; o < bucket_count && placed_all; o++) {
+            uint32_t b = order[o];
+            uint32_t first = bucket_start[b], last = bucket_start[b + 1];
+            if (first == last) continue;
+
+            bool placed = false;
+            for (uint32_t d = 0; d <= UINT16_MAX && !placed; d++) {
+                uint32_t m;
+                for (m = first; m < last; m++) {
+                    uint32_t slot = kdvd_settings_hash(entries[members[m]].name, d + 1) & snapshot->slot_mask;
+                    if (slots[slot] >= 0) break;
+                    slots[slot] = members[m];
+                }
+                if (m == last) {
+                    displacements[b] = d;
+                    placed = true;
+                } else {
+                    // Roll back the partial placement of this bucket
+                    while (m-- > first)
+                        slots[kdvd_settings_hash(entries[members[m]].name, d + 1) & snapshot->slot_mask] = -1;
+                }
+            }
+            placed_all = placed;
+        }
+
+        if (placed_all) break;
+
+        free(snapshot);
+        snapshot = NULL;
+        slot_count <<= 1;
+    }
+
+out:
+    free(bucket_of);
+    free(bucket_start);
+    free(members);
+    free(order);
+    return snapshot;
+}
+
+static const kdvd_settings_snapshot_t *kdvd_settings_read_lock(kdvd_settings_t *settings,
+                                                               struct kdvd_settings_generation **genp) {
+    struct kdvd_settings_generation *gen =
+        atomic_load_explicit(&settings->generation, memory_order_acquire);
+    atomic_fetch_add_explicit(&gen->readers, 1, memory_order_seq_cst);
+    *genp = gen;
+    return atomic_load_explicit(&settings->snapshot, memory_order_seq_cst);
+}
+
+static void kdvd_settings_read_unlock(struct kdvd_settings_generation *gen) {
+    uintptr_t readers = atomic_fetch_sub_explicit(&gen->readers, 1, memory_order_release);
+    assert(readers > 0);
+    if (readers > 1)
+        return; // Other readers remain
+
+    if (unlikely(atomic_exchange_explicit(&gen->writer, 0, memory_order_release)))
+        vlc_atomic_notify_one(&gen->writer); // Last reader wakes the writer up
+}
+
+// Caller must hold the writer lock
+static void kdvd_settings_synchronize(kdvd_settings_t *settings) {
+    struct kdvd_settings_generation *gen =
+        atomic_load_explicit(&settings->generation, memory_order_relaxed);
+    size_t idx = (gen - settings->generations + 1) % ARRAY_SIZE(settings->generations);
+
+    // Start a new generation for future readers, then wait for the old one
+    atomic_store_explicit(&settings->generation, &settings->generations[idx], memory_order_release);
+    atomic_exchange_explicit(&gen->writer, 1, memory_order_seq_cst);
+
+    while (atomic_load_explicit(&gen->readers, memory_order_acquire) > 0)
+        vlc_atomic_wait(&gen->writer, 1);
+
+    atomic_store_explicit(&gen->writer, 0, memory_order_relaxed);
+}
+
+// Caller must hold the writer lock
+static void kdvd_settings_publish(kdvd_settings_t *settings, kdvd_settings_snapshot_t *snapshot) {
+    kdvd_settings_snapshot_t *old =
+        atomic_exchange_explicit(&settings->snapshot, snapshot, memory_order_seq_cst);
+    kdvd_settings_synchronize(settings);
+    free(old);
+
+    // Written strings the new values no longer use had no other reader
+    for (uint32_t i = 0; i < snapshot->count; i++) {
+        if (settings->owned_strings[i] &&
+            settings->owned_strings[i] != snapshot->entries[i].value.string_value) {
+            free(settings->owned_strings[i]);
+            settings->owned_strings[i] = NULL;
+        }
+    }
+}
+
+// Caller must hold the writer lock
+static void kdvd_settings_notify(kdvd_settings_t *settings, const char *name) {
+    kdvd_settings_listener_id *listener;
+    vlc_list_foreach(listener, &settings->listeners, node)
+        listener->cbs->on_changed(settings, name, listener->data);
+}
+
+// Returns a string that lives as long as the settings object, only for keys
+// and default values, which are bounded by the registered settings.
+// Caller must hold the writer lock.
+static const char *kdvd_settings_intern_string(kdvd_settings_t *settings, const char *str) {
+    size_t len = strlen(str) + 1;
+    kdvd_settings_chunk_t *chunk = settings->strings;
+
+    if (!chunk || chunk->size - chunk->used < len) {
+        size_t size = len > 4096 ? len : 4096;
+        chunk = malloc(sizeof(*chunk) + size);
+        if (!chunk) return NULL;
+        chunk->next = settings->strings;
+        chunk->used = 0;
+        chunk->size = size;
+        settings->strings = chunk;
+    }
+
+    char *copy = chunk->data + chunk->used;
+    memcpy(copy, str, len);
+    chunk->used += len;
+    return copy;
+}
+
+static bool kdvd_settings_is_string_type(kdvd_setting_type_t type) {
+    return type == EIGHTKDVD_SETTING_STRING || type == EIGHTKDVD_SETTING_PATH ||
+           type == EIGHTKDVD_SETTING_PASSWORD;
+}
+
+static bool kdvd_settings_is_uint_type(kdvd_setting_type_t type) {
+    return type == EIGHTKDVD_SETTING_ENUM || type == EIGHTKDVD_SETTING_COLOR;
+}
+
+// Same storage: accessors of one type can serve every type stored alike
+static bool kdvd_settings_types_compatible(kdvd_setting_type_t a, kdvd_setting_type_t b) {
+    if (a == b) return true;
+    if (kdvd_settings_is_string_type(a)) return kdvd_settings_is_string_type(b);
+    if (kdvd_settings_is_uint_type(a)) return kdvd_settings_is_uint_type(b);
+    return false;
+}
+
+// Caller must hold the writer lock
+static int kdvd_settings_scalar_from_value(kdvd_settings_t *settings, kdvd_setting_type_t type,
+                                           const kdvd_setting_value_t *value,
+                                           kdvd_settings_scalar_t *scalar) {
+    switch (type) {
+        case EIGHTKDVD_SETTING_BOOLEAN:
+            scalar->boolean_value = value->boolean_value;
+            break;
+        case EIGHTKDVD_SETTING_INTEGER:
+            scalar->integer_value = value->integer_value;
+            break;
+        case EIGHTKDVD_SETTING_FLOAT:
+            scalar->float_value = value->float_value;
+            break;
+        case EIGHTKDVD_SETTING_ENUM:
+            scalar->uint_value = value->enum_value;
+            break;
+        case EIGHTKDVD_SETTING_COLOR:
+            scalar->uint_value = value->color_value;
+            break;
+        case EIGHTKDVD_SETTING_STRING:
+        case EIGHTKDVD_SETTING_PATH:
+        case EIGHTKDVD_SETTING_PASSWORD: {
+            const char *str = type == EIGHTKDVD_SETTING_STRING ? value->string_value :
+                              type == EIGHTKDVD_SETTING_PATH ? value->path_value :
+                              value->password_value;
+            scalar->string_value = kdvd_settings_intern_string(settings, str);
+            if (!scalar->string_value) return -1;
+            break;
+        }
+        default:
+            return -1;
+    }
+    return 0;
+}
+
+// Reads one value without locking; name is used when key is invalid
+static bool kdvd_settings_read(kdvd_settings_t *settings, const char *name, kdvd_setting_key_t key,
+                               kdvd_setting_type_t type, kdvd_settings_scalar_t *value) {
+    struct kdvd_settings_generation *gen;
+    const kdvd_settings_snapshot_t *snapshot = kdvd_settings_read_lock(settings, &gen);
+
+    if (name)
+        key = kdvd_settings_snapshot_find(snapshot, name);
+
+    bool found = key >= 0 && (uint32_t)key < snapshot->count &&
+                 kdvd_settings_types_compatible(snapshot->entries[key].type, type);
+    if (found)
+        *value = snapshot->entries[key].value;
+
+    kdvd_settings_read_unlock(gen);
+    return found;
+}
+
+static int kdvd_settings_write(kdvd_settings_t *settings, const char *name,
+                               kdvd_setting_type_t type, kdvd_settings_scalar_t value) {
+    vlc_mutex_lock(&settings->writer_lock);
+
+    const kdvd_settings_snapshot_t *current =
+        atomic_load_explicit(&settings->snapshot, memory_order_relaxed);
+    kdvd_setting_key_t key = kdvd_settings_snapshot_find(current, name);
+    if (key < 0) {
+        vlc_mutex_unlock(&settings->writer_lock);
+        msg_Warn(settings->obj, "Setting not found: %s", name);
+        return -1;
+    }
+
+    const kdvd_setting_t *setting = &settings->settings[key];
+    if (!kdvd_settings_types_compatible(setting->type, type) || setting->readonly) {
+        vlc_mutex_unlock(&settings->writer_lock);
+        msg_Warn(settings->obj, "Setting cannot be written: %s", name);
+        settings->stats.settings_errors++;
+        return -1;
+    }
+
+    if (setting->type == EIGHTKDVD_SETTING_INTEGER &&
+        setting->min_value.integer_value < setting->max_value.integer_value &&
+        (value.integer_value < setting->min_value.integer_value ||
+         value.integer_value > setting->max_value.integer_value)) {
+        vlc_mutex_unlock(&settings->writer_lock);
+        msg_Warn(settings->obj, "Setting out of range: %s = %d", name, value.integer_value);
+        settings->stats.settings_errors++;
+        return -1;
+    }
+
+    // The setting owns its string until the next value replaces it
+    char *copy = NULL;
+    if (kdvd_settings_is_string_type(type)) {
+        copy = strdup(value.string_value);
+        if (!copy) {
+            vlc_mutex_unlock(&settings->writer_lock);
+            return -1;
+        }
+        value.string_value = copy;
+    }
+
+    kdvd_settings_snapshot_t *snapshot = kdvd_settings_snapshot_dup(current);
+    if (!snapshot) {
+        vlc_mutex_unlock(&settings->writer_lock);
+        free(copy);
+        return -1;
+    }
+
+    // Publishing reclaims the string being replaced
+    snapshot->entries[key].value = value;
+    kdvd_settings_publish(settings, snapshot);
+    if (copy)
+        settings->owned_strings[key] = copy;
+    kdvd_settings_notify(settings, snapshot->entries[key].name);
+
+    vlc_mutex_unlock(&settings->writer_lock);
+    return 0;
+}
+
+static void kdvd_settings_unmap_file(kdvd_settings_mapping_t *mapping) {
+    if (!mapping) return;
+
+#ifndef _WIN32
+    munmap(mapping->addr, mapping->size);
+#else
+    free(mapping->addr);
+#endif
+    free(mapping);
+}
+
+static bool kdvd_settings_mapping_contains(const kdvd_settings_mapping_t *mapping, const char *str) {
+    uintptr_t addr = (uintptr_t)mapping->addr;
+    return (uintptr_t)str >= addr && (uintptr_t)str < addr + mapping->size;
+}
+
 // 8KDVD Settings Functions
 kdvd_settings_t* kdvd_settings_create(vlc_object_t *obj) {
     kdvd_settings_t *settings = calloc(1, sizeof(kdvd_settings_t));
     if (!settings) return NULL;
-    
+
     settings->obj = obj;
     settings->initialized = false;
     settings->debug_enabled = false;
     settings->settings = NULL;
+    settings->defaults = NULL;
     settings->setting_count = 0;
     settings->profiles = NULL;
     settings->profile_count = 0;
     settings->settings_context = NULL;
     settings->start_time = 0;
     settings->memory_usage_mb = 0;
-    
+
     // Initialize stats
     memset(&settings->stats, 0, sizeof(kdvd_settings_stats_t));
-    
+
+    // Initialize the compiled table (empty until settings are registered)
+    kdvd_settings_snapshot_t *snapshot = kdvd_settings_snapshot_compile(NULL, 0);
+    if (!snapshot) {
+        free(settings);
+        return NULL;
+    }
+    atomic_init(&settings->snapshot, snapshot);
+    for (size_t i = 0; i < ARRAY_SIZE(settings->generations); i++) {
+        atomic_init(&settings->generations[i].readers, 0);
+        atomic_init(&settings->generations[i].writer, 0);
+    }
+    atomic_init(&settings->generation, &settings->generations[0]);
+    vlc_mutex_init(&settings->writer_lock);
+    settings->strings = NULL;
+    settings->owned_strings = NULL;
+    settings->mapping = NULL;
+    vlc_list_init(&settings->listeners);
+
+    // Built-in settings
+    kdvd_setting_t performance_mode = {
+        .name = "performance_mode",
+        .display_name = "Performance mode",
+        .description = "Playback performance trade-off: quality, balanced or speed",
+        .type = EIGHTKDVD_SETTING_STRING,
+        .category = EIGHTKDVD_SETTINGS_PERFORMANCE,
+        .default_value.string_value = "balanced",
+    };
+    if (kdvd_settings_register(settings, &performance_mode) != 0) {
+        kdvd_settings_destroy(settings);
+        return NULL;
+    }
+
     settings->initialized = true;
     settings->start_time = vlc_tick_now();
-    
+
     msg_Info(obj, "8KDVD settings created");
     return settings;
 }
 
 void kdvd_settings_destroy(kdvd_settings_t *settings) {
     if (!settings) return;
-    
+
+    msg_Info(settings->obj, "8KDVD settings destroyed");
+
+    // No readers may remain at this point
+    free(atomic_load_explicit(&settings->snapshot, memory_order_relaxed));
+
+    kdvd_settings_listener_id *listener;
+    vlc_list_foreach(listener, &settings->listeners, node)
+        free(listener);
+
+    while (settings->strings) {
+        kdvd_settings_chunk_t *next = settings->strings->next;
+        free(settings->strings);
+        settings->strings = next;
+    }
+
+    if (settings->owned_strings) {
+        for (uint32_t i = 0; i < settings->setting_count; i++)
+            free(settings->owned_strings[i]);
+        free(settings->owned_strings);
+    }
+
+    kdvd_settings_unmap_file(settings->mapping);
+
     if (settings->settings) {
         free(settings->settings);
     }
-    
+
+    free(settings->defaults);
+
     if (settings->profiles) {
         free(settings->profiles);
     }
-    
+
     if (settings->settings_context) {
         free(settings->settings_context);
     }
-    
+
     free(settings);
-    msg_Info(settings->obj, "8KDVD settings destroyed");
+}
+
+int kdvd_settings_register(kdvd_settings_t *settings, const kdvd_setting_t *setting) {
+    if (!settings || !setting || !setting->name[0]) return -1;
+
+    vlc_mutex_lock(&settings->writer_lock);
+
+    const kdvd_settings_snapshot_t *current =
+        atomic_load_explicit(&settings->snapshot, memory_order_relaxed);
+    if (kdvd_settings_snapshot_find(current, setting->name) >= 0) {
+        vlc_mutex_unlock(&settings->writer_lock);
+        msg_Err(settings->obj, "Setting already registered: %s", setting->name);
+        return -1;
+    }
+
+    uint32_t count = settings->setting_count;
+    kdvd_setting_t *schema = realloc(settings->settings, (count + 1) * sizeof(*schema));
+    if (schema) settings->settings = schema;
+    kdvd_settings_scalar_t *defaults = realloc(settings->defaults, (count + 1) * sizeof(*defaults));
+    if (defaults) settings->defaults = defaults;
+    char **owned_strings = realloc(settings->owned_strings, (count + 1) * sizeof(*owned_strings));
+    if (owned_strings) {
+        settings->owned_strings = owned_strings;
+        owned_strings[count] = NULL;
+    }
+    kdvd_settings_entry_t *entries = malloc((count + 1) * sizeof(*entries));
+
+    kdvd_settings_snapshot_t *snapshot = NULL;
+    const char *name = NULL;
+    if (schema && defaults && owned_strings && entries &&
+        kdvd_settings_scalar_from_value(settings, setting->type, &setting->default_value,
+                                        &defaults[count]) == 0 &&
+        (name = kdvd_settings_intern_string(settings, setting->name)) != NULL) {
+        // Keys are appended: previously interned keys stay valid
+        if (count > 0)
+            memcpy(entries, current->entries, count * sizeof(*entries));
+        entries[count].name = name;
+        entries[count].type = setting->type;
+        entries[count].value = defaults[count];
+        snapshot = kdvd_settings_snapshot_compile(entries, count + 1);
+    }
+    free(entries);
+
+    if (!snapshot) {
+        vlc_mutex_unlock(&settings->writer_lock);
+        msg_Err(settings->obj, "Failed to register setting: %s", setting->name);
+        return -1;
+    }
+
+    schema[count] = *setting;
+    settings->setting_count = count + 1;
+    snapshot->version = current->version + 1;
+    kdvd_settings_publish(settings, snapshot);
+
+    vlc_mutex_unlock(&settings->writer_lock);
+
+    if (settings->debug_enabled) {
+        msg_Dbg(settings->obj, "Setting registered: %s", setting->name);
+    }
+    return 0;
+}
+
+kdvd_setting_key_t kdvd_settings_intern(kdvd_settings_t *settings, const char *name) {
+    if (!settings || !name) return KDVD_SETTING_KEY_INVALID;
+
+    struct kdvd_settings_generation *gen;
+    const kdvd_settings_snapshot_t *snapshot = kdvd_settings_read_lock(settings, &gen);
+    kdvd_setting_key_t key = kdvd_settings_snapshot_find(snapshot, name);
+    kdvd_settings_read_unlock(gen);
+    return key;
+}
+
+kdvd_settings_listener_id* kdvd_settings_add_listener(kdvd_settings_t *settings,
+                                                      const kdvd_settings_callbacks_t *cbs,
+                                                      void *data) {
+    if (!settings || !cbs || !cbs->on_changed) return NULL;
+
+    kdvd_settings_listener_id *listener = malloc(sizeof(*listener));
+    if (!listener) return NULL;
+
+    listener->cbs = cbs;
+    listener->data = data;
+
+    vlc_mutex_lock(&settings->writer_lock);
+    vlc_list_append(&listener->node, &settings->listeners);
+    vlc_mutex_unlock(&settings->writer_lock);
+    return listener;
+}
+
+void kdvd_settings_remove_listener(kdvd_settings_t *settings, kdvd_settings_listener_id *listener) {
+    if (!settings || !listener) return;
+
+    vlc_mutex_lock(&settings->writer_lock);
+    vlc_list_remove(&listener->node);
+    vlc_mutex_unlock(&settings->writer_lock);
+    free(listener);
+}
+
+// Maps a snapshot file and checks it; the mapping is returned in *mappingp
+static const kdvd_settings_file_header_t *kdvd_settings_map_file(kdvd_settings_t *settings, const char *path,
+                                                                 kdvd_settings_mapping_t **mappingp) {
+    int fd = vlc_open(path, O_RDONLY);
+    if (fd == -1) {
+        msg_Err(settings->obj, "Cannot open settings file %s: %s", path, vlc_strerror_c(errno));
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < sizeof(kdvd_settings_file_header_t) ||
+        (uint64_t)st.st_size > UINT32_MAX) {
+        vlc_close(fd);
+        msg_Err(settings->obj, "Invalid settings file: %s", path);
+        return NULL;
+    }
+
+    size_t size = st.st_size;
+#ifndef _WIN32
+    void *addr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) addr = NULL;
+#else
+    void *addr = malloc(size);
+    if (addr && read(fd, addr, size) != (ssize_t)size) {
+        free(addr);
+        addr = NULL;
+    }
+#endif
+    vlc_close(fd);
+    if (!addr) {
+        msg_Err(settings->obj, "Cannot map settings file: %s", path);
+        return NULL;
+    }
+
+    kdvd_settings_mapping_t *mapping = malloc(sizeof(*mapping));
+    if (mapping) {
+        mapping->addr = addr;
+        mapping->size = size;
+    }
+
+    const kdvd_settings_file_header_t *header = addr;
+    const char *strings = (const char *)addr + sizeof(*header) +
+                          (size_t)header->record_count * sizeof(kdvd_settings_file_record_t);
+    bool valid = mapping &&
+                 header->magic == KDVD_SETTINGS_FILE_MAGIC &&
+                 header->version == KDVD_SETTINGS_FILE_VERSION &&
+                 header->record_size == sizeof(kdvd_settings_file_record_t) &&
+                 header->strings_size > 0 &&
+                 (uint64_t)header->record_count * sizeof(kdvd_settings_file_record_t) +
+                     sizeof(*header) + header->strings_size == size &&
+                 strings[header->strings_size - 1] == '\0';
+    if (!valid) {
+        msg_Err(settings->obj, "Unsupported or corrupted settings file: %s", path);
+#ifndef _WIN32
+        munmap(addr, size);
+#else
+        free(addr);
+#endif
+        free(mapping);
+        return NULL;
+    }
+
+    *mappingp = mapping;
+    return header;
+}
+
+// Applies a snapshot file to the current values; strings are used in place
+static int kdvd_settings_read_file(kdvd_settings_t *settings, const char *path) {
+    kdvd_settings_mapping_t *mapping;
+    const kdvd_settings_file_header_t *header = kdvd_settings_map_file(settings, path, &mapping);
+    if (!header) return -1;
+
+    const kdvd_settings_file_record_t *records = (const void *)(header + 1);
+    const char *strings = (const char *)(records + header->record_count);
+
+    vlc_mutex_lock(&settings->writer_lock);
+
+    kdvd_settings_snapshot_t *snapshot =
+        kdvd_settings_snapshot_dup(atomic_load_explicit(&settings->snapshot, memory_order_relaxed));
+    char **copies = snapshot ? calloc(snapshot->count + 1, sizeof(*copies)) : NULL;
+    if (!copies) {
+        vlc_mutex_unlock(&settings->writer_lock);
+        free(snapshot);
+        kdvd_settings_unmap_file(mapping);
+        return -1;
+    }
+
+    uint32_t applied = 0;
+    for (uint32_t i = 0; i < header->record_count; i++) {
+        const kdvd_settings_file_record_t *record = &records[i];
+        if (record->name_offset >= header->strings_size)
+            continue;
+
+        // Unknown keys come from newer or other builds: skip them
+        kdvd_setting_key_t key = kdvd_settings_snapshot_find(snapshot, strings + record->name_offset);
+        if (key < 0 || snapshot->entries[key].type != record->type || settings->settings[key].readonly)
+            continue;
+
+        kdvd_settings_scalar_t *value = &snapshot->entries[key].value;
+        switch (record->type) {
+            case EIGHTKDVD_SETTING_BOOLEAN:
+                value->boolean_value = record->uint_value != 0;
+                break;
+            case EIGHTKDVD_SETTING_INTEGER:
+                value->integer_value = record->integer_value;
+                break;
+            case EIGHTKDVD_SETTING_FLOAT:
+                value->float_value = record->float_value;
+                break;
+            case EIGHTKDVD_SETTING_ENUM:
+            case EIGHTKDVD_SETTING_COLOR:
+                value->uint_value = record->uint_value;
+                break;
+            default:
+                if (record->string_offset >= header->strings_size)
+                    continue;
+                value->string_value = strings + record->string_offset;
+                break;
+        }
+        applied++;
+    }
+
+    // Only the new file stays mapped: the values it does not set and that
+    // still come from the previous one are copied out of it
+    kdvd_settings_mapping_t *previous = settings->mapping;
+    for (uint32_t i = 0; previous && i < snapshot->count; i++) {
+        if (!kdvd_settings_is_string_type(snapshot->entries[i].type) ||
+            !kdvd_settings_mapping_contains(previous, snapshot->entries[i].value.string_value))
+            continue;
+
+        copies[i] = strdup(snapshot->entries[i].value.string_value);
+        if (!copies[i]) {
+            vlc_mutex_unlock(&settings->writer_lock);
+            for (uint32_t j = 0; j < i; j++)
+                free(copies[j]);
+            free(copies);
+            free(snapshot);
+            kdvd_settings_unmap_file(mapping);
+            return -1;
+        }
+        snapshot->entries[i].value.string_value = copies[i];
+    }
+
+    kdvd_settings_publish(settings, snapshot);
+    for (uint32_t i = 0; i < snapshot->count; i++) {
+        if (copies[i])
+            settings->owned_strings[i] = copies[i];
+    }
+    free(copies);
+
+    // No reader of the previous values remains after the publication
+    settings->mapping = mapping;
+    kdvd_settings_unmap_file(previous);
+
+    kdvd_settings_notify(settings, NULL);
+    vlc_mutex_unlock(&settings->writer_lock);
+
+    if (settings->debug_enabled) {
+        msg_Dbg(settings->obj, "Applied %u of %u settings from %s", applied, header->record_count, path);
+    }
+    return 0;
+}
+
+// Writes the current values as a snapshot file, atomically replacing path
+static int kdvd_settings_write_file(kdvd_settings_t *settings, const char *path) {
+    struct kdvd_settings_generation *gen;
+    const kdvd_settings_snapshot_t *snapshot = kdvd_settings_read_lock(settings, &gen);
+
+    size_t strings_size = 0;
+    for (uint32_t i = 0; i < snapshot->count; i++) {
+        strings_size += strlen(snapshot->entries[i].name) + 1;
+        if (kdvd_settings_is_string_type(snapshot->entries[i].type))
+            strings_size += strlen(snapshot->entries[i].value.string_value) + 1;
+    }
+    if (strings_size == 0)
+        strings_size = 1; // Keep the pool NUL-terminated
+
+    size_t records_size = snapshot->count * sizeof(kdvd_settings_file_record_t);
+    size_t size = sizeof(kdvd_settings_file_header_t) + records_size + strings_size;
+    uint8_t *buffer = calloc(1, size);
+    if (!buffer) {
+        kdvd_settings_read_unlock(gen);
+        return -1;
+    }
+
+    kdvd_settings_file_header_t *header = (void *)buffer;
+    kdvd_settings_file_record_t *records = (void *)(header + 1);
+    char *strings = (char *)(records + snapshot->count);
+    size_t offset = 0;
+
+    header->magic = KDVD_SETTINGS_FILE_MAGIC;
+    header->version = KDVD_SETTINGS_FILE_VERSION;
+    header->record_size = sizeof(kdvd_settings_file_record_t);
+    header->record_count = snapshot->count;
+    header->strings_size = strings_size;
+    header->modified_date = time(NULL);
+
+    for (uint32_t i = 0; i < snapshot->count; i++) {
+        const kdvd_settings_entry_t *entry = &snapshot->entries[i];
+        size_t len = strlen(entry->name) + 1;
+
+        records[i].name_offset = offset;
+        records[i].type = entry->type;
+        memcpy(strings + offset, entry->name, len);
+        offset += len;
+
+        switch (entry->type) {
+            case EIGHTKDVD_SETTING_BOOLEAN:
+                records[i].uint_value = entry->value.boolean_value;
+                break;
+            case EIGHTKDVD_SETTING_INTEGER:
+                records[i].integer_value = entry->value.integer_value;
+                break;
+            case EIGHTKDVD_SETTING_FLOAT:
+                records[i].float_value = entry->value.float_value;
+                break;
+            case EIGHTKDVD_SETTING_ENUM:
+            case EIGHTKDVD_SETTING_COLOR:
+                records[i].uint_value = entry->value.uint_value;
+                break;
+            default:
+                len = strlen(entry->value.string_value) + 1;
+                records[i].string_offset = offset;
+                memcpy(strings + offset, entry->value.string_value, len);
+                offset += len;
+                break;
+        }
+    }
+
+    kdvd_settings_read_unlock(gen);
+
+    char *tmp_path;
+    if (asprintf(&tmp_path, "%s.tmp", path) == -1) {
+        free(buffer);
+        return -1;
+    }
+
+    int ret = -1;
+    FILE *file = vlc_fopen(tmp_path, "wb");
+    if (file) {
+        bool written = fwrite(buffer, 1, size, file) == size;
+        if (fclose(file) == 0 && written && vlc_rename(tmp_path, path) == 0)
+            ret = 0;
+        else
+            vlc_unlink(tmp_path);
+    }
+
+    if (ret != 0) {
+        msg_Err(settings->obj, "Cannot write settings file %s: %s", path, vlc_strerror_c(errno));
+    }
+
+    free(tmp_path);
+    free(buffer);
+    return ret;
 }
 
 int kdvd_settings_load(kdvd_settings_t *settings, const char *config_path) {
     if (!settings || !config_path) return -1;
-    
+
     msg_Info(settings->obj, "Loading settings from: %s", config_path);
-    
+
     uint64_t load_start = vlc_tick_now();
-    
+
     // Check if config path exists
     if (vlc_access(config_path, R_OK) != 0) {
         msg_Err(settings->obj, "Config path not found: %s", config_path);
         return -1;
     }
-    
-    // Simulate settings loading
-    if (settings->debug_enabled) {
-        msg_Dbg(settings->obj, "Loading settings from: %s", config_path);
-        msg_Dbg(settings->obj, "Parsing settings file");
-        msg_Dbg(settings->obj, "Validating settings");
+
+    if (kdvd_settings_read_file(settings, config_path) != 0) {
+        settings->stats.settings_errors++;
+        return -1;
     }
-    
+
     strncpy(settings->config_path, config_path, sizeof(settings->config_path) - 1);
     settings->config_path[sizeof(settings->config_path) - 1] = '\0';
-    
+
     // Update statistics
     settings->stats.settings_loaded++;
-    
+
     uint64_t load_time = vlc_tick_now() - load_start;
     settings->stats.average_load_time = (settings->stats.average_load_time + (float)load_time / 1000.0f) / 2.0f;
-    
+
     if (settings->debug_enabled) {
         msg_Dbg(settings->obj, "Settings loaded in %llu us", load_time);
     }
-    
+
     msg_Info(settings->obj, "Settings loaded successfully: %s", config_path);
     return 0;
 }
 
 int kdvd_settings_save(kdvd_settings_t *settings, const char *config_path) {
     if (!settings || !config_path) return -1;
-    
+
     msg_Info(settings->obj, "Saving settings to: %s", config_path);
-    
+
     uint64_t save_start = vlc_tick_now();
-    
-    // Simulate settings saving
-    if (settings->debug_enabled) {
-        msg_Dbg(settings->obj, "Saving settings to: %s", config_path);
-        msg_Dbg(settings->obj, "Serializing settings");
-        msg_Dbg(settings->obj, "Writing settings file");
+
+    if (kdvd_settings_write_file(settings, config_path) != 0) {
+        settings->stats.settings_errors++;
+        return -1;
     }
-    
+
     // Update statistics
     settings->stats.settings_saved++;
-    
+
     uint64_t save_time = vlc_tick_now() - save_start;
     settings->stats.average_save_time = (settings->stats.average_save_time + (float)save_time / 1000.0f) / 2.0f;
-    
+
     if (settings->debug_enabled) {
         msg_Dbg(settings->obj, "Settings saved in %llu us", save_time);
     }
-    
+
     msg_Info(settings->obj, "Settings saved successfully: %s", config_path);
     return 0;
 }
 
 int kdvd_settings_reset(kdvd_settings_t *settings) {
     if (!settings) return -1;
-    
+
     msg_Info(settings->obj, "Resetting settings to defaults");
-    
+
+    vlc_mutex_lock(&settings->writer_lock);
+
+    kdvd_settings_snapshot_t *snapshot =
+        kdvd_settings_snapshot_dup(atomic_load_explicit(&settings->snapshot, memory_order_relaxed));
+    if (!snapshot) {
+        vlc_mutex_unlock(&settings->writer_lock);
+        return -1;
+    }
+
     // Reset all settings to default values
     for (uint32_t i = 0; i < settings->setting_count; i++) {
-        settings->settings[i].current_value = settings->settings[i].default_value;
+        snapshot->entries[i].value = settings->defaults[i];
     }
-    
+
+    kdvd_settings_publish(settings, snapshot);
+    kdvd_settings_notify(settings, NULL);
+    vlc_mutex_unlock(&settings->writer_lock);
+
     // Update statistics
     settings->stats.settings_reset++;
-    
+
     if (settings->debug_enabled) {
         msg_Dbg(settings->obj, "Settings reset to defaults");
     }
-    
+
     msg_Info(settings->obj, "Settings reset successfully");
     return 0;
 }
@@ -177,102 +1089,162 @@ int kdvd_settings_validate(kdvd_settings_t *settings) {
     msg_Info(settings->obj, "Settings validation successful");
     return 0;
 }
-
 int kdvd_settings_set_boolean(kdvd_settings_t *settings, const char *name, bool value) {
     if (!settings || !name) return -1;
-    
+
     if (settings->debug_enabled) {
         msg_Dbg(settings->obj, "Setting boolean: %s = %s", name, value ? "true" : "false");
     }
-    
-    // Find and update setting
-    for (uint32_t i = 0; i < settings->setting_count; i++) {
-        if (strcmp(settings->settings[i].name, name) == 0) {
-            settings->settings[i].current_value.boolean_value = value;
-            return 0;
-        }
-    }
-    
-    msg_Warn(settings->obj, "Setting not found: %s", name);
-    return -1;
+
+    kdvd_settings_scalar_t scalar = { .boolean_value = value };
+    return kdvd_settings_write(settings, name, EIGHTKDVD_SETTING_BOOLEAN, scalar);
 }
 
 bool kdvd_settings_get_boolean(kdvd_settings_t *settings, const char *name) {
     if (!settings || !name) return false;
-    
-    // Find setting
-    for (uint32_t i = 0; i < settings->setting_count; i++) {
-        if (strcmp(settings->settings[i].name, name) == 0) {
-            return settings->settings[i].current_value.boolean_value;
-        }
-    }
-    
-    return false;
+
+    kdvd_settings_scalar_t value;
+    return kdvd_settings_read(settings, name, KDVD_SETTING_KEY_INVALID, EIGHTKDVD_SETTING_BOOLEAN, &value)
+           ? value.boolean_value : false;
 }
 
 int kdvd_settings_set_integer(kdvd_settings_t *settings, const char *name, int32_t value) {
     if (!settings || !name) return -1;
-    
+
     if (settings->debug_enabled) {
         msg_Dbg(settings->obj, "Setting integer: %s = %d", name, value);
     }
-    
-    // Find and update setting
-    for (uint32_t i = 0; i < settings->setting_count; i++) {
-        if (strcmp(settings->settings[i].name, name) == 0) {
-            settings->settings[i].current_value.integer_value = value;
-            return 0;
-        }
-    }
-    
-    msg_Warn(settings->obj, "Setting not found: %s", name);
-    return -1;
+
+    kdvd_settings_scalar_t scalar = { .integer_value = value };
+    return kdvd_settings_write(settings, name, EIGHTKDVD_SETTING_INTEGER, scalar);
 }
 
 int32_t kdvd_settings_get_integer(kdvd_settings_t *settings, const char *name) {
     if (!settings || !name) return 0;
-    
-    // Find setting
-    for (uint32_t i = 0; i < settings->setting_count; i++) {
-        if (strcmp(settings->settings[i].name, name) == 0) {
-            return settings->settings[i].current_value.integer_value;
-        }
+
+    kdvd_settings_scalar_t value;
+    return kdvd_settings_read(settings, name, KDVD_SETTING_KEY_INVALID, EIGHTKDVD_SETTING_INTEGER, &value)
+           ? value.integer_value : 0;
+}
+
+int kdvd_settings_set_float(kdvd_settings_t *settings, const char *name, float value) {
+    if (!settings || !name) return -1;
+
+    if (settings->debug_enabled) {
+        msg_Dbg(settings->obj, "Setting float: %s = %f", name, value);
     }
-    
-    return 0;
+
+    kdvd_settings_scalar_t scalar = { .float_value = value };
+    return kdvd_settings_write(settings, name, EIGHTKDVD_SETTING_FLOAT, scalar);
+}
+
+float kdvd_settings_get_float(kdvd_settings_t *settings, const char *name) {
+    if (!settings || !name) return 0.0f;
+
+    kdvd_settings_scalar_t value;
+    return kdvd_settings_read(settings, name, KDVD_SETTING_KEY_INVALID, EIGHTKDVD_SETTING_FLOAT, &value)
+           ? value.float_value : 0.0f;
+}
+
+int kdvd_settings_set_enum(kdvd_settings_t *settings, const char *name, uint32_t value) {
+    if (!settings || !name) return -1;
+
+    kdvd_settings_scalar_t scalar = { .uint_value = value };
+    return kdvd_settings_write(settings, name, EIGHTKDVD_SETTING_ENUM, scalar);
+}
+
+uint32_t kdvd_settings_get_enum(kdvd_settings_t *settings, const char *name) {
+    if (!settings || !name) return 0;
+
+    kdvd_settings_scalar_t value;
+    return kdvd_settings_read(settings, name, KDVD_SETTING_KEY_INVALID, EIGHTKDVD_SETTING_ENUM, &value)
+           ? value.uint_value : 0;
+}
+
+int kdvd_settings_set_color(kdvd_settings_t *settings, const char *name, uint32_t value) {
+    if (!settings || !name) return -1;
+
+    kdvd_settings_scalar_t scalar = { .uint_value = value };
+    return kdvd_settings_write(settings, name, EIGHTKDVD_SETTING_COLOR, scalar);
+}
+
+uint32_t kdvd_settings_get_color(kdvd_settings_t *settings, const char *name) {
+    if (!settings || !name) return 0;
+
+    kdvd_settings_scalar_t value;
+    return kdvd_settings_read(settings, name, KDVD_SETTING_KEY_INVALID, EIGHTKDVD_SETTING_COLOR, &value)
+           ? value.uint_value : 0;
 }
 
 int kdvd_settings_set_string(kdvd_settings_t *settings, const char *name, const char *value) {
     if (!settings || !name || !value) return -1;
-    
+
     if (settings->debug_enabled) {
         msg_Dbg(settings->obj, "Setting string: %s = %s", name, value);
     }
-    
-    // Find and update setting
-    for (uint32_t i = 0; i < settings->setting_count; i++) {
-        if (strcmp(settings->settings[i].name, name) == 0) {
-            strncpy(settings->settings[i].current_value.string_value, value, sizeof(settings->settings[i].current_value.string_value) - 1);
-            settings->settings[i].current_value.string_value[sizeof(settings->settings[i].current_value.string_value) - 1] = '\0';
-            return 0;
-        }
-    }
-    
-    msg_Warn(settings->obj, "Setting not found: %s", name);
-    return -1;
+
+    kdvd_settings_scalar_t scalar = { .string_value = value };
+    return kdvd_settings_write(settings, name, EIGHTKDVD_SETTING_STRING, scalar);
 }
 
 const char* kdvd_settings_get_string(kdvd_settings_t *settings, const char *name) {
     if (!settings || !name) return NULL;
-    
-    // Find setting
-    for (uint32_t i = 0; i < settings->setting_count; i++) {
-        if (strcmp(settings->settings[i].name, name) == 0) {
-            return settings->settings[i].current_value.string_value;
-        }
-    }
-    
-    return NULL;
+
+    kdvd_settings_scalar_t value;
+    return kdvd_settings_read(settings, name, KDVD_SETTING_KEY_INVALID, EIGHTKDVD_SETTING_STRING, &value)
+           ? value.string_value : NULL;
+}
+
+int kdvd_settings_set_path(kdvd_settings_t *settings, const char *name, const char *value) {
+    if (!settings || !name || !value) return -1;
+
+    kdvd_settings_scalar_t scalar = { .string_value = value };
+    return kdvd_settings_write(settings, name, EIGHTKDVD_SETTING_PATH, scalar);
+}
+
+const char* kdvd_settings_get_path(kdvd_settings_t *settings, const char *name) {
+    return kdvd_settings_get_string(settings, name);
+}
+
+int kdvd_settings_set_password(kdvd_settings_t *settings, const char *name, const char *value) {
+    if (!settings || !name || !value) return -1;
+
+    kdvd_settings_scalar_t scalar = { .string_value = value };
+    return kdvd_settings_write(settings, name, EIGHTKDVD_SETTING_PASSWORD, scalar);
+}
+
+const char* kdvd_settings_get_password(kdvd_settings_t *settings, const char *name) {
+    return kdvd_settings_get_string(settings, name);
+}
+
+bool kdvd_settings_get_boolean_key(kdvd_settings_t *settings, kdvd_setting_key_t key) {
+    kdvd_settings_scalar_t value;
+    return settings && kdvd_settings_read(settings, NULL, key, EIGHTKDVD_SETTING_BOOLEAN, &value)
+           ? value.boolean_value : false;
+}
+
+int32_t kdvd_settings_get_integer_key(kdvd_settings_t *settings, kdvd_setting_key_t key) {
+    kdvd_settings_scalar_t value;
+    return settings && kdvd_settings_read(settings, NULL, key, EIGHTKDVD_SETTING_INTEGER, &value)
+           ? value.integer_value : 0;
+}
+
+float kdvd_settings_get_float_key(kdvd_settings_t *settings, kdvd_setting_key_t key) {
+    kdvd_settings_scalar_t value;
+    return settings && kdvd_settings_read(settings, NULL, key, EIGHTKDVD_SETTING_FLOAT, &value)
+           ? value.float_value : 0.0f;
+}
+
+uint32_t kdvd_settings_get_enum_key(kdvd_settings_t *settings, kdvd_setting_key_t key) {
+    kdvd_settings_scalar_t value;
+    return settings && kdvd_settings_read(settings, NULL, key, EIGHTKDVD_SETTING_ENUM, &value)
+           ? value.uint_value : 0;
+}
+
+const char* kdvd_settings_get_string_key(kdvd_settings_t *settings, kdvd_setting_key_t key) {
+    kdvd_settings_scalar_t value;
+    return settings && kdvd_settings_read(settings, NULL, key, EIGHTKDVD_SETTING_STRING, &value)
+           ? value.string_value : NULL;
 }
 
 int kdvd_settings_create_profile(kdvd_settings_t *settings, const char *profile_name, const char *description) {
@@ -318,72 +1290,117 @@ int kdvd_settings_create_profile(kdvd_settings_t *settings, const char *profile_
     msg_Info(settings->obj, "Settings profile created successfully: %s", profile_name);
     return 0;
 }
+// Profiles are stored next to the main configuration file
+static char *kdvd_settings_profile_path(kdvd_settings_t *settings, const char *profile_name) {
+    if (!settings->config_path[0]) return NULL;
+
+    char *path;
+    if (asprintf(&path, "%s.%s", settings->config_path, profile_name) == -1)
+        return NULL;
+    return path;
+}
 
 int kdvd_settings_load_profile(kdvd_settings_t *settings, const char *profile_name) {
     if (!settings || !profile_name) return -1;
-    
+
     msg_Info(settings->obj, "Loading settings profile: %s", profile_name);
-    
+
     // Find profile
     for (uint32_t i = 0; i < settings->profile_count; i++) {
         if (strcmp(settings->profiles[i].name, profile_name) == 0) {
-            // Load profile settings
+            // Load profile settings, a profile never saved keeps the current values
+            char *path = kdvd_settings_profile_path(settings, profile_name);
+            if (path && vlc_access(path, R_OK) == 0 && kdvd_settings_read_file(settings, path) != 0) {
+                free(path);
+                settings->stats.settings_errors++;
+                return -1;
+            }
+            free(path);
+
             strncpy(settings->current_profile, profile_name, sizeof(settings->current_profile) - 1);
             settings->current_profile[sizeof(settings->current_profile) - 1] = '\0';
-            
+
             if (settings->debug_enabled) {
                 msg_Dbg(settings->obj, "Profile loaded: %s", profile_name);
             }
-            
+
             msg_Info(settings->obj, "Settings profile loaded successfully: %s", profile_name);
             return 0;
         }
     }
-    
+
+    msg_Err(settings->obj, "Profile not found: %s", profile_name);
+    return -1;
+}
+
+int kdvd_settings_save_profile(kdvd_settings_t *settings, const char *profile_name) {
+    if (!settings || !profile_name) return -1;
+
+    msg_Info(settings->obj, "Saving settings profile: %s", profile_name);
+
+    for (uint32_t i = 0; i < settings->profile_count; i++) {
+        if (strcmp(settings->profiles[i].name, profile_name) == 0) {
+            char *path = kdvd_settings_profile_path(settings, profile_name);
+            if (!path) {
+                msg_Err(settings->obj, "No configuration path to save profile: %s", profile_name);
+                return -1;
+            }
+
+            int ret = kdvd_settings_write_file(settings, path);
+            free(path);
+            if (ret != 0) {
+                settings->stats.settings_errors++;
+                return -1;
+            }
+
+            settings->profiles[i].modified_date = time(NULL);
+            settings->profiles[i].setting_count = settings->setting_count;
+
+            msg_Info(settings->obj, "Settings profile saved successfully: %s", profile_name);
+            return 0;
+        }
+    }
+
     msg_Err(settings->obj, "Profile not found: %s", profile_name);
     return -1;
 }
 
 int kdvd_settings_import(kdvd_settings_t *settings, const char *import_path) {
     if (!settings || !import_path) return -1;
-    
+
     msg_Info(settings->obj, "Importing settings from: %s", import_path);
-    
+
     // Check if import path exists
     if (vlc_access(import_path, R_OK) != 0) {
         msg_Err(settings->obj, "Import path not found: %s", import_path);
         return -1;
     }
-    
-    // Simulate settings import
-    if (settings->debug_enabled) {
-        msg_Dbg(settings->obj, "Importing settings from: %s", import_path);
-        msg_Dbg(settings->obj, "Parsing import file");
-        msg_Dbg(settings->obj, "Validating imported settings");
+
+    if (kdvd_settings_read_file(settings, import_path) != 0) {
+        settings->stats.settings_errors++;
+        return -1;
     }
-    
+
     // Update statistics
     settings->stats.settings_imported++;
-    
+
     msg_Info(settings->obj, "Settings imported successfully: %s", import_path);
     return 0;
 }
 
 int kdvd_settings_export(kdvd_settings_t *settings, const char *export_path) {
     if (!settings || !export_path) return -1;
-    
+
     msg_Info(settings->obj, "Exporting settings to: %s", export_path);
-    
-    // Simulate settings export
-    if (settings->debug_enabled) {
-        msg_Dbg(settings->obj, "Exporting settings to: %s", export_path);
-        msg_Dbg(settings->obj, "Serializing settings");
-        msg_Dbg(settings->obj, "Writing export file");
+
+    if (kdvd_settings_write_file(settings, export_path) != 0) {
+        settings->stats.settings_errors++;
+        return -1;
     }
-    
+
     // Update statistics
     settings->stats.settings_exported++;
-    
+
     msg_Info(settings->obj, "Settings exported successfully: %s", export_path);
     return 0;
 }
@@ -428,7 +1445,9 @@ int kdvd_settings_set_performance_mode(kdvd_settings_t *settings, const char *mo
         return -1;
     }
     
-    return 0;
+    // Stored as a regular setting: playback reads it lock-free and
+    // listeners are notified of the change
+    return kdvd_settings_set_string(settings, "performance_mode", mode);
 }
 
 int kdvd_settings_allocate_buffers(kdvd_settings_t *settings) {
@@ -101,17 +101,39 @@ typedef struct kdvd_settings_stats_t {
     uint32_t memory_usage_mb;       // Memory usage in MB
 } kdvd_settings_stats_t;
 
+// Interned setting key: index into the compiled settings table, stable for
+// the lifetime of the settings object once the setting is registered
+typedef int32_t kdvd_setting_key_t;
+#define KDVD_SETTING_KEY_INVALID (-1)
+
+// Change notification
+typedef struct kdvd_settings_listener_id kdvd_settings_listener_id;
+
+typedef struct kdvd_settings_callbacks_t {
+    // name is NULL when several settings changed at once (load, reset,
+    // profile or import); called with the settings writer lock held, so the
+    // callback may read but must not modify settings
+    void (*on_changed)(kdvd_settings_t *settings, const char *name, void *data);
+} kdvd_settings_callbacks_t;
+
 // 8KDVD Settings Functions
 kdvd_settings_t* kdvd_settings_create(vlc_object_t *obj);
 void kdvd_settings_destroy(kdvd_settings_t *settings);
 
 // Settings Management
+// Settings persist as a versioned binary snapshot, mapped in place on load
 int kdvd_settings_load(kdvd_settings_t *settings, const char *config_path);
 int kdvd_settings_save(kdvd_settings_t *settings, const char *config_path);
 int kdvd_settings_reset(kdvd_settings_t *settings);
 int kdvd_settings_validate(kdvd_settings_t *settings);
 
+// Setting Registration
+int kdvd_settings_register(kdvd_settings_t *settings, const kdvd_setting_t *setting);
+kdvd_setting_key_t kdvd_settings_intern(kdvd_settings_t *settings, const char *name);
+
 // Setting Operations
+// Getters never lock; returned strings stay valid until the setting is
+// written again, or until settings are loaded, imported or reset
 int kdvd_settings_set_boolean(kdvd_settings_t *settings, const char *name, bool value);
 int kdvd_settings_set_integer(kdvd_settings_t *settings, const char *name, int32_t value);
 int kdvd_settings_set_float(kdvd_settings_t *settings, const char *name, float value);
@@ -130,6 +152,19 @@ uint32_t kdvd_settings_get_color(kdvd_settings_t *settings, const char *name);
 const char* kdvd_settings_get_path(kdvd_settings_t *settings, const char *name);
 const char* kdvd_settings_get_password(kdvd_settings_t *settings, const char *name);
 
+// Interned-key getters for hot paths (no hashing, no string compare)
+bool kdvd_settings_get_boolean_key(kdvd_settings_t *settings, kdvd_setting_key_t key);
+int32_t kdvd_settings_get_integer_key(kdvd_settings_t *settings, kdvd_setting_key_t key);
+float kdvd_settings_get_float_key(kdvd_settings_t *settings, kdvd_setting_key_t key);
+uint32_t kdvd_settings_get_enum_key(kdvd_settings_t *settings, kdvd_setting_key_t key);
+const char* kdvd_settings_get_string_key(kdvd_settings_t *settings, kdvd_setting_key_t key);
+
+// Change Notification
+kdvd_settings_listener_id* kdvd_settings_add_listener(kdvd_settings_t *settings,
+                                                      const kdvd_settings_callbacks_t *cbs,
+                                                      void *data);
+void kdvd_settings_remove_listener(kdvd_settings_t *settings, kdvd_settings_listener_id *listener);
+
 // Setting Information
 kdvd_setting_t kdvd_settings_get_setting(kdvd_settings_t *settings, const char *name);
 int kdvd_settings_get_setting_count(kdvd_settings_t *settings);
@@ -0,0 +1,234 @@
+/*****************************************************************************
+ * udf.c: UDF disc image stream extractor
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_stream.h>
+#include <vlc_stream_extractor.h>
+
+#include "udf_fs.h"
+
+static  int ExtractorOpen( vlc_object_t* );
+static void ExtractorClose( vlc_object_t* );
+
+/* No stream_directory: it would be attached to every UDF volume, DVD and
+ * Blu-ray images included, and take them away from their own demuxers.
+ * Files are reached explicitly with "#!/path" MRLs. */
+vlc_module_begin()
+    set_subcategory( SUBCAT_INPUT_STREAM_FILTER )
+    set_capability( "stream_extractor", 90 )
+    set_description( N_( "UDF disc image stream extractor" ) )
+    set_callbacks( ExtractorOpen, ExtractorClose )
+vlc_module_end()
+
+typedef struct
+{
+    stream_t* source;
+    vlc_udf_t* udf;
+
+    const struct vlc_udf_file* file;
+    uint64_t i_offset;
+} private_sys_t;
+
+/* ------------------------------------------------------------------------- */
+
+static int ReadSource( void* opaque, uint64_t offset, void* buf, size_t len )
+{
+    stream_t* source = opaque;
+
+    /* Consecutive extents do not seek */
+    if( vlc_stream_Tell( source ) != offset
+     && vlc_stream_Seek( source, offset ) )
+        return -1;
+
+    return vlc_stream_Read( source, buf, len ) == (ssize_t)len ? 0 : -1;
+}
+
+static int probe( stream_t* source )
+{
+    bool b_seekable;
+
+    /* The file system is all over the volume */
+    if( vlc_stream_Control( source, STREAM_CAN_SEEK, &b_seekable )
+     || !b_seekable )
+        return VLC_EGENERIC;
+
+    const uint8_t *p_peek;
+    ssize_t i_peek = vlc_stream_Peek( source, &p_peek,
+                                      VLC_UDF_VRS_OFFSET + VLC_UDF_VRS_SIZE );
+    if( i_peek <= VLC_UDF_VRS_OFFSET )
+        return VLC_EGENERIC;
+
+    return vlc_udf_Probe( p_peek + VLC_UDF_VRS_OFFSET,
+                          i_peek - VLC_UDF_VRS_OFFSET )
+         ? VLC_SUCCESS : VLC_EGENERIC;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static ssize_t Read( stream_extractor_t* p_extractor, void* p_data, size_t i_size )
+{
+    private_sys_t* p_sys = p_extractor->p_sys;
+    const struct vlc_udf_file* file = p_sys->file;
+
+    if( p_sys->i_offset >= file->size )
+        return 0;
+
+    ssize_t i_ret;
+    if( p_data == NULL )
+        i_ret = __MIN( i_size, file->size - p_sys->i_offset );
+    else
+    {
+        /* One extent at a time, the next one may need a seek */
+        const struct vlc_udf_extent* ext =
+            vlc_udf_FindExtent( file, p_sys->i_offset );
+        if( ext != NULL )
+            i_size = __MIN( i_size,
+                            ext->offset + ext->length - p_sys->i_offset );
+
+        i_ret = vlc_udf_Read( p_sys->udf, file, p_sys->i_offset,
+                              p_data, i_size );
+        if( i_ret < 0 )
+        {
+            msg_Err( p_extractor, "read error at %"PRIu64, p_sys->i_offset );
+            return -1;
+        }
+    }
+
+    p_sys->i_offset += i_ret;
+    return i_ret;
+}
+
+static int Seek( stream_extractor_t* p_extractor, uint64_t i_req )
+{
+    private_sys_t* p_sys = p_extractor->p_sys;
+
+    p_sys->i_offset = i_req;
+    return VLC_SUCCESS;
+}
+
+static int Control( stream_extractor_t* p_extractor, int i_query, va_list args )
+{
+    private_sys_t* p_sys = p_extractor->p_sys;
+    const struct vlc_udf_file* file = p_sys->file;
+
+    switch( i_query )
+    {
+        case STREAM_CAN_SEEK:
+            *va_arg( args, bool* ) = true;
+            break;
+
+        case STREAM_GET_SIZE:
+            *va_arg( args, uint64_t* ) = file->size;
+            break;
+
+        case STREAM_GET_MTIME:
+            if( file->mtime < 0 )
+                return VLC_EGENERIC;
+            *va_arg( args, uint64_t* ) = file->mtime;
+            break;
+
+        case STREAM_GET_CONTENT_TYPE:
+            return VLC_EGENERIC;
+
+        case STREAM_SET_PREFETCH_HINT:
+        {
+            /* From the file to the volume, within one extent */
+            uint64_t i_hint = va_arg( args, uint64_t );
+            size_t i_length = va_arg( args, size_t );
+            const struct vlc_udf_extent* ext = vlc_udf_FindExtent( file, i_hint );
+
+            if( ext == NULL || ext->position == VLC_UDF_SPARSE )
+                return VLC_EGENERIC;
+
+            uint64_t i_skip = i_hint - ext->offset;
+            return vlc_stream_SetPrefetchHint( p_sys->source,
+                ext->position + i_skip,
+                __MIN( i_length, ext->length - i_skip ) );
+        }
+
+        default:
+            return vlc_stream_vaControl( p_sys->source, i_query, args );
+    }
+
+    return VLC_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void ExtractorClose( vlc_object_t* p_obj )
+{
+    stream_extractor_t* p_extractor = (void*)p_obj;
+    private_sys_t* p_sys = p_extractor->p_sys;
+
+    vlc_udf_Close( p_sys->udf );
+    free( p_sys );
+}
+
+static int ExtractorOpen( vlc_object_t* p_obj )
+{
+    stream_extractor_t* p_extractor = (void*)p_obj;
+    stream_t* source = p_extractor->source;
+
+    if( probe( source ) )
+        return VLC_EGENERIC;
+
+    private_sys_t* p_sys = calloc( 1, sizeof( *p_sys ) );
+    if( unlikely( !p_sys ) )
+        return VLC_ENOMEM;
+
+    uint64_t i_size;
+    if( vlc_stream_GetSize( source, &i_size ) )
+        i_size = 0;
+
+    p_sys->source = source;
+    p_sys->udf = vlc_udf_Open( p_obj, ReadSource, source, i_size );
+    if( p_sys->udf == NULL )
+    {
+        msg_Dbg( p_obj, "no readable UDF volume" );
+        free( p_sys );
+        return VLC_EGENERIC;
+    }
+
+    p_sys->file = vlc_udf_Lookup( p_sys->udf, p_extractor->identifier );
+    if( p_sys->file == NULL || p_sys->file->directory )
+    {
+        msg_Err( p_extractor, "UDF volume does not contain %s",
+                 p_extractor->identifier );
+        vlc_udf_Close( p_sys->udf );
+        free( p_sys );
+        return VLC_EGENERIC;
+    }
+
+    msg_Dbg( p_extractor, "%s: %"PRIu64" bytes in %zu extent(s)",
+             p_extractor->identifier, p_sys->file->size,
+             p_sys->file->extent_count );
+
+    p_extractor->p_sys = p_sys;
+    p_extractor->pf_read = Read;
+    p_extractor->pf_control = Control;
+    p_extractor->pf_seek = Seek;
+
+    return VLC_SUCCESS;
+}
@@ -0,0 +1,892 @@
+/*****************************************************************************
+ * udf_fs.c: UDF file system reader
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_charset.h>
+#include <vlc_strings.h>
+
+#include "udf_fs.h"
+
+/* Descriptor tag identifiers, ECMA-167 3/7.2.1 and 4/7.2.1 */
+enum
+{
+    TAG_AVDP = 2,
+    TAG_PD   = 5,
+    TAG_LVD  = 6,
+    TAG_TD   = 8,
+    TAG_FSD  = 256,
+    TAG_FID  = 257,
+    TAG_AED  = 258,
+    TAG_FE   = 261,
+    TAG_EFE  = 266,
+};
+
+/* File characteristics of the file identifier descriptor */
+#define FID_DIRECTORY 0x02
+#define FID_DELETED   0x04
+#define FID_PARENT    0x08
+
+#define MAX_PARTITIONS 4
+#define MAX_VDS_LENGTH 64         /* sectors of a volume descriptor sequence */
+#define MAX_DIR_SIZE   (16 << 20)
+#define MAX_AD_CHAIN   1024       /* allocation extent descriptors per file */
+
+struct udf_map
+{
+    uint64_t start;  /* first sector of the physical partition */
+    uint64_t length; /* in sectors */
+    bool metadata;
+    struct vlc_udf_file file; /* of the metadata partition */
+};
+
+struct udf_node
+{
+    char *name;
+    struct vlc_udf_file file;
+    uint16_t partref;
+    uint32_t lbn;
+    bool loaded; /* file entry parsed */
+    bool listed; /* children parsed */
+    struct udf_node **children;
+    size_t child_count;
+};
+
+struct vlc_udf
+{
+    vlc_object_t *obj;
+    vlc_udf_read_cb read;
+    void *opaque;
+    uint64_t size;
+
+    unsigned sector_size;
+    uint8_t *block; /* one sector */
+    struct udf_map maps[MAX_PARTITIONS];
+    unsigned map_count;
+
+    struct udf_node root;
+};
+
+/*
+ * Descriptors
+ */
+static uint16_t Crc16(const uint8_t *p, size_t length)
+{
+    uint16_t crc = 0;
+
+    while (length--)
+    {
+        crc ^= *p++ << 8;
+        for (unsigned i = 0; i < 8; i++)
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+static bool CheckTag(const uint8_t *p, size_t size, uint16_t id)
+{
+    uint8_t sum = 0;
+
+    if (size < 16)
+        return false;
+    for (unsigned i = 0; i < 16; i++)
+        if (i != 4)
+            sum += p[i];
+    if (sum != p[4] || GetWLE(p) != id)
+        return false;
+
+    /* The CRC may cover more than the buffer, for the descriptors split
+     * across sectors */
+    size_t crc_length = GetWLE(p + 10);
+    return crc_length == 0 || crc_length > size - 16
+        || Crc16(p + 16, crc_length) == GetWLE(p + 8);
+}
+
+static int64_t DecodeTime(const uint8_t *p)
+{
+    const uint16_t type_tz = GetWLE(p);
+    const int year = (int16_t)GetWLE(p + 2);
+    const int month = p[4], day = p[5];
+
+    if (year == 0 || month < 1 || month > 12 || day < 1 || day > 31)
+        return -1;
+
+    /* Days from the civil date */
+    const int y = year - (month <= 2);
+    const int era = (y >= 0 ? y : y - 399) / 400;
+    const int yoe = y - era * 400;
+    const int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    int64_t t = ((int64_t)era * 146097 + doe - 719468) * 86400
+              + p[6] * 3600 + p[7] * 60 + p[8];
+
+    /* Local time, with the offset from UTC in minutes */
+    if ((type_tz >> 12) == 1)
+    {
+        int offset = type_tz & 0xFFF;
+        if (offset & 0x800)
+            offset -= 0x1000;
+        if (offset != -2047) /* unspecified */
+            t -= offset * 60;
+    }
+    return t;
+}
+
+static char *DecodeName(const uint8_t *p, size_t length)
+{
+    if (length < 2)
+        return NULL;
+
+    /* OSTA compressed unicode */
+    switch (p[0])
+    {
+        case 8:
+        case 254:
+            return FromCharset("ISO-8859-1", p + 1, length - 1);
+        case 16:
+        case 255:
+            return FromCharset("UTF-16BE", p + 1, (length - 1) & ~1);
+    }
+    return NULL;
+}
+
+/*
+ * Partitions
+ */
+static int ReadSector(vlc_udf_t *udf, uint64_t sector)
+{
+    const uint64_t offset = sector * udf->sector_size;
+
+    if (udf->size > 0 && offset + udf->sector_size > udf->size)
+        return -1;
+    return udf->read(udf->opaque, offset, udf->block, udf->sector_size);
+}
+
+static const struct udf_map *GetMap(vlc_udf_t *udf, uint16_t partref)
+{
+    return partref < udf->map_count ? &udf->maps[partref] : NULL;
+}
+
+static int MapBlock(vlc_udf_t *udf, const struct udf_map *map, uint32_t lbn,
+                    uint64_t *sector)
+{
+    if (!map->metadata)
+    {
+        if (lbn >= map->length)
+            return -1;
+        *sector = map->start + lbn;
+        return 0;
+    }
+
+    const uint64_t offset = (uint64_t)lbn * udf->sector_size;
+    const struct vlc_udf_extent *ext = vlc_udf_FindExtent(&map->file, offset);
+    if (ext == NULL || ext->position == VLC_UDF_SPARSE)
+        return -1;
+    *sector = (ext->position + offset - ext->offset) / udf->sector_size;
+    return 0;
+}
+
+static int ReadBlock(vlc_udf_t *udf, const struct udf_map *map, uint32_t lbn)
+{
+    uint64_t sector;
+
+    if (MapBlock(udf, map, lbn, &sector))
+        return -1;
+    return ReadSector(udf, sector);
+}
+
+/* Appends to the map of a file, merging the contiguous extents */
+static int AddExtent(struct vlc_udf_file *file, size_t *capacity,
+                     uint64_t length, uint64_t position)
+{
+    uint64_t offset = 0;
+
+    if (file->extent_count > 0)
+    {
+        struct vlc_udf_extent *last = &file->extents[file->extent_count - 1];
+        offset = last->offset + last->length;
+
+        if (last->position == VLC_UDF_SPARSE
+          ? position == VLC_UDF_SPARSE
+          : position == last->position + last->length)
+        {
+            last->length += length;
+            return 0;
+        }
+    }
+
+    if (file->extent_count == *capacity)
+    {
+        size_t count = *capacity ? *capacity * 2 : 4;
+        struct vlc_udf_extent *extents =
+            realloc(file->extents, count * sizeof (*extents));
+        if (unlikely(extents == NULL))
+            return -1;
+        file->extents = extents;
+        *capacity = count;
+    }
+
+    file->extents[file->extent_count++] = (struct vlc_udf_extent) {
+        .offset = offset, .length = length, .position = position,
+    };
+    return 0;
+}
+
+static int MapExtent(vlc_udf_t *udf, struct vlc_udf_file *file,
+                     size_t *capacity, const struct udf_map *map,
+                     uint32_t lbn, uint64_t length)
+{
+    const uint64_t ss = udf->sector_size;
+
+    if (!map->metadata)
+    {
+        if (lbn > map->length || (length + ss - 1) / ss > map->length - lbn)
+            return -1;
+        return AddExtent(file, capacity, length, (map->start + lbn) * ss);
+    }
+
+    /* Through the extents of the metadata file */
+    uint64_t offset = lbn * ss;
+    while (length > 0)
+    {
+        const struct vlc_udf_extent *ext =
+            vlc_udf_FindExtent(&map->file, offset);
+        if (ext == NULL || ext->position == VLC_UDF_SPARSE)
+            return -1;
+
+        const uint64_t skip = offset - ext->offset;
+        const uint64_t n = __MIN(length, ext->length - skip);
+        if (AddExtent(file, capacity, n, ext->position + skip))
+            return -1;
+        offset += n;
+        length -= n;
+    }
+    return 0;
+}
+
+/*
+ * File entries
+ */
+static void ClearFile(struct vlc_udf_file *file)
+{
+    free(file->data);
+    free(file->extents);
+    file->data = NULL;
+    file->extents = NULL;
+    file->extent_count = 0;
+}
+
+static int ReadAllocation(vlc_udf_t *udf, struct vlc_udf_file *file,
+                          const struct udf_map *map, bool long_ads,
+                          uint8_t *ads, size_t length)
+{
+    const size_t ss = udf->sector_size;
+    const size_t ad_size = long_ads ? 16 : 8;
+    size_t capacity = 0;
+    uint64_t mapped = 0;
+    unsigned chain = 0;
+
+    for (size_t i = 0; i + ad_size <= length && mapped < file->size;)
+    {
+        const uint8_t *ad = ads + i;
+        const unsigned type = GetDWLE(ad) >> 30;
+        uint64_t extent_length = GetDWLE(ad) & 0x3FFFFFFF;
+        const uint32_t lbn = GetDWLE(ad + 4);
+        const struct udf_map *ad_map = long_ads ? GetMap(udf, GetWLE(ad + 8))
+                                                : map;
+
+        if (extent_length == 0)
+            break;
+        if (ad_map == NULL)
+            goto error;
+
+        if (type == 3)
+        {   /* Continued in an allocation extent descriptor */
+            const uint8_t *aed = udf->block;
+
+            if (++chain > MAX_AD_CHAIN || ReadBlock(udf, ad_map, lbn)
+             || !CheckTag(aed, ss, TAG_AED) || GetDWLE(aed + 12) != lbn)
+                goto error;
+
+            length = GetDWLE(aed + 20);
+            if (length > ss - 24)
+                goto error;
+            memcpy(ads, aed + 24, length);
+            i = 0;
+            continue;
+        }
+
+        extent_length = __MIN(extent_length, file->size - mapped);
+        if (type == 0 ? MapExtent(udf, file, &capacity, ad_map, lbn,
+                                  extent_length)
+                      : AddExtent(file, &capacity, extent_length,
+                                  VLC_UDF_SPARSE))
+            goto error;
+        mapped += extent_length;
+        i += ad_size;
+    }
+
+    if (mapped < file->size)
+    {
+        msg_Warn(udf->obj, "file allocation truncated (%"PRIu64"/%"PRIu64")",
+                 mapped, file->size);
+        file->size = mapped;
+    }
+    return 0;
+
+error:
+    ClearFile(file);
+    return -1;
+}
+
+static int ReadEntry(vlc_udf_t *udf, const struct udf_map *map, uint32_t lbn,
+                     struct vlc_udf_file *file)
+{
+    const size_t ss = udf->sector_size;
+    const uint8_t *p = udf->block;
+
+    if (ReadBlock(udf, map, lbn))
+        return -1;
+
+    const bool extended = CheckTag(p, ss, TAG_EFE);
+    if ((!extended && !CheckTag(p, ss, TAG_FE)) || GetDWLE(p + 12) != lbn)
+        return -1;
+
+    /* The ICB tag follows the descriptor tag */
+    const uint8_t file_type = p[16 + 11];
+    const unsigned ad_type = GetWLE(p + 16 + 18) & 7;
+    size_t ad_offset = extended ? 216 : 176;
+    const uint32_t ea_length = GetDWLE(p + ad_offset - 8);
+    const uint32_t ad_length = GetDWLE(p + ad_offset - 4);
+
+    if (ea_length > ss - ad_offset || ad_length > ss - ad_offset - ea_length)
+        return -1;
+    ad_offset += ea_length;
+
+    file->directory = file_type == 4;
+    file->size = GetQWLE(p + 56);
+    file->mtime = DecodeTime(p + (extended ? 92 : 84));
+
+    switch (ad_type)
+    {
+        case 0: /* short */
+        case 1: /* long */
+            break;
+        case 3: /* embedded */
+            if (file->size > ad_length)
+                return -1;
+            file->data = malloc(__MAX(file->size, 1));
+            if (unlikely(file->data == NULL))
+                return -1;
+            memcpy(file->data, p + ad_offset, file->size);
+            return 0;
+        default:
+            msg_Dbg(udf->obj, "unsupported allocation descriptors %u",
+                    ad_type);
+            return -1;
+    }
+
+    /* The block buffer is reused for the allocation extents */
+    uint8_t *ads = malloc(ss);
+    if (unlikely(ads == NULL))
+        return -1;
+    memcpy(ads, p + ad_offset, ad_length);
+    int ret = ReadAllocation(udf, file, map, ad_type == 1, ads, ad_length);
+    free(ads);
+    return ret;
+}
+
+/*
+ * Directories
+ */
+static int LoadNode(vlc_udf_t *udf, struct udf_node *node)
+{
+    if (node->loaded)
+        return 0;
+
+    const struct udf_map *map = GetMap(udf, node->partref);
+    if (map == NULL || ReadEntry(udf, map, node->lbn, &node->file))
+    {
+        msg_Warn(udf->obj, "cannot read the entry of %s",
+                 node->name ? node->name : "the root directory");
+        return -1;
+    }
+    node->loaded = true;
+    return 0;
+}
+
+static int AddChild(struct udf_node *dir, const uint8_t *fid, char *name)
+{
+    struct udf_node *child = calloc(1, sizeof (*child));
+    if (unlikely(child == NULL))
+        return -1;
+
+    struct udf_node **children = realloc(dir->children,
+        (dir->child_count + 1) * sizeof (*children));
+    if (unlikely(children == NULL))
+    {
+        free(child);
+        return -1;
+    }
+    dir->children = children;
+
+    /* The long_ad of the ICB */
+    child->name = name;
+    child->lbn = GetDWLE(fid + 24);
+    child->partref = GetWLE(fid + 28);
+    child->file.directory = (fid[18] & FID_DIRECTORY) != 0;
+    child->file.mtime = -1;
+    dir->children[dir->child_count++] = child;
+    return 0;
+}
+
+static int ListDir(vlc_udf_t *udf, struct udf_node *dir)
+{
+    if (dir->listed)
+        return 0;
+    if (LoadNode(udf, dir) || !dir->file.directory
+     || dir->file.size > MAX_DIR_SIZE)
+        return -1;
+
+    const size_t size = dir->file.size;
+    uint8_t *buf = malloc(__MAX(size, 1));
+    if (unlikely(buf == NULL))
+        return -1;
+    if (vlc_udf_Read(udf, &dir->file, 0, buf, size) != (ssize_t)size)
+    {
+        free(buf);
+        return -1;
+    }
+
+    /* File identifier descriptors, aligned on 4 bytes */
+    for (size_t i = 0; size - i >= 38;)
+    {
+        const uint8_t *fid = buf + i;
+        const uint8_t name_length = fid[19];
+        const uint16_t iu_length = GetWLE(fid + 36);
+
+        if (!CheckTag(fid, size - i, TAG_FID)
+         || 38u + iu_length + name_length > size - i)
+        {
+            msg_Warn(udf->obj, "corrupt directory %s",
+                     dir->name ? dir->name : "/");
+            break;
+        }
+
+        if (!(fid[18] & (FID_DELETED | FID_PARENT)))
+        {
+            char *name = DecodeName(fid + 38 + iu_length, name_length);
+
+            if (name != NULL && (name[0] == '\0' || strchr(name, '/')))
+            {
+                free(name);
+                name = NULL;
+            }
+            if (name != NULL && AddChild(dir, fid, name))
+            {
+                free(name);
+                break;
+            }
+        }
+        i += (38 + iu_length + name_length + 3) & ~3;
+    }
+
+    free(buf);
+    dir->listed = true;
+    return 0;
+}
+
+static struct udf_node *FindChild(vlc_udf_t *udf, struct udf_node *dir,
+                                  const char *name)
+{
+    if (ListDir(udf, dir))
+        return NULL;
+
+    for (size_t i = 0; i < dir->child_count; i++)
+        if (!strcmp(dir->children[i]->name, name))
+            return dir->children[i];
+    for (size_t i = 0; i < dir->child_count; i++)
+        if (!vlc_ascii_strcasecmp(dir->children[i]->name, name))
+            return dir->children[i];
+    return NULL;
+}
+
+static void FreeNode(struct udf_node *node)
+{
+    for (size_t i = 0; i < node->child_count; i++)
+    {
+        FreeNode(node->children[i]);
+        free(node->children[i]);
+    }
+    free(node->children);
+    free(node->name);
+    ClearFile(&node->file);
+}
+
+/*
+ * Volume
+ */
+static int LoadMetadata(vlc_udf_t *udf, struct udf_map *map,
+                        uint32_t main_lbn, uint32_t mirror_lbn)
+{
+    /* The metadata file is recorded in the physical partition */
+    const struct udf_map physical = {
+        .start = map->start, .length = map->length,
+    };
+
+    if (ReadEntry(udf, &physical, main_lbn, &map->file)
+     && ReadEntry(udf, &physical, mirror_lbn, &map->file))
+    {
+        msg_Err(udf->obj, "cannot read the metadata partition");
+        return -1;
+    }
+    if (map->file.data != NULL)
+        return -1;
+    map->metadata = true;
+    return 0;
+}
+
+static int ReadFileSet(vlc_udf_t *udf, uint16_t partref, uint32_t lbn)
+{
+    const struct udf_map *map = GetMap(udf, partref);
+    const uint8_t *p = udf->block;
+
+    if (map == NULL || ReadBlock(udf, map, lbn)
+     || !CheckTag(p, udf->sector_size, TAG_FSD) || GetDWLE(p + 12) != lbn)
+    {
+        msg_Err(udf->obj, "cannot read the file set descriptor");
+        return -1;
+    }
+
+    /* The long_ad of the root directory ICB */
+    udf->root.lbn = GetDWLE(p + 404);
+    udf->root.partref = GetWLE(p + 408);
+    return ListDir(udf, &udf->root);
+}
+
+struct udf_partition
+{
+    uint16_t number;
+    uint32_t start;
+    uint32_t length;
+};
+
+static int ParseLogicalVolume(vlc_udf_t *udf, const uint8_t *lvd,
+                              const struct udf_partition *parts,
+                              unsigned part_count)
+{
+    const size_t ss = udf->sector_size;
+
+    if (GetDWLE(lvd + 212) != ss)
+        return -1;
+
+    const uint32_t table_length = GetDWLE(lvd + 264);
+    const uint32_t map_count = GetDWLE(lvd + 268);
+    if (table_length > ss - 440 || map_count > MAX_PARTITIONS)
+        return -1;
+
+    const uint8_t *m = lvd + 440, *end = m + table_length;
+    for (uint32_t i = 0; i < map_count; i++)
+    {
+        if (end - m < 2 || m[1] < 6 || m[1] > end - m)
+            return -1;
+
+        const uint8_t type = m[0], length = m[1];
+        uint16_t number;
+        bool metadata = false;
+
+        if (type == 1)
+            number = GetWLE(m + 4);
+        else if (type == 2 && length >= 64)
+        {
+            const char *ident = (const char *)m + 5;
+
+            number = GetWLE(m + 38);
+            if (!memcmp(ident, "*UDF Metadata Partition", 23))
+                metadata = true;
+            /* Remapped sectors only exist on rewritable media */
+            else if (memcmp(ident, "*UDF Sparable Partition", 23))
+            {
+                msg_Dbg(udf->obj, "unsupported partition %.23s", ident);
+                return -1;
+            }
+        }
+        else
+            return -1;
+
+        const struct udf_partition *part = NULL;
+        for (unsigned j = 0; j < part_count; j++)
+            if (parts[j].number == number)
+                part = &parts[j];
+        if (part == NULL)
+            return -1;
+
+        struct udf_map *map = &udf->maps[udf->map_count++];
+        map->start = part->start;
+        map->length = part->length;
+        if (metadata && LoadMetadata(udf, map, GetDWLE(m + 40),
+                                     GetDWLE(m + 44)))
+            return -1;
+        m += length;
+    }
+
+    /* The long_ad of the file set descriptor */
+    return ReadFileSet(udf, GetWLE(lvd + 256), GetDWLE(lvd + 252));
+}
+
+static int ReadVolume(vlc_udf_t *udf, uint32_t length, uint32_t location)
+{
+    const size_t ss = udf->sector_size;
+    const uint32_t count = __MIN(length / ss, MAX_VDS_LENGTH);
+    struct udf_partition parts[MAX_PARTITIONS];
+    unsigned part_count = 0;
+    uint8_t *lvd = NULL;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const uint8_t *p = udf->block;
+
+        if (ReadSector(udf, (uint64_t)location + i))
+            break;
+
+        const uint16_t id = GetWLE(p);
+        if (!CheckTag(p, ss, id) || GetDWLE(p + 12) != location + i
+         || id == TAG_TD)
+            break;
+
+        if (id == TAG_PD && part_count < MAX_PARTITIONS)
+            parts[part_count++] = (struct udf_partition) {
+                .number = GetWLE(p + 22),
+                .start = GetDWLE(p + 188),
+                .length = GetDWLE(p + 192),
+            };
+        else if (id == TAG_LVD && lvd == NULL)
+        {
+            lvd = malloc(ss);
+            if (unlikely(lvd == NULL))
+                return -1;
+            memcpy(lvd, p, ss);
+        }
+    }
+
+    int ret = -1;
+    if (lvd != NULL)
+    {
+        ret = ParseLogicalVolume(udf, lvd, parts, part_count);
+        free(lvd);
+    }
+    return ret;
+}
+
+static void CloseVolume(vlc_udf_t *udf)
+{
+    FreeNode(&udf->root);
+    memset(&udf->root, 0, sizeof (udf->root));
+    for (unsigned i = 0; i < udf->map_count; i++)
+        ClearFile(&udf->maps[i].file);
+    memset(udf->maps, 0, sizeof (udf->maps));
+    udf->map_count = 0;
+}
+
+static int OpenVolume(vlc_udf_t *udf)
+{
+    const uint64_t sectors = udf->size / udf->sector_size;
+    uint64_t anchors[3] = { 256, 0, 0 };
+    unsigned anchor_count = 1;
+
+    if (sectors > 257)
+    {
+        anchors[anchor_count++] = sectors - 1;
+        anchors[anchor_count++] = sectors - 257;
+    }
+
+    for (unsigned i = 0; i < anchor_count; i++)
+    {
+        const uint8_t *p = udf->block;
+
+        if (ReadSector(udf, anchors[i])
+         || !CheckTag(p, udf->sector_size, TAG_AVDP)
+         || GetDWLE(p + 12) != anchors[i])
+            continue;
+
+        /* Main, then reserve volume descriptor sequence */
+        const uint32_t main_length = GetDWLE(p + 16);
+        const uint32_t main_location = GetDWLE(p + 20);
+        const uint32_t reserve_length = GetDWLE(p + 24);
+        const uint32_t reserve_location = GetDWLE(p + 28);
+
+        if (ReadVolume(udf, main_length, main_location) == 0)
+            return 0;
+        CloseVolume(udf);
+        if (ReadVolume(udf, reserve_length, reserve_location) == 0)
+            return 0;
+        CloseVolume(udf);
+    }
+    return -1;
+}
+
+bool vlc_udf_Probe(const uint8_t *vrs, size_t length)
+{
+    bool extended = false;
+
+    /* Volume structure descriptors of 2048 bytes, or one per sector on
+     * larger sectors */
+    for (size_t i = 0; i < length && length - i >= 6; i += 2048)
+    {
+        const char *ident = (const char *)vrs + i + 1;
+
+        if (!memcmp(ident, "BEA01", 5))
+            extended = true;
+        else if (!memcmp(ident, "NSR02", 5) || !memcmp(ident, "NSR03", 5))
+            return extended;
+        else if (!memcmp(ident, "TEA01", 5))
+            return false;
+        else if (memcmp(ident, "CD001", 5) && memcmp(ident, "CDW02", 5)
+              && memcmp(ident, "BOOT2", 5) && memcmp(ident, "\0\0\0\0\0", 5))
+            return false;
+    }
+    return false;
+}
+
+vlc_udf_t *vlc_udf_Open(vlc_object_t *obj, vlc_udf_read_cb read, void *opaque,
+                        uint64_t size)
+{
+    static const unsigned sector_sizes[] = { 2048, 4096, 512 };
+
+    vlc_udf_t *udf = calloc(1, sizeof (*udf));
+    if (unlikely(udf == NULL))
+        return NULL;
+
+    udf->obj = obj;
+    udf->read = read;
+    udf->opaque = opaque;
+    udf->size = size;
+    udf->block = malloc(4096);
+    if (unlikely(udf->block == NULL))
+    {
+        free(udf);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(sector_sizes); i++)
+    {
+        udf->sector_size = sector_sizes[i];
+        if (OpenVolume(udf) == 0)
+        {
+            msg_Dbg(obj, "UDF volume, %u bytes sectors, %u partition(s)",
+                    udf->sector_size, udf->map_count);
+            return udf;
+        }
+    }
+
+    free(udf->block);
+    free(udf);
+    return NULL;
+}
+
+void vlc_udf_Close(vlc_udf_t *udf)
+{
+    CloseVolume(udf);
+    free(udf->block);
+    free(udf);
+}
+
+/*
+ * Files
+ */
+const struct vlc_udf_file *vlc_udf_Lookup(vlc_udf_t *udf, const char *path)
+{
+    struct udf_node *node = &udf->root;
+    char *buf = strdup(path), *saveptr;
+
+    if (unlikely(buf == NULL))
+        return NULL;
+
+    for (char *name = strtok_r(buf, "/", &saveptr); name != NULL;
+         name = strtok_r(NULL, "/", &saveptr))
+    {
+        node = FindChild(udf, node, name);
+        if (node == NULL)
+            break;
+    }
+    free(buf);
+
+    if (node == NULL || LoadNode(udf, node))
+        return NULL;
+    return &node->file;
+}
+
+const struct vlc_udf_extent *vlc_udf_FindExtent(const struct vlc_udf_file *file,
+                                                uint64_t offset)
+{
+    size_t lo = 0, hi = file->extent_count;
+
+    while (lo < hi)
+    {
+        const size_t mid = (lo + hi) / 2;
+        const struct vlc_udf_extent *ext = &file->extents[mid];
+
+        if (offset < ext->offset)
+            hi = mid;
+        else if (offset - ext->offset >= ext->length)
+            lo = mid + 1;
+        else
+            return ext;
+    }
+    return NULL;
+}
+
+ssize_t vlc_udf_Read(vlc_udf_t *udf, const struct vlc_udf_file *file,
+                     uint64_t offset, void *buf, size_t length)
+{
+    if (offset >= file->size)
+        return 0;
+    length = __MIN(length, file->size - offset);
+
+    if (file->data != NULL)
+    {
+        memcpy(buf, file->data + offset, length);
+        return length;
+    }
+
+    size_t done = 0;
+    while (done < length)
+    {
+        const struct vlc_udf_extent *ext =
+            vlc_udf_FindExtent(file, offset + done);
+        if (ext == NULL)
+            break;
+
+        const uint64_t skip = offset + done - ext->offset;
+        const size_t n = __MIN(length - done, ext->length - skip);
+        uint8_t *p = (uint8_t *)buf + done;
+
+        if (ext->position == VLC_UDF_SPARSE)
+            memset(p, 0, n);
+        else if (udf->read(udf->opaque, ext->position + skip, p, n))
+            return done > 0 ? (ssize_t)done : -1;
+        done += n;
+    }
+    return done;
+}
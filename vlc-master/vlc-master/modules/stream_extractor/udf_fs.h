@@ -0,0 +1,81 @@
+/*****************************************************************************
+ * udf_fs.h: UDF file system reader
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_UDF_FS_H
+#define VLC_UDF_FS_H
+
+/* Read-only UDF, up to revision 2.60, including the metadata partition of
+ * the 2.50 revision. Sparable partitions are read as physical ones, the
+ * virtual partition of sequentially recorded discs is not supported.
+ *
+ * A directory is parsed when it is first looked up, and stays in the tree.
+ * A file entry is resolved once into a map of extents of the volume, so
+ * that reading a file does not touch the metadata again. */
+
+/* The volume recognition sequence starts at 32 KiB */
+#define VLC_UDF_VRS_OFFSET 32768
+#define VLC_UDF_VRS_SIZE   32768
+
+#define VLC_UDF_SPARSE UINT64_MAX
+
+struct vlc_udf_extent
+{
+    uint64_t offset;   /* in the file */
+    uint64_t length;
+    uint64_t position; /* in the volume, VLC_UDF_SPARSE if not recorded */
+};
+
+struct vlc_udf_file
+{
+    uint64_t size;
+    int64_t  mtime;  /* seconds since the Epoch, -1 if unknown */
+    bool     directory;
+    uint8_t *data;   /* content embedded in the file entry, or NULL */
+    struct vlc_udf_extent *extents;
+    size_t   extent_count;
+};
+
+typedef struct vlc_udf vlc_udf_t;
+
+/* Reads length bytes of the volume at offset, returns 0 or -1 on error */
+typedef int (*vlc_udf_read_cb)(void *opaque, uint64_t offset, void *buf,
+                               size_t length);
+
+/* Checks the volume recognition sequence, from VLC_UDF_VRS_OFFSET */
+bool vlc_udf_Probe(const uint8_t *vrs, size_t length);
+
+/* size is the size of the volume, 0 if unknown */
+vlc_udf_t *vlc_udf_Open(vlc_object_t *, vlc_udf_read_cb, void *opaque,
+                        uint64_t size);
+void vlc_udf_Close(vlc_udf_t *);
+
+/* Looks a '/' separated path up from the root directory. A name matching
+ * the case exactly is preferred, ASCII case is ignored otherwise. The file
+ * remains valid until the volume is closed. */
+const struct vlc_udf_file *vlc_udf_Lookup(vlc_udf_t *, const char *path);
+
+/* Returns the extent containing offset, NULL past the end */
+const struct vlc_udf_extent *vlc_udf_FindExtent(const struct vlc_udf_file *,
+                                                uint64_t offset);
+
+/* Returns the number of bytes read, 0 past the end, -1 on error */
+ssize_t vlc_udf_Read(vlc_udf_t *, const struct vlc_udf_file *,
+                     uint64_t offset, void *buf, size_t length);
+
+#endif
@@ -469,6 +469,7 @@ static int AStreamControl(stream_t *s, int i_query, va_list args)
         case STREAM_SET_PRIVATE_ID_CA:
         case STREAM_GET_PRIVATE_ID_STATE:
         case STREAM_GET_MTIME:
+        case STREAM_SET_PREFETCH_HINT:
             return vlc_stream_vaControl(s->s, i_query, args);
 
         case STREAM_SET_TITLE:
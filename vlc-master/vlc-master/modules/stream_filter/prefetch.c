@@ -34,6 +34,23 @@
 #include <vlc_stream.h>
 #include <vlc_fs.h>
 #include <vlc_interrupt.h>
+#include <vlc_tick.h>
+
+/* Upper bound of the kept ranges, besides the history size */
+#define PREFETCH_RANGES 8
+/* Consumption rate measurement period */
+#define PREFETCH_RATE_PERIOD VLC_TICK_FROM_SEC(1)
+/* Playback duration to buffer ahead, on top of the upstream latency */
+#define PREFETCH_AHEAD VLC_TICK_FROM_SEC(4)
+
+/* Data kept after a seek, or read in advance from a demuxer hint */
+struct prefetch_range
+{
+    uint64_t offset;
+    size_t length;
+    char *buffer;
+    size_t size; /* allocated */
+};
 
 struct stream_ctrl
 {
@@ -71,11 +88,29 @@ typedef struct
 
     uint64_t     buffer_offset;
     uint64_t     stream_offset;
+    uint64_t     source_offset;
+    uint64_t     read_offset;
     size_t       buffer_length;
     size_t       buffer_size;
+    size_t       buffer_max;
     char        *buffer;
     size_t       seek_threshold;
 
+    vlc_tick_t   rate_date;
+    uint64_t     rate_bytes;
+    uint64_t     rate; /* bytes per second read by the demuxer */
+    vlc_tick_t   latency; /* upstream seek duration */
+
+    struct prefetch_range ranges[PREFETCH_RANGES]; /* most recent first */
+    size_t       range_count;
+    size_t       history_size;
+    char        *spare; /* buffer of a dropped range, to be reused */
+    size_t       spare_size;
+
+    bool         hint_pending;
+    uint64_t     hint_offset;
+    size_t       hint_length;
+
     struct stream_ctrl *controls;
 } stream_sys_t;
 
@@ -95,6 +130,7 @@ static ssize_t ThreadRead(stream_t *stream, void *buf, size_t length)
 static int ThreadSeek(stream_t *stream, uint64_t seek_offset)
 {
     stream_sys_t *sys = stream->p_sys;
+    vlc_tick_t start = vlc_tick_now();
 
     vlc_mutex_unlock(&sys->lock);
 
@@ -104,6 +140,16 @@ static int ThreadSeek(stream_t *stream, uint64_t seek_offset)
 
     vlc_mutex_lock(&sys->lock);
 
+    if (val == VLC_SUCCESS)
+    {
+        vlc_tick_t latency = vlc_tick_now() - start;
+        sys->latency = sys->latency ? (3 * sys->latency + latency) / 4
+                                    : latency;
+        sys->source_offset = seek_offset;
+    }
+    else
+        sys->source_offset = UINT64_MAX;
+
     return (val == VLC_SUCCESS) ? 0 : -1;
 }
 
@@ -124,6 +170,259 @@ static int ThreadControl(stream_t *stream, int query, ...)
     return ret;
 }
 
+/* Copies data between the circular buffer and a linear one */
+static void BufferCopy(stream_sys_t *sys, char *linear, uint64_t offset,
+                       size_t length, bool to_buffer)
+{
+    while (length > 0)
+    {
+        size_t pos = offset % sys->buffer_size;
+        size_t len = __MIN(length, sys->buffer_size - pos);
+
+        if (to_buffer)
+            memcpy(sys->buffer + pos, linear, len);
+        else
+            memcpy(linear, sys->buffer + pos, len);
+        linear += len;
+        offset += len;
+        length -= len;
+    }
+}
+
+static size_t RangeFind(const stream_sys_t *sys, uint64_t offset)
+{
+    for (size_t i = 0; i < sys->range_count; i++)
+    {
+        const struct prefetch_range *range = &sys->ranges[i];
+        if (offset >= range->offset && offset - range->offset < range->length)
+            return i;
+    }
+    return sys->range_count;
+}
+
+/* Keeps the largest buffer of the dropped ranges for the next one */
+static void RangeRelease(stream_sys_t *sys, const struct prefetch_range *range)
+{
+    if (range->size > sys->spare_size)
+    {
+        free(sys->spare);
+        sys->spare = range->buffer;
+        sys->spare_size = range->size;
+    }
+    else
+        free(range->buffer);
+}
+
+static int RangeAlloc(stream_sys_t *sys, struct prefetch_range *range,
+                      size_t length)
+{
+    /* Do not waste more than the range length, the history size accounts
+     * for the lengths only */
+    if (sys->spare_size >= length && sys->spare_size / 2 <= length)
+    {
+        range->buffer = sys->spare;
+        range->size = sys->spare_size;
+        sys->spare = NULL;
+        sys->spare_size = 0;
+        return 0;
+    }
+
+    range->buffer = malloc(length);
+    range->size = length;
+    return range->buffer != NULL ? 0 : -1;
+}
+
+static void RangeRemove(stream_sys_t *sys, size_t i)
+{
+    sys->range_count--;
+    memmove(&sys->ranges[i], &sys->ranges[i + 1],
+            (sys->range_count - i) * sizeof (sys->ranges[0]));
+}
+
+static void RangeAdd(stream_sys_t *sys, const struct prefetch_range *range)
+{
+    size_t total = range->length;
+    size_t count = 0;
+
+    /* Evict the least recently used ranges beyond the history size */
+    while (count < sys->range_count && count < PREFETCH_RANGES - 1
+        && total + sys->ranges[count].length <= sys->history_size)
+        total += sys->ranges[count++].length;
+    while (sys->range_count > count)
+        RangeRelease(sys, &sys->ranges[--sys->range_count]);
+
+    memmove(&sys->ranges[1], &sys->ranges[0],
+            sys->range_count * sizeof (sys->ranges[0]));
+    sys->ranges[0] = *range;
+    sys->range_count++;
+}
+
+/* Keeps the buffered data around the last read position, mostly before it
+ * as it is where short backward seeks land */
+static void ThreadRetire(stream_t *stream)
+{
+    stream_sys_t *sys = stream->p_sys;
+    uint64_t end = sys->buffer_offset + sys->buffer_length;
+    size_t max = __MIN(sys->history_size, sys->buffer_size);
+    uint64_t read = sys->read_offset;
+
+    if (read < sys->buffer_offset)
+        read = sys->buffer_offset;
+    if (read > end)
+        read = end;
+
+    uint64_t hi = end - read > max / 4 ? read + max / 4 : end;
+    uint64_t lo = hi - sys->buffer_offset > max ? hi - max : sys->buffer_offset;
+    struct prefetch_range range = { .offset = lo, .length = hi - lo };
+
+    if (range.length == 0 || RangeAlloc(sys, &range, range.length))
+        return;
+
+    BufferCopy(sys, range.buffer, range.offset, range.length, false);
+    RangeAdd(sys, &range);
+}
+
+/* Restarts the buffer at the offset, from a kept range if possible */
+static void ThreadReset(stream_t *stream, uint64_t offset)
+{
+    stream_sys_t *sys = stream->p_sys;
+    struct prefetch_range range = { .buffer = NULL };
+
+    if (sys->can_seek)
+    {
+        size_t i = RangeFind(sys, offset);
+        if (i < sys->range_count)
+        {
+            range = sys->ranges[i];
+            RangeRemove(sys, i);
+        }
+        ThreadRetire(stream);
+    }
+
+    sys->eof = false;
+
+    if (range.buffer != NULL)
+    {
+        msg_Dbg(stream, "reusing %zu bytes at offset %"PRIu64, range.length,
+                range.offset);
+        assert(range.length <= sys->buffer_size);
+        BufferCopy(sys, range.buffer, range.offset, range.length, true);
+        RangeRelease(sys, &range);
+        sys->buffer_offset = range.offset;
+        sys->buffer_length = range.length;
+    }
+    else
+    {
+        sys->buffer_offset = offset;
+        sys->buffer_length = 0;
+    }
+}
+
+/* Grows the buffer to hold a few seconds of the stream at the rate it is
+ * read, plus the time to reconnect upstream */
+static void ThreadResize(stream_t *stream)
+{
+    stream_sys_t *sys = stream->p_sys;
+    uint64_t target = sys->rate * (PREFETCH_AHEAD + 2 * sys->latency)
+                      / CLOCK_FREQ;
+
+    if (sys->buffer_size >= sys->buffer_max
+     || target <= sys->buffer_size + sys->buffer_size / 4)
+        return;
+
+    size_t size = target + target / 2 < sys->buffer_max ? target + target / 2
+                                                         : sys->buffer_max;
+    char *buffer = malloc(size);
+    if (buffer == NULL)
+    {
+        sys->buffer_max = sys->buffer_size;
+        return;
+    }
+
+    for (uint64_t offset = sys->buffer_offset,
+                  end = sys->buffer_offset + sys->buffer_length;
+         offset < end;)
+    {
+        size_t src = offset % sys->buffer_size, dst = offset % size;
+        size_t len = end - offset;
+
+        len = __MIN(len, sys->buffer_size - src);
+        len = __MIN(len, size - dst);
+        memcpy(buffer + dst, sys->buffer + src, len);
+        offset += len;
+    }
+
+    free(sys->buffer);
+    sys->buffer = buffer;
+    sys->buffer_size = size;
+    msg_Dbg(stream, "using %zu bytes buffer (%"PRIu64" bytes/s)", size,
+            sys->rate);
+}
+
+/* Whether the downstream offset is out of the buffer, such that the buffer
+ * has to be restarted there */
+static bool ThreadSeekPending(const stream_sys_t *sys)
+{
+    /* If upstream supports seeking and if the downstream offset is far
+     * beyond the upstream offset, then attempt to skip forward instead
+     * of reading until the desired offset. Seeking backward before the
+     * buffer cannot be avoided. */
+    return sys->stream_offset < sys->buffer_offset
+        || (sys->can_seek
+         && sys->stream_offset - sys->buffer_offset
+            >= sys->buffer_length + sys->seek_threshold);
+}
+
+/* Reads the range hinted by the demuxer while there is nothing else to do */
+static bool ThreadHint(stream_t *stream)
+{
+    stream_sys_t *sys = stream->p_sys;
+
+    if (!sys->hint_pending)
+        return false;
+    sys->hint_pending = false;
+
+    uint64_t offset = sys->hint_offset;
+    size_t length = __MIN(sys->hint_length,
+                          __MIN(sys->history_size, sys->buffer_size));
+
+    if (length == 0
+     || (offset >= sys->buffer_offset
+      && offset - sys->buffer_offset < sys->buffer_length)
+     || RangeFind(sys, offset) < sys->range_count)
+        return true; /* already buffered */
+
+    struct prefetch_range range = { .offset = offset, .length = 0 };
+
+    if (RangeAlloc(sys, &range, length))
+        return true;
+
+    if (ThreadSeek(stream, offset) == 0)
+    {
+        /* Yield to a seek out of the buffer, the downstream reader waits */
+        while (range.length < length && !vlc_killed()
+            && !ThreadSeekPending(sys))
+        {
+            ssize_t val = ThreadRead(stream, range.buffer + range.length,
+                                     length - range.length);
+            if (val <= 0)
+                break;
+            range.length += val;
+            sys->source_offset += val;
+        }
+    }
+
+    if (range.length > 0)
+    {
+        msg_Dbg(stream, "prefetched %zu bytes at offset %"PRIu64,
+                range.length, range.offset);
+        RangeAdd(sys, &range);
+    }
+    else
+        RangeRelease(sys, &range);
+    return true;
+}
+
 static void *Thread(void *data)
 {
     vlc_thread_set_name("vlc-prefetch");
@@ -164,63 +463,45 @@ static void *Thread(void *data)
 
         uint_fast64_t stream_offset = sys->stream_offset;
 
-        if (stream_offset < sys->buffer_offset)
-        {   /* Need to seek backward */
-            if (ThreadSeek(stream, stream_offset) == 0)
-            {
-                sys->buffer_offset = stream_offset;
-                sys->buffer_length = 0;
-                assert(!sys->error);
-                sys->eof = false;
-            }
-            else
-            {
-                sys->error = true;
-                vlc_cond_signal(&sys->wait_data);
-            }
+        if (ThreadSeekPending(sys))
+        {
+            ThreadReset(stream, stream_offset);
             continue;
         }
 
         if (sys->eof)
         {   /* Do not attempt to read at EOF - would busy loop */
-            vlc_cond_wait(&sys->wait_space, &sys->lock);
+            if (!ThreadHint(stream))
+                vlc_cond_wait(&sys->wait_space, &sys->lock);
             continue;
         }
 
-        assert(stream_offset >= sys->buffer_offset);
+        uint64_t buffer_end = sys->buffer_offset + sys->buffer_length;
 
-        /* As long as there is space, the buffer will retain already read
-         * ("historical") data. The data can be used if/when seeking backward.
-         * Unread data is however given precedence if the buffer is full. */
-        uint64_t history = stream_offset - sys->buffer_offset;
-
-        /* If upstream supports seeking and if the downstream offset is far
-         * beyond the upstream offset, then attempt to skip forward.
-         * If it fails, assume upstream is well-behaved such that the failed
-         * seek is a no-op, and continue as if seeking was not supported.
-         * WARNING: Except problems with misbehaving access plug-ins. */
-        if (sys->can_seek
-         && history >= (sys->buffer_length + sys->seek_threshold))
-        {
-            if (ThreadSeek(stream, stream_offset) == 0)
+        if (sys->source_offset != buffer_end)
+        {   /* Upstream is not where the buffer ends, after a reset or a
+             * hint. If the seek fails, assume upstream is well-behaved such
+             * that the failed seek is a no-op. But in practice, not all
+             * upstream accesses handle reads after failed seek correctly,
+             * so do not try to read instead.
+             * WARNING: Except problems with misbehaving access plug-ins. */
+            if (ThreadSeek(stream, buffer_end))
             {
-                sys->buffer_offset = stream_offset;
-                sys->buffer_length = 0;
-                assert(!sys->error);
-                assert(!sys->eof);
-            }
-            else
-            {   /* Seek failure is not necessarily fatal here. We could read
-                 * data instead until the desired seek offset. But in practice,
-                 * not all upstream accesses handle reads after failed seek
-                 * correctly. Furthermore, sys->stream_offset and/or
-                 * sys->paused might have changed in the mean time. */
                 sys->error = true;
                 vlc_cond_signal(&sys->wait_data);
             }
             continue;
         }
 
+        assert(stream_offset >= sys->buffer_offset);
+
+        ThreadResize(stream);
+
+        /* As long as there is space, the buffer will retain already read
+         * ("historical") data. The data can be used if/when seeking backward.
+         * Unread data is however given precedence if the buffer is full. */
+        uint64_t history = stream_offset - sys->buffer_offset;
+
         assert(sys->buffer_size >= sys->buffer_length);
 
         size_t len = sys->buffer_size - sys->buffer_length;
@@ -228,7 +509,8 @@ static void *Thread(void *data)
         {   /* Buffer is full */
             if (history == 0)
             {   /* Wait for data to be read */
-                vlc_cond_wait(&sys->wait_space, &sys->lock);
+                if (!ThreadHint(stream))
+                    vlc_cond_wait(&sys->wait_space, &sys->lock);
                 continue;
             }
 
@@ -256,6 +538,7 @@ static void *Thread(void *data)
         }
 
         assert((size_t)val <= len);
+        sys->source_offset += val;
         sys->buffer_length += val;
         assert(sys->buffer_length <= sys->buffer_size);
         //msg_Dbg(stream, "buffer: %zu/%zu", sys->buffer_length,
@@ -276,6 +559,7 @@ static int Seek(stream_t *stream, uint64_t offset)
     vlc_mutex_lock(&sys->lock);
     sys->stream_offset = offset;
     sys->error = false;
+    sys->rate_date = VLC_TICK_INVALID;
     vlc_cond_signal(&sys->wait_space);
     vlc_mutex_unlock(&sys->lock);
     return 0;
@@ -338,6 +622,23 @@ static ssize_t Read(stream_t *stream, void *buf, size_t buflen)
 
     memcpy(buf, sys->buffer + offset, copy);
     sys->stream_offset += copy;
+    sys->read_offset = sys->stream_offset;
+
+    /* Measure the consumption rate to size the buffer */
+    vlc_tick_t now = vlc_tick_now();
+    sys->rate_bytes += copy;
+    if (sys->rate_date == VLC_TICK_INVALID)
+    {
+        sys->rate_date = now;
+        sys->rate_bytes = 0;
+    }
+    else if (now - sys->rate_date >= PREFETCH_RATE_PERIOD)
+    {
+        uint64_t rate = sys->rate_bytes * CLOCK_FREQ / (now - sys->rate_date);
+        sys->rate = sys->rate ? (3 * sys->rate + rate) / 4 : rate;
+        sys->rate_date = now;
+        sys->rate_bytes = 0;
+    }
     vlc_cond_signal(&sys->wait_space);
     vlc_mutex_unlock(&sys->lock);
     return copy;
@@ -394,6 +695,7 @@ static int Control(stream_t *stream, int query, va_list args)
 
             vlc_mutex_lock(&sys->lock);
             sys->paused = paused;
+            sys->rate_date = VLC_TICK_INVALID;
             vlc_cond_signal(&sys->wait_space);
             vlc_mutex_unlock (&sys->lock);
             break;
@@ -421,6 +723,18 @@ static int Control(stream_t *stream, int query, va_list args)
         case STREAM_SET_PRIVATE_ID_CA:
         case STREAM_GET_PRIVATE_ID_STATE:
             return VLC_EGENERIC;
+        case STREAM_SET_PREFETCH_HINT:
+            if (!sys->can_seek)
+                return VLC_EGENERIC;
+
+            /* Replaces a hint not read yet */
+            vlc_mutex_lock(&sys->lock);
+            sys->hint_offset = va_arg(args, uint64_t);
+            sys->hint_length = va_arg(args, size_t);
+            sys->hint_pending = true;
+            vlc_cond_signal(&sys->wait_space);
+            vlc_mutex_unlock(&sys->lock);
+            break;
         default:
             msg_Err(stream, "unimplemented query (%d) in control", query);
             return VLC_EGENERIC;
@@ -469,9 +783,21 @@ static int Open(vlc_object_t *obj)
     sys->paused = false;
     sys->buffer_offset = 0;
     sys->stream_offset = 0;
+    sys->source_offset = 0;
+    sys->read_offset = 0;
     sys->buffer_length = 0;
     sys->buffer_size = var_InheritInteger(obj, "prefetch-buffer-size") << 10u;
+    sys->buffer_max = var_InheritInteger(obj, "prefetch-buffer-max") << 10u;
     sys->seek_threshold = var_InheritInteger(obj, "prefetch-seek-threshold");
+    sys->rate_date = VLC_TICK_INVALID;
+    sys->rate_bytes = 0;
+    sys->rate = 0;
+    sys->latency = 0;
+    sys->range_count = 0;
+    sys->history_size = var_InheritInteger(obj, "prefetch-history-size") << 10u;
+    sys->spare = NULL;
+    sys->spare_size = 0;
+    sys->hint_pending = false;
     sys->controls = NULL;
 
     uint64_t size = stream_Size(stream->s);
@@ -479,7 +805,11 @@ static int Open(vlc_object_t *obj)
     {   /* No point allocating a buffer larger than the source stream */
         if (sys->buffer_size > size)
             sys->buffer_size = size;
+        if (sys->buffer_max > size)
+            sys->buffer_max = size;
     }
+    if (sys->buffer_max < sys->buffer_size)
+        sys->buffer_max = sys->buffer_size;
 
     sys->buffer = malloc(sys->buffer_size);
     if (sys->buffer == NULL)
@@ -537,6 +867,9 @@ static void Close (vlc_object_t *obj)
         sys->controls = ctrl->next;
         free(ctrl);
     }
+    while (sys->range_count > 0)
+        free(sys->ranges[--sys->range_count].buffer);
+    free(sys->spare);
     free(sys->buffer);
     free(sys->content_type);
     free(sys);
@@ -552,6 +885,15 @@ vlc_module_begin()
     add_integer("prefetch-buffer-size", 1 << 14, N_("Buffer size"),
                 N_("Prefetch buffer size (KiB)"))
         change_integer_range(4, 1 << 20)
+    add_integer("prefetch-buffer-max", 1 << 17, N_("Maximum buffer size"),
+                N_("The buffer grows up to this size (KiB) to hold a few "
+                   "seconds of the stream at the rate it is read"))
+        change_integer_range(4, 1 << 22)
+    add_integer("prefetch-history-size", 1 << 15, N_("History size"),
+                N_("Data kept from the previous positions to serve seeks "
+                   "back to them, and read ahead at the demuxer "
+                   "request (KiB)"))
+        change_integer_range(0, 1 << 20)
     add_obsolete_integer("prefetch-read-size") /* since 4.0.0 */
     add_integer("prefetch-seek-threshold", 1 << 14, N_("Seek threshold"),
                 N_("Prefetch forward seek threshold (bytes)"))
@@ -208,6 +208,15 @@ static int Control(stream_t *stream, int query, va_list args)
                 *va_arg(args, uint64_t *) = size - sys->header_skip;
             return ret;
         }
+
+        case STREAM_SET_PREFETCH_HINT:
+        {
+            uint64_t offset = va_arg(args, uint64_t);
+            size_t length = va_arg(args, size_t);
+            return vlc_stream_SetPrefetchHint(stream->s,
+                                              sys->header_skip + offset,
+                                              length);
+        }
     }
 
     return vlc_stream_vaControl(stream->s, query, args);
@@ -30,13 +30,20 @@
 
 #include <vlc_common.h>
 
+#include <vlc_codec.h>
 #include <vlc_configuration.h>
 #include <vlc_frame.h>
+#include <vlc_picture.h>
 #include <vlc_plugin.h>
 #include <vlc_sout.h>
 #include <vlc_subpicture.h>
+#include <vlc_threads.h>
 #include <vlc_vector.h>
 
+#include "fanout.h"
+#include "transcode/pcr_helper.h"
+#include "transcode/pcr_sync.h"
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -75,23 +82,45 @@ typedef struct {
     /* Last PCR forwarded at the end of the stream chain or VLC_TICK_MIN when
      * unset. */
     vlc_tick_t pcr;
+
+    /* Serializes the calls to the duplicated sout chain, which is also fed
+     * from the fanout thread when a decoder is shared. */
+    vlc_mutex_t lock;
+    /* Decoded pictures for this chain, created with the first output of a
+     * shared decoder. */
+    vlc_fanout_queue_t *fanout;
+    size_t fanout_depth;
+    enum vlc_fanout_policy fanout_policy;
 } duplicated_stream_t;
 
 typedef struct
 {
     struct VLC_VECTOR(duplicated_stream_t) streams;
+
+    /* Serializes the PCR selectors, which all forward to the same sink. */
+    vlc_mutex_t sink_lock;
+
+    /* Decode the video ES once for all the duplicated streams. */
+    bool decode;
+    vlc_pcr_sync_t *pcr_sync;
+    unsigned int decoder_count;
 } sout_stream_sys_t;
 
+typedef struct shared_decoder shared_decoder_t;
+
 typedef struct {
     void *id;
     char *es_id;
     /* Reference to the duplicated output stream. */
-    sout_stream_t *stream_owner;
+    duplicated_stream_t *dup_stream;
 } duplicated_id_t;
 
 typedef struct
 {
     struct VLC_VECTOR(duplicated_id_t) dup_ids;
+    /* Decoder feeding all the duplicated streams, or NULL when they
+     * receive the ES as is. */
+    shared_decoder_t *decoder;
 } sout_stream_id_sys_t;
 
 static bool ESSelected( struct vlc_logger *, const es_format_t *fmt,
@@ -103,36 +132,63 @@ static bool ESSelected( struct vlc_logger *, const es_format_t *fmt,
  * The PCR selector is the endpoint of each duplicated sout chains before they
  * are linked back to the main pipeline. It is used to regroup PCR from each
  * duplicated stream and select the lowest to forward it to the sink.
+ *
+ * With a shared decoder, the duplicated chains are fed from several threads
+ * and the selectors serialize what reaches the sink.
  *****************************************************************************/
 
 static void *PCRSelectorAdd( sout_stream_t *stream,
                              const es_format_t *fmt,
                              const char *es_id )
 {
-    return sout_StreamIdAdd( stream->p_next, fmt, es_id );
+    sout_stream_sys_t *sys = stream->p_sys;
+
+    vlc_mutex_lock( &sys->sink_lock );
+    void *id = sout_StreamIdAdd( stream->p_next, fmt, es_id );
+    vlc_mutex_unlock( &sys->sink_lock );
+    return id;
 }
 static void PCRSelectorDel( sout_stream_t *stream, void *id )
 {
+    sout_stream_sys_t *sys = stream->p_sys;
+
+    vlc_mutex_lock( &sys->sink_lock );
     sout_StreamIdDel( stream->p_next, id );
+    vlc_mutex_unlock( &sys->sink_lock );
 }
 static int PCRSelectorControl( sout_stream_t *stream, int query, va_list args )
 {
-    return sout_StreamControlVa( stream->p_next, query, args );
+    sout_stream_sys_t *sys = stream->p_sys;
+
+    vlc_mutex_lock( &sys->sink_lock );
+    int ret = sout_StreamControlVa( stream->p_next, query, args );
+    vlc_mutex_unlock( &sys->sink_lock );
+    return ret;
 }
 static int PCRSelectorSend( sout_stream_t *stream,
                             void *id,
                             vlc_frame_t *frame )
 {
-    return sout_StreamIdSend( stream->p_next, id, frame );
+    sout_stream_sys_t *sys = stream->p_sys;
+
+    vlc_mutex_lock( &sys->sink_lock );
+    int ret = sout_StreamIdSend( stream->p_next, id, frame );
+    vlc_mutex_unlock( &sys->sink_lock );
+    return ret;
 }
 static void PCRSelectorFlush( sout_stream_t *stream, void *id )
 {
+    sout_stream_sys_t *sys = stream->p_sys;
+
+    vlc_mutex_lock( &sys->sink_lock );
     sout_StreamFlush( stream->p_next, id );
+    vlc_mutex_unlock( &sys->sink_lock );
 }
 static void PCRSelectorSetPCR( sout_stream_t *stream, vlc_tick_t pcr )
 {
     sout_stream_sys_t *sys = stream->p_sys;
 
+    vlc_mutex_lock( &sys->sink_lock );
     vlc_tick_t min_pcr = pcr;
     duplicated_stream_t *dup;
     vlc_vector_foreach_ref( dup, &sys->streams )
@@ -145,14 +201,15 @@ static void PCRSelectorSetPCR( sout_stream_t *stream, vlc_tick_t pcr )
 
     /* One of the selector has not received a PCR yet and was defaulted to
      * VLC_TICK_MIN. */
-    if( min_pcr == VLC_TICK_MIN )
-        return;
-
-    sout_StreamSetPCR( stream->p_next, min_pcr );
+    if( min_pcr != VLC_TICK_MIN )
+    {
+        sout_StreamSetPCR( stream->p_next, min_pcr );
 
-    /* Reset all selectors PCR values. */
-    vlc_vector_foreach_ref( dup, &sys->streams )
-        dup->pcr = VLC_TICK_MIN;
+        /* Reset all selectors PCR values. */
+        vlc_vector_foreach_ref( dup, &sys->streams )
+            dup->pcr = VLC_TICK_MIN;
+    }
+    vlc_mutex_unlock( &sys->sink_lock );
 }
 
 static sout_stream_t *PCRSelectorNew( sout_stream_t *parent )
@@ -176,6 +233,425 @@ static sout_stream_t *PCRSelectorNew( sout_stream_t *parent )
     return selector;
 }
 
+/*****************************************************************************
+ * Shared decoder
+ *
+ * With the decode option, a video ES is decoded once and every duplicated
+ * stream receives the pictures as raw video. The pictures are handed to the
+ * fanout queue of each duplicated stream, whose thread copies them into
+ * frames and feeds the stream chain, so that a slow chain only holds up the
+ * others when its queue blocks.
+ *
+ * The queue and backpressure options apply to the last dst given, e.g.
+ *   duplicate{decode,dst=display,backpressure=drop,
+ *             dst=transcode{vcodec=h264,scale=0.25}:std{...},queue=8}
+ *****************************************************************************/
+
+/* Longest a picture is expected to stay in the decoder, see pcr_helper.h */
+#define SHARED_DECODER_MAX_DELAY VLC_TICK_FROM_SEC(1)
+
+typedef struct
+{
+    shared_decoder_t *owner;
+    duplicated_stream_t *dup_stream;
+    char *es_id;
+
+    /* Raw ES, added when the decoder output format is set and again when it
+     * changes, under the stream lock. */
+    void *id;
+    video_format_t fmt;
+} shared_output_t;
+
+struct shared_decoder
+{
+    decoder_t dec;
+    es_format_t fmt_in;
+    sout_stream_t *stream;
+
+    struct VLC_VECTOR(shared_output_t *) outputs;
+    transcode_track_pcr_helper_t *pcr_helper;
+    /* The decoder output format is set, see SharedDecoderUpdateFormat() */
+    bool has_format;
+
+    /* Dates of the pictures output since the last PCR update */
+    vlc_mutex_t lock;
+    struct VLC_VECTOR(vlc_tick_t) dates;
+};
+
+static vlc_tick_t FrameLength( const video_format_t *fmt )
+{
+    if( fmt->i_frame_rate == 0 || fmt->i_frame_rate_base == 0 )
+        return 0;
+    return vlc_tick_from_samples( fmt->i_frame_rate_base, fmt->i_frame_rate );
+}
+
+/* Lays the planes out the way the rawvideo decoder reads them. */
+static vlc_frame_t *PackPicture( const picture_t *pic )
+{
+    const video_format_t *fmt = &pic->format;
+    const vlc_chroma_description_t *dsc =
+        vlc_fourcc_GetChromaDescription( fmt->i_chroma );
+    if( dsc == NULL || dsc->plane_count == 0 )
+        return NULL;
+
+    size_t pitches[PICTURE_PLANE_MAX];
+    size_t lines[PICTURE_PLANE_MAX];
+    size_t size = 0;
+    for( unsigned i = 0; i < dsc->plane_count; i++ )
+    {
+        pitches[i] = (fmt->i_width + dsc->p[i].w.den - 1) / dsc->p[i].w.den
+                   * dsc->p[i].w.num * dsc->pixel_size;
+        lines[i] = (fmt->i_height + dsc->p[i].h.den - 1) / dsc->p[i].h.den
+                 * dsc->p[i].h.num;
+        size += pitches[i] * lines[i];
+    }
+
+    vlc_frame_t *frame = vlc_frame_Alloc( size );
+    if( unlikely(frame == NULL) )
+        return NULL;
+
+    uint8_t *dst = frame->p_buffer;
+    for( unsigned i = 0; i < dsc->plane_count; i++ )
+    {
+        const plane_t *plane = &pic->p[i];
+        const uint8_t *src = plane->p_pixels;
+        const size_t width = __MIN( pitches[i], (size_t)plane->i_pitch );
+        const size_t count = __MIN( lines[i], (size_t)plane->i_lines );
+
+        for( size_t y = 0; y < count; y++ )
+        {
+            memcpy( dst, src, width );
+            src += plane->i_pitch;
+            dst += pitches[i];
+        }
+        memset( dst, 0, (lines[i] - count) * pitches[i] );
+        dst += (lines[i] - count) * pitches[i];
+    }
+
+    frame->i_dts = frame->i_pts = pic->date;
+    frame->i_length = FrameLength( fmt );
+    frame->i_flags |= VLC_FRAME_FLAG_TYPE_I;
+    if( !pic->b_progressive )
+    {
+        frame->i_flags |= pic->b_top_field_first
+                        ? VLC_FRAME_FLAG_TOP_FIELD_FIRST
+                        : VLC_FRAME_FLAG_BOTTOM_FIELD_FIRST;
+        if( pic->i_nb_fields == 1 )
+            frame->i_flags |= VLC_FRAME_FLAG_SINGLE_FIELD;
+    }
+    return frame;
+}
+
+static void SharedOutputReset( shared_output_t *output,
+                               const video_format_t *fmt )
+{
+    sout_stream_t *stream = output->dup_stream->stream;
+    const es_format_t *fmt_in = &output->owner->fmt_in;
+
+    vlc_mutex_assert( &output->dup_stream->lock );
+    if( output->id != NULL )
+        sout_StreamIdDel( stream, output->id );
+
+    video_format_Clean( &output->fmt );
+    video_format_Copy( &output->fmt, fmt );
+
+    es_format_t raw;
+    es_format_Init( &raw, VIDEO_ES, fmt->i_chroma );
+    video_format_Copy( &raw.video, fmt );
+    raw.i_id = fmt_in->i_id;
+    raw.i_group = fmt_in->i_group;
+    raw.psz_language = fmt_in->psz_language;
+    raw.psz_description = fmt_in->psz_description;
+
+    output->id = sout_StreamIdAdd( stream, &raw, output->es_id );
+    if( output->id == NULL )
+        msg_Err( output->owner->stream, "cannot add raw %4.4s ES `%s'",
+                 (const char *)&fmt->i_chroma, output->es_id );
+
+    raw.psz_language = raw.psz_description = NULL;
+    es_format_Clean( &raw );
+}
+
+static void FanoutPicture( void *opaque, void *tag, picture_t *pic )
+{
+    duplicated_stream_t *dup_stream = opaque;
+    shared_output_t *output = tag;
+
+    /* Copy out of the lock, in parallel with the other streams */
+    vlc_frame_t *frame = PackPicture( pic );
+
+    vlc_mutex_lock( &dup_stream->lock );
+    if( frame != NULL && output->id != NULL )
+        sout_StreamIdSend( dup_stream->stream, output->id, frame );
+    else if( frame != NULL )
+        vlc_frame_Release( frame );
+    vlc_mutex_unlock( &dup_stream->lock );
+
+    picture_Release( pic );
+}
+
+static void FanoutPCR( void *opaque, vlc_tick_t pcr )
+{
+    duplicated_stream_t *dup_stream = opaque;
+
+    vlc_mutex_lock( &dup_stream->lock );
+    sout_StreamSetPCR( dup_stream->stream, pcr );
+    vlc_mutex_unlock( &dup_stream->lock );
+}
+
+/* The PCR reaches the streams with a fanout after the pictures queued
+ * before it. */
+static void BroadcastPCR( sout_stream_t *p_stream, vlc_tick_t pcr )
+{
+    sout_stream_sys_t *sys = p_stream->p_sys;
+
+    duplicated_stream_t *dup_stream;
+    vlc_vector_foreach_ref( dup_stream, &sys->streams )
+    {
+        if( dup_stream->fanout == NULL ||
+            vlc_fanout_queue_PushPCR( dup_stream->fanout, pcr ) != VLC_SUCCESS )
+            FanoutPCR( dup_stream, pcr );
+    }
+}
+
+static vlc_decoder_device *SharedDecoderGetDevice( decoder_t *p_dec )
+{
+    /* The pictures are copied for every stream, keep them in memory */
+    (void) p_dec;
+    return NULL;
+}
+
+static int SharedDecoderUpdateFormat( decoder_t *p_dec,
+                                      vlc_video_context *vctx )
+{
+    const vlc_fourcc_t chroma = p_dec->fmt_out.video.i_chroma;
+    const vlc_chroma_description_t *dsc =
+        vlc_fourcc_GetChromaDescription( chroma );
+
+    if( vctx != NULL || dsc == NULL || dsc->plane_count == 0 )
+    {
+        msg_Err( p_dec, "cannot share %4.4s pictures",
+                 (const char *)&chroma );
+        return VLC_EGENERIC;
+    }
+
+    shared_decoder_t *dec = container_of( p_dec, shared_decoder_t, dec );
+    const video_format_t *fmt = &p_dec->fmt_out.video;
+
+    shared_output_t *output;
+    vlc_vector_foreach( output, &dec->outputs )
+    {
+        if( output->id != NULL &&
+            video_format_IsSimilar( &output->fmt, fmt ) )
+            continue;
+
+        /* The pictures in the previous format go to the previous ES */
+        vlc_fanout_queue_Wait( output->dup_stream->fanout, output );
+
+        vlc_mutex_lock( &output->dup_stream->lock );
+        SharedOutputReset( output, fmt );
+        vlc_mutex_unlock( &output->dup_stream->lock );
+    }
+    dec->has_format = true;
+    return VLC_SUCCESS;
+}
+
+static void SharedDecoderQueue( decoder_t *p_dec, picture_t *pic )
+{
+    shared_decoder_t *dec = container_of( p_dec, shared_decoder_t, dec );
+
+    shared_output_t *output;
+    vlc_vector_foreach( output, &dec->outputs )
+    {
+        if( vlc_fanout_queue_PushPicture( output->dup_stream->fanout,
+                                          output, pic ) != VLC_SUCCESS )
+            msg_Err( p_dec, "cannot queue picture for `%s'", output->es_id );
+    }
+
+    vlc_mutex_lock( &dec->lock );
+    if( !vlc_vector_push( &dec->dates, pic->date ) )
+        msg_Err( p_dec, "cannot track picture date" );
+    vlc_mutex_unlock( &dec->lock );
+
+    picture_Release( pic );
+}
+
+/* Forwards the PCR following the pictures output by the decoder. */
+static void SharedDecoderUpdatePCR( sout_stream_t *p_stream,
+                                    shared_decoder_t *dec )
+{
+    const vlc_tick_t length = FrameLength( &dec->dec.fmt_out.video );
+    vlc_tick_t pcr = VLC_TICK_INVALID;
+
+    vlc_mutex_lock( &dec->lock );
+    vlc_tick_t date;
+    vlc_vector_foreach( date, &dec->dates )
+    {
+        const vlc_frame_t out = {
+            .i_dts = date, .i_pts = date, .i_length = length,
+        };
+        vlc_tick_t next;
+        if( transcode_track_pcr_helper_SignalLeavingFrame( dec->pcr_helper,
+                                                           &out, &next )
+                == VLC_SUCCESS && next != VLC_TICK_INVALID )
+            pcr = next;
+    }
+    vlc_vector_clear( &dec->dates );
+    vlc_mutex_unlock( &dec->lock );
+
+    if( pcr != VLC_TICK_INVALID )
+        BroadcastPCR( p_stream, pcr );
+}
+
+static shared_decoder_t *SharedDecoderNew( sout_stream_t *p_stream,
+                                           const es_format_t *fmt )
+{
+    sout_stream_sys_t *sys = p_stream->p_sys;
+
+    shared_decoder_t *dec = vlc_object_create( p_stream, sizeof(*dec) );
+    if( unlikely(dec == NULL) )
+        return NULL;
+
+    dec->stream = p_stream;
+    dec->has_format = false;
+    vlc_vector_init( &dec->outputs );
+    vlc_mutex_init( &dec->lock );
+    vlc_vector_init( &dec->dates );
+
+    decoder_Init( &dec->dec, &dec->fmt_in, fmt );
+
+    static const struct decoder_owner_callbacks cbs =
+    {
+        .video = {
+            .get_device = SharedDecoderGetDevice,
+            .format_update = SharedDecoderUpdateFormat,
+            .queue = SharedDecoderQueue,
+        },
+    };
+    dec->dec.cbs = &cbs;
+
+    if( decoder_LoadModule( &dec->dec, false, true ) != VLC_SUCCESS )
+    {
+        msg_Err( p_stream, "cannot find a video decoder for fcc=`%4.4s'",
+                 (const char *)&fmt->i_codec );
+        goto error;
+    }
+
+    dec->pcr_helper = transcode_track_pcr_helper_New( sys->pcr_sync,
+                                                      SHARED_DECODER_MAX_DELAY );
+    if( unlikely(dec->pcr_helper == NULL) )
+        goto error;
+
+    sys->decoder_count++;
+    return dec;
+
+error:
+    decoder_Clean( &dec->dec );
+    es_format_Clean( &dec->fmt_in );
+    vlc_object_delete( &dec->dec );
+    return NULL;
+}
+
+static int SharedDecoderAddOutput( shared_decoder_t *dec,
+                                   duplicated_stream_t *dup_stream,
+                                   char *es_id )
+{
+    if( dup_stream->fanout == NULL )
+    {
+        static const struct vlc_fanout_cbs cbs = {
+            .picture = FanoutPicture,
+            .pcr = FanoutPCR,
+        };
+        dup_stream->fanout =
+            vlc_fanout_queue_New( &cbs, dup_stream, dup_stream->fanout_depth,
+                                  dup_stream->fanout_policy );
+        if( dup_stream->fanout == NULL )
+            return VLC_ENOMEM;
+    }
+
+    shared_output_t *output = malloc( sizeof(*output) );
+    if( unlikely(output == NULL) )
+        return VLC_ENOMEM;
+
+    output->owner = dec;
+    output->dup_stream = dup_stream;
+    output->es_id = es_id;
+    output->id = NULL;
+    video_format_Init( &output->fmt, 0 );
+
+    if( !vlc_vector_push( &dec->outputs, output ) )
+    {
+        free( output );
+        return VLC_ENOMEM;
+    }
+
+    /* The decoder may have set its output format while loading */
+    if( dec->has_format )
+    {
+        vlc_mutex_lock( &dup_stream->lock );
+        SharedOutputReset( output, &dec->dec.fmt_out.video );
+        vlc_mutex_unlock( &dup_stream->lock );
+    }
+    return VLC_SUCCESS;
+}
+
+static int SharedDecoderSend( sout_stream_t *p_stream, shared_decoder_t *dec,
+                              vlc_frame_t *frame )
+{
+    vlc_tick_t dropped_pcr;
+    if( transcode_track_pcr_helper_SignalEnteringFrame( dec->pcr_helper, frame,
+                                                        &dropped_pcr )
+            == VLC_SUCCESS && dropped_pcr != VLC_TICK_INVALID )
+        BroadcastPCR( p_stream, dropped_pcr );
+
+    int ret = dec->dec.pf_decode( &dec->dec, frame );
+    SharedDecoderUpdatePCR( p_stream, dec );
+
+    return ret == VLCDEC_SUCCESS ? VLC_SUCCESS : VLC_EGENERIC;
+}
+
+static void SharedDecoderDelete( sout_stream_t *p_stream,
+                                 shared_decoder_t *dec )
+{
+    sout_stream_sys_t *sys = p_stream->p_sys;
+
+    /* Drain, then let every stream catch up before removing its ES */
+    dec->dec.pf_decode( &dec->dec, NULL );
+    SharedDecoderUpdatePCR( p_stream, dec );
+
+    shared_output_t *output;
+    vlc_vector_foreach( output, &dec->outputs )
+    {
+        duplicated_stream_t *dup_stream = output->dup_stream;
+
+        vlc_fanout_queue_Wait( dup_stream->fanout, output );
+
+        vlc_mutex_lock( &dup_stream->lock );
+        if( output->id != NULL )
+            sout_StreamIdDel( dup_stream->stream, output->id );
+        vlc_mutex_unlock( &dup_stream->lock );
+
+        const size_t dropped = vlc_fanout_queue_GetDropped( dup_stream->fanout );
+        if( dropped > 0 )
+            msg_Dbg( p_stream, "%zu picture(s) dropped so far for `%s'",
+                     dropped, output->es_id );
+
+        video_format_Clean( &output->fmt );
+        free( output->es_id );
+        free( output );
+    }
+    vlc_vector_destroy( &dec->outputs );
+    vlc_vector_destroy( &dec->dates );
+
+    transcode_track_pcr_helper_Delete( dec->pcr_helper );
+    sys->decoder_count--;
+
+    /* The decoder module may use its input format until it is unloaded */
+    decoder_Clean( &dec->dec );
+    es_format_Clean( &dec->fmt_in );
+    vlc_object_delete( &dec->dec );
+}
+
 /*****************************************************************************
  * Control
  *****************************************************************************/
@@ -192,8 +668,12 @@ static int Control( sout_stream_t *p_stream, int i_query, va_list args )
             duplicated_id_t *dup_id;
             vlc_vector_foreach_ref( dup_id, &id->dup_ids )
             {
+                duplicated_stream_t *dup_stream = dup_id->dup_stream;
+
+                vlc_mutex_lock( &dup_stream->lock );
                 sout_StreamControl(
-                    dup_id->stream_owner, i_query, dup_id->id, spu_hl );
+                    dup_stream->stream, i_query, dup_id->id, spu_hl );
+                vlc_mutex_unlock( &dup_stream->lock );
             }
             return VLC_SUCCESS;
         }
@@ -213,12 +693,16 @@ static void Close( sout_stream_t * p_stream )
     duplicated_stream_t *dup_stream;
     vlc_vector_foreach_ref( dup_stream, &p_sys->streams )
     {
+        if( dup_stream->fanout != NULL )
+            vlc_fanout_queue_Delete( dup_stream->fanout );
         sout_StreamChainDelete( dup_stream->stream, p_stream->p_next );
         free( dup_stream->select_chain );
         free( dup_stream->es_id_suffix );
     }
     vlc_vector_destroy( &p_sys->streams );
 
+    if( p_sys->pcr_sync != NULL )
+        vlc_pcr_sync_Delete( p_sys->pcr_sync );
     free( p_sys );
 }
 
@@ -245,6 +729,10 @@ static int Open( vlc_object_t *p_this )
         return VLC_ENOMEM;
 
     vlc_vector_init( &p_sys->streams );
+    vlc_mutex_init( &p_sys->sink_lock );
+    p_sys->decode = false;
+    p_sys->pcr_sync = NULL;
+    p_sys->decoder_count = 0;
 
     p_stream->p_sys = p_sys;
 
@@ -252,7 +740,11 @@ static int Open( vlc_object_t *p_this )
     {
         if( !strncmp( p_cfg->psz_name, "dst", strlen( "dst" ) ) )
         {
-            duplicated_stream_t dup_stream = { .pcr = VLC_TICK_MIN };
+            duplicated_stream_t dup_stream = {
+                .pcr = VLC_TICK_MIN,
+                .fanout_depth = 4,
+                .fanout_policy = VLC_FANOUT_BLOCK,
+            };
 
             sout_stream_t *sink = NULL;
             if( p_stream->p_next != NULL )
@@ -315,6 +807,58 @@ static int Open( vlc_object_t *p_this )
                 vlc_vector_last_ref( &p_sys->streams )->es_id_suffix = name;
             }
         }
+        else if( !strncmp( p_cfg->psz_name, "decode", strlen( "decode" ) ) )
+        {
+            const char *value = p_cfg->psz_value;
+
+            p_sys->decode = value == NULL || value[0] == '\0' ||
+                            !strcmp( value, "1" ) ||
+                            !strcasecmp( value, "yes" ) ||
+                            !strcasecmp( value, "true" );
+        }
+        else if( !strncmp( p_cfg->psz_name, "queue", strlen( "queue" ) ) )
+        {
+            const char *value = p_cfg->psz_value;
+            const int depth = value != NULL ? atoi( value ) : 0;
+
+            if( p_sys->streams.size == 0 || depth <= 0 )
+            {
+                msg_Err( p_stream, " * ignore queue depth `%s'",
+                         value != NULL ? value : "" );
+            }
+            else
+            {
+                msg_Dbg( p_stream, " * apply queue depth %d", depth );
+                vlc_vector_last_ref( &p_sys->streams )->fanout_depth = depth;
+            }
+        }
+        else if( !strncmp( p_cfg->psz_name, "backpressure",
+                           strlen( "backpressure" ) ) )
+        {
+            const char *value = p_cfg->psz_value;
+            enum vlc_fanout_policy policy;
+
+            if( value != NULL && !strcmp( value, "drop" ) )
+                policy = VLC_FANOUT_DROP;
+            else if( value != NULL && !strcmp( value, "block" ) )
+                policy = VLC_FANOUT_BLOCK;
+            else
+            {
+                msg_Err( p_stream, " * ignore backpressure `%s'",
+                         value != NULL ? value : "" );
+                continue;
+            }
+
+            if( p_sys->streams.size == 0 )
+            {
+                msg_Err( p_stream, " * ignore backpressure `%s'", value );
+            }
+            else
+            {
+                msg_Dbg( p_stream, " * apply backpressure `%s'", value );
+                vlc_vector_last_ref( &p_sys->streams )->fanout_policy = policy;
+            }
+        }
         else
         {
             msg_Err( p_stream, " * ignore unknown option `%s'", p_cfg->psz_name );
@@ -329,6 +873,18 @@ static int Open( vlc_object_t *p_this )
         return VLC_EGENERIC;
     }
 
+    /* The streams do not move anymore */
+    duplicated_stream_t *dup_stream;
+    vlc_vector_foreach_ref( dup_stream, &p_sys->streams )
+        vlc_mutex_init( &dup_stream->lock );
+
+    if( p_sys->decode )
+    {
+        p_sys->pcr_sync = vlc_pcr_sync_New();
+        if( unlikely(p_sys->pcr_sync == NULL) )
+            goto nomem;
+    }
+
     p_stream->ops = &ops;
     return VLC_SUCCESS;
 nomem:
@@ -373,10 +929,18 @@ Add( sout_stream_t *p_stream, const es_format_t *p_fmt, const char *es_id )
         return NULL;
 
     vlc_vector_init( &id->dup_ids );
+    id->decoder = NULL;
 
     msg_Dbg( p_stream, "duplicated a new stream codec=%4.4s (es=%d group=%d)",
              (char*)&p_fmt->i_codec, p_fmt->i_id, p_fmt->i_group );
 
+    if( p_sys->decode && p_fmt->i_cat == VIDEO_ES )
+    {
+        id->decoder = SharedDecoderNew( p_stream, p_fmt );
+        if( id->decoder == NULL )
+            msg_Warn( p_stream, "    - not decoded once for all outputs" );
+    }
+
     duplicated_stream_t *dup_stream;
     vlc_vector_foreach_ref( dup_stream, &p_sys->streams )
     {
@@ -389,8 +953,22 @@ Add( sout_stream_t *p_stream, const es_format_t *p_fmt, const char *es_id )
             if( unlikely(dup_es_id == NULL) )
                 goto error;
 
+            if( id->decoder != NULL )
+            {
+                if( SharedDecoderAddOutput( id->decoder, dup_stream,
+                                            dup_es_id ) != VLC_SUCCESS )
+                {
+                    free( dup_es_id );
+                    goto error;
+                }
+                msg_Dbg( p_stream, "    - decoded for output %zu", idx );
+                continue;
+            }
+
+            vlc_mutex_lock( &dup_stream->lock );
             void *next_id = sout_StreamIdAdd( dup_stream->stream,
                                               p_fmt, dup_es_id );
+            vlc_mutex_unlock( &dup_stream->lock );
             if( next_id == NULL )
             {
                 free(dup_es_id);
@@ -402,11 +980,13 @@ Add( sout_stream_t *p_stream, const es_format_t *p_fmt, const char *es_id )
             const duplicated_id_t dup_id = {
                 .id = next_id,
                 .es_id = dup_es_id,
-                .stream_owner = dup_stream->stream,
+                .dup_stream = dup_stream,
             };
             if( !vlc_vector_push(&id->dup_ids, dup_id) )
             {
+                vlc_mutex_lock( &dup_stream->lock );
                 sout_StreamIdDel( dup_stream->stream, next_id );
+                vlc_mutex_unlock( &dup_stream->lock );
                 free( dup_id.es_id );
                 goto error;
             }
@@ -417,7 +997,8 @@ Add( sout_stream_t *p_stream, const es_format_t *p_fmt, const char *es_id )
         }
     }
 
-    if( id->dup_ids.size > 0 )
+    if( id->dup_ids.size > 0 ||
+        (id->decoder != NULL && id->decoder->outputs.size > 0) )
         return id;
 error:
     Del( p_stream, id );
@@ -431,16 +1012,22 @@ static void Del( sout_stream_t *p_stream, void *_id )
 {
     sout_stream_id_sys_t *id = (sout_stream_id_sys_t *)_id;
 
+    if( id->decoder != NULL )
+        SharedDecoderDelete( p_stream, id->decoder );
+
     duplicated_id_t *dup_id;
     vlc_vector_foreach_ref( dup_id, &id->dup_ids )
     {
-        sout_StreamIdDel( dup_id->stream_owner, dup_id->id );
+        duplicated_stream_t *dup_stream = dup_id->dup_stream;
+
+        vlc_mutex_lock( &dup_stream->lock );
+        sout_StreamIdDel( dup_stream->stream, dup_id->id );
+        vlc_mutex_unlock( &dup_stream->lock );
         free( dup_id->es_id );
     }
     vlc_vector_destroy( &id->dup_ids );
 
     free( id );
-    (void)p_stream;
 }
 
 /*****************************************************************************
@@ -450,6 +1037,9 @@ static int Send( sout_stream_t *p_stream, void *_id, vlc_frame_t *frame )
 {
     sout_stream_id_sys_t *id = (sout_stream_id_sys_t *)_id;
 
+    if( id->decoder != NULL )
+        return SharedDecoderSend( p_stream, id->decoder, frame );
+
     /* Should be ensured in `Add`. */
     assert(id->dup_ids.size > 0);
 
@@ -464,10 +1054,13 @@ static int Send( sout_stream_t *p_stream, void *_id, vlc_frame_t *frame )
             return VLC_ENOMEM;
         }
 
-        sout_StreamIdSend( dup_id->stream_owner, dup_id->id, to_send );
+        duplicated_stream_t *dup_stream = dup_id->dup_stream;
+
+        vlc_mutex_lock( &dup_stream->lock );
+        sout_StreamIdSend( dup_stream->stream, dup_id->id, to_send );
+        vlc_mutex_unlock( &dup_stream->lock );
     }
 
-    (void)p_stream;
     return VLC_SUCCESS;
 }
 
@@ -475,11 +1068,12 @@ static void SetPCR( sout_stream_t *stream, vlc_tick_t pcr )
 {
     sout_stream_sys_t *sys = stream->p_sys;
 
-    duplicated_stream_t *dup_stream;
-    vlc_vector_foreach_ref( dup_stream, &sys->streams )
-    {
-        sout_StreamSetPCR( dup_stream->stream, pcr );
-    }
+    /* Held back until the decoders output the pictures preceding it */
+    if( sys->decoder_count > 0 &&
+        vlc_pcr_sync_SignalPCR( sys->pcr_sync, pcr ) != VLC_PCR_SYNC_FORWARD_PCR )
+        return;
+
+    BroadcastPCR( stream, pcr );
 }
 
 /*****************************************************************************
@@ -0,0 +1,253 @@
+/*****************************************************************************
+ * fanout.c: picture queue feeding one stream output consumer
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <assert.h>
+
+#include "fanout.h"
+
+#include <vlc_list.h>
+#include <vlc_threads.h>
+
+typedef struct
+{
+    picture_t *pic; /* NULL for a PCR */
+    void *tag;
+    vlc_tick_t pcr;
+    struct vlc_list node;
+} fanout_entry_t;
+
+struct vlc_fanout_queue
+{
+    const struct vlc_fanout_cbs *cbs;
+    void *opaque;
+    size_t depth;
+    enum vlc_fanout_policy policy;
+
+    vlc_mutex_t lock;
+    vlc_cond_t wait_entry;    /**< signaled to the thread */
+    vlc_cond_t wait_progress; /**< signaled by the thread */
+    struct vlc_list entries;
+    size_t picture_count;
+    /* Entry being consumed outside of the lock */
+    bool busy;
+    void *busy_tag;
+    size_t dropped;
+    bool closing;
+
+    vlc_thread_t thread;
+};
+
+static bool EntryMatches(const fanout_entry_t *entry, void *tag)
+{
+    return tag == NULL || entry->tag == tag;
+}
+
+static void EntryDelete(fanout_entry_t *entry)
+{
+    if (entry->pic != NULL)
+        picture_Release(entry->pic);
+    free(entry);
+}
+
+static void *Thread(void *data)
+{
+    vlc_thread_set_name("vlc-sout-fanout");
+
+    vlc_fanout_queue_t *queue = data;
+
+    vlc_mutex_lock(&queue->lock);
+    for (;;)
+    {
+        while (!queue->closing && vlc_list_is_empty(&queue->entries))
+            vlc_cond_wait(&queue->wait_entry, &queue->lock);
+        if (queue->closing)
+            break;
+
+        fanout_entry_t *entry =
+            vlc_list_first_entry_or_null(&queue->entries, fanout_entry_t, node);
+        vlc_list_remove(&entry->node);
+        if (entry->pic != NULL)
+            queue->picture_count--;
+        queue->busy = true;
+        queue->busy_tag = entry->tag;
+        /* There is room for a blocked picture */
+        vlc_cond_broadcast(&queue->wait_progress);
+        vlc_mutex_unlock(&queue->lock);
+
+        if (entry->pic != NULL)
+        {
+            queue->cbs->picture(queue->opaque, entry->tag, entry->pic);
+            entry->pic = NULL;
+        }
+        else
+            queue->cbs->pcr(queue->opaque, entry->pcr);
+        EntryDelete(entry);
+
+        vlc_mutex_lock(&queue->lock);
+        queue->busy = false;
+        vlc_cond_broadcast(&queue->wait_progress);
+    }
+    vlc_mutex_unlock(&queue->lock);
+
+    return NULL;
+}
+
+vlc_fanout_queue_t *vlc_fanout_queue_New(const struct vlc_fanout_cbs *cbs,
+                                         void *opaque, size_t depth,
+                                         enum vlc_fanout_policy policy)
+{
+    assert(depth > 0);
+
+    vlc_fanout_queue_t *queue = malloc(sizeof(*queue));
+    if (unlikely(queue == NULL))
+        return NULL;
+
+    queue->cbs = cbs;
+    queue->opaque = opaque;
+    queue->depth = depth;
+    queue->policy = policy;
+
+    vlc_mutex_init(&queue->lock);
+    vlc_cond_init(&queue->wait_entry);
+    vlc_cond_init(&queue->wait_progress);
+    vlc_list_init(&queue->entries);
+    queue->picture_count = 0;
+    queue->busy = false;
+    queue->busy_tag = NULL;
+    queue->dropped = 0;
+    queue->closing = false;
+
+    if (vlc_clone(&queue->thread, Thread, queue))
+    {
+        free(queue);
+        return NULL;
+    }
+    return queue;
+}
+
+void vlc_fanout_queue_Delete(vlc_fanout_queue_t *queue)
+{
+    vlc_mutex_lock(&queue->lock);
+    queue->closing = true;
+    vlc_cond_signal(&queue->wait_entry);
+    vlc_mutex_unlock(&queue->lock);
+
+    vlc_join(queue->thread, NULL);
+
+    fanout_entry_t *entry;
+    vlc_list_foreach(entry, &queue->entries, node)
+        EntryDelete(entry);
+    free(queue);
+}
+
+static void Append(vlc_fanout_queue_t *queue, fanout_entry_t *entry)
+{
+    vlc_list_append(&entry->node, &queue->entries);
+    vlc_cond_signal(&queue->wait_entry);
+}
+
+int vlc_fanout_queue_PushPicture(vlc_fanout_queue_t *queue, void *tag,
+                                 picture_t *pic)
+{
+    fanout_entry_t *entry = malloc(sizeof(*entry));
+    if (unlikely(entry == NULL))
+        return VLC_ENOMEM;
+
+    entry->pic = picture_Hold(pic);
+    entry->tag = tag;
+    entry->pcr = VLC_TICK_INVALID;
+
+    vlc_mutex_lock(&queue->lock);
+    if (queue->policy == VLC_FANOUT_BLOCK)
+    {
+        while (queue->picture_count >= queue->depth)
+            vlc_cond_wait(&queue->wait_progress, &queue->lock);
+    }
+    else if (queue->picture_count >= queue->depth)
+    {
+        /* The oldest picture is the least useful to a late consumer */
+        fanout_entry_t *it;
+        vlc_list_foreach(it, &queue->entries, node)
+        {
+            if (it->pic == NULL)
+                continue;
+
+            vlc_list_remove(&it->node);
+            EntryDelete(it);
+            queue->picture_count--;
+            queue->dropped++;
+            break;
+        }
+        vlc_cond_broadcast(&queue->wait_progress);
+    }
+
+    queue->picture_count++;
+    Append(queue, entry);
+    vlc_mutex_unlock(&queue->lock);
+    return VLC_SUCCESS;
+}
+
+int vlc_fanout_queue_PushPCR(vlc_fanout_queue_t *queue, vlc_tick_t pcr)
+{
+    fanout_entry_t *entry = malloc(sizeof(*entry));
+    if (unlikely(entry == NULL))
+        return VLC_ENOMEM;
+
+    entry->pic = NULL;
+    entry->tag = NULL;
+    entry->pcr = pcr;
+
+    vlc_mutex_lock(&queue->lock);
+    Append(queue, entry);
+    vlc_mutex_unlock(&queue->lock);
+    return VLC_SUCCESS;
+}
+
+static bool IsPending(vlc_fanout_queue_t *queue, void *tag)
+{
+    if (queue->busy && (tag == NULL || queue->busy_tag == tag))
+        return true;
+
+    const fanout_entry_t *entry;
+    vlc_list_foreach(entry, &queue->entries, node)
+        if (EntryMatches(entry, tag))
+            return true;
+    return false;
+}
+
+void vlc_fanout_queue_Wait(vlc_fanout_queue_t *queue, void *tag)
+{
+    vlc_mutex_lock(&queue->lock);
+    while (IsPending(queue, tag))
+        vlc_cond_wait(&queue->wait_progress, &queue->lock);
+    vlc_mutex_unlock(&queue->lock);
+}
+
+size_t vlc_fanout_queue_GetDropped(vlc_fanout_queue_t *queue)
+{
+    vlc_mutex_lock(&queue->lock);
+    size_t dropped = queue->dropped;
+    vlc_mutex_unlock(&queue->lock);
+    return dropped;
+}
@@ -0,0 +1,119 @@
+/*****************************************************************************
+ * fanout.h: picture queue feeding one stream output consumer
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef FANOUT_H
+#define FANOUT_H
+
+#include <vlc_common.h>
+#include <vlc_picture.h>
+
+/**
+ * The fanout queue lets a single decoder feed several consumers: the
+ * decoder pushes a reference of each picture to the queue of every
+ * consumer, and every queue is emptied by its own thread.
+ *
+ * PCR events are queued along with the pictures so that a consumer never
+ * receives a PCR before the pictures that were decoded ahead of it. They do
+ * not count against the depth of the queue and are never dropped.
+ */
+
+/**
+ * What to do with a picture pushed to a full queue.
+ */
+enum vlc_fanout_policy
+{
+    VLC_FANOUT_BLOCK, /**< Wait for the consumer to catch up */
+    VLC_FANOUT_DROP,  /**< Drop the oldest queued picture */
+};
+
+struct vlc_fanout_cbs
+{
+    /**
+     * Consume a picture, from the thread of the queue.
+     *
+     * \param tag The tag the picture was pushed with.
+     * \param pic The picture, to be released by the callback.
+     */
+    void (*picture)(void *opaque, void *tag, picture_t *pic);
+
+    /**
+     * Consume a PCR, from the thread of the queue.
+     */
+    void (*pcr)(void *opaque, vlc_tick_t pcr);
+};
+
+/**
+ * Opaque internal state.
+ */
+typedef struct vlc_fanout_queue vlc_fanout_queue_t;
+
+/**
+ * Create a queue and start its thread.
+ *
+ * \param depth Maximum number of queued pictures, at least 1.
+ *
+ * \return The queue or NULL on error.
+ */
+vlc_fanout_queue_t *vlc_fanout_queue_New(const struct vlc_fanout_cbs *,
+                                         void *opaque, size_t depth,
+                                         enum vlc_fanout_policy);
+
+/**
+ * Stop the thread and delete the queue.
+ *
+ * \note Pending entries are discarded, see \ref vlc_fanout_queue_Wait.
+ */
+void vlc_fanout_queue_Delete(vlc_fanout_queue_t *);
+
+/**
+ * Queue a picture.
+ *
+ * The queue holds its own reference to the picture. With the block policy,
+ * this waits until the queue has room for it.
+ *
+ * \param tag Opaque value given back to the picture callback.
+ *
+ * \retval VLC_SUCCESS On success, including when a picture was dropped.
+ * \retval VLC_ENOMEM On allocation error.
+ */
+int vlc_fanout_queue_PushPicture(vlc_fanout_queue_t *, void *tag,
+                                 picture_t *pic);
+
+/**
+ * Queue a PCR after the pictures already queued.
+ *
+ * \retval VLC_SUCCESS On success.
+ * \retval VLC_ENOMEM On allocation error.
+ */
+int vlc_fanout_queue_PushPCR(vlc_fanout_queue_t *, vlc_tick_t pcr);
+
+/**
+ * Wait until the consumer is done with the pictures pushed with a tag.
+ *
+ * \param tag The tag, or NULL to wait for every entry including PCRs.
+ */
+void vlc_fanout_queue_Wait(vlc_fanout_queue_t *, void *tag);
+
+/**
+ * Return the number of pictures dropped so far.
+ */
+size_t vlc_fanout_queue_GetDropped(vlc_fanout_queue_t *);
+
+#endif
@@ -0,0 +1,456 @@
+/*****************************************************************************
+ * parallel.c: transcoding stream output module (parallel video segments)
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_atomic.h>
+#include <vlc_list.h>
+#include <vlc_sout.h>
+
+#include "transcode.h"
+#include "segmenter.h"
+
+/*
+ * The video ES is cut at keyframes by the segmenter, and every segment is
+ * transcoded by its own decoder/filters/encoder chain on its own thread.
+ * The encoded segments are sent downstream in order, from the thread of
+ * the stream output, through a single ES.
+ */
+
+typedef struct
+{
+    sout_stream_t *p_stream;
+    sout_stream_id_sys_t *master;
+    transcode_segment_t *segment;
+
+    /* Set by the job thread */
+    sout_stream_id_sys_t *worker;
+    block_t *output;
+    int status;
+    bool done;
+
+    vlc_thread_t thread;
+    struct vlc_list node;
+} parallel_job_t;
+
+struct transcode_parallel
+{
+    transcode_segmenter_t *segmenter;
+    size_t max_jobs;
+
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    /* Jobs in segment order, only used from the stream output thread */
+    struct vlc_list jobs;
+    size_t job_count;
+    atomic_bool abort;
+
+    /* Last DTS sent downstream */
+    vlc_tick_t last_dts;
+};
+
+static void *WorkerDownstreamAdd( sout_stream_t *p_stream,
+                                  const es_format_t *fmt_orig,
+                                  const es_format_t *fmt,
+                                  const char *es_id )
+{
+    VLC_UNUSED(p_stream); VLC_UNUSED(fmt_orig);
+    VLC_UNUSED(fmt); VLC_UNUSED(es_id);
+    /* The master ES sends the output of every segment */
+    return NULL;
+}
+
+static void WorkerDelete( sout_stream_id_sys_t *id )
+{
+    dec_Delete( id->p_decoder );
+    if( id->output_fifo != NULL )
+        transcode_video_clean( id );
+    free( id );
+}
+
+static sout_stream_id_sys_t *WorkerNew( sout_stream_t *p_stream,
+                                        const sout_stream_id_sys_t *master,
+                                        const transcode_segment_t *segment )
+{
+    sout_stream_id_sys_t *id = calloc( 1, sizeof( *id ) );
+    if( !id )
+        return NULL;
+
+    vlc_mutex_init( &id->fifo.lock );
+    id->pf_transcode_downstream_add = WorkerDownstreamAdd;
+
+    struct decoder_owner *p_owner = vlc_object_create( p_stream, sizeof( *p_owner ) );
+    if( !p_owner )
+    {
+        free( id );
+        return NULL;
+    }
+    p_owner->p_stream = p_stream;
+
+    id->p_decoder = &p_owner->dec;
+    decoder_Init( id->p_decoder, &p_owner->fmt_in, master->p_decoder->fmt_in );
+    es_format_SetMeta( &id->p_decoder->fmt_out, id->p_decoder->fmt_in );
+
+    id->es_id = master->es_id;
+    id->p_filterscfg = master->p_filterscfg;
+    id->p_enccfg = master->p_enccfg;
+    id->segment_start = segment->start;
+    id->segment_end = segment->end;
+
+    if( transcode_video_init( p_stream, id->p_decoder->fmt_in, id ) )
+    {
+        WorkerDelete( id );
+        return NULL;
+    }
+    return id;
+}
+
+static void *JobThread( void *data )
+{
+    vlc_thread_set_name( "vlc-transc-seg" );
+
+    parallel_job_t *job = data;
+    sout_stream_t *p_stream = job->p_stream;
+    struct transcode_parallel *par = job->master->p_parallel;
+    block_t *output = NULL;
+    int status = VLC_EGENERIC;
+
+    sout_stream_id_sys_t *worker = WorkerNew( p_stream, job->master, job->segment );
+    if( worker != NULL )
+    {
+        block_t *in = job->segment->frames;
+        job->segment->frames = NULL;
+        job->segment->frames_last = &job->segment->frames;
+
+        status = VLC_SUCCESS;
+        while( in != NULL )
+        {
+            block_t *next = in->p_next;
+            in->p_next = NULL;
+
+            if( status == VLC_SUCCESS && atomic_load( &par->abort ) )
+                status = VLC_EGENERIC;
+
+            if( status == VLC_SUCCESS )
+            {
+                block_t *out;
+                status = transcode_video_process( p_stream, worker, in, &out );
+                block_ChainAppend( &output, out );
+            }
+            else
+                block_Release( in );
+            in = next;
+        }
+
+        /* Drain the decoder and the encoder */
+        if( status == VLC_SUCCESS )
+        {
+            block_t *out;
+            status = transcode_video_process( p_stream, worker, NULL, &out );
+            block_ChainAppend( &output, out );
+        }
+    }
+
+    vlc_mutex_lock( &par->lock );
+    job->worker = worker;
+    job->output = output;
+    job->status = status;
+    job->done = true;
+    vlc_cond_broadcast( &par->wait );
+    vlc_mutex_unlock( &par->lock );
+
+    return NULL;
+}
+
+static void JobDelete( struct transcode_parallel *par, parallel_job_t *job )
+{
+    vlc_join( job->thread, NULL );
+    vlc_list_remove( &job->node );
+    par->job_count--;
+
+    if( job->worker != NULL )
+        WorkerDelete( job->worker );
+    block_ChainRelease( job->output );
+    transcode_segment_Delete( job->segment );
+    free( job );
+}
+
+static vlc_tick_t FrameLength( const es_format_t *fmt, const block_t *chain )
+{
+    if( fmt->video.i_frame_rate != 0 && fmt->video.i_frame_rate_base != 0 )
+        return vlc_tick_from_samples( fmt->video.i_frame_rate_base,
+                                      fmt->video.i_frame_rate );
+    for( const block_t *it = chain; it != NULL; it = it->p_next )
+        if( it->i_length > 0 )
+            return it->i_length;
+    return 1;
+}
+
+/* Every encoder starts with its own reordering delay, which can take the
+ * first DTS of a segment back before the last DTS of the previous one.
+ * The DTS of the whole segment are then shifted to follow it by a frame,
+ * as far as the reordering delay of the segment allows without passing
+ * its PTS. */
+static void ShiftDTS( struct transcode_parallel *par, block_t *chain,
+                      const es_format_t *fmt )
+{
+    vlc_tick_t first = VLC_TICK_INVALID;
+    vlc_tick_t delay = INT64_MAX;
+
+    for( const block_t *it = chain; it != NULL; it = it->p_next )
+    {
+        if( it->i_dts == VLC_TICK_INVALID )
+            continue;
+        if( first == VLC_TICK_INVALID )
+            first = it->i_dts;
+        if( it->i_pts != VLC_TICK_INVALID )
+            delay = __MIN( delay, it->i_pts - it->i_dts );
+    }
+    if( first == VLC_TICK_INVALID )
+        return;
+
+    vlc_tick_t shift = 0;
+    if( par->last_dts != VLC_TICK_INVALID )
+    {
+        shift = par->last_dts + FrameLength( fmt, chain ) - first;
+        shift = __MAX( 0, __MIN( shift, delay ) );
+    }
+
+    for( block_t *it = chain; it != NULL; it = it->p_next )
+    {
+        if( it->i_dts == VLC_TICK_INVALID )
+            continue;
+        it->i_dts += shift;
+        /* Still overlapping if the delay of the segment is shorter than
+         * the one of the previous segment */
+        if( par->last_dts != VLC_TICK_INVALID && it->i_dts <= par->last_dts )
+            it->i_dts = par->last_dts + 1;
+        par->last_dts = it->i_dts;
+    }
+}
+
+static int JobCollect( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
+                       parallel_job_t *job, block_t **out )
+{
+    struct transcode_parallel *par = id->p_parallel;
+    int status = job->status;
+
+    if( status == VLC_SUCCESS && job->output != NULL && !id->downstream_id )
+    {
+        id->downstream_id =
+            id->pf_transcode_downstream_add( p_stream,
+                                             id->p_decoder->fmt_in,
+                                             transcode_encoder_format_out( job->worker->encoder ),
+                                             id->es_id );
+        if( !id->downstream_id )
+            status = VLC_EGENERIC;
+    }
+
+    if( status == VLC_SUCCESS )
+    {
+        ShiftDTS( par, job->output,
+                  transcode_encoder_format_out( job->worker->encoder ) );
+        block_ChainAppend( out, job->output );
+        job->output = NULL;
+    }
+    else
+        msg_Err( p_stream, "failed to transcode a segment" );
+
+    JobDelete( par, job );
+    return status;
+}
+
+/* Collect the completed jobs in segment order, waiting for them until at
+ * most `pending` jobs are left */
+static int CollectJobs( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
+                        size_t pending, block_t **out )
+{
+    struct transcode_parallel *par = id->p_parallel;
+    int status = VLC_SUCCESS;
+
+    while( status == VLC_SUCCESS )
+    {
+        parallel_job_t *job =
+            vlc_list_first_entry_or_null( &par->jobs, parallel_job_t, node );
+        if( job == NULL )
+            break;
+
+        vlc_mutex_lock( &par->lock );
+        if( par->job_count > pending )
+        {
+            while( !job->done )
+                vlc_cond_wait( &par->wait, &par->lock );
+        }
+        bool done = job->done;
+        vlc_mutex_unlock( &par->lock );
+
+        if( !done )
+            break;
+        status = JobCollect( p_stream, id, job, out );
+    }
+    return status;
+}
+
+static int Dispatch( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
+                     transcode_segment_t *segment, block_t **out )
+{
+    struct transcode_parallel *par = id->p_parallel;
+
+    /* The output goes in order, there is no point in running ahead of the
+     * oldest segment by more than a job per thread */
+    int status = CollectJobs( p_stream, id, par->max_jobs - 1, out );
+    if( status != VLC_SUCCESS )
+    {
+        transcode_segment_Delete( segment );
+        return status;
+    }
+
+    parallel_job_t *job = malloc( sizeof( *job ) );
+    if( unlikely( job == NULL ) )
+    {
+        transcode_segment_Delete( segment );
+        return VLC_ENOMEM;
+    }
+
+    job->p_stream = p_stream;
+    job->master = id;
+    job->segment = segment;
+    job->worker = NULL;
+    job->output = NULL;
+    job->status = VLC_EGENERIC;
+    job->done = false;
+
+    if( vlc_clone( &job->thread, JobThread, job ) )
+    {
+        transcode_segment_Delete( segment );
+        free( job );
+        return VLC_ENOMEM;
+    }
+
+    vlc_list_append( &job->node, &par->jobs );
+    par->job_count++;
+    return VLC_SUCCESS;
+}
+
+static void AbortJobs( struct transcode_parallel *par )
+{
+    atomic_store( &par->abort, true );
+
+    parallel_job_t *job;
+    vlc_list_foreach( job, &par->jobs, node )
+        JobDelete( par, job );
+
+    atomic_store( &par->abort, false );
+}
+
+int transcode_parallel_init( sout_stream_t *p_stream, const es_format_t *p_fmt,
+                             sout_stream_id_sys_t *id )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+
+    msg_Dbg( p_stream,
+             "creating video transcoding from fcc=`%4.4s' to fcc=`%4.4s' "
+             "in %u parallel segments of %"PRId64"s",
+             (char*)&p_fmt->i_codec, (char*)&id->p_enccfg->i_codec,
+             p_sys->i_segments, SEC_FROM_VLC_TICK( p_sys->segment_length ) );
+
+    struct transcode_parallel *par = malloc( sizeof( *par ) );
+    if( unlikely( par == NULL ) )
+        return VLC_ENOMEM;
+
+    par->segmenter = transcode_segmenter_New( p_sys->segment_length,
+                                              p_fmt->i_codec );
+    if( unlikely( par->segmenter == NULL ) )
+    {
+        free( par );
+        return VLC_ENOMEM;
+    }
+    par->max_jobs = p_sys->i_segments;
+
+    vlc_mutex_init( &par->lock );
+    vlc_cond_init( &par->wait );
+    vlc_list_init( &par->jobs );
+    par->job_count = 0;
+    atomic_init( &par->abort, false );
+    par->last_dts = VLC_TICK_INVALID;
+
+    id->p_parallel = par;
+    id->b_transcode = true;
+    return VLC_SUCCESS;
+}
+
+void transcode_parallel_clean( sout_stream_id_sys_t *id )
+{
+    struct transcode_parallel *par = id->p_parallel;
+
+    AbortJobs( par );
+    transcode_segmenter_Delete( par->segmenter );
+    free( par );
+    id->p_parallel = NULL;
+}
+
+void transcode_parallel_flush( sout_stream_id_sys_t *id )
+{
+    struct transcode_parallel *par = id->p_parallel;
+
+    /* The segments being transcoded are from before the discontinuity */
+    AbortJobs( par );
+    transcode_segmenter_Flush( par->segmenter );
+    par->last_dts = VLC_TICK_INVALID;
+}
+
+int transcode_parallel_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
+                                block_t *in, block_t **out )
+{
+    struct transcode_parallel *par = id->p_parallel;
+    transcode_segment_t *segment;
+    int status = VLC_SUCCESS;
+
+    *out = NULL;
+
+    if( in == NULL )
+    {
+        while( status == VLC_SUCCESS &&
+               ( segment = transcode_segmenter_Drain( par->segmenter ) ) != NULL )
+            status = Dispatch( p_stream, id, segment, out );
+
+        if( status == VLC_SUCCESS )
+            status = CollectJobs( p_stream, id, 0, out );
+        return status;
+    }
+
+    status = transcode_segmenter_Push( par->segmenter, in, &segment );
+    if( segment != NULL )
+    {
+        int ret = Dispatch( p_stream, id, segment, out );
+        if( status == VLC_SUCCESS )
+            status = ret;
+    }
+
+    if( status == VLC_SUCCESS )
+        status = CollectJobs( p_stream, id, par->max_jobs, out );
+    return status;
+}
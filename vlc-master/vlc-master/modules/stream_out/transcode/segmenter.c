@@ -0,0 +1,244 @@
+/*****************************************************************************
+ * segmenter.c: split a video ES at keyframes
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <assert.h>
+
+#include "segmenter.h"
+
+#include <vlc_fourcc.h>
+#include <vlc_tick.h>
+
+#include "../../packetizer/hxxx_nal.h"
+#include "../../packetizer/h264_nal.h"
+#include "../../packetizer/hevc_nal.h"
+
+struct transcode_segmenter
+{
+    vlc_tick_t length;
+    vlc_fourcc_t codec;
+
+    /// Segment being gathered.
+    transcode_segment_t *current;
+    vlc_tick_t current_first_ts;
+    /// Previous segment, still waiting for the leading frames of the current
+    /// one.
+    transcode_segment_t *closing;
+};
+
+static transcode_segment_t *SegmentNew(vlc_tick_t start)
+{
+    transcode_segment_t *segment = malloc(sizeof(*segment));
+    if (unlikely(segment == NULL))
+        return NULL;
+
+    segment->frames = NULL;
+    segment->frames_last = &segment->frames;
+    segment->start = start;
+    segment->end = VLC_TICK_INVALID;
+    return segment;
+}
+
+static void SegmentAppend(transcode_segment_t *segment, vlc_frame_t *frame)
+{
+    assert(frame->p_next == NULL);
+    *segment->frames_last = frame;
+    segment->frames_last = &frame->p_next;
+}
+
+void transcode_segment_Delete(transcode_segment_t *segment)
+{
+    vlc_frame_ChainRelease(segment->frames);
+    free(segment);
+}
+
+static vlc_tick_t FrameTs(const vlc_frame_t *frame)
+{
+    return frame->i_dts != VLC_TICK_INVALID ? frame->i_dts : frame->i_pts;
+}
+
+transcode_segmenter_t *transcode_segmenter_New(vlc_tick_t length,
+                                               vlc_fourcc_t codec)
+{
+    transcode_segmenter_t *segmenter = malloc(sizeof(*segmenter));
+    if (unlikely(segmenter == NULL))
+        return NULL;
+
+    segmenter->length = length;
+    segmenter->codec = codec;
+    segmenter->current = NULL;
+    segmenter->current_first_ts = VLC_TICK_INVALID;
+    segmenter->closing = NULL;
+    return segmenter;
+}
+
+void transcode_segmenter_Flush(transcode_segmenter_t *segmenter)
+{
+    if (segmenter->closing != NULL)
+        transcode_segment_Delete(segmenter->closing);
+    if (segmenter->current != NULL)
+        transcode_segment_Delete(segmenter->current);
+    segmenter->closing = NULL;
+    segmenter->current = NULL;
+}
+
+void transcode_segmenter_Delete(transcode_segmenter_t *segmenter)
+{
+    transcode_segmenter_Flush(segmenter);
+    free(segmenter);
+}
+
+/* Whether decoding can start at the frame, given it is an I frame. The
+ * packetizers output Annex B H.264 and HEVC. */
+static bool IsRandomAccess(vlc_fourcc_t codec, const vlc_frame_t *frame)
+{
+    hxxx_iterator_ctx_t it;
+    const uint8_t *nal;
+    size_t size;
+
+    switch (codec)
+    {
+        case VLC_CODEC_H264:
+            hxxx_iterator_init(&it, frame->p_buffer, frame->i_buffer, 0);
+            while (hxxx_annexb_iterate_next(&it, &nal, &size))
+                if (size > 0 && h264_getNALType(nal) == H264_NAL_SLICE_IDR)
+                    return true;
+            return false;
+        case VLC_CODEC_HEVC:
+            hxxx_iterator_init(&it, frame->p_buffer, frame->i_buffer, 0);
+            while (hxxx_annexb_iterate_next(&it, &nal, &size))
+            {
+                if (size == 0)
+                    continue;
+                const uint8_t type = hevc_getNALType(nal);
+                if (type >= HEVC_NAL_BLA_W_LP && type <= HEVC_NAL_IRAP_VCL23)
+                    return true;
+            }
+            return false;
+        default:
+            return true;
+    }
+}
+
+static bool IsBoundary(const transcode_segmenter_t *segmenter,
+                       const vlc_frame_t *frame)
+{
+    if (!(frame->i_flags & VLC_FRAME_FLAG_TYPE_I) ||
+        frame->i_pts == VLC_TICK_INVALID ||
+        !IsRandomAccess(segmenter->codec, frame))
+        return false;
+
+    const vlc_tick_t ts = FrameTs(frame);
+    return segmenter->current_first_ts != VLC_TICK_INVALID &&
+           ts != VLC_TICK_INVALID &&
+           ts - segmenter->current_first_ts >= segmenter->length;
+}
+
+int transcode_segmenter_Push(transcode_segmenter_t *segmenter,
+                             vlc_frame_t *frame,
+                             transcode_segment_t **segment)
+{
+    *segment = NULL;
+    assert(frame->p_next == NULL);
+
+    if (segmenter->closing != NULL)
+    {
+        /* Leading frames of the current segment, presented before its
+         * keyframe: the closing segment outputs them */
+        assert(segmenter->current != NULL);
+        if (!(frame->i_flags & VLC_FRAME_FLAG_TYPE_I) &&
+            frame->i_pts != VLC_TICK_INVALID &&
+            frame->i_pts < segmenter->current->start)
+        {
+            vlc_frame_t *dup = vlc_frame_Duplicate(frame);
+            if (unlikely(dup == NULL))
+            {
+                vlc_frame_Release(frame);
+                return VLC_ENOMEM;
+            }
+            SegmentAppend(segmenter->closing, dup);
+        }
+        else
+        {
+            *segment = segmenter->closing;
+            segmenter->closing = NULL;
+        }
+    }
+
+    if (segmenter->current != NULL && IsBoundary(segmenter, frame))
+    {
+        /* Only one segment is closing at a time, as its leading frames
+         * come before the next keyframe */
+        assert(segmenter->closing == NULL);
+
+        transcode_segment_t *next = SegmentNew(frame->i_pts);
+        vlc_frame_t *dup = vlc_frame_Duplicate(frame);
+        if (unlikely(next == NULL || dup == NULL))
+        {
+            free(next);
+            if (dup != NULL)
+                vlc_frame_Release(dup);
+            vlc_frame_Release(frame);
+            return VLC_ENOMEM;
+        }
+
+        /* The keyframe is referenced by the leading frames */
+        segmenter->current->end = frame->i_pts;
+        SegmentAppend(segmenter->current, dup);
+        segmenter->closing = segmenter->current;
+        segmenter->current = next;
+        segmenter->current_first_ts = FrameTs(frame);
+    }
+    else if (segmenter->current == NULL)
+    {
+        segmenter->current = SegmentNew(VLC_TICK_INVALID);
+        if (unlikely(segmenter->current == NULL))
+        {
+            vlc_frame_Release(frame);
+            return VLC_ENOMEM;
+        }
+        segmenter->current_first_ts = FrameTs(frame);
+    }
+    else if (segmenter->current_first_ts == VLC_TICK_INVALID)
+        segmenter->current_first_ts = FrameTs(frame);
+
+    SegmentAppend(segmenter->current, frame);
+    return VLC_SUCCESS;
+}
+
+transcode_segment_t *transcode_segmenter_Drain(transcode_segmenter_t *segmenter)
+{
+    transcode_segment_t *segment;
+
+    if (segmenter->closing != NULL)
+    {
+        segment = segmenter->closing;
+        segmenter->closing = NULL;
+    }
+    else
+    {
+        segment = segmenter->current;
+        segmenter->current = NULL;
+    }
+    return segment;
+}
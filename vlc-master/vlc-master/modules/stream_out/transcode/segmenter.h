@@ -0,0 +1,113 @@
+/*****************************************************************************
+ * segmenter.h: split a video ES at keyframes
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef SEGMENTER_H
+#define SEGMENTER_H
+
+#include <vlc_common.h>
+
+#include <vlc_frame.h>
+
+/**
+ * The segmenter cuts a compressed video ES into segments that can be decoded
+ * independently, so that each one can go through its own transcoding chain.
+ *
+ * A segment starts on a keyframe once the previous one lasts at least the
+ * requested length. For H.264, only IDR pictures are keyframes, as the other
+ * I pictures may be followed by pictures referencing the ones before them;
+ * a stream without IDR after its start, relying on recovery points, is
+ * hence not cut. For HEVC, IRAP pictures are keyframes. For the other
+ * codecs, every I frame is. Frames following that keyframe in decoding order but
+ * presented before it (the leading frames of an open GOP) may reference the
+ * previous segment: the keyframe and those frames are also given to the
+ * previous segment, and every segment only keeps the pictures presented
+ * within its [start, end[ range.
+ */
+
+typedef struct
+{
+    /** Frames to decode, in decoding order */
+    vlc_frame_t *frames;
+    vlc_frame_t **frames_last;
+    /** Date of the first picture to keep, VLC_TICK_INVALID for the first
+     * segment */
+    vlc_tick_t start;
+    /** Date of the first picture of the next segment, VLC_TICK_INVALID for
+     * the last segment */
+    vlc_tick_t end;
+} transcode_segment_t;
+
+/**
+ * Opaque internal state.
+ */
+typedef struct transcode_segmenter transcode_segmenter_t;
+
+/**
+ * Allocate a new segmenter.
+ *
+ * \param length Minimum duration of a segment.
+ * \param codec Codec of the ES, to find its random access points.
+ *
+ * \return A pointer to the allocated segmenter or NULL if the allocation
+ * failed.
+ */
+transcode_segmenter_t *transcode_segmenter_New(vlc_tick_t length,
+                                               vlc_fourcc_t codec);
+
+/**
+ * Delete the segmenter and the frames it holds.
+ */
+void transcode_segmenter_Delete(transcode_segmenter_t *);
+
+/**
+ * Push a frame, in decoding order.
+ *
+ * \param frame The frame, owned by the segmenter.
+ * \param[out] segment A complete segment to be transcoded or NULL, also set
+ * on error.
+ *
+ * \retval VLC_SUCCESS On success, even if no segment was completed.
+ * \retval VLC_ENOMEM On allocation error, the frame is released.
+ */
+int transcode_segmenter_Push(transcode_segmenter_t *, vlc_frame_t *frame,
+                             transcode_segment_t **segment);
+
+/**
+ * Complete the segments being gathered, at the end of the stream.
+ *
+ * Call it until it returns NULL.
+ *
+ * \return The next segment to be transcoded or NULL.
+ */
+transcode_segment_t *transcode_segmenter_Drain(transcode_segmenter_t *);
+
+/**
+ * Discard the segments being gathered.
+ *
+ * The next frame starts a segment without lower bound.
+ */
+void transcode_segmenter_Flush(transcode_segmenter_t *);
+
+/**
+ * Release a segment and its remaining frames.
+ */
+void transcode_segment_Delete(transcode_segment_t *);
+
+#endif
@@ -132,6 +132,14 @@
 #define POOL_TEXT N_("Picture pool size")
 #define POOL_LONGTEXT N_( "Defines how many pictures we allow to be in pool "\
     "between decoder/encoder threads when threads > 0" )
+#define SEGMENTS_TEXT N_("Parallel video segments")
+#define SEGMENTS_LONGTEXT N_( \
+    "Cut the video at keyframes and transcode this many segments at once, " \
+    "each one with its own decoder and encoder. Meant for file to file " \
+    "transcoding, as the output lags by as many segments. 0 disables it." )
+#define SEGMENT_LENGTH_TEXT N_("Video segment length")
+#define SEGMENT_LENGTH_LONGTEXT N_( \
+    "Minimum duration of a parallel video segment, in seconds." )
 #define FORWARD_PCR_TEXT N_( "Forward PCR" )
 #define FORWARD_PCR_LONGTEXT N_( \
     "Enable PCR events forwarding to the next stream." )
@@ -220,6 +228,12 @@ vlc_module_begin ()
         change_integer_range( 0, 32 )
     add_integer( SOUT_CFG_PREFIX "pool-size", 10, POOL_TEXT, POOL_LONGTEXT )
         change_integer_range( 1, 1000 )
+    add_integer( SOUT_CFG_PREFIX "segments", 0, SEGMENTS_TEXT,
+                 SEGMENTS_LONGTEXT )
+        change_integer_range( 0, 64 )
+    add_integer( SOUT_CFG_PREFIX "segment-length", 10, SEGMENT_LENGTH_TEXT,
+                 SEGMENT_LENGTH_LONGTEXT )
+        change_integer_range( 1, 3600 )
     add_obsolete_bool( SOUT_CFG_PREFIX "high-priority" ) // Since 4.0.0
     add_bool( SOUT_CFG_PREFIX "forward-pcr", true, FORWARD_PCR_TEXT,
               FORWARD_PCR_LONGTEXT )
@@ -232,7 +246,7 @@ static const char *const ppsz_sout_options[] = {
     "deinterlace-module", "threads", "aenc", "acodec", "ab", "alang",
     "afilter", "samplerate", "channels", "senc", "scodec", "soverlay",
     "sfilter", "high-priority", "maxwidth", "maxheight", "pool-size",
-    "forward-pcr", NULL
+    "forward-pcr", "segments", "segment-length", NULL
 };
 
 /*****************************************************************************
@@ -385,7 +399,10 @@ static void Flush( sout_stream_t *p_stream, void *_id)
                                       id->p_decoder->fmt_in->i_cat : UNKNOWN_ES;
     if( i_cat == VIDEO_ES )
     {
-        transcode_video_flush(id);
+        if( id->p_parallel != NULL )
+            transcode_parallel_flush(id);
+        else
+            transcode_video_flush(id);
     }
 }
 
@@ -450,6 +467,9 @@ static int Open( vlc_object_t *p_this )
 
     SetVideoEncoderConfig( p_stream, &p_sys->venc_cfg );
     p_sys->b_master_sync = (p_sys->venc_cfg.video.fps.num > 0);
+    p_sys->i_segments = var_GetInteger( p_stream, SOUT_CFG_PREFIX "segments" );
+    p_sys->segment_length =
+        VLC_TICK_FROM_SEC( var_GetInteger( p_stream, SOUT_CFG_PREFIX "segment-length" ) );
     if( p_sys->venc_cfg.i_codec )
     {
         msg_Dbg( p_stream, "codec video=%4.4s %dx%d scaling: %f %dkb/s",
@@ -677,6 +697,12 @@ Add( sout_stream_t *p_stream, const es_format_t *p_fmt, const char *es_id )
             p_sys->id_master_sync = id;
         vlc_mutex_unlock( &p_sys->lock );
     }
+    else if( p_fmt->i_cat == VIDEO_ES && id->p_enccfg->i_codec &&
+             p_sys->i_segments > 1 )
+    {
+        /* No overlay from the SPU ES, each segment has its own chain */
+        success = !transcode_parallel_init(p_stream, p_fmt, id);
+    }
     else if( p_fmt->i_cat == VIDEO_ES && id->p_enccfg->i_codec )
     {
         success = !transcode_video_init(p_stream, p_fmt, id);
@@ -712,7 +738,13 @@ Add( sout_stream_t *p_stream, const es_format_t *p_fmt, const char *es_id )
     if( p_sys->pcr_forwarding_enabled )
     {
         // TODO properly estimate the delay
-        id->pcr_helper = transcode_track_pcr_helper_New( p_sys->pcr_sync, VLC_TICK_FROM_SEC( 4 ) );
+        vlc_tick_t max_delay = VLC_TICK_FROM_SEC( 4 );
+        /* Frames are held until their segment and the previous ones are
+         * transcoded, a segment ending on the first keyframe after the
+         * requested length */
+        if( p_fmt->i_cat == VIDEO_ES && id->p_parallel != NULL )
+            max_delay += 2 * ( p_sys->i_segments + 1 ) * p_sys->segment_length;
+        id->pcr_helper = transcode_track_pcr_helper_New( p_sys->pcr_sync, max_delay );
         if( unlikely( id->pcr_helper == NULL ) )
             goto error;
     }
@@ -758,7 +790,10 @@ static void Del( sout_stream_t *p_stream, void *_id )
             if( id == p_sys->id_video )
                 p_sys->id_video = NULL;
             vlc_mutex_unlock( &p_sys->lock );
-            transcode_video_clean( id );
+            if( id->p_parallel != NULL )
+                transcode_parallel_clean( id );
+            else
+                transcode_video_clean( id );
             break;
         case SPU_ES:
             dec_Delete( id->p_decoder );
@@ -818,7 +853,10 @@ static int Send( sout_stream_t *p_stream, void *_id, block_t *p_buffer )
         break;
 
     case VIDEO_ES:
-        i_ret = transcode_video_process( p_stream, id, p_buffer, &p_out );
+        if( id->p_parallel != NULL )
+            i_ret = transcode_parallel_process( p_stream, id, p_buffer, &p_out );
+        else
+            i_ret = transcode_video_process( p_stream, id, p_buffer, &p_out );
         break;
 
     case SPU_ES:
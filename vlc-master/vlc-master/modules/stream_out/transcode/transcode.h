@@ -58,6 +58,10 @@ typedef struct
     /* SPU */
     transcode_encoder_config_t senc_cfg;
 
+    /* Parallel video segments */
+    unsigned        i_segments;
+    vlc_tick_t      segment_length;
+
     /* Shared between streams */
     vlc_mutex_t     lock;
     /* Sync */
@@ -74,6 +78,7 @@ typedef struct
 } sout_stream_sys_t;
 
 struct aout_filters;
+struct transcode_parallel;
 
 struct sout_stream_id_sys_t
 {
@@ -134,6 +139,10 @@ struct sout_stream_id_sys_t
              spu_t           *p_spu;
              vlc_decoder_device *dec_dev;
              vlc_video_context *enc_vctx_in;
+             struct transcode_parallel *p_parallel; /**< segment chains, if any */
+             /* Pictures out of [start, end[ belong to other segments */
+             vlc_tick_t      segment_start;
+             vlc_tick_t      segment_end;
          };
          struct
          {
@@ -234,3 +243,12 @@ int transcode_video_get_output_dimensions( sout_stream_id_sys_t *,
 void transcode_video_push_spu( sout_stream_t *, sout_stream_id_sys_t *, subpicture_t * );
 int  transcode_video_init    ( sout_stream_t *, const es_format_t *,
                                sout_stream_id_sys_t *);
+
+/* PARALLEL VIDEO SEGMENTS */
+
+void transcode_parallel_clean  ( sout_stream_id_sys_t * );
+int  transcode_parallel_process( sout_stream_t *, sout_stream_id_sys_t *,
+                                 block_t *, block_t ** );
+void transcode_parallel_flush  ( sout_stream_id_sys_t * );
+int  transcode_parallel_init   ( sout_stream_t *, const es_format_t *,
+                                 sout_stream_id_sys_t * );
@@ -257,6 +257,14 @@ static void decoder_queue_video( decoder_t *p_dec, picture_t *p_pic )
     struct decoder_owner *p_owner = dec_get_owner( p_dec );
     sout_stream_id_sys_t *id = p_owner->id;
 
+    if( ( id->segment_start != VLC_TICK_INVALID && p_pic->date < id->segment_start ) ||
+        ( id->segment_end != VLC_TICK_INVALID && p_pic->date >= id->segment_end ) )
+    {
+        /* Only decoded as a reference, another segment outputs it */
+        picture_Release( p_pic );
+        return;
+    }
+
     block_t *p_block = NULL;
     int ret = transcode_process_picture( id, p_pic, &p_block );
 
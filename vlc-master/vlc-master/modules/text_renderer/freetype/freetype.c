@@ -41,6 +41,7 @@
 #include <vlc_subpicture.h>
 #include <vlc_text_style.h>                                   /* text_style_t*/
 #include <vlc_charset.h>
+#include <vlc_memstream.h>
 
 #include <assert.h>
 
@@ -87,6 +88,9 @@ static void Destroy( filter_t * );
 #define SHADOW_DISTANCE_TEXT N_("Shadow distance")
 #define CACHE_SIZE_TEXT N_("Cache size")
 #define CACHE_SIZE_LONGTEXT N_("Cache size in kBytes")
+#define REGION_CACHE_SIZE_TEXT N_("Rendered text cache size")
+#define REGION_CACHE_SIZE_LONGTEXT N_("Memory used to keep rendered " \
+    "subtitles for reuse, in kBytes. 0 disables it.")
 
 #define TEXT_DIRECTION_TEXT N_("Text direction")
 #define TEXT_DIRECTION_LONGTEXT N_("Paragraph base direction for the Unicode bi-directional algorithm.")
@@ -184,6 +188,9 @@ vlc_module_begin ()
     add_integer_with_range( "freetype-cache-size", 200, 25, (UINT32_MAX >> 10),
                             CACHE_SIZE_TEXT, CACHE_SIZE_LONGTEXT )
         change_safe()
+    add_integer_with_range( "freetype-region-cache-size", 65536, 0, (UINT32_MAX >> 10),
+                            REGION_CACHE_SIZE_TEXT, REGION_CACHE_SIZE_LONGTEXT )
+        change_safe()
 
     add_obsolete_integer( "freetype-fontsize" ) /* since 4.0.0 */
     add_obsolete_integer( "freetype-rel-fontsize" ) /* since 4.0.0 */
@@ -918,6 +925,137 @@ static size_t SegmentsToTextAndStyles( filter_t *p_filter, const text_segment_t
     return i_nb_char;
 }
 
+/*****************************************************************************
+ * Rendered regions cache
+ *****************************************************************************
+ * The key describes all the inputs of Render(): the text and styles, the
+ * live default and forced styles, the scale, the output size and the
+ * region placement.
+ *****************************************************************************/
+#define KeyWrite( ms, v ) vlc_memstream_write( ms, &(v), sizeof(v) )
+
+static void KeyWriteString( struct vlc_memstream *ms, const char *psz )
+{
+    if( psz )
+        vlc_memstream_write( ms, psz, strlen( psz ) + 1 );
+    else
+        vlc_memstream_putc( ms, 0xFF ); /* never found in UTF-8 */
+}
+
+static void KeyWriteStyle( struct vlc_memstream *ms, const text_style_t *p_style )
+{
+    vlc_memstream_putc( ms, p_style != NULL );
+    if( !p_style )
+        return;
+
+    KeyWriteString( ms, p_style->psz_fontname );
+    KeyWriteString( ms, p_style->psz_monofontname );
+    KeyWrite( ms, p_style->i_features );
+    KeyWrite( ms, p_style->i_style_flags );
+    KeyWrite( ms, p_style->f_font_relsize );
+    KeyWrite( ms, p_style->i_font_size );
+    KeyWrite( ms, p_style->i_font_color );
+    KeyWrite( ms, p_style->i_font_alpha );
+    KeyWrite( ms, p_style->i_spacing );
+    KeyWrite( ms, p_style->i_outline_color );
+    KeyWrite( ms, p_style->i_outline_alpha );
+    KeyWrite( ms, p_style->i_outline_width );
+    KeyWrite( ms, p_style->i_shadow_color );
+    KeyWrite( ms, p_style->i_shadow_alpha );
+    KeyWrite( ms, p_style->i_shadow_width );
+    KeyWrite( ms, p_style->i_background_color );
+    KeyWrite( ms, p_style->i_background_alpha );
+    KeyWrite( ms, p_style->e_wrapinfo );
+}
+
+static char *RegionCacheKey( filter_t *p_filter,
+                             const subpicture_region_t *p_region_in,
+                             const vlc_fourcc_t *p_chroma_list,
+                             size_t *pi_key )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    struct vlc_memstream ms;
+
+    if( vlc_memstream_open( &ms ) )
+        return NULL;
+
+    KeyWrite( &ms, p_filter->fmt_out.video.i_visible_width );
+    KeyWrite( &ms, p_filter->fmt_out.video.i_visible_height );
+    KeyWrite( &ms, p_sys->i_scale );
+    for( ; p_chroma_list && *p_chroma_list; p_chroma_list++ )
+        KeyWrite( &ms, *p_chroma_list );
+    vlc_memstream_write( &ms, &(vlc_fourcc_t){ 0 }, sizeof(vlc_fourcc_t) );
+
+    KeyWrite( &ms, p_region_in->text_flags );
+    KeyWrite( &ms, p_region_in->i_max_width );
+    KeyWrite( &ms, p_region_in->i_max_height );
+    KeyWrite( &ms, p_region_in->i_x );
+    KeyWrite( &ms, p_region_in->i_y );
+    KeyWrite( &ms, p_region_in->i_align );
+    KeyWrite( &ms, p_region_in->i_alpha );
+    vlc_memstream_putc( &ms, p_region_in->b_absolute );
+    vlc_memstream_putc( &ms, p_region_in->b_in_window );
+    KeyWrite( &ms, p_region_in->fmt.i_sar_num );
+    KeyWrite( &ms, p_region_in->fmt.i_sar_den );
+    KeyWrite( &ms, p_region_in->fmt.transfer );
+    KeyWrite( &ms, p_region_in->fmt.primaries );
+    KeyWrite( &ms, p_region_in->fmt.space );
+    KeyWrite( &ms, p_region_in->fmt.mastering );
+
+    KeyWriteStyle( &ms, p_sys->p_default_style );
+    KeyWriteStyle( &ms, p_sys->p_forced_style );
+
+    for( const text_segment_t *p_segment = p_region_in->p_text;
+         p_segment; p_segment = p_segment->p_next )
+    {
+        vlc_memstream_putc( &ms, 1 );
+        KeyWriteString( &ms, p_segment->psz_text );
+        KeyWriteStyle( &ms, p_segment->style );
+        for( const text_segment_ruby_t *p_ruby = p_segment->p_ruby;
+             p_ruby; p_ruby = p_ruby->p_next )
+        {
+            vlc_memstream_putc( &ms, 2 );
+            KeyWriteString( &ms, p_ruby->psz_base );
+            KeyWriteString( &ms, p_ruby->psz_rt );
+        }
+    }
+    vlc_memstream_putc( &ms, 0 );
+
+    if( vlc_memstream_close( &ms ) )
+        return NULL;
+    *pi_key = ms.length;
+    return ms.ptr;
+}
+
+static subpicture_region_t *RenderFromCache( filter_t *p_filter,
+                                             const subpicture_region_t *p_region_in,
+                                             const char *p_key, size_t i_key )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    int i_x, i_y;
+
+    picture_t *p_picture = vlc_region_cache_Get( p_sys->p_region_cache,
+                                                 p_key, i_key, &i_x, &i_y );
+    if( !p_picture )
+        return NULL;
+
+    /* The picture is shared with the cache, and never written again */
+    subpicture_region_t *region = subpicture_region_ForPicture( p_picture );
+    picture_Release( p_picture );
+    if( unlikely(region == NULL) )
+        return NULL;
+
+    region->fmt.i_sar_num = p_region_in->fmt.i_sar_num;
+    region->fmt.i_sar_den = p_region_in->fmt.i_sar_den;
+    region->i_x = i_x;
+    region->i_y = i_y;
+    region->i_alpha = p_region_in->i_alpha;
+    region->i_align = p_region_in->i_align;
+    region->b_absolute = p_region_in->b_absolute;
+    region->b_in_window = p_region_in->b_in_window;
+    return region;
+}
+
 /**
  * This function renders a text subpicture region into another one.
  * It also calculates the size needed for this string, and renders the
@@ -948,6 +1086,20 @@ static subpicture_region_t *Render( filter_t *p_filter,
         p_sys->i_font_default_size = i_font_default_size;
     }
 
+    /* Paletted regions are not shared, as their palette is per region */
+    char *p_key = NULL;
+    size_t i_key;
+    if( p_sys->p_region_cache && p_sys->i_forced_chroma != VLC_CODEC_YUVP )
+    {
+        p_key = RegionCacheKey( p_filter, p_region_in, p_chroma_list, &i_key );
+        if( p_key && (region = RenderFromCache( p_filter, p_region_in,
+                                                p_key, i_key )) )
+        {
+            free( p_key );
+            return region;
+        }
+    }
+
     layout_text_block_t text_block = { 0 };
     text_block.b_balanced = (p_region_in->text_flags & VLC_SUBPIC_TEXT_FLAG_TEXT_NOT_BALANCED) == 0;
     text_block.b_grid = b_grid;
@@ -957,6 +1109,7 @@ static subpicture_region_t *Render( filter_t *p_filter,
     {
         free( text_block.pp_styles );
         free( text_block.p_uchars );
+        free( p_key );
         return NULL;
     }
 
@@ -1154,8 +1307,12 @@ static subpicture_region_t *Render( filter_t *p_filter,
 
     if (region == NULL)
         msg_Warn( p_filter, "no output chroma supported for rendering" );
+    else if( p_key && region->fmt.i_chroma != VLC_CODEC_YUVP )
+        vlc_region_cache_Insert( p_sys->p_region_cache, p_key, i_key,
+                                 region->p_picture, region->i_x, region->i_y );
 
 done:
+    free( p_key );
     FreeLines( text_block.p_laid );
 
     free( text_block.p_uchars );
@@ -1204,6 +1361,13 @@ static int Create( filter_t *p_filter )
     if( !p_sys->ftcache )
         goto error;
 
+    int64_t i_region_cache_size = var_InheritInteger( p_filter, "freetype-region-cache-size" );
+    if( i_region_cache_size > 0 )
+    {
+        /* Failure is not fatal, regions are rendered each time */
+        p_sys->p_region_cache = vlc_region_cache_New( (size_t) i_region_cache_size << 10 );
+    }
+
     p_sys->i_scale = 100;
 
     /* default style to apply to incomplete segments styles */
@@ -1270,6 +1434,9 @@ static void Destroy( filter_t *p_filter )
         DumpFamilies( p_sys->fs );
 #endif
 
+    if( p_sys->p_region_cache )
+        vlc_region_cache_Delete( p_sys->p_region_cache );
+
     if( p_sys->ftcache )
         vlc_ftcache_Delete( p_sys->ftcache );
 
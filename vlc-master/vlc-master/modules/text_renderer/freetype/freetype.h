@@ -73,6 +73,7 @@ typedef uint32_t uni_char_t;
 #endif
 
 #include "ftcache.h"
+#include "regioncache.h"
 
 typedef struct vlc_font_select_t vlc_font_select_t;
 
@@ -112,6 +113,7 @@ typedef struct
 
     vlc_font_select_t *fs;
     vlc_ftcache_t     *ftcache;
+    vlc_region_cache_t *p_region_cache; /* rendered regions, may be NULL */
 
 } filter_sys_t;
 
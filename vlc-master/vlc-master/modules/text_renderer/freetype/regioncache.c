@@ -0,0 +1,164 @@
+/*****************************************************************************
+ * regioncache.c : Rendered text regions cache
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_list.h>
+#include <vlc_picture.h>
+
+#include "regioncache.h"
+
+struct vlc_region_cache_entry
+{
+    uint64_t i_hash;
+    size_t i_key;
+    void *p_key;
+
+    picture_t *p_picture;
+    size_t i_bytes;
+    int i_x;
+    int i_y;
+
+    struct vlc_list node;
+};
+
+struct vlc_region_cache_t
+{
+    struct vlc_list list; /* most recently used first */
+    size_t i_bytes;
+    size_t i_max_bytes;
+};
+
+/* FNV-1a */
+static uint64_t Hash( const void *p_key, size_t i_key )
+{
+    const uint8_t *p = p_key;
+    uint64_t i_hash = UINT64_C(0xcbf29ce484222325);
+
+    for( size_t i = 0; i < i_key; i++ )
+    {
+        i_hash ^= p[i];
+        i_hash *= UINT64_C(0x100000001b3);
+    }
+    return i_hash;
+}
+
+static size_t PictureBytes( const picture_t *p_picture )
+{
+    size_t i_bytes = 0;
+    for( int i = 0; i < p_picture->i_planes; i++ )
+        i_bytes += (size_t)p_picture->p[i].i_pitch * p_picture->p[i].i_lines;
+    return i_bytes;
+}
+
+static void EntryDelete( vlc_region_cache_t *p_cache,
+                         struct vlc_region_cache_entry *p_entry )
+{
+    vlc_list_remove( &p_entry->node );
+    p_cache->i_bytes -= p_entry->i_bytes;
+    picture_Release( p_entry->p_picture );
+    free( p_entry->p_key );
+    free( p_entry );
+}
+
+vlc_region_cache_t * vlc_region_cache_New( size_t i_max_bytes )
+{
+    vlc_region_cache_t *p_cache = malloc( sizeof(*p_cache) );
+    if( p_cache )
+    {
+        vlc_list_init( &p_cache->list );
+        p_cache->i_bytes = 0;
+        p_cache->i_max_bytes = i_max_bytes;
+    }
+    return p_cache;
+}
+
+void vlc_region_cache_Delete( vlc_region_cache_t *p_cache )
+{
+    struct vlc_region_cache_entry *p_entry;
+    vlc_list_foreach( p_entry, &p_cache->list, node )
+        EntryDelete( p_cache, p_entry );
+    free( p_cache );
+}
+
+picture_t * vlc_region_cache_Get( vlc_region_cache_t *p_cache,
+                                  const void *p_key, size_t i_key,
+                                  int *pi_x, int *pi_y )
+{
+    const uint64_t i_hash = Hash( p_key, i_key );
+
+    struct vlc_region_cache_entry *p_entry;
+    vlc_list_foreach( p_entry, &p_cache->list, node )
+    {
+        if( p_entry->i_hash != i_hash || p_entry->i_key != i_key ||
+            memcmp( p_entry->p_key, p_key, i_key ) )
+            continue;
+
+        if( !vlc_list_is_first( &p_entry->node, &p_cache->list ) )
+        {
+            vlc_list_remove( &p_entry->node );
+            vlc_list_prepend( &p_entry->node, &p_cache->list );
+        }
+        *pi_x = p_entry->i_x;
+        *pi_y = p_entry->i_y;
+        return picture_Hold( p_entry->p_picture );
+    }
+    return NULL;
+}
+
+void vlc_region_cache_Insert( vlc_region_cache_t *p_cache,
+                              const void *p_key, size_t i_key,
+                              picture_t *p_picture, int i_x, int i_y )
+{
+    const size_t i_bytes = PictureBytes( p_picture );
+    if( i_bytes > p_cache->i_max_bytes )
+        return;
+
+    struct vlc_region_cache_entry *p_entry = malloc( sizeof(*p_entry) );
+    if( !p_entry )
+        return;
+    p_entry->p_key = malloc( i_key );
+    if( !p_entry->p_key )
+    {
+        free( p_entry );
+        return;
+    }
+    memcpy( p_entry->p_key, p_key, i_key );
+    p_entry->i_key = i_key;
+    p_entry->i_hash = Hash( p_key, i_key );
+    p_entry->p_picture = picture_Hold( p_picture );
+    p_entry->i_bytes = i_bytes;
+    p_entry->i_x = i_x;
+    p_entry->i_y = i_y;
+
+    /* Evict the least recently used regions */
+    while( p_cache->i_bytes + i_bytes > p_cache->i_max_bytes )
+    {
+        struct vlc_region_cache_entry *p_last =
+            vlc_list_last_entry_or_null( &p_cache->list,
+                                         struct vlc_region_cache_entry, node );
+        EntryDelete( p_cache, p_last );
+    }
+
+    vlc_list_prepend( &p_entry->node, &p_cache->list );
+    p_cache->i_bytes += i_bytes;
+}
@@ -0,0 +1,51 @@
+/*****************************************************************************
+ * regioncache.h : Rendered text regions cache
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef REGIONCACHE_H
+#define REGIONCACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Fully laid out and rasterized regions, keyed by an opaque binary blob
+ * describing everything the rendering depends on (text, styles, scale,
+ * output size...). Least recently used entries are dropped when the
+ * pictures exceed the memory budget. */
+typedef struct vlc_region_cache_t vlc_region_cache_t;
+
+vlc_region_cache_t * vlc_region_cache_New( size_t i_max_bytes );
+void vlc_region_cache_Delete( vlc_region_cache_t * );
+
+/* Returns a new reference to the cached picture and its position,
+ * or NULL if the key is not cached */
+picture_t * vlc_region_cache_Get( vlc_region_cache_t *,
+                                  const void *p_key, size_t i_key,
+                                  int *pi_x, int *pi_y );
+
+/* Holds the picture. It must not be modified afterwards. */
+void vlc_region_cache_Insert( vlc_region_cache_t *,
+                              const void *p_key, size_t i_key,
+                              picture_t *, int i_x, int i_y );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
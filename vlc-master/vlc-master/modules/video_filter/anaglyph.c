@@ -29,14 +29,31 @@
 #include <vlc_plugin.h>
 #include <vlc_filter.h>
 #include <vlc_picture.h>
+#include <vlc_cpu.h>
+#include <vlc_executor.h>
 #include "filter_picture.h"
 
+#if defined(HAVE_SSE2_INTRINSICS)
+#   include <emmintrin.h>
+#endif
+#if defined(HAVE_AVX2_INTRINSICS)
+#   include <immintrin.h>
+#endif
+
 static int Create(filter_t *);
-static void combine_side_by_side_yuv420(picture_t *, picture_t *, int, int);
 
 #define SCHEME_TEXT N_("Color scheme")
 #define SCHEME_LONGTEXT N_("Define the glasses' color scheme")
 
+#define OUTPUT_TEXT N_("Output mode")
+#define OUTPUT_LONGTEXT N_("Combine both views into an anaglyph image, or " \
+    "pass the stereo pair through for displays handling stereoscopy " \
+    "themselves")
+
+#define THREADS_TEXT N_("Threads")
+#define THREADS_LONGTEXT N_("Number of threads used to process a picture " \
+    "(0 for one per CPU)")
+
 #define FILTER_PREFIX "anaglyph-"
 
 /* See http://en.wikipedia.org/wiki/Anaglyph_image for a list of known
@@ -65,32 +82,541 @@ static const char *const ppsz_scheme_descriptions[] = {
     N_("magenta (left)  cyan (right)"),
     };
 
+enum output_e
+{
+    output_anaglyph,
+    output_side_by_side,
+    output_top_bottom,
+};
+
+static const char *const ppsz_output_values[] = {
+    "anaglyph",
+    "side-by-side",
+    "top-bottom",
+    };
+static const char *const ppsz_output_descriptions[] = {
+    N_("Anaglyph"),
+    N_("Side by side stereo (pass-through)"),
+    N_("Top and bottom stereo"),
+    };
+
 vlc_module_begin()
     set_description(N_("Convert 3D picture to anaglyph image video filter"))
     set_shortname(N_("Anaglyph"))
     set_subcategory(SUBCAT_VIDEO_VFILTER)
     add_string(FILTER_PREFIX "scheme", "red-cyan", SCHEME_TEXT, SCHEME_LONGTEXT)
         change_string_list(ppsz_scheme_values, ppsz_scheme_descriptions)
+    add_string(FILTER_PREFIX "output", "anaglyph", OUTPUT_TEXT, OUTPUT_LONGTEXT)
+        change_string_list(ppsz_output_values, ppsz_output_descriptions)
+    add_integer_with_range(FILTER_PREFIX "threads", 0, 0, 64,
+                           THREADS_TEXT, THREADS_LONGTEXT)
     set_callback_video_filter(Create)
 vlc_module_end()
 
 static const char *const ppsz_filter_options[] = {
-    "scheme", NULL
+    "scheme", "output", "threads", NULL
 };
 
+/* Pixel layouts, samples are converted to 8-bit equivalent floats */
+enum layout_e
+{
+    layout_planar8,     /* I420, YV12 */
+    layout_planar16,    /* I420_10L */
+    layout_semiplanar16 /* P010 */
+};
+
+/* Per eye RGB weights: 1 if the channel only comes from that eye, 1/2 if it
+ * comes from both */
+typedef struct
+{
+    float left[3];
+    float right[3];
+} combine_t;
+
+typedef void (*combine_line_t)(const combine_t *,
+                               const float *, const float *, const float *,
+                               const float *, const float *, const float *,
+                               float *, float *, float *, unsigned);
+
+/* Line buffers of one slice, count samples each */
+enum
+{
+    BUF_YL, BUF_UL, BUF_VL,
+    BUF_YR, BUF_UR, BUF_VR,
+    BUF_Y, BUF_U, BUF_V,
+    BUF_COUNT
+};
+
+typedef struct anaglyph_slice
+{
+    struct vlc_runnable runnable;
+    filter_t *filter;
+    picture_t *in, *out;
+    unsigned first, last; /* row pairs */
+    float *buffers[BUF_COUNT];
+    vlc_latch_t *done;
+} anaglyph_slice_t;
+
 typedef struct
 {
-    int left, right;
+    combine_t combine;
+    combine_line_t combine_line;
+    enum output_e output;
+    enum layout_e layout;
+    unsigned u_plane, v_plane;
+    float in_scale, out_scale;
+    unsigned out_shift, out_max;
+
+    vlc_executor_t *executor;
+    anaglyph_slice_t *slices;
+    unsigned slice_count;
+    float *buffers;
 } filter_sys_t;
 
-VIDEO_FILTER_WRAPPER(Filter)
+VIDEO_FILTER_WRAPPER_CLOSE(Filter, Close)
+
+static picture_t *FilterPassthrough(filter_t *p_filter, picture_t *p_pic)
+{
+    /* The display composes the views itself: nothing to do */
+    VLC_UNUSED(p_filter);
+    return p_pic;
+}
+
+static const struct vlc_filter_operations passthrough_ops = {
+    .filter_video = FilterPassthrough, .close = Close,
+};
+
+/*****************************************************************************
+ * Colour matrix combine
+ *****************************************************************************/
+/* Same BT.601 limited range matrices as yuv_to_rgb()/rgb_to_yuv() */
+#define KY   (255.f / 219.f)
+#define KRV  (1.40200f * 255.f / 224.f)
+#define KGU  (0.34414f * 255.f / 224.f)
+#define KGV  (0.71414f * 255.f / 224.f)
+#define KBU  (1.77200f * 255.f / 224.f)
+
+static void combine_line_c(const combine_t *c,
+                           const float *yl, const float *ul, const float *vl,
+                           const float *yr, const float *ur, const float *vr,
+                           float *yo, float *uo, float *vo, unsigned count)
+{
+    for (unsigned i = 0; i < count; i++)
+    {
+        float y = (yl[i] - 16.f) * KY, cb = ul[i] - 128.f, cr = vl[i] - 128.f;
+        float rl = VLC_CLIP(y + KRV * cr, 0.f, 255.f);
+        float gl = VLC_CLIP(y - KGU * cb - KGV * cr, 0.f, 255.f);
+        float bl = VLC_CLIP(y + KBU * cb, 0.f, 255.f);
+
+        y = (yr[i] - 16.f) * KY; cb = ur[i] - 128.f; cr = vr[i] - 128.f;
+        float rr = VLC_CLIP(y + KRV * cr, 0.f, 255.f);
+        float gr = VLC_CLIP(y - KGU * cb - KGV * cr, 0.f, 255.f);
+        float br = VLC_CLIP(y + KBU * cb, 0.f, 255.f);
+
+        float r = c->left[0] * rl + c->right[0] * rr;
+        float g = c->left[1] * gl + c->right[1] * gr;
+        float b = c->left[2] * bl + c->right[2] * br;
+
+        yo[i] = ( 66.f * r + 129.f * g +  25.f * b) / 256.f + 16.f;
+        uo[i] = (-38.f * r -  74.f * g + 112.f * b) / 256.f + 128.f;
+        vo[i] = (112.f * r -  94.f * g -  18.f * b) / 256.f + 128.f;
+    }
+}
+
+#if defined(HAVE_SSE2_INTRINSICS)
+__attribute__((__target__("sse2")))
+static void combine_line_sse2(const combine_t *c,
+                              const float *yl, const float *ul, const float *vl,
+                              const float *yr, const float *ur, const float *vr,
+                              float *yo, float *uo, float *vo, unsigned count)
+{
+    const __m128 zero = _mm_setzero_ps(), max = _mm_set1_ps(255.f);
+    const __m128 k16 = _mm_set1_ps(16.f), k128 = _mm_set1_ps(128.f);
+    const __m128 ky = _mm_set1_ps(KY), krv = _mm_set1_ps(KRV);
+    const __m128 kgu = _mm_set1_ps(KGU), kgv = _mm_set1_ps(KGV);
+    const __m128 kbu = _mm_set1_ps(KBU);
+    const __m128 wlr = _mm_set1_ps(c->left[0]), wrr = _mm_set1_ps(c->right[0]);
+    const __m128 wlg = _mm_set1_ps(c->left[1]), wrg = _mm_set1_ps(c->right[1]);
+    const __m128 wlb = _mm_set1_ps(c->left[2]), wrb = _mm_set1_ps(c->right[2]);
+#define CLAMP(x) _mm_min_ps(_mm_max_ps(x, zero), max)
+#define DOT(a, b, cc, r, g, bb) \
+    _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(a / 256.f), r), \
+                          _mm_mul_ps(_mm_set1_ps(b / 256.f), g)), \
+               _mm_mul_ps(_mm_set1_ps(cc / 256.f), bb))
+    unsigned i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 y = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(yl + i), k16), ky);
+        __m128 cb = _mm_sub_ps(_mm_loadu_ps(ul + i), k128);
+        __m128 cr = _mm_sub_ps(_mm_loadu_ps(vl + i), k128);
+        __m128 rl = CLAMP(_mm_add_ps(y, _mm_mul_ps(krv, cr)));
+        __m128 gl = CLAMP(_mm_sub_ps(_mm_sub_ps(y, _mm_mul_ps(kgu, cb)),
+                                     _mm_mul_ps(kgv, cr)));
+        __m128 bl = CLAMP(_mm_add_ps(y, _mm_mul_ps(kbu, cb)));
+
+        y = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(yr + i), k16), ky);
+        cb = _mm_sub_ps(_mm_loadu_ps(ur + i), k128);
+        cr = _mm_sub_ps(_mm_loadu_ps(vr + i), k128);
+        __m128 rr = CLAMP(_mm_add_ps(y, _mm_mul_ps(krv, cr)));
+        __m128 gr = CLAMP(_mm_sub_ps(_mm_sub_ps(y, _mm_mul_ps(kgu, cb)),
+                                     _mm_mul_ps(kgv, cr)));
+        __m128 br = CLAMP(_mm_add_ps(y, _mm_mul_ps(kbu, cb)));
+
+        __m128 r = _mm_add_ps(_mm_mul_ps(wlr, rl), _mm_mul_ps(wrr, rr));
+        __m128 g = _mm_add_ps(_mm_mul_ps(wlg, gl), _mm_mul_ps(wrg, gr));
+        __m128 b = _mm_add_ps(_mm_mul_ps(wlb, bl), _mm_mul_ps(wrb, br));
+
+        _mm_storeu_ps(yo + i, _mm_add_ps(DOT( 66.f, 129.f,  25.f, r, g, b), k16));
+        _mm_storeu_ps(uo + i, _mm_add_ps(DOT(-38.f, -74.f, 112.f, r, g, b), k128));
+        _mm_storeu_ps(vo + i, _mm_add_ps(DOT(112.f, -94.f, -18.f, r, g, b), k128));
+    }
+#undef DOT
+#undef CLAMP
+
+    combine_line_c(c, yl + i, ul + i, vl + i, yr + i, ur + i, vr + i,
+                   yo + i, uo + i, vo + i, count - i);
+}
+#endif
+
+#if defined(HAVE_AVX2_INTRINSICS)
+__attribute__((__target__("avx2")))
+static void combine_line_avx2(const combine_t *c,
+                              const float *yl, const float *ul, const float *vl,
+                              const float *yr, const float *ur, const float *vr,
+                              float *yo, float *uo, float *vo, unsigned count)
+{
+    const __m256 zero = _mm256_setzero_ps(), max = _mm256_set1_ps(255.f);
+    const __m256 k16 = _mm256_set1_ps(16.f), k128 = _mm256_set1_ps(128.f);
+    const __m256 ky = _mm256_set1_ps(KY), krv = _mm256_set1_ps(KRV);
+    const __m256 kgu = _mm256_set1_ps(KGU), kgv = _mm256_set1_ps(KGV);
+    const __m256 kbu = _mm256_set1_ps(KBU);
+    const __m256 wlr = _mm256_set1_ps(c->left[0]), wrr = _mm256_set1_ps(c->right[0]);
+    const __m256 wlg = _mm256_set1_ps(c->left[1]), wrg = _mm256_set1_ps(c->right[1]);
+    const __m256 wlb = _mm256_set1_ps(c->left[2]), wrb = _mm256_set1_ps(c->right[2]);
+#define CLAMP(x) _mm256_min_ps(_mm256_max_ps(x, zero), max)
+#define DOT(a, b, cc, r, g, bb) \
+    _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(a / 256.f), r), \
+                                _mm256_mul_ps(_mm256_set1_ps(b / 256.f), g)), \
+                  _mm256_mul_ps(_mm256_set1_ps(cc / 256.f), bb))
+    unsigned i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 y = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(yl + i), k16), ky);
+        __m256 cb = _mm256_sub_ps(_mm256_loadu_ps(ul + i), k128);
+        __m256 cr = _mm256_sub_ps(_mm256_loadu_ps(vl + i), k128);
+        __m256 rl = CLAMP(_mm256_add_ps(y, _mm256_mul_ps(krv, cr)));
+        __m256 gl = CLAMP(_mm256_sub_ps(_mm256_sub_ps(y, _mm256_mul_ps(kgu, cb)),
+                                        _mm256_mul_ps(kgv, cr)));
+        __m256 bl = CLAMP(_mm256_add_ps(y, _mm256_mul_ps(kbu, cb)));
+
+        y = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(yr + i), k16), ky);
+        cb = _mm256_sub_ps(_mm256_loadu_ps(ur + i), k128);
+        cr = _mm256_sub_ps(_mm256_loadu_ps(vr + i), k128);
+        __m256 rr = CLAMP(_mm256_add_ps(y, _mm256_mul_ps(krv, cr)));
+        __m256 gr = CLAMP(_mm256_sub_ps(_mm256_sub_ps(y, _mm256_mul_ps(kgu, cb)),
+                                        _mm256_mul_ps(kgv, cr)));
+        __m256 br = CLAMP(_mm256_add_ps(y, _mm256_mul_ps(kbu, cb)));
+
+        __m256 r = _mm256_add_ps(_mm256_mul_ps(wlr, rl), _mm256_mul_ps(wrr, rr));
+        __m256 g = _mm256_add_ps(_mm256_mul_ps(wlg, gl), _mm256_mul_ps(wrg, gr));
+        __m256 b = _mm256_add_ps(_mm256_mul_ps(wlb, bl), _mm256_mul_ps(wrb, br));
+
+        _mm256_storeu_ps(yo + i, _mm256_add_ps(DOT( 66.f, 129.f,  25.f, r, g, b), k16));
+        _mm256_storeu_ps(uo + i, _mm256_add_ps(DOT(-38.f, -74.f, 112.f, r, g, b), k128));
+        _mm256_storeu_ps(vo + i, _mm256_add_ps(DOT(112.f, -94.f, -18.f, r, g, b), k128));
+    }
+#undef DOT
+#undef CLAMP
+
+    combine_line_c(c, yl + i, ul + i, vl + i, yr + i, ur + i, vr + i,
+                   yo + i, uo + i, vo + i, count - i);
+}
+#endif
+
+/*****************************************************************************
+ * Line unpacking/packing
+ *****************************************************************************/
+/* Loads count luma samples of a row, starting at sample offset */
+static void load_luma(const filter_sys_t *p_sys, const plane_t *p,
+                      unsigned row, unsigned offset, unsigned count, float *dst)
+{
+    const uint8_t *line = p->p_pixels + row * p->i_pitch;
+
+    if (p_sys->layout == layout_planar8)
+    {
+        const uint8_t *src = line + offset;
+        for (unsigned i = 0; i < count; i++)
+            dst[i] = src[i];
+    }
+    else
+    {
+        const uint16_t *src = (const uint16_t *)line + offset;
+        for (unsigned i = 0; i < count; i++)
+            dst[i] = src[i] * p_sys->in_scale;
+    }
+}
+
+/* Loads count/2 chroma samples of a row, horizontally doubled to count */
+static void load_chroma(const filter_sys_t *p_sys, const picture_t *pic,
+                        unsigned row, unsigned offset, unsigned count,
+                        float *u, float *v)
+{
+    const plane_t *pu = &pic->p[p_sys->u_plane];
+    const plane_t *pv = &pic->p[p_sys->v_plane];
+
+    switch (p_sys->layout)
+    {
+        case layout_planar8:
+        {
+            const uint8_t *su = pu->p_pixels + row * pu->i_pitch + offset;
+            const uint8_t *sv = pv->p_pixels + row * pv->i_pitch + offset;
+            for (unsigned i = 0; i < count / 2; i++)
+            {
+                u[2 * i] = u[2 * i + 1] = su[i];
+                v[2 * i] = v[2 * i + 1] = sv[i];
+            }
+            break;
+        }
+        case layout_planar16:
+        {
+            const uint16_t *su = (const uint16_t *)(pu->p_pixels + row * pu->i_pitch) + offset;
+            const uint16_t *sv = (const uint16_t *)(pv->p_pixels + row * pv->i_pitch) + offset;
+            for (unsigned i = 0; i < count / 2; i++)
+            {
+                u[2 * i] = u[2 * i + 1] = su[i] * p_sys->in_scale;
+                v[2 * i] = v[2 * i + 1] = sv[i] * p_sys->in_scale;
+            }
+            break;
+        }
+        case layout_semiplanar16:
+        {
+            const uint16_t *suv = (const uint16_t *)(pu->p_pixels + row * pu->i_pitch) + 2 * offset;
+            for (unsigned i = 0; i < count / 2; i++)
+            {
+                u[2 * i] = u[2 * i + 1] = suv[2 * i] * p_sys->in_scale;
+                v[2 * i] = v[2 * i + 1] = suv[2 * i + 1] * p_sys->in_scale;
+            }
+            break;
+        }
+    }
+}
+
+static inline unsigned quantize(const filter_sys_t *p_sys, float value)
+{
+    int q = value * p_sys->out_scale + .5f;
+    return VLC_CLIP(q, 0, (int)p_sys->out_max) << p_sys->out_shift;
+}
+
+/* Stores count luma samples, horizontally doubled to a full output row */
+static void store_luma(const filter_sys_t *p_sys, plane_t *p,
+                       unsigned row, const float *src, unsigned count)
+{
+    uint8_t *line = p->p_pixels + row * p->i_pitch;
+
+    if (p_sys->layout == layout_planar8)
+    {
+        for (unsigned i = 0; i < count; i++)
+            line[2 * i] = line[2 * i + 1] = quantize(p_sys, src[i]);
+    }
+    else
+    {
+        uint16_t *dst = (uint16_t *)line;
+        for (unsigned i = 0; i < count; i++)
+            dst[2 * i] = dst[2 * i + 1] = quantize(p_sys, src[i]);
+    }
+}
+
+/* Stores a full output chroma row of count samples */
+static void store_chroma(const filter_sys_t *p_sys, picture_t *pic,
+                         unsigned row, const float *u, const float *v,
+                         unsigned count)
+{
+    plane_t *pu = &pic->p[p_sys->u_plane];
+    plane_t *pv = &pic->p[p_sys->v_plane];
+
+    switch (p_sys->layout)
+    {
+        case layout_planar8:
+        {
+            uint8_t *du = pu->p_pixels + row * pu->i_pitch;
+            uint8_t *dv = pv->p_pixels + row * pv->i_pitch;
+            for (unsigned i = 0; i < count; i++)
+            {
+                du[i] = quantize(p_sys, u[i]);
+                dv[i] = quantize(p_sys, v[i]);
+            }
+            break;
+        }
+        case layout_planar16:
+        {
+            uint16_t *du = (uint16_t *)(pu->p_pixels + row * pu->i_pitch);
+            uint16_t *dv = (uint16_t *)(pv->p_pixels + row * pv->i_pitch);
+            for (unsigned i = 0; i < count; i++)
+            {
+                du[i] = quantize(p_sys, u[i]);
+                dv[i] = quantize(p_sys, v[i]);
+            }
+            break;
+        }
+        case layout_semiplanar16:
+        {
+            uint16_t *duv = (uint16_t *)(pu->p_pixels + row * pu->i_pitch);
+            for (unsigned i = 0; i < count; i++)
+            {
+                duv[2 * i] = quantize(p_sys, u[i]);
+                duv[2 * i + 1] = quantize(p_sys, v[i]);
+            }
+            break;
+        }
+    }
+}
+
+/*****************************************************************************
+ * Slices
+ *****************************************************************************/
+static unsigned view_width(const picture_t *pic)
+{
+    /* Samples per view and per row, even for chroma subsampling */
+    const plane_t *p = &pic->p[Y_PLANE];
+    return (p->i_visible_pitch / p->i_pixel_pitch / 2) & ~1u;
+}
+
+static void RunSlice(void *opaque)
+{
+    anaglyph_slice_t *slice = opaque;
+    filter_sys_t *p_sys = slice->filter->p_sys;
+    picture_t *in = slice->in, *out = slice->out;
+    float **buf = slice->buffers;
+    const unsigned count = view_width(in);
+    const unsigned half = in->p[Y_PLANE].i_visible_lines / 4;
+
+    for (unsigned pair = slice->first; pair < slice->last; pair++)
+    {
+        if (p_sys->output == output_top_bottom)
+        {
+            /* Output pair rows come from every other input row of one view,
+             * left view on top */
+            bool bottom = pair >= half;
+            unsigned src = (bottom ? pair - half : pair) * 2;
+            unsigned offset = bottom ? count : 0;
+
+            load_chroma(p_sys, in, src, offset / 2, count,
+                        buf[BUF_U], buf[BUF_V]);
+            store_chroma(p_sys, out, pair, buf[BUF_U], buf[BUF_V], count);
+            for (unsigned i = 0; i < 2; i++)
+            {
+                load_luma(p_sys, &in->p[Y_PLANE], 2 * src + 2 * i, offset,
+                          count, buf[BUF_Y]);
+                store_luma(p_sys, &out->p[Y_PLANE], 2 * pair + i,
+                           buf[BUF_Y], count);
+            }
+            continue;
+        }
+
+        load_chroma(p_sys, in, pair, 0, count, buf[BUF_UL], buf[BUF_VL]);
+        load_chroma(p_sys, in, pair, count / 2, count, buf[BUF_UR], buf[BUF_VR]);
+
+        for (unsigned i = 0; i < 2; i++)
+        {
+            unsigned row = 2 * pair + i;
+
+            load_luma(p_sys, &in->p[Y_PLANE], row, 0, count, buf[BUF_YL]);
+            load_luma(p_sys, &in->p[Y_PLANE], row, count, count, buf[BUF_YR]);
+            p_sys->combine_line(&p_sys->combine,
+                                buf[BUF_YL], buf[BUF_UL], buf[BUF_VL],
+                                buf[BUF_YR], buf[BUF_UR], buf[BUF_VR],
+                                buf[BUF_Y], buf[BUF_U], buf[BUF_V], count);
+            store_luma(p_sys, &out->p[Y_PLANE], row, buf[BUF_Y], count);
+            /* Chroma is taken from the upper row of the pair */
+            if (i == 0)
+                store_chroma(p_sys, out, pair, buf[BUF_U], buf[BUF_V], count);
+        }
+    }
+
+    if (slice->done)
+        vlc_latch_count_down(slice->done, 1);
+}
+
+static void Filter(filter_t *p_filter, picture_t *p_pic, picture_t *p_outpic)
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    unsigned pairs = p_pic->p[Y_PLANE].i_visible_lines / 2;
+
+    if (p_sys->output == output_top_bottom)
+        pairs &= ~1u; /* each view gets the same number of rows */
+
+    /* Small pictures are not worth the synchronisation */
+    unsigned count = __MIN(p_sys->slice_count, pairs / 32);
+    if (count <= 1 || p_sys->executor == NULL)
+    {
+        anaglyph_slice_t *slice = &p_sys->slices[0];
+        slice->filter = p_filter;
+        slice->in = p_pic;
+        slice->out = p_outpic;
+        slice->first = 0;
+        slice->last = pairs;
+        slice->done = NULL;
+        RunSlice(slice);
+        return;
+    }
+
+    unsigned band = (pairs + count - 1) / count;
+    vlc_latch_t done;
+
+    vlc_latch_init(&done, count);
+    for (unsigned i = 0; i < count; i++)
+    {
+        anaglyph_slice_t *slice = &p_sys->slices[i];
+        slice->filter = p_filter;
+        slice->in = p_pic;
+        slice->out = p_outpic;
+        slice->first = __MIN(pairs, i * band);
+        slice->last = __MIN(pairs, (i + 1) * band);
+        slice->done = &done;
+        slice->runnable.run = RunSlice;
+        slice->runnable.userdata = slice;
+    }
+
+    /* Run the first band on the filter thread, the others on the executor */
+    for (unsigned i = 1; i < count; i++)
+        vlc_executor_Submit(p_sys->executor, &p_sys->slices[i].runnable);
+    RunSlice(&p_sys->slices[0]);
+    vlc_latch_wait(&done);
+}
+
+static void Close(filter_t *p_filter)
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if (p_sys->executor)
+        vlc_executor_Delete(p_sys->executor);
+    free(p_sys->slices);
+    free(p_sys->buffers);
+}
 
 static int Create(filter_t *p_filter)
 {
+    enum layout_e layout;
+    unsigned u_plane = U_PLANE, v_plane = V_PLANE;
+
     switch (p_filter->fmt_in.video.i_chroma)
     {
         case VLC_CODEC_I420:
+            layout = layout_planar8;
+            break;
         case VLC_CODEC_YV12:
+            layout = layout_planar8;
+            u_plane = V_PLANE;
+            v_plane = U_PLANE;
+            break;
+        case VLC_CODEC_I420_10L:
+            layout = layout_planar16;
+            break;
+        case VLC_CODEC_P010:
+            layout = layout_semiplanar16;
+            u_plane = v_plane = 1;
             break;
 
         default:
@@ -99,14 +625,63 @@ static int Create(filter_t *p_filter)
             return VLC_EGENERIC;
     }
 
-    p_filter->p_sys = vlc_obj_malloc(VLC_OBJECT(p_filter), sizeof(filter_sys_t));
+    p_filter->p_sys = vlc_obj_calloc(VLC_OBJECT(p_filter), 1, sizeof(filter_sys_t));
     if (unlikely(!p_filter->p_sys))
         return VLC_ENOMEM;
     filter_sys_t *p_sys = p_filter->p_sys;
 
+    p_sys->layout = layout;
+    p_sys->u_plane = u_plane;
+    p_sys->v_plane = v_plane;
+    switch (layout)
+    {
+        case layout_planar8:
+            p_sys->in_scale = 1.f;
+            p_sys->out_scale = 1.f;
+            p_sys->out_max = 255;
+            p_sys->out_shift = 0;
+            break;
+        case layout_planar16:
+            p_sys->in_scale = 1.f / 4.f;
+            p_sys->out_scale = 4.f;
+            p_sys->out_max = 1023;
+            p_sys->out_shift = 0;
+            break;
+        case layout_semiplanar16:
+            /* 10 bits in the most significant bits */
+            p_sys->in_scale = 1.f / 256.f;
+            p_sys->out_scale = 4.f;
+            p_sys->out_max = 1023;
+            p_sys->out_shift = 6;
+            break;
+    }
+
     config_ChainParse(p_filter, FILTER_PREFIX, ppsz_filter_options,
                       p_filter->p_cfg);
 
+    char *psz_output = var_CreateGetString(p_filter, FILTER_PREFIX "output");
+    p_sys->output = output_anaglyph;
+    if (psz_output)
+    {
+        if (!strcmp(psz_output, "side-by-side"))
+            p_sys->output = output_side_by_side;
+        else if (!strcmp(psz_output, "top-bottom"))
+            p_sys->output = output_top_bottom;
+        else if (strcmp(psz_output, "anaglyph"))
+            msg_Err(p_filter, "Unknown anaglyph output mode '%s'", psz_output);
+    }
+    free(psz_output);
+
+    if (p_sys->output == output_side_by_side)
+    {
+        /* Side by side is the input layout: flag it and let it through */
+        p_filter->fmt_out.video.multiview_mode = MULTIVIEW_STEREO_SBS;
+        p_filter->ops = &passthrough_ops;
+        return VLC_SUCCESS;
+    }
+    if (p_sys->output == output_top_bottom)
+        p_filter->fmt_out.video.multiview_mode = MULTIVIEW_STEREO_TB;
+
     char *psz_scheme = var_CreateGetStringCommand(p_filter,
                                                   FILTER_PREFIX "scheme");
     enum scheme_e scheme = red_cyan;
@@ -127,149 +702,78 @@ static int Create(filter_t *p_filter)
     }
     free(psz_scheme);
 
+    int left = 0, right = 0;
     switch (scheme)
     {
         case red_green:
-            p_sys->left = 0xff0000;
-            p_sys->right = 0x00ff00;
+            left = 0xff0000;
+            right = 0x00ff00;
             break;
         case red_blue:
-            p_sys->left = 0xff0000;
-            p_sys->right = 0x0000ff;
+            left = 0xff0000;
+            right = 0x0000ff;
             break;
         case red_cyan:
-            p_sys->left = 0xff0000;
-            p_sys->right = 0x00ffff;
+            left = 0xff0000;
+            right = 0x00ffff;
             break;
         case trioscopic:
-            p_sys->left = 0x00ff00;
-            p_sys->right = 0xff00ff;
+            left = 0x00ff00;
+            right = 0xff00ff;
             break;
         case magenta_cyan:
-            p_sys->left = 0xff00ff;
-            p_sys->right = 0x00ffff;
+            left = 0xff00ff;
+            right = 0x00ffff;
             break;
     }
 
-    p_filter->ops = &Filter_ops;
-    return VLC_SUCCESS;
-}
-
-static void Filter(filter_t *p_filter, picture_t *p_pic, picture_t *p_outpic)
-{
-    filter_sys_t *p_sys = p_filter->p_sys;
-
-    switch (p_pic->format.i_chroma)
+    /* A channel shared by both eyes is averaged */
+    for (unsigned i = 0; i < 3; i++)
     {
-        case VLC_CODEC_I420:
-        case VLC_CODEC_YV12:
-            combine_side_by_side_yuv420(p_pic, p_outpic,
-                                        p_sys->left, p_sys->right);
-            break;
-
-        default:
-            vlc_assert_unreachable();
+        int mask = 0xff0000 >> (8 * i);
+        bool l = left & mask, r = right & mask;
+        float weight = (l && r) ? .5f : 1.f;
+        p_sys->combine.left[i] = l ? weight : 0.f;
+        p_sys->combine.right[i] = r ? weight : 0.f;
     }
-}
-
 
-static void combine_side_by_side_yuv420(picture_t *p_inpic, picture_t *p_outpic,
-                                        int left, int right)
-{
-    uint8_t *y1inl = p_inpic->p[Y_PLANE].p_pixels;
-    uint8_t *y2inl;
-    uint8_t *uinl = p_inpic->p[U_PLANE].p_pixels;
-    uint8_t *vinl = p_inpic->p[V_PLANE].p_pixels;
-
-    uint8_t *y1out = p_outpic->p[Y_PLANE].p_pixels;
-    uint8_t *y2out;
-    uint8_t *uout = p_outpic->p[U_PLANE].p_pixels;
-    uint8_t *vout = p_outpic->p[V_PLANE].p_pixels;
-
-    const int in_pitch = p_inpic->p[Y_PLANE].i_pitch;
-    const int out_pitch = p_outpic->p[Y_PLANE].i_pitch;
-
-    const int visible_pitch = p_inpic->p[Y_PLANE].i_visible_pitch;
-    const int visible_lines = p_inpic->p[Y_PLANE].i_visible_lines;
-    const int uv_visible_pitch = p_inpic->p[U_PLANE].i_visible_pitch;
+    p_sys->combine_line = combine_line_c;
+#if defined(HAVE_SSE2_INTRINSICS)
+    if (vlc_CPU_SSE2())
+        p_sys->combine_line = combine_line_sse2;
+#endif
+#if defined(HAVE_AVX2_INTRINSICS)
+    if (vlc_CPU_AVX2())
+        p_sys->combine_line = combine_line_avx2;
+#endif
 
-    const uint8_t *yend = y1inl + visible_lines * in_pitch;
+    unsigned threads = var_CreateGetInteger(p_filter, FILTER_PREFIX "threads");
+    if (threads == 0)
+        threads = vlc_GetCPUCount();
+    threads = __MAX(threads, 1);
 
-    while (y1inl < yend)
+    /* Line buffers hold one view row, i.e. half the input width */
+    size_t line = ((p_filter->fmt_in.video.i_width / 2 + 7) & ~7u);
+    p_sys->slices = calloc(threads, sizeof(*p_sys->slices));
+    p_sys->buffers = vlc_alloc(threads * BUF_COUNT, line * sizeof(float));
+    if (!p_sys->slices || !p_sys->buffers)
     {
-        uint8_t *y1inr = y1inl + visible_pitch/2;
-        uint8_t *y2inr;
-        uint8_t *uinr = uinl + uv_visible_pitch/2;
-        uint8_t *vinr = vinl + uv_visible_pitch/2;
-
-        const uint8_t *y1end = y1inr;
-        y2inl = y1inl + in_pitch;
-        y2inr = y1inr + in_pitch;
-        y2out = y1out + out_pitch;
-
-        while (y1inl < y1end)
-        {
-            int rl, gl, bl, rr, gr, br, r, g, b;
-
-            int rshift = !!((0xff0000&left) && (0xff0000&right));
-            int gshift = !!((0x00ff00&left) && (0x00ff00&right));
-            int bshift = !!((0x0000ff&left) && (0x0000ff&right));
-
-            yuv_to_rgb(&rl, &gl, &bl, *y1inl, *uinl, *vinl);
-            yuv_to_rgb(&rr, &gr, &br, *y1inr, *uinr, *vinr);
-            r = ((!!(0xff0000&left))*rl + (!!(0xff0000&right))*rr)>>rshift;
-            g = ((!!(0x00ff00&left))*gl + (!!(0x00ff00&right))*gr)>>gshift;
-            b = ((!!(0x0000ff&left))*bl + (!!(0x0000ff&right))*br)>>bshift;
-            rgb_to_yuv(y1out, uout++, vout++, r, g, b);
-            y1out[1] = *y1out;
-            y1out+=2;
-            y1inl++;
-            y1inr++;
-
-            yuv_to_rgb(&rl, &gl, &bl, *y1inl, *uinl, *vinl);
-            yuv_to_rgb(&rr, &gr, &br, *y1inr, *uinr, *vinr);
-            r = ((!!(0xff0000&left))*rl + (!!(0xff0000&right))*rr)>>rshift;
-            g = ((!!(0x00ff00&left))*gl + (!!(0x00ff00&right))*gr)>>gshift;
-            b = ((!!(0x0000ff&left))*bl + (!!(0x0000ff&right))*br)>>bshift;
-            rgb_to_yuv(y1out, uout++, vout++, r, g, b);
-            y1out[1] = *y1out;
-            y1out+=2;
-            y1inl++;
-            y1inr++;
-
-            yuv_to_rgb(&rl, &gl, &bl, *y2inl, *uinl, *vinl);
-            yuv_to_rgb(&rr, &gr, &br, *y2inr, *uinr, *vinr);
-            r = ((!!(0xff0000&left))*rl + (!!(0xff0000&right))*rr)>>rshift;
-            g = ((!!(0x00ff00&left))*gl + (!!(0x00ff00&right))*gr)>>gshift;
-            b = ((!!(0x0000ff&left))*bl + (!!(0x0000ff&right))*br)>>bshift;
-            rgb_to_yuv(y2out, uout/*will be overwritten later, as will vout*/, vout, r, g, b);
-            y2out[1] = *y2out;
-            y2out+=2;
-            y2inl++;
-            y2inr++;
-
-            yuv_to_rgb(&rl, &gl, &bl, *y2inl, *uinl, *vinl);
-            yuv_to_rgb(&rr, &gr, &br, *y2inr, *uinr, *vinr);
-            r = ((!!(0xff0000&left))*rl + (!!(0xff0000&right))*rr)>>rshift;
-            g = ((!!(0x00ff00&left))*gl + (!!(0x00ff00&right))*gr)>>gshift;
-            b = ((!!(0x0000ff&left))*bl + (!!(0x0000ff&right))*br)>>bshift;
-            rgb_to_yuv(y2out, uout/*will be overwritten later, as will vout*/, vout, r, g, b);
-            y2out[1] = *y2out;
-            y2out+=2;
-            y2inl++;
-            y2inr++;
-
-            uinl++;
-            vinl++;
-            uinr++;
-            vinr++;
-        }
+        Close(p_filter);
+        return VLC_ENOMEM;
+    }
+    for (unsigned i = 0; i < threads; i++)
+        for (unsigned j = 0; j < BUF_COUNT; j++)
+            p_sys->slices[i].buffers[j] = p_sys->buffers + (i * BUF_COUNT + j) * line;
 
-        y1inl = y1inr + 2*in_pitch - visible_pitch;
-        y1out += 2*out_pitch - visible_pitch;
-        uinl = uinr + p_inpic->p[U_PLANE].i_pitch - uv_visible_pitch;
-        vinl = vinr + p_inpic->p[V_PLANE].i_pitch - uv_visible_pitch;
-        uout += p_outpic->p[U_PLANE].i_pitch - uv_visible_pitch;
-        vout += p_outpic->p[V_PLANE].i_pitch - uv_visible_pitch;
+    /* The filter thread runs one band itself */
+    if (threads > 1)
+    {
+        p_sys->executor = vlc_executor_New(threads - 1);
+        if (!p_sys->executor)
+            threads = 1;
     }
+    p_sys->slice_count = threads;
+
+    p_filter->ops = &Filter_ops;
+    return VLC_SUCCESS;
 }
@@ -31,8 +31,16 @@
 #include <vlc_plugin.h>
 #include <vlc_filter.h>
 #include <vlc_picture.h>
+#include <vlc_cpu.h>
 #include "filter_picture.h"
 
+#if defined(HAVE_AVX2_INTRINSICS)
+#   include <immintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#   include <arm_neon.h>
+#endif
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -79,6 +87,19 @@ public:
     {
         return fmt;
     }
+    /* Start of the plane line holding the line dy of the area */
+    uint8_t *getLineAt(unsigned plane, unsigned dy, unsigned ry = 1) const
+    {
+        return &picture->p[plane].p_pixels[(y + dy) / ry * picture->p[plane].i_pitch];
+    }
+    unsigned getX() const
+    {
+        return x;
+    }
+    unsigned getY() const
+    {
+        return y;
+    }
     bool isFull(unsigned) const
     {
         return true;
@@ -151,7 +172,8 @@ private:
     uint8_t *data[4];
 };
 
-template <bool swap_uv>
+/* Samples of more than 8 bits are stored in the most significant bits */
+template <typename pixel, bool swap_uv, unsigned shift>
 class CPictureYUVSemiPlanar : public CPicture {
 public:
     CPictureYUVSemiPlanar(const CPicture &cfg) : CPicture(cfg)
@@ -161,18 +183,18 @@ public:
     }
     void get(CPixel *px, unsigned dx, bool full = true) const
     {
-        px->i = *getPointer(0, dx);
+        px->i = *getPointer(0, dx) >> shift;
         if (full) {
-            px->j = getPointer(1, dx)[swap_uv];
-            px->k = getPointer(1, dx)[!swap_uv];
+            px->j = getPointer(1, dx)[swap_uv] >> shift;
+            px->k = getPointer(1, dx)[!swap_uv] >> shift;
         }
     }
     void merge(unsigned dx, const CPixel &spx, unsigned a, bool full)
     {
-        ::merge(getPointer(0, dx), spx.i, a);
+        merge(getPointer(0, dx), spx.i, a);
         if (full) {
-            ::merge(&getPointer(1, dx)[ swap_uv], spx.j, a);
-            ::merge(&getPointer(1, dx)[!swap_uv], spx.k, a);
+            merge(&getPointer(1, dx)[ swap_uv], spx.j, a);
+            merge(&getPointer(1, dx)[!swap_uv], spx.k, a);
         }
     }
     bool isFull(unsigned dx) const
@@ -187,12 +209,18 @@ public:
             data[1] += picture->p[1].i_pitch;
     }
 private:
-    uint8_t *getPointer(unsigned plane, unsigned dx) const
+    static void merge(pixel *dst, unsigned src, unsigned a)
+    {
+        unsigned v = *dst >> shift;
+        ::merge(&v, src, a);
+        *dst = v << shift;
+    }
+    pixel *getPointer(unsigned plane, unsigned dx) const
     {
         if (plane == 0)
-            return &data[plane][x + dx];
+            return &((pixel *)data[plane])[x + dx];
         else
-            return &data[plane][(x + dx) / 2 * 2];
+            return &((pixel *)data[plane])[(x + dx) / 2 * 2];
     }
     uint8_t *data[2];
 };
@@ -405,8 +433,10 @@ typedef CPictureYUVPlanar<uint8_t,  4,4, false, false> CPictureI410_8;
 
 typedef CPictureYUVPlanar<uint8_t,  4,1, false, false> CPictureI411_8;
 
-typedef CPictureYUVSemiPlanar<false>                   CPictureNV12;
-typedef CPictureYUVSemiPlanar<true>                    CPictureNV21;
+typedef CPictureYUVSemiPlanar<uint8_t,  false, 0>     CPictureNV12;
+typedef CPictureYUVSemiPlanar<uint8_t,  true,  0>     CPictureNV21;
+typedef CPictureYUVSemiPlanar<uint16_t, false, 6>     CPictureP010;
+typedef CPictureYUVSemiPlanar<uint16_t, false, 4>     CPictureP012;
 
 typedef CPictureYUVPlanar<uint8_t,  2,2, false, true>  CPictureYV12;
 typedef CPictureYUVPlanar<uint8_t,  2,2, false, false> CPictureI420_8;
@@ -455,6 +485,7 @@ struct convertBits {
 };
 typedef convertBits< 9, 8> convert8To9Bits;
 typedef convertBits<10, 8> convert8To10Bits;
+typedef convertBits<12, 8> convert8To12Bits;
 typedef convertBits<16, 8> convert8To16Bits;
 
 struct convertRgbToYuv8 {
@@ -604,6 +635,349 @@ void Blend(const CPicture &dst_data, const CPicture &src_data,
     }
 }
 
+/* YUVA onto 10 and 12 bits 4:2:0, i.e. subpictures on HDR video.
+ *
+ * Each line is first bounded to its non transparent span, then blended by
+ * kernels skipping transparent groups of pixels. Results are identical to
+ * the generic Blend() with convertBits: the 8 bits to N bits expansion
+ * v * (2^N - 1) / 255 is computed exactly as q * v + div255(r * v). */
+namespace {
+
+typedef void (*blend_luma_t)(uint16_t *dst, const uint8_t *y,
+                             const uint8_t *a, unsigned count, unsigned alpha);
+/* Source samples are 2 pixels apart, destination ones step samples apart */
+typedef void (*blend_chroma_t)(uint16_t *dst_u, uint16_t *dst_v,
+                               const uint8_t *u, const uint8_t *v,
+                               const uint8_t *a, unsigned count, unsigned alpha);
+
+template <unsigned bits>
+struct expand8 {
+    static const unsigned max = (1 << bits) - 1;
+    static const unsigned q = max / 255;
+    static const unsigned r = max % 255;
+};
+
+static inline bool IsTransparent8(const uint8_t *a)
+{
+    uint64_t w;
+    memcpy(&w, a, sizeof(w));
+    return w == 0;
+}
+
+static bool AlphaSpan(const uint8_t *a, unsigned count,
+                      unsigned *start, unsigned *end)
+{
+    unsigned s = 0, e = count;
+
+    while (s + 8 <= e && IsTransparent8(&a[s]))
+        s += 8;
+    while (s < e && a[s] == 0)
+        s++;
+    while (e >= s + 8 && IsTransparent8(&a[e - 8]))
+        e -= 8;
+    while (e > s && a[e - 1] == 0)
+        e--;
+
+    *start = s;
+    *end = e;
+    return s < e;
+}
+
+template <unsigned bits, unsigned shift>
+static inline void BlendSample(uint16_t *dst, unsigned src, unsigned f)
+{
+    unsigned v = *dst >> shift;
+    ::merge(&v, src * expand8<bits>::max / 255, f);
+    *dst = v << shift;
+}
+
+template <unsigned bits, unsigned shift>
+void BlendLumaC(uint16_t *dst, const uint8_t *y, const uint8_t *a,
+                unsigned count, unsigned alpha)
+{
+    for (unsigned i = 0; i < count; i++) {
+        if (i + 8 <= count && IsTransparent8(&a[i])) {
+            i += 7;
+            continue;
+        }
+        unsigned f = div255(alpha * a[i]);
+        if (f > 0)
+            BlendSample<bits, shift>(&dst[i], y[i], f);
+    }
+}
+
+template <unsigned bits, unsigned shift, unsigned step>
+void BlendChromaC(uint16_t *dst_u, uint16_t *dst_v,
+                  const uint8_t *u, const uint8_t *v,
+                  const uint8_t *a, unsigned count, unsigned alpha)
+{
+    for (unsigned i = 0; i < count; i++) {
+        unsigned f = div255(alpha * a[2 * i]);
+        if (f == 0)
+            continue;
+        BlendSample<bits, shift>(&dst_u[step * i], u[2 * i], f);
+        BlendSample<bits, shift>(&dst_v[step * i], v[2 * i], f);
+    }
+}
+
+#if defined(HAVE_AVX2_INTRINSICS)
+#define AVX2 __attribute__((__target__("avx2")))
+
+AVX2 static inline __m256i Div255x16(__m256i v)
+{
+    v = _mm256_add_epi16(_mm256_add_epi16(v, _mm256_srli_epi16(v, 8)),
+                         _mm256_set1_epi16(1));
+    return _mm256_srli_epi16(v, 8);
+}
+
+AVX2 static inline __m256i Div255x32(__m256i v)
+{
+    v = _mm256_add_epi32(_mm256_add_epi32(v, _mm256_srli_epi32(v, 8)),
+                         _mm256_set1_epi32(1));
+    return _mm256_srli_epi32(v, 8);
+}
+
+template <unsigned bits>
+AVX2 static inline __m256i ExpandAVX2(__m256i v)
+{
+    const __m256i q = _mm256_mullo_epi16(v, _mm256_set1_epi16(expand8<bits>::q));
+    const __m256i r = _mm256_mullo_epi16(v, _mm256_set1_epi16(expand8<bits>::r));
+    return _mm256_add_epi16(q, Div255x16(r));
+}
+
+/* Blends 16 samples, keeping the destination where f is 0 */
+template <unsigned bits, unsigned shift>
+AVX2 static inline __m256i MergeAVX2(__m256i dst, __m256i src, __m256i f)
+{
+    const __m256i d = _mm256_srli_epi16(dst, shift);
+    const __m256i s = ExpandAVX2<bits>(src);
+    const __m256i g = _mm256_sub_epi16(_mm256_set1_epi16(255), f);
+
+    /* (255 - f) * d + f * s on 32 bits, samples fit signed 16 bits */
+    __m256i lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(d, s),
+                                   _mm256_unpacklo_epi16(g, f));
+    __m256i hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(d, s),
+                                   _mm256_unpackhi_epi16(g, f));
+    __m256i m = _mm256_packus_epi32(Div255x32(lo), Div255x32(hi));
+    m = _mm256_slli_epi16(m, shift);
+
+    const __m256i skip = _mm256_cmpeq_epi16(f, _mm256_setzero_si256());
+    return _mm256_blendv_epi8(m, dst, skip);
+}
+
+template <unsigned bits, unsigned shift>
+AVX2 void BlendLumaAVX2(uint16_t *dst, const uint8_t *y, const uint8_t *a,
+                        unsigned count, unsigned alpha)
+{
+    const __m256i k_alpha = _mm256_set1_epi16(alpha);
+    unsigned i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        const __m128i a8 = _mm_loadu_si128((const __m128i *)&a[i]);
+        if (_mm_testz_si128(a8, a8))
+            continue;
+
+        const __m256i f = Div255x16(_mm256_mullo_epi16(_mm256_cvtepu8_epi16(a8),
+                                                       k_alpha));
+        const __m256i s = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)&y[i]));
+        __m256i *d = (__m256i *)&dst[i];
+        _mm256_storeu_si256(d, MergeAVX2<bits, shift>(_mm256_loadu_si256(d), s, f));
+    }
+    BlendLumaC<bits, shift>(&dst[i], &y[i], &a[i], count - i, alpha);
+}
+
+template <unsigned bits, unsigned shift, unsigned step>
+AVX2 void BlendChromaAVX2(uint16_t *dst_u, uint16_t *dst_v,
+                          const uint8_t *u, const uint8_t *v,
+                          const uint8_t *a, unsigned count, unsigned alpha)
+{
+    const __m256i k_alpha = _mm256_set1_epi16(alpha);
+    const __m256i even8 = _mm256_set1_epi16(0x00ff);
+    const __m256i even16 = _mm256_set1_epi32(0xffff);
+    unsigned i = 0;
+
+    /* The last source sample is the first byte of a pair */
+    for (; i + 16 < count; i += 16) {
+        const __m256i a16 = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)&a[2 * i]),
+                                             even8);
+        if (_mm256_testz_si256(a16, a16))
+            continue;
+
+        const __m256i f = Div255x16(_mm256_mullo_epi16(a16, k_alpha));
+        const __m256i su = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)&u[2 * i]),
+                                            even8);
+        const __m256i sv = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)&v[2 * i]),
+                                            even8);
+        if (step == 1) {
+            __m256i *du = (__m256i *)&dst_u[i];
+            __m256i *dv = (__m256i *)&dst_v[i];
+            _mm256_storeu_si256(du, MergeAVX2<bits, shift>(_mm256_loadu_si256(du), su, f));
+            _mm256_storeu_si256(dv, MergeAVX2<bits, shift>(_mm256_loadu_si256(dv), sv, f));
+        } else {
+            /* Interleaved UV: split into U and V, then back */
+            __m256i *d = (__m256i *)&dst_u[2 * i];
+            const __m256i p0 = _mm256_loadu_si256(&d[0]);
+            const __m256i p1 = _mm256_loadu_si256(&d[1]);
+            __m256i du = _mm256_packus_epi32(_mm256_and_si256(p0, even16),
+                                             _mm256_and_si256(p1, even16));
+            __m256i dv = _mm256_packus_epi32(_mm256_srli_epi32(p0, 16),
+                                             _mm256_srli_epi32(p1, 16));
+            du = MergeAVX2<bits, shift>(_mm256_permute4x64_epi64(du, 0xd8), su, f);
+            dv = MergeAVX2<bits, shift>(_mm256_permute4x64_epi64(dv, 0xd8), sv, f);
+
+            const __m256i lo = _mm256_unpacklo_epi16(du, dv);
+            const __m256i hi = _mm256_unpackhi_epi16(du, dv);
+            _mm256_storeu_si256(&d[0], _mm256_permute2x128_si256(lo, hi, 0x20));
+            _mm256_storeu_si256(&d[1], _mm256_permute2x128_si256(lo, hi, 0x31));
+        }
+    }
+    BlendChromaC<bits, shift, step>(&dst_u[step * i], &dst_v[step * i],
+                                    &u[2 * i], &v[2 * i], &a[2 * i],
+                                    count - i, alpha);
+}
+#undef AVX2
+#endif
+
+#if defined(__ARM_NEON)
+static inline uint16x8_t Div255x16(uint16x8_t v)
+{
+    return vshrq_n_u16(vaddq_u16(vsraq_n_u16(v, v, 8), vdupq_n_u16(1)), 8);
+}
+
+static inline uint32x4_t Div255x32(uint32x4_t v)
+{
+    return vshrq_n_u32(vaddq_u32(vsraq_n_u32(v, v, 8), vdupq_n_u32(1)), 8);
+}
+
+/* Blends 8 samples, keeping the destination where f is 0 */
+template <unsigned bits, unsigned shift>
+static inline uint16x8_t MergeNEON(uint16x8_t dst, uint16x8_t src, uint16x8_t f)
+{
+    const uint16x8_t d = vshlq_u16(dst, vdupq_n_s16(-(int)shift));
+    const uint16x8_t s = vaddq_u16(vmulq_n_u16(src, expand8<bits>::q),
+                                   Div255x16(vmulq_n_u16(src, expand8<bits>::r)));
+    const uint16x8_t g = vsubq_u16(vdupq_n_u16(255), f);
+
+    uint32x4_t lo = vmull_u16(vget_low_u16(d), vget_low_u16(g));
+    uint32x4_t hi = vmull_u16(vget_high_u16(d), vget_high_u16(g));
+    lo = vmlal_u16(lo, vget_low_u16(s), vget_low_u16(f));
+    hi = vmlal_u16(hi, vget_high_u16(s), vget_high_u16(f));
+    uint16x8_t m = vcombine_u16(vmovn_u32(Div255x32(lo)), vmovn_u32(Div255x32(hi)));
+    m = vshlq_u16(m, vdupq_n_s16(shift));
+
+    return vbslq_u16(vceqq_u16(f, vdupq_n_u16(0)), dst, m);
+}
+
+template <unsigned bits, unsigned shift>
+void BlendLumaNEON(uint16_t *dst, const uint8_t *y, const uint8_t *a,
+                   unsigned count, unsigned alpha)
+{
+    unsigned i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        const uint8x8_t a8 = vld1_u8(&a[i]);
+        if (vget_lane_u64(vreinterpret_u64_u8(a8), 0) == 0)
+            continue;
+
+        const uint16x8_t f = Div255x16(vmulq_n_u16(vmovl_u8(a8), alpha));
+        const uint16x8_t s = vmovl_u8(vld1_u8(&y[i]));
+        vst1q_u16(&dst[i], MergeNEON<bits, shift>(vld1q_u16(&dst[i]), s, f));
+    }
+    BlendLumaC<bits, shift>(&dst[i], &y[i], &a[i], count - i, alpha);
+}
+
+template <unsigned bits, unsigned shift, unsigned step>
+void BlendChromaNEON(uint16_t *dst_u, uint16_t *dst_v,
+                     const uint8_t *u, const uint8_t *v,
+                     const uint8_t *a, unsigned count, unsigned alpha)
+{
+    unsigned i = 0;
+
+    /* The last source sample is the first byte of a pair */
+    for (; i + 8 < count; i += 8) {
+        const uint8x8_t a8 = vld2_u8(&a[2 * i]).val[0];
+        if (vget_lane_u64(vreinterpret_u64_u8(a8), 0) == 0)
+            continue;
+
+        const uint16x8_t f = Div255x16(vmulq_n_u16(vmovl_u8(a8), alpha));
+        const uint16x8_t su = vmovl_u8(vld2_u8(&u[2 * i]).val[0]);
+        const uint16x8_t sv = vmovl_u8(vld2_u8(&v[2 * i]).val[0]);
+        if (step == 1) {
+            vst1q_u16(&dst_u[i], MergeNEON<bits, shift>(vld1q_u16(&dst_u[i]), su, f));
+            vst1q_u16(&dst_v[i], MergeNEON<bits, shift>(vld1q_u16(&dst_v[i]), sv, f));
+        } else {
+            uint16x8x2_t uv = vld2q_u16(&dst_u[2 * i]);
+            uv.val[0] = MergeNEON<bits, shift>(uv.val[0], su, f);
+            uv.val[1] = MergeNEON<bits, shift>(uv.val[1], sv, f);
+            vst2q_u16(&dst_u[2 * i], uv);
+        }
+    }
+    BlendChromaC<bits, shift, step>(&dst_u[step * i], &dst_v[step * i],
+                                    &u[2 * i], &v[2 * i], &a[2 * i],
+                                    count - i, alpha);
+}
+#endif
+
+} // namespace
+
+template <unsigned bits, bool semi_planar>
+void BlendYUVA420_16(const CPicture &dst_data, const CPicture &src_data,
+                     unsigned width, unsigned height, int alpha)
+{
+    /* Semi planar formats store the samples in the most significant bits */
+    const unsigned shift = semi_planar ? 16 - bits : 0;
+    const unsigned step = semi_planar ? 2 : 1;
+
+    blend_luma_t blend_luma = BlendLumaC<bits, shift>;
+    blend_chroma_t blend_chroma = BlendChromaC<bits, shift, step>;
+#if defined(HAVE_AVX2_INTRINSICS)
+    if (vlc_CPU_AVX2()) {
+        blend_luma = BlendLumaAVX2<bits, shift>;
+        blend_chroma = BlendChromaAVX2<bits, shift, step>;
+    }
+#endif
+#if defined(__ARM_NEON)
+    if (vlc_CPU_ARM_NEON()) {
+        blend_luma = BlendLumaNEON<bits, shift>;
+        blend_chroma = BlendChromaNEON<bits, shift, step>;
+    }
+#endif
+
+    const unsigned x = dst_data.getX();
+    const unsigned sx = src_data.getX();
+
+    for (unsigned dy = 0; dy < height; dy++) {
+        const uint8_t *a = &src_data.getLineAt(A_PLANE, dy)[sx];
+        unsigned start, end;
+        if (!AlphaSpan(a, width, &start, &end))
+            continue;
+
+        const uint8_t *y = &src_data.getLineAt(Y_PLANE, dy)[sx];
+        uint16_t *dst_y = (uint16_t *)dst_data.getLineAt(Y_PLANE, dy) + x;
+        blend_luma(&dst_y[start], &y[start], &a[start], end - start, alpha);
+
+        /* Chroma is blended from the top left pixel of each 2x2 block */
+        if ((dst_data.getY() + dy) % 2)
+            continue;
+        start += (x + start) % 2;
+        if (start >= end)
+            continue;
+
+        const uint8_t *u = &src_data.getLineAt(U_PLANE, dy)[sx];
+        const uint8_t *v = &src_data.getLineAt(V_PLANE, dy)[sx];
+        uint16_t *dst_u, *dst_v;
+        if (semi_planar) {
+            dst_u = (uint16_t *)dst_data.getLineAt(1, dy, 2) + (x + start) / 2 * 2;
+            dst_v = dst_u + 1;
+        } else {
+            dst_u = (uint16_t *)dst_data.getLineAt(U_PLANE, dy, 2) + (x + start) / 2;
+            dst_v = (uint16_t *)dst_data.getLineAt(V_PLANE, dy, 2) + (x + start) / 2;
+        }
+        blend_chroma(dst_u, dst_v, &u[start], &v[start], &a[start],
+                     (end - start + 1) / 2, alpha);
+    }
+}
+
 typedef void (*blend_function_t)(const CPicture &dst_data, const CPicture &src_data,
                                  unsigned width, unsigned height, int alpha);
 
@@ -654,6 +1028,14 @@ static const struct {
 #else
     YUV(VLC_CODEC_I420_9L,  CPictureI420_16,  convert8To9Bits),
     YUV(VLC_CODEC_I420_10L, CPictureI420_16,  convert8To10Bits),
+    YUV(VLC_CODEC_I420_12L, CPictureI420_16,  convert8To12Bits),
+    YUV(VLC_CODEC_P010,     CPictureP010,     convert8To10Bits),
+    YUV(VLC_CODEC_P012,     CPictureP012,     convert8To12Bits),
+    /* Overrides the generic YUVA entries above */
+    { VLC_CODEC_I420_10L, VLC_CODEC_YUVA, BlendYUVA420_16<10, false> },
+    { VLC_CODEC_I420_12L, VLC_CODEC_YUVA, BlendYUVA420_16<12, false> },
+    { VLC_CODEC_P010,     VLC_CODEC_YUVA, BlendYUVA420_16<10, true> },
+    { VLC_CODEC_P012,     VLC_CODEC_YUVA, BlendYUVA420_16<12, true> },
 #endif
 
     YUV(VLC_CODEC_I422,     CPictureI422_8,   convertNone),
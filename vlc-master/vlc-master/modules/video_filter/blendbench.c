@@ -58,6 +58,14 @@ static picture_t *Filter( filter_t *, picture_t * );
 #define BASE_IMAGE_TEXT N_("Image to be blended onto")
 #define BASE_IMAGE_LONGTEXT N_("The image which will be used to blend onto")
 
+#define BASE_WIDTH_TEXT N_("Width of the base image")
+#define BASE_WIDTH_LONGTEXT N_("Width the base image is scaled to " \
+                               "(0 keeps the image width)")
+
+#define BASE_HEIGHT_TEXT N_("Height of the base image")
+#define BASE_HEIGHT_LONGTEXT N_("Height the base image is scaled to " \
+                                "(0 keeps the image height)")
+
 #define BASE_CHROMA_TEXT N_("Chroma for the base image")
 #define BASE_CHROMA_LONGTEXT N_("Chroma which the base image will be loaded in")
 
@@ -86,6 +94,10 @@ vlc_module_begin ()
                  BASE_IMAGE_TEXT, BASE_IMAGE_LONGTEXT)
     add_string( CFG_PREFIX "base-chroma", "I420", BASE_CHROMA_TEXT,
               BASE_CHROMA_LONGTEXT )
+    add_integer( CFG_PREFIX "base-width", 7680, BASE_WIDTH_TEXT,
+                 BASE_WIDTH_LONGTEXT )
+    add_integer( CFG_PREFIX "base-height", 4320, BASE_HEIGHT_TEXT,
+                 BASE_HEIGHT_LONGTEXT )
 
     set_section( N_("Blend image"), NULL )
     add_loadfile(CFG_PREFIX "blend-image", NULL,
@@ -97,8 +109,8 @@ vlc_module_begin ()
 vlc_module_end ()
 
 static const char *const ppsz_filter_options[] = {
-    "loops", "alpha", "base-image", "base-chroma", "blend-image",
-    "blend-chroma", NULL
+    "loops", "alpha", "base-image", "base-chroma", "base-width",
+    "base-height", "blend-image", "blend-chroma", NULL
 };
 
 /*****************************************************************************
@@ -117,12 +129,16 @@ typedef struct
 } filter_sys_t;
 
 static int blendbench_LoadImage( vlc_object_t *p_this, picture_t **pp_pic,
-                                 vlc_fourcc_t i_chroma, char *psz_file, const char *psz_name )
+                                 vlc_fourcc_t i_chroma, unsigned i_width,
+                                 unsigned i_height, char *psz_file,
+                                 const char *psz_name )
 {
     image_handler_t *p_image;
     video_format_t fmt_out;
 
     video_format_Init( &fmt_out, i_chroma );
+    fmt_out.i_width = fmt_out.i_visible_width = i_width;
+    fmt_out.i_height = fmt_out.i_visible_height = i_height;
 
     p_image = image_HandlerCreate( p_this );
     *pp_pic = image_ReadUrl( p_image, psz_file, &fmt_out );
@@ -181,7 +197,10 @@ static int Create( filter_t *p_filter )
         VLC_FOURCC( psz_temp[0], psz_temp[1], psz_temp[2], psz_temp[3] );
     psz_cmd = var_CreateGetStringCommand( p_filter, CFG_PREFIX "base-image" );
     i_ret = blendbench_LoadImage( VLC_OBJECT(p_filter), &p_sys->p_base_image,
-                                  p_sys->i_base_chroma, psz_cmd, "Base" );
+                                  p_sys->i_base_chroma,
+                                  var_CreateGetInteger( p_filter, CFG_PREFIX "base-width" ),
+                                  var_CreateGetInteger( p_filter, CFG_PREFIX "base-height" ),
+                                  psz_cmd, "Base" );
     free( psz_temp );
     free( psz_cmd );
     if( i_ret != VLC_SUCCESS )
@@ -196,7 +215,7 @@ static int Create( filter_t *p_filter )
         ? 0 : VLC_FOURCC( psz_temp[0], psz_temp[1], psz_temp[2], psz_temp[3] );
     psz_cmd = var_CreateGetStringCommand( p_filter, CFG_PREFIX "blend-image" );
     i_ret = blendbench_LoadImage( VLC_OBJECT(p_filter), &p_sys->p_blend_image, p_sys->i_blend_chroma,
-                                  psz_cmd, "Blend" );
+                                  0, 0, psz_cmd, "Blend" );
 
     free( psz_temp );
     free( psz_cmd );
@@ -259,13 +278,22 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
     }
     time = vlc_tick_now() - time;
 
+    /* Blended area, the blend image is cropped to the base one */
+    const video_format_t *p_base = &p_sys->p_base_image->format;
+    const video_format_t *p_over = &p_sys->p_blend_image->format;
+    const double f_pixels = (double)
+        __MIN( p_base->i_visible_width, p_over->i_visible_width ) *
+        __MIN( p_base->i_visible_height, p_over->i_visible_height );
+    const double f_rate = p_sys->i_loops / secf_from_vlc_tick( time );
+
     msg_Info( p_filter, "Blended %d images in %f sec", p_sys->i_loops,
               secf_from_vlc_tick(time) );
-    msg_Info( p_filter, "Speed is: %f images/second, %f pixels/second",
-              (float) p_sys->i_loops / time * CLOCK_FREQ,
-              (float) p_sys->i_loops / time * CLOCK_FREQ *
-                  p_sys->p_blend_image->p[Y_PLANE].i_visible_pitch *
-                  p_sys->p_blend_image->p[Y_PLANE].i_visible_lines );
+    msg_Info( p_filter, "Speed is: %f images/second, %f Mpixel/s",
+              f_rate, f_rate * f_pixels / 1000000. );
+    msg_Info( p_filter, "Base frame %ux%u (%4.4s): %f Mpixel/s",
+              p_base->i_visible_width, p_base->i_visible_height,
+              (const char *)&p_base->i_chroma,
+              f_rate * p_base->i_visible_width * p_base->i_visible_height / 1000000. );
 
     vlc_filter_Delete( p_blend );
 
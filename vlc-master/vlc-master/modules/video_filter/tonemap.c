@@ -0,0 +1,304 @@
+/*****************************************************************************
+ * tonemap.c: HDR to SDR tone mapping video filter
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_configuration.h>
+#include <vlc_plugin.h>
+#include <vlc_filter.h>
+#include <vlc_picture.h>
+#include <vlc_cpu.h>
+#include <vlc_executor.h>
+
+#include "tonemap.h"
+
+static int OpenFilter(filter_t *);
+static int OpenConverter(filter_t *);
+
+#define CURVE_TEXT N_("Tone mapping curve")
+#define CURVE_LONGTEXT N_("Curve compressing the HDR highlights into the " \
+    "SDR range")
+
+#define TARGET_TEXT N_("Target peak luminance")
+#define TARGET_LONGTEXT N_("Peak luminance of the SDR output, in cd/m²")
+
+#define PEAK_TEXT N_("Source peak luminance")
+#define PEAK_LONGTEXT N_("Peak luminance of the HDR input, in cd/m², when " \
+    "the stream does not signal it (0 for 1000)")
+
+#define THREADS_TEXT N_("Threads")
+#define THREADS_LONGTEXT N_("Number of threads used to process a picture " \
+    "(0 for one per CPU)")
+
+#define FILTER_PREFIX "tonemap-"
+
+static const char *const ppsz_curve_values[] = {
+    "bt2390", "hable", "reinhard", "clip",
+};
+static const char *const ppsz_curve_descriptions[] = {
+    N_("ITU-R BT.2390 EETF"),
+    N_("Hable (filmic)"),
+    N_("Reinhard"),
+    N_("Clip"),
+};
+
+vlc_module_begin()
+    set_description(N_("HDR to SDR tone mapping video filter"))
+    set_shortname(N_("Tone mapping"))
+    set_subcategory(SUBCAT_VIDEO_VFILTER)
+    add_string(FILTER_PREFIX "curve", "bt2390", CURVE_TEXT, CURVE_LONGTEXT)
+        change_string_list(ppsz_curve_values, ppsz_curve_descriptions)
+    add_integer_with_range(FILTER_PREFIX "target", 100, 50, 1000,
+                           TARGET_TEXT, TARGET_LONGTEXT)
+    add_integer_with_range(FILTER_PREFIX "peak", 0, 0, 10000,
+                           PEAK_TEXT, PEAK_LONGTEXT)
+    add_integer_with_range(FILTER_PREFIX "threads", 0, 0, 64,
+                           THREADS_TEXT, THREADS_LONGTEXT)
+    set_callback_video_filter(OpenFilter)
+
+    add_submodule()
+    /* Above swscale, which converts these chromas but ignores the transfer
+     * function. Only HDR to SDR conversions are accepted. */
+    set_callback_video_converter(OpenConverter, 200)
+vlc_module_end()
+
+static const char *const ppsz_filter_options[] = {
+    "curve", "target", "peak", "threads", NULL
+};
+
+typedef struct tonemap_slice
+{
+    struct vlc_runnable runnable;
+    const struct tonemap *tonemap;
+    picture_t *in, *out;
+    unsigned first, last; /* luma rows */
+    vlc_latch_t *done;
+} tonemap_slice_t;
+
+typedef struct
+{
+    struct tonemap tonemap;
+
+    vlc_executor_t *executor;
+    tonemap_slice_t *slices;
+    unsigned slice_count;
+} filter_sys_t;
+
+VIDEO_FILTER_WRAPPER_CLOSE(Filter, Close)
+
+static void RunSlice(void *opaque)
+{
+    tonemap_slice_t *slice = opaque;
+
+    tonemap_Slice(slice->tonemap, slice->out, slice->in,
+                  slice->first, slice->last);
+    if (slice->done)
+        vlc_latch_count_down(slice->done, 1);
+}
+
+static void Filter(filter_t *p_filter, picture_t *p_pic, picture_t *p_outpic)
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const unsigned rows = p_pic->p[0].i_visible_lines;
+
+    /* Small pictures are not worth the synchronisation */
+    unsigned count = __MIN(p_sys->slice_count, rows / 64);
+    if (count <= 1 || p_sys->executor == NULL)
+    {
+        tonemap_Slice(&p_sys->tonemap, p_outpic, p_pic, 0, rows);
+        return;
+    }
+
+    /* Bands start on even rows, so that they do not share chroma rows */
+    unsigned band = ((rows + count - 1) / count + 1) & ~1u;
+    vlc_latch_t done;
+
+    vlc_latch_init(&done, count);
+    for (unsigned i = 0; i < count; i++)
+    {
+        tonemap_slice_t *slice = &p_sys->slices[i];
+        slice->tonemap = &p_sys->tonemap;
+        slice->in = p_pic;
+        slice->out = p_outpic;
+        slice->first = __MIN(rows, i * band);
+        slice->last = __MIN(rows, (i + 1) * band);
+        slice->done = &done;
+        slice->runnable.run = RunSlice;
+        slice->runnable.userdata = slice;
+    }
+
+    /* Run the first band on the filter thread, the others on the executor */
+    for (unsigned i = 1; i < count; i++)
+        vlc_executor_Submit(p_sys->executor, &p_sys->slices[i].runnable);
+    RunSlice(&p_sys->slices[0]);
+    vlc_latch_wait(&done);
+}
+
+static void Close(filter_t *p_filter)
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if (p_sys->executor)
+        vlc_executor_Delete(p_sys->executor);
+    free(p_sys->slices);
+    tonemap_Clean(&p_sys->tonemap);
+    free(p_sys);
+}
+
+static bool IsSDR(const video_format_t *fmt)
+{
+    return fmt->transfer != TRANSFER_FUNC_SMPTE_ST2084
+        && fmt->transfer != TRANSFER_FUNC_HLG
+        && fmt->transfer != TRANSFER_FUNC_LINEAR
+        && fmt->primaries != COLOR_PRIMARIES_BT2020
+        && fmt->color_range != COLOR_RANGE_FULL;
+}
+
+static enum tonemap_curve GetCurve(filter_t *p_filter)
+{
+    enum tonemap_curve curve = TONEMAP_BT2390;
+    char *psz_curve = var_InheritString(p_filter, FILTER_PREFIX "curve");
+
+    if (psz_curve)
+    {
+        if (!strcmp(psz_curve, "hable"))
+            curve = TONEMAP_HABLE;
+        else if (!strcmp(psz_curve, "reinhard"))
+            curve = TONEMAP_REINHARD;
+        else if (!strcmp(psz_curve, "clip"))
+            curve = TONEMAP_CLIP;
+        else if (strcmp(psz_curve, "bt2390"))
+            msg_Err(p_filter, "Unknown tone mapping curve '%s'", psz_curve);
+    }
+    free(psz_curve);
+    return curve;
+}
+
+static float GetSourcePeak(filter_t *p_filter, const video_format_t *fmt)
+{
+    /* HLG is scene referred: the peak is the one of the nominal display */
+    if (fmt->transfer != TRANSFER_FUNC_HLG)
+    {
+        /* Content light level first, it is tighter than the mastering
+         * display one. The mastering luminance is in 0.0001 cd/m². */
+        if (fmt->lighting.MaxCLL)
+            return fmt->lighting.MaxCLL;
+        if (fmt->mastering.max_luminance)
+            return fmt->mastering.max_luminance / 10000.f;
+    }
+
+    int peak = var_InheritInteger(p_filter, FILTER_PREFIX "peak");
+    return peak > 0 ? peak : 1000.f;
+}
+
+static int Open(filter_t *p_filter, bool converter)
+{
+    const video_format_t *in = &p_filter->fmt_in.video;
+    video_format_t *out = &p_filter->fmt_out.video;
+
+    if (in->i_chroma != VLC_CODEC_I420_10L && in->i_chroma != VLC_CODEC_P010)
+        return VLC_EGENERIC;
+    if (in->transfer != TRANSFER_FUNC_SMPTE_ST2084
+     && in->transfer != TRANSFER_FUNC_HLG)
+        return VLC_EGENERIC;
+
+    if (converter)
+    {
+        if (out->i_chroma != VLC_CODEC_I420 || !IsSDR(out)
+         || in->i_width != out->i_width || in->i_height != out->i_height
+         || in->orientation != out->orientation)
+            return VLC_EGENERIC;
+    }
+    else
+    {
+        config_ChainParse(p_filter, FILTER_PREFIX, ppsz_filter_options,
+                          p_filter->p_cfg);
+
+        /* Other chromas are handled by the converters of the chain, and
+         * the output is plain SDR */
+        out->i_chroma = VLC_CODEC_I420;
+        out->primaries = COLOR_PRIMARIES_BT709;
+        out->transfer = TRANSFER_FUNC_BT709;
+        out->space = COLOR_SPACE_BT709;
+        out->color_range = COLOR_RANGE_LIMITED;
+        memset(&out->mastering, 0, sizeof(out->mastering));
+        memset(&out->lighting, 0, sizeof(out->lighting));
+    }
+
+    struct tonemap_params params = {
+        .hlg = in->transfer == TRANSFER_FUNC_HLG,
+        .full_range = in->color_range == COLOR_RANGE_FULL,
+        .semiplanar = in->i_chroma == VLC_CODEC_P010,
+        .src_peak = GetSourcePeak(p_filter, in),
+        .dst_peak = var_InheritInteger(p_filter, FILTER_PREFIX "target"),
+        .curve = GetCurve(p_filter),
+    };
+
+    filter_sys_t *p_sys = calloc(1, sizeof(*p_sys));
+    if (!p_sys)
+        return VLC_ENOMEM;
+    p_filter->p_sys = p_sys;
+
+    if (tonemap_Init(&p_sys->tonemap, &params, true))
+    {
+        free(p_sys);
+        return VLC_ENOMEM;
+    }
+
+    unsigned threads = var_InheritInteger(p_filter, FILTER_PREFIX "threads");
+    if (threads == 0)
+        threads = vlc_GetCPUCount();
+    threads = __MAX(threads, 1);
+
+    p_sys->slices = calloc(threads, sizeof(*p_sys->slices));
+    if (!p_sys->slices)
+    {
+        Close(p_filter);
+        return VLC_ENOMEM;
+    }
+
+    /* The filter thread runs one band itself */
+    if (threads > 1)
+    {
+        p_sys->executor = vlc_executor_New(threads - 1);
+        if (!p_sys->executor)
+            threads = 1;
+    }
+    p_sys->slice_count = threads;
+
+    msg_Dbg(p_filter, "%s %.0f cd/m² to SDR %.0f cd/m²",
+            params.hlg ? "HLG" : "PQ", params.src_peak, params.dst_peak);
+
+    p_filter->ops = &Filter_ops;
+    return VLC_SUCCESS;
+}
+
+static int OpenFilter(filter_t *p_filter)
+{
+    return Open(p_filter, false);
+}
+
+static int OpenConverter(filter_t *p_filter)
+{
+    return Open(p_filter, true);
+}
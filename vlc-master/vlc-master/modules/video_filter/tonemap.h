@@ -0,0 +1,87 @@
+/*****************************************************************************
+ * tonemap.h: HDR to SDR tone mapping 3D LUT
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_TONEMAP_H
+#define VLC_TONEMAP_H
+
+#include <vlc_picture.h>
+
+/* The whole conversion, from 10-bit BT.2020 Y'CbCr to 8-bit BT.709 Y'CbCr,
+ * is sampled on a 33x33x33 grid of the input code values. Pixels are then
+ * converted with a tetrahedral interpolation between 4 grid nodes. */
+#define TONEMAP_LUT_SHIFT  5
+#define TONEMAP_LUT_MASK   ((1 << TONEMAP_LUT_SHIFT) - 1)
+#define TONEMAP_LUT_POINTS ((1 << (10 - TONEMAP_LUT_SHIFT)) + 1)
+#define TONEMAP_LUT_SIZE   (TONEMAP_LUT_POINTS * TONEMAP_LUT_POINTS * \
+                            TONEMAP_LUT_POINTS)
+
+enum tonemap_curve
+{
+    TONEMAP_BT2390,
+    TONEMAP_HABLE,
+    TONEMAP_REINHARD,
+    TONEMAP_CLIP,
+};
+
+struct tonemap_params
+{
+    bool hlg;            /* ARIB STD-B67, otherwise SMPTE ST 2084 */
+    bool full_range;     /* input range */
+    bool semiplanar;     /* P010, otherwise I420_10L */
+    float src_peak;      /* cd/m² */
+    float dst_peak;      /* cd/m² */
+    enum tonemap_curve curve;
+};
+
+struct tonemap
+{
+    bool semiplanar;
+    /* Output Y' and Cb'/Cr' codes, with 6 fractional bits. The chroma
+     * table packs Cb' in the low 16 bits and Cr' in the high ones. */
+    int32_t *luma;
+    int32_t *chroma;
+
+    void (*luma_line)(const struct tonemap *, uint8_t *dst,
+                      const uint16_t *y, const uint16_t *u,
+                      const uint16_t *v, unsigned width);
+    void (*chroma_line)(const struct tonemap *, uint8_t *dst_u,
+                        uint8_t *dst_v, const uint16_t *y0,
+                        const uint16_t *y1, const uint16_t *u,
+                        const uint16_t *v, unsigned width);
+};
+
+/**
+ * Computes the tables.
+ *
+ * \param cpu whether the SIMD line kernels may be used
+ * \return VLC_SUCCESS or VLC_ENOMEM
+ */
+int tonemap_Init(struct tonemap *, const struct tonemap_params *, bool cpu);
+void tonemap_Clean(struct tonemap *);
+
+/**
+ * Converts the luma rows [first, last[ and the matching chroma rows.
+ *
+ * \param first even row index
+ */
+void tonemap_Slice(const struct tonemap *, picture_t *dst,
+                   const picture_t *src, unsigned first, unsigned last);
+
+#endif
@@ -0,0 +1,617 @@
+/*****************************************************************************
+ * tonemap_lut.c: HDR to SDR tone mapping 3D LUT
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+#include <vlc_picture.h>
+
+#include "tonemap.h"
+
+#if defined(HAVE_AVX2_INTRINSICS)
+#   include <immintrin.h>
+#endif
+
+#define STRIDE_Y (TONEMAP_LUT_POINTS * TONEMAP_LUT_POINTS)
+#define STRIDE_U TONEMAP_LUT_POINTS
+#define STRIDE_V 1
+#define ONE      (1 << TONEMAP_LUT_SHIFT)
+#define OUT_SHIFT (TONEMAP_LUT_SHIFT + 6)
+#define ROUND    (1 << (OUT_SHIFT - 1))
+
+/*****************************************************************************
+ * Tables
+ *****************************************************************************/
+/* SMPTE ST 2084 */
+#define PQ_M1 (2610. / 16384.)
+#define PQ_M2 (2523. / 4096. * 128.)
+#define PQ_C1 (3424. / 4096.)
+#define PQ_C2 (2413. / 4096. * 32.)
+#define PQ_C3 (2392. / 4096. * 32.)
+
+static double pq_eotf(double e)
+{
+    double p = pow(e, 1. / PQ_M2);
+    double n = fmax(p - PQ_C1, 0.) / (PQ_C2 - PQ_C3 * p);
+    return 10000. * pow(n, 1. / PQ_M1);
+}
+
+static double pq_inv_eotf(double nits)
+{
+    double p = pow(nits / 10000., PQ_M1);
+    return pow((PQ_C1 + PQ_C2 * p) / (1. + PQ_C3 * p), PQ_M2);
+}
+
+/* ARIB STD-B67, normalized scene light */
+static double hlg_inv_oetf(double e)
+{
+    const double a = 0.17883277, b = 1. - 4. * a, c = .5 - a * log(4. * a);
+
+    if (e <= .5)
+        return e * e / 3.;
+    return (exp((e - c) / a) + b) / 12.;
+}
+
+static double hable(double x)
+{
+    const double a = .15, b = .50, c = .10, d = .20, e = .02, f = .30;
+    return (x * (a * x + c * b) + d * e) / (x * (a * x + b) + d * f) - e / f;
+}
+
+/* Maps a display light level to the [0, 1] range of the target display */
+static double tone_map(const struct tonemap_params *p, double nits)
+{
+    const double x = nits / p->dst_peak;
+    const double peak = p->src_peak / p->dst_peak;
+
+    if (peak <= 1.)
+        return fmin(x, 1.);
+
+    switch (p->curve)
+    {
+        case TONEMAP_BT2390:
+        {
+            /* ITU-R BT.2390 EETF knee, in the PQ domain */
+            const double src = pq_inv_eotf(p->src_peak);
+            const double max = pq_inv_eotf(p->dst_peak) / src;
+            const double ks = 1.5 * max - .5;
+            double e = pq_inv_eotf(fmin(nits, p->src_peak)) / src;
+
+            if (e > ks)
+            {
+                double t = (e - ks) / (1. - ks), t2 = t * t, t3 = t2 * t;
+                e = (2. * t3 - 3. * t2 + 1.) * ks
+                  + (t3 - 2. * t2 + t) * (1. - ks)
+                  + (-2. * t3 + 3. * t2) * max;
+            }
+            return fmin(pq_eotf(e * src) / p->dst_peak, 1.);
+        }
+        case TONEMAP_HABLE:
+            return fmin(hable(x) / hable(peak), 1.);
+        case TONEMAP_REINHARD:
+            return fmin(x * (1. + x / (peak * peak)) / (1. + x), 1.);
+        case TONEMAP_CLIP:
+        default:
+            return fmin(x, 1.);
+    }
+}
+
+static int32_t to_code(double value, double offset, double scale)
+{
+    long code = lrint((offset + scale * value) * 64.);
+    return VLC_CLIP(code, 0, 255 * 64);
+}
+
+static void compute_node(const struct tonemap_params *p,
+                         unsigned iy, unsigned iu, unsigned iv,
+                         int32_t *luma, int32_t *chroma)
+{
+    /* The last node is the largest code value */
+    const double y = __MIN(iy << TONEMAP_LUT_SHIFT, 1023);
+    const double u = __MIN(iu << TONEMAP_LUT_SHIFT, 1023);
+    const double v = __MIN(iv << TONEMAP_LUT_SHIFT, 1023);
+    double ey, eb, er;
+
+    if (p->full_range)
+    {
+        ey = y / 1023.;
+        eb = (u - 512.) / 1023.;
+        er = (v - 512.) / 1023.;
+    }
+    else
+    {
+        ey = (y - 64.) / 876.;
+        eb = (u - 512.) / 896.;
+        er = (v - 512.) / 896.;
+    }
+
+    /* BT.2020 non constant luminance */
+    double rgb[3];
+    rgb[0] = ey + 1.4746 * er;
+    rgb[2] = ey + 1.8814 * eb;
+    rgb[1] = (ey - .2627 * rgb[0] - .0593 * rgb[2]) / .6780;
+    for (unsigned i = 0; i < 3; i++)
+        rgb[i] = VLC_CLIP(rgb[i], 0., 1.);
+
+    /* Display light, in cd/m² */
+    if (p->hlg)
+    {
+        for (unsigned i = 0; i < 3; i++)
+            rgb[i] = hlg_inv_oetf(rgb[i]);
+
+        /* BT.2100 OOTF, with the system gamma of the nominal peak */
+        double ys = .2627 * rgb[0] + .6780 * rgb[1] + .0593 * rgb[2];
+        double gamma = 1.2 + .42 * log10(p->src_peak / 1000.);
+        double scale = ys > 0. ? p->src_peak * pow(ys, gamma - 1.) : 0.;
+        for (unsigned i = 0; i < 3; i++)
+            rgb[i] *= scale;
+    }
+    else
+    {
+        for (unsigned i = 0; i < 3; i++)
+            rgb[i] = pq_eotf(rgb[i]);
+    }
+
+    /* Tone map the largest component, keeping the hue */
+    double m = fmax(rgb[0], fmax(rgb[1], rgb[2]));
+    double scale = m > 0. ? tone_map(p, m) / m : 0.;
+    for (unsigned i = 0; i < 3; i++)
+        rgb[i] *= scale;
+
+    /* BT.2020 to BT.709 primaries */
+    double r =  1.6605 * rgb[0] - .5876 * rgb[1] - .0728 * rgb[2];
+    double g = -.1246 * rgb[0] + 1.1329 * rgb[1] - .0083 * rgb[2];
+    double b = -.0182 * rgb[0] - .1006 * rgb[1] + 1.1187 * rgb[2];
+
+    /* Out of gamut colours are desaturated towards their luminance */
+    double l = .2126 * r + .7152 * g + .0722 * b;
+    double lo = fmin(r, fmin(g, b));
+    if (lo < 0. && l > 0.)
+    {
+        double k = l / (l - lo);
+        r = l + k * (r - l);
+        g = l + k * (g - l);
+        b = l + k * (b - l);
+    }
+    r = pow(VLC_CLIP(r, 0., 1.), 1. / 2.4);
+    g = pow(VLC_CLIP(g, 0., 1.), 1. / 2.4);
+    b = pow(VLC_CLIP(b, 0., 1.), 1. / 2.4);
+
+    /* BT.709 limited range Y'CbCr */
+    double oy = .2126 * r + .7152 * g + .0722 * b;
+    *luma = to_code(oy, 16., 219.);
+    *chroma = (int32_t)((uint32_t)to_code((b - oy) / 1.8556, 128., 224.)
+                      | (uint32_t)to_code((r - oy) / 1.5748, 128., 224.) << 16);
+}
+
+/*****************************************************************************
+ * Tetrahedral interpolation
+ *****************************************************************************/
+/* The cube cell is split along its diagonal into 6 tetrahedra, selected by
+ * the order of the fractional parts. The SIMD kernels compute exactly the
+ * same vertices and weights: ties go to the first axis for the largest
+ * fraction, and to the last one for the smallest. */
+struct vertices
+{
+    unsigned index[4];
+    int weight[4];
+};
+
+static inline void find_vertices(struct vertices *vx,
+                                 unsigned y, unsigned u, unsigned v)
+{
+    const int fy = y & TONEMAP_LUT_MASK;
+    const int fu = u & TONEMAP_LUT_MASK;
+    const int fv = v & TONEMAP_LUT_MASK;
+    const unsigned base = (y >> TONEMAP_LUT_SHIFT) * STRIDE_Y
+                        + (u >> TONEMAP_LUT_SHIFT) * STRIDE_U
+                        + (v >> TONEMAP_LUT_SHIFT) * STRIDE_V;
+
+    unsigned off_uv = fv > fu ? STRIDE_V : STRIDE_U;
+    int max_uv = __MAX(fu, fv);
+    unsigned off_max = max_uv > fy ? off_uv : STRIDE_Y;
+    int max = __MAX(fy, max_uv);
+
+    unsigned off_yu = fu > fy ? STRIDE_Y : STRIDE_U;
+    int min_yu = __MIN(fy, fu);
+    unsigned off_min = fv > min_yu ? off_yu : STRIDE_V;
+    int min = __MIN(min_yu, fv);
+
+    int mid = fy + fu + fv - max - min;
+
+    vx->index[0] = base;
+    vx->index[1] = base + off_max;
+    vx->index[2] = base + STRIDE_Y + STRIDE_U + STRIDE_V - off_min;
+    vx->index[3] = base + STRIDE_Y + STRIDE_U + STRIDE_V;
+    vx->weight[0] = ONE - max;
+    vx->weight[1] = max - mid;
+    vx->weight[2] = mid - min;
+    vx->weight[3] = min;
+}
+
+static inline uint8_t interp_luma(const int32_t *lut, const struct vertices *vx)
+{
+    int32_t sum = ROUND;
+    for (unsigned i = 0; i < 4; i++)
+        sum += lut[vx->index[i]] * vx->weight[i];
+    return sum >> OUT_SHIFT;
+}
+
+static inline void interp_chroma(const int32_t *lut, const struct vertices *vx,
+                                 uint8_t *u, uint8_t *v)
+{
+    int32_t sum_u = ROUND, sum_v = ROUND;
+    for (unsigned i = 0; i < 4; i++)
+    {
+        uint32_t c = lut[vx->index[i]];
+        sum_u += (int32_t)(c & 0xffff) * vx->weight[i];
+        sum_v += (int32_t)(c >> 16) * vx->weight[i];
+    }
+    *u = sum_u >> OUT_SHIFT;
+    *v = sum_v >> OUT_SHIFT;
+}
+
+/*****************************************************************************
+ * C line kernels
+ *****************************************************************************/
+/* I420_10L samples are LSB aligned, P010 ones are MSB aligned */
+static inline unsigned sample(uint16_t value, bool semiplanar)
+{
+    return semiplanar ? value >> 6 : __MIN(value, 1023);
+}
+
+static inline void luma_pixels(const struct tonemap *t, uint8_t *dst,
+                               const uint16_t *y, const uint16_t *u,
+                               const uint16_t *v, unsigned x, unsigned width,
+                               bool semiplanar)
+{
+    for (; x < width; x++)
+    {
+        /* Nearest co-sited chroma sample */
+        unsigned c = x / 2;
+        unsigned cu = semiplanar ? u[2 * c] : u[c];
+        unsigned cv = semiplanar ? u[2 * c + 1] : v[c];
+        struct vertices vx;
+
+        find_vertices(&vx, sample(y[x], semiplanar),
+                      sample(cu, semiplanar), sample(cv, semiplanar));
+        dst[x] = interp_luma(t->luma, &vx);
+    }
+}
+
+static inline void chroma_pixels(const struct tonemap *t,
+                                 uint8_t *dst_u, uint8_t *dst_v,
+                                 const uint16_t *y0, const uint16_t *y1,
+                                 const uint16_t *u, const uint16_t *v,
+                                 unsigned c, unsigned width, bool semiplanar)
+{
+    for (; c < (width + 1) / 2; c++)
+    {
+        /* Average luma of the chroma sample footprint */
+        unsigned x0 = 2 * c, x1 = __MIN(2 * c + 1, width - 1);
+        unsigned sum = sample(y0[x0], semiplanar) + sample(y0[x1], semiplanar)
+                     + sample(y1[x0], semiplanar) + sample(y1[x1], semiplanar);
+        unsigned cu = semiplanar ? u[2 * c] : u[c];
+        unsigned cv = semiplanar ? u[2 * c + 1] : v[c];
+        struct vertices vx;
+
+        find_vertices(&vx, (sum + 2) >> 2,
+                      sample(cu, semiplanar), sample(cv, semiplanar));
+        interp_chroma(t->chroma, &vx, &dst_u[c], &dst_v[c]);
+    }
+}
+
+#define LINE_KERNELS(name, semiplanar) \
+static void luma_line_##name(const struct tonemap *t, uint8_t *dst, \
+                             const uint16_t *y, const uint16_t *u, \
+                             const uint16_t *v, unsigned width) \
+{ \
+    luma_pixels(t, dst, y, u, v, 0, width, semiplanar); \
+} \
+static void chroma_line_##name(const struct tonemap *t, uint8_t *dst_u, \
+                               uint8_t *dst_v, const uint16_t *y0, \
+                               const uint16_t *y1, const uint16_t *u, \
+                               const uint16_t *v, unsigned width) \
+{ \
+    chroma_pixels(t, dst_u, dst_v, y0, y1, u, v, 0, width, semiplanar); \
+}
+
+LINE_KERNELS(planar_c, false)
+LINE_KERNELS(semiplanar_c, true)
+
+/*****************************************************************************
+ * AVX2 line kernels
+ *****************************************************************************/
+#if defined(HAVE_AVX2_INTRINSICS)
+#define AVX2 __attribute__((__target__("avx2")))
+
+AVX2 static inline void find_vertices_avx2(__m256i y, __m256i u, __m256i v,
+                                           __m256i index[4], __m256i weight[4])
+{
+    const __m256i mask = _mm256_set1_epi32(TONEMAP_LUT_MASK);
+    const __m256i sy = _mm256_set1_epi32(STRIDE_Y);
+    const __m256i su = _mm256_set1_epi32(STRIDE_U);
+    const __m256i sv = _mm256_set1_epi32(STRIDE_V);
+    const __m256i fy = _mm256_and_si256(y, mask);
+    const __m256i fu = _mm256_and_si256(u, mask);
+    const __m256i fv = _mm256_and_si256(v, mask);
+
+    /* ((y * 33) + u) * 33 + v, with shifts */
+    __m256i base = _mm256_srli_epi32(y, TONEMAP_LUT_SHIFT);
+    base = _mm256_add_epi32(_mm256_add_epi32(_mm256_slli_epi32(base, 5), base),
+                            _mm256_srli_epi32(u, TONEMAP_LUT_SHIFT));
+    base = _mm256_add_epi32(_mm256_add_epi32(_mm256_slli_epi32(base, 5), base),
+                            _mm256_srli_epi32(v, TONEMAP_LUT_SHIFT));
+
+    __m256i off_uv = _mm256_blendv_epi8(su, sv, _mm256_cmpgt_epi32(fv, fu));
+    __m256i max_uv = _mm256_max_epi32(fu, fv);
+    __m256i off_max = _mm256_blendv_epi8(sy, off_uv,
+                                         _mm256_cmpgt_epi32(max_uv, fy));
+    __m256i max = _mm256_max_epi32(fy, max_uv);
+
+    __m256i off_yu = _mm256_blendv_epi8(su, sy, _mm256_cmpgt_epi32(fu, fy));
+    __m256i min_yu = _mm256_min_epi32(fy, fu);
+    __m256i off_min = _mm256_blendv_epi8(sv, off_yu,
+                                         _mm256_cmpgt_epi32(fv, min_yu));
+    __m256i min = _mm256_min_epi32(min_yu, fv);
+
+    __m256i mid = _mm256_sub_epi32(_mm256_add_epi32(_mm256_add_epi32(fy, fu), fv),
+                                   _mm256_add_epi32(max, min));
+
+    index[0] = base;
+    index[1] = _mm256_add_epi32(base, off_max);
+    index[3] = _mm256_add_epi32(base,
+                    _mm256_set1_epi32(STRIDE_Y + STRIDE_U + STRIDE_V));
+    index[2] = _mm256_sub_epi32(index[3], off_min);
+    weight[0] = _mm256_sub_epi32(_mm256_set1_epi32(ONE), max);
+    weight[1] = _mm256_sub_epi32(max, mid);
+    weight[2] = _mm256_sub_epi32(mid, min);
+    weight[3] = min;
+}
+
+/* Sums the vertices weighted by the low (shift 0) or high (shift 16) 16-bit
+ * halves of the weights. Table values and weights fit in signed 16 bits. */
+AVX2 static inline __m256i interp_avx2(const int32_t *lut,
+                                       const __m256i index[4],
+                                       const __m256i weight[4], int shift)
+{
+    __m256i sum = _mm256_set1_epi32(ROUND);
+    for (unsigned i = 0; i < 4; i++)
+    {
+        __m256i c = _mm256_i32gather_epi32((const int *)lut, index[i], 4);
+        __m256i w = shift ? _mm256_slli_epi32(weight[i], 16) : weight[i];
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(c, w));
+    }
+    return _mm256_srli_epi32(sum, OUT_SHIFT);
+}
+
+/* Stores 8 32-bit values in [0, 255] as bytes */
+AVX2 static inline void store8_avx2(uint8_t *dst, __m256i v)
+{
+    v = _mm256_packus_epi32(v, v);
+    v = _mm256_packus_epi16(v, v);
+    v = _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0));
+    _mm_storel_epi64((__m128i *)dst, _mm256_castsi256_si128(v));
+}
+
+AVX2 static inline __m256i load8_avx2(const uint16_t *p, bool semiplanar)
+{
+    __m256i v = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)p));
+    return semiplanar ? _mm256_srli_epi32(v, 6)
+                      : _mm256_min_epi32(v, _mm256_set1_epi32(1023));
+}
+
+AVX2 static inline void luma_line_avx2(const struct tonemap *t, uint8_t *dst,
+                                       const uint16_t *y, const uint16_t *u,
+                                       const uint16_t *v, unsigned width,
+                                       bool semiplanar)
+{
+    const __m256i dup_lo = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+    const __m256i dup_even = _mm256_setr_epi32(0, 0, 2, 2, 4, 4, 6, 6);
+    const __m256i dup_odd = _mm256_setr_epi32(1, 1, 3, 3, 5, 5, 7, 7);
+    unsigned x = 0;
+
+    for (; x + 8 <= width; x += 8)
+    {
+        __m256i vy = load8_avx2(&y[x], semiplanar);
+        __m256i vu, vv;
+
+        if (semiplanar)
+        {
+            /* 4 interleaved pairs */
+            __m256i uv = load8_avx2(&u[x], true);
+            vu = _mm256_permutevar8x32_epi32(uv, dup_even);
+            vv = _mm256_permutevar8x32_epi32(uv, dup_odd);
+        }
+        else
+        {
+            const __m256i max = _mm256_set1_epi32(1023);
+            vu = _mm256_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)&u[x / 2]));
+            vv = _mm256_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)&v[x / 2]));
+            vu = _mm256_permutevar8x32_epi32(_mm256_min_epi32(vu, max), dup_lo);
+            vv = _mm256_permutevar8x32_epi32(_mm256_min_epi32(vv, max), dup_lo);
+        }
+
+        __m256i index[4], weight[4];
+        find_vertices_avx2(vy, vu, vv, index, weight);
+        store8_avx2(&dst[x], interp_avx2(t->luma, index, weight, 0));
+    }
+    luma_pixels(t, dst, y, u, v, x, width, semiplanar);
+}
+
+AVX2 static inline void chroma_line_avx2(const struct tonemap *t,
+                                         uint8_t *dst_u, uint8_t *dst_v,
+                                         const uint16_t *y0, const uint16_t *y1,
+                                         const uint16_t *u, const uint16_t *v,
+                                         unsigned width, bool semiplanar)
+{
+    const __m256i one = _mm256_set1_epi16(1);
+    unsigned c = 0;
+
+    for (; 2 * c + 16 <= width; c += 8)
+    {
+        __m256i r0 = _mm256_loadu_si256((const __m256i *)&y0[2 * c]);
+        __m256i r1 = _mm256_loadu_si256((const __m256i *)&y1[2 * c]);
+        if (semiplanar)
+        {
+            r0 = _mm256_srli_epi16(r0, 6);
+            r1 = _mm256_srli_epi16(r1, 6);
+        }
+        else
+        {
+            const __m256i max = _mm256_set1_epi16(1023);
+            r0 = _mm256_min_epu16(r0, max);
+            r1 = _mm256_min_epu16(r1, max);
+        }
+        /* Horizontal pairs of the vertical sums */
+        __m256i vy = _mm256_madd_epi16(_mm256_add_epi16(r0, r1), one);
+        vy = _mm256_srli_epi32(_mm256_add_epi32(vy, _mm256_set1_epi32(2)), 2);
+
+        __m256i vu, vv;
+        if (semiplanar)
+        {
+            __m256i uv = _mm256_loadu_si256((const __m256i *)&u[2 * c]);
+            vu = _mm256_srli_epi32(_mm256_and_si256(uv, _mm256_set1_epi32(0xffff)), 6);
+            vv = _mm256_srli_epi32(uv, 16 + 6);
+        }
+        else
+        {
+            vu = load8_avx2(&u[c], false);
+            vv = load8_avx2(&v[c], false);
+        }
+
+        __m256i index[4], weight[4];
+        find_vertices_avx2(vy, vu, vv, index, weight);
+        store8_avx2(&dst_u[c], interp_avx2(t->chroma, index, weight, 0));
+        store8_avx2(&dst_v[c], interp_avx2(t->chroma, index, weight, 16));
+    }
+    chroma_pixels(t, dst_u, dst_v, y0, y1, u, v, c, width, semiplanar);
+}
+
+#define LINE_KERNELS_AVX2(name, semiplanar) \
+AVX2 static void luma_line_##name(const struct tonemap *t, uint8_t *dst, \
+                                  const uint16_t *y, const uint16_t *u, \
+                                  const uint16_t *v, unsigned width) \
+{ \
+    luma_line_avx2(t, dst, y, u, v, width, semiplanar); \
+} \
+AVX2 static void chroma_line_##name(const struct tonemap *t, uint8_t *dst_u, \
+                                    uint8_t *dst_v, const uint16_t *y0, \
+                                    const uint16_t *y1, const uint16_t *u, \
+                                    const uint16_t *v, unsigned width) \
+{ \
+    chroma_line_avx2(t, dst_u, dst_v, y0, y1, u, v, width, semiplanar); \
+}
+
+LINE_KERNELS_AVX2(planar_avx2, false)
+LINE_KERNELS_AVX2(semiplanar_avx2, true)
+
+#undef AVX2
+#endif
+
+/*****************************************************************************
+ * API
+ *****************************************************************************/
+int tonemap_Init(struct tonemap *t, const struct tonemap_params *p, bool simd)
+{
+    t->luma = vlc_alloc(TONEMAP_LUT_SIZE, sizeof(*t->luma));
+    t->chroma = vlc_alloc(TONEMAP_LUT_SIZE, sizeof(*t->chroma));
+    if (!t->luma || !t->chroma)
+    {
+        tonemap_Clean(t);
+        return VLC_ENOMEM;
+    }
+
+    unsigned i = 0;
+    for (unsigned y = 0; y < TONEMAP_LUT_POINTS; y++)
+        for (unsigned u = 0; u < TONEMAP_LUT_POINTS; u++)
+            for (unsigned v = 0; v < TONEMAP_LUT_POINTS; v++, i++)
+                compute_node(p, y, u, v, &t->luma[i], &t->chroma[i]);
+
+    t->semiplanar = p->semiplanar;
+    if (p->semiplanar)
+    {
+        t->luma_line = luma_line_semiplanar_c;
+        t->chroma_line = chroma_line_semiplanar_c;
+    }
+    else
+    {
+        t->luma_line = luma_line_planar_c;
+        t->chroma_line = chroma_line_planar_c;
+    }
+#if defined(HAVE_AVX2_INTRINSICS)
+    if (simd && vlc_CPU_AVX2())
+    {
+        if (p->semiplanar)
+        {
+            t->luma_line = luma_line_semiplanar_avx2;
+            t->chroma_line = chroma_line_semiplanar_avx2;
+        }
+        else
+        {
+            t->luma_line = luma_line_planar_avx2;
+            t->chroma_line = chroma_line_planar_avx2;
+        }
+    }
+#else
+    VLC_UNUSED(simd);
+#endif
+    return VLC_SUCCESS;
+}
+
+void tonemap_Clean(struct tonemap *t)
+{
+    free(t->luma);
+    free(t->chroma);
+    t->luma = t->chroma = NULL;
+}
+
+static const uint16_t *row16(const plane_t *p, unsigned row)
+{
+    return (const uint16_t *)&p->p_pixels[row * p->i_pitch];
+}
+
+void tonemap_Slice(const struct tonemap *t, picture_t *dst,
+                   const picture_t *src, unsigned first, unsigned last)
+{
+    const plane_t *sy = &src->p[0], *su = &src->p[1];
+    const plane_t *sv = t->semiplanar ? NULL : &src->p[2];
+    plane_t *dy = &dst->p[0], *du = &dst->p[1], *dv = &dst->p[2];
+    const unsigned width = __MIN(sy->i_visible_pitch / 2,
+                                 dy->i_visible_pitch);
+    const unsigned height = sy->i_visible_lines;
+
+    for (unsigned row = first; row < last; row++)
+        t->luma_line(t, &dy->p_pixels[row * dy->i_pitch], row16(sy, row),
+                     row16(su, row / 2), sv ? row16(sv, row / 2) : NULL,
+                     width);
+
+    for (unsigned row = first / 2; row < (last + 1) / 2; row++)
+        t->chroma_line(t, &du->p_pixels[row * du->i_pitch],
+                       &dv->p_pixels[row * dv->i_pitch],
+                       row16(sy, 2 * row),
+                       row16(sy, __MIN(2 * row + 1, height - 1)),
+                       row16(su, row), sv ? row16(sv, row) : NULL, width);
+}
@@ -110,9 +110,10 @@ int kdvd_8k_renderer_configure(kdvd_8k_renderer_t *renderer, const kdvd_8k_rende
     // Copy configuration
     memcpy(&renderer->config, config, sizeof(kdvd_8k_render_config_t));
     
-    // Validate 8K configuration
-    if (config->width != 7680 || config->height != 4320) {
-        msg_Err(renderer->obj, "Invalid 8K resolution: %ux%u (expected 7680x4320)", 
+    // Pictures may be downscaled on decode, to any size up to 8K
+    if (config->width == 0 || config->height == 0 ||
+        config->width > 7680 || config->height > 4320) {
+        msg_Err(renderer->obj, "Invalid resolution: %ux%u (expected up to 7680x4320)", 
                 config->width, config->height);
         return -1;
     }
@@ -387,14 +388,14 @@ int kdvd_8k_renderer_enable_8k_rendering(kdvd_8k_renderer_t *renderer, bool enab
     if (!renderer) return -1;
     
     if (enable) {
-        renderer->config.width = 7680;
-        renderer->config.height = 4320;
+        // Keep the configured size, pictures may be downscaled on decode
         renderer->config.bit_depth = 10;
         renderer->config.frame_rate = 60;
         renderer->config.hdr_enabled = true;
         renderer->config.color_space = 1;  // BT.2020
         renderer->config.color_range = 1;  // Full range
-        msg_Info(renderer->obj, "8K rendering enabled: 7680x4320 10-bit HDR 60 FPS");
+        msg_Info(renderer->obj, "8K rendering enabled: %ux%u 10-bit HDR 60 FPS",
+                 renderer->config.width, renderer->config.height);
     } else {
         renderer->config.width = 1920;
         renderer->config.height = 1080;
@@ -435,9 +436,7 @@ int kdvd_8k_renderer_optimize_for_8k(kdvd_8k_renderer_t *renderer) {
     renderer->hardware_acceleration = true;
     renderer->config.hardware_acceleration = true;
     
-    // Set optimal settings for 8K
-    renderer->config.width = 7680;
-    renderer->config.height = 4320;
+    // Set optimal settings for 8K, at the configured size
     renderer->config.bit_depth = 10;
     renderer->config.frame_rate = 60;
     renderer->config.hdr_enabled = true;
@@ -10,6 +10,8 @@
 // 8KDVD Video Output Module for VLC
 typedef struct vout_sys_t {
     kdvd_8k_renderer_t *renderer;
+    unsigned display_width;
+    unsigned display_height;
     bool initialized;
     bool debug_enabled;
 } vout_sys_t;
@@ -42,10 +44,12 @@ static int Open(vlc_object_t *obj) {
     
     msg_Info(vout, "8KDVD video output module opening");
     
-    // Check if this is an 8K video output
-    if (vout->fmt.video.i_width != 7680 || vout->fmt.video.i_height != 4320) {
-        msg_Err(vout, "Not an 8K video output: %ux%u (expected 7680x4320)", 
-               vout->fmt.video.i_width, vout->fmt.video.i_height);
+    // 8K video, possibly downscaled on decode to any size
+    unsigned width = vout->fmt.video.i_width;
+    unsigned height = vout->fmt.video.i_height;
+    if (width == 0 || height == 0 || width > 7680 || height > 4320) {
+        msg_Err(vout, "Not an 8K video output: %ux%u (expected up to 7680x4320)", 
+               width, height);
         free(sys);
         return VLC_EGENERIC;
     }
@@ -93,8 +97,8 @@ static int Open(vlc_object_t *obj) {
     vout->pf_control = Control;
     
     // Set up video format
-    vout->fmt.video.i_width = 7680;
-    vout->fmt.video.i_height = 4320;
+    vout->fmt.video.i_width = width;
+    vout->fmt.video.i_height = height;
     vout->fmt.video.i_bits_per_pixel = 10;
     vout->fmt.video.i_frame_rate = 60;
     vout->fmt.video.i_frame_rate_base = 1;
@@ -105,6 +109,10 @@ static int Open(vlc_object_t *obj) {
     sys->initialized = true;
     sys->debug_enabled = false;
     
+    // Display size for the 8KDVD decoder downscale-on-decode, set on
+    // VOUT_DISPLAY_CHANGE_DISPLAY_SIZE and followed through its callback
+    var_Create(vlc_object_instance(vout), "8kdvd-display-size", VLC_VAR_COORDS);
+    
     msg_Info(vout, "8KDVD video output module opened successfully");
     return VLC_SUCCESS;
 }
@@ -117,6 +125,8 @@ static void Close(vlc_object_t *obj) {
     
     msg_Info(vout, "8KDVD video output module closing");
     
+    var_Destroy(vlc_object_instance(vout), "8kdvd-display-size");
+    
     if (sys->renderer) {
         kdvd_8k_renderer_destroy(sys->renderer);
     }
@@ -178,6 +188,14 @@ static int Control(vout_display_t *vout, int query, va_list args) {
             unsigned width = va_arg(args, unsigned);
             unsigned height = va_arg(args, unsigned);
             msg_Info(vout, "8KDVD display size changed: %ux%u", width, height);
+            
+            // Let the 8KDVD decoder pick its downscale-on-decode factor
+            if (width != sys->display_width || height != sys->display_height) {
+                sys->display_width = width;
+                sys->display_height = height;
+                var_SetCoords(vlc_object_instance(vout), "8kdvd-display-size",
+                              width, height);
+            }
             return VLC_SUCCESS;
         }
         
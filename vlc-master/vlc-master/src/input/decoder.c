@@ -205,6 +205,11 @@ struct vlc_input_decoder_t
 
     bool error;
 
+    /* How late the last queued picture was, cf. decoder_GetLateness(),
+     * only measured once the module asked for it */
+    _Atomic vlc_tick_t late_delay;
+    atomic_bool late_wanted;
+
     /* Waiting */
     bool b_waiting;
     bool b_first;
@@ -973,6 +978,14 @@ static vlc_tick_t ModuleThread_GetDisplayDate( decoder_t *p_dec,
     return conv_ts;
 }
 
+static vlc_tick_t ModuleThread_GetLateness( decoder_t *p_dec )
+{
+    vlc_input_decoder_t *p_owner = dec_get_owner( p_dec );
+
+    atomic_store_explicit( &p_owner->late_wanted, true, memory_order_relaxed );
+    return atomic_load_explicit( &p_owner->late_delay, memory_order_relaxed );
+}
+
 static float ModuleThread_GetDisplayRate( decoder_t *p_dec )
 {
     vlc_input_decoder_t *p_owner = dec_get_owner( p_dec );
@@ -1396,6 +1409,21 @@ static void ModuleThread_QueueVideo( decoder_t *p_dec, picture_t *p_pic )
                             "OUT", p_pic->date );
     }
 
+    /* Share how late this picture is with the decoder module so that it can
+     * skip the next frames before decoding them, cf. decoder_GetLateness().
+     * Converting the date locks the clock: skip it for the other modules. */
+    if( atomic_load_explicit( &p_owner->late_wanted, memory_order_relaxed ) )
+    {
+        vlc_tick_t now = vlc_tick_now();
+        vlc_tick_t display_date =
+            ModuleThread_GetDisplayDate( p_dec, now, p_pic->date );
+        vlc_tick_t late_delay = 0;
+        if( display_date != VLC_TICK_INVALID && display_date < now )
+            late_delay = now - display_date;
+        atomic_store_explicit( &p_owner->late_delay, late_delay,
+                               memory_order_relaxed );
+    }
+
     vlc_fifo_Lock( p_owner->p_fifo );
 
     int success = ModuleThread_PlayVideo( p_owner, p_pic );
@@ -1758,6 +1786,8 @@ static void DecoderThread_Flush( vlc_input_decoder_t *p_owner )
     if( p_owner->error )
         return;
 
+    atomic_store_explicit( &p_owner->late_delay, 0, memory_order_relaxed );
+
     if( p_packetizer != NULL && p_packetizer->pf_flush != NULL )
         p_packetizer->pf_flush( p_packetizer );
 
@@ -1887,6 +1917,7 @@ static const struct decoder_owner_callbacks dec_video_cbs =
         .queue_cc = ModuleThread_QueueCc,
         .get_display_date = ModuleThread_GetDisplayDate,
         .get_display_rate = ModuleThread_GetDisplayRate,
+        .get_lateness = ModuleThread_GetLateness,
     },
     .get_attachments = InputThread_GetInputAttachments,
 };
@@ -1972,6 +2003,8 @@ CreateDecoder( vlc_object_t *p_parent, const struct vlc_input_decoder_cfg *cfg )
     p_owner->out_started = false;
 
     p_owner->error = false;
+    atomic_init( &p_owner->late_delay, 0 );
+    atomic_init( &p_owner->late_wanted, false );
 
     p_owner->flushing = false;
     p_owner->b_draining = false;
@@ -4044,6 +4044,9 @@ static int EsOutVaPrivControlLocked(es_out_sys_t *p_sys, input_source_t *source,
         }
         return ret;
     }
+    case ES_OUT_PRIV_SET_TIMESHIFT_TIME:
+        /* Handled by the timeshift es_out */
+        return VLC_EGENERIC;
     default: vlc_assert_unreachable();
     }
 
@@ -101,7 +101,10 @@ enum es_out_query_private_e
     ES_OUT_PRIV_SET_VBI_PAGE,                       /* arg1=unsigned res=can fail */
 
     /* Set VBI/Teletext menu transparent */
-    ES_OUT_PRIV_SET_VBI_TRANSPARENCY                /* arg1=bool res=can fail */
+    ES_OUT_PRIV_SET_VBI_TRANSPARENCY,               /* arg1=bool res=can fail */
+
+    /* Skip the timeshift buffer up to a time still buffered */
+    ES_OUT_PRIV_SET_TIMESHIFT_TIME                  /* arg1=vlc_tick_t i_time res=can fail */
 };
 
 struct vlc_input_es_out;
@@ -319,6 +322,12 @@ es_out_SetVbiTransparency(struct vlc_input_es_out *out, vlc_es_id_t *id,
                               enabled);
 }
 
+static inline int
+es_out_SetTimeshiftTime(struct vlc_input_es_out *out, vlc_tick_t i_time)
+{
+    return es_out_PrivControl(out, ES_OUT_PRIV_SET_TIMESHIFT_TIME, i_time);
+}
+
 struct vlc_input_es_out *
 input_EsOutNew(input_thread_t *, input_source_t *main_source, float rate,
                enum input_type input_type);
@@ -36,6 +36,11 @@
 #endif
 #include <sys/stat.h>
 #include <unistd.h>
+#include <fcntl.h>
+#if defined(HAVE_MMAP) && defined(HAVE_POSIX_FALLOCATE)
+#  include <sys/mman.h>
+#  define TS_STORAGE_MMAP 1
+#endif
 
 #include <vlc_common.h>
 #include <vlc_arrays.h>
@@ -191,6 +196,24 @@ static_assert(offsetof(ts_cmd_t, header) == offsetof(ts_cmd_send_t, header), "in
 static_assert(offsetof(ts_cmd_t, header) == offsetof(ts_cmd_control_t, header), "invalid packing");
 static_assert(offsetof(ts_cmd_t, header) == offsetof(ts_cmd_privcontrol_t, header), "invalid packing");
 
+/* Stored in the data file in front of each block payload */
+typedef struct
+{
+    vlc_tick_t i_dts;
+    vlc_tick_t i_pts;
+    vlc_tick_t i_length;
+    uint32_t   i_flags;
+    unsigned   i_nb_samples;
+    size_t     i_buffer;
+} ts_block_header_t;
+
+/* Time index entry, added for each ES_OUT_PRIV_SET_TIMES command */
+typedef struct
+{
+    vlc_tick_t i_time;  /* input time */
+    size_t     i_cmd;   /* offset of the command in the command buffer */
+} ts_index_entry_t;
+
 typedef struct ts_storage_t ts_storage_t;
 struct ts_storage_t
 {
@@ -202,14 +225,25 @@ struct ts_storage_t
 #endif
     size_t  i_file_max; /* Max size in bytes */
     int64_t i_file_size;/* Current size in bytes */
+#ifdef TS_STORAGE_MMAP
+    int     fd;
+    uint8_t *p_map;     /* The whole preallocated file */
+#else
     FILE    *p_filew;   /* FILE handle for data writing */
     FILE    *p_filer;   /* FILE handle for data reading */
+#endif
 
     /* */
     uint8_t *p_cmd_r;
     uint8_t *p_cmd_w;
     uint8_t *p_cmd_buf;
     size_t   i_cmd_buf;
+
+    /* Sorted by command offset, and by time as long as the input time
+     * increases */
+    ts_index_entry_t *p_index;
+    size_t           i_index;
+    size_t           i_index_max;
 };
 
 typedef struct
@@ -243,9 +277,13 @@ typedef struct
     /* */
     ts_storage_t   *p_storage_r;
     ts_storage_t   *p_storage_w;
+    ts_storage_t   *p_storage_spare; /* Consumed storage, to be reused */
 
     vlc_tick_t     i_cmd_delay;
 
+    /* Requested input time, handled by the timeshift thread */
+    vlc_tick_t     i_seek_time;
+
 } ts_thread_t;
 
 struct es_out_id_t
@@ -294,6 +332,7 @@ static bool         TsHasCmd( ts_thread_t * );
 static bool         TsIsUnused( ts_thread_t * );
 static int          TsChangePause( ts_thread_t *, bool b_source_paused, bool b_paused, vlc_tick_t i_date );
 static int          TsChangeRate( ts_thread_t *, float src_rate, float rate );
+static int          TsSeek( ts_thread_t *, vlc_tick_t i_time );
 
 static void         *TsRun( void * );
 
@@ -304,8 +343,12 @@ static bool         TsStorageIsFull( ts_storage_t *, const ts_cmd_t *p_cmd );
 static bool         TsStorageIsEmpty( ts_storage_t * );
 static void         TsStoragePushCmd( ts_storage_t *, const ts_cmd_t *p_cmd, bool b_flush );
 static void         TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush );
+static bool         TsStorageReset( ts_storage_t * );
+static int          TsStorageFind( ts_storage_t *, vlc_tick_t i_time,
+                                   ts_storage_t **pp_storage, size_t *pi_cmd );
 
 static void CmdClean( ts_cmd_t * );
+static bool CmdIsTimed( const ts_cmd_t * );
 
 static int  CmdInitAdd    ( ts_cmd_add_t *, input_source_t *, es_out_id_t *, const es_format_t *, bool b_copy );
 static void CmdInitSend   ( ts_cmd_send_t *, es_out_id_t *, block_t * );
@@ -800,6 +843,14 @@ static int PrivControlLocked(struct vlc_input_es_out *p_tsout,
     }
     case ES_OUT_PRIV_GET_GROUP_FORCED:
         return es_out_in_vaPrivControl( p_sys->p_out, in, i_query, args );
+    case ES_OUT_PRIV_SET_TIMESHIFT_TIME:
+    {
+        const vlc_tick_t i_time = va_arg( args, vlc_tick_t );
+
+        if( !p_sys->b_delayed )
+            return VLC_EGENERIC;
+        return TsSeek( p_sys->p_ts, i_time );
+    }
     /* Invalid queries for this es_out level */
     case ES_OUT_PRIV_SET_ES:
     case ES_OUT_PRIV_UNSET_ES:
@@ -979,8 +1030,10 @@ static int TsStart(struct es_out_timeshift *p_sys)
     p_ts->i_rate_delay = 0;
     p_ts->i_buffering_delay = 0;
     p_ts->i_cmd_delay = 0;
+    p_ts->i_seek_time = VLC_TICK_INVALID;
     p_ts->p_storage_r = NULL;
     p_ts->p_storage_w = NULL;
+    p_ts->p_storage_spare = NULL;
 
     p_sys->b_delayed = true;
     if( vlc_clone( &p_ts->thread, TsRun, p_ts ) )
@@ -1028,6 +1081,8 @@ static void TsStop( ts_thread_t *p_ts )
     assert( !p_ts->p_storage_r || !p_ts->p_storage_r->p_next );
     if( p_ts->p_storage_r )
         TsStorageDelete( p_ts->p_storage_r );
+    if( p_ts->p_storage_spare )
+        TsStorageDelete( p_ts->p_storage_spare );
     vlc_mutex_unlock( &p_ts->lock );
 
     TsDestroy( p_ts );
@@ -1038,13 +1093,37 @@ static void TsPushCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
 
     if( !p_ts->p_storage_w || TsStorageIsFull( p_ts->p_storage_w, p_cmd ) )
     {
-        ts_storage_t *p_storage = TsStorageNew( p_ts->psz_tmp_path, p_ts->i_tmp_size_max );
+        /* A block larger than the granularity gets a segment of its own */
+        int64_t i_size_max = p_ts->i_tmp_size_max;
+        if( p_cmd->header.i_type == C_SEND )
+        {
+            const int64_t i_size = sizeof(ts_block_header_t) +
+                                   p_cmd->send.p_block->i_buffer;
+            if( i_size > i_size_max )
+            {
+                msg_Dbg( p_ts->p_input, "es out timeshift: %"PRId64" bytes "
+                         "block in a dedicated segment", i_size );
+                i_size_max = i_size;
+            }
+        }
+
+        /* Reuse the last consumed storage, its file is already allocated */
+        ts_storage_t *p_storage = NULL;
+        if( p_ts->p_storage_spare &&
+            p_ts->p_storage_spare->i_file_max >= (size_t)i_size_max )
+        {
+            p_storage = p_ts->p_storage_spare;
+            p_ts->p_storage_spare = NULL;
+        }
+        if( !p_storage )
+            p_storage = TsStorageNew( p_ts->psz_tmp_path, i_size_max );
 
         if( !p_storage )
         {
+            msg_Warn( p_ts->p_input, "es out timeshift: cannot create a "
+                      "%"PRId64" bytes segment, dropping data", i_size_max );
             CmdClean( p_cmd );
             vlc_mutex_unlock( &p_ts->lock );
-            /* TODO warn the user (but only once) */
             return;
         }
 
@@ -1082,7 +1161,13 @@ static int TsPopCmdLocked( ts_thread_t *p_ts, ts_cmd_t *p_cmd, bool b_flush )
         if( !p_next )
             break;
 
-        TsStorageDelete( p_ts->p_storage_r );
+        /* Dedicated segments are not worth keeping */
+        if( !p_ts->p_storage_spare &&
+            p_ts->p_storage_r->i_file_max == (size_t)p_ts->i_tmp_size_max &&
+            TsStorageReset( p_ts->p_storage_r ) )
+            p_ts->p_storage_spare = p_ts->p_storage_r;
+        else
+            TsStorageDelete( p_ts->p_storage_r );
         p_ts->p_storage_r = p_next;
     }
 
@@ -1160,6 +1245,113 @@ static int TsChangeRate( ts_thread_t *p_ts, float src_rate, float rate )
     return i_ret;
 }
 
+static int TsSeek( ts_thread_t *p_ts, vlc_tick_t i_time )
+{
+    ts_storage_t *p_storage;
+    size_t i_cmd;
+
+    vlc_mutex_lock( &p_ts->lock );
+
+    /* Only check that the time is buffered, the timeshift thread skips the
+     * commands */
+    int i_ret = TsStorageFind( p_ts->p_storage_r, i_time, &p_storage, &i_cmd );
+    if( !i_ret )
+    {
+        p_ts->i_seek_time = i_time;
+        vlc_cond_signal( &p_ts->wait );
+    }
+
+    vlc_mutex_unlock( &p_ts->lock );
+    return i_ret;
+}
+
+static void TsExecuteCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
+{
+    switch( p_cmd->header.i_type )
+    {
+    case C_ADD:
+        CmdExecuteAdd(p_ts->ts, &p_cmd->add);
+        CmdCleanAdd( &p_cmd->add );
+        break;
+    case C_SEND:
+        CmdExecuteSend(p_ts->ts, &p_cmd->send );
+        CmdCleanSend( &p_cmd->send );
+        break;
+    case C_CONTROL:
+        CmdExecuteControl(p_ts->ts, &p_cmd->control);
+        CmdCleanControl( &p_cmd->control );
+        break;
+    case C_PRIVCONTROL:
+        CmdExecutePrivControl(p_ts->ts, &p_cmd->privcontrol);
+        CmdCleanPrivControl( &p_cmd->privcontrol );
+        break;
+    case C_DEL:
+        CmdExecuteDel(p_ts->ts, &p_cmd->del);
+        break;
+    default:
+        vlc_assert_unreachable();
+        break;
+    }
+}
+
+/* Skip the commands up to the requested time: the data and the timing
+ * commands are dropped, the other ones still change the output state */
+static void TsSkipLocked( ts_thread_t *p_ts )
+{
+    const vlc_tick_t i_time = p_ts->i_seek_time;
+    ts_storage_t *p_target;
+    size_t i_target;
+
+    p_ts->i_seek_time = VLC_TICK_INVALID;
+
+    /* The buffer may have been played up to the time meanwhile */
+    if( TsStorageFind( p_ts->p_storage_r, i_time, &p_target, &i_target ) )
+        return;
+
+    msg_Dbg( p_ts->p_input, "es out timeshift: skipping to %"PRId64" ms",
+             MS_FROM_VLC_TICK(i_time) );
+
+    while( p_ts->p_storage_r != p_target
+        || (size_t)(p_target->p_cmd_r - p_target->p_cmd_buf) < i_target )
+    {
+        ts_cmd_t cmd;
+
+        if( TsPopCmdLocked( p_ts, &cmd, true ) )
+            break;
+
+        if( CmdIsTimed( &cmd ) )
+        {
+            CmdClean( &cmd );
+            continue;
+        }
+
+        vlc_mutex_unlock( &p_ts->lock );
+        TsExecuteCmd( p_ts, &cmd );
+        vlc_mutex_lock( &p_ts->lock );
+    }
+
+    vlc_mutex_unlock( &p_ts->lock );
+    es_out_Control( &p_ts->p_out->out, ES_OUT_RESET_PCR );
+    vlc_mutex_lock( &p_ts->lock );
+
+    /* Execute the next command now */
+    const vlc_tick_t i_now = vlc_tick_now();
+    vlc_tick_t i_date = i_now;
+    if( !TsStorageIsEmpty( p_ts->p_storage_r ) )
+    {
+        ts_cmd_header_t header;
+        memcpy( &header, p_ts->p_storage_r->p_cmd_r, sizeof(header) );
+        i_date = header.i_date;
+    }
+
+    p_ts->i_cmd_delay = i_now - i_date;
+    p_ts->i_rate_date = -1;
+    p_ts->i_rate_delay = 0;
+    p_ts->i_buffering_delay = 0;
+    if( p_ts->b_paused )
+        p_ts->i_pause_date = i_now;
+}
+
 static void *TsRun( void *p_data )
 {
     vlc_thread_set_name("vlc-timeshift");
@@ -1173,6 +1365,13 @@ static void *TsRun( void *p_data )
         ts_cmd_t cmd;
         vlc_tick_t  i_deadline;
 
+        if( p_ts->i_seek_time != VLC_TICK_INVALID )
+        {
+            TsSkipLocked( p_ts );
+            i_buffering_date = -1;
+            continue;
+        }
+
         /* Pop a command to execute */
         bool b_buffering = es_out_GetBuffering( p_ts->p_out );
 
@@ -1239,31 +1438,7 @@ static void *TsRun( void *p_data )
         }
 
         /* Execute the command  */
-        switch( cmd.header.i_type )
-        {
-        case C_ADD:
-            CmdExecuteAdd(p_ts->ts, &cmd.add);
-            CmdCleanAdd( &cmd.add );
-            break;
-        case C_SEND:
-            CmdExecuteSend(p_ts->ts, &cmd.send );
-            CmdCleanSend( &cmd.send );
-            break;
-        case C_CONTROL:
-            CmdExecuteControl(p_ts->ts, &cmd.control);
-            CmdCleanControl( &cmd.control );
-            break;
-        case C_PRIVCONTROL:
-            CmdExecutePrivControl(p_ts->ts, &cmd.privcontrol);
-            CmdCleanPrivControl( &cmd.privcontrol );
-            break;
-        case C_DEL:
-            CmdExecuteDel(p_ts->ts, &cmd.del);
-            break;
-        default:
-            vlc_assert_unreachable();
-            break;
-        }
+        TsExecuteCmd( p_ts, &cmd );
         vlc_mutex_lock( &p_ts->lock );
     }
     vlc_mutex_unlock( &p_ts->lock );
@@ -1299,6 +1474,30 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
         return NULL;
     }
 
+#ifdef TS_STORAGE_MMAP
+    /* The whole segment is allocated and mapped once, the data are then
+     * copied without any system call and the kernel writes them back */
+    vlc_unlink( psz_file );
+    free( psz_file );
+
+    if( posix_fallocate( fd, 0, i_tmp_size_max ) )
+    {
+        vlc_close( fd );
+        free( p_storage );
+        return NULL;
+    }
+
+    p_storage->p_map = mmap( NULL, i_tmp_size_max, PROT_READ|PROT_WRITE,
+                             MAP_SHARED, fd, 0 );
+    if( p_storage->p_map == MAP_FAILED )
+    {
+        vlc_close( fd );
+        free( p_storage );
+        return NULL;
+    }
+    posix_madvise( p_storage->p_map, i_tmp_size_max, POSIX_MADV_SEQUENTIAL );
+    p_storage->fd = fd;
+#else
     p_storage->p_filew = fdopen( fd, "w+b" );
     if( p_storage->p_filew == NULL )
     {
@@ -1320,6 +1519,7 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
     free( psz_file );
 #else
     p_storage->psz_file = psz_file;
+#endif
 #endif
     p_storage->p_next = NULL;
 
@@ -1327,6 +1527,11 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
     p_storage->i_file_max = i_tmp_size_max;
     p_storage->i_file_size = 0;
 
+    /* */
+    p_storage->p_index = NULL;
+    p_storage->i_index = 0;
+    p_storage->i_index_max = 0;
+
     /* */
     p_storage->p_cmd_buf = vlc_alloc( TS_STORAGE_COMMAND_PREALLOC, MAX_COMMAND_SIZE );
     p_storage->i_cmd_buf = TS_STORAGE_COMMAND_PREALLOC * MAX_COMMAND_SIZE;
@@ -1340,10 +1545,12 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
         return NULL;
     }
     return p_storage;
+#ifndef TS_STORAGE_MMAP
 error:
     free( psz_file );
     free( p_storage );
     return NULL;
+#endif
 }
 
 static void TsStorageDelete( ts_storage_t *p_storage )
@@ -1357,18 +1564,30 @@ static void TsStorageDelete( ts_storage_t *p_storage )
         CmdClean( &cmd );
     }
     free( p_storage->p_cmd_buf );
+    free( p_storage->p_index );
 
+#ifdef TS_STORAGE_MMAP
+    munmap( p_storage->p_map, p_storage->i_file_max );
+    vlc_close( p_storage->fd );
+#else
     fclose( p_storage->p_filer );
     fclose( p_storage->p_filew );
 #ifdef _WIN32
     vlc_unlink( p_storage->psz_file );
     free( p_storage->psz_file );
+#endif
 #endif
     free( p_storage );
 }
 
 static void TsStoragePack( ts_storage_t *p_storage )
 {
+#ifdef TS_STORAGE_MMAP
+    /* The segment is complete, start writing it back */
+    if( p_storage->i_file_size > 0 )
+        msync( p_storage->p_map, p_storage->i_file_size, MS_ASYNC );
+#endif
+
     /* Try to release a bit of memory */
     if( (size_t)(p_storage->p_cmd_w - p_storage->p_cmd_buf) == p_storage->i_cmd_buf )
         return;
@@ -1384,13 +1603,41 @@ static void TsStoragePack( ts_storage_t *p_storage )
     }
 }
 
+static bool TsStorageReset( ts_storage_t *p_storage )
+{
+#ifdef TS_STORAGE_MMAP
+    assert( TsStorageIsEmpty( p_storage ) );
+
+    /* The command buffer may have been packed */
+    const size_t i_cmd_buf = TS_STORAGE_COMMAND_PREALLOC * MAX_COMMAND_SIZE;
+    if( p_storage->i_cmd_buf != i_cmd_buf )
+    {
+        uint8_t *p_realloc = realloc( p_storage->p_cmd_buf, i_cmd_buf );
+        if( !p_realloc )
+            return false;
+        p_storage->p_cmd_buf = p_realloc;
+        p_storage->i_cmd_buf = i_cmd_buf;
+    }
+    p_storage->p_cmd_r = p_storage->p_cmd_buf;
+    p_storage->p_cmd_w = p_storage->p_cmd_buf;
+    p_storage->p_next = NULL;
+    p_storage->i_file_size = 0;
+    p_storage->i_index = 0;
+    return true;
+#else
+    /* Rewinding the files is not worth it */
+    VLC_UNUSED( p_storage );
+    return false;
+#endif
+}
+
 static bool TsStorageIsFull( ts_storage_t *p_storage, const ts_cmd_t *p_cmd )
 {
     if( p_cmd && p_cmd->header.i_type == C_SEND && p_storage->p_cmd_w )
     {
-        size_t i_size = sizeof(*p_cmd->send.p_block) + p_cmd->send.p_block->i_buffer;
+        size_t i_size = sizeof(ts_block_header_t) + p_cmd->send.p_block->i_buffer;
 
-        if( p_storage->i_file_size + i_size >= p_storage->i_file_max )
+        if( p_storage->i_file_size + i_size > p_storage->i_file_max )
             return true;
     }
     return (size_t)(p_storage->p_cmd_w - p_storage->p_cmd_buf) > p_storage->i_cmd_buf - MAX_COMMAND_SIZE;
@@ -1401,6 +1648,76 @@ static bool TsStorageIsEmpty( ts_storage_t *p_storage )
     return !p_storage || p_storage->p_cmd_r >= p_storage->p_cmd_w;
 }
 
+static void TsStorageIndex( ts_storage_t *p_storage, const ts_cmd_t *p_cmd )
+{
+    if( p_cmd->header.i_type != C_PRIVCONTROL ||
+        p_cmd->privcontrol.i_query != ES_OUT_PRIV_SET_TIMES ||
+        p_cmd->privcontrol.u.times.i_time == VLC_TICK_INVALID )
+        return;
+
+    if( p_storage->i_index >= p_storage->i_index_max )
+    {
+        size_t i_max = p_storage->i_index_max ? 2 * p_storage->i_index_max : 64;
+        ts_index_entry_t *p_index = realloc_or_free( p_storage->p_index,
+                                                     i_max * sizeof(*p_index) );
+        /* The index is only used to seek, the storage is still valid */
+        p_storage->p_index = p_index;
+        p_storage->i_index_max = p_index ? i_max : 0;
+        p_storage->i_index = 0;
+        if( !p_index )
+            return;
+    }
+
+    p_storage->p_index[p_storage->i_index++] = (ts_index_entry_t) {
+        .i_time = p_cmd->privcontrol.u.times.i_time,
+        .i_cmd = p_storage->p_cmd_w - p_storage->p_cmd_buf,
+    };
+}
+
+static int TsStorageFind( ts_storage_t *p_storage, vlc_tick_t i_time,
+                          ts_storage_t **pp_storage, size_t *pi_cmd )
+{
+    for( ; p_storage; p_storage = p_storage->p_next )
+    {
+        const ts_index_entry_t *p_index = p_storage->p_index;
+        const size_t i_read = p_storage->p_cmd_r - p_storage->p_cmd_buf;
+
+        /* First entry not played yet */
+        size_t i_lo = 0, i_hi = p_storage->i_index;
+        while( i_lo < i_hi )
+        {
+            const size_t i_mid = (i_lo + i_hi) / 2;
+            if( p_index[i_mid].i_cmd < i_read )
+                i_lo = i_mid + 1;
+            else
+                i_hi = i_mid;
+        }
+        if( i_lo >= p_storage->i_index )
+            continue;
+
+        /* Backward seeks would need the played data */
+        if( p_index[i_lo].i_time > i_time )
+            return VLC_EGENERIC;
+        if( p_index[p_storage->i_index - 1].i_time < i_time )
+            continue;
+
+        /* First entry at or after the requested time */
+        i_hi = p_storage->i_index;
+        while( i_lo < i_hi )
+        {
+            const size_t i_mid = (i_lo + i_hi) / 2;
+            if( p_index[i_mid].i_time < i_time )
+                i_lo = i_mid + 1;
+            else
+                i_hi = i_mid;
+        }
+        *pp_storage = p_storage;
+        *pi_cmd = p_index[i_lo].i_cmd;
+        return VLC_SUCCESS;
+    }
+    return VLC_EGENERIC;
+}
+
 static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bool b_flush )
 {
     assert( !TsStorageIsFull( p_storage, p_cmd ) );
@@ -1410,16 +1727,34 @@ static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bo
     if( cmd.header.i_type == C_SEND )
     {
         block_t *p_block = cmd.send.p_block;
+        const ts_block_header_t header = {
+            .i_dts = p_block->i_dts,
+            .i_pts = p_block->i_pts,
+            .i_length = p_block->i_length,
+            .i_flags = p_block->i_flags,
+            .i_nb_samples = p_block->i_nb_samples,
+            .i_buffer = p_block->i_buffer,
+        };
 
         cmd.send.p_block = NULL;
-        cmd.send.i_offset = ftell( p_storage->p_filew );
+        cmd.send.i_offset = p_storage->i_file_size;
 
-        if( fwrite( p_block, sizeof(*p_block), 1, p_storage->p_filew ) != 1 )
+#ifdef TS_STORAGE_MMAP
+        VLC_UNUSED( b_flush );
+        /* TsPushCmd sized the segment for the block */
+        uint8_t *p_dst = &p_storage->p_map[p_storage->i_file_size];
+        memcpy( p_dst, &header, sizeof(header) );
+        if( p_block->i_buffer > 0 )
+            memcpy( p_dst + sizeof(header), p_block->p_buffer, p_block->i_buffer );
+        p_storage->i_file_size += sizeof(header) + p_block->i_buffer;
+        block_Release( p_block );
+#else
+        if( fwrite( &header, sizeof(header), 1, p_storage->p_filew ) != 1 )
         {
             block_Release( p_block );
             return;
         }
-        p_storage->i_file_size += sizeof(*p_block);
+        p_storage->i_file_size += sizeof(header);
         if( p_block->i_buffer > 0 )
         {
             if( fwrite( p_block->p_buffer, p_block->i_buffer, 1, p_storage->p_filew ) != 1 )
@@ -1433,7 +1768,10 @@ static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bo
 
         if( b_flush )
             fflush( p_storage->p_filew );
+#endif
     }
+    TsStorageIndex( p_storage, &cmd );
+
     size_t i_cmdsize = TsStorageSizeofCommand[ cmd.header.i_type ];
     memcpy( p_storage->p_cmd_w, &cmd, i_cmdsize );
     p_storage->p_cmd_w += i_cmdsize;
@@ -1450,29 +1788,37 @@ static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_fl
 
     if( p_cmd->header.i_type == C_SEND )
     {
-        block_t block;
+        ts_block_header_t header;
+        block_t *p_block = NULL;
 
+#ifdef TS_STORAGE_MMAP
+        if( !b_flush )
+        {
+            const uint8_t *p_src = &p_storage->p_map[p_cmd->send.i_offset];
+            memcpy( &header, p_src, sizeof(header) );
+            p_block = block_Alloc( header.i_buffer );
+            if( p_block )
+                memcpy( p_block->p_buffer, p_src + sizeof(header), header.i_buffer );
+        }
+#else
         if( !b_flush &&
             !fseek( p_storage->p_filer, p_cmd->send.i_offset, SEEK_SET ) &&
-            fread( &block, sizeof(block), 1, p_storage->p_filer ) == 1 )
+            fread( &header, sizeof(header), 1, p_storage->p_filer ) == 1 )
         {
-            block_t *p_block = block_Alloc( block.i_buffer );
+            p_block = block_Alloc( header.i_buffer );
             if( p_block )
-            {
-                p_block->i_dts      = block.i_dts;
-                p_block->i_pts      = block.i_pts;
-                p_block->i_flags    = block.i_flags;
-                p_block->i_length   = block.i_length;
-                p_block->i_nb_samples = block.i_nb_samples;
-                p_block->i_buffer = fread( p_block->p_buffer, 1, block.i_buffer, p_storage->p_filer );
-            }
-            p_cmd->send.p_block = p_block;
+                p_block->i_buffer = fread( p_block->p_buffer, 1, header.i_buffer, p_storage->p_filer );
         }
-        else
+#endif
+        if( p_block )
         {
-            //perror( "TsStoragePopCmd" );
-            p_cmd->send.p_block = block_Alloc( 1 );
+            p_block->i_dts      = header.i_dts;
+            p_block->i_pts      = header.i_pts;
+            p_block->i_flags    = header.i_flags;
+            p_block->i_length   = header.i_length;
+            p_block->i_nb_samples = header.i_nb_samples;
         }
+        p_cmd->send.p_block = p_block;
     }
 }
 
@@ -1503,6 +1849,31 @@ static void CmdClean( ts_cmd_t *p_cmd )
     }
 }
 
+/* Commands only meaningful at their own time, skipped by a seek */
+static bool CmdIsTimed( const ts_cmd_t *p_cmd )
+{
+    switch( p_cmd->header.i_type )
+    {
+    case C_SEND:
+        return true;
+    case C_CONTROL:
+        switch( p_cmd->control.i_query )
+        {
+        case ES_OUT_SET_PCR:
+        case ES_OUT_SET_GROUP_PCR:
+        case ES_OUT_RESET_PCR:
+        case ES_OUT_SET_NEXT_DISPLAY_TIME:
+            return true;
+        default:
+            return false;
+        }
+    case C_PRIVCONTROL:
+        return p_cmd->privcontrol.i_query == ES_OUT_PRIV_SET_TIMES;
+    default:
+        return false;
+    }
+}
+
 static int CmdInitAdd( ts_cmd_add_t *p_cmd, input_source_t *in,  es_out_id_t *p_es,
                        const es_format_t *p_fmt, bool b_copy )
 {
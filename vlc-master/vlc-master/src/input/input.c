@@ -140,6 +140,16 @@ int input_Start( input_thread_t *p_input )
     return VLC_SUCCESS;
 }
 
+/**
+ * Let a preloaded input create its decoders and start playing
+ *
+ * \param p_input the input thread held before its programs initialisation
+ */
+void input_StartPreloaded( input_thread_t *p_input )
+{
+    vlc_sem_post( &input_priv(p_input)->preload_wait );
+}
+
 /**
  * Request a running input thread to stop and die
  *
@@ -275,6 +285,8 @@ input_thread_t * input_Create( vlc_object_t *p_parent, input_item_t *p_item,
     priv->is_running = false;
     priv->is_stopped = false;
     priv->b_recording = false;
+    priv->preload = cfg->preload;
+    vlc_sem_init( &priv->preload_wait, 0 );
     priv->rate = 1.f;
     TAB_INIT( priv->i_attachment, priv->attachment );
     priv->p_sout   = NULL;
@@ -322,7 +334,9 @@ input_thread_t * input_Create( vlc_object_t *p_parent, input_item_t *p_item,
         priv->p_resource = input_resource_Hold( cfg->resource );
     else
         priv->p_resource = input_resource_New( VLC_OBJECT( p_input ) );
-    input_resource_SetInput( priv->p_resource, p_input );
+    /* A preloaded input binds the resource once the previous one is done */
+    if( !priv->preload )
+        input_resource_SetInput( priv->p_resource, p_input );
 
     /* Init control buffer */
     vlc_mutex_init( &priv->lock_control );
@@ -1360,6 +1374,18 @@ static int Init( input_thread_t * p_input )
         StartTitle( p_input );
         SetSubtitlesOptions( p_input );
         LoadSlaves( p_input );
+
+        /* The media is opened and probed: wait for the player to hand the
+         * outputs over before creating the decoders */
+        if( priv->preload )
+        {
+            msg_Dbg( p_input, "preloaded, waiting for the previous input" );
+            if( vlc_sem_wait_i11e( &priv->preload_wait ) )
+                goto error_preload;
+            priv->preload = false;
+            input_resource_SetInput( priv->p_resource, p_input );
+        }
+
         InitPrograms( p_input );
 
         double f_rate = var_GetFloat( p_input, "rate" );
@@ -1405,6 +1431,14 @@ static int Init( input_thread_t * p_input )
 
     return VLC_SUCCESS;
 
+error_preload:
+    for( size_t i = 0; i < priv->i_slave; i++ )
+    {
+        InputSourceDestroy( priv->slave[i] );
+        input_source_Release( priv->slave[i] );
+    }
+    TAB_CLEAN( priv->i_slave, priv->slave );
+    InputSourceDestroy( master );
 error:
     input_ChangeState( p_input, ERROR_S, VLC_TICK_INVALID );
 
@@ -1416,7 +1450,8 @@ error:
         if( input_priv(p_input)->p_sout )
             input_resource_PutSout( input_priv(p_input)->p_resource,
                                     input_priv(p_input)->p_sout );
-        input_resource_SetInput( input_priv(p_input)->p_resource, NULL );
+        if( !input_priv(p_input)->preload )
+            input_resource_SetInput( input_priv(p_input)->p_resource, NULL );
         if( input_priv(p_input)->p_resource )
         {
             input_resource_Release( input_priv(p_input)->p_resource );
@@ -1996,6 +2031,18 @@ static bool Control( input_thread_t *p_input,
                 break;
             }
 
+            /* A live stream cannot seek, but its timeshift buffer can */
+            bool b_can_seek;
+            if( demux_Control( priv->master->p_demux, DEMUX_CAN_SEEK, &b_can_seek ) )
+                b_can_seek = false;
+            if( !b_can_seek &&
+                !es_out_SetTimeshiftTime( priv->p_es_out,
+                                          priv->i_start + param.time.i_val ) )
+            {
+                b_force_update = true;
+                break;
+            }
+
             /* Reset the decoders states and clock sync (before calling the demuxer */
             es_out_Control(&priv->p_es_out->out, ES_OUT_RESET_PCR);
 
@@ -356,6 +356,9 @@ struct vlc_input_thread_cfg
         bool subitems;
     } preparsing;
     bool interact;
+    /* Open the media but hold the input before its programs and decoders
+     * are created, until input_StartPreloaded() */
+    bool preload;
 };
 /**
  * Create a new input_thread_t.
@@ -374,6 +377,14 @@ input_thread_t * input_Create( vlc_object_t *p_parent, input_item_t *item,
 
 int input_Start( input_thread_t * );
 
+/**
+ * Resume an input created with the preload configuration.
+ *
+ * The input binds the resource and creates its decoders. The previous input
+ * using the same resource must be stopped.
+ */
+void input_StartPreloaded( input_thread_t * );
+
 void input_Stop( input_thread_t * );
 
 void input_Close( input_thread_t * );
@@ -471,6 +482,10 @@ typedef struct input_thread_private_t
     bool        is_running;
     bool        is_stopped;
     bool        b_recording;
+
+    /* Preloading: held until input_StartPreloaded() */
+    bool        preload;
+    vlc_sem_t   preload_wait;
     float       rate;
 
     /* Playtime configuration and state */
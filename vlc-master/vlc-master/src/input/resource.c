@@ -71,6 +71,7 @@ struct input_resource_t
     char *psz_sout;
     vout_thread_t   *p_vout_dummy;
     struct vout_resource *vout_rsc_free;
+    bool            b_vout_linger; /* keep the display of the main vout */
 
     /* This lock is used to protect vout resources access (for hold)
      * It is a special case because of embed video (possible deadlock
@@ -373,7 +374,11 @@ static void input_resource_PutVoutLocked(input_resource_t *p_resource,
 
     if (vout_rsc->started)
     {
-        vout_StopDisplay(vout_rsc->vout);
+        if (p_resource->b_vout_linger
+         && vout_rsc == resource_GetFirstVoutRsc(p_resource))
+            vout_SuspendDisplay(vout_rsc->vout);
+        else
+            vout_StopDisplay(vout_rsc->vout);
         vout_rsc->started = false;
     }
 
@@ -575,6 +580,13 @@ exit:
     vlc_mutex_unlock( &p_resource->lock_hold );
 }
 
+void input_resource_SetVoutLinger(input_resource_t *p_resource, bool linger)
+{
+    vlc_mutex_lock(&p_resource->lock);
+    p_resource->b_vout_linger = linger;
+    vlc_mutex_unlock(&p_resource->lock);
+}
+
 void input_resource_StopFreeVout(input_resource_t *p_resource)
 {
     vlc_mutex_lock(&p_resource->lock);
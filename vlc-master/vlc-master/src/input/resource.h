@@ -89,6 +89,12 @@ void input_resource_HoldVouts( input_resource_t *, vout_thread_t ***, size_t * )
 
 void input_resource_StopFreeVout( input_resource_t * );
 
+/**
+ * This function keeps the display of the main vout when it is released, so
+ * that the next input can resume it if the video format does not change.
+ */
+void input_resource_SetVoutLinger( input_resource_t *, bool );
+
 /**
  * This function holds the input_resource_t itself
  */
@@ -903,6 +903,13 @@ int vlc_stream_vaControl(stream_t *s, int cmd, va_list args)
                 return s->ops->stream.set_private_id_state(s, priv_data, selected);
             }
             return VLC_EGENERIC;
+        case STREAM_SET_PREFETCH_HINT:
+            if (s->ops->stream.set_prefetch_hint != NULL) {
+                uint64_t offset = va_arg(args, uint64_t);
+                size_t length = va_arg(args, size_t);
+                return s->ops->stream.set_prefetch_hint(s, offset, length);
+            }
+            return VLC_EGENERIC;
         case STREAM_SET_PRIVATE_ID_CA:
             if (s->ops->stream.set_private_id_ca != NULL) {
                 void *payload = va_arg(args, void *);
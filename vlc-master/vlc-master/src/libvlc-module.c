@@ -712,6 +712,11 @@ static const char *const ppsz_prefres[] = {
 #define INPUT_REPEAT_LONGTEXT N_( \
     "Number of time the same input will be repeated")
 
+#define INPUT_PRELOAD_TEXT N_("Next input preloading (ms)")
+#define INPUT_PRELOAD_LONGTEXT N_( \
+    "Open the next input this long before the end of the current one, " \
+    "so that it starts without a gap. 0, the default, disables it." )
+
 #define START_TIME_TEXT N_("Start time")
 #define START_TIME_LONGTEXT N_( \
     "The stream will start at this position (in seconds)." )
@@ -1895,6 +1900,9 @@ vlc_module_begin ()
                  INPUT_REPEAT_TEXT, INPUT_REPEAT_LONGTEXT )
         change_integer_range( 0, 65535 )
         change_safe ()
+    add_integer( "input-preload", 0,
+                 INPUT_PRELOAD_TEXT, INPUT_PRELOAD_LONGTEXT )
+        change_integer_range( 0, 60000 )
     add_float( "start-time", 0,
                START_TIME_TEXT, START_TIME_LONGTEXT )
         change_safe ()
@@ -22,6 +22,8 @@
 # include "config.h"
 #endif
 
+#include <stdatomic.h>
+
 #include <vlc_executor.h>
 
 #include <vlc_atomic.h>
@@ -29,21 +31,44 @@
 #include <vlc_threads.h>
 #include "../libvlc.h"
 
+#define PRIORITY_COUNT (VLC_EXECUTOR_PRIORITY_INTERACTIVE + 1)
+
+/**
+ * Queue of the runnables submitted to one thread.
+ *
+ * Each thread takes from its own queue first, then steals from the other
+ * threads queues, one priority lane at a time. A runnable stays in the queue
+ * it was submitted to until it is taken or canceled, so that canceling only
+ * locks that queue.
+ */
+struct vlc_executor_queue {
+    vlc_mutex_t lock;
+
+    /** Lists of vlc_runnable, by priority */
+    struct vlc_list lanes[PRIORITY_COUNT];
+
+    /** Runnables in each lane, read without the lock to skip empty lanes */
+    atomic_uint counts[PRIORITY_COUNT];
+};
+
 /**
  * An executor can spawn several threads.
  *
  * This structure contains the data specific to one thread.
  */
 struct vlc_executor_thread {
-    /** Node of vlc_executor.threads list */
-    struct vlc_list node;
-
     /** The executor owning the thread */
     vlc_executor_t *owner;
 
+    /** Index in vlc_executor.threads */
+    unsigned index;
+
     /** The system thread */
     vlc_thread_t thread;
 
+    /** The runnables submitted to this thread */
+    struct vlc_executor_queue queue;
+
     /** The current task executed by the thread, NULL if none */
     struct vlc_runnable *current_task;
 };
@@ -53,62 +78,160 @@ struct vlc_executor_thread {
  * header).
  */
 struct vlc_executor {
+    /** Protects thread creation and the sleeping threads */
     vlc_mutex_t lock;
 
     /** Maximum number of threads to run the tasks */
     unsigned max_threads;
 
-    /** List of active vlc_executor_thread */
-    struct vlc_list threads;
+    /** Threads, the first nthreads ones are running */
+    struct vlc_executor_thread *threads;
 
     /** Thread count (in a separate field to quickly compare to max_threads) */
-    unsigned nthreads;
+    atomic_uint nthreads;
+
+    /** Thread receiving the next runnable submitted from outside */
+    atomic_uint next_thread;
+
+    /** Runnables queued in all the threads, by priority */
+    atomic_uint queued[PRIORITY_COUNT];
 
     /* Number of tasks requested but not finished. */
-    unsigned unfinished;
+    atomic_uint unfinished;
 
     /** Wait for the executor to be idle (i.e. unfinished == 0) */
     vlc_cond_t idle_wait;
 
-    /** Queue of vlc_runnable */
-    struct vlc_list queue;
+    /** Threads waiting for a runnable */
+    atomic_uint sleepers;
 
-    /** Wait for the queue to be non-empty */
+    /** Wait for a runnable to be submitted */
     vlc_cond_t queue_wait;
 
     /** True if executor deletion is requested */
-    bool closing;
+    atomic_bool closing;
 };
 
+/** The executor thread running on the current thread, if any */
+static thread_local struct vlc_executor_thread *current_thread;
+
 static void
-QueuePush(vlc_executor_t *executor, struct vlc_runnable *runnable)
+QueueInit(struct vlc_executor_queue *queue)
 {
-    vlc_mutex_assert(&executor->lock);
-
-    vlc_list_append(&runnable->node, &executor->queue);
-    vlc_cond_signal(&executor->queue_wait);
+    vlc_mutex_init(&queue->lock);
+    for (unsigned i = 0; i < PRIORITY_COUNT; ++i)
+    {
+        vlc_list_init(&queue->lanes[i]);
+        atomic_init(&queue->counts[i], 0);
+    }
 }
 
-static struct vlc_runnable *
-QueueTake(vlc_executor_t *executor)
+static inline bool
+QueueIsEmpty(struct vlc_executor_queue *queue)
 {
-    vlc_mutex_assert(&executor->lock);
+    for (unsigned i = 0; i < PRIORITY_COUNT; ++i)
+        if (!vlc_list_is_empty(&queue->lanes[i]))
+            return false;
+    return true;
+}
 
-    while (!executor->closing && vlc_list_is_empty(&executor->queue))
-        vlc_cond_wait(&executor->queue_wait, &executor->lock);
+static void
+QueuePush(vlc_executor_t *executor, struct vlc_executor_queue *queue,
+          struct vlc_runnable *runnable, enum vlc_executor_priority priority)
+{
+    atomic_fetch_add(&executor->queued[priority], 1);
+
+    vlc_mutex_lock(&queue->lock);
+    runnable->queue = queue;
+    runnable->priority = priority;
+    vlc_list_append(&runnable->node, &queue->lanes[priority]);
+    atomic_fetch_add(&queue->counts[priority], 1);
+    vlc_mutex_unlock(&queue->lock);
+}
 
-    if (executor->closing)
+static struct vlc_runnable *
+QueueTake(vlc_executor_t *executor, struct vlc_executor_queue *queue,
+          unsigned priority)
+{
+    if (atomic_load(&queue->counts[priority]) == 0)
         return NULL;
 
+    vlc_mutex_lock(&queue->lock);
+
     struct vlc_runnable *runnable =
-        vlc_list_first_entry_or_null(&executor->queue, struct vlc_runnable,
-                                     node);
-    assert(runnable);
-    vlc_list_remove(&runnable->node);
+        vlc_list_first_entry_or_null(&queue->lanes[priority],
+                                     struct vlc_runnable, node);
+    if (runnable)
+    {
+        vlc_list_remove(&runnable->node);
+        atomic_fetch_sub(&queue->counts[priority], 1);
+        atomic_fetch_sub(&executor->queued[priority], 1);
+
+        /* Set links to NULL to know that it has been taken by a thread in
+         * vlc_executor_Cancel() */
+        runnable->node.prev = runnable->node.next = NULL;
+    }
+
+    vlc_mutex_unlock(&queue->lock);
+
+    return runnable;
+}
+
+/* Takes the first runnable of the highest priority, from the thread queue
+ * then from the other threads queues */
+static struct vlc_runnable *
+TakeTask(struct vlc_executor_thread *thread)
+{
+    vlc_executor_t *executor = thread->owner;
+    unsigned nthreads = atomic_load(&executor->nthreads);
+
+    for (unsigned priority = PRIORITY_COUNT; priority-- > 0;)
+    {
+        if (atomic_load(&executor->queued[priority]) == 0)
+            continue;
+
+        for (unsigned i = 0; i < nthreads; ++i)
+        {
+            struct vlc_executor_thread *victim =
+                &executor->threads[(thread->index + i) % nthreads];
+
+            struct vlc_runnable *runnable =
+                QueueTake(executor, &victim->queue, priority);
+            if (runnable)
+                return runnable;
+        }
+    }
+    return NULL;
+}
+
+static void
+TaskFinished(vlc_executor_t *executor)
+{
+    unsigned unfinished = atomic_fetch_sub(&executor->unfinished, 1);
+    assert(unfinished > 0);
+    if (unfinished == 1)
+    {
+        vlc_mutex_lock(&executor->lock);
+        vlc_cond_broadcast(&executor->idle_wait);
+        vlc_mutex_unlock(&executor->lock);
+    }
+}
 
-    /* Set links to NULL to know that it has been taken by a thread in
-     * vlc_executor_Cancel() */
-    runnable->node.prev = runnable->node.next = NULL;
+static struct vlc_runnable *
+WaitTask(struct vlc_executor_thread *thread)
+{
+    vlc_executor_t *executor = thread->owner;
+    struct vlc_runnable *runnable = NULL;
+
+    vlc_mutex_lock(&executor->lock);
+    /* Pairs with the check in vlc_executor_SubmitPriority(): either a
+     * runnable is found here, or the submitter sees this thread sleeping */
+    atomic_fetch_add(&executor->sleepers, 1);
+    while (!atomic_load(&executor->closing)
+        && (runnable = TakeTask(thread)) == NULL)
+        vlc_cond_wait(&executor->queue_wait, &executor->lock);
+    atomic_fetch_sub(&executor->sleepers, 1);
+    vlc_mutex_unlock(&executor->lock);
 
     return runnable;
 }
@@ -121,54 +244,47 @@ ThreadRun(void *userdata)
 
     vlc_thread_set_name("vlc-exec-runner");
 
-    vlc_mutex_lock(&executor->lock);
+    current_thread = thread;
 
-    struct vlc_runnable *runnable;
-    /* When the executor is closing, QueueTake() returns NULL */
-    while ((runnable = QueueTake(executor)))
+    /* When the executor is closing, WaitTask() returns NULL */
+    while (!atomic_load(&executor->closing))
     {
+        struct vlc_runnable *runnable = TakeTask(thread);
+        if (runnable == NULL && (runnable = WaitTask(thread)) == NULL)
+            break;
+
         thread->current_task = runnable;
-        vlc_mutex_unlock(&executor->lock);
 
-        /* Execute the user-provided runnable, without the executor lock */
+        /* Execute the user-provided runnable, without any lock */
         runnable->run(runnable->userdata);
 
-        vlc_mutex_lock(&executor->lock);
         thread->current_task = NULL;
 
         vlc_thread_set_name("vlc-exec-runner");
 
-        assert(executor->unfinished > 0);
-        --executor->unfinished;
-        if (!executor->unfinished)
-            vlc_cond_signal(&executor->idle_wait);
+        TaskFinished(executor);
     }
 
-    vlc_mutex_unlock(&executor->lock);
-
     return NULL;
 }
 
 static int
 SpawnThread(vlc_executor_t *executor)
 {
-    assert(executor->nthreads < executor->max_threads);
+    vlc_mutex_assert(&executor->lock);
 
-    struct vlc_executor_thread *thread = malloc(sizeof(*thread));
-    if (!thread)
-        return VLC_ENOMEM;
+    unsigned nthreads = atomic_load(&executor->nthreads);
+    assert(nthreads < executor->max_threads);
 
+    struct vlc_executor_thread *thread = &executor->threads[nthreads];
     thread->owner = executor;
+    thread->index = nthreads;
     thread->current_task = NULL;
 
     if (vlc_clone(&thread->thread, ThreadRun, thread))
-    {
-        free(thread);
         return VLC_EGENERIC;
-    }
 
-    executor->nthreads++;
-    vlc_list_append(&thread->node, &executor->threads);
+    atomic_store(&executor->nthreads, nthreads + 1);
 
     return VLC_SUCCESS;
 }
@@ -181,24 +297,37 @@ vlc_executor_New(unsigned max_threads)
     if (!executor)
         return NULL;
 
+    executor->threads = vlc_alloc(max_threads, sizeof(*executor->threads));
+    if (!executor->threads)
+    {
+        free(executor);
+        return NULL;
+    }
+    for (unsigned i = 0; i < max_threads; ++i)
+        QueueInit(&executor->threads[i].queue);
+
     vlc_mutex_init(&executor->lock);
 
     executor->max_threads = max_threads;
-    executor->nthreads = 0;
-    executor->unfinished = 0;
-
-    vlc_list_init(&executor->threads);
-    vlc_list_init(&executor->queue);
+    atomic_init(&executor->nthreads, 0);
+    atomic_init(&executor->next_thread, 0);
+    for (unsigned i = 0; i < PRIORITY_COUNT; ++i)
+        atomic_init(&executor->queued[i], 0);
+    atomic_init(&executor->unfinished, 0);
+    atomic_init(&executor->sleepers, 0);
 
     vlc_cond_init(&executor->idle_wait);
     vlc_cond_init(&executor->queue_wait);
 
-    executor->closing = false;
+    atomic_init(&executor->closing, false);
 
     /* Create one thread on init so that vlc_executor_Submit() may never fail */
+    vlc_mutex_lock(&executor->lock);
     int ret = SpawnThread(executor);
+    vlc_mutex_unlock(&executor->lock);
     if (ret != VLC_SUCCESS)
     {
+        free(executor->threads);
         free(executor);
         return NULL;
     }
@@ -207,26 +336,57 @@ vlc_executor_New(unsigned max_threads)
 }
 
 void
-vlc_executor_Submit(vlc_executor_t *executor, struct vlc_runnable *runnable)
+vlc_executor_SubmitPriority(vlc_executor_t *executor,
+                            struct vlc_runnable *runnable,
+                            enum vlc_executor_priority priority)
 {
-    vlc_mutex_lock(&executor->lock);
+    assert(!atomic_load(&executor->closing));
+    assert(priority < PRIORITY_COUNT);
 
-    assert(!executor->closing);
+    unsigned unfinished = atomic_fetch_add(&executor->unfinished, 1) + 1;
 
-    QueuePush(executor, runnable);
+    /* Runnables submitted from a task stay on its thread */
+    struct vlc_executor_thread *thread = current_thread;
+    if (thread == NULL || thread->owner != executor)
+    {
+        unsigned nthreads = atomic_load(&executor->nthreads);
+        unsigned index = atomic_fetch_add_explicit(&executor->next_thread, 1,
+                                                   memory_order_relaxed);
+        thread = &executor->threads[index % nthreads];
+    }
+    QueuePush(executor, &thread->queue, runnable, priority);
 
-    if (++executor->unfinished > executor->nthreads
-            && executor->nthreads < executor->max_threads)
-        /* If it fails, this is not an error, there is at least one thread */
-        SpawnThread(executor);
+    if (atomic_load(&executor->sleepers) > 0)
+    {
+        vlc_mutex_lock(&executor->lock);
+        vlc_cond_signal(&executor->queue_wait);
+        vlc_mutex_unlock(&executor->lock);
+    }
 
-    vlc_mutex_unlock(&executor->lock);
+    if (unfinished > atomic_load(&executor->nthreads)
+     && atomic_load(&executor->nthreads) < executor->max_threads)
+    {
+        vlc_mutex_lock(&executor->lock);
+        if (atomic_load(&executor->nthreads) < executor->max_threads)
+            /* If it fails, this is not an error, there is at least one thread */
+            SpawnThread(executor);
+        vlc_mutex_unlock(&executor->lock);
+    }
+}
+
+void
+vlc_executor_Submit(vlc_executor_t *executor, struct vlc_runnable *runnable)
+{
+    vlc_executor_SubmitPriority(executor, runnable,
+                                VLC_EXECUTOR_PRIORITY_NORMAL);
 }
 
 bool
 vlc_executor_Cancel(vlc_executor_t *executor, struct vlc_runnable *runnable)
 {
-    vlc_mutex_lock(&executor->lock);
+    struct vlc_executor_queue *queue = runnable->queue;
+
+    vlc_mutex_lock(&queue->lock);
 
     /* Either both prev and next are set, either both are NULL */
     assert(!runnable->node.prev == !runnable->node.next);
@@ -235,14 +395,15 @@ vlc_executor_Cancel(vlc_executor_t *executor, struct vlc_runnable *runnable)
     if (in_queue)
     {
         vlc_list_remove(&runnable->node);
-
-        assert(executor->unfinished > 0);
-        --executor->unfinished;
-        if (!executor->unfinished)
-            vlc_cond_signal(&executor->idle_wait);
+        atomic_fetch_sub(&queue->counts[runnable->priority], 1);
+        atomic_fetch_sub(&executor->queued[runnable->priority], 1);
+        runnable->node.prev = runnable->node.next = NULL;
     }
 
-    vlc_mutex_unlock(&executor->lock);
+    vlc_mutex_unlock(&queue->lock);
+
+    if (in_queue)
+        TaskFinished(executor);
 
     return in_queue;
 }
@@ -251,7 +412,7 @@ void
 vlc_executor_WaitIdle(vlc_executor_t *executor)
 {
     vlc_mutex_lock(&executor->lock);
-    while (executor->unfinished)
+    while (atomic_load(&executor->unfinished))
         vlc_cond_wait(&executor->idle_wait, &executor->lock);
     vlc_mutex_unlock(&executor->lock);
 }
@@ -261,32 +422,29 @@ vlc_executor_Delete(vlc_executor_t *executor)
 {
     vlc_mutex_lock(&executor->lock);
 
-    executor->closing = true;
-
-    /* All the tasks must be canceled on delete */
-    assert(vlc_list_is_empty(&executor->queue));
+    atomic_store(&executor->closing, true);
 
     /* "closing" is now true, this will wake up threads */
     vlc_cond_broadcast(&executor->queue_wait);
 
     vlc_mutex_unlock(&executor->lock);
 
-    /* The threads list may not be written at this point, so it is safe to read
-     * it without mutex locked (the mutex must be released to join the
+    /* No thread may be spawned at this point, so it is safe to read nthreads
+     * without mutex locked (the mutex must be released to join the
      * threads). */
 
-    struct vlc_executor_thread *thread;
-    vlc_list_foreach(thread, &executor->threads, node)
-    {
-        vlc_join(thread->thread, NULL);
-        free(thread);
-    }
+    unsigned nthreads = atomic_load(&executor->nthreads);
+    for (unsigned i = 0; i < nthreads; ++i)
+        vlc_join(executor->threads[i].thread, NULL);
 
-    /* The queue must still be empty (no runnable submitted a new runnable) */
-    assert(vlc_list_is_empty(&executor->queue));
+    /* All the tasks must be canceled on delete, and no runnable may have
+     * submitted a new runnable */
+    for (unsigned i = 0; i < executor->max_threads; ++i)
+        assert(QueueIsEmpty(&executor->threads[i].queue));
 
     /* There are no tasks anymore */
-    assert(!executor->unfinished);
+    assert(!atomic_load(&executor->unfinished));
 
+    free(executor->threads);
     free(executor);
 }
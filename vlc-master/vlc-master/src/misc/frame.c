@@ -40,6 +40,7 @@
 #include <vlc_fs.h>
 
 #include <vlc_ancillary.h>
+#include "frame.h"
 
 #ifndef NDEBUG
 static void vlc_frame_Check (vlc_frame_t *frame)
@@ -104,18 +105,6 @@ vlc_frame_t *vlc_frame_Init(vlc_frame_t *restrict f, const struct vlc_frame_call
     return f;
 }
 
-/** Initial memory alignment of data frame.
- * @note This must be a multiple of sizeof(void*) and a power of two.
- * libavcodec AVX optimizations require at least 32-bytes. */
-#define VLC_FRAME_ALIGN        32
-
-/** Initial reserved header and footer size. */
-#ifdef FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION
-# define VLC_FRAME_PADDING      0 /* Don't hide buffer overflows */
-#else
-# define VLC_FRAME_PADDING      32 /* Avoid <= 32 bytes reallocs */
-#endif
-
 vlc_frame_t *vlc_frame_Alloc (size_t size)
 {
     if (unlikely(size >> 28))
@@ -127,6 +116,10 @@ vlc_frame_t *vlc_frame_Alloc (size_t size)
     static_assert ((VLC_FRAME_PADDING % VLC_FRAME_ALIGN) == 0,
                    "VLC_FRAME_PADDING must be a multiple of VLC_FRAME_ALIGN");
 
+    vlc_frame_t *f = vlc_frame_cache_Alloc(size);
+    if (f != NULL)
+        return f;
+
     /* 2 * VLC_FRAME_PADDING: pre + post padding */
     size_t capacity = (2 * VLC_FRAME_PADDING) + size;
     unsigned char *buf;
@@ -140,7 +133,7 @@ vlc_frame_t *vlc_frame_Alloc (size_t size)
     if (unlikely(buf == NULL))
         return NULL;
 
-    vlc_frame_t *f = vlc_frame_heap_Alloc(buf, capacity);
+    f = vlc_frame_heap_Alloc(buf, capacity);
     if (likely(f != NULL)) {
 #ifndef HAVE_ALIGNED_ALLOC
         /* Alignment */
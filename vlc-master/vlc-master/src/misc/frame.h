@@ -0,0 +1,49 @@
+/*****************************************************************************
+ * frame.h: frame internals
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_FRAME_INTERNAL_H
+#define VLC_FRAME_INTERNAL_H
+
+#include <vlc_frame.h>
+
+/** Initial memory alignment of data frame.
+ * @note This must be a multiple of sizeof(void*) and a power of two.
+ * libavcodec AVX optimizations require at least 32-bytes. */
+#define VLC_FRAME_ALIGN        32
+
+/** Initial reserved header and footer size. */
+#ifdef FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION
+# define VLC_FRAME_PADDING      0 /* Don't hide buffer overflows */
+#else
+# define VLC_FRAME_PADDING      32 /* Avoid <= 32 bytes reallocs */
+#endif
+
+/**
+ * Allocates a frame from the size class cache.
+ *
+ * The frame has VLC_FRAME_PADDING bytes reserved before and after the
+ * payload, like vlc_frame_Alloc().
+ *
+ * @return the frame, or NULL if the size is not cached (or on memory error),
+ * in which case the caller falls back to the heap.
+ */
+vlc_frame_t *vlc_frame_cache_Alloc(size_t size);
+
+#endif
@@ -0,0 +1,442 @@
+/*****************************************************************************
+ * frame_cache.c: size class cache for frame allocations
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_frame.h>
+#include <vlc_list.h>
+#include <vlc_threads.h>
+
+#include "frame.h"
+
+/*
+ * Frames of up to 256 KiB (header included) are carved out of chunks of
+ * power-of-two size classes. Each chunk is a single heap allocation holding
+ * the frame header and the buffer, so a cache hit costs neither malloc() nor
+ * free().
+ *
+ * Freed chunks go to a per-thread magazine (a small stack of chunks) of their
+ * class. Each thread has a loaded and a previous magazine per class, so that
+ * it can alternate between allocating and freeing without touching any
+ * shared state. Full magazines are exchanged as a whole through a global
+ * depot: the typical demux thread allocates, a decoder thread frees, and the
+ * chunks come back to the demux thread one magazine at a time.
+ *
+ * Magazines are flushed to the depot when their thread exits. The depot
+ * holds at most DEPOT_BYTES per class, and each thread at most two
+ * magazines per class, so that the memory kept alive stays bounded.
+ */
+
+#if defined(FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION) || \
+    defined(__SANITIZE_ADDRESS__)
+# define FRAME_CACHE_DISABLED 1 /* Don't hide buffer overflows */
+#elif defined(__has_feature)
+# if __has_feature(address_sanitizer)
+#  define FRAME_CACHE_DISABLED 1
+# endif
+#endif
+
+#ifndef FRAME_CACHE_DISABLED
+
+#define CACHE_MIN_SHIFT     9  /* 512 bytes */
+#define CACHE_MAX_SHIFT    18  /* 256 KiB */
+#define CACHE_CLASSES      (CACHE_MAX_SHIFT - CACHE_MIN_SHIFT + 1)
+
+#define MAGAZINE_BYTES     (128 << 10)
+#define MAGAZINE_ROUNDS    64
+#define DEPOT_BYTES        (1 << 20) /* per class */
+
+struct vlc_frame_chunk
+{
+    vlc_frame_t frame;
+    unsigned class;
+};
+
+struct frame_magazine
+{
+    struct frame_magazine *next; /* in the depot */
+    unsigned count;
+    struct vlc_frame_chunk *rounds[];
+};
+
+struct frame_cache
+{
+    struct frame_magazine *loaded[CACHE_CLASSES];
+    struct frame_magazine *previous[CACHE_CLASSES];
+
+    /* Only written by the owner thread */
+    atomic_uint_least64_t hits;
+    atomic_uint_least64_t misses;
+    atomic_size_t bytes;
+
+    struct vlc_list node;
+};
+
+static struct
+{
+    vlc_mutex_t lock;
+    struct frame_magazine *full[CACHE_CLASSES];
+    atomic_uint count[CACHE_CLASSES];
+    size_t bytes;
+    /* Counters of the exited threads */
+    uint64_t hits;
+    uint64_t misses;
+    struct vlc_list caches;
+} depot =
+{
+    .lock = VLC_STATIC_MUTEX,
+    .caches = VLC_LIST_INITIALIZER(&depot.caches),
+};
+
+static vlc_once_t cache_once = VLC_STATIC_ONCE;
+static vlc_threadvar_t cache_key;
+static bool cache_key_ok;
+
+static thread_local struct frame_cache *current_cache;
+static thread_local bool current_cache_exited;
+
+static size_t ClassSize(unsigned c)
+{
+    return (size_t)1 << (c + CACHE_MIN_SHIFT);
+}
+
+static unsigned MagazineRounds(unsigned c)
+{
+    size_t rounds = MAGAZINE_BYTES / ClassSize(c);
+
+    if (rounds > MAGAZINE_ROUNDS)
+        return MAGAZINE_ROUNDS;
+    return rounds > 0 ? rounds : 1;
+}
+
+static unsigned DepotMagazines(unsigned c)
+{
+    return DEPOT_BYTES / (MagazineRounds(c) * ClassSize(c));
+}
+
+static struct frame_magazine *MagazineNew(unsigned c)
+{
+    struct frame_magazine *mag =
+        malloc(sizeof (*mag) + MagazineRounds(c) * sizeof (mag->rounds[0]));
+    if (likely(mag != NULL))
+        mag->count = 0;
+    return mag;
+}
+
+static void MagazineDelete(struct frame_magazine *mag)
+{
+    for (unsigned i = 0; i < mag->count; i++)
+        free(mag->rounds[i]);
+    free(mag);
+}
+
+/* The counters are only written by their owner thread, no need for a
+ * read-modify-write operation. */
+static void CounterAdd(atomic_uint_least64_t *counter, uint_least64_t n)
+{
+    atomic_store_explicit(counter,
+        atomic_load_explicit(counter, memory_order_relaxed) + n,
+        memory_order_relaxed);
+}
+
+static void BytesAdd(struct frame_cache *cache, ssize_t n)
+{
+    atomic_store_explicit(&cache->bytes,
+        atomic_load_explicit(&cache->bytes, memory_order_relaxed) + n,
+        memory_order_relaxed);
+}
+
+static bool DepotPut(unsigned c, struct frame_magazine *mag)
+{
+    unsigned count = atomic_load_explicit(&depot.count[c],
+                                          memory_order_relaxed);
+    if (count >= DepotMagazines(c))
+        return false;
+
+    vlc_mutex_lock(&depot.lock);
+    count = atomic_load_explicit(&depot.count[c], memory_order_relaxed);
+    if (count < DepotMagazines(c))
+    {
+        mag->next = depot.full[c];
+        depot.full[c] = mag;
+        atomic_store_explicit(&depot.count[c], count + 1,
+                              memory_order_relaxed);
+        depot.bytes += mag->count * ClassSize(c);
+    }
+    else
+        mag = NULL;
+    vlc_mutex_unlock(&depot.lock);
+    return mag != NULL;
+}
+
+static struct frame_magazine *DepotGet(unsigned c)
+{
+    /* Racy check to skip the lock if the depot is empty */
+    if (atomic_load_explicit(&depot.count[c], memory_order_relaxed) == 0)
+        return NULL;
+
+    vlc_mutex_lock(&depot.lock);
+    struct frame_magazine *mag = depot.full[c];
+    if (mag != NULL)
+    {
+        depot.full[c] = mag->next;
+        atomic_store_explicit(&depot.count[c],
+            atomic_load_explicit(&depot.count[c], memory_order_relaxed) - 1,
+            memory_order_relaxed);
+        depot.bytes -= mag->count * ClassSize(c);
+    }
+    vlc_mutex_unlock(&depot.lock);
+    return mag;
+}
+
+static struct vlc_frame_chunk *CacheGet(struct frame_cache *cache, unsigned c)
+{
+    struct frame_magazine *mag = cache->loaded[c];
+
+    if (mag == NULL || mag->count == 0)
+    {
+        struct frame_magazine *prev = cache->previous[c];
+
+        if (prev != NULL && prev->count > 0)
+        {
+            cache->previous[c] = mag;
+            cache->loaded[c] = mag = prev;
+        }
+        else
+        {
+            struct frame_magazine *full = DepotGet(c);
+            if (full == NULL)
+                return NULL;
+
+            BytesAdd(cache, full->count * ClassSize(c));
+            free(prev); /* empty */
+            cache->previous[c] = mag;
+            cache->loaded[c] = mag = full;
+        }
+    }
+
+    BytesAdd(cache, -(ssize_t)ClassSize(c));
+    return mag->rounds[--mag->count];
+}
+
+static bool CachePut(struct frame_cache *cache, struct vlc_frame_chunk *chunk)
+{
+    const unsigned c = chunk->class;
+    struct frame_magazine *mag = cache->loaded[c];
+
+    if (mag == NULL || mag->count == MagazineRounds(c))
+    {
+        struct frame_magazine *prev = cache->previous[c];
+
+        if (prev != NULL && prev->count == 0)
+        {
+            cache->previous[c] = mag;
+            cache->loaded[c] = mag = prev;
+        }
+        else
+        {
+            struct frame_magazine *empty = MagazineNew(c);
+            if (unlikely(empty == NULL))
+                return false;
+
+            if (prev != NULL)
+            {   /* Full, hand it over to the allocating threads */
+                BytesAdd(cache, -(ssize_t)(prev->count * ClassSize(c)));
+                if (!DepotPut(c, prev))
+                    MagazineDelete(prev);
+            }
+            cache->previous[c] = mag;
+            cache->loaded[c] = mag = empty;
+        }
+    }
+
+    mag->rounds[mag->count++] = chunk;
+    BytesAdd(cache, ClassSize(c));
+    return true;
+}
+
+static void CacheFlushMagazine(unsigned c, struct frame_magazine *mag)
+{
+    if (mag == NULL)
+        return;
+    if (mag->count == 0 || !DepotPut(c, mag))
+        MagazineDelete(mag);
+}
+
+static void CacheExit(void *data)
+{
+    struct frame_cache *cache = data;
+
+    /* Frames released by later thread-specific destructors are freed
+     * directly. */
+    current_cache = NULL;
+    current_cache_exited = true;
+
+    for (unsigned c = 0; c < CACHE_CLASSES; c++)
+    {
+        CacheFlushMagazine(c, cache->loaded[c]);
+        CacheFlushMagazine(c, cache->previous[c]);
+    }
+
+    vlc_mutex_lock(&depot.lock);
+    depot.hits += atomic_load_explicit(&cache->hits, memory_order_relaxed);
+    depot.misses += atomic_load_explicit(&cache->misses, memory_order_relaxed);
+    vlc_list_remove(&cache->node);
+    vlc_mutex_unlock(&depot.lock);
+    free(cache);
+}
+
+static void CacheInit(void *data)
+{
+    (void) data;
+    cache_key_ok = vlc_threadvar_create(&cache_key, CacheExit) == 0;
+}
+
+static struct frame_cache *GetCache(void)
+{
+    struct frame_cache *cache = current_cache;
+
+    if (likely(cache != NULL))
+        return cache;
+    if (current_cache_exited)
+        return NULL;
+
+    vlc_once(&cache_once, CacheInit, NULL);
+    if (unlikely(!cache_key_ok))
+        return NULL;
+
+    cache = calloc(1, sizeof (*cache));
+    if (unlikely(cache == NULL))
+        return NULL;
+
+    /* The key destructor flushes the cache when the thread exits */
+    if (unlikely(vlc_threadvar_set(cache_key, cache)))
+    {
+        free(cache);
+        return NULL;
+    }
+
+    vlc_mutex_lock(&depot.lock);
+    vlc_list_append(&cache->node, &depot.caches);
+    vlc_mutex_unlock(&depot.lock);
+
+    current_cache = cache;
+    return cache;
+}
+
+static void vlc_frame_cache_Release(vlc_frame_t *frame)
+{
+    struct vlc_frame_chunk *chunk =
+        container_of(frame, struct vlc_frame_chunk, frame);
+    struct frame_cache *cache = GetCache();
+
+    if (cache == NULL || !CachePut(cache, chunk))
+        free(chunk);
+}
+
+static const struct vlc_frame_callbacks vlc_frame_cache_cbs =
+{
+    vlc_frame_cache_Release,
+};
+
+vlc_frame_t *vlc_frame_cache_Alloc(size_t size)
+{
+    /* Worst case, the buffer is aligned after the header */
+    const size_t needed = sizeof (struct vlc_frame_chunk) + VLC_FRAME_ALIGN
+                        - 1 + (2 * VLC_FRAME_PADDING) + size;
+    if (needed > ClassSize(CACHE_CLASSES - 1))
+        return NULL;
+
+    unsigned c = 0;
+    while (ClassSize(c) < needed)
+        c++;
+
+    struct frame_cache *cache = GetCache();
+    if (unlikely(cache == NULL))
+        return NULL;
+
+    struct vlc_frame_chunk *chunk = CacheGet(cache, c);
+    if (chunk != NULL)
+        CounterAdd(&cache->hits, 1);
+    else
+    {
+        CounterAdd(&cache->misses, 1);
+        chunk = malloc(ClassSize(c));
+        if (unlikely(chunk == NULL))
+            return NULL;
+        chunk->class = c;
+    }
+
+    unsigned char *start = (unsigned char *)(chunk + 1);
+    unsigned char *end = (unsigned char *)chunk + ClassSize(c);
+
+    start += (-(uintptr_t)(void *)start) % (uintptr_t)VLC_FRAME_ALIGN;
+
+    vlc_frame_t *f = vlc_frame_Init(&chunk->frame, &vlc_frame_cache_cbs,
+                                    start, end - start);
+    f->p_buffer = start + VLC_FRAME_PADDING;
+    f->i_buffer = size;
+    return f;
+}
+
+void vlc_frame_cache_GetStats(struct vlc_frame_cache_stats *stats)
+{
+    vlc_mutex_lock(&depot.lock);
+    stats->hits = depot.hits;
+    stats->misses = depot.misses;
+    stats->bytes_cached = depot.bytes;
+
+    struct frame_cache *cache;
+    vlc_list_foreach(cache, &depot.caches, node)
+    {
+        stats->hits += atomic_load_explicit(&cache->hits,
+                                            memory_order_relaxed);
+        stats->misses += atomic_load_explicit(&cache->misses,
+                                              memory_order_relaxed);
+        stats->bytes_cached += atomic_load_explicit(&cache->bytes,
+                                                    memory_order_relaxed);
+    }
+    vlc_mutex_unlock(&depot.lock);
+}
+
+#else /* FRAME_CACHE_DISABLED */
+
+vlc_frame_t *vlc_frame_cache_Alloc(size_t size)
+{
+    (void) size;
+    return NULL;
+}
+
+void vlc_frame_cache_GetStats(struct vlc_frame_cache_stats *stats)
+{
+    stats->hits = 0;
+    stats->misses = 0;
+    stats->bytes_cached = 0;
+}
+
+#endif
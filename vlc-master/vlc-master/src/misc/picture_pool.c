@@ -35,52 +35,93 @@
 #include <vlc_threads.h>
 #include <vlc_picture_pool.h>
 #include <vlc_atomic.h>
-#include <vlc_list.h>
 #include "picture.h"
 
 #define POOL_MAX 256
+#define POOL_NONE UINT32_MAX
 
+/* Available pictures form a lock-free stack of indexes. The head holds
+ * a tag, bumped by every update, in its upper half so that a picture
+ * taken and given back between two reads of the head does not corrupt
+ * the stack (ABA). Only picture_pool_Wait() takes the lock, and only
+ * when the pool is empty. */
 struct picture_pool_t {
+    _Atomic uint64_t head;
+    _Atomic uint32_t next[POOL_MAX];
+    picture_t *pictures[POOL_MAX];
+    unsigned count;
+
     vlc_mutex_t lock;
     vlc_cond_t  wait;
+    atomic_uint waiters;
 
     vlc_atomic_rc_t    refs;
-    bool released;
-    struct vlc_list inuse_list;
-    struct vlc_list available_list;
 };
 
+static uint64_t picture_pool_Head(uint64_t head, uint32_t index)
+{
+    return ((head >> 32) + 1) << 32 | index;
+}
+
+static bool picture_pool_Pop(picture_pool_t *pool, unsigned *index)
+{
+    /* Sequentially consistent: a waiter increments the waiters count then
+     * loads the head, while picture_pool_Push() stores the head then loads
+     * the count. Anything weaker on either side can lose a wakeup. */
+    uint64_t head = atomic_load(&pool->head);
+    uint64_t next;
+
+    do
+    {
+        uint32_t i = (uint32_t)head;
+        if (i == POOL_NONE)
+            return false;
+
+        assert(i < pool->count);
+        next = picture_pool_Head(head,
+                atomic_load_explicit(&pool->next[i], memory_order_relaxed));
+    }
+    while (!atomic_compare_exchange_weak(&pool->head, &head, next));
+
+    *index = (uint32_t)head;
+    return true;
+}
+
+static void picture_pool_Push(picture_pool_t *pool, unsigned index)
+{
+    uint64_t head = atomic_load_explicit(&pool->head, memory_order_relaxed);
+
+    do
+        atomic_store_explicit(&pool->next[index], (uint32_t)head,
+                              memory_order_relaxed);
+    while (!atomic_compare_exchange_weak(&pool->head, &head,
+                                         picture_pool_Head(head, index)));
+
+    /* Pairs with the increment in picture_pool_Wait(): either the waiter
+     * sees the picture, or it is counted here and gets signaled. */
+    if (atomic_load(&pool->waiters) > 0)
+    {
+        vlc_mutex_lock(&pool->lock);
+        vlc_cond_signal(&pool->wait);
+        vlc_mutex_unlock(&pool->lock);
+    }
+}
+
 static void picture_pool_Destroy(picture_pool_t *pool)
 {
     if (!vlc_atomic_rc_dec(&pool->refs))
         return;
 
-    assert(vlc_list_is_empty(&pool->inuse_list));
-    assert(vlc_list_is_empty(&pool->available_list));
-
     free(pool);
 }
 
 void picture_pool_Release(picture_pool_t *pool)
 {
-    vlc_mutex_lock(&pool->lock);
+    /* In-use pictures are kept alive by their clones, which give them back
+     * to the stack until the last one releases the pool. */
+    for (unsigned i = 0; i < pool->count; i++)
+        picture_Release(pool->pictures[i]);
 
-    /* Release pictures from both available and in-use lists */
-    for (size_t i = 0; i < 2; ++i)
-    {
-        struct vlc_list *list = i == 0 ? &pool->available_list : &pool->inuse_list;
-
-        picture_priv_t *priv;
-        vlc_list_foreach(priv, list, pool_node)
-        {
-            assert(priv->pool == pool);
-            vlc_list_remove(&priv->pool_node);
-            picture_Release(&priv->picture);
-        }
-    }
-    /* Prevent in-use cloned pictures to be added back to lists */
-    pool->released = true;
-    vlc_mutex_unlock(&pool->lock);
     picture_pool_Destroy(pool);
 }
 
@@ -95,16 +136,7 @@ static void picture_pool_ReleaseClone(picture_t *clone)
     picture_pool_t *pool = original_priv->pool;
     assert(pool != NULL);
 
-    vlc_mutex_lock(&pool->lock);
-
-    if (!pool->released)
-    {
-        vlc_list_remove(&original_priv->pool_node);
-        vlc_list_append(&original_priv->pool_node, &pool->available_list);
-        vlc_cond_signal(&pool->wait);
-    }
-
-    vlc_mutex_unlock(&pool->lock);
+    picture_pool_Push(pool, original_priv->pool_index);
 
     picture_Release(original);
 
@@ -112,14 +144,17 @@ static void picture_pool_ReleaseClone(picture_t *clone)
 }
 
 static picture_t *picture_pool_ClonePicture(picture_pool_t *pool,
-                                            picture_t *picture)
+                                            unsigned index)
 {
+    picture_t *picture = pool->pictures[index];
     picture_t *clone = picture_InternalClone(picture, picture_pool_ReleaseClone,
                                              picture);
     if (clone != NULL) {
         assert(!picture_HasChainedPics(clone));
         vlc_atomic_rc_inc(&pool->refs);
     }
+    else
+        picture_pool_Push(pool, index);
     return clone;
 }
 
@@ -127,8 +162,14 @@ static void picture_pool_AppendPic(picture_pool_t *pool, picture_t *pic)
 {
     picture_priv_t *priv = container_of(pic, picture_priv_t, picture);
     assert(priv->pool == NULL);
-    vlc_list_append(&priv->pool_node, &pool->available_list);
+    assert(pool->count < POOL_MAX);
+
     priv->pool = pool;
+    priv->pool_index = pool->count;
+    pool->pictures[pool->count] = pic;
+    atomic_init(&pool->next[pool->count], (uint32_t)atomic_load(&pool->head));
+    atomic_init(&pool->head, pool->count);
+    pool->count++;
 }
 
 static picture_pool_t *
@@ -139,13 +180,13 @@ picture_pool_NewCommon(void)
     if (unlikely(pool == NULL))
         return NULL;
 
-    vlc_list_init(&pool->inuse_list);
-    vlc_list_init(&pool->available_list);
+    atomic_init(&pool->head, POOL_NONE);
+    pool->count = 0;
 
     vlc_mutex_init(&pool->lock);
     vlc_cond_init(&pool->wait);
+    atomic_init(&pool->waiters, 0);
     vlc_atomic_rc_init(&pool->refs);
-    pool->released = false;
 
     return pool;
 }
@@ -190,51 +231,31 @@ picture_pool_t *picture_pool_NewFromFormat(const video_format_t *fmt,
     return pool;
 }
 
-static picture_t *picture_pool_GetAvailableLocked(picture_pool_t *pool)
-{
-    picture_priv_t *priv = vlc_list_first_entry_or_null(&pool->available_list,
-                                                        picture_priv_t,
-                                                        pool_node);
-    assert(priv != NULL);
-
-    assert(priv->pool == pool);
-
-    vlc_list_remove(&priv->pool_node);
-    vlc_list_append(&priv->pool_node, &pool->inuse_list);
-
-    return &priv->picture;
-}
-
 picture_t *picture_pool_Get(picture_pool_t *pool)
 {
-
-    vlc_mutex_lock(&pool->lock);
     assert(vlc_atomic_rc_get(&pool->refs) > 0);
 
-    if (vlc_list_is_empty(&pool->available_list))
-    {
-        vlc_mutex_unlock(&pool->lock);
+    unsigned index;
+    if (!picture_pool_Pop(pool, &index))
         return NULL;
-    }
-
-    picture_t *pic = picture_pool_GetAvailableLocked(pool);
 
-    vlc_mutex_unlock(&pool->lock);
-
-    return picture_pool_ClonePicture(pool, pic);
+    return picture_pool_ClonePicture(pool, index);
 }
 
 picture_t *picture_pool_Wait(picture_pool_t *pool)
 {
-    vlc_mutex_lock(&pool->lock);
     assert(vlc_atomic_rc_get(&pool->refs) > 0);
 
-    while (vlc_list_is_empty(&pool->available_list))
-        vlc_cond_wait(&pool->wait, &pool->lock);
-
-    picture_t *pic = picture_pool_GetAvailableLocked(pool);
-
-    vlc_mutex_unlock(&pool->lock);
+    unsigned index;
+    if (!picture_pool_Pop(pool, &index))
+    {
+        vlc_mutex_lock(&pool->lock);
+        atomic_fetch_add(&pool->waiters, 1);
+        while (!picture_pool_Pop(pool, &index))
+            vlc_cond_wait(&pool->wait, &pool->lock);
+        atomic_fetch_sub(&pool->waiters, 1);
+        vlc_mutex_unlock(&pool->lock);
+    }
 
-    return picture_pool_ClonePicture(pool, pic);
+    return picture_pool_ClonePicture(pool, index);
 }
@@ -25,6 +25,7 @@
 #include <vlc_common.h>
 #include <vlc_memstream.h>
 #include "player.h"
+#include "input/resource.h"
 
 struct vlc_player_track_priv *
 vlc_player_input_FindTrackById(struct vlc_player_input *input, vlc_es_id_t *id,
@@ -95,9 +96,67 @@ vlc_player_input_UpdateTime(struct vlc_player_input *input)
     }
 }
 
+static void
+vlc_player_input_SendPreloadedEvents(struct vlc_player_input *input)
+{
+    vlc_player_t *player = input->player;
+
+    /* Tell the listeners what was probed while the input was preloading */
+    vlc_player_input_HandleState(input, VLC_PLAYER_STATE_STARTED,
+                                 VLC_TICK_INVALID);
+
+    for (enum es_format_category_e i = UNKNOWN_ES; i < DATA_ES; ++i)
+        if (input->cat_delays[i] != 0)
+            vlc_player_SendEvent(player, on_category_delay_changed, i,
+                                 input->cat_delays[i]);
+
+    vlc_player_SendEvent(player, on_capabilities_changed, 0,
+                         input->capabilities);
+    if (input->length != VLC_TICK_INVALID)
+        vlc_player_SendEvent(player, on_length_changed, input->length);
+
+    struct vlc_player_program *prgm;
+    vlc_vector_foreach(prgm, &input->program_vector)
+        vlc_player_SendEvent(player, on_program_list_changed,
+                             VLC_PLAYER_LIST_ADDED, prgm);
+
+    static const enum es_format_category_e cats[] = {
+        VIDEO_ES, AUDIO_ES, SPU_ES,
+    };
+    for (size_t i = 0; i < ARRAY_SIZE(cats); ++i)
+    {
+        vlc_player_track_vector *vec =
+            vlc_player_input_GetTrackVector(input, cats[i]);
+        struct vlc_player_track_priv *trackpriv;
+        vlc_vector_foreach(trackpriv, vec)
+            vlc_player_SendEvent(player, on_track_list_changed,
+                                 VLC_PLAYER_LIST_ADDED, &trackpriv->t);
+    }
+    if (input->teletext_source != NULL)
+        vlc_player_SendEvent(player, on_teletext_menu_changed, true);
+
+    if (input->titles)
+    {
+        vlc_player_SendEvent(player, on_titles_changed, input->titles);
+        vlc_player_SendEvent(player, on_title_selection_changed,
+                             &input->titles->array[input->title_selected],
+                             input->title_selected);
+    }
+}
+
 int
 vlc_player_input_Start(struct vlc_player_input *input)
 {
+    if (input->preloaded)
+    {
+        /* Already opened, let it create its decoders */
+        assert(input->started && !input->preloading);
+        input->preloaded = false;
+        vlc_player_input_SendPreloadedEvents(input);
+        input_StartPreloaded(input->thread);
+        return VLC_SUCCESS;
+    }
+
     int ret = input_Start(input->thread);
     if (ret != VLC_SUCCESS)
         return ret;
@@ -340,6 +399,8 @@ vlc_player_input_HandleStateEvent(struct vlc_player_input *input,
                                          state_date);
             break;
         case END_S:
+            if (input == input->player->input)
+                input->player->eos_date = vlc_tick_now();
             input->playing = false;
             vlc_player_input_HandleState(input, VLC_PLAYER_STATE_STOPPING,
                                          VLC_TICK_INVALID);
@@ -870,6 +931,60 @@ vlc_player_input_MouseFallback(struct vlc_player_input *input)
     vlc_player_TogglePause(player);
 }
 
+static void
+vlc_player_input_HandlePreloadEvent(struct vlc_player_input *input,
+                                    const struct vlc_input_event *event)
+{
+    vlc_player_t *player = input->player;
+
+    /* Only keep track of the preloading input, the listeners are told about
+     * it once it becomes the current one */
+    player->preload.muted = true;
+    switch (event->type)
+    {
+        case INPUT_EVENT_STATE:
+            if (event->state.value == ERROR_S)
+                input->error = VLC_PLAYER_ERROR_GENERIC;
+            break;
+        case INPUT_EVENT_CAPABILITIES:
+            input->capabilities = event->capabilities;
+            break;
+        case INPUT_EVENT_TIMES:
+            input->length = input_GetItemDuration(input->thread,
+                                                  event->times.length);
+            break;
+        case INPUT_EVENT_PROGRAM:
+            vlc_player_input_HandleProgramEvent(input, &event->program);
+            break;
+        case INPUT_EVENT_ES:
+            vlc_player_input_HandleEsEvent(input, &event->es);
+            break;
+        case INPUT_EVENT_TITLE:
+            vlc_player_input_HandleTitleEvent(input, &event->title);
+            break;
+        case INPUT_EVENT_CHAPTER:
+            vlc_player_input_HandleChapterEvent(input, &event->chapter);
+            break;
+        case INPUT_EVENT_DEAD:
+            if (input->titles)
+            {
+                vlc_player_title_list_Release(input->titles);
+                input->titles = NULL;
+            }
+            if (player->preload.input == input)
+            {
+                /* The next media will be opened again when needed */
+                player->preload.input = NULL;
+                input_resource_SetVoutLinger(player->resource, false);
+            }
+            vlc_player_destructor_AddJoinableInput(player, input);
+            break;
+        default:
+            break;
+    }
+    player->preload.muted = false;
+}
+
 static bool
 input_thread_Events(input_thread_t *input_thread,
                     const struct vlc_input_event *event, void *user_data)
@@ -885,6 +1000,13 @@ input_thread_Events(input_thread_t *input_thread,
     {
         if (event->output_clock.system_ts != VLC_TICK_INVALID)
         {
+            if (atomic_load_explicit(&input->gap.pending, memory_order_acquire)
+             && atomic_exchange(&input->gap.pending, false))
+                msg_Dbg(player, "gap at the media boundary: %"PRId64" ms%s",
+                        MS_FROM_VLC_TICK(event->output_clock.system_ts
+                                         - input->gap.start),
+                        input->gap.preloaded ? " (preloaded)" : "");
+
             const struct vlc_player_timer_point point = {
                 .position = 0,
                 .rate = event->output_clock.rate,
@@ -911,6 +1033,13 @@ input_thread_Events(input_thread_t *input_thread,
 
     vlc_mutex_lock(&player->lock);
 
+    if (input->preloading)
+    {
+        vlc_player_input_HandlePreloadEvent(input, event);
+        vlc_mutex_unlock(&player->lock);
+        return true;
+    }
+
     switch (event->type)
     {
         case INPUT_EVENT_STATE:
@@ -980,6 +1109,9 @@ input_thread_Events(input_thread_t *input_thread,
                 };
                 vlc_player_UpdateTimer(player, NULL, false, &point,
                                        input->normal_time, 0, 0, priv->i_start);
+
+                if (input == player->input)
+                    vlc_player_PreloadNextMedia(player);
             }
             break;
         }
@@ -1112,7 +1244,7 @@ vlc_player_input_GetSelectedTrackStringIds(struct vlc_player_input *input,
 }
 
 struct vlc_player_input *
-vlc_player_input_New(vlc_player_t *player, input_item_t *item)
+vlc_player_input_New(vlc_player_t *player, input_item_t *item, bool preload)
 {
     struct vlc_player_input *input = malloc(sizeof(*input));
     if (!input)
@@ -1121,6 +1253,10 @@ vlc_player_input_New(vlc_player_t *player, input_item_t *item)
     input->player = player;
     input->started = false;
     input->playing = false;
+    input->preloading = input->preloaded = preload;
+    input->gap.start = VLC_TICK_INVALID;
+    input->gap.preloaded = false;
+    atomic_init(&input->gap.pending, false);
 
     input->state = VLC_PLAYER_STATE_STOPPED;
     input->error = VLC_PLAYER_ERROR_NONE;
@@ -1177,6 +1313,7 @@ vlc_player_input_New(vlc_player_t *player, input_item_t *item)
         .renderer = player->renderer,
         .cbs = &cbs,
         .cbs_data = input,
+        .preload = preload,
     };
 
     input->thread = input_Create(player, item, &cfg);
@@ -1185,19 +1322,26 @@ vlc_player_input_New(vlc_player_t *player, input_item_t *item)
         free(input);
         return NULL;
     }
-    vlc_player_input_RestoreMlStates(input, false);
 
-    if (player->video_string_ids)
-        vlc_player_input_SelectTracksByStringIds(input, VIDEO_ES,
-                                                 player->video_string_ids);
+    /* The states of a preloaded input are restored, and the track string ids
+     * of the current media are not applied, when it becomes the current
+     * input */
+    if (!preload)
+    {
+        vlc_player_input_RestoreMlStates(input, false);
+
+        if (player->video_string_ids)
+            vlc_player_input_SelectTracksByStringIds(input, VIDEO_ES,
+                                                     player->video_string_ids);
 
-    if (player->audio_string_ids)
-        vlc_player_input_SelectTracksByStringIds(input, AUDIO_ES,
-                                                 player->audio_string_ids);
+        if (player->audio_string_ids)
+            vlc_player_input_SelectTracksByStringIds(input, AUDIO_ES,
+                                                     player->audio_string_ids);
 
-    if (player->sub_string_ids)
-        vlc_player_input_SelectTracksByStringIds(input, SPU_ES,
-                                                 player->sub_string_ids);
+        if (player->sub_string_ids)
+            vlc_player_input_SelectTracksByStringIds(input, SPU_ES,
+                                                     player->sub_string_ids);
+    }
 
     /* Initial sub/audio delay */
     const vlc_tick_t cat_delays[DATA_ES] = {
@@ -1213,7 +1357,7 @@ vlc_player_input_New(vlc_player_t *player, input_item_t *item)
         if (cat_delays[i] != 0)
         {
             int ret = input_SetEsCatDelay(input->thread, i, cat_delays[i]);
-            if (ret == VLC_SUCCESS)
+            if (ret == VLC_SUCCESS && !preload)
                 vlc_player_SendEvent(player, on_category_delay_changed, i,
                                      cat_delays[i]);
         }
@@ -52,6 +52,90 @@ static_assert(VLC_PLAYER_TITLE_MENU == INPUT_TITLE_MENU &&
 #define vlc_player_foreach_inputs(it) \
     for (struct vlc_player_input *it = player->input; it != NULL; it = NULL)
 
+static void
+vlc_player_CancelPreload(vlc_player_t *player)
+{
+    struct vlc_player_input *input = player->preload.input;
+    if (input == NULL)
+        return;
+
+    player->preload.input = NULL;
+    input_resource_SetVoutLinger(player->resource, false);
+
+    /* Interrupt its opening, the destructor thread deletes it once dead */
+    input_Stop(input->thread);
+    vlc_player_destructor_AddStoppingInput(player, input);
+}
+
+static struct vlc_player_input *
+vlc_player_TakePreload(vlc_player_t *player)
+{
+    struct vlc_player_input *input = player->preload.input;
+    if (input == NULL)
+        return NULL;
+
+    if (!player->started || input->error != VLC_PLAYER_ERROR_NONE
+     || input_GetItem(input->thread) != player->media)
+    {
+        vlc_player_CancelPreload(player);
+        return NULL;
+    }
+
+    /* The previous input released its outputs, the display is kept for this
+     * one if the video format did not change */
+    player->preload.input = NULL;
+    input_resource_SetVoutLinger(player->resource, false);
+
+    /* Its thread is already running, vlc_player_input_Start() releases it */
+    input->preloading = false;
+    input->started = true;
+    vlc_player_input_RestoreMlStates(input, false);
+    return input;
+}
+
+void
+vlc_player_PreloadNextMedia(vlc_player_t *player)
+{
+    struct vlc_player_input *input = player->input;
+    assert(input != NULL);
+
+    if (player->preload.delay == 0 || player->preload.tried
+     || player->preload.input != NULL || !player->started
+     || player->next_media == NULL || player->next_media == player->media
+     || player->renderer != NULL)
+        return;
+
+    if (input->live || input->length == VLC_TICK_INVALID
+     || input->time == VLC_TICK_INVALID
+     || input->length - input->time > player->preload.delay * input->rate)
+        return;
+
+    player->preload.tried = true;
+
+    /* A stream output can't be shared by two inputs */
+    char *sout = var_GetNonEmptyString(player, "sout");
+    if (sout != NULL)
+    {
+        free(sout);
+        return;
+    }
+
+    struct vlc_player_input *next =
+        vlc_player_input_New(player, player->next_media, true);
+    if (next == NULL)
+        return;
+
+    if (input_Start(next->thread) != VLC_SUCCESS)
+    {
+        vlc_player_input_Delete(next);
+        return;
+    }
+
+    msg_Dbg(player, "preloading the next media");
+    player->preload.input = next;
+    input_resource_SetVoutLinger(player->resource, true);
+}
+
 int
 vlc_player_OpenNextMedia(vlc_player_t *player)
 {
@@ -82,15 +166,27 @@ vlc_player_OpenNextMedia(vlc_player_t *player)
         player->media = player->next_media;
         player->next_media = NULL;
 
-        struct vlc_player_input *input = player->input =
-            vlc_player_input_New(player, player->media);
+        struct vlc_player_input *input = vlc_player_TakePreload(player);
+        if (!input)
+            input = vlc_player_input_New(player, player->media, false);
+        player->input = input;
         if (!input)
         {
             input_item_Release(player->media);
             player->media = NULL;
             ret = VLC_ENOMEM;
         }
+        else if (player->eos_date != VLC_TICK_INVALID)
+        {
+            input->gap.start = player->eos_date;
+            input->gap.preloaded = input->preloaded;
+            /* Publishes the gap to the input event thread */
+            atomic_store_explicit(&input->gap.pending, true,
+                                  memory_order_release);
+        }
     }
+    player->preload.tried = false;
+    player->eos_date = VLC_TICK_INVALID;
     vlc_player_SendEvent(player, on_current_media_changed, player->media);
     if (player->input && player->input->ml.delay_restore)
     {
@@ -219,6 +315,14 @@ vlc_player_destructor_Thread(void *data)
             !vlc_list_is_empty(&player->destructor.joinable_inputs);
         vlc_list_foreach(input, &player->destructor.joinable_inputs, node)
         {
+            if (input->preloading)
+            {
+                /* Cancelled or failed before being played */
+                vlc_list_remove(&input->node);
+                vlc_player_input_Delete(input);
+                continue;
+            }
+
             vlc_player_UpdateMLStates(player, input);
 
             keep_sout = var_GetBool(input->thread, "sout-keep");
@@ -998,6 +1102,7 @@ static void
 vlc_player_InvalidateNextMedia(vlc_player_t *player)
 {
     vlc_player_assert_locked(player);
+    vlc_player_CancelPreload(player);
     if (player->next_media)
     {
         input_item_Release(player->next_media);
@@ -1058,6 +1163,11 @@ vlc_player_SetNextMedia(vlc_player_t *player, input_item_t *media)
         input_item_Release(player->next_media);
 
     player->next_media = next_media;
+
+    if (player->preload.input != NULL
+     && input_GetItem(player->preload.input->thread) != next_media)
+        vlc_player_CancelPreload(player);
+    player->preload.tried = false;
 }
 
 input_item_t *
@@ -1196,7 +1306,7 @@ vlc_player_Start(vlc_player_t *player)
     if (!player->input)
     {
         /* Possible if the player was stopped by the user */
-        player->input = vlc_player_input_New(player, player->media);
+        player->input = vlc_player_input_New(player, player->media, false);
 
         if (!player->input)
             return VLC_ENOMEM;
@@ -1439,6 +1549,9 @@ vlc_player_SetRenderer(vlc_player_t *player, vlc_renderer_item_t *renderer)
         vlc_renderer_item_release(player->renderer);
     player->renderer = renderer ? vlc_renderer_item_hold(renderer) : NULL;
 
+    /* The next media is rendered by the new renderer */
+    vlc_player_CancelPreload(player);
+
     vlc_player_foreach_inputs(input)
     {
         vlc_value_t val = {
@@ -1944,6 +2057,7 @@ vlc_player_Delete(vlc_player_t *player)
         vlc_player_destructor_AddInput(player, player->input);
         player->input = NULL;
     }
+    vlc_player_CancelPreload(player);
 
     player->deleting = true;
     vlc_cond_signal(&player->destructor.wait);
@@ -2017,6 +2131,13 @@ vlc_player_New(vlc_object_t *parent, enum vlc_player_lock_type lock_type)
     player->releasing_media = false;
     player->next_media = NULL;
 
+    player->preload.input = NULL;
+    player->preload.delay =
+        VLC_TICK_FROM_MS(var_InheritInteger(player, "input-preload"));
+    player->preload.tried = false;
+    player->preload.muted = false;
+    player->eos_date = VLC_TICK_INVALID;
+
     player->video_string_ids = player->audio_string_ids =
     player->sub_string_ids = NULL;
 
@@ -60,6 +60,21 @@ struct vlc_player_input
     vlc_player_t *player;
     bool started;
 
+    /* Next media opened in advance, its events are not sent to the
+     * listeners (cf. vlc_player_PreloadNextMedia()) */
+    bool preloading;
+    /* Held before its decoders creation until vlc_player_input_Start() */
+    bool preloaded;
+
+    /* Time between the end of the previous media and the first output of
+     * this one */
+    struct
+    {
+        vlc_tick_t start;
+        bool preloaded;
+        atomic_bool pending;
+    } gap;
+
     /* Monitor the OPENING_S -> PLAYING_S transition. */
     bool playing;
 
@@ -263,6 +278,16 @@ struct vlc_player_t
     bool releasing_media;
     input_item_t *next_media;
 
+    struct
+    {
+        struct vlc_player_input *input;
+        vlc_tick_t delay; /* before the end of the current media */
+        bool tried; /* only once per media */
+        bool muted; /* listeners are not notified */
+    } preload;
+    /* End of the current media, to measure the gap with the next one */
+    vlc_tick_t eos_date;
+
     char *video_string_ids;
     char *audio_string_ids;
     char *sub_string_ids;
@@ -319,6 +344,8 @@ vlc_player_get_input_locked(vlc_player_t *player)
 
 #define vlc_player_SendEvent(player, event, ...) do { \
     vlc_player_listener_id *listener; \
+    if (player->preload.muted) \
+        break; \
     vlc_list_foreach(listener, &player->listeners, node) \
     { \
         if (listener->cbs->event) \
@@ -348,6 +375,9 @@ vlc_player_GetObject(vlc_player_t *player);
 int
 vlc_player_OpenNextMedia(vlc_player_t *player);
 
+void
+vlc_player_PreloadNextMedia(vlc_player_t *player);
+
 void
 vlc_player_destructor_AddStoppingInput(vlc_player_t *player,
                                        struct vlc_player_input *input);
@@ -422,7 +452,7 @@ vlc_player_input_FindTrackById(struct vlc_player_input *input, vlc_es_id_t *id,
                                size_t *idx);
 
 struct vlc_player_input *
-vlc_player_input_New(vlc_player_t *player, input_item_t *item);
+vlc_player_input_New(vlc_player_t *player, input_item_t *item, bool preload);
 
 void
 vlc_player_input_Delete(struct vlc_player_input *input);
@@ -25,6 +25,7 @@
 #include "content.h"
 
 #include "control.h"
+#include "index.h"
 #include "item.h"
 #include "notify.h"
 #include "playlist.h"
@@ -37,6 +38,25 @@ vlc_playlist_ClearItems(vlc_playlist_t *playlist)
     vlc_vector_foreach(item, &playlist->items)
         vlc_playlist_item_Release(item);
     vlc_vector_clear(&playlist->items);
+    vlc_playlist_index_Clear(&playlist->index);
+}
+
+void
+vlc_playlist_UpdateIndexes(vlc_playlist_t *playlist, size_t from, size_t to)
+{
+    assert(to <= playlist->items.size);
+    for (size_t i = from; i < to; ++i)
+        playlist->items.data[i]->index = i;
+}
+
+static void
+vlc_playlist_IndexItems(vlc_playlist_t *playlist, size_t index, size_t count)
+{
+    for (size_t i = index; i < index + count; ++i)
+        vlc_playlist_index_Add(&playlist->index, playlist->items.data[i]);
+
+    /* the following items are shifted */
+    vlc_playlist_UpdateIndexes(playlist, index, playlist->items.size);
 }
 
 static void
@@ -200,9 +220,11 @@ vlc_playlist_IndexOf(vlc_playlist_t *playlist, const vlc_playlist_item_t *item)
 {
     vlc_playlist_AssertLocked(playlist);
 
-    ssize_t index;
-    vlc_vector_index_of(&playlist->items, item, &index);
-    return index;
+    /* the item may have been removed, its position is then outdated */
+    size_t index = item->index;
+    if (index < playlist->items.size && playlist->items.data[index] == item)
+        return index;
+    return -1;
 }
 
 ssize_t
@@ -210,11 +232,9 @@ vlc_playlist_IndexOfMedia(vlc_playlist_t *playlist, const input_item_t *media)
 {
     vlc_playlist_AssertLocked(playlist);
 
-    playlist_item_vector_t *items = &playlist->items;
-    for (size_t i = 0; i < items->size; ++i)
-        if (items->data[i]->media == media)
-            return i;
-    return -1;
+    vlc_playlist_item_t *item =
+        vlc_playlist_index_FindMedia(&playlist->index, media);
+    return item ? (ssize_t) item->index : -1;
 }
 
 ssize_t
@@ -222,11 +242,8 @@ vlc_playlist_IndexOfId(vlc_playlist_t *playlist, uint64_t id)
 {
     vlc_playlist_AssertLocked(playlist);
 
-    playlist_item_vector_t *items = &playlist->items;
-    for (size_t i = 0; i < items->size; ++i)
-        if (items->data[i]->id == id)
-            return i;
-    return -1;
+    vlc_playlist_item_t *item = vlc_playlist_index_FindId(&playlist->index, id);
+    return item ? (ssize_t) item->index : -1;
 }
 
 void
@@ -274,6 +291,10 @@ vlc_playlist_Insert(vlc_playlist_t *playlist, size_t index,
     vlc_playlist_AssertLocked(playlist);
     assert(index <= playlist->items.size);
 
+    if (!vlc_playlist_index_Reserve(&playlist->index,
+                                    playlist->items.size + count))
+        return VLC_ENOMEM;
+
     /* make space in the vector */
     if (!vlc_vector_insert_hole(&playlist->items, index, count))
         return VLC_ENOMEM;
@@ -288,6 +309,7 @@ vlc_playlist_Insert(vlc_playlist_t *playlist, size_t index,
         return ret;
     }
 
+    vlc_playlist_IndexItems(playlist, index, count);
     vlc_playlist_ItemsInserted(playlist, index, count, true);
     vlc_playlist_UpdateNextMedia(playlist);
 
@@ -303,6 +325,8 @@ vlc_playlist_Move(vlc_playlist_t *playlist, size_t index, size_t count,
     assert(target + count <= playlist->items.size);
 
     vlc_vector_move_slice(&playlist->items, index, count, target);
+    vlc_playlist_UpdateIndexes(playlist, __MIN(index, target),
+                               __MAX(index, target) + count);
 
     vlc_playlist_ItemsMoved(playlist, index, count, target);
     vlc_playlist_UpdateNextMedia(playlist);
@@ -322,10 +346,12 @@ vlc_playlist_Remove(vlc_playlist_t *playlist, size_t index, size_t count)
                 && item->preparser_id != VLC_PREPARSER_REQ_ID_INVALID)
             vlc_preparser_Cancel(playlist->parser, item->preparser_id);
 
+        vlc_playlist_index_Remove(&playlist->index, item);
         vlc_playlist_item_Release(item);
     }
 
     vlc_vector_remove_slice(&playlist->items, index, count);
+    vlc_playlist_UpdateIndexes(playlist, index, playlist->items.size);
 
     bool current_media_changed = vlc_playlist_ItemsRemoved(playlist, index,
                                                            count);
@@ -358,8 +384,11 @@ vlc_playlist_Replace(vlc_playlist_t *playlist, size_t index,
     if (playlist->parser != NULL
             && old->preparser_id != VLC_PREPARSER_REQ_ID_INVALID)
         vlc_preparser_Cancel(playlist->parser, old->preparser_id);
+    vlc_playlist_index_Remove(&playlist->index, old);
     vlc_playlist_item_Release(old);
     playlist->items.data[index] = item;
+    item->index = index;
+    vlc_playlist_index_Add(&playlist->index, item);
 
     vlc_playlist_ItemReplaced(playlist, index);
     return VLC_SUCCESS;
@@ -382,6 +411,10 @@ vlc_playlist_Expand(vlc_playlist_t *playlist, size_t index,
 
         if (count > 1)
         {
+            if (!vlc_playlist_index_Reserve(&playlist->index,
+                                            playlist->items.size + count - 1))
+                return VLC_ENOMEM;
+
             /* make space in the vector */
             if (!vlc_vector_insert_hole(&playlist->items, index + 1, count - 1))
                 return VLC_ENOMEM;
@@ -395,6 +428,7 @@ vlc_playlist_Expand(vlc_playlist_t *playlist, size_t index,
                 vlc_vector_remove_slice(&playlist->items, index + 1, count - 1);
                 return ret;
             }
+            vlc_playlist_IndexItems(playlist, index + 1, count - 1);
             vlc_playlist_ItemsInserted(playlist, index + 1, count - 1, false);
         }
 
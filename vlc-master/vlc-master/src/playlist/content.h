@@ -28,6 +28,11 @@ typedef struct input_item_t input_item_t;
 void
 vlc_playlist_ClearItems(vlc_playlist_t *playlist);
 
+/* update the positions stored in the items [from, to), to be called after the
+ * items have been reordered in place */
+void
+vlc_playlist_UpdateIndexes(vlc_playlist_t *playlist, size_t from, size_t to);
+
 /* expand an item (replace it by the given media array) */
 int
 vlc_playlist_Expand(vlc_playlist_t *playlist, size_t index,
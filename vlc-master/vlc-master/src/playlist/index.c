@@ -0,0 +1,195 @@
+/*****************************************************************************
+ * playlist/index.c
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "index.h"
+
+#include "item.h"
+
+/* Fibonacci hashing, the high bits of the product are the best mixed */
+static inline size_t
+HashKey(uint64_t key, unsigned bits)
+{
+    return (key * UINT64_C(0x9e3779b97f4a7c15)) >> (64 - bits);
+}
+
+static inline size_t
+HashId(uint64_t id, unsigned bits)
+{
+    return HashKey(id, bits);
+}
+
+static inline size_t
+HashMedia(const input_item_t *media, unsigned bits)
+{
+    return HashKey((uintptr_t) media, bits);
+}
+
+static void
+Link(vlc_playlist_item_t **ids, vlc_playlist_item_t **medias, unsigned bits,
+     vlc_playlist_item_t *item)
+{
+    vlc_playlist_item_t **id_head = &ids[HashId(item->id, bits)];
+    item->id_next = *id_head;
+    *id_head = item;
+
+    vlc_playlist_item_t **media_head = &medias[HashMedia(item->media, bits)];
+    item->media_next = *media_head;
+    *media_head = item;
+}
+
+void
+vlc_playlist_index_Init(struct vlc_playlist_index *index)
+{
+    index->ids = NULL;
+    index->medias = NULL;
+    index->bits = 0;
+    index->count = 0;
+}
+
+void
+vlc_playlist_index_Destroy(struct vlc_playlist_index *index)
+{
+    free(index->ids);
+    free(index->medias);
+}
+
+bool
+vlc_playlist_index_Reserve(struct vlc_playlist_index *index, size_t count)
+{
+    /* keep a load factor of at most 1 */
+    if (index->ids && count <= ((size_t) 1 << index->bits))
+        return true;
+
+    unsigned bits = __MAX(index->bits, 4);
+    while (((size_t) 1 << bits) < count)
+        bits++;
+    if (unlikely(bits >= sizeof(size_t) * 8))
+        return false;
+
+    size_t size = (size_t) 1 << bits;
+    vlc_playlist_item_t **ids = calloc(size, sizeof(*ids));
+    vlc_playlist_item_t **medias = calloc(size, sizeof(*medias));
+    if (unlikely(!ids || !medias))
+    {
+        free(ids);
+        free(medias);
+        return false;
+    }
+
+    /* rehash from the id chains, every item is in exactly one of them */
+    if (index->ids)
+    {
+        size_t old_size = (size_t) 1 << index->bits;
+        for (size_t i = 0; i < old_size; ++i)
+        {
+            vlc_playlist_item_t *item = index->ids[i];
+            while (item)
+            {
+                vlc_playlist_item_t *next = item->id_next;
+                Link(ids, medias, bits, item);
+                item = next;
+            }
+        }
+    }
+
+    free(index->ids);
+    free(index->medias);
+    index->ids = ids;
+    index->medias = medias;
+    index->bits = bits;
+    return true;
+}
+
+void
+vlc_playlist_index_Add(struct vlc_playlist_index *index,
+                       vlc_playlist_item_t *item)
+{
+    assert(index->ids);
+    Link(index->ids, index->medias, index->bits, item);
+    index->count++;
+}
+
+void
+vlc_playlist_index_Remove(struct vlc_playlist_index *index,
+                          vlc_playlist_item_t *item)
+{
+    vlc_playlist_item_t **pp = &index->ids[HashId(item->id, index->bits)];
+    while (*pp != item)
+    {
+        assert(*pp);
+        pp = &(*pp)->id_next;
+    }
+    *pp = item->id_next;
+
+    pp = &index->medias[HashMedia(item->media, index->bits)];
+    while (*pp != item)
+    {
+        assert(*pp);
+        pp = &(*pp)->media_next;
+    }
+    *pp = item->media_next;
+
+    assert(index->count > 0);
+    index->count--;
+}
+
+void
+vlc_playlist_index_Clear(struct vlc_playlist_index *index)
+{
+    if (index->ids)
+    {
+        size_t size = (size_t) 1 << index->bits;
+        memset(index->ids, 0, size * sizeof(*index->ids));
+        memset(index->medias, 0, size * sizeof(*index->medias));
+    }
+    index->count = 0;
+}
+
+vlc_playlist_item_t *
+vlc_playlist_index_FindId(struct vlc_playlist_index *index, uint64_t id)
+{
+    if (!index->ids)
+        return NULL;
+
+    vlc_playlist_item_t *item = index->ids[HashId(id, index->bits)];
+    while (item && item->id != id)
+        item = item->id_next;
+    return item;
+}
+
+vlc_playlist_item_t *
+vlc_playlist_index_FindMedia(struct vlc_playlist_index *index,
+                             const input_item_t *media)
+{
+    if (!index->medias)
+        return NULL;
+
+    /* the same media may be inserted several times */
+    vlc_playlist_item_t *found = NULL;
+    vlc_playlist_item_t *item = index->medias[HashMedia(media, index->bits)];
+    for (; item; item = item->media_next)
+        if (item->media == media && (!found || item->index < found->index))
+            found = item;
+    return found;
+}
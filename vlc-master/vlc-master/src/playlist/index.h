@@ -0,0 +1,82 @@
+/*****************************************************************************
+ * playlist/index.h
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_PLAYLIST_INDEX_H
+#define VLC_PLAYLIST_INDEX_H
+
+#include <vlc_common.h>
+
+typedef struct vlc_playlist_item vlc_playlist_item_t;
+typedef struct input_item_t input_item_t;
+
+/**
+ * Hash tables to find the playlist items from their id or their media.
+ *
+ * The items are chained in the buckets through their own fields, and store
+ * their position in the playlist, so that the lookups do not depend on the
+ * playlist size.
+ */
+struct vlc_playlist_index
+{
+    vlc_playlist_item_t **ids;
+    vlc_playlist_item_t **medias;
+    unsigned bits; /* log2 of the number of buckets */
+    size_t count;
+};
+
+void
+vlc_playlist_index_Init(struct vlc_playlist_index *index);
+
+void
+vlc_playlist_index_Destroy(struct vlc_playlist_index *index);
+
+/**
+ * Grow the tables for the given number of items.
+ *
+ * Must succeed before adding items, so that adding cannot fail.
+ */
+bool
+vlc_playlist_index_Reserve(struct vlc_playlist_index *index, size_t count);
+
+void
+vlc_playlist_index_Add(struct vlc_playlist_index *index,
+                       vlc_playlist_item_t *item);
+
+void
+vlc_playlist_index_Remove(struct vlc_playlist_index *index,
+                          vlc_playlist_item_t *item);
+
+/**
+ * Remove all the items (the memory is kept).
+ */
+void
+vlc_playlist_index_Clear(struct vlc_playlist_index *index);
+
+vlc_playlist_item_t *
+vlc_playlist_index_FindId(struct vlc_playlist_index *index, uint64_t id);
+
+/**
+ * Find the first item (with the lowest position) of the given media.
+ */
+vlc_playlist_item_t *
+vlc_playlist_index_FindMedia(struct vlc_playlist_index *index,
+                             const input_item_t *media);
+
+#endif
@@ -33,6 +33,11 @@ struct vlc_playlist_item
     uint64_t id;
     vlc_preparser_req_id preparser_id;
     vlc_atomic_rc_t rc;
+
+    /* maintained by the playlist index, see index.h */
+    size_t index; /* position in the playlist */
+    vlc_playlist_item_t *id_next;
+    vlc_playlist_item_t *media_next;
 };
 
 /* _New() is private, it is called when inserting new media in the playlist */
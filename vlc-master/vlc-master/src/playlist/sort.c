@@ -23,27 +23,43 @@
 #endif
 
 #include <vlc_common.h>
+#include <vlc_executor.h>
 #include <vlc_rand.h>
 #include <vlc_sort.h>
 #include <vlc_strings.h>
+
+#include <ctype.h>
+#include "content.h"
 #include "control.h"
 #include "item.h"
 #include "notify.h"
 #include "playlist.h"
 
+/* Below this number of items, the sort is not worth the worker threads */
+#define PARALLEL_SORT_THRESHOLD 16384
+#define PARALLEL_SORT_MAX_WORKERS 16
+
 /**
  * Struct containing a copy of (parsed) media metadata, used for sorting
  * without locking all the items.
+ *
+ * The strings are stored as keys, computed once per item, so that comparing
+ * two items does not transform them again:
+ *  - the strings compared case-insensitively are stored lowercase;
+ *  - the strings compared with vlc_filenamecmp() are stored along with their
+ *    collation key (from strxfrm()).
  */
 struct vlc_playlist_item_meta {
     vlc_playlist_item_t *item;
     size_t index;
     const char *title_or_name;
+    const char *title_or_name_key;
     vlc_tick_t duration;
-    const char *artist;
+    const char *artist; /* lowercase */
     const char *album;
-    const char *album_artist;
-    const char *genre;
+    const char *album_key;
+    const char *album_artist; /* lowercase */
+    const char *genre; /* lowercase */
     const char *url;
     int64_t date;
     int64_t track_number;
@@ -71,6 +87,38 @@ vlc_playlist_item_meta_CopyString(const char **to, const char *from)
     return VLC_SUCCESS;
 }
 
+static int
+vlc_playlist_item_meta_CopyLowercase(const char **to, const char *from)
+{
+    int ret = vlc_playlist_item_meta_CopyString(to, from);
+    if (ret == VLC_SUCCESS && *to)
+        for (char *p = (char *) *to; *p; ++p)
+            *p = tolower((unsigned char) *p);
+    return ret;
+}
+
+/* copy the string and its collation key, so that strcoll(a, b) becomes
+ * strcmp(key_a, key_b) */
+static int
+vlc_playlist_item_meta_CopyCollated(const char **to, const char **key,
+                                    const char *from)
+{
+    int ret = vlc_playlist_item_meta_CopyString(to, from);
+    if (ret != VLC_SUCCESS || !from)
+    {
+        *key = NULL;
+        return ret;
+    }
+
+    size_t len = strxfrm(NULL, from, 0);
+    char *buf = malloc(len + 1);
+    if (unlikely(!buf))
+        return VLC_ENOMEM;
+    strxfrm(buf, from, len + 1);
+    *key = buf;
+    return VLC_SUCCESS;
+}
+
 static int
 vlc_playlist_item_meta_GetNumber(const char * str, int64_t * to)
 {
@@ -106,8 +154,9 @@ vlc_playlist_item_meta_InitField(struct vlc_playlist_item_meta *meta,
             const char *value = input_item_GetMetaLocked(media, vlc_meta_Title);
             if (EMPTY_STR(value))
                 value = media->psz_name;
-            return vlc_playlist_item_meta_CopyString(&meta->title_or_name,
-                                                     value);
+            return vlc_playlist_item_meta_CopyCollated(&meta->title_or_name,
+                                                       &meta->title_or_name_key,
+                                                       value);
         }
         case VLC_PLAYLIST_SORT_KEY_DURATION:
         {
@@ -122,24 +171,25 @@ vlc_playlist_item_meta_InitField(struct vlc_playlist_item_meta *meta,
         {
             const char *value = input_item_GetMetaLocked(media,
                                                          vlc_meta_Artist);
-            return vlc_playlist_item_meta_CopyString(&meta->artist, value);
+            return vlc_playlist_item_meta_CopyLowercase(&meta->artist, value);
         }
         case VLC_PLAYLIST_SORT_KEY_ALBUM:
         {
             const char *value = input_item_GetMetaLocked(media, vlc_meta_Album);
-            return vlc_playlist_item_meta_CopyString(&meta->album, value);
+            return vlc_playlist_item_meta_CopyCollated(&meta->album,
+                                                       &meta->album_key, value);
         }
         case VLC_PLAYLIST_SORT_KEY_ALBUM_ARTIST:
         {
             const char *value = input_item_GetMetaLocked(media,
                                                          vlc_meta_AlbumArtist);
-            return vlc_playlist_item_meta_CopyString(&meta->album_artist,
-                                                     value);
+            return vlc_playlist_item_meta_CopyLowercase(&meta->album_artist,
+                                                        value);
         }
         case VLC_PLAYLIST_SORT_KEY_GENRE:
         {
             const char *value = input_item_GetMetaLocked(media, vlc_meta_Genre);
-            return vlc_playlist_item_meta_CopyString(&meta->genre, value);
+            return vlc_playlist_item_meta_CopyLowercase(&meta->genre, value);
         }
         case VLC_PLAYLIST_SORT_KEY_DATE:
         {
@@ -216,8 +266,10 @@ static void
 vlc_playlist_item_meta_DestroyFields(struct vlc_playlist_item_meta *meta)
 {
     free((void *) meta->title_or_name);
+    free((void *) meta->title_or_name_key);
     free((void *) meta->artist);
     free((void *) meta->album);
+    free((void *) meta->album_key);
     free((void *) meta->album_artist);
     free((void *) meta->genre);
     free((void *) meta->url);
@@ -232,24 +284,19 @@ vlc_playlist_item_meta_InitFields(struct vlc_playlist_item_meta *meta,
         const struct vlc_playlist_sort_criterion *criterion = &criteria[i];
         int ret = vlc_playlist_item_meta_InitField(meta, criterion->key);
         if (unlikely(ret != VLC_SUCCESS))
-        {
-            vlc_playlist_item_meta_DestroyFields(meta);
+            /* the fields are destroyed by the caller */
             return ret;
-        }
     }
     return VLC_SUCCESS;
 }
 
-static struct vlc_playlist_item_meta *
-vlc_playlist_item_meta_New(size_t index, vlc_playlist_item_t *item,
-                           const struct vlc_playlist_sort_criterion criteria[],
-                           size_t count)
+/* the meta must be zeroed (assume that NULL representation is all-zeros) */
+static int
+vlc_playlist_item_meta_Init(struct vlc_playlist_item_meta *meta, size_t index,
+                            vlc_playlist_item_t *item,
+                            const struct vlc_playlist_sort_criterion criteria[],
+                            size_t count)
 {
-    /* assume that NULL representation is all-zeros */
-    struct vlc_playlist_item_meta *meta = calloc(1, sizeof(*meta));
-    if (unlikely(!meta))
-        return NULL;
-
     meta->item = item;
     meta->index = index;
 
@@ -257,40 +304,47 @@ vlc_playlist_item_meta_New(size_t index, vlc_playlist_item_t *item,
     int ret = vlc_playlist_item_meta_InitFields(meta, criteria, count);
     vlc_mutex_unlock(&item->media->lock);
 
-    if (unlikely(ret != VLC_SUCCESS))
-    {
-        free(meta);
-        return NULL;
-    }
-
-    return meta;
-}
-
-static void
-vlc_playlist_item_meta_Delete(struct vlc_playlist_item_meta *meta)
-{
-    vlc_playlist_item_meta_DestroyFields(meta);
-    free(meta);
+    return ret;
 }
 
+/* the strings have been lowercased, this is strcasecmp() */
 static inline int
 CompareStrings(const char *a, const char *b)
 {
     if (a && b)
-        return strcasecmp(a, b);
+        return strcmp(a, b);
     if (!a && !b)
         return 0;
     return a ? 1 : -1;
 }
 
+/* vlc_filenamecmp(), using the precomputed collation keys */
 static inline int
-CompareFilenameStrings(const char *a, const char *b)
+CompareFilenameStrings(const char *a, const char *key_a,
+                       const char *b, const char *key_b)
 {
-    if (a && b)
-        return vlc_filenamecmp(a, b);
-    if (!a && !b)
-        return 0;
-    return a ? 1 : -1;
+    if (!a || !b)
+    {
+        if (!a && !b)
+            return 0;
+        return a ? 1 : -1;
+    }
+
+    size_t i;
+    char ca, cb;
+    for (i = 0; (ca = a[i]) == (cb = b[i]); i++)
+        if (ca == '\0')
+            return 0;
+
+    if ((unsigned)(ca - '0') > 9 || (unsigned)(cb - '0') > 9)
+        return strcmp(key_a, key_b);
+
+    unsigned long long ua = strtoull(a + i, NULL, 10);
+    unsigned long long ub = strtoull(b + i, NULL, 10);
+    if (ua == ub)
+        return strcmp(key_a, key_b);
+
+    return (ua > ub) ? +1 : -1;
 }
 
 static inline int
@@ -333,13 +387,17 @@ CompareMetaByKey(const struct vlc_playlist_item_meta *a,
     switch (key)
     {
         case VLC_PLAYLIST_SORT_KEY_TITLE:
-            return CompareFilenameStrings(a->title_or_name, b->title_or_name);
+            return CompareFilenameStrings(a->title_or_name,
+                                          a->title_or_name_key,
+                                          b->title_or_name,
+                                          b->title_or_name_key);
         case VLC_PLAYLIST_SORT_KEY_DURATION:
             return CompareIntegers(a->duration, b->duration);
         case VLC_PLAYLIST_SORT_KEY_ARTIST:
             return CompareStrings(a->artist, b->artist);
         case VLC_PLAYLIST_SORT_KEY_ALBUM:
-            return CompareFilenameStrings(a->album, b->album);
+            return CompareFilenameStrings(a->album, a->album_key,
+                                          b->album, b->album_key);
         case VLC_PLAYLIST_SORT_KEY_ALBUM_ARTIST:
             return CompareStrings(a->album_artist, b->album_artist);
         case VLC_PLAYLIST_SORT_KEY_GENRE:
@@ -403,42 +461,143 @@ compare_meta(const void *lhs, const void *rhs, void *userdata)
     return a->index < b->index ? -1 : 1;
 }
 
+struct sort_context
+{
+    vlc_playlist_t *playlist;
+    struct sort_request req;
+    struct vlc_playlist_item_meta *metas;
+    struct vlc_playlist_item_meta **array;
+    struct vlc_playlist_item_meta **tmp;
+};
+
+/* a slice of the playlist, handled by one worker thread */
+struct sort_worker
+{
+    struct vlc_runnable runnable;
+    void (*run)(struct sort_worker *);
+    struct sort_context *ctx;
+    size_t begin;
+    size_t mid; /* merge only */
+    size_t end;
+    int ret;
+    vlc_latch_t *done;
+};
+
 static void
-vlc_playlist_DeleteMetaArray(struct vlc_playlist_item_meta *array[],
-                             size_t count)
+RunInitMetas(struct sort_worker *worker)
 {
-    for (size_t i = 0; i < count; ++i)
-        vlc_playlist_item_meta_Delete(array[i]);
-    free(array);
+    struct sort_context *ctx = worker->ctx;
+
+    for (size_t i = worker->begin; i < worker->end; ++i)
+    {
+        int ret = vlc_playlist_item_meta_Init(&ctx->metas[i], i,
+                                              ctx->playlist->items.data[i],
+                                              ctx->req.criteria,
+                                              ctx->req.count);
+        if (unlikely(ret != VLC_SUCCESS))
+        {
+            worker->ret = ret;
+            break;
+        }
+        ctx->array[i] = &ctx->metas[i];
+    }
 }
 
-static struct vlc_playlist_item_meta **
-vlc_playlist_NewMetaArray(vlc_playlist_t *playlist,
-        const struct vlc_playlist_sort_criterion criteria[], size_t count)
+static void
+RunSort(struct sort_worker *worker)
 {
-    struct vlc_playlist_item_meta **array =
-            vlc_alloc(playlist->items.size, sizeof(*array));
+    struct sort_context *ctx = worker->ctx;
 
-    if (unlikely(!array))
-        return NULL;
+    vlc_qsort(&ctx->array[worker->begin], worker->end - worker->begin,
+              sizeof(*ctx->array), compare_meta, &ctx->req);
+}
 
-    size_t i;
-    for (i = 0; i < playlist->items.size; ++i)
+static void
+RunMerge(struct sort_worker *worker)
+{
+    struct sort_context *ctx = worker->ctx;
+    struct vlc_playlist_item_meta **src = ctx->array;
+    struct vlc_playlist_item_meta **dst = ctx->tmp;
+
+    size_t i = worker->begin;
+    size_t j = worker->mid;
+    size_t k = worker->begin;
+    while (i < worker->mid && j < worker->end)
     {
-        array[i] = vlc_playlist_item_meta_New(i, playlist->items.data[i],
-                                              criteria, count);
-        if (unlikely(!array[i]))
-            break;
+        /* the comparison never returns 0, the merge is stable anyway */
+        if (compare_meta(&src[j], &src[i], &ctx->req) < 0)
+            dst[k++] = src[j++];
+        else
+            dst[k++] = src[i++];
     }
+    while (i < worker->mid)
+        dst[k++] = src[i++];
+    while (j < worker->end)
+        dst[k++] = src[j++];
+}
+
+static void
+RunWorker(void *userdata)
+{
+    struct sort_worker *worker = userdata;
+    worker->run(worker);
+    vlc_latch_count_down(worker->done, 1);
+}
 
-    if (i < playlist->items.size)
+/* run the workers, the first one on the calling thread */
+static void
+RunWorkers(vlc_executor_t *executor, struct sort_worker workers[],
+           size_t count, void (*run)(struct sort_worker *))
+{
+    vlc_latch_t done;
+    vlc_latch_init(&done, count);
+
+    for (size_t i = 0; i < count; ++i)
     {
-        /* allocation failure */
-        vlc_playlist_DeleteMetaArray(array, i);
-        return NULL;
+        workers[i].run = run;
+        workers[i].done = &done;
+        workers[i].runnable.run = RunWorker;
+        workers[i].runnable.userdata = &workers[i];
     }
 
-    return array;
+    for (size_t i = 1; i < count; ++i)
+        vlc_executor_Submit(executor, &workers[i].runnable);
+    RunWorker(&workers[0]);
+    vlc_latch_wait(&done);
+}
+
+/* sort the array by slices in parallel, then merge the slices pairwise */
+static void
+vlc_playlist_ParallelSort(vlc_executor_t *executor, struct sort_context *ctx,
+                          const size_t bounds[], size_t count)
+{
+    struct sort_worker workers[PARALLEL_SORT_MAX_WORKERS];
+
+    for (size_t i = 0; i < count; ++i)
+        workers[i] = (struct sort_worker) {
+            .ctx = ctx, .begin = bounds[i], .end = bounds[i + 1],
+        };
+    RunWorkers(executor, workers, count, RunSort);
+
+    for (size_t width = 1; width < count; width *= 2)
+    {
+        size_t merges = 0;
+        for (size_t i = 0; i < count; i += 2 * width)
+        {
+            assert(i + width < count); /* count is a power of 2 */
+            workers[merges++] = (struct sort_worker) {
+                .ctx = ctx,
+                .begin = bounds[i],
+                .mid = bounds[i + width],
+                .end = bounds[i + 2 * width],
+            };
+        }
+        RunWorkers(executor, workers, merges, RunMerge);
+
+        struct vlc_playlist_item_meta **array = ctx->array;
+        ctx->array = ctx->tmp;
+        ctx->tmp = array;
+    }
 }
 
 int
@@ -453,20 +612,81 @@ vlc_playlist_Sort(vlc_playlist_t *playlist,
                                  ? playlist->items.data[playlist->current]
                                  : NULL;
 
-    struct vlc_playlist_item_meta **array =
-        vlc_playlist_NewMetaArray(playlist, criteria, count);
-    if (unlikely(!array))
-        return VLC_ENOMEM;
+    const size_t size = playlist->items.size;
+    struct sort_context ctx = {
+        .playlist = playlist,
+        .req = { criteria, count },
+    };
 
-    struct sort_request req = { criteria, count };
+    /* use a power of 2 of workers, so that the slices merge pairwise */
+    size_t workers = 1;
+    vlc_executor_t *executor = NULL;
+    if (size >= PARALLEL_SORT_THRESHOLD)
+    {
+        unsigned cpus = __MIN(vlc_GetCPUCount(), PARALLEL_SORT_MAX_WORKERS);
+        while (workers * 2 <= cpus)
+            workers *= 2;
+        if (workers > 1)
+        {
+            executor = vlc_executor_New(workers - 1);
+            if (!executor)
+                workers = 1;
+        }
+    }
+
+    int ret = VLC_ENOMEM;
+    ctx.metas = calloc(size, sizeof(*ctx.metas));
+    ctx.array = vlc_alloc(size, sizeof(*ctx.array));
+    if (workers > 1)
+        ctx.tmp = vlc_alloc(size, sizeof(*ctx.tmp));
+    if (unlikely(!ctx.metas || !ctx.array || (workers > 1 && !ctx.tmp)))
+        goto end;
+
+    size_t bounds[PARALLEL_SORT_MAX_WORKERS + 1];
+    struct sort_worker init[PARALLEL_SORT_MAX_WORKERS];
+    for (size_t i = 0; i <= workers; ++i)
+        bounds[i] = size * i / workers;
+
+    /* reading the metadata locks every media, this is done in parallel too */
+    for (size_t i = 0; i < workers; ++i)
+        init[i] = (struct sort_worker) {
+            .ctx = &ctx, .begin = bounds[i], .end = bounds[i + 1],
+            .ret = VLC_SUCCESS,
+        };
+    if (workers > 1)
+        RunWorkers(executor, init, workers, RunInitMetas);
+    else
+        RunInitMetas(&init[0]);
 
-    vlc_qsort(array, playlist->items.size, sizeof(*array), compare_meta, &req);
+    for (size_t i = 0; i < workers; ++i)
+        if (unlikely(init[i].ret != VLC_SUCCESS))
+            goto end;
+
+    if (workers > 1)
+        vlc_playlist_ParallelSort(executor, &ctx, bounds, workers);
+    else
+        vlc_qsort(ctx.array, size, sizeof(*ctx.array), compare_meta, &ctx.req);
 
     /* apply the sorting result to the playlist */
-    for (size_t i = 0; i < playlist->items.size; ++i)
-        playlist->items.data[i] = array[i]->item;
+    for (size_t i = 0; i < size; ++i)
+        playlist->items.data[i] = ctx.array[i]->item;
+    vlc_playlist_UpdateIndexes(playlist, 0, size);
+    ret = VLC_SUCCESS;
+
+end:
+    if (ctx.metas)
+    {
+        for (size_t i = 0; i < size; ++i)
+            vlc_playlist_item_meta_DestroyFields(&ctx.metas[i]);
+        free(ctx.metas);
+    }
+    free(ctx.array);
+    free(ctx.tmp);
+    if (executor)
+        vlc_executor_Delete(executor);
 
-    vlc_playlist_DeleteMetaArray(array, playlist->items.size);
+    if (ret != VLC_SUCCESS)
+        return ret;
 
     struct vlc_playlist_state state;
     if (current)
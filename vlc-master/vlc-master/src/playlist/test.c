@@ -25,6 +25,9 @@
 #endif
 
 #include <stdio.h>
+#include <vlc_common.h>
+#include <vlc_strings.h>
+#include "content.h"
 #include "item.h"
 #include "playlist.h"
 #include "preparse.h"
@@ -1061,10 +1064,142 @@ test_index_of(void)
     assert(vlc_playlist_IndexOf(playlist, item) == -1);
     vlc_playlist_item_Release(item);
 
+    /* the first occurrence of a media is returned */
+    ret = vlc_playlist_Append(playlist, &media[2], 1);
+    assert(ret == VLC_SUCCESS);
+    assert(vlc_playlist_IndexOfMedia(playlist, media[2]) == 2);
+    vlc_playlist_RemoveOne(playlist, 2);
+    assert(vlc_playlist_IndexOfMedia(playlist, media[2]) == 7);
+
+    item = vlc_playlist_Get(playlist, 5);
+    assert(vlc_playlist_IndexOfId(playlist, item->id) == 5);
+    assert(vlc_playlist_IndexOfId(playlist, playlist->idgen) == -1);
+
     DestroyMediaArray(media, 10);
     vlc_playlist_Delete(playlist);
 }
 
+static void
+CheckIndex(vlc_playlist_t *playlist)
+{
+    for (size_t i = 0; i < playlist->items.size; ++i)
+    {
+        vlc_playlist_item_t *item = playlist->items.data[i];
+        assert(vlc_playlist_IndexOf(playlist, item) == (ssize_t) i);
+        assert(vlc_playlist_IndexOfId(playlist, item->id) == (ssize_t) i);
+
+        ssize_t first;
+        for (first = 0; playlist->items.data[first]->media != item->media;
+             ++first);
+        assert(vlc_playlist_IndexOfMedia(playlist, item->media) == first);
+    }
+    assert(playlist->index.count == playlist->items.size);
+}
+
+static void
+test_index_update(void)
+{
+    vlc_playlist_t *playlist = vlc_playlist_New(NULL, VLC_PLAYLIST_PREPARSING_DISABLED, 0, 0);
+    assert(playlist);
+
+    input_item_t *media[100];
+    CreateDummyMediaArray(media, 100);
+
+    unsigned short xsubi[3] = { 42, 43, 44 };
+    for (int i = 0; i < 500; ++i)
+    {
+        size_t size = playlist->items.size;
+        size_t index = size ? nrand48(xsubi) % size : 0;
+        size_t count = size ? 1 + nrand48(xsubi) % (size - index) : 0;
+        int ret;
+
+        switch (size < 50 ? 0 : nrand48(xsubi) % 4)
+        {
+            case 0:
+                /* the same media may be inserted several times */
+                count = 1 + nrand48(xsubi) % 10;
+                ret = vlc_playlist_Insert(playlist, index,
+                                          &media[nrand48(xsubi) % 90], count);
+                assert(ret == VLC_SUCCESS);
+                break;
+            case 1:
+                vlc_playlist_Move(playlist, index, count,
+                                  nrand48(xsubi) % (size - count + 1));
+                break;
+            case 2:
+                vlc_playlist_Remove(playlist, index, __MIN(count, 16));
+                break;
+            case 3:
+                if (i % 100 == 3)
+                    vlc_playlist_Shuffle(playlist);
+                else
+                    vlc_playlist_Expand(playlist, index, &media[90], 3);
+                break;
+        }
+        CheckIndex(playlist);
+    }
+
+    vlc_playlist_Clear(playlist);
+    assert(vlc_playlist_IndexOfMedia(playlist, media[0]) == -1);
+    assert(playlist->index.count == 0);
+
+    DestroyMediaArray(media, 100);
+    vlc_playlist_Delete(playlist);
+}
+
+#define BENCH_ITEMS 50000
+
+static void
+bench_index(void)
+{
+    vlc_playlist_t *playlist = vlc_playlist_New(NULL, VLC_PLAYLIST_PREPARSING_DISABLED, 0, 0);
+    assert(playlist);
+
+    input_item_t **media = vlc_alloc(BENCH_ITEMS, sizeof(*media));
+    assert(media);
+    CreateDummyMediaArray(media, BENCH_ITEMS);
+
+    /* append one by one, then look every item up, as the UI would do on each
+     * event */
+    vlc_tick_t start = vlc_tick_now();
+    for (size_t i = 0; i < BENCH_ITEMS; ++i)
+    {
+        int ret = vlc_playlist_Append(playlist, &media[i], 1);
+        assert(ret == VLC_SUCCESS);
+        assert(vlc_playlist_IndexOfMedia(playlist, media[i]) == (ssize_t) i);
+    }
+    vlc_tick_t append = vlc_tick_now() - start;
+
+    start = vlc_tick_now();
+    for (size_t i = 0; i < BENCH_ITEMS; ++i)
+    {
+        vlc_playlist_item_t *item = playlist->items.data[i];
+        assert(vlc_playlist_IndexOfId(playlist, item->id) == (ssize_t) i);
+        assert(vlc_playlist_IndexOf(playlist, item) == (ssize_t) i);
+    }
+    vlc_tick_t lookup = vlc_tick_now() - start;
+
+    /* move the last item to the front, every position changes */
+    start = vlc_tick_now();
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        vlc_playlist_Move(playlist, BENCH_ITEMS - 1, 1, 0);
+        assert(vlc_playlist_IndexOfMedia(playlist, media[BENCH_ITEMS - 1 - i])
+               == 0);
+    }
+    vlc_tick_t move = vlc_tick_now() - start;
+
+    printf("playlist index, %d items: append+lookup %"PRId64" ms, "
+           "lookups %"PRId64" ms, 1000 moves %"PRId64" ms\n", BENCH_ITEMS,
+           MS_FROM_VLC_TICK(append), MS_FROM_VLC_TICK(lookup),
+           MS_FROM_VLC_TICK(move));
+
+    vlc_playlist_Clear(playlist);
+    DestroyMediaArray(media, BENCH_ITEMS);
+    free(media);
+    vlc_playlist_Delete(playlist);
+}
+
 static void
 test_prev(void)
 {
@@ -2425,6 +2560,80 @@ test_stable_sort(void)
 
 #undef EXPECT_AT
 
+#define BENCH_SORT_ITEMS 100000
+
+static void
+bench_sort(void)
+{
+    vlc_playlist_t *playlist = vlc_playlist_New(NULL, VLC_PLAYLIST_PREPARSING_DISABLED, 0, 0);
+    assert(playlist);
+
+    input_item_t **media = vlc_alloc(BENCH_SORT_ITEMS, sizeof(*media));
+    assert(media);
+    CreateDummyMediaArray(media, BENCH_SORT_ITEMS);
+
+    for (size_t i = 0; i < BENCH_SORT_ITEMS; ++i)
+    {
+        char str[32];
+        snprintf(str, sizeof(str), "%s %zu", i % 3 ? "Artist" : "artist",
+                 i * 7919 % 500);
+        input_item_SetArtist(media[i], str);
+        snprintf(str, sizeof(str), "Album %zu", i * 31 % 37);
+        input_item_SetAlbum(media[i], str);
+        snprintf(str, sizeof(str), "%zu", i % 20);
+        input_item_SetTrackNumber(media[i], str);
+    }
+
+    int ret = vlc_playlist_Append(playlist, media, BENCH_SORT_ITEMS);
+    assert(ret == VLC_SUCCESS);
+
+    struct vlc_playlist_sort_criterion criteria[] = {
+        { VLC_PLAYLIST_SORT_KEY_ARTIST, VLC_PLAYLIST_SORT_ORDER_ASCENDING },
+        { VLC_PLAYLIST_SORT_KEY_ALBUM, VLC_PLAYLIST_SORT_ORDER_ASCENDING },
+        { VLC_PLAYLIST_SORT_KEY_TRACK_NUMBER, VLC_PLAYLIST_SORT_ORDER_ASCENDING },
+    };
+
+    vlc_tick_t start = vlc_tick_now();
+    ret = vlc_playlist_Sort(playlist, criteria, ARRAY_SIZE(criteria));
+    assert(ret == VLC_SUCCESS);
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+
+    /* check the order, and the stability from the insertion order */
+    for (size_t i = 1; i < BENCH_SORT_ITEMS; ++i)
+    {
+        vlc_playlist_item_t *a = playlist->items.data[i - 1];
+        vlc_playlist_item_t *b = playlist->items.data[i];
+        char *artist_a = input_item_GetArtist(a->media);
+        char *artist_b = input_item_GetArtist(b->media);
+        char *album_a = input_item_GetAlbum(a->media);
+        char *album_b = input_item_GetAlbum(b->media);
+        char *track_a = input_item_GetTrackNum(a->media);
+        char *track_b = input_item_GetTrackNum(b->media);
+
+        int cmp = strcasecmp(artist_a, artist_b);
+        if (!cmp)
+            cmp = vlc_filenamecmp(album_a, album_b);
+        if (!cmp)
+            cmp = atoi(track_a) - atoi(track_b);
+        assert(cmp < 0 || (cmp == 0 && a->id < b->id));
+
+        free(artist_a);
+        free(artist_b);
+        free(album_a);
+        free(album_b);
+        free(track_a);
+        free(track_b);
+    }
+
+    printf("playlist sort, %d items by artist/album/track: %"PRId64" ms\n",
+           BENCH_SORT_ITEMS, MS_FROM_VLC_TICK(elapsed));
+
+    vlc_playlist_Clear(playlist);
+    DestroyMediaArray(media, BENCH_SORT_ITEMS);
+    free(media);
+    vlc_playlist_Delete(playlist);
+}
+
 int main(void)
 {
     test_append();
@@ -2441,6 +2650,7 @@ int main(void)
     test_playback_order_changed_callbacks();
     test_callbacks_on_add_listener();
     test_index_of();
+    test_index_update();
     test_prev();
     test_next();
     test_goto();
@@ -2459,6 +2669,13 @@ int main(void)
     test_shuffle();
     test_sort();
     test_stable_sort();
+
+    /* Timings are noise in a test run, compare them on demand */
+    bool bench = getenv("VLC_TEST_BENCH") != NULL;
+    if (bench)
+        bench_index();
+    if (bench)
+        bench_sort();
     return 0;
 }
 
@@ -136,7 +136,10 @@ Submit(input_fetcher_t *fetcher, vlc_executor_t *executor, input_item_t *item,
         return VLC_ENOMEM;
 
     FetcherAddTask(fetcher, task);
-    vlc_executor_Submit(task->executor, &task->runnable);
+    vlc_executor_SubmitPriority(task->executor, &task->runnable,
+                                options & VLC_PREPARSER_OPTION_INTERACT
+                                ? VLC_EXECUTOR_PRIORITY_INTERACTIVE
+                                : VLC_EXECUTOR_PRIORITY_BACKGROUND);
 
     return VLC_SUCCESS;
 }
@@ -682,7 +682,11 @@ vlc_preparser_req_id vlc_preparser_Push( vlc_preparser_t *preparser, input_item_
     {
         vlc_preparser_req_id id = PreparserAddTask(preparser, task);
 
-        vlc_executor_Submit(preparser->parser, &task->runnable);
+        /* Requests made on behalf of the user go ahead of library scans */
+        vlc_executor_SubmitPriority(preparser->parser, &task->runnable,
+                                    type_options & VLC_PREPARSER_OPTION_INTERACT
+                                    ? VLC_EXECUTOR_PRIORITY_INTERACTIVE
+                                    : VLC_EXECUTOR_PRIORITY_BACKGROUND);
 
         return id;
     }
@@ -718,7 +722,8 @@ vlc_preparser_GenerateThumbnail( vlc_preparser_t *preparser, input_item_t *item,
 
     vlc_preparser_req_id id = PreparserAddTask(preparser, task);
 
-    vlc_executor_Submit(preparser->thumbnailer, &task->runnable);
+    vlc_executor_SubmitPriority(preparser->thumbnailer, &task->runnable,
+                                VLC_EXECUTOR_PRIORITY_INTERACTIVE);
 
     return id;
 }
@@ -852,7 +857,8 @@ vlc_preparser_GenerateThumbnailToFiles( vlc_preparser_t *preparser, input_item_t
 
     vlc_preparser_req_id id = PreparserAddTask(preparser, task);
 
-    vlc_executor_Submit(preparser->thumbnailer, &task->runnable);
+    vlc_executor_SubmitPriority(preparser->thumbnailer, &task->runnable,
+                                VLC_EXECUTOR_PRIORITY_BACKGROUND);
 
     return id;
 }
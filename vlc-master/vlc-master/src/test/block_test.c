@@ -23,12 +23,15 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #undef NDEBUG
 #include <assert.h>
 
 #include <vlc_common.h>
 #include <vlc_block.h>
+#include <vlc_threads.h>
+#include <vlc_tick.h>
 
 static const char text[] =
     "This is a test!\n"
@@ -86,11 +89,217 @@ static void test_block (void)
     //assert (block == NULL);
 }
 
+static void test_block_Layout(block_t *block, size_t size)
+{
+    assert(block->i_buffer == size);
+    assert(((uintptr_t)block->p_buffer % 32) == 0);
+    assert(block->p_buffer >= block->p_start);
+    assert(block->p_buffer + block->i_buffer
+           <= block->p_start + block->i_size);
+    memset(block->p_buffer, 0xA5, block->i_buffer);
+}
+
+static void *test_frame_cache_Release(void *data)
+{
+    block_ChainRelease(data);
+    return NULL;
+}
+
+static void test_frame_cache(void)
+{
+    static const size_t sizes[] = {
+        0, 1, 188, 400, 4000, 65536, 200000, 300000, 1 << 20,
+    };
+    struct vlc_frame_cache_stats before, after;
+
+    vlc_frame_cache_GetStats(&before);
+
+    for (size_t i = 0; i < ARRAY_SIZE(sizes); i++)
+    {
+        block_t *block = block_Alloc(sizes[i]);
+        assert(block != NULL);
+        test_block_Layout(block, sizes[i]);
+        block_Release(block);
+
+        /* Recycled */
+        block = block_Alloc(sizes[i]);
+        assert(block != NULL);
+        test_block_Layout(block, sizes[i]);
+
+        block = block_Realloc(block, 100, sizes[i] + 1000);
+        assert(block != NULL);
+        test_block_Layout(block, 100 + sizes[i] + 1000);
+        block_Release(block);
+    }
+
+    vlc_frame_cache_GetStats(&after);
+    bool enabled = after.misses > before.misses;
+    if (enabled)
+    {
+        assert(after.hits > before.hits);
+        assert(after.bytes_cached > 0);
+    }
+
+    /* Frames released by another thread come back through the depot */
+    block_t *chain = NULL;
+    block_t **pp = &chain;
+    for (unsigned i = 0; i < 4096; i++)
+    {
+        *pp = block_Alloc(188);
+        assert(*pp != NULL);
+        pp = &(*pp)->p_next;
+    }
+
+    vlc_thread_t th;
+    int ret = vlc_clone(&th, test_frame_cache_Release, chain);
+    assert(ret == 0);
+    vlc_join(th, NULL);
+
+    vlc_frame_cache_GetStats(&before);
+    for (unsigned i = 0; i < 4096; i++)
+    {
+        block_t *block = block_Alloc(188);
+        assert(block != NULL);
+        block_Release(block);
+    }
+    vlc_frame_cache_GetStats(&after);
+    if (enabled)
+        assert(after.hits - before.hits > after.misses - before.misses);
+}
+
+/*
+ * Allocation cost of a high bitrate TS demux: the demux thread allocates
+ * 188 bytes packets and reassembled PES payloads, the decoder thread
+ * releases them.
+ */
+#define BENCH_PASSES        128
+#define BENCH_PACKETS       (1 << 11)
+#define BENCH_PES_PACKETS   256  /* TS packets per PES */
+
+struct bench_decoder
+{
+    vlc_fifo_t *fifo;
+    vlc_sem_t drained;
+};
+
+static void *bench_Decoder(void *data)
+{
+    struct bench_decoder *dec = data;
+    bool eos = false;
+
+    while (!eos)
+    {
+        vlc_fifo_Lock(dec->fifo);
+        while (vlc_fifo_IsEmpty(dec->fifo))
+            vlc_fifo_Wait(dec->fifo);
+        block_t *chain = vlc_fifo_DequeueAllUnlocked(dec->fifo);
+        vlc_fifo_Unlock(dec->fifo);
+
+        while (chain != NULL)
+        {
+            block_t *block = chain;
+
+            chain = block->p_next;
+            if (block->i_buffer == 0)
+            {   /* End of pass marker */
+                eos = (block->i_flags & BLOCK_FLAG_END_OF_SEQUENCE) != 0;
+                vlc_sem_post(&dec->drained);
+            }
+            block_Release(block);
+        }
+    }
+    return NULL;
+}
+
+static block_t *bench_HeapAlloc(size_t size)
+{
+    /* vlc_frame_Alloc() without the cache */
+    size_t capacity = 64 + size + ((-size) % 32);
+    unsigned char *buf = aligned_alloc(32, capacity);
+    assert(buf != NULL);
+
+    block_t *block = block_heap_Alloc(buf, capacity);
+    assert(block != NULL);
+    block->p_buffer += 32;
+    block->i_buffer = size;
+    return block;
+}
+
+static vlc_tick_t bench_Demux(block_t *(*alloc)(size_t))
+{
+    struct bench_decoder dec;
+    vlc_thread_t th;
+
+    dec.fifo = vlc_fifo_New();
+    assert(dec.fifo != NULL);
+    vlc_sem_init(&dec.drained, 0);
+    int ret = vlc_clone(&th, bench_Decoder, &dec);
+    assert(ret == 0);
+
+    vlc_tick_t start = vlc_tick_now();
+    for (unsigned pass = 0; pass < BENCH_PASSES; pass++)
+    {
+        for (unsigned i = 0; i < BENCH_PACKETS; i++)
+        {
+            block_t *pkt = alloc(188);
+            pkt->p_buffer[0] = 0x47;
+            vlc_fifo_Put(dec.fifo, pkt);
+
+            if ((i % BENCH_PES_PACKETS) == BENCH_PES_PACKETS - 1)
+            {
+                block_t *pes = alloc(BENCH_PES_PACKETS * 184);
+                pes->p_buffer[0] = 0x00;
+                vlc_fifo_Put(dec.fifo, pes);
+            }
+        }
+
+        block_t *marker = alloc(0);
+        if (pass == BENCH_PASSES - 1)
+            marker->i_flags |= BLOCK_FLAG_END_OF_SEQUENCE;
+        vlc_fifo_Put(dec.fifo, marker);
+        vlc_sem_wait(&dec.drained);
+    }
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+
+    vlc_join(th, NULL);
+    vlc_fifo_Delete(dec.fifo);
+    return elapsed;
+}
+
+static void bench_frame_cache(void)
+{
+    const double count = (double)BENCH_PASSES * BENCH_PACKETS
+                       * (BENCH_PES_PACKETS + 1) / BENCH_PES_PACKETS;
+    struct vlc_frame_cache_stats before, after;
+
+    vlc_tick_t heap = bench_Demux(bench_HeapAlloc);
+
+    vlc_frame_cache_GetStats(&before);
+    vlc_tick_t cache = bench_Demux(block_Alloc);
+    vlc_frame_cache_GetStats(&after);
+
+    printf("heap:  %6.1f ns per block\n",
+           1e9 * secf_from_vlc_tick(heap) / count);
+    printf("cache: %6.1f ns per block\n",
+           1e9 * secf_from_vlc_tick(cache) / count);
+    printf("cache hits: %"PRIu64", misses: %"PRIu64" (%.1f%%), "
+           "%zu bytes cached\n", after.hits - before.hits,
+           after.misses - before.misses,
+           100. * (after.hits - before.hits)
+           / ((after.hits - before.hits) + (after.misses - before.misses)),
+           after.bytes_cached);
+}
+
 int main (void)
 {
     test_block_File(false);
     test_block_File(true);
     test_block ();
+    test_frame_cache ();
+
+    /* Timings are noise in a test run, compare them on demand */
+    if (getenv ("VLC_TEST_BENCH") != NULL)
+        bench_frame_cache ();
     return 0;
 }
 
@@ -25,6 +25,8 @@
 #undef NDEBUG
 
 #include <assert.h>
+#include <stdatomic.h>
+#include <stdio.h>
 
 #include <vlc_common.h>
 #include <vlc_threads.h>
@@ -271,6 +273,164 @@ static void test_task_chain(void)
         assert(array[i] == 2 * i);
 }
 
+struct order_data
+{
+    vlc_mutex_t lock;
+    vlc_cond_t cond;
+    bool started;
+    bool blocked;
+    int count;
+    int order[6];
+};
+
+struct order_task
+{
+    struct order_data *data;
+    int id;
+    struct vlc_runnable runnable;
+};
+
+static void RunOrder(void *userdata)
+{
+    struct order_task *task = userdata;
+    struct order_data *data = task->data;
+
+    vlc_mutex_lock(&data->lock);
+    data->started = true;
+    vlc_cond_broadcast(&data->cond);
+    while (data->blocked)
+        vlc_cond_wait(&data->cond, &data->lock);
+    data->order[data->count++] = task->id;
+    vlc_mutex_unlock(&data->lock);
+}
+
+static void test_priority(void)
+{
+    vlc_executor_t *executor = vlc_executor_New(1);
+    assert(executor);
+
+    struct order_data data = { .started = false, .blocked = true };
+    vlc_mutex_init(&data.lock);
+    vlc_cond_init(&data.cond);
+
+    static const enum vlc_executor_priority priorities[] = {
+        VLC_EXECUTOR_PRIORITY_NORMAL, /* blocks the only thread */
+        VLC_EXECUTOR_PRIORITY_BACKGROUND,
+        VLC_EXECUTOR_PRIORITY_NORMAL,
+        VLC_EXECUTOR_PRIORITY_INTERACTIVE,
+        VLC_EXECUTOR_PRIORITY_BACKGROUND,
+        VLC_EXECUTOR_PRIORITY_INTERACTIVE,
+    };
+    struct order_task tasks[ARRAY_SIZE(priorities)];
+
+    for (size_t i = 0; i < ARRAY_SIZE(priorities); ++i)
+    {
+        tasks[i].data = &data;
+        tasks[i].id = i;
+        tasks[i].runnable.run = RunOrder;
+        tasks[i].runnable.userdata = &tasks[i];
+        vlc_executor_SubmitPriority(executor, &tasks[i].runnable,
+                                    priorities[i]);
+
+        /* Queue the others once the first one blocks the thread */
+        vlc_mutex_lock(&data.lock);
+        while (!data.started)
+            vlc_cond_wait(&data.cond, &data.lock);
+        vlc_mutex_unlock(&data.lock);
+    }
+
+    vlc_mutex_lock(&data.lock);
+    data.blocked = false;
+    vlc_cond_signal(&data.cond);
+    vlc_mutex_unlock(&data.lock);
+
+    vlc_executor_WaitIdle(executor);
+    vlc_executor_Delete(executor);
+
+    static const int expected[] = { 0, 3, 5, 2, 1, 4 };
+    assert(data.count == ARRAY_SIZE(expected));
+    for (size_t i = 0; i < ARRAY_SIZE(expected); ++i)
+        assert(data.order[i] == expected[i]);
+}
+
+#define BENCH_TASKS 100000
+#define BENCH_FANOUT 16
+
+struct bench_task
+{
+    vlc_executor_t *executor;
+    unsigned depth;
+    unsigned value;
+    atomic_uint *count;
+    struct vlc_runnable runnable;
+};
+
+static void RunBench(void *userdata)
+{
+    struct bench_task *task = userdata;
+
+    /* Some work per task */
+    unsigned value = task->depth;
+    for (unsigned i = 0; i < 1000; ++i)
+        value = value * 1103515245 + 12345;
+    task->value = value;
+    atomic_fetch_add_explicit(task->count, 1, memory_order_relaxed);
+
+    if (task->depth > 0)
+    {
+        struct bench_task *children = &task[1];
+        for (unsigned i = 0; i < BENCH_FANOUT; ++i)
+            vlc_executor_Submit(task->executor, &children[i].runnable);
+    }
+}
+
+/* Tasks submitted from outside, then tasks spawning tasks */
+static void bench(unsigned threads)
+{
+    vlc_executor_t *executor = vlc_executor_New(threads);
+    assert(executor);
+
+    atomic_uint count = 0;
+    struct bench_task *tasks = malloc(BENCH_TASKS * sizeof(*tasks));
+    assert(tasks);
+    for (unsigned i = 0; i < BENCH_TASKS; ++i)
+    {
+        tasks[i].executor = executor;
+        tasks[i].depth = 0;
+        tasks[i].count = &count;
+        tasks[i].runnable.run = RunBench;
+        tasks[i].runnable.userdata = &tasks[i];
+    }
+
+    vlc_tick_t start = vlc_tick_now();
+    for (unsigned i = 0; i < BENCH_TASKS; ++i)
+        vlc_executor_Submit(executor, &tasks[i].runnable);
+    vlc_executor_WaitIdle(executor);
+    vlc_tick_t submitted = vlc_tick_now() - start;
+    assert(atomic_load(&count) == BENCH_TASKS);
+
+    /* Each parent is followed by its children in the array */
+    const unsigned stride = 1 + BENCH_FANOUT;
+    const unsigned parents = BENCH_TASKS / stride;
+    for (unsigned i = 0; i < parents; ++i)
+        tasks[i * stride].depth = 1;
+
+    atomic_store(&count, 0);
+    start = vlc_tick_now();
+    for (unsigned i = 0; i < parents; ++i)
+        vlc_executor_Submit(executor, &tasks[i * stride].runnable);
+    vlc_executor_WaitIdle(executor);
+    vlc_tick_t spawned = vlc_tick_now() - start;
+    assert(atomic_load(&count) == parents * stride);
+
+    printf("%2u threads: %.0f tasks/s submitted, %.0f tasks/s spawned\n",
+           threads, BENCH_TASKS / secf_from_vlc_tick(submitted),
+           parents * stride / secf_from_vlc_tick(spawned));
+
+    vlc_executor_Delete(executor);
+    free(tasks);
+}
+
 int main(void)
 {
     test_single_runnable();
@@ -278,5 +438,12 @@ int main(void)
     test_blocking_delete();
     test_cancel();
     test_task_chain();
+    test_priority();
+
+
+    /* Timings are noise in a test run, compare them on demand */
+    if (getenv("VLC_TEST_BENCH") != NULL)
+        for (unsigned threads = 1; threads <= 64; threads *= 2)
+            bench(threads);
     return 0;
 }
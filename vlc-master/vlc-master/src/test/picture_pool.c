@@ -26,11 +26,17 @@
 #undef NDEBUG
 #include <assert.h>
 
+#include <stdio.h>
+
 #include <vlc_common.h>
 #include <vlc_es.h>
 #include <vlc_picture_pool.h>
+#include <vlc_threads.h>
+#include <vlc_tick.h>
 
 #define PICTURES 10
+#define THREADS_MAX 16
+#define LOOPS 100000
 
 const char vlc_module_name[] = "test_picture_pool";
 
@@ -87,6 +93,92 @@ static void test(bool zombie)
             picture_Release(pics[i]);
 }
 
+struct contender
+{
+    vlc_thread_t thread;
+    bool wait;
+    unsigned loops;
+};
+
+static void *contend(void *data)
+{
+    struct contender *c = data;
+
+    for (unsigned i = 0; i < c->loops; i++) {
+        picture_t *pic = c->wait ? picture_pool_Wait(pool)
+                                 : picture_pool_Get(pool);
+        if (pic == NULL)
+            continue;
+        /* The picture must not be handed out twice */
+        uint8_t *owner = pic->p[0].p_pixels;
+        assert(*owner == 0);
+        *owner = 1;
+        *owner = 0;
+        picture_Release(pic);
+    }
+    return NULL;
+}
+
+/* Threads getting and releasing pictures from a pool smaller than their
+ * count, so that picture_pool_Wait() also sleeps */
+static vlc_tick_t test_contention(unsigned threads, unsigned pictures, bool wait)
+{
+    struct contender contenders[THREADS_MAX];
+
+    pool = picture_pool_NewFromFormat(&fmt, pictures);
+    assert(pool != NULL);
+
+    /* Plane contents tell whether a picture is in use */
+    picture_t *pics[PICTURES];
+    for (unsigned i = 0; i < pictures; i++) {
+        pics[i] = picture_pool_Get(pool);
+        assert(pics[i] != NULL);
+        *pics[i]->p[0].p_pixels = 0;
+    }
+    for (unsigned i = 0; i < pictures; i++)
+        picture_Release(pics[i]);
+
+    vlc_tick_t start = vlc_tick_now();
+    for (unsigned i = 0; i < threads; i++) {
+        contenders[i].wait = wait;
+        contenders[i].loops = LOOPS;
+        int ret = vlc_clone(&contenders[i].thread, contend, &contenders[i]);
+        assert(ret == 0);
+    }
+    for (unsigned i = 0; i < threads; i++)
+        vlc_join(contenders[i].thread, NULL);
+    vlc_tick_t duration = vlc_tick_now() - start;
+
+    /* Every picture went back to the pool */
+    for (unsigned i = 0; i < pictures; i++) {
+        pics[i] = picture_pool_Get(pool);
+        assert(pics[i] != NULL);
+    }
+    assert(picture_pool_Get(pool) == NULL);
+    for (unsigned i = 0; i < pictures; i++)
+        picture_Release(pics[i]);
+
+    picture_pool_Release(pool);
+    return duration;
+}
+
+static void bench(void)
+{
+    /* Timings are noise in a test run, print them on demand */
+    bool print = getenv("VLC_TEST_BENCH") != NULL;
+
+    for (unsigned threads = 1; threads <= THREADS_MAX; threads *= 2) {
+        vlc_tick_t get = test_contention(threads, PICTURES, false);
+        vlc_tick_t wait = test_contention(threads, 4, true);
+
+        if (print)
+            printf("%2u threads: get %.0f pictures/s, wait %.0f pictures/s\n",
+                   threads,
+                   (double)threads * LOOPS / secf_from_vlc_tick(get),
+                   (double)threads * LOOPS / secf_from_vlc_tick(wait));
+    }
+}
+
 int main(void)
 {
     video_format_Init(&fmt, VLC_CODEC_I420);
@@ -100,5 +192,7 @@ int main(void)
     test(false);
     test(true);
 
+    bench();
+
     return 0;
 }
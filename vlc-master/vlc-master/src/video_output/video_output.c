@@ -86,6 +86,7 @@ typedef struct vout_thread_sys_t
 
     vlc_clock_t     *clock;
     vlc_clock_listener_id *clock_listener_id;
+    bool            display_suspended; /* thread stopped, display kept */
     uint32_t clock_id;
     float           rate;
     vlc_tick_t      delay;
@@ -1948,6 +1949,25 @@ error:
     return VLC_EGENERIC;
 }
 
+static void vout_Resume(vout_thread_sys_t *vout, const vout_configuration_t *cfg)
+{
+    vout_thread_sys_t *sys = vout;
+
+    assert(sys->display != NULL);
+
+    vlc_mutex_lock(&sys->window_lock);
+    vout_display_window_SetMouseHandler(sys->display_cfg.window,
+                                        cfg->mouse_event, cfg->mouse_opaque);
+    vlc_mutex_unlock(&sys->window_lock);
+
+    vlc_queuedmutex_lock(&sys->display_lock);
+    VoutResetChronoLocked(sys);
+    vlc_queuedmutex_unlock(&sys->display_lock);
+
+    sys->pause.is_on = false;
+    sys->pause.date  = VLC_TICK_INVALID;
+}
+
 /*****************************************************************************
  * Thread: video output thread
  *****************************************************************************
@@ -1986,6 +2006,33 @@ static void *Thread(void *object)
     return NULL;
 }
 
+static void vout_DetachSource(vout_thread_sys_t *vout)
+{
+    vout_thread_sys_t *sys = vout;
+
+    vlc_mutex_lock(&sys->window_lock);
+    vout_display_window_SetMouseHandler(sys->display_cfg.window, NULL, NULL);
+    vlc_mutex_unlock(&sys->window_lock);
+
+    if (sys->spu)
+        spu_Detach(sys->spu);
+
+    if (sys->clock_listener_id != NULL)
+    {
+        vlc_clock_Lock(sys->clock);
+        vlc_clock_RemoveListener(sys->clock, sys->clock_listener_id);
+        vlc_clock_Unlock(sys->clock);
+        sys->clock_listener_id = NULL;
+    }
+
+    vlc_mutex_lock(&sys->clock_lock);
+    sys->clock = NULL;
+    vlc_mutex_unlock(&sys->clock_lock);
+    sys->str_id = NULL;
+    sys->clock_id = 0;
+    sys->first_picture = true;
+}
+
 static void vout_ReleaseDisplay(vout_thread_sys_t *vout)
 {
     vout_thread_sys_t *sys = vout;
@@ -2035,41 +2082,43 @@ static void vout_ReleaseDisplay(vout_thread_sys_t *vout)
     }
     assert(sys->private_pool == NULL);
 
-    vlc_mutex_lock(&sys->window_lock);
-    vout_display_window_SetMouseHandler(sys->display_cfg.window, NULL, NULL);
-    vlc_mutex_unlock(&sys->window_lock);
-
-    if (sys->spu)
-        spu_Detach(sys->spu);
-
-    if (sys->clock_listener_id != NULL)
-    {
-        vlc_clock_Lock(sys->clock);
-        vlc_clock_RemoveListener(sys->clock, sys->clock_listener_id);
-        vlc_clock_Unlock(sys->clock);
-        sys->clock_listener_id = NULL;
-    }
-
-    vlc_mutex_lock(&sys->clock_lock);
-    sys->clock = NULL;
-    vlc_mutex_unlock(&sys->clock_lock);
-    sys->str_id = NULL;
-    sys->clock_id = 0;
-    sys->first_picture = true;
+    vout_DetachSource(vout);
 }
 
-void vout_StopDisplay(vout_thread_t *vout)
+static void vout_StopThread(vout_thread_sys_t *sys)
 {
-    vout_thread_sys_t *sys = VOUT_THREAD_TO_SYS(vout);
-
     atomic_store(&sys->control_is_terminated, true);
     // wake up so it goes back to the loop that will detect the terminated state
     vout_control_Wake(&sys->control);
     vlc_join(sys->thread, NULL);
+}
+
+void vout_StopDisplay(vout_thread_t *vout)
+{
+    vout_thread_sys_t *sys = VOUT_THREAD_TO_SYS(vout);
+
+    /* A suspended display has no thread anymore */
+    if (!sys->display_suspended)
+        vout_StopThread(sys);
+    sys->display_suspended = false;
 
     vout_ReleaseDisplay(sys);
 }
 
+void vout_SuspendDisplay(vout_thread_t *vout)
+{
+    vout_thread_sys_t *sys = VOUT_THREAD_TO_SYS(vout);
+
+    assert(sys->display != NULL && !sys->display_suspended);
+    vout_StopThread(sys);
+
+    /* Drop the pictures of the previous source, the last displayed one is
+     * kept on screen until the next source starts */
+    vout_FlushUnlocked(sys, true, VLC_TICK_MAX);
+    vout_DetachSource(sys);
+    sys->display_suspended = true;
+}
+
 static void vout_DisableWindow(vout_thread_sys_t *sys)
 {
     vlc_mutex_lock(&sys->window_lock);
@@ -2236,6 +2285,7 @@ vout_thread_t *vout_Create(vlc_object_t *object)
 
     /* Display */
     sys->display = NULL;
+    sys->display_suspended = false;
     sys->display_cfg.icc_profile = NULL;
     vlc_queuedmutex_init(&sys->display_lock);
 
@@ -2364,30 +2414,39 @@ int vout_Request(const vout_configuration_t *cfg, vlc_video_context *vctx, input
     video_format_t original;
     VoutFixFormat(&original, cfg->fmt);
 
+    bool resume = false;
     if (vout_ChangeSource(cfg->vout, &original, vctx) == 0)
     {
         video_format_Clean(&original);
-        return 0;
-    }
-
-    vlc_mutex_lock(&sys->window_lock);
-    video_format_Clean(&sys->original);
-    sys->original = original;
-    sys->displayed.projection = original.projection_mode;
-    vout_InitSource(vout);
+        if (!sys->display_suspended)
+            return 0;
 
-    if (EnableWindowLocked(vout, &original) != 0)
+        /* Same format as the previous source: resume its display */
+        msg_Dbg(cfg->vout, "resuming the display");
+        sys->display_suspended = false;
+        resume = true;
+    }
+    else
     {
-        /* the window was not enabled, nor the display started */
-        msg_Err(cfg->vout, "failed to enable window");
+        vlc_mutex_lock(&sys->window_lock);
+        video_format_Clean(&sys->original);
+        sys->original = original;
+        sys->displayed.projection = original.projection_mode;
+        vout_InitSource(vout);
+
+        if (EnableWindowLocked(vout, &original) != 0)
+        {
+            /* the window was not enabled, nor the display started */
+            msg_Err(cfg->vout, "failed to enable window");
+            vlc_mutex_unlock(&sys->window_lock);
+            assert(sys->display == NULL);
+            return -1;
+        }
         vlc_mutex_unlock(&sys->window_lock);
-        assert(sys->display == NULL);
-        return -1;
-    }
-    vlc_mutex_unlock(&sys->window_lock);
 
-    if (sys->display != NULL)
-        vout_StopDisplay(cfg->vout);
+        if (sys->display != NULL)
+            vout_StopDisplay(cfg->vout);
+    }
 
     vout_ReinitInterlacingSupport(cfg->vout, &sys->interlacing);
 
@@ -2410,7 +2469,9 @@ int vout_Request(const vout_configuration_t *cfg, vlc_video_context *vctx, input
 
     sys->delay = 0;
 
-    if (vout_Start(vout, vctx, cfg))
+    if (resume)
+        vout_Resume(vout, cfg);
+    else if (vout_Start(vout, vctx, cfg))
     {
         msg_Err(cfg->vout, "video output display creation failed");
         goto error_display;
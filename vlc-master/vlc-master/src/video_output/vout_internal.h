@@ -97,6 +97,16 @@ void vout_Stop(vout_thread_t *);
  */
 void vout_StopDisplay(vout_thread_t *);
 
+/**
+ * Stop the vout thread and detach its source, but keep the display.
+ *
+ * The next vout_Request() resumes the display if the format is similar
+ * (a gapless switch to the next media), or stops it otherwise. Until then,
+ * the last picture stays on screen: if the next media has no video, the
+ * display is stopped with vout_Stop() along with the other free vouts.
+ */
+void vout_SuspendDisplay(vout_thread_t *);
+
 /**
  * Set the new source format for a started vout
  *
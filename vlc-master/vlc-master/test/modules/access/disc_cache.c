@@ -0,0 +1,340 @@
+/*****************************************************************************
+ * disc_cache.c: optical disc sector cache tests and benchmark
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_threads.h>
+#include <vlc_tick.h>
+
+#include <stdio.h>
+
+#include "../../../modules/access/disc_cache.h"
+
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/test.h"
+
+/* The module code under test logs */
+const char vlc_module_name[] = "test_disc_cache";
+
+#define SECTOR_SIZE     2048
+#define BLOCK_SECTORS   DISC_CACHE_DVD_BLOCK_SECTORS
+#define DISC_BLOCKS     1024
+#define DISC_SECTORS    (DISC_BLOCKS * BLOCK_SECTORS - 5) /* short last block */
+
+/* File backed drive: a non-contiguous read costs a seek, every sector
+ * costs its transfer time */
+struct fake_drive
+{
+    FILE        *file;
+    vlc_mutex_t  lock;
+    vlc_cond_t   wait;
+    bool         paused;
+    vlc_tick_t   seek_latency;
+    vlc_tick_t   sector_latency;
+    uint64_t     head;
+    uint64_t     order[64];     /* first sector of each read */
+    unsigned     reads;
+    unsigned     seeks;
+};
+
+static uint8_t SectorByte(uint64_t lba, size_t i)
+{
+    return (lba * 7 + i) & 0xFF;
+}
+
+static void DriveInit(struct fake_drive *d, vlc_tick_t seek_latency,
+                      vlc_tick_t sector_latency)
+{
+    d->file = tmpfile();
+    assert(d->file != NULL);
+
+    uint8_t sector[SECTOR_SIZE];
+    for (uint64_t lba = 0; lba < DISC_SECTORS; lba++)
+    {
+        for (size_t i = 0; i < SECTOR_SIZE; i++)
+            sector[i] = SectorByte(lba, i);
+        assert(fwrite(sector, SECTOR_SIZE, 1, d->file) == 1);
+    }
+    fflush(d->file);
+
+    vlc_mutex_init(&d->lock);
+    vlc_cond_init(&d->wait);
+    d->paused = false;
+    d->seek_latency = seek_latency;
+    d->sector_latency = sector_latency;
+    d->head = 0;
+    d->reads = d->seeks = 0;
+}
+
+static void DriveClean(struct fake_drive *d)
+{
+    fclose(d->file);
+}
+
+static void DrivePause(struct fake_drive *d, bool b_paused)
+{
+    vlc_mutex_lock(&d->lock);
+    d->paused = b_paused;
+    vlc_cond_broadcast(&d->wait);
+    vlc_mutex_unlock(&d->lock);
+}
+
+static int DriveRead(void *opaque, void *buf, uint64_t lba, unsigned count)
+{
+    struct fake_drive *d = opaque;
+
+    vlc_mutex_lock(&d->lock);
+    while (d->paused)
+        vlc_cond_wait(&d->wait, &d->lock);
+
+    if (d->reads < ARRAY_SIZE(d->order))
+        d->order[d->reads] = lba;
+    d->reads++;
+    if (lba != d->head)
+    {
+        d->seeks++;
+        vlc_tick_sleep(d->seek_latency);
+    }
+
+    if (lba >= DISC_SECTORS)
+        count = 0;
+    else if (lba + count > DISC_SECTORS)
+        count = DISC_SECTORS - lba;
+    if (count > 0)
+    {
+        vlc_tick_sleep(d->sector_latency * count);
+        assert(fseek(d->file, lba * SECTOR_SIZE, SEEK_SET) == 0);
+        assert(fread(buf, SECTOR_SIZE, count, d->file) == count);
+    }
+    d->head = lba + count;
+    vlc_cond_broadcast(&d->wait);
+    vlc_mutex_unlock(&d->lock);
+    return count;
+}
+
+static vlc_disc_cache_t *CacheNew(vlc_object_t *obj, struct fake_drive *d,
+                                  unsigned blocks, unsigned prefetch)
+{
+    const struct vlc_disc_cache_cfg cfg = {
+        .sector_size = SECTOR_SIZE,
+        .block_sectors = BLOCK_SECTORS,
+        .blocks = blocks,
+        .prefetch = prefetch,
+        .read = DriveRead,
+        .opaque = d,
+    };
+    vlc_disc_cache_t *c = vlc_disc_cache_New(obj, &cfg);
+    assert(c != NULL);
+    return c;
+}
+
+static void CheckSectors(const uint8_t *buf, uint64_t lba, unsigned count)
+{
+    for (unsigned s = 0; s < count; s++)
+        for (size_t i = 0; i < SECTOR_SIZE; i += 97)
+            assert(buf[s * SECTOR_SIZE + i] == SectorByte(lba + s, i));
+}
+
+static void WaitReads(struct fake_drive *d, unsigned reads)
+{
+    vlc_mutex_lock(&d->lock);
+    while (d->reads < reads)
+        vlc_cond_wait(&d->wait, &d->lock);
+    vlc_mutex_unlock(&d->lock);
+}
+
+static void test_read(vlc_object_t *obj)
+{
+    struct fake_drive d;
+    DriveInit(&d, 0, 0);
+    vlc_disc_cache_t *c = CacheNew(obj, &d, 16, 4);
+    uint8_t buf[40 * SECTOR_SIZE];
+
+    /* Unaligned reads spanning blocks */
+    static const uint64_t lbas[] = { 0, 3, 17, 500, 15, 8000, 123, 124 };
+    for (size_t i = 0; i < ARRAY_SIZE(lbas); i++)
+    {
+        assert(vlc_disc_cache_Read(c, buf, lbas[i], 40) == 40);
+        CheckSectors(buf, lbas[i], 40);
+    }
+
+    /* Short read at the end of the disc, nothing past it */
+    assert(vlc_disc_cache_Read(c, buf, DISC_SECTORS - 10, 40) == 10);
+    CheckSectors(buf, DISC_SECTORS - 10, 10);
+    assert(vlc_disc_cache_Read(c, buf, DISC_SECTORS + 100, 1) == 0);
+
+    vlc_disc_cache_Delete(c);
+
+    /* Read-ahead: the following blocks are only read once, in order */
+    d.reads = 0;
+    c = CacheNew(obj, &d, 16, 4);
+    assert(vlc_disc_cache_Read(c, buf, 200 * BLOCK_SECTORS, BLOCK_SECTORS)
+           == BLOCK_SECTORS);
+    WaitReads(&d, 1 + 4);
+    for (unsigned i = 1; i <= 4; i++)
+        assert(vlc_disc_cache_Read(c, buf, (200 + i) * BLOCK_SECTORS,
+                                   BLOCK_SECTORS) == BLOCK_SECTORS);
+    vlc_disc_cache_Delete(c);
+
+    for (unsigned i = 0; i < __MIN(d.reads, ARRAY_SIZE(d.order)); i++)
+        assert(d.order[i] == (200 + i) * BLOCK_SECTORS);
+
+    DriveClean(&d);
+}
+
+static void test_elevator(vlc_object_t *obj)
+{
+    struct fake_drive d;
+    DriveInit(&d, 0, 0);
+    vlc_disc_cache_t *c = CacheNew(obj, &d, 16, 0);
+    uint8_t buf[SECTOR_SIZE];
+
+    /* Head at block 41, then requests queue while the drive is busy */
+    assert(vlc_disc_cache_Read(c, buf, 40 * BLOCK_SECTORS, 1) == 1);
+    DrivePause(&d, true);
+    static const uint64_t blocks[] = { 50, 10, 70, 30, 60, 20 };
+    for (size_t i = 0; i < ARRAY_SIZE(blocks); i++)
+        vlc_disc_cache_Prefetch(c, blocks[i] * BLOCK_SECTORS, BLOCK_SECTORS);
+    DrivePause(&d, false);
+    WaitReads(&d, 1 + ARRAY_SIZE(blocks));
+
+    /* One sweep up then one down */
+    static const uint64_t expected[] = { 40, 50, 60, 70, 30, 20, 10 };
+    for (size_t i = 0; i < ARRAY_SIZE(expected); i++)
+        assert(d.order[i] == expected[i] * BLOCK_SECTORS);
+
+    vlc_disc_cache_Delete(c);
+    DriveClean(&d);
+}
+
+static void test_pin(vlc_object_t *obj)
+{
+    struct fake_drive d;
+    DriveInit(&d, 0, 0);
+    vlc_disc_cache_t *c = CacheNew(obj, &d, 16, 4);
+    uint8_t buf[BLOCK_SECTORS * SECTOR_SIZE];
+
+    /* "IFO" read at open, then a chapter start pinned explicitly */
+    vlc_disc_cache_SetPinning(c, true);
+    assert(vlc_disc_cache_Read(c, buf, 0, BLOCK_SECTORS) == BLOCK_SECTORS);
+    vlc_disc_cache_SetPinning(c, false);
+    vlc_disc_cache_Pin(c, 500 * BLOCK_SECTORS, 1);
+
+    /* Stream through many more blocks than the cache holds */
+    for (uint64_t i = 100; i < 300; i++)
+        assert(vlc_disc_cache_Read(c, buf, i * BLOCK_SECTORS, BLOCK_SECTORS)
+               == BLOCK_SECTORS);
+
+    struct vlc_disc_cache_stats before, after;
+    vlc_disc_cache_GetStats(c, &before);
+    assert(vlc_disc_cache_Read(c, buf, 0, BLOCK_SECTORS) == BLOCK_SECTORS);
+    CheckSectors(buf, 0, BLOCK_SECTORS);
+    assert(vlc_disc_cache_Read(c, buf, 500 * BLOCK_SECTORS, 1) == 1);
+    CheckSectors(buf, 500 * BLOCK_SECTORS, 1);
+    vlc_disc_cache_GetStats(c, &after);
+    assert(after.hits - before.hits == 2);
+
+    vlc_disc_cache_Delete(c);
+    DriveClean(&d);
+}
+
+/* Playback with a demuxer spending time on each block, and chapter jumps */
+#define BENCH_BLOCKS    192
+#define BENCH_CHAPTERS  8
+#define BENCH_CONSUME   VLC_TICK_FROM_US(400)
+#define BENCH_PINNED    4   /* blocks pinned at each chapter start */
+
+static uint64_t ChapterStart(unsigned i)
+{
+    return (64 + i * 97) * BLOCK_SECTORS;
+}
+
+static vlc_tick_t Playback(struct fake_drive *d, vlc_disc_cache_t *c)
+{
+    uint8_t buf[BLOCK_SECTORS * SECTOR_SIZE];
+    vlc_tick_t start = vlc_tick_now();
+
+    for (unsigned chapter = 0; chapter < BENCH_CHAPTERS; chapter++)
+    {
+        uint64_t lba = ChapterStart(chapter);
+        for (unsigned i = 0; i < BENCH_BLOCKS / BENCH_CHAPTERS; i++)
+        {
+            int ret = c ? vlc_disc_cache_Read(c, buf, lba, BLOCK_SECTORS)
+                        : DriveRead(d, buf, lba, BLOCK_SECTORS);
+            assert(ret == BLOCK_SECTORS);
+            vlc_tick_wait(vlc_tick_now() + BENCH_CONSUME);
+            lba += BLOCK_SECTORS;
+        }
+    }
+    return vlc_tick_now() - start;
+}
+
+static void bench(vlc_object_t *obj)
+{
+    struct fake_drive d;
+    DriveInit(&d, VLC_TICK_FROM_MS(5), VLC_TICK_FROM_US(25));
+
+    vlc_tick_t direct = Playback(&d, NULL);
+    unsigned direct_seeks = d.seeks;
+
+    d.seeks = 0;
+    vlc_disc_cache_t *c = CacheNew(obj, &d, 64, 8);
+    const unsigned pin_reads = d.reads + BENCH_CHAPTERS * BENCH_PINNED;
+    for (unsigned i = 0; i < BENCH_CHAPTERS; i++)
+        vlc_disc_cache_Pin(c, ChapterStart(i), BENCH_PINNED * BLOCK_SECTORS);
+    WaitReads(&d, pin_reads);
+    unsigned pin_seeks = d.seeks;
+
+    vlc_tick_t cached = Playback(&d, c);
+    struct vlc_disc_cache_stats stats;
+    vlc_disc_cache_GetStats(c, &stats);
+    vlc_disc_cache_Delete(c);
+
+    printf("direct reads: %"PRId64" ms, %u seeks\n",
+           MS_FROM_VLC_TICK(direct), direct_seeks);
+    printf("disc cache:   %"PRId64" ms, %u seeks (%u pinning chapters), "
+           "%"PRIu64" hits, %"PRIu64" misses\n",
+           MS_FROM_VLC_TICK(cached), d.seeks, pin_seeks,
+           stats.hits, stats.misses);
+
+    DriveClean(&d);
+}
+
+int main(void)
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(0, NULL);
+    assert(vlc);
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    test_read(obj);
+    test_elevator(obj);
+    test_pin(obj);
+
+    /* Timings are noise in a test run, compare them on demand */
+    if (getenv("VLC_TEST_BENCH") != NULL)
+        bench(obj);
+
+    libvlc_release(vlc);
+    return 0;
+}
@@ -0,0 +1,280 @@
+/*****************************************************************************
+ * uring.c: io_uring file reader tests and benchmark
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_tick.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "../../../modules/access/uring_reader.h"
+
+#include "../../libvlc/test.h"
+
+#define BLOCK_SIZE  (64 * 1024)
+#define DEPTH       4
+#define FILE_SIZE   (5 * 1024 * 1024 + 1234) /* short last block */
+
+static uint8_t FileByte(uint64_t offset)
+{
+    return (offset * 7 + (offset >> 16)) & 0xFF;
+}
+
+static FILE *CreateFile(uint64_t size)
+{
+    FILE *file = tmpfile();
+    assert(file != NULL);
+
+    uint8_t buf[4096];
+    for (uint64_t offset = 0; offset < size; offset += sizeof (buf))
+    {
+        size_t len = __MIN(sizeof (buf), size - offset);
+        for (size_t i = 0; i < len; i++)
+            buf[i] = FileByte(offset + i);
+        assert(fwrite(buf, 1, len, file) == len);
+    }
+    assert(fflush(file) == 0);
+    return file;
+}
+
+static vlc_uring_reader_t *ReaderNew(FILE *file, size_t block_size,
+                                     unsigned depth)
+{
+    const struct vlc_uring_reader_cfg cfg = {
+        .fd = fileno(file),
+        .block_size = block_size,
+        .depth = depth,
+    };
+    return vlc_uring_reader_New(&cfg);
+}
+
+static void CheckBlock(const block_t *block, uint64_t offset)
+{
+    assert(block->i_buffer > 0);
+    for (size_t i = 0; i < block->i_buffer; i++)
+        assert(block->p_buffer[i] == FileByte(offset + i));
+}
+
+/* Reads and checks a block, returns the offset after it */
+static uint64_t ReadBlock(vlc_uring_reader_t *r, uint64_t offset)
+{
+    bool eof;
+    block_t *block = vlc_uring_reader_Read(r, &eof);
+
+    assert(block != NULL && !eof);
+    CheckBlock(block, offset);
+    offset += block->i_buffer;
+    block_Release(block);
+    return offset;
+}
+
+static void CheckEOF(vlc_uring_reader_t *r)
+{
+    bool eof;
+
+    assert(vlc_uring_reader_Read(r, &eof) == NULL);
+    assert(eof && errno == 0);
+}
+
+static void test_read(FILE *file)
+{
+    vlc_uring_reader_t *r = ReaderNew(file, BLOCK_SIZE, DEPTH);
+    uint64_t offset = 0;
+
+    assert(vlc_uring_reader_GetSize(r) == FILE_SIZE);
+    while (offset < FILE_SIZE)
+        offset = ReadBlock(r, offset);
+    assert(offset == FILE_SIZE);
+    CheckEOF(r);
+    vlc_uring_reader_Delete(r);
+}
+
+static void test_seek(FILE *file)
+{
+    vlc_uring_reader_t *r = ReaderNew(file, BLOCK_SIZE, DEPTH);
+    uint64_t offset = 0;
+
+    offset = ReadBlock(r, offset);
+    offset = ReadBlock(r, offset);
+
+    /* Forward, into a read in flight */
+    offset += BLOCK_SIZE + 100;
+    vlc_uring_reader_Seek(r, offset);
+    offset = ReadBlock(r, offset);
+    offset = ReadBlock(r, offset);
+
+    /* Backward, unaligned */
+    offset = 12345;
+    vlc_uring_reader_Seek(r, offset);
+    for (unsigned i = 0; i < 3 * DEPTH; i++)
+        offset = ReadBlock(r, offset);
+
+    /* Far forward, then back to the start */
+    offset = FILE_SIZE / 2 + 1;
+    vlc_uring_reader_Seek(r, offset);
+    offset = ReadBlock(r, offset);
+    vlc_uring_reader_Seek(r, 0);
+    assert(ReadBlock(r, 0) == BLOCK_SIZE);
+
+    /* Into the last block, and past the end */
+    offset = FILE_SIZE - 10;
+    vlc_uring_reader_Seek(r, offset);
+    assert(ReadBlock(r, offset) == FILE_SIZE);
+    CheckEOF(r);
+    vlc_uring_reader_Seek(r, FILE_SIZE + 1);
+    CheckEOF(r);
+
+    vlc_uring_reader_Delete(r);
+}
+
+static void test_hold(FILE *file)
+{
+    vlc_uring_reader_t *r = ReaderNew(file, BLOCK_SIZE, DEPTH);
+    block_t *held[4 * DEPTH];
+    uint64_t offsets[ARRAY_SIZE(held)];
+    uint64_t offset = 0;
+
+    /* More blocks than buffers: the last ones are read synchronously */
+    for (size_t i = 0; i < ARRAY_SIZE(held); i++)
+    {
+        bool eof;
+
+        held[i] = vlc_uring_reader_Read(r, &eof);
+        assert(held[i] != NULL && !eof);
+        offsets[i] = offset;
+        offset += held[i]->i_buffer;
+    }
+    /* The first block comes from a buffer of the reader */
+    const struct vlc_frame_callbacks *slot_cbs = held[0]->cbs;
+    for (size_t i = 0; i < ARRAY_SIZE(held); i++)
+    {
+        CheckBlock(held[i], offsets[i]);
+        block_Release(held[i]);
+    }
+
+    /* The buffers are queued again */
+    for (unsigned i = 0; i < 2 * DEPTH; i++)
+    {
+        bool eof;
+        block_t *block = vlc_uring_reader_Read(r, &eof);
+
+        assert(block != NULL && !eof);
+        assert(block->cbs == slot_cbs);
+        CheckBlock(block, offset);
+        offset += block->i_buffer;
+        block_Release(block);
+    }
+
+    /* A block outlives the reader */
+    bool eof;
+    block_t *block = vlc_uring_reader_Read(r, &eof);
+    assert(block != NULL);
+    vlc_uring_reader_Delete(r);
+    CheckBlock(block, offset);
+    block_Release(block);
+}
+
+/*
+ * Benchmark
+ */
+#define BENCH_SIZE       (128 * 1024 * 1024)
+#define BENCH_BLOCK_SIZE (1024 * 1024)
+
+static void bench_report(const char *name, vlc_tick_t elapsed,
+                         unsigned blocks)
+{
+    double secs = secf_from_vlc_tick(elapsed);
+    printf("%-10s %7.1f MB/s, %6.1f us per block\n", name,
+           BENCH_SIZE / secs / 1e6, secs * 1e6 / blocks);
+}
+
+static void bench(void)
+{
+    FILE *file = CreateFile(BENCH_SIZE);
+    const int fd = fileno(file);
+
+    uint8_t *buf = malloc(BENCH_BLOCK_SIZE);
+    assert(buf != NULL);
+
+    unsigned blocks = 0;
+    uint64_t offset = 0;
+    vlc_tick_t start = vlc_tick_now();
+    for (;;)
+    {
+        ssize_t val = pread(fd, buf, BENCH_BLOCK_SIZE, offset);
+        assert(val >= 0);
+        if (val == 0)
+            break;
+        offset += val;
+        blocks++;
+    }
+    bench_report("read()", vlc_tick_now() - start, blocks);
+    assert(offset == BENCH_SIZE);
+    free(buf);
+
+    vlc_uring_reader_t *r = ReaderNew(file, BENCH_BLOCK_SIZE, 8);
+    block_t *block;
+    bool eof;
+
+    blocks = 0;
+    offset = 0;
+    start = vlc_tick_now();
+    while ((block = vlc_uring_reader_Read(r, &eof)) != NULL)
+    {
+        offset += block->i_buffer;
+        block_Release(block);
+        blocks++;
+    }
+    bench_report("io_uring", vlc_tick_now() - start, blocks);
+    assert(offset == BENCH_SIZE);
+    vlc_uring_reader_Delete(r);
+
+    fclose(file);
+}
+
+int main(void)
+{
+    test_init();
+
+    FILE *file = CreateFile(FILE_SIZE);
+    vlc_uring_reader_t *r = ReaderNew(file, BLOCK_SIZE, DEPTH);
+    if (r == NULL)
+    {
+        fprintf(stderr, "io_uring not available, skipping\n");
+        fclose(file);
+        return 77;
+    }
+    vlc_uring_reader_Delete(r);
+
+    test_read(file);
+    test_seek(file);
+    test_hold(file);
+    fclose(file);
+
+    /* Timings are noise in a test run, compare them on demand */
+    if (getenv("VLC_TEST_BENCH") != NULL)
+        bench();
+    return 0;
+}
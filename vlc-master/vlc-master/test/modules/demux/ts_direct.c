@@ -0,0 +1,314 @@
+/*****************************************************************************
+ * ts_direct.c: MPEG TS demuxer run in place on data pushed by its owner
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_demux.h>
+#include <vlc_es_out.h>
+#include <vlc_stream.h>
+
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/test.h"
+
+/* Same setup as the BluRay access: M2TS units queued by the read loop and
+ * the demuxer run until the queue is drained, before more is queued. */
+
+#define M2TS_PACKET_SIZE   192
+#define PID_PMT            0x0100
+#define PID_VIDEO          0x1011
+
+struct queue
+{
+    block_t *p_head;
+    block_t **pp_last;
+};
+
+static block_t *QueueBlock( stream_t *s, bool *restrict eof )
+{
+    struct queue *q = s->p_sys;
+    block_t *p_block = q->p_head;
+
+    *eof = p_block == NULL;
+    if( p_block == NULL )
+        return NULL;
+
+    q->p_head = p_block->p_next;
+    if( q->p_head == NULL )
+        q->pp_last = &q->p_head;
+    p_block->p_next = NULL;
+    return p_block;
+}
+
+static int QueueControl( stream_t *s, int i_query, va_list args )
+{
+    VLC_UNUSED(s);
+
+    switch( i_query )
+    {
+        case STREAM_CAN_SEEK:
+        case STREAM_CAN_FASTSEEK:
+        case STREAM_CAN_PAUSE:
+        case STREAM_CAN_CONTROL_PACE:
+            *va_arg( args, bool * ) = false;
+            return VLC_SUCCESS;
+        case STREAM_GET_PTS_DELAY:
+            *va_arg( args, vlc_tick_t * ) = 0;
+            return VLC_SUCCESS;
+        default:
+            return VLC_EGENERIC;
+    }
+}
+
+static void QueueDestroy( stream_t *s )
+{
+    struct queue *q = s->p_sys;
+    block_ChainRelease( q->p_head );
+}
+
+struct out
+{
+    es_out_t es_out;
+    unsigned i_added;
+    unsigned i_sent;
+};
+
+static es_out_id_t *OutAdd( es_out_t *out, input_source_t *in,
+                            const es_format_t *fmt )
+{
+    VLC_UNUSED(in);
+    struct out *sys = container_of( out, struct out, es_out );
+
+    assert( fmt->i_id == PID_VIDEO );
+    assert( fmt->i_codec == VLC_CODEC_H264 );
+    sys->i_added++;
+    return (es_out_id_t *)sys;
+}
+
+static int OutSend( es_out_t *out, es_out_id_t *id, block_t *p_block )
+{
+    struct out *sys = container_of( out, struct out, es_out );
+
+    assert( id == (es_out_id_t *)sys );
+    assert( p_block->i_buffer > 0 );
+    sys->i_sent++;
+    block_ChainRelease( p_block );
+    return VLC_SUCCESS;
+}
+
+static void OutDel( es_out_t *out, es_out_id_t *id )
+{
+    VLC_UNUSED(out);
+    VLC_UNUSED(id);
+}
+
+static int OutControl( es_out_t *out, input_source_t *in, int i_query,
+                       va_list args )
+{
+    VLC_UNUSED(out);
+    VLC_UNUSED(in);
+
+    switch( i_query )
+    {
+        case ES_OUT_GET_ES_STATE:
+            (void) va_arg( args, es_out_id_t * );
+            *va_arg( args, bool * ) = true;
+            return VLC_SUCCESS;
+        default:
+            return VLC_EGENERIC;
+    }
+}
+
+static void OutDestroy( es_out_t *out )
+{
+    VLC_UNUSED(out);
+}
+
+static const struct es_out_callbacks out_cbs =
+{
+    .add = OutAdd,
+    .send = OutSend,
+    .del = OutDel,
+    .control = OutControl,
+    .destroy = OutDestroy,
+};
+
+static unsigned i_read_errors;
+
+static void LogCallback( void *data, int level, const libvlc_log_t *ctx,
+                         const char *fmt, va_list args )
+{
+    VLC_UNUSED(data);
+    VLC_UNUSED(level);
+    VLC_UNUSED(ctx);
+
+    char psz_msg[256];
+    vsnprintf( psz_msg, sizeof (psz_msg), fmt, args );
+    if( strstr( psz_msg, "Can't read TS packet" ) != NULL )
+        i_read_errors++;
+}
+
+static uint32_t CRC32( const uint8_t *p, size_t i_size )
+{
+    uint32_t i_crc = 0xFFFFFFFF;
+    while( i_size-- )
+    {
+        i_crc ^= (uint32_t)*p++ << 24;
+        for( int i = 0; i < 8; i++ )
+            i_crc = (i_crc << 1) ^ ((i_crc & 0x80000000) ? 0x04C11DB7 : 0);
+    }
+    return i_crc;
+}
+
+/* 4 bytes arrival time stamp then the TS header, returns the payload */
+static uint8_t *WriteHeader( uint8_t *p, uint16_t i_pid, bool b_adaptation,
+                             uint8_t *pi_cc )
+{
+    memset( p, 0, 4 );
+    p[4] = 0x47;
+    p[5] = 0x40 | (i_pid >> 8); /* payload unit start */
+    p[6] = i_pid & 0xFF;
+    p[7] = (b_adaptation ? 0x30 : 0x10) | ((*pi_cc)++ & 0x0F);
+    return &p[8];
+}
+
+static void WriteSection( uint8_t *p, uint16_t i_pid, uint8_t *pi_cc,
+                          const uint8_t *p_section, size_t i_section )
+{
+    uint8_t *p_payload = WriteHeader( p, i_pid, false, pi_cc );
+    memset( p_payload, 0xFF, &p[M2TS_PACKET_SIZE] - p_payload );
+    p_payload[0] = 0; /* pointer field */
+    memcpy( &p_payload[1], p_section, i_section );
+    SetDWBE( &p_payload[1 + i_section], CRC32( p_section, i_section ) );
+}
+
+static void WritePES( uint8_t *p, uint8_t *pi_cc, uint64_t i_pcr )
+{
+    uint8_t *p_af = WriteHeader( p, PID_VIDEO, true, pi_cc );
+    p_af[0] = 7;
+    p_af[1] = 0x10; /* PCR flag */
+    p_af[2] = i_pcr >> 25;
+    p_af[3] = i_pcr >> 17;
+    p_af[4] = i_pcr >> 9;
+    p_af[5] = i_pcr >> 1;
+    p_af[6] = ((i_pcr & 1) << 7) | 0x7E;
+    p_af[7] = 0;
+
+    const uint64_t i_pts = i_pcr + 9000;
+    uint8_t *p_pes = &p_af[8];
+    static const uint8_t pes_header[] = {
+        0x00, 0x00, 0x01, 0xE0, 0x00, 0x00, 0x80, 0x80, 0x05,
+    };
+    memcpy( p_pes, pes_header, sizeof (pes_header) );
+    p_pes += sizeof (pes_header);
+    p_pes[0] = 0x21 | ((i_pts >> 29) & 0x0E);
+    p_pes[1] = i_pts >> 22;
+    p_pes[2] = ((i_pts >> 14) & 0xFE) | 0x01;
+    p_pes[3] = i_pts >> 7;
+    p_pes[4] = ((i_pts << 1) & 0xFE) | 0x01;
+    p_pes += 5;
+
+    static const uint8_t aud[] = { 0x00, 0x00, 0x00, 0x01, 0x09, 0xF0 };
+    memcpy( p_pes, aud, sizeof (aud) );
+    p_pes += sizeof (aud);
+    memset( p_pes, 0, &p[M2TS_PACKET_SIZE] - p_pes );
+}
+
+static void Push( struct queue *q, const uint8_t *p_data, size_t i_data )
+{
+    block_t *p_block = block_Alloc( i_data );
+    assert( p_block );
+    memcpy( p_block->p_buffer, p_data, i_data );
+    block_ChainLastAppend( &q->pp_last, p_block );
+}
+
+static void Drain( demux_t *p_ts )
+{
+    while( demux_Demux( p_ts ) == VLC_DEMUXER_SUCCESS );
+}
+
+int main( void )
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new( 0, NULL );
+    assert( vlc );
+    libvlc_log_set( vlc, LogCallback, NULL );
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    struct queue q = { .p_head = NULL, .pp_last = &q.p_head };
+    stream_t *s = vlc_stream_CommonNew( obj, QueueDestroy );
+    assert( s );
+    s->p_sys = &q;
+    s->pf_block = QueueBlock;
+    s->pf_control = QueueControl;
+
+    struct out out = { .es_out = { .cbs = &out_cbs } };
+
+    /* Nothing to probe yet: the packet size is not detected */
+    demux_t *p_ts = demux_New( obj, "m2ts", "vlc://nop", s, &out.es_out );
+    assert( p_ts );
+    demux_Control( p_ts, DEMUX_SET_GROUP_ALL );
+    Drain( p_ts );
+
+    static const uint8_t pat[] = {
+        0x00, 0xB0, 0x0D, 0x00, 0x01, 0xC1, 0x00, 0x00,
+        0x00, 0x01, 0xE0 | (PID_PMT >> 8), PID_PMT & 0xFF,
+    };
+    static const uint8_t pmt[] = {
+        0x02, 0xB0, 0x12, 0x00, 0x01, 0xC1, 0x00, 0x00,
+        0xE0 | (PID_VIDEO >> 8), PID_VIDEO & 0xFF, 0xF0, 0x00,
+        0x1B, 0xE0 | (PID_VIDEO >> 8), PID_VIDEO & 0xFF, 0xF0, 0x00,
+    };
+    uint8_t cc_pat = 0, cc_pmt = 0, cc_video = 0;
+    uint8_t packets[2 * M2TS_PACKET_SIZE];
+
+    /* Units split across runs are resumed once the rest is pushed */
+    WriteSection( &packets[0], 0x0000, &cc_pat, pat, sizeof (pat) );
+    WriteSection( &packets[M2TS_PACKET_SIZE], PID_PMT, &cc_pmt,
+                  pmt, sizeof (pmt) );
+    Push( &q, packets, M2TS_PACKET_SIZE + 100 );
+    Drain( p_ts );
+    Push( &q, &packets[M2TS_PACKET_SIZE + 100], M2TS_PACKET_SIZE - 100 );
+    Drain( p_ts );
+
+    /* The ES is created on the first data of its program, then each PES is
+     * sent once the next one starts */
+    for( unsigned i = 0; i < 3; i++ )
+    {
+        WritePES( packets, &cc_video, 90000 * (i + 1) );
+        Push( &q, packets, M2TS_PACKET_SIZE );
+        Drain( p_ts );
+        assert( out.i_added == 1 );
+    }
+    assert( out.i_sent >= 1 );
+
+    /* Running dry is the normal end of each run, not an error */
+    assert( i_read_errors == 0 );
+
+    demux_Delete( p_ts ); /* and the queue stream */
+    libvlc_release( vlc );
+    return 0;
+}
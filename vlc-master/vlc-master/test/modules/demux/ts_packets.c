@@ -0,0 +1,197 @@
+/*****************************************************************************
+ * ts_packets.c: MPEG TS batched packets input tests and benchmark
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_stream.h>
+#include <vlc_tick.h>
+
+#include "../../../modules/demux/mpeg/ts_packets.h"
+
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/test.h"
+
+/* The module code under test logs */
+const char vlc_module_name[] = "test_ts_packets";
+
+#define M2TS_PACKET_SIZE   192
+#define M2TS_HEADER_SIZE   4
+#define PACKET_COUNT       (1 << 16)
+#define BENCH_PASSES       8
+
+static const uint16_t pids[] = { 0x0000, 0x1011, 0x1011, 0x1011, 0x1100, 0x1FFF };
+
+/* Synthetic BluRay M2TS: 4 bytes arrival timestamp then a TS packet */
+static uint8_t * GenerateM2TS( size_t i_count, size_t i_garbage_at,
+                               size_t i_garbage, size_t *pi_size )
+{
+    size_t i_size = i_count * M2TS_PACKET_SIZE + i_garbage;
+    uint8_t *p_data = malloc( i_size );
+    assert( p_data );
+
+    uint8_t *p = p_data;
+    uint8_t cc[ARRAY_SIZE(pids)] = { 0 };
+    for( size_t i = 0; i < i_count; i++ )
+    {
+        if( i == i_garbage_at )
+        {
+            memset( p, 0xA5, i_garbage );
+            p += i_garbage;
+        }
+
+        const size_t i_pid = i % ARRAY_SIZE(pids);
+        SetDWBE( p, (uint32_t)(i * 1234) & 0x3F3F3F3F ); /* arrival time stamp */
+        p[4] = 0x47;
+        p[5] = (i % 16 == 0 ? 0x40 : 0x00) | (pids[i_pid] >> 8);
+        p[6] = pids[i_pid] & 0xFF;
+        p[7] = 0x10 | (cc[i_pid]++ & 0x0F);
+        for( size_t j = 8; j < M2TS_PACKET_SIZE; j++ )
+            p[j] = (i + j) & 0x3F; /* never a sync byte */
+        p += M2TS_PACKET_SIZE;
+    }
+
+    *pi_size = i_size;
+    return p_data;
+}
+
+static uint16_t PID( const block_t *p_pkt )
+{
+    return ((p_pkt->p_buffer[1] & 0x1F) << 8) | p_pkt->p_buffer[2];
+}
+
+static void test_read( vlc_object_t *obj, size_t i_garbage )
+{
+    size_t i_size;
+    uint8_t *p_data = GenerateM2TS( PACKET_COUNT, PACKET_COUNT / 3,
+                                    i_garbage, &i_size );
+    stream_t *s = vlc_stream_MemoryNew( obj, p_data, i_size, false );
+    assert( s );
+
+    ts_packets_t packets;
+    assert( ts_packets_Init( &packets, M2TS_PACKET_SIZE, M2TS_HEADER_SIZE ) == VLC_SUCCESS );
+
+    size_t i_count = 0;
+    block_t *p_pkt;
+    while( (p_pkt = ts_packets_Read( &packets, obj, s )) )
+    {
+        assert( p_pkt->i_buffer == M2TS_PACKET_SIZE - M2TS_HEADER_SIZE );
+        assert( p_pkt->p_buffer[0] == 0x47 );
+        assert( PID( p_pkt ) == pids[i_count % ARRAY_SIZE(pids)] );
+        block_Release( p_pkt );
+        i_count++;
+
+        /* Logical position matches what was consumed */
+        if( i_garbage == 0 )
+            assert( vlc_stream_Tell( s ) - ts_packets_Buffered( &packets ) ==
+                    i_count * M2TS_PACKET_SIZE );
+    }
+    assert( i_count == PACKET_COUNT );
+
+    /* Seek back and read again after flush */
+    ts_packets_Flush( &packets );
+    assert( vlc_stream_Seek( s, M2TS_PACKET_SIZE ) == VLC_SUCCESS );
+    p_pkt = ts_packets_Read( &packets, obj, s );
+    assert( p_pkt && PID( p_pkt ) == pids[1] );
+
+    ts_packets_Clean( &packets );
+    vlc_stream_Delete( s );
+}
+
+static void bench( vlc_object_t *obj )
+{
+    size_t i_size;
+    uint8_t *p_data = GenerateM2TS( PACKET_COUNT, SIZE_MAX, 0, &i_size );
+    stream_t *s = vlc_stream_MemoryNew( obj, p_data, i_size, false );
+    assert( s );
+
+    /* Before: one stream call and one allocation per packet */
+    unsigned i_sum = 0;
+    vlc_tick_t start = vlc_tick_now();
+    for( unsigned pass = 0; pass < BENCH_PASSES; pass++ )
+    {
+        assert( vlc_stream_Seek( s, 0 ) == VLC_SUCCESS );
+        block_t *p_pkt;
+        while( (p_pkt = vlc_stream_Block( s, M2TS_PACKET_SIZE )) )
+        {
+            p_pkt->p_buffer += M2TS_HEADER_SIZE;
+            p_pkt->i_buffer -= M2TS_HEADER_SIZE;
+            i_sum += PID( p_pkt );
+            block_Release( p_pkt );
+        }
+    }
+    vlc_tick_t before = vlc_tick_now() - start;
+
+    /* After: batched reads, allocations for PES payloads only */
+    ts_packets_t packets;
+    assert( ts_packets_Init( &packets, M2TS_PACKET_SIZE, M2TS_HEADER_SIZE ) == VLC_SUCCESS );
+    unsigned i_sum2 = 0;
+    start = vlc_tick_now();
+    for( unsigned pass = 0; pass < BENCH_PASSES; pass++ )
+    {
+        ts_packets_Flush( &packets );
+        assert( vlc_stream_Seek( s, 0 ) == VLC_SUCCESS );
+        block_t *p_pkt;
+        while( (p_pkt = ts_packets_Read( &packets, obj, s )) )
+        {
+            uint16_t i_pid = PID( p_pkt );
+            i_sum2 += i_pid;
+            if( i_pid == 0x1011 || i_pid == 0x1100 )
+            {
+                block_t *p_payload = block_Alloc( p_pkt->i_buffer - 4 );
+                assert( p_payload );
+                memcpy( p_payload->p_buffer, &p_pkt->p_buffer[4], p_payload->i_buffer );
+                block_Release( p_payload );
+            }
+            block_Release( p_pkt );
+        }
+    }
+    vlc_tick_t after = vlc_tick_now() - start;
+    assert( i_sum == i_sum2 );
+
+    const double packets_count = (double) PACKET_COUNT * BENCH_PASSES;
+    printf( "per packet block: %.0f packets/s\n",
+            packets_count / secf_from_vlc_tick( before ) );
+    printf( "batched views:    %.0f packets/s\n",
+            packets_count / secf_from_vlc_tick( after ) );
+
+    ts_packets_Clean( &packets );
+    vlc_stream_Delete( s );
+}
+
+int main( void )
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new( 0, NULL );
+    assert( vlc );
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    test_read( obj, 0 );
+    test_read( obj, 37 ); /* resync over garbage */
+    /* Timings are noise in a test run, compare them on demand */
+    if( getenv( "VLC_TEST_BENCH" ) != NULL )
+        bench( obj );
+
+    libvlc_release( vlc );
+    return 0;
+}
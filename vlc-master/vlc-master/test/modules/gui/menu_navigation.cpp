@@ -0,0 +1,130 @@
+/*****************************************************************************
+ * menu_navigation.cpp: 8KDVD menu navigation tests
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <vlc_common.h>
+
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/test.h"
+
+#include "../../../modules/gui/cef/html5_menu_system.h"
+#include "../../../modules/gui/cef/menu_navigation.h"
+
+const char vlc_module_name[] = "test_menu_navigation";
+
+/* The navigation only shows other menus through the menu system, which is
+ * not attached here */
+int html5_menu_system_show_menu(html5_menu_system_t *, const char *)
+{
+    assert(!"unexpected menu change");
+    return -1;
+}
+
+int html5_menu_system_hide_menu(html5_menu_system_t *)
+{
+    assert(!"unexpected menu change");
+    return -1;
+}
+
+#define MENU_WIDTH  7680
+#define MENU_HEIGHT 4320
+#define VIEW_WIDTH  1920
+#define VIEW_HEIGHT 1080
+
+/* Same column as the disc menus, in menu coordinates */
+static std::vector<menu_item_t> NewItems(int count)
+{
+    std::vector<menu_item_t> items(count);
+    const int width = MENU_WIDTH / 4, height = MENU_HEIGHT / 12;
+
+    for (int i = 0; i < count; i++)
+    {
+        items[i].x = (MENU_WIDTH - width) / 2;
+        items[i].y = MENU_HEIGHT / 4 + i * height * 3 / 2;
+        items[i].width = width;
+        items[i].height = height;
+        items[i].enabled = items[i].visible = true;
+    }
+    return items;
+}
+
+/* Centre of an item, where the mouse is in the view */
+static void ItemCentre(const menu_item_t &item, int *x, int *y)
+{
+    *x = (item.x + item.width / 2) * VIEW_WIDTH / MENU_WIDTH;
+    *y = (item.y + item.height / 2) * VIEW_HEIGHT / MENU_HEIGHT;
+}
+
+static void test_mouse(vlc_object_t *obj)
+{
+    menu_navigation_t *nav = menu_navigation_create(obj);
+    assert(nav != NULL);
+
+    std::vector<menu_item_t> items = NewItems(3);
+    assert(menu_navigation_set_menu_size(nav, MENU_WIDTH, MENU_HEIGHT) == 0);
+    assert(menu_navigation_set_view_size(nav, VIEW_WIDTH, VIEW_HEIGHT) == 0);
+    assert(menu_navigation_set_menu_items(nav, "8kdvd_main", items.data(),
+                                          (int)items.size()) == 0);
+    assert(menu_navigation_get_current_item(nav) == 0);
+
+    /* Hovering the centre of an item highlights it */
+    int x, y;
+    ItemCentre(items[2], &x, &y);
+    assert(menu_navigation_mouse_move(nav, x, y) == 2);
+    assert(menu_navigation_get_current_item(nav) == 2);
+
+    /* Outside of the items, the highlight stays */
+    assert(menu_navigation_mouse_move(nav, 0, 0) == -1);
+    assert(menu_navigation_get_current_item(nav) == 2);
+
+    /* Clicking the centre of the first item, which plays the title, selects
+     * it */
+    ItemCentre(items[0], &x, &y);
+    assert(menu_navigation_mouse_click(nav, x, y) == 0);
+    assert(menu_navigation_get_current_item(nav) == 0);
+
+    /* In menu coordinates, the same position is out of the menu */
+    assert(menu_navigation_hit_test(nav, items[0].x + items[0].width / 2,
+                                    items[0].y + items[0].height / 2) == -1);
+
+    /* Hidden items can't be hit */
+    items[1].visible = false;
+    assert(menu_navigation_set_menu_items(nav, "8kdvd_main", items.data(),
+                                          (int)items.size()) == 0);
+    ItemCentre(items[1], &x, &y);
+    assert(menu_navigation_mouse_click(nav, x, y) == -1);
+
+    menu_navigation_destroy(nav);
+}
+
+int main(void)
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(0, NULL);
+    assert(vlc != NULL);
+
+    test_mouse(VLC_OBJECT(vlc->p_libvlc_int));
+
+    libvlc_release(vlc);
+    return 0;
+}
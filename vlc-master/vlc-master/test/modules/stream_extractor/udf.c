@@ -0,0 +1,426 @@
+/*****************************************************************************
+ * udf.c: UDF file system reader tests
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <vlc_common.h>
+
+#include <stdio.h>
+
+#include "../../../modules/stream_extractor/udf_fs.h"
+
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/test.h"
+
+/* The module code under test logs */
+const char vlc_module_name[] = "test_udf";
+
+/* A UDF 2.50 image: the file entries are in the metadata partition, whose
+ * file is split in two extents of the physical partition */
+#define SS            2048
+#define PART_START    300
+#define PART_LENGTH   256
+#define IMAGE_SIZE    ((PART_START + PART_LENGTH) * SS)
+#define MAIN_VDS      32
+#define RESERVE_VDS   48
+
+#define PAYLOAD_SIZE  (5 * SS + 100)
+#define PAYLOAD_MTIME INT64_C(1715945415) /* 2024-05-17 12:30:15 +01:00 */
+
+static const uint32_t metadata_blocks[] = { 10, 11, 12, 13, 20, 21, 22, 23 };
+
+enum
+{
+    META_FSD,
+    META_ROOT,
+    META_ROOT_FIDS,
+    META_DVD_TS,
+    META_PAYLOAD,
+    META_PAYLOAD_AED,
+    META_README,
+};
+
+static const char readme[] = "hello udf\n";
+
+struct image
+{
+    uint8_t *data;
+    unsigned reads;
+};
+
+static uint8_t PayloadByte(uint64_t offset)
+{
+    return (offset * 13 + (offset >> 11) + 7) & 0xFF;
+}
+
+static uint16_t Crc16(const uint8_t *p, size_t length)
+{
+    uint16_t crc = 0;
+
+    while (length--)
+    {
+        crc ^= *p++ << 8;
+        for (unsigned i = 0; i < 8; i++)
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+/* Completes a descriptor once its content is written */
+static void SetTag(uint8_t *p, uint16_t id, uint32_t location, size_t length)
+{
+    uint8_t sum = 0;
+
+    SetWLE(p, id);
+    SetWLE(p + 2, 3);
+    SetWLE(p + 8, Crc16(p + 16, length - 16));
+    SetWLE(p + 10, length - 16);
+    SetDWLE(p + 12, location);
+    for (unsigned i = 0; i < 16; i++)
+        if (i != 4)
+            sum += p[i];
+    p[4] = sum;
+}
+
+static uint8_t *Sector(struct image *img, uint32_t sector)
+{
+    return img->data + (size_t)sector * SS;
+}
+
+static uint8_t *Physical(struct image *img, uint32_t lbn)
+{
+    return Sector(img, PART_START + lbn);
+}
+
+static uint8_t *Metadata(struct image *img, uint32_t lbn)
+{
+    return Physical(img, metadata_blocks[lbn]);
+}
+
+static void SetLongAD(uint8_t *p, uint32_t length, uint32_t lbn,
+                      uint16_t partref)
+{
+    SetDWLE(p, length);
+    SetDWLE(p + 4, lbn);
+    SetWLE(p + 8, partref);
+}
+
+/* Writes the header of a file entry, returns the allocation descriptors */
+static uint8_t *SetEntry(uint8_t *p, bool extended, uint8_t file_type,
+                         unsigned ad_type, uint64_t size, uint32_t ad_length)
+{
+    const size_t ad_offset = extended ? 216 : 176;
+    uint8_t *mtime = p + (extended ? 92 : 84);
+
+    p[16 + 11] = file_type;
+    SetWLE(p + 16 + 18, ad_type);
+    SetQWLE(p + 56, size);
+
+    /* Local time, UTC+1 */
+    SetWLE(mtime, 0x1000 | 60);
+    SetWLE(mtime + 2, 2024);
+    mtime[4] = 5;
+    mtime[5] = 17;
+    mtime[6] = 12;
+    mtime[7] = 30;
+    mtime[8] = 15;
+
+    SetDWLE(p + ad_offset - 8, 0);
+    SetDWLE(p + ad_offset - 4, ad_length);
+    return p + ad_offset;
+}
+
+static size_t SetFID(uint8_t *p, uint32_t location, uint8_t flags,
+                     const char *name, size_t name_length, uint32_t lbn)
+{
+    SetWLE(p + 16, 1);
+    p[18] = flags;
+    p[19] = name_length;
+    SetLongAD(p + 20, SS, lbn, 1);
+    SetWLE(p + 36, 0);
+    memcpy(p + 38, name, name_length);
+    SetTag(p, 257, location, 38 + name_length);
+    return (38 + name_length + 3) & ~3;
+}
+
+static void WriteVDS(struct image *img, uint32_t location)
+{
+    uint8_t *pd = Sector(img, location);
+    SetWLE(pd + 22, 0);
+    SetDWLE(pd + 188, PART_START);
+    SetDWLE(pd + 192, PART_LENGTH);
+    SetTag(pd, 5, location, 512);
+
+    uint8_t *lvd = Sector(img, location + 1);
+    SetDWLE(lvd + 212, SS);
+    SetLongAD(lvd + 248, SS, META_FSD, 1);
+    SetDWLE(lvd + 264, 6 + 64);
+    SetDWLE(lvd + 268, 2);
+
+    uint8_t *map = lvd + 440;
+    map[0] = 1;
+    map[1] = 6;
+    SetWLE(map + 2, 1);
+    SetWLE(map + 4, 0);
+
+    map += 6;
+    map[0] = 2;
+    map[1] = 64;
+    memcpy(map + 5, "*UDF Metadata Partition", 23);
+    SetWLE(map + 36, 1);
+    SetWLE(map + 38, 0);
+    SetDWLE(map + 40, 0); /* metadata file */
+    SetDWLE(map + 44, 1); /* mirror */
+    SetDWLE(map + 48, UINT32_MAX);
+    SetTag(lvd, 6, location + 1, 440 + 6 + 64);
+
+    SetTag(Sector(img, location + 2), 8, location + 2, 512);
+}
+
+static void WriteMetadataFile(struct image *img, uint32_t lbn)
+{
+    uint8_t *p = Physical(img, lbn);
+    uint8_t *ad = SetEntry(p, true, 250, 0, 8 * SS, 16);
+
+    SetDWLE(ad, 4 * SS);
+    SetDWLE(ad + 4, metadata_blocks[0]);
+    SetDWLE(ad + 8, 4 * SS);
+    SetDWLE(ad + 12, metadata_blocks[4]);
+    SetTag(p, 266, lbn, 216 + 16);
+}
+
+static void CreateImage(struct image *img)
+{
+    img->data = calloc(1, IMAGE_SIZE);
+    assert(img->data != NULL);
+    img->reads = 0;
+
+    /* Volume recognition sequence */
+    static const char *const vrs[] = { "BEA01", "NSR03", "TEA01" };
+    for (unsigned i = 0; i < ARRAY_SIZE(vrs); i++)
+    {
+        uint8_t *p = Sector(img, 16 + i);
+        memcpy(p + 1, vrs[i], 5);
+        p[6] = 1;
+    }
+
+    uint8_t *avdp = Sector(img, 256);
+    SetDWLE(avdp + 16, 4 * SS);
+    SetDWLE(avdp + 20, MAIN_VDS);
+    SetDWLE(avdp + 24, 4 * SS);
+    SetDWLE(avdp + 28, RESERVE_VDS);
+    SetTag(avdp, 2, 256, 512);
+
+    WriteVDS(img, MAIN_VDS);
+    WriteVDS(img, RESERVE_VDS);
+    WriteMetadataFile(img, 0);
+    WriteMetadataFile(img, 1);
+
+    uint8_t *p = Metadata(img, META_FSD);
+    SetLongAD(p + 400, SS, META_ROOT, 1);
+    SetTag(p, 256, META_FSD, 512);
+
+    /* Root directory: the FIDs in their own block */
+    uint8_t *fids = Metadata(img, META_ROOT_FIDS);
+    size_t size = 0;
+    size += SetFID(fids + size, META_ROOT_FIDS, 0x0A, "", 0, META_ROOT);
+    size += SetFID(fids + size, META_ROOT_FIDS, 0x02, "\x08" "8KDVD_TS", 9,
+                   META_DVD_TS);
+    size += SetFID(fids + size, META_ROOT_FIDS, 0x04, "\x08" "GONE", 5,
+                   META_README);
+    size += SetFID(fids + size, META_ROOT_FIDS, 0x00,
+                   "\x10" "\0R\0e\0a\0d\0m\0e\0 \0\xe9\0.\0t\0x\0t", 25,
+                   META_README);
+
+    p = Metadata(img, META_ROOT);
+    SetLongAD(SetEntry(p, true, 4, 1, size, 16), size, META_ROOT_FIDS, 1);
+    SetTag(p, 266, META_ROOT, 216 + 16);
+
+    /* 8KDVD_TS: the FIDs embedded in the file entry */
+    p = Metadata(img, META_DVD_TS);
+    fids = p + 176;
+    size = 0;
+    size += SetFID(fids + size, META_DVD_TS, 0x0A, "", 0, META_ROOT);
+    size += SetFID(fids + size, META_DVD_TS, 0x00, "\x08" "PAYLOAD_0.EVO8",
+                   15, META_PAYLOAD);
+    SetEntry(p, false, 4, 3, size, size);
+    SetTag(p, 261, META_DVD_TS, 176 + size);
+
+    /* The payload: two contiguous extents, an unrecorded one, and the last
+     * one from an allocation extent descriptor */
+    p = Metadata(img, META_PAYLOAD);
+    uint8_t *ad = SetEntry(p, true, 5, 1, PAYLOAD_SIZE, 4 * 16);
+    SetLongAD(ad, 2 * SS, 100, 0);
+    SetLongAD(ad + 16, SS, 102, 0);
+    SetLongAD(ad + 32, (1u << 30) | SS, 0, 0);
+    SetLongAD(ad + 48, (3u << 30) | SS, META_PAYLOAD_AED, 1);
+    SetTag(p, 266, META_PAYLOAD, 216 + 4 * 16);
+
+    p = Metadata(img, META_PAYLOAD_AED);
+    SetDWLE(p + 20, 16);
+    SetLongAD(p + 24, SS + 100, 150, 0);
+    SetTag(p, 258, META_PAYLOAD_AED, 24 + 16);
+
+    for (uint64_t i = 0; i < 3 * SS; i++)
+        Physical(img, 100)[i] = PayloadByte(i);
+    for (uint64_t i = 0; i < SS + 100; i++)
+        Physical(img, 150)[i] = PayloadByte(4 * SS + i);
+
+    p = Metadata(img, META_README);
+    memcpy(SetEntry(p, false, 5, 3, strlen(readme), strlen(readme)),
+           readme, strlen(readme));
+    SetTag(p, 261, META_README, 176 + strlen(readme));
+}
+
+static int ReadImage(void *opaque, uint64_t offset, void *buf, size_t length)
+{
+    struct image *img = opaque;
+
+    img->reads++;
+    if (offset > IMAGE_SIZE || length > IMAGE_SIZE - offset)
+        return -1;
+    memcpy(buf, img->data + offset, length);
+    return 0;
+}
+
+static void test_probe(void)
+{
+    struct image img;
+    uint8_t vrs[VLC_UDF_VRS_SIZE];
+
+    CreateImage(&img);
+    assert(vlc_udf_Probe(img.data + VLC_UDF_VRS_OFFSET, VLC_UDF_VRS_SIZE));
+
+    /* ISO 9660 bridge */
+    memset(vrs, 0, sizeof (vrs));
+    memcpy(vrs + 1, "CD001", 5);
+    memcpy(vrs + 2048 + 1, "CD001", 5);
+    memcpy(vrs + 2 * 2048, img.data + VLC_UDF_VRS_OFFSET, 3 * 2048);
+    assert(vlc_udf_Probe(vrs, sizeof (vrs)));
+
+    /* ISO 9660 only, and truncated */
+    memset(vrs + 2 * 2048, 0, 3 * 2048);
+    assert(!vlc_udf_Probe(vrs, sizeof (vrs)));
+    assert(!vlc_udf_Probe(img.data + VLC_UDF_VRS_OFFSET, 2048));
+    free(img.data);
+}
+
+static void test_files(vlc_object_t *obj)
+{
+    struct image img;
+
+    CreateImage(&img);
+    vlc_udf_t *udf = vlc_udf_Open(obj, ReadImage, &img, IMAGE_SIZE);
+    assert(udf != NULL);
+
+    const struct vlc_udf_file *file =
+        vlc_udf_Lookup(udf, "8KDVD_TS/PAYLOAD_0.EVO8");
+    assert(file != NULL && !file->directory);
+    assert(file->size == PAYLOAD_SIZE);
+    assert(file->mtime == PAYLOAD_MTIME);
+
+    /* The contiguous extents are merged */
+    assert(file->extent_count == 3);
+    assert(file->extents[0].offset == 0);
+    assert(file->extents[0].length == 3 * SS);
+    assert(file->extents[0].position == (PART_START + 100) * SS);
+    assert(file->extents[1].position == VLC_UDF_SPARSE);
+    assert(file->extents[2].offset == 4 * SS);
+    assert(file->extents[2].position == (PART_START + 150) * SS);
+
+    /* Cached, whatever the case */
+    assert(vlc_udf_Lookup(udf, "/8kdvd_ts//payload_0.evo8") == file);
+    assert(vlc_udf_Lookup(udf, "8KDVD_TS")->directory);
+
+    /* One read per recorded extent, without any metadata */
+    uint8_t *buf = malloc(PAYLOAD_SIZE);
+    assert(buf != NULL);
+    img.reads = 0;
+    assert(vlc_udf_Read(udf, file, 0, buf, PAYLOAD_SIZE + 1) == PAYLOAD_SIZE);
+    assert(img.reads == 2);
+    for (uint64_t i = 0; i < PAYLOAD_SIZE; i++)
+        assert(buf[i] == (i / SS == 3 ? 0 : PayloadByte(i)));
+
+    assert(vlc_udf_Read(udf, file, 4 * SS - 10, buf, 30) == 30);
+    for (unsigned i = 0; i < 30; i++)
+        assert(buf[i] == (i < 10 ? 0 : PayloadByte(4 * SS - 10 + i)));
+    assert(vlc_udf_Read(udf, file, PAYLOAD_SIZE, buf, 1) == 0);
+    free(buf);
+
+    /* Embedded, with a 16-bits name */
+    char text[sizeof (readme)];
+    file = vlc_udf_Lookup(udf, "Readme \xc3\xa9.txt");
+    assert(file != NULL && file->data != NULL);
+    assert(vlc_udf_Read(udf, file, 0, text, sizeof (text)) == strlen(readme));
+    assert(!memcmp(text, readme, strlen(readme)));
+
+    assert(vlc_udf_Lookup(udf, "GONE") == NULL);
+    assert(vlc_udf_Lookup(udf, "8KDVD_TS/PAYLOAD_1.EVO8") == NULL);
+    assert(vlc_udf_Lookup(udf, "Readme \xc3\xa9.txt/x") == NULL);
+
+    vlc_udf_Close(udf);
+    free(img.data);
+}
+
+static void test_recovery(vlc_object_t *obj)
+{
+    struct image img;
+    vlc_udf_t *udf;
+
+    /* Mirror of the metadata file, reserve volume descriptors */
+    CreateImage(&img);
+    Physical(&img, 0)[4] ^= 1;
+    Sector(&img, MAIN_VDS + 1)[100] ^= 1;
+    udf = vlc_udf_Open(obj, ReadImage, &img, IMAGE_SIZE);
+    assert(udf != NULL);
+    assert(vlc_udf_Lookup(udf, "8KDVD_TS/PAYLOAD_0.EVO8") != NULL);
+    vlc_udf_Close(udf);
+
+    /* No anchor */
+    Sector(&img, 256)[0] = 0;
+    assert(vlc_udf_Open(obj, ReadImage, &img, IMAGE_SIZE) == NULL);
+
+    /* Broken file entry */
+    Sector(&img, 256)[0] = 2;
+    Metadata(&img, META_PAYLOAD)[20] ^= 1;
+    udf = vlc_udf_Open(obj, ReadImage, &img, IMAGE_SIZE);
+    assert(udf != NULL);
+    assert(vlc_udf_Lookup(udf, "8KDVD_TS/PAYLOAD_0.EVO8") == NULL);
+    assert(vlc_udf_Lookup(udf, "8KDVD_TS") != NULL);
+    vlc_udf_Close(udf);
+    free(img.data);
+}
+
+int main(void)
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(0, NULL);
+    assert(vlc);
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    test_probe();
+    test_files(obj);
+    test_recovery(obj);
+
+    libvlc_release(vlc);
+    return 0;
+}
@@ -0,0 +1,257 @@
+/*****************************************************************************
+ * fanout.c: fanout queue unit tests
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#undef NDEBUG
+
+#include <assert.h>
+
+#include <vlc_common.h>
+
+#include <vlc_atomic.h>
+#include <vlc_picture.h>
+#include <vlc_threads.h>
+#include <vlc_tick.h>
+
+#include "../modules/stream_out/fanout.h"
+
+#define DEPTH 3
+#define MAX_EVENTS 64
+
+/* A picture is recorded as its date, a PCR as its negated value */
+typedef struct
+{
+    vlc_mutex_t lock;
+    vlc_tick_t events[MAX_EVENTS];
+    void *tags[MAX_EVENTS];
+    size_t count;
+
+    /* Holds the consumer while set */
+    bool gated;
+    vlc_sem_t gate;
+    vlc_sem_t entered;
+} consumer_t;
+
+static void consumer_Init(consumer_t *c, bool gated)
+{
+    vlc_mutex_init(&c->lock);
+    c->count = 0;
+    c->gated = gated;
+    vlc_sem_init(&c->gate, 0);
+    vlc_sem_init(&c->entered, 0);
+}
+
+static void consumer_Record(consumer_t *c, void *tag, vlc_tick_t event)
+{
+    vlc_mutex_lock(&c->lock);
+    assert(c->count < MAX_EVENTS);
+    c->tags[c->count] = tag;
+    c->events[c->count++] = event;
+    vlc_mutex_unlock(&c->lock);
+}
+
+static void OnPicture(void *opaque, void *tag, picture_t *pic)
+{
+    consumer_t *c = opaque;
+
+    if (c->gated)
+    {
+        vlc_sem_post(&c->entered);
+        vlc_sem_wait(&c->gate);
+    }
+    consumer_Record(c, tag, pic->date);
+    picture_Release(pic);
+}
+
+static void OnPCR(void *opaque, vlc_tick_t pcr)
+{
+    consumer_Record(opaque, NULL, -pcr);
+}
+
+static const struct vlc_fanout_cbs cbs = {
+    .picture = OnPicture,
+    .pcr = OnPCR,
+};
+
+static picture_t *NewPicture(vlc_tick_t date)
+{
+    video_format_t fmt;
+    video_format_Init(&fmt, VLC_CODEC_I420);
+    video_format_Setup(&fmt, VLC_CODEC_I420, 16, 16, 16, 16, 1, 1);
+
+    picture_t *pic = picture_NewFromFormat(&fmt);
+    assert(pic != NULL);
+    pic->date = date;
+    return pic;
+}
+
+static void Push(vlc_fanout_queue_t *queue, void *tag, vlc_tick_t date)
+{
+    picture_t *pic = NewPicture(date);
+    assert(vlc_fanout_queue_PushPicture(queue, tag, pic) == VLC_SUCCESS);
+    picture_Release(pic);
+}
+
+static void test_Order(void)
+{
+    consumer_t c;
+    consumer_Init(&c, false);
+
+    vlc_fanout_queue_t *queue =
+        vlc_fanout_queue_New(&cbs, &c, DEPTH, VLC_FANOUT_BLOCK);
+    assert(queue != NULL);
+
+    int tag_a, tag_b;
+    Push(queue, &tag_a, 1);
+    Push(queue, &tag_b, 2);
+    assert(vlc_fanout_queue_PushPCR(queue, 2) == VLC_SUCCESS);
+    Push(queue, &tag_a, 3);
+    assert(vlc_fanout_queue_PushPCR(queue, 3) == VLC_SUCCESS);
+    vlc_fanout_queue_Wait(queue, NULL);
+
+    static const vlc_tick_t expected[] = { 1, 2, -2, 3, -3 };
+    assert(c.count == ARRAY_SIZE(expected));
+    for (size_t i = 0; i < ARRAY_SIZE(expected); i++)
+        assert(c.events[i] == expected[i]);
+    assert(c.tags[0] == &tag_a && c.tags[1] == &tag_b && c.tags[3] == &tag_a);
+    assert(vlc_fanout_queue_GetDropped(queue) == 0);
+
+    vlc_fanout_queue_Delete(queue);
+}
+
+static void test_Drop(void)
+{
+    consumer_t c;
+    consumer_Init(&c, true);
+
+    vlc_fanout_queue_t *queue =
+        vlc_fanout_queue_New(&cbs, &c, DEPTH, VLC_FANOUT_DROP);
+    assert(queue != NULL);
+
+    int tag;
+    /* The consumer holds the first picture */
+    Push(queue, &tag, 1);
+    vlc_sem_wait(&c.entered);
+
+    /* Never blocks, the oldest pictures go, the PCR stays */
+    Push(queue, &tag, 2);
+    assert(vlc_fanout_queue_PushPCR(queue, 2) == VLC_SUCCESS);
+    for (vlc_tick_t date = 3; date <= 1 + 2 * DEPTH; date++)
+        Push(queue, &tag, date);
+    assert(vlc_fanout_queue_GetDropped(queue) == DEPTH);
+
+    c.gated = false;
+    vlc_sem_post(&c.gate);
+    vlc_fanout_queue_Wait(queue, &tag);
+
+    static const vlc_tick_t expected[] = { 1, -2, 5, 6, 7 };
+    assert(c.count == ARRAY_SIZE(expected));
+    for (size_t i = 0; i < ARRAY_SIZE(expected); i++)
+        assert(c.events[i] == expected[i]);
+
+    vlc_fanout_queue_Delete(queue);
+}
+
+struct producer
+{
+    vlc_fanout_queue_t *queue;
+    atomic_size_t pushed;
+    size_t count;
+};
+
+static void *Produce(void *data)
+{
+    struct producer *p = data;
+
+    for (size_t i = 0; i < p->count; i++)
+    {
+        Push(p->queue, p, i + 1);
+        atomic_fetch_add(&p->pushed, 1);
+    }
+    return NULL;
+}
+
+static void test_Block(void)
+{
+    consumer_t c;
+    consumer_Init(&c, true);
+
+    struct producer p = {
+        .queue = vlc_fanout_queue_New(&cbs, &c, DEPTH, VLC_FANOUT_BLOCK),
+        .count = 4 * DEPTH,
+    };
+    assert(p.queue != NULL);
+    atomic_init(&p.pushed, 0);
+
+    vlc_thread_t th;
+    assert(vlc_clone(&th, Produce, &p) == 0);
+
+    /* While the consumer holds a picture, at most a full queue is pushed
+     * behind it, and every picture gets through in the end */
+    for (size_t i = 0; i < p.count; i++)
+    {
+        vlc_sem_wait(&c.entered);
+        assert(atomic_load(&p.pushed) <= i + 1 + DEPTH);
+        vlc_sem_post(&c.gate);
+    }
+    vlc_join(th, NULL);
+    vlc_fanout_queue_Wait(p.queue, NULL);
+
+    assert(c.count == p.count);
+    for (size_t i = 0; i < p.count; i++)
+        assert(c.events[i] == (vlc_tick_t)i + 1);
+    assert(vlc_fanout_queue_GetDropped(p.queue) == 0);
+
+    vlc_fanout_queue_Delete(p.queue);
+}
+
+static void test_DeletePending(void)
+{
+    consumer_t c;
+    consumer_Init(&c, true);
+
+    vlc_fanout_queue_t *queue =
+        vlc_fanout_queue_New(&cbs, &c, DEPTH, VLC_FANOUT_BLOCK);
+    assert(queue != NULL);
+
+    int tag;
+    Push(queue, &tag, 1);
+    vlc_sem_wait(&c.entered);
+    Push(queue, &tag, 2);
+    assert(vlc_fanout_queue_PushPCR(queue, 2) == VLC_SUCCESS);
+
+    /* The picture being consumed completes, the rest is discarded */
+    c.gated = false;
+    vlc_sem_post(&c.gate);
+    vlc_fanout_queue_Delete(queue);
+    assert(c.count >= 1 && c.events[0] == 1);
+}
+
+int main(void)
+{
+    test_Order();
+    test_Drop();
+    test_Block();
+    test_DeletePending();
+    return 0;
+}
@@ -0,0 +1,320 @@
+/*****************************************************************************
+ * parallel.c: parallel video segments transcoding tests and benchmark
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+/* Define a builtin module for the decoder, encoder and output */
+#define MODULE_NAME test_transcode_parallel
+#undef VLC_DYNAMIC_PLUGIN
+
+#include "../../libvlc/test.h"
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_codec.h>
+#include <vlc_picture.h>
+#include <vlc_sout.h>
+#include <vlc_frame.h>
+#include <vlc_tick.h>
+
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../../../lib/libvlc_internal.h"
+
+const char vlc_module_name[] = MODULE_STRING;
+
+#define TEST_CODEC   VLC_FOURCC('t','p','a','r')
+#define WIDTH        64
+#define HEIGHT       64
+#define FRAME_LENGTH VLC_TICK_FROM_MS(40)
+/* A keyframe every second, each one starting a segment of 1s */
+#define GOP          25
+#define FRAMES       (10 * GOP)
+
+/* Parameter sets of the ES, which the segments after the first one cannot
+ * find in band */
+static const uint8_t extradata[] = { 0x00, 0x00, 0x00, 0x01, 0x67, 0x42 };
+
+static atomic_uint decoder_count;
+/* Encoding cost of a picture */
+static unsigned work_rounds = 1;
+
+static struct
+{
+    vlc_tick_t pts[2 * FRAMES];
+    vlc_tick_t dts[2 * FRAMES];
+    size_t count;
+} output;
+
+static int DecoderDecode(decoder_t *dec, vlc_frame_t *frame)
+{
+    if (frame == NULL)
+        return VLCDEC_SUCCESS;
+
+    vlc_tick_t date = frame->i_pts;
+    vlc_frame_Release(frame);
+
+    int ret = decoder_UpdateVideoOutput(dec, NULL);
+    assert(ret == VLC_SUCCESS);
+
+    picture_t *pic = decoder_NewPicture(dec);
+    assert(pic != NULL);
+    memset(pic->p[0].p_pixels, date & 0xff,
+           pic->p[0].i_pitch * pic->p[0].i_lines);
+    pic->date = date;
+    decoder_QueueVideo(dec, pic);
+    return VLCDEC_SUCCESS;
+}
+
+static int OpenDecoder(vlc_object_t *obj)
+{
+    decoder_t *dec = (decoder_t *)obj;
+
+    if (dec->fmt_in->i_codec != TEST_CODEC)
+        return VLC_EGENERIC;
+
+    /* Every segment decodes with the parameter sets of the ES */
+    assert(dec->fmt_in->i_extra == sizeof(extradata));
+    assert(memcmp(dec->fmt_in->p_extra, extradata, sizeof(extradata)) == 0);
+    atomic_fetch_add(&decoder_count, 1);
+
+    es_format_Clean(&dec->fmt_out);
+    es_format_Copy(&dec->fmt_out, dec->fmt_in);
+    dec->fmt_out.video.i_chroma
+        = dec->fmt_out.i_codec
+        = VLC_CODEC_I420;
+
+    dec->pf_decode = DecoderDecode;
+    return VLC_SUCCESS;
+}
+
+static vlc_frame_t *EncodeVideo(encoder_t *enc, picture_t *pic)
+{
+    (void)enc;
+    if (pic == NULL)
+        return NULL;
+
+    uint8_t *pixels = pic->p[0].p_pixels;
+    const size_t size = pic->p[0].i_pitch * pic->p[0].i_lines;
+    for (unsigned round = 0; round < work_rounds; round++)
+        for (size_t i = 0; i < size; i++)
+            pixels[i] = pixels[i] * 31 + i;
+
+    vlc_frame_t *frame = vlc_frame_Alloc(4);
+    assert(frame != NULL);
+    memcpy(frame->p_buffer, pixels, 4);
+    frame->i_pts = frame->i_dts = pic->date;
+    frame->i_length = FRAME_LENGTH;
+    return frame;
+}
+
+static int OpenEncoder(vlc_object_t *obj)
+{
+    encoder_t *enc = (encoder_t *)obj;
+
+    enc->fmt_in.video.i_chroma
+        = enc->fmt_in.i_codec
+        = VLC_CODEC_I420;
+    enc->fmt_in.video.i_visible_width
+        = enc->fmt_in.video.i_width
+        = WIDTH;
+    enc->fmt_in.video.i_visible_height
+        = enc->fmt_in.video.i_height
+        = HEIGHT;
+
+    static const struct vlc_encoder_operations ops =
+    {
+        .encode_video = EncodeVideo,
+    };
+    enc->ops = &ops;
+    return VLC_SUCCESS;
+}
+
+static int CollectorSend(sout_stream_t *stream, void *id, vlc_frame_t *f)
+{
+    (void)stream; (void)id;
+
+    for (const vlc_frame_t *it = f; it != NULL; it = it->p_next)
+    {
+        assert(output.count < ARRAY_SIZE(output.pts));
+        output.pts[output.count] = it->i_pts;
+        output.dts[output.count] = it->i_dts;
+        output.count++;
+    }
+    vlc_frame_ChainRelease(f);
+    return VLC_SUCCESS;
+}
+
+static void *CollectorAdd(sout_stream_t *stream, const es_format_t *fmt,
+                          const char *es_id)
+{
+    (void)stream; (void)es_id;
+    assert(fmt->i_cat == VIDEO_ES);
+    return (void *)0x42;
+}
+
+static void CollectorDel(sout_stream_t *stream, void *id)
+    { (void)stream; (void)id; }
+
+static int OpenCollector(vlc_object_t *obj)
+{
+    sout_stream_t *stream = (sout_stream_t *)obj;
+
+    static const struct sout_stream_operations ops = {
+        .add = CollectorAdd,
+        .del = CollectorDel,
+        .send = CollectorSend,
+    };
+    stream->ops = &ops;
+    return VLC_SUCCESS;
+}
+
+/* Transcode the whole ES, feeding the chain as fast as it takes it, and
+ * return how long it took */
+static vlc_tick_t Transcode(vlc_object_t *obj, unsigned segments)
+{
+    char config[256];
+    snprintf(config, sizeof(config),
+             "transcode{vcodec=mp4v,venc=" MODULE_STRING ",segments=%u,"
+             "segment-length=1}:parallel_collector", segments);
+
+    output.count = 0;
+    atomic_store(&decoder_count, 0);
+
+    sout_stream_t *stream = sout_StreamNew(obj, config);
+    assert(stream != NULL);
+
+    es_format_t fmt;
+    es_format_Init(&fmt, VIDEO_ES, TEST_CODEC);
+    fmt.video.i_visible_width = fmt.video.i_width = WIDTH;
+    fmt.video.i_visible_height = fmt.video.i_height = HEIGHT;
+    fmt.video.i_frame_rate = 25;
+    fmt.video.i_frame_rate_base = 1;
+    fmt.p_extra = malloc(sizeof(extradata));
+    assert(fmt.p_extra != NULL);
+    memcpy(fmt.p_extra, extradata, sizeof(extradata));
+    fmt.i_extra = sizeof(extradata);
+
+    void *id = sout_StreamIdAdd(stream, &fmt, "video/0");
+    assert(id != NULL);
+
+    vlc_tick_t start = vlc_tick_now();
+    for (unsigned i = 0; i < FRAMES; i++)
+    {
+        vlc_frame_t *frame = vlc_frame_Alloc(16);
+        assert(frame != NULL);
+        memset(frame->p_buffer, i, frame->i_buffer);
+        frame->i_pts = frame->i_dts = VLC_TICK_0 + i * FRAME_LENGTH;
+        frame->i_length = FRAME_LENGTH;
+        frame->i_flags = i % GOP == 0 ? VLC_FRAME_FLAG_TYPE_I
+                                      : VLC_FRAME_FLAG_TYPE_P;
+        int ret = sout_StreamIdSend(stream, id, frame);
+        assert(ret == VLC_SUCCESS);
+    }
+
+    /* Deleting the ES drains the pending segments */
+    sout_StreamIdDel(stream, id);
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+
+    sout_StreamChainDelete(stream, NULL);
+    es_format_Clean(&fmt);
+    return elapsed;
+}
+
+static void test_segments(vlc_object_t *obj, unsigned segments)
+{
+    Transcode(obj, segments);
+
+    /* One decoder per segment */
+    assert(atomic_load(&decoder_count) == (segments > 1 ? FRAMES / GOP : 1));
+
+    /* Every frame once, in order, with increasing DTS across the segment
+     * boundaries */
+    assert(output.count == FRAMES);
+    for (size_t i = 0; i < output.count; i++)
+    {
+        assert(output.pts[i] == VLC_TICK_0 + (vlc_tick_t)i * FRAME_LENGTH);
+        assert(output.dts[i] != VLC_TICK_INVALID);
+        assert(output.dts[i] <= output.pts[i]);
+        if (i > 0)
+            assert(output.dts[i] > output.dts[i - 1]);
+    }
+}
+
+static void bench(vlc_object_t *obj)
+{
+    work_rounds = 400;
+
+    vlc_tick_t serial = Transcode(obj, 1);
+    printf("%2u segment:  %5"PRId64" ms\n", 1u, MS_FROM_VLC_TICK(serial));
+
+    for (unsigned segments = 2; segments <= 8; segments *= 2)
+    {
+        vlc_tick_t elapsed = Transcode(obj, segments);
+        assert(output.count == FRAMES);
+        printf("%2u segments: %5"PRId64" ms, x%.2f\n", segments,
+               MS_FROM_VLC_TICK(elapsed), (double)serial / elapsed);
+    }
+}
+
+vlc_module_begin()
+    set_callback(OpenDecoder)
+    set_capability("video decoder", INT_MAX)
+
+    add_submodule()
+        set_callback(OpenEncoder)
+        set_capability("video encoder", 0)
+
+    add_submodule()
+        set_callback(OpenCollector)
+        set_capability("sout output", 0)
+        add_shortcut("parallel_collector")
+vlc_module_end()
+
+VLC_EXPORT const vlc_plugin_cb vlc_static_modules[] = {
+    VLC_SYMBOL(vlc_entry),
+    NULL
+};
+
+int main(void)
+{
+#ifndef ENABLE_SOUT
+    return 77;
+#endif
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(0, NULL);
+    assert(vlc != NULL);
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    test_segments(obj, 1);
+    test_segments(obj, 4);
+
+    /* Timings are noise in a test run, compare them on demand */
+    if (getenv("VLC_TEST_BENCH") != NULL)
+        bench(obj);
+
+    libvlc_release(vlc);
+    return 0;
+}
@@ -0,0 +1,276 @@
+/*****************************************************************************
+ * segmenter.c: transcode segmenter unit tests
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#undef NDEBUG
+
+#include <assert.h>
+
+#include <vlc_common.h>
+
+#include <vlc_fourcc.h>
+#include <vlc_frame.h>
+#include <vlc_tick.h>
+
+#include "../modules/stream_out/transcode/segmenter.h"
+
+typedef struct
+{
+    vlc_tick_t dts;
+    vlc_tick_t pts;
+    bool key;
+    const uint8_t *data;
+    size_t size;
+} test_frame;
+
+static transcode_segment_t *Push(transcode_segmenter_t *segmenter,
+                                 const test_frame *f)
+{
+    vlc_frame_t *frame = vlc_frame_Alloc(f->data != NULL ? f->size : 1);
+    assert(frame != NULL);
+    if (f->data != NULL)
+        memcpy(frame->p_buffer, f->data, f->size);
+    frame->i_dts = f->dts;
+    frame->i_pts = f->pts;
+    if (f->key)
+        frame->i_flags |= VLC_FRAME_FLAG_TYPE_I;
+
+    transcode_segment_t *segment;
+    assert(transcode_segmenter_Push(segmenter, frame, &segment) == VLC_SUCCESS);
+    return segment;
+}
+
+static void CheckSegment(transcode_segment_t *segment, vlc_tick_t start,
+                         vlc_tick_t end, const vlc_tick_t *pts, size_t count)
+{
+    assert(segment != NULL);
+    assert(segment->start == start);
+    assert(segment->end == end);
+
+    size_t i = 0;
+    for (const vlc_frame_t *it = segment->frames; it != NULL; it = it->p_next)
+    {
+        assert(i < count);
+        assert(it->i_pts == pts[i++]);
+    }
+    assert(i == count);
+
+    transcode_segment_Delete(segment);
+}
+
+static void test_ClosedGOP(void)
+{
+    transcode_segmenter_t *segmenter =
+        transcode_segmenter_New(VLC_TICK_FROM_MS(30), 0);
+    assert(segmenter != NULL);
+
+    test_frame frames[8];
+    for (size_t i = 0; i < ARRAY_SIZE(frames); i++)
+    {
+        frames[i].dts = frames[i].pts = VLC_TICK_FROM_MS(10 * (i + 1));
+        frames[i].key = i % 3 == 0;
+    }
+
+    /* The keyframe at 40ms closes the first segment, which completes with
+     * the next frame as there are no leading frames */
+    for (size_t i = 0; i < 4; i++)
+        assert(Push(segmenter, &frames[i]) == NULL);
+    transcode_segment_t *segment = Push(segmenter, &frames[4]);
+    static const vlc_tick_t first[] = {
+        VLC_TICK_FROM_MS(10), VLC_TICK_FROM_MS(20), VLC_TICK_FROM_MS(30),
+        VLC_TICK_FROM_MS(40),
+    };
+    CheckSegment(segment, VLC_TICK_INVALID, VLC_TICK_FROM_MS(40),
+                 first, ARRAY_SIZE(first));
+
+    assert(Push(segmenter, &frames[5]) == NULL);
+    assert(Push(segmenter, &frames[6]) == NULL);
+    segment = Push(segmenter, &frames[7]);
+    static const vlc_tick_t second[] = {
+        VLC_TICK_FROM_MS(40), VLC_TICK_FROM_MS(50), VLC_TICK_FROM_MS(60),
+        VLC_TICK_FROM_MS(70),
+    };
+    CheckSegment(segment, VLC_TICK_FROM_MS(40), VLC_TICK_FROM_MS(70),
+                 second, ARRAY_SIZE(second));
+
+    static const vlc_tick_t last[] = {
+        VLC_TICK_FROM_MS(70), VLC_TICK_FROM_MS(80),
+    };
+    CheckSegment(transcode_segmenter_Drain(segmenter), VLC_TICK_FROM_MS(70),
+                 VLC_TICK_INVALID, last, ARRAY_SIZE(last));
+    assert(transcode_segmenter_Drain(segmenter) == NULL);
+
+    transcode_segmenter_Delete(segmenter);
+}
+
+static void test_OpenGOP(void)
+{
+    transcode_segmenter_t *segmenter =
+        transcode_segmenter_New(VLC_TICK_FROM_MS(60), 0);
+    assert(segmenter != NULL);
+
+    /* I B B P B B, in decoding order, the B frames of the second GOP
+     * reference the last P frame of the first one */
+    static const vlc_tick_t pts[] = {
+        30, 10, 20, 60, 40, 50, 90, 70, 80, 120, 100, 110,
+    };
+    transcode_segment_t *segment = NULL;
+    for (size_t i = 0; i < ARRAY_SIZE(pts); i++)
+    {
+        const test_frame frame = {
+            .dts = VLC_TICK_FROM_MS(10 * (i + 1)),
+            .pts = VLC_TICK_FROM_MS(pts[i]),
+            .key = i % 6 == 0,
+        };
+        transcode_segment_t *done = Push(segmenter, &frame);
+        if (done != NULL)
+        {
+            /* Completed by the first frame presented after the keyframe */
+            assert(segment == NULL && i == 9);
+            segment = done;
+        }
+    }
+
+    static const vlc_tick_t first[] = {
+        VLC_TICK_FROM_MS(30), VLC_TICK_FROM_MS(10), VLC_TICK_FROM_MS(20),
+        VLC_TICK_FROM_MS(60), VLC_TICK_FROM_MS(40), VLC_TICK_FROM_MS(50),
+        VLC_TICK_FROM_MS(90), VLC_TICK_FROM_MS(70), VLC_TICK_FROM_MS(80),
+    };
+    CheckSegment(segment, VLC_TICK_INVALID, VLC_TICK_FROM_MS(90),
+                 first, ARRAY_SIZE(first));
+
+    static const vlc_tick_t last[] = {
+        VLC_TICK_FROM_MS(90), VLC_TICK_FROM_MS(70), VLC_TICK_FROM_MS(80),
+        VLC_TICK_FROM_MS(120), VLC_TICK_FROM_MS(100), VLC_TICK_FROM_MS(110),
+    };
+    CheckSegment(transcode_segmenter_Drain(segmenter), VLC_TICK_FROM_MS(90),
+                 VLC_TICK_INVALID, last, ARRAY_SIZE(last));
+    assert(transcode_segmenter_Drain(segmenter) == NULL);
+
+    transcode_segmenter_Delete(segmenter);
+}
+
+static void test_DrainClosing(void)
+{
+    transcode_segmenter_t *segmenter =
+        transcode_segmenter_New(VLC_TICK_FROM_MS(10), 0);
+    assert(segmenter != NULL);
+
+    const test_frame frames[] = {
+        { VLC_TICK_FROM_MS(10), VLC_TICK_FROM_MS(10), true },
+        { VLC_TICK_FROM_MS(20), VLC_TICK_FROM_MS(20), true },
+    };
+    assert(Push(segmenter, &frames[0]) == NULL);
+    assert(Push(segmenter, &frames[1]) == NULL);
+
+    /* The closing segment comes out before the one being gathered */
+    static const vlc_tick_t first[] = {
+        VLC_TICK_FROM_MS(10), VLC_TICK_FROM_MS(20),
+    };
+    CheckSegment(transcode_segmenter_Drain(segmenter), VLC_TICK_INVALID,
+                 VLC_TICK_FROM_MS(20), first, ARRAY_SIZE(first));
+    static const vlc_tick_t last[] = { VLC_TICK_FROM_MS(20) };
+    CheckSegment(transcode_segmenter_Drain(segmenter), VLC_TICK_FROM_MS(20),
+                 VLC_TICK_INVALID, last, ARRAY_SIZE(last));
+    assert(transcode_segmenter_Drain(segmenter) == NULL);
+
+    transcode_segmenter_Delete(segmenter);
+}
+
+static void test_Flush(void)
+{
+    transcode_segmenter_t *segmenter =
+        transcode_segmenter_New(VLC_TICK_FROM_MS(10), 0);
+    assert(segmenter != NULL);
+
+    const test_frame frames[] = {
+        { VLC_TICK_FROM_MS(10), VLC_TICK_FROM_MS(10), true },
+        { VLC_TICK_FROM_MS(20), VLC_TICK_FROM_MS(20), true },
+        { VLC_TICK_FROM_MS(90), VLC_TICK_FROM_MS(90), false },
+    };
+    assert(Push(segmenter, &frames[0]) == NULL);
+    assert(Push(segmenter, &frames[1]) == NULL);
+    transcode_segmenter_Flush(segmenter);
+    assert(transcode_segmenter_Drain(segmenter) == NULL);
+
+    /* Restarts without lower bound, even without a keyframe */
+    assert(Push(segmenter, &frames[2]) == NULL);
+    static const vlc_tick_t last[] = { VLC_TICK_FROM_MS(90) };
+    CheckSegment(transcode_segmenter_Drain(segmenter), VLC_TICK_INVALID,
+                 VLC_TICK_INVALID, last, ARRAY_SIZE(last));
+
+    transcode_segmenter_Delete(segmenter);
+}
+
+static void test_H264(void)
+{
+    transcode_segmenter_t *segmenter =
+        transcode_segmenter_New(VLC_TICK_FROM_MS(10), VLC_CODEC_H264);
+    assert(segmenter != NULL);
+
+    static const uint8_t idr[] = {
+        0, 0, 0, 1, 0x67, 0x42, 0, 0, 1, 0x68, 0xce, 0, 0, 1, 0x65, 0x88,
+    };
+    static const uint8_t non_idr[] = { 0, 0, 0, 1, 0x61, 0x88 };
+    const test_frame frames[] = {
+        { VLC_TICK_FROM_MS(10), VLC_TICK_FROM_MS(10), true,
+          idr, sizeof (idr) },
+        { VLC_TICK_FROM_MS(20), VLC_TICK_FROM_MS(20), false,
+          non_idr, sizeof (non_idr) },
+        /* Not a random access point, even though an I frame */
+        { VLC_TICK_FROM_MS(30), VLC_TICK_FROM_MS(30), true,
+          non_idr, sizeof (non_idr) },
+        { VLC_TICK_FROM_MS(40), VLC_TICK_FROM_MS(40), true,
+          idr, sizeof (idr) },
+        { VLC_TICK_FROM_MS(50), VLC_TICK_FROM_MS(50), false,
+          non_idr, sizeof (non_idr) },
+    };
+    for (size_t i = 0; i < 4; i++)
+        assert(Push(segmenter, &frames[i]) == NULL);
+
+    static const vlc_tick_t first[] = {
+        VLC_TICK_FROM_MS(10), VLC_TICK_FROM_MS(20), VLC_TICK_FROM_MS(30),
+        VLC_TICK_FROM_MS(40),
+    };
+    CheckSegment(Push(segmenter, &frames[4]), VLC_TICK_INVALID,
+                 VLC_TICK_FROM_MS(40), first, ARRAY_SIZE(first));
+
+    static const vlc_tick_t last[] = {
+        VLC_TICK_FROM_MS(40), VLC_TICK_FROM_MS(50),
+    };
+    CheckSegment(transcode_segmenter_Drain(segmenter), VLC_TICK_FROM_MS(40),
+                 VLC_TICK_INVALID, last, ARRAY_SIZE(last));
+    assert(transcode_segmenter_Drain(segmenter) == NULL);
+
+    transcode_segmenter_Delete(segmenter);
+}
+
+int main(void)
+{
+    test_ClosedGOP();
+    test_OpenGOP();
+    test_DrainClosing();
+    test_Flush();
+    test_H264();
+    return 0;
+}
@@ -105,9 +105,10 @@ static int OpenDecoder(vlc_object_t *obj)
 {
     decoder_t *dec = (decoder_t*)obj;
 
+    /* Shared decoders, see duplicate, do not provide any device */
     struct vlc_decoder_device *device = decoder_GetDecoderDevice(dec);
-    assert(device);
-    vlc_decoder_device_Release(device);
+    if (device != NULL)
+        vlc_decoder_device_Release(device);
 
     dec->pf_decode = DecoderDecode;
     // Necessary ?
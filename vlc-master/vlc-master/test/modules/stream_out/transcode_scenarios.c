@@ -36,6 +36,7 @@ static struct scenario_data
     vlc_sem_t wait_stop;
     struct vlc_video_context *decoder_vctx;
     unsigned output_frame_count;
+    unsigned decoded_count;
     bool converter_opened;
     bool encoder_opened;
     bool encoder_closed;
@@ -136,6 +137,26 @@ static int decoder_decode_vctx_update(decoder_t *dec, picture_t *pic)
     return VLC_SUCCESS;
 }
 
+/* Shared decoders do not provide a decoder device: the mock picture has no
+ * pixels. The size changes after the third picture. */
+static int decoder_decode_shared(decoder_t *dec, picture_t *pic)
+{
+    vlc_tick_t date = pic->date;
+    picture_Release(pic);
+
+    if (++scenario_data.decoded_count == 4)
+        decoder_fixed_size(dec, dec->fmt_out.video.i_chroma, 640, 480);
+
+    int ret = decoder_UpdateVideoOutput(dec, NULL);
+    assert(ret == VLC_SUCCESS);
+
+    pic = decoder_NewPicture(dec);
+    assert(pic != NULL);
+    pic->date = date;
+    decoder_QueueVideo(dec, pic);
+    return VLC_SUCCESS;
+}
+
 static int decoder_decode_error(decoder_t *dec, picture_t *pic)
 {
     (void)dec;
@@ -216,6 +237,22 @@ static void wait_output_10_frames_reported(const vlc_frame_t *out)
         vlc_sem_post(&scenario_data.wait_stop);
 }
 
+/* Raw frames of both outputs of a shared decoder, from their own threads */
+static void wait_output_20_raw_frames_reported(const vlc_frame_t *out)
+{
+    static vlc_mutex_t lock = VLC_STATIC_MUTEX;
+
+    vlc_mutex_lock(&lock);
+    for (; out != NULL; out = out->p_next)
+    {
+        assert(out->i_buffer == 800 * 600 * 3 / 2 ||
+               out->i_buffer == 640 * 480 * 3 / 2);
+        if (++scenario_data.output_frame_count == 20)
+            vlc_sem_post(&scenario_data.wait_stop);
+    }
+    vlc_mutex_unlock(&lock);
+}
+
 static void wait_output_reported(const vlc_frame_t *out)
 {
     (void)out;
@@ -365,6 +402,14 @@ struct transcode_scenario transcode_scenarios[] =
     .decoder_decode = decoder_decode_error,
     .report_error = wait_error_reported,
     .encoder_close = encoder_close,
+},{
+    /* Decode once for two outputs, which receive raw video and get a new
+     * ES when the decoder output size changes. */
+    .source = source_800_600,
+    .sout = "sout=#duplicate{decode,dst=output_checker,dst=output_checker}",
+    .decoder_setup = decoder_i420_800_600,
+    .decoder_decode = decoder_decode_shared,
+    .report_output = wait_output_20_raw_frames_reported,
 }};
 size_t transcode_scenarios_count = ARRAY_SIZE(transcode_scenarios);
 
@@ -372,6 +417,7 @@ void transcode_scenario_init(void)
 {
     scenario_data.decoder_vctx = NULL;
     scenario_data.output_frame_count = 0;
+    scenario_data.decoded_count = 0;
     scenario_data.converter_opened = false;
     scenario_data.encoder_opened = false;
     vlc_sem_init(&scenario_data.wait_stop, 0);
@@ -0,0 +1,328 @@
+/*****************************************************************************
+ * tonemap.c: HDR to SDR tone mapping tests and benchmark
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+#include <vlc_executor.h>
+#include <vlc_picture.h>
+#include <vlc_rand.h>
+#include <vlc_tick.h>
+
+#include <stdio.h>
+
+#include "../../../modules/video_filter/tonemap.h"
+
+#include "../../libvlc/test.h"
+
+static const struct tonemap_params pq_params = {
+    .hlg = false,
+    .full_range = false,
+    .semiplanar = false,
+    .src_peak = 1000.f,
+    .dst_peak = 100.f,
+    .curve = TONEMAP_BT2390,
+};
+
+static picture_t *NewPicture(vlc_fourcc_t chroma, unsigned width,
+                             unsigned height)
+{
+    video_format_t fmt;
+
+    video_format_Init(&fmt, chroma);
+    video_format_Setup(&fmt, chroma, width, height, width, height, 1, 1);
+    picture_t *pic = picture_NewFromFormat(&fmt);
+    assert(pic != NULL);
+    return pic;
+}
+
+static void Fill(picture_t *pic, bool semiplanar, bool random,
+                 unsigned y, unsigned u, unsigned v)
+{
+    const unsigned shift = semiplanar ? 6 : 0;
+
+    for (int i = 0; i < pic->i_planes; i++)
+    {
+        const plane_t *p = &pic->p[i];
+        for (int row = 0; row < p->i_lines; row++)
+        {
+            uint16_t *line = (uint16_t *)&p->p_pixels[row * p->i_pitch];
+            for (int x = 0; x < p->i_pitch / 2; x++)
+            {
+                unsigned value;
+                if (random)
+                    value = vlc_mrand48() & 1023;
+                else if (i == 0)
+                    value = y;
+                else if (semiplanar)
+                    value = x & 1 ? v : u;
+                else
+                    value = i == 1 ? u : v;
+                line[x] = value << shift;
+            }
+        }
+    }
+}
+
+static void Convert(const struct tonemap_params *params, bool simd,
+                    picture_t *dst, const picture_t *src)
+{
+    struct tonemap t;
+
+    assert(tonemap_Init(&t, params, simd) == VLC_SUCCESS);
+    tonemap_Slice(&t, dst, src, 0, src->p[0].i_visible_lines);
+    tonemap_Clean(&t);
+}
+
+static uint8_t Sample(const picture_t *pic, int plane)
+{
+    return pic->p[plane].p_pixels[0];
+}
+
+static void test_levels(void)
+{
+    picture_t *src = NewPicture(VLC_CODEC_I420_10L, 16, 16);
+    picture_t *dst = NewPicture(VLC_CODEC_I420, 16, 16);
+
+    /* Black stays black */
+    Fill(src, false, false, 64, 512, 512);
+    Convert(&pq_params, false, dst, src);
+    assert(Sample(dst, 0) == 16);
+    assert(Sample(dst, 1) == 128 && Sample(dst, 2) == 128);
+
+    /* The source peak white (1000 cd/m² is code 723) becomes the SDR white,
+     * 100 cd/m² (code 509) stays well below it */
+    Fill(src, false, false, 723, 512, 512);
+    Convert(&pq_params, false, dst, src);
+    assert(Sample(dst, 0) >= 234);
+    assert(abs(Sample(dst, 1) - 128) <= 1 && abs(Sample(dst, 2) - 128) <= 1);
+
+    Fill(src, false, false, 509, 512, 512);
+    Convert(&pq_params, false, dst, src);
+    assert(Sample(dst, 0) > 150 && Sample(dst, 0) < 234);
+
+    /* Grey ramps stay monotonic with every curve and transfer */
+    for (unsigned hlg = 0; hlg < 2; hlg++)
+        for (int curve = TONEMAP_BT2390; curve <= TONEMAP_CLIP; curve++)
+        {
+            struct tonemap_params params = pq_params;
+            struct tonemap t;
+
+            params.hlg = hlg;
+            params.curve = curve;
+            assert(tonemap_Init(&t, &params, false) == VLC_SUCCESS);
+
+            uint8_t prev = 0;
+            for (unsigned y = 64; y <= 940; y += 4)
+            {
+                Fill(src, false, false, y, 512, 512);
+                tonemap_Slice(&t, dst, src, 0, 2);
+                assert(Sample(dst, 0) >= prev);
+                prev = Sample(dst, 0);
+            }
+            assert(prev >= 234);
+            tonemap_Clean(&t);
+        }
+
+    picture_Release(src);
+    picture_Release(dst);
+}
+
+static bool SamePictures(const picture_t *a, const picture_t *b)
+{
+    for (int i = 0; i < a->i_planes; i++)
+        for (int row = 0; row < a->p[i].i_visible_lines; row++)
+            if (memcmp(&a->p[i].p_pixels[row * a->p[i].i_pitch],
+                       &b->p[i].p_pixels[row * b->p[i].i_pitch],
+                       a->p[i].i_visible_pitch))
+                return false;
+    return true;
+}
+
+static void test_simd(void)
+{
+    if (!vlc_CPU_AVX2())
+    {
+        fprintf(stderr, "AVX2 not available, skipping SIMD test\n");
+        return;
+    }
+
+    static const unsigned sizes[][2] = {
+        { 64, 16 }, { 1927, 9 }, { 33, 33 }, { 3, 2 },
+    };
+
+    for (unsigned semiplanar = 0; semiplanar < 2; semiplanar++)
+        for (size_t i = 0; i < ARRAY_SIZE(sizes); i++)
+        {
+            const unsigned w = sizes[i][0], h = sizes[i][1];
+            picture_t *src = NewPicture(semiplanar ? VLC_CODEC_P010
+                                                   : VLC_CODEC_I420_10L, w, h);
+            picture_t *ref = NewPicture(VLC_CODEC_I420, w, h);
+            picture_t *dst = NewPicture(VLC_CODEC_I420, w, h);
+            struct tonemap_params params = pq_params;
+
+            params.semiplanar = semiplanar;
+            params.hlg = i & 1;
+            Fill(src, semiplanar, true, 0, 0, 0);
+            Convert(&params, false, ref, src);
+            Convert(&params, true, dst, src);
+            assert(SamePictures(ref, dst));
+
+            picture_Release(src);
+            picture_Release(ref);
+            picture_Release(dst);
+        }
+}
+
+static void test_slices(void)
+{
+    picture_t *src = NewPicture(VLC_CODEC_P010, 98, 37);
+    picture_t *ref = NewPicture(VLC_CODEC_I420, 98, 37);
+    picture_t *dst = NewPicture(VLC_CODEC_I420, 98, 37);
+    struct tonemap_params params = pq_params;
+    struct tonemap t;
+
+    params.semiplanar = true;
+    Fill(src, true, true, 0, 0, 0);
+    assert(tonemap_Init(&t, &params, true) == VLC_SUCCESS);
+    tonemap_Slice(&t, ref, src, 0, 37);
+
+    /* Even bands, the last one with the odd row */
+    tonemap_Slice(&t, dst, src, 20, 37);
+    tonemap_Slice(&t, dst, src, 0, 6);
+    tonemap_Slice(&t, dst, src, 6, 20);
+    assert(SamePictures(ref, dst));
+
+    tonemap_Clean(&t);
+    picture_Release(src);
+    picture_Release(ref);
+    picture_Release(dst);
+}
+
+/*
+ * Benchmark
+ */
+#define BENCH_WIDTH  7680
+#define BENCH_HEIGHT 4320
+#define BENCH_TIME   VLC_TICK_FROM_MS(500)
+
+struct bench_slice
+{
+    struct vlc_runnable runnable;
+    const struct tonemap *tonemap;
+    picture_t *src, *dst;
+    unsigned first, last;
+    vlc_latch_t *done;
+};
+
+static void RunSlice(void *opaque)
+{
+    struct bench_slice *slice = opaque;
+
+    tonemap_Slice(slice->tonemap, slice->dst, slice->src,
+                  slice->first, slice->last);
+    vlc_latch_count_down(slice->done, 1);
+}
+
+static void bench_run(const char *name, const struct tonemap *t,
+                      vlc_executor_t *executor, unsigned count,
+                      picture_t *dst, picture_t *src)
+{
+    const unsigned rows = BENCH_HEIGHT;
+    const unsigned band = ((rows + count - 1) / count + 1) & ~1u;
+    struct bench_slice slices[64];
+    unsigned frames = 0;
+
+    vlc_tick_t start = vlc_tick_now(), elapsed;
+    do
+    {
+        vlc_latch_t done;
+        vlc_latch_init(&done, count);
+        for (unsigned i = 0; i < count; i++)
+        {
+            slices[i] = (struct bench_slice) {
+                .runnable = { .run = RunSlice, .userdata = &slices[i] },
+                .tonemap = t, .src = src, .dst = dst,
+                .first = __MIN(rows, i * band),
+                .last = __MIN(rows, (i + 1) * band),
+                .done = &done,
+            };
+        }
+        for (unsigned i = 1; i < count; i++)
+            vlc_executor_Submit(executor, &slices[i].runnable);
+        RunSlice(&slices[0]);
+        vlc_latch_wait(&done);
+        frames++;
+        elapsed = vlc_tick_now() - start;
+    }
+    while (elapsed < BENCH_TIME);
+
+    double secs = secf_from_vlc_tick(elapsed);
+    printf("%-18s %2u thread(s): %7.1f Mpixel/s, %5.2f frames/s\n", name,
+           count, frames * (double)(BENCH_WIDTH * BENCH_HEIGHT) / secs / 1e6,
+           frames / secs);
+}
+
+static void bench(void)
+{
+    const unsigned threads = __MIN(vlc_GetCPUCount(), 64);
+    vlc_executor_t *executor = vlc_executor_New(threads);
+    assert(executor != NULL);
+
+    picture_t *src = NewPicture(VLC_CODEC_I420_10L, BENCH_WIDTH, BENCH_HEIGHT);
+    picture_t *dst = NewPicture(VLC_CODEC_I420, BENCH_WIDTH, BENCH_HEIGHT);
+    Fill(src, false, true, 0, 0, 0);
+
+    for (unsigned simd = 0; simd < 2; simd++)
+    {
+        struct tonemap t;
+        vlc_tick_t start = vlc_tick_now();
+        assert(tonemap_Init(&t, &pq_params, simd) == VLC_SUCCESS);
+        if (!simd)
+            printf("LUT computed in %"PRId64" ms\n",
+                   MS_FROM_VLC_TICK(vlc_tick_now() - start));
+
+        const char *name = simd && vlc_CPU_AVX2() ? "8K PQ->SDR AVX2" : "8K PQ->SDR C";
+        bench_run(name, &t, executor, 1, dst, src);
+        if (threads > 1)
+            bench_run(name, &t, executor, threads, dst, src);
+        tonemap_Clean(&t);
+    }
+
+    picture_Release(src);
+    picture_Release(dst);
+    vlc_executor_Delete(executor);
+}
+
+int main(void)
+{
+    test_init();
+
+    test_levels();
+    test_simd();
+    test_slices();
+
+    /* Timings are noise in a test run, compare them on demand */
+    if (getenv("VLC_TEST_BENCH") != NULL)
+        bench();
+    return 0;
+}
@@ -24,6 +24,7 @@
 #include <vlc_strings.h>
 #include <vlc_hash.h>
 #include <vlc_stream.h>
+#include <vlc_access.h>
 #include <vlc_fs.h>
 
 #include <errno.h>
@@ -368,6 +369,255 @@ fill_rand( int i_fd, size_t i_size )
 }
 #endif
 
+#ifndef TEST_NET
+/* Upstream of the prefetch filter, which is skipped for fast seeking
+ * sources such as local files */
+static struct
+{
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    int i_fd;
+    uint64_t i_offset;
+    uint64_t i_read_lo; /* lowest offset read since the last reset */
+    size_t i_read_max;  /* largest read length */
+    uint64_t i_watch;   /* offset to wait a read at */
+    bool b_watched;
+} slow = {
+    .lock = VLC_STATIC_MUTEX,
+    .wait = VLC_STATIC_COND,
+};
+
+static ssize_t
+slow_Read( stream_t *p_access, void *p_buf, size_t i_len )
+{
+    (void) p_access;
+    vlc_mutex_lock( &slow.lock );
+    ssize_t i_ret = pread( slow.i_fd, p_buf, i_len, slow.i_offset );
+    if( i_ret > 0 )
+    {
+        if( slow.i_offset < slow.i_read_lo )
+            slow.i_read_lo = slow.i_offset;
+        if( slow.i_offset == slow.i_watch )
+            slow.b_watched = true;
+        slow.i_offset += i_ret;
+    }
+    if( i_len > slow.i_read_max )
+        slow.i_read_max = i_len;
+    vlc_cond_broadcast( &slow.wait );
+    vlc_mutex_unlock( &slow.lock );
+    return i_ret;
+}
+
+static int
+slow_Seek( stream_t *p_access, uint64_t i_offset )
+{
+    (void) p_access;
+    vlc_mutex_lock( &slow.lock );
+    slow.i_offset = i_offset;
+    vlc_mutex_unlock( &slow.lock );
+    return VLC_SUCCESS;
+}
+
+static int
+slow_Control( stream_t *p_access, int i_query, va_list args )
+{
+    (void) p_access;
+    switch( i_query )
+    {
+        case STREAM_CAN_SEEK:
+        case STREAM_CAN_PAUSE:
+        case STREAM_CAN_CONTROL_PACE:
+            *va_arg( args, bool * ) = true;
+            break;
+        case STREAM_CAN_FASTSEEK:
+            *va_arg( args, bool * ) = false;
+            break;
+        case STREAM_GET_SIZE:
+            *va_arg( args, uint64_t * ) = RAND_FILE_SIZE;
+            break;
+        case STREAM_GET_PTS_DELAY:
+            *va_arg( args, vlc_tick_t * ) = DEFAULT_PTS_DELAY;
+            break;
+        case STREAM_SET_PAUSE_STATE:
+            break;
+        default:
+            return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static int
+slow_Open( vlc_object_t *p_obj )
+{
+    stream_t *p_access = (stream_t *)p_obj;
+
+    vlc_mutex_lock( &slow.lock );
+    slow.i_offset = 0;
+    vlc_mutex_unlock( &slow.lock );
+
+    p_access->pf_read = slow_Read;
+    p_access->pf_seek = slow_Seek;
+    p_access->pf_control = slow_Control;
+    return VLC_SUCCESS;
+}
+
+static void
+slow_Reset( void )
+{
+    vlc_mutex_lock( &slow.lock );
+    slow.i_read_lo = UINT64_MAX;
+    vlc_mutex_unlock( &slow.lock );
+}
+
+static uint64_t
+slow_ReadLow( void )
+{
+    vlc_mutex_lock( &slow.lock );
+    uint64_t i_read_lo = slow.i_read_lo;
+    vlc_mutex_unlock( &slow.lock );
+    return i_read_lo;
+}
+
+/* Reads at the current position and compares with the file */
+static void
+prefetch_read( stream_t *s, size_t i_len )
+{
+    uint8_t p_buf[4096], p_ref[4096];
+    uint64_t i_offset = vlc_stream_Tell( s );
+
+    assert( i_len <= sizeof (p_buf) );
+    assert( vlc_stream_Read( s, p_buf, i_len ) == (ssize_t) i_len );
+    assert( pread( slow.i_fd, p_ref, i_len, i_offset ) == (ssize_t) i_len );
+    assert( memcmp( p_buf, p_ref, i_len ) == 0 );
+}
+
+static void
+prefetch_read_at( stream_t *s, uint64_t i_offset, size_t i_len )
+{
+    assert( vlc_stream_Seek( s, i_offset ) == 0 );
+    prefetch_read( s, i_len );
+}
+
+static stream_t *
+prefetch_open( libvlc_instance_t *p_vlc )
+{
+    stream_t *p_access = vlc_access_NewMRL( VLC_OBJECT(p_vlc->p_libvlc_int),
+                                            "slowfile://" );
+    assert( p_access != NULL );
+
+    stream_t *s = vlc_stream_FilterNew( p_access, "prefetch" );
+    assert( s != NULL );
+    return s;
+}
+
+static void
+test_prefetch_kept_range( libvlc_instance_t *p_vlc )
+{
+    test_log( "prefetch: backward seek to a kept range\n" );
+    stream_t *s = prefetch_open( p_vlc );
+
+    /* The whole 16 KiB buffer is filled by the first upstream read */
+    prefetch_read_at( s, 0, 8192 );
+
+    /* The data around the read position are kept when seeking away */
+    prefetch_read_at( s, RAND_FILE_SIZE / 2, 4096 );
+
+    slow_Reset();
+    prefetch_read_at( s, 2048, 4096 );
+    /* Upstream only resumes after the kept range */
+    assert( slow_ReadLow() >= 8192 );
+
+    vlc_stream_Delete( s );
+}
+
+static void
+test_prefetch_hint( libvlc_instance_t *p_vlc )
+{
+    test_log( "prefetch: hinted read-ahead\n" );
+    const uint64_t i_hint = 3 * RAND_FILE_SIZE / 4;
+    stream_t *s = prefetch_open( p_vlc );
+
+    vlc_mutex_lock( &slow.lock );
+    slow.i_watch = i_hint;
+    slow.b_watched = false;
+    vlc_mutex_unlock( &slow.lock );
+
+    prefetch_read_at( s, 0, 4096 );
+    assert( vlc_stream_SetPrefetchHint( s, i_hint, 16384 ) == VLC_SUCCESS );
+
+    /* The hint is read once the buffer is full */
+    vlc_mutex_lock( &slow.lock );
+    while( !slow.b_watched )
+        vlc_cond_wait( &slow.wait, &slow.lock );
+    vlc_mutex_unlock( &slow.lock );
+
+    slow_Reset();
+    prefetch_read_at( s, i_hint, 4096 );
+    prefetch_read( s, 4096 );
+    /* Served from the hinted range, upstream resumes after it */
+    assert( slow_ReadLow() >= i_hint + 16384 );
+
+    vlc_stream_Delete( s );
+}
+
+static void
+test_prefetch_resize( libvlc_instance_t *p_vlc )
+{
+    test_log( "prefetch: resize while data are buffered\n" );
+    stream_t *s = prefetch_open( p_vlc );
+
+    vlc_mutex_lock( &slow.lock );
+    slow.i_read_max = 0;
+    vlc_mutex_unlock( &slow.lock );
+
+    /* Read at about 200 KB/s, until the rate is measured, which then
+     * requires much more than the 16 KiB buffer */
+    const vlc_tick_t i_end = vlc_tick_now() + VLC_TICK_FROM_MS(1200);
+    while( vlc_tick_now() < i_end )
+    {
+        prefetch_read( s, 1024 );
+        vlc_tick_sleep( VLC_TICK_FROM_MS(5) );
+    }
+
+    /* The thread reads larger chunks once the buffer grew */
+    vlc_mutex_lock( &slow.lock );
+    while( slow.i_read_max <= 16384 )
+        vlc_cond_wait( &slow.wait, &slow.lock );
+    vlc_mutex_unlock( &slow.lock );
+
+    /* The buffered data were moved to the new buffer */
+    while( vlc_stream_Tell( s ) + 4096 <= RAND_FILE_SIZE )
+        prefetch_read( s, 4096 );
+
+    vlc_stream_Delete( s );
+}
+
+static void
+test_prefetch( int i_fd )
+{
+    const char * argv[] = {
+        "-v",
+        "--ignore-config",
+        "-I",
+        "dummy",
+        "--no-media-library",
+        "--prefetch-buffer-size=16",
+        "--prefetch-buffer-max=256",
+        "--prefetch-history-size=64",
+    };
+
+    libvlc_instance_t *p_vlc = libvlc_new( ARRAY_SIZE(argv), argv );
+    assert( p_vlc != NULL );
+    slow.i_fd = i_fd;
+
+    test_prefetch_kept_range( p_vlc );
+    test_prefetch_hint( p_vlc );
+    test_prefetch_resize( p_vlc );
+
+    libvlc_release( p_vlc );
+}
+#endif
+
 int
 main( void )
 {
@@ -395,6 +645,9 @@ main( void )
         pp_readers[i]->pf_close( pp_readers[i] );
     free( psz_url );
 
+    test_log( "Testing the prefetch filter...\n" );
+    test_prefetch( i_tmp_fd );
+
     close( i_tmp_fd );
 #else
 
@@ -414,3 +667,22 @@ main( void )
 
     return 0;
 }
+
+#ifndef TEST_NET
+#define MODULE_NAME test_src_input_stream
+#undef VLC_DYNAMIC_PLUGIN
+#include <vlc_plugin.h>
+/* Define a builtin module for the prefetch upstream */
+const char vlc_module_name[] = MODULE_STRING;
+
+vlc_module_begin()
+    set_capability( "access", 0 )
+    add_shortcut( "slowfile" )
+    set_callback( slow_Open )
+vlc_module_end()
+
+VLC_EXPORT const vlc_plugin_cb vlc_static_modules[] = {
+    VLC_SYMBOL(vlc_entry),
+    NULL
+};
+#endif
@@ -28,6 +28,7 @@
 #include <vlc_vector.h>
 #include <vlc_modules.h>
 #include <vlc_filter.h>
+#include <vlc_vout_display.h>
 
 #if defined(ZVBI_COMPILED)
 # define TELETEXT_DECODER "zvbi,"
@@ -159,8 +160,15 @@ struct report_aout_first_pts
     vlc_tick_t first_pts;
 };
 
+enum report_display
+{
+    REPORT_DISPLAY_OPENED,
+    REPORT_DISPLAY_CLOSED,
+};
+
 #define REPORT_LIST \
     X(vlc_tick_t, on_aout_first_pts) \
+    X(enum report_display, on_display_changed) \
 
 struct report_timer
 {
@@ -226,6 +234,7 @@ struct media_params
 
     bool can_seek;
     bool can_pause;
+    bool can_control_pace;
     bool error;
     bool null_names;
     vlc_tick_t pts_delay;
@@ -251,6 +260,7 @@ struct media_params
     .attachment_count = 0, \
     .can_seek = true, \
     .can_pause = true, \
+    .can_control_pace = true, \
     .error = false, \
     .null_names = false, \
     .pts_delay = DEFAULT_PTS_DELAY, \
@@ -263,6 +273,7 @@ struct media_params
 #define DISABLE_VIDEO        (1 << 2)
 #define DISABLE_AUDIO        (1 << 3)
 #define AUDIO_INSTANT_DRAIN  (1 << 4)
+#define ENABLE_PRELOAD       (1 << 5)
 
 struct ctx
 {
@@ -807,7 +818,8 @@ create_mock_media(const char *name, const struct media_params *params)
         "sub_packetized=%d;length=%"PRId64";audio_sample_length=%"PRId64";"
         "video_frame_rate=%u;video_frame_rate_base=%u;"
         "title_count=%zu;chapter_count=%zu;"
-        "can_seek=%d;can_pause=%d;error=%d;null_names=%d;pts_delay=%"PRId64";"
+        "can_seek=%d;can_pause=%d;can_control_pace=%d;error=%d;null_names=%d;"
+        "pts_delay=%"PRId64";"
         "config=%s;discontinuities=%s;attachment_count=%zu",
         params->track_count[VIDEO_ES], params->track_count[AUDIO_ES],
         params->track_count[SPU_ES], params->program_count,
@@ -815,7 +827,8 @@ create_mock_media(const char *name, const struct media_params *params)
         params->sub_packetized, params->length, params->audio_sample_length,
         params->video_frame_rate, params->video_frame_rate_base,
         params->title_count, params->chapter_count,
-        params->can_seek, params->can_pause, params->error, params->null_names,
+        params->can_seek, params->can_pause, params->can_control_pace,
+        params->error, params->null_names,
         params->pts_delay,
         params->config ? params->config : "",
         params->discontinuities ? params->discontinuities : "",
@@ -1930,6 +1943,48 @@ test_pause(struct ctx *ctx)
     test_end(ctx);
 }
 
+static void
+test_timeshift_large_block(struct ctx *ctx)
+{
+    test_log("timeshift_large_block\n");
+    vlc_player_t *player = ctx->player;
+    vlc_object_t *libvlc = VLC_OBJECT(ctx->vlc->p_libvlc_int);
+
+    /* I420 pictures of about 2 MiB, larger than the smallest segment */
+    int ret = var_Create(libvlc, "input-timeshift-granularity", VLC_VAR_INTEGER);
+    assert(ret == VLC_SUCCESS);
+    var_SetInteger(libvlc, "input-timeshift-granularity", 1024 * 1024);
+
+    struct media_params params = DEFAULT_MEDIA_PARAMS(VLC_TICK_FROM_SEC(10));
+    params.track_count[AUDIO_ES] = 0;
+    params.track_count[SPU_ES] = 0;
+    params.can_pause = false;
+    params.can_control_pace = false;
+    params.config = "video[0]{width=1280,height=1024}";
+    player_set_next_mock_media(ctx, "media1", &params);
+
+    player_start(ctx);
+    wait_state(ctx, VLC_PLAYER_STATE_PLAYING);
+
+    /* The live source can't pause, the data go through the timeshift */
+    vlc_player_Pause(player);
+    wait_state(ctx, VLC_PLAYER_STATE_PAUSED);
+
+    vec_on_statistics_changed *vec = &ctx->report.on_statistics_changed;
+    const uint64_t decoded = vec->size > 0 ? VEC_LAST(vec).i_decoded_video : 0;
+
+    vlc_player_Resume(player);
+
+    /* Dropped by the timeshift, no picture would be decoded anymore */
+    while (vec->size == 0 ||
+           VEC_LAST(vec).i_decoded_video < decoded + params.video_frame_rate)
+        vlc_player_CondWait(player, &ctx->wait);
+
+    test_end(ctx);
+
+    var_Destroy(libvlc, "input-timeshift-granularity");
+}
+
 static void
 test_seeks(struct ctx *ctx)
 {
@@ -2026,6 +2081,135 @@ test_next_media(struct ctx *ctx)
     test_end(ctx);
 }
 
+static void
+test_preload(struct ctx *ctx)
+{
+    test_log("preload\n");
+
+    vlc_player_t *player = ctx->player;
+
+    /* Shorter than the preload delay: the next media is opened in advance as
+     * soon as the first one plays */
+    struct media_params params = DEFAULT_MEDIA_PARAMS(VLC_TICK_FROM_MS(1000));
+
+    player_set_next_mock_media(ctx, "media1", &params);
+    player_set_next_mock_media(ctx, "media2", &params);
+    player_start(ctx);
+
+    wait_state(ctx, VLC_PLAYER_STATE_PLAYING);
+
+    /* Replace the preloading media, it is dropped without any event */
+    assert(ctx->added_medias.size == 2 && ctx->played_medias.size == 2);
+    input_item_t *media = create_mock_media("media3", &params);
+    assert(media);
+    vlc_player_SetNextMedia(player, media);
+    input_item_Release(ctx->added_medias.data[1]);
+    ctx->added_medias.data[1] = ctx->played_medias.data[1] = media;
+
+    wait_state(ctx, VLC_PLAYER_STATE_STOPPED);
+
+    {
+        vec_on_current_media_changed *vec = &ctx->report.on_current_media_changed;
+
+        assert(vec->size == 2);
+        assert_media_name(vec->data[0], "media1");
+        assert_media_name(vec->data[1], "media3");
+    }
+
+    test_end(ctx);
+}
+
+static void
+assert_display_reports(struct ctx *ctx, size_t count)
+{
+    /* One display, opened for the first media, closed only once */
+    vec_on_display_changed *vec = &ctx->report.on_display_changed;
+    assert(vec->size == count);
+    if (count > 0)
+        assert(vec->data[0] == REPORT_DISPLAY_OPENED);
+    if (count > 1)
+        assert(vec->data[1] == REPORT_DISPLAY_CLOSED);
+}
+
+static void
+test_preload_video_to_video(struct ctx *ctx)
+{
+    test_log("preload_video_to_video\n");
+
+    struct media_params params = DEFAULT_MEDIA_PARAMS(VLC_TICK_FROM_MS(1000));
+
+    player_set_next_mock_media(ctx, "media1", &params);
+    player_set_next_mock_media(ctx, "media2", &params);
+    player_start(ctx);
+
+    wait_state(ctx, VLC_PLAYER_STATE_STOPPED);
+
+    {
+        vec_on_current_media_changed *vec = &ctx->report.on_current_media_changed;
+        assert(vec->size == 2);
+        assert_media_name(vec->data[0], "media1");
+        assert_media_name(vec->data[1], "media2");
+    }
+
+    {
+        /* The vout is released then requested again by the next media */
+        vec_on_vout_changed *vec = &ctx->report.on_vout_changed;
+        size_t vout_started = 0;
+        assert(vec->size > 0);
+        for (size_t i = 0; i < vec->size; ++i)
+        {
+            assert(vec->data[i].vout == vec->data[0].vout);
+            if (vec->data[i].action == VLC_PLAYER_VOUT_STARTED)
+                vout_started++;
+        }
+        assert(vout_started == 2);
+    }
+
+    /* Its display was suspended then resumed, not re-opened */
+    assert_display_reports(ctx, 2);
+
+    test_end(ctx);
+}
+
+static void
+test_preload_video_to_audio(struct ctx *ctx)
+{
+    test_log("preload_video_to_audio\n");
+
+    vlc_player_t *player = ctx->player;
+
+    struct media_params params = DEFAULT_MEDIA_PARAMS(VLC_TICK_FROM_MS(1000));
+    player_set_next_mock_media(ctx, "media1", &params);
+    params.track_count[VIDEO_ES] = 0;
+    params.track_count[SPU_ES] = 0;
+    player_set_next_mock_media(ctx, "media2", &params);
+    player_start(ctx);
+
+    /* Wait for the audio of the second media */
+    vec_on_aout_first_pts *vec = &ctx->report.on_aout_first_pts;
+    while (vec->size < 2)
+        vlc_player_CondWait(player, &ctx->wait);
+
+    /* The suspended display kept the last picture of the first media until
+     * the second one was buffered, then was stopped as it has no video */
+    assert_display_reports(ctx, 2);
+
+    wait_state(ctx, VLC_PLAYER_STATE_STOPPED);
+
+    {
+        /* Only started for the first media */
+        vec_on_vout_changed *vec = &ctx->report.on_vout_changed;
+        size_t vout_started = 0;
+        for (size_t i = 0; i < vec->size; ++i)
+            if (vec->data[i].action == VLC_PLAYER_VOUT_STARTED)
+                vout_started++;
+        assert(vout_started == 1);
+    }
+    assert_display_reports(ctx, 2);
+
+    test_end(ctx);
+}
+
 static void
 test_same_media(struct ctx *ctx)
 {
@@ -2280,11 +2464,14 @@ ctx_init(struct ctx *ctx, int flags)
         /* Avoid leaks from various dlopen... */
         "--codec=araw,rawvideo,subsdec,"TELETEXT_DECODER"none",
         "--dec-dev=none",
-        (flags & DISABLE_VIDEO_OUTPUT) ? "--vout=none" : "--vout=dummy,none",
+        (flags & DISABLE_VIDEO_OUTPUT) ? "--vout=none" :
+        (flags & ENABLE_PRELOAD) ? "--vout=test_src_player_display,none" :
+                                   "--vout=dummy,none",
         (flags & DISABLE_AUDIO_OUTPUT) ? "--aout=none" : "--aout=test_src_player,none",
         (flags & DISABLE_VIDEO) ? "--no-video" : "--video",
         (flags & DISABLE_AUDIO) ? "--no-audio" : "--audio",
         "--text-renderer=tdummy,none",
+        (flags & ENABLE_PRELOAD) ? "--input-preload=2000" : "--input-preload=0",
 #ifdef TEST_CLOCK_MONOTONIC
         "--clock-master=monotonic",
 #endif
@@ -3153,6 +3340,7 @@ main(void)
     test_next_media(&ctx);
     test_seeks(&ctx);
     test_pause(&ctx);
+    test_timeshift_large_block(&ctx);
     test_capabilities_pause(&ctx);
     test_capabilities_seek(&ctx);
     test_error(&ctx);
@@ -3172,6 +3360,13 @@ main(void)
 
     ctx_destroy(&ctx);
 
+    /* Test with the next media preloaded */
+    ctx_init(&ctx, ENABLE_PRELOAD);
+    test_preload(&ctx);
+    test_preload_video_to_video(&ctx);
+    test_preload_video_to_audio(&ctx);
+    ctx_destroy(&ctx);
+
     /* Test with instantaneous audio drain */
     ctx_init(&ctx, AUDIO_INSTANT_DRAIN);
     test_clock_discontinuities(&ctx);
@@ -3294,6 +3489,53 @@ static int resampler_Open(vlc_object_t *obj)
     return VLC_SUCCESS;
 }
 
+struct display_sys
+{
+    struct ctx *ctx;
+};
+
+static void display_Display(vout_display_t *vd, picture_t *picture)
+{
+    (void) vd; (void) picture;
+}
+
+static int display_Control(vout_display_t *vd, int query)
+{
+    (void) vd; (void) query;
+    return VLC_SUCCESS;
+}
+
+static void display_Close(vout_display_t *vd)
+{
+    struct display_sys *sys = vd->sys;
+    struct ctx *ctx = sys->ctx;
+    VEC_PUSH(on_display_changed, REPORT_DISPLAY_CLOSED);
+    free(sys);
+}
+
+static int display_Open(vout_display_t *vd, video_format_t *fmtp,
+                        vlc_video_context *context)
+{
+    (void) fmtp; (void) context;
+    static const struct vlc_display_operations ops = {
+        .close = display_Close,
+        .display = display_Display,
+        .control = display_Control,
+    };
+
+    struct display_sys *sys = vd->sys = malloc(sizeof(*sys));
+    assert(sys != NULL);
+
+    sys->ctx = var_InheritAddress(vd, "test-ctx");
+    assert(sys->ctx != NULL);
+
+    struct ctx *ctx = sys->ctx;
+    VEC_PUSH(on_display_changed, REPORT_DISPLAY_OPENED);
+
+    vd->ops = &ops;
+    return VLC_SUCCESS;
+}
+
 vlc_module_begin()
     /* This aout module will report audio timings perfectly, but without any
      * delay, in order to be usable for player tests. Indeed, this aout will
@@ -3306,6 +3548,11 @@ vlc_module_begin()
      * Insert our own resampler that keeps blocks and pts untouched. */
         set_capability ("audio resampler", 9999)
         set_callback (resampler_Open)
+    add_submodule ()
+    /* Display reporting when it is opened and closed, to check that it is
+     * kept across preloaded medias. */
+        add_shortcut ("test_src_player_display")
+        set_callback_display (display_Open, 0)
 vlc_module_end()
 
 VLC_EXPORT const vlc_plugin_cb vlc_static_modules[] = {